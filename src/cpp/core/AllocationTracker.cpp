@@ -0,0 +1,405 @@
+/*
+ * AllocationTracker.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/AllocationTracker.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sstream>
+
+#include <core/Thread.hpp>
+
+namespace rstudio {
+namespace core {
+namespace allocation {
+
+namespace {
+
+// the tracker keeps all of its state in fixed-size statically allocated
+// storage: the record paths run inside operator new/delete, so they can
+// never allocate themselves. module slot 0 is the implicit "untagged"
+// module; the sampled-pointer table lets deletes of sampled allocations
+// decrement the live counters (unsampled pointers miss the table and
+// fall straight through)
+const int kMaxModules = 32;
+const int kTableSize = 65536;      // must be a power of two
+const int kMaxProbes = 16;
+
+#ifdef _WIN32
+#define TRACKER_THREAD_LOCAL __declspec(thread)
+#else
+#define TRACKER_THREAD_LOCAL __thread
+#endif
+
+// read unlocked on every allocation; writes occur under s_trackerMutex
+volatile int s_enabled = 0;
+int s_sampleRate = 1;
+
+// current module tag and per-thread allocation counter (used for
+// sampling without shared state on the fast path)
+TRACKER_THREAD_LOCAL int t_moduleIndex = 0;
+TRACKER_THREAD_LOCAL unsigned t_allocationCount = 0;
+
+// plain aggregates so the arrays land zero-initialized in bss rather
+// than requiring constructors to run before the first allocation
+struct ModuleCounters
+{
+   const char* name;
+   boost::uint64_t liveAllocations;
+   boost::uint64_t liveBytes;
+   boost::uint64_t totalAllocations;
+   boost::uint64_t totalBytes;
+};
+
+struct TableEntry
+{
+   void* ptr;
+   std::size_t size;
+   int moduleIndex;
+};
+
+ModuleCounters s_modules[kMaxModules];
+int s_moduleCount = 0;
+TableEntry s_table[kTableSize];
+
+boost::mutex s_trackerMutex;
+
+inline std::size_t tableSlot(void* ptr)
+{
+   // allocations are at least 16-byte aligned so the low bits carry no
+   // information; knuth multiplicative hash on what remains
+   return (reinterpret_cast<std::size_t>(ptr) >> 4) * 2654435761u;
+}
+
+// resolve (registering on first use) the slot for a module name.
+// callers hold s_trackerMutex
+int moduleIndexForName(const char* name)
+{
+   if (s_moduleCount == 0)
+   {
+      s_modules[0].name = "untagged";
+      s_moduleCount = 1;
+   }
+
+   for (int i = 1; i < s_moduleCount; i++)
+   {
+      if (s_modules[i].name == name ||
+          ::strcmp(s_modules[i].name, name) == 0)
+      {
+         return i;
+      }
+   }
+
+   if (s_moduleCount >= kMaxModules)
+      return 0;
+
+   int index = s_moduleCount++;
+   s_modules[index].name = name;
+   return index;
+}
+
+#ifndef _WIN32
+
+void recordAllocation(void* ptr, std::size_t size)
+{
+   // sample one in s_sampleRate allocations (the counter is per-thread
+   // so the fast path touches no shared state)
+   if (++t_allocationCount % static_cast<unsigned>(s_sampleRate) != 0)
+      return;
+
+   int moduleIndex = t_moduleIndex;
+
+   LOCK_MUTEX(s_trackerMutex)
+   {
+      // re-check now that we hold the lock (disable may have raced us)
+      if (!s_enabled)
+         return;
+
+      ModuleCounters& module = s_modules[moduleIndex];
+      module.totalAllocations++;
+      module.totalBytes += size;
+
+      // remember the sampled pointer so the matching delete can
+      // decrement the live counters. if the probe window is full the
+      // sample still counts towards totals but not towards live
+      std::size_t slot = tableSlot(ptr);
+      for (int probe = 0; probe < kMaxProbes; probe++)
+      {
+         TableEntry& entry = s_table[(slot + probe) & (kTableSize - 1)];
+         if (entry.ptr == NULL)
+         {
+            entry.ptr = ptr;
+            entry.size = size;
+            entry.moduleIndex = moduleIndex;
+            module.liveAllocations++;
+            module.liveBytes += size;
+            break;
+         }
+      }
+   }
+   END_LOCK_MUTEX
+}
+
+void recordFree(void* ptr)
+{
+   // unlocked pre-scan: the entry for a pointer can only be created by
+   // the allocation that produced it and cleared by its free, both of
+   // which happened-before this call, so a miss here is authoritative
+   // and the overwhelmingly common unsampled case skips the lock
+   std::size_t slot = tableSlot(ptr);
+   bool candidate = false;
+   for (int probe = 0; probe < kMaxProbes; probe++)
+   {
+      if (s_table[(slot + probe) & (kTableSize - 1)].ptr == ptr)
+      {
+         candidate = true;
+         break;
+      }
+   }
+   if (!candidate)
+      return;
+
+   LOCK_MUTEX(s_trackerMutex)
+   {
+      for (int probe = 0; probe < kMaxProbes; probe++)
+      {
+         TableEntry& entry = s_table[(slot + probe) & (kTableSize - 1)];
+         if (entry.ptr == ptr)
+         {
+            ModuleCounters& module = s_modules[entry.moduleIndex];
+            if (module.liveAllocations > 0)
+               module.liveAllocations--;
+            if (module.liveBytes >= entry.size)
+               module.liveBytes -= entry.size;
+            entry.ptr = NULL;
+            entry.size = 0;
+            entry.moduleIndex = 0;
+            break;
+         }
+      }
+   }
+   END_LOCK_MUTEX
+}
+
+#endif // !_WIN32
+
+} // anonymous namespace
+
+bool enable(int sampleRate)
+{
+#ifdef _WIN32
+   return false;
+#else
+   if (sampleRate < 1)
+      sampleRate = 1;
+
+   LOCK_MUTEX(s_trackerMutex)
+   {
+      if (s_enabled)
+         return true;
+
+      // start the run with a clean slate (module registrations survive)
+      if (s_moduleCount == 0)
+      {
+         s_modules[0].name = "untagged";
+         s_moduleCount = 1;
+      }
+      for (int i = 0; i < s_moduleCount; i++)
+      {
+         s_modules[i].liveAllocations = 0;
+         s_modules[i].liveBytes = 0;
+         s_modules[i].totalAllocations = 0;
+         s_modules[i].totalBytes = 0;
+      }
+      ::memset(s_table, 0, sizeof(s_table));
+
+      s_sampleRate = sampleRate;
+      s_enabled = 1;
+   }
+   END_LOCK_MUTEX
+
+   return true;
+#endif
+}
+
+void disable()
+{
+   LOCK_MUTEX(s_trackerMutex)
+   {
+      s_enabled = 0;
+
+      // clear the pointer table so a recycled address can't be matched
+      // against a stale sample if tracking is re-enabled later
+      ::memset(s_table, 0, sizeof(s_table));
+   }
+   END_LOCK_MUTEX
+}
+
+bool isEnabled()
+{
+   return s_enabled != 0;
+}
+
+Scope::Scope(const char* moduleName)
+{
+   previousIndex_ = t_moduleIndex;
+
+   int index = 0;
+   LOCK_MUTEX(s_trackerMutex)
+   {
+      index = moduleIndexForName(moduleName);
+   }
+   END_LOCK_MUTEX
+
+   t_moduleIndex = index;
+}
+
+Scope::~Scope()
+{
+   t_moduleIndex = previousIndex_;
+}
+
+std::vector<ModuleStats> stats()
+{
+   std::vector<ModuleStats> results;
+
+   LOCK_MUTEX(s_trackerMutex)
+   {
+      boost::uint64_t rate = static_cast<boost::uint64_t>(s_sampleRate);
+      for (int i = 0; i < s_moduleCount; i++)
+      {
+         const ModuleCounters& module = s_modules[i];
+
+         ModuleStats moduleStats;
+         moduleStats.module = module.name;
+         moduleStats.liveAllocations = module.liveAllocations * rate;
+         moduleStats.liveBytes = module.liveBytes * rate;
+         moduleStats.totalAllocations = module.totalAllocations * rate;
+         moduleStats.totalBytes = module.totalBytes * rate;
+         results.push_back(moduleStats);
+      }
+   }
+   END_LOCK_MUTEX
+
+   return results;
+}
+
+std::string statsAsText()
+{
+   std::vector<ModuleStats> moduleStats = stats();
+   if (moduleStats.empty())
+      return std::string();
+
+   std::ostringstream ostr;
+
+   ostr << "# TYPE rstudio_allocation_live_bytes gauge\n";
+   for (std::size_t i = 0; i < moduleStats.size(); i++)
+   {
+      ostr << "rstudio_allocation_live_bytes{module=\""
+           << moduleStats[i].module << "\"} "
+           << moduleStats[i].liveBytes << "\n";
+   }
+
+   ostr << "# TYPE rstudio_allocation_live_count gauge\n";
+   for (std::size_t i = 0; i < moduleStats.size(); i++)
+   {
+      ostr << "rstudio_allocation_live_count{module=\""
+           << moduleStats[i].module << "\"} "
+           << moduleStats[i].liveAllocations << "\n";
+   }
+
+   ostr << "# TYPE rstudio_allocation_total_bytes counter\n";
+   for (std::size_t i = 0; i < moduleStats.size(); i++)
+   {
+      ostr << "rstudio_allocation_total_bytes{module=\""
+           << moduleStats[i].module << "\"} "
+           << moduleStats[i].totalBytes << "\n";
+   }
+
+   ostr << "# TYPE rstudio_allocation_total_count counter\n";
+   for (std::size_t i = 0; i < moduleStats.size(); i++)
+   {
+      ostr << "rstudio_allocation_total_count{module=\""
+           << moduleStats[i].module << "\"} "
+           << moduleStats[i].totalAllocations << "\n";
+   }
+
+   return ostr.str();
+}
+
+} // namespace allocation
+} // namespace core
+} // namespace rstudio
+
+#ifndef _WIN32
+
+// global operator new/delete replacements. these apply to every binary
+// that links core; when tracking is disabled the added cost is the
+// single branch on s_enabled
+
+void* operator new(std::size_t size)
+{
+   void* ptr = ::malloc(size != 0 ? size : 1);
+   if (ptr == NULL)
+      throw std::bad_alloc();
+   if (rstudio::core::allocation::s_enabled)
+      rstudio::core::allocation::recordAllocation(ptr, size);
+   return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+   return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+   void* ptr = ::malloc(size != 0 ? size : 1);
+   if (ptr != NULL && rstudio::core::allocation::s_enabled)
+      rstudio::core::allocation::recordAllocation(ptr, size);
+   return ptr;
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+   return ::operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept
+{
+   if (ptr == NULL)
+      return;
+   if (rstudio::core::allocation::s_enabled)
+      rstudio::core::allocation::recordFree(ptr);
+   ::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+   ::operator delete(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+   ::operator delete(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+   ::operator delete(ptr);
+}
+
+#endif // !_WIN32
@@ -0,0 +1,150 @@
+/*
+ * AsyncLogWriter.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/AsyncLogWriter.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <core/Thread.hpp>
+
+namespace rstudio {
+namespace core {
+
+AsyncLogWriter::AsyncLogWriter(boost::shared_ptr<LogWriter> pSink,
+                               std::size_t maxQueueSize)
+   : pSink_(pSink),
+     maxQueueSize_(maxQueueSize),
+     droppedEntries_(0),
+     stopRequested_(false)
+{
+   thread_ = boost::thread(boost::bind(&AsyncLogWriter::writerThread, this));
+}
+
+AsyncLogWriter::~AsyncLogWriter()
+{
+   try
+   {
+      // signal the writer thread to flush remaining entries and exit
+      {
+         boost::unique_lock<boost::mutex> lock(mutex_);
+         stopRequested_ = true;
+      }
+      condition_.notify_all();
+      thread_.join();
+   }
+   catch(...)
+   {
+   }
+}
+
+void AsyncLogWriter::log(core::system::LogLevel level,
+                         const std::string& message)
+{
+   log(std::string(), level, message);
+}
+
+void AsyncLogWriter::log(const std::string& programIdentity,
+                         core::system::LogLevel level,
+                         const std::string& message)
+{
+   LogEntry entry;
+   entry.programIdentity = programIdentity;
+   entry.level = level;
+   entry.message = message;
+   enqueue(entry);
+}
+
+void AsyncLogWriter::setLogToStderr(bool logToStderr)
+{
+   pSink_->setLogToStderr(logToStderr);
+}
+
+void AsyncLogWriter::enqueue(const LogEntry& entry)
+{
+   {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+
+      // bounded-loss overflow policy: drop (and count) rather than
+      // blocking the logging thread or growing without bound
+      if (queue_.size() >= maxQueueSize_)
+      {
+         droppedEntries_++;
+         return;
+      }
+
+      queue_.push_back(entry);
+   }
+   condition_.notify_all();
+}
+
+void AsyncLogWriter::writerThread()
+{
+   try
+   {
+      while (true)
+      {
+         // wait for entries (or a stop request) then claim the entire
+         // queue so the batch is written without holding the lock
+         std::deque<LogEntry> entries;
+         std::size_t droppedEntries = 0;
+         bool stopRequested = false;
+         {
+            boost::unique_lock<boost::mutex> lock(mutex_);
+            while (queue_.empty() && !stopRequested_)
+               condition_.wait(lock);
+
+            entries.swap(queue_);
+            droppedEntries = droppedEntries_;
+            droppedEntries_ = 0;
+            stopRequested = stopRequested_;
+         }
+
+         writeBatch(entries, droppedEntries);
+
+         if (stopRequested)
+            break;
+      }
+   }
+   catch(...)
+   {
+      // swallow errors -- we can't log so it doesn't matter
+   }
+}
+
+void AsyncLogWriter::writeBatch(const std::deque<LogEntry>& entries,
+                                std::size_t droppedEntries)
+{
+   BOOST_FOREACH(const LogEntry& entry, entries)
+   {
+      if (entry.programIdentity.empty())
+         pSink_->log(entry.level, entry.message);
+      else
+         pSink_->log(entry.programIdentity, entry.level, entry.message);
+   }
+
+   // note any entries lost to the overflow policy
+   if (droppedEntries > 0)
+   {
+      pSink_->log(core::system::kLogLevelWarning,
+                  "dropped " +
+                  boost::lexical_cast<std::string>(droppedEntries) +
+                  " log entries (logging queue overflow)");
+   }
+}
+
+} // namespace core
+} // namespace rstudio
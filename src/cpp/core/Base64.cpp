@@ -13,12 +13,17 @@
  *
  */
 
+#include <istream>
+#include <ostream>
+
 #include <core/Macros.hpp>
 #include <core/Error.hpp>
 #include <core/Log.hpp>
 #include <core/FileSerializer.hpp>
 
-#include <boost/scoped_array.hpp>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+# include <immintrin.h>
+#endif
 
 namespace rstudio {
 namespace core {
@@ -38,24 +43,136 @@ std::size_t encoded_size(std::size_t n)
    return (n + 2) / 3 * 4;
 }
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+
+// hardware implementation: encodes 12 input bytes into a 16-byte output
+// lane per iteration using SSSE3 byte shuffles (Mula's vectorized
+// lookup). compiled with the ssse3 target attribute and only invoked
+// after a runtime cpu check. each iteration loads 16 bytes while
+// consuming 12, so the loop stops while a 4-byte scalar tail remains
+__attribute__((target("ssse3")))
+void encodeChunksSimd(const Byte** ppData, std::size_t* pN, Byte** ppOut)
+{
+   const Byte* pData = *ppData;
+   std::size_t n = *pN;
+   Byte* pOut = *ppOut;
+
+   // spreads each 3-byte group across 4 output slots
+   const __m128i shuffle = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4,
+                                         7, 6, 8, 7, 10, 9, 11, 10);
+
+   // per-range ascii offsets: 'a'-26 for 26..51, '0'-52 for 52..61,
+   // '+'-62, '/'-63, and 'A' for 0..25
+   const __m128i shiftLUT = _mm_setr_epi8(71, -4, -4, -4, -4, -4,
+                                          -4, -4, -4, -4, -4, -19,
+                                          -16, 65, 0, 0);
+
+   while (n >= 16)
+   {
+      __m128i in = _mm_loadu_si128(
+               reinterpret_cast<const __m128i*>(pData));
+      in = _mm_shuffle_epi8(in, shuffle);
+
+      // extract the four 6-bit indices of each group
+      const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00));
+      const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+      const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003F03F0));
+      const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+      const __m128i indices = _mm_or_si128(t1, t3);
+
+      // translate to ascii: collapse the indices into 14 ranges, look
+      // up each range's offset, and add it back to the index
+      __m128i ranges = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+      const __m128i lower = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+      ranges = _mm_or_si128(ranges,
+                            _mm_and_si128(lower, _mm_set1_epi8(13)));
+      const __m128i ascii = _mm_add_epi8(
+               indices, _mm_shuffle_epi8(shiftLUT, ranges));
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(pOut), ascii);
+
+      pData += 12;
+      n -= 12;
+      pOut += 16;
+   }
+
+   *ppData = pData;
+   *pN = n;
+   *ppOut = pOut;
+}
+
+bool simdEncodeAvailable()
+{
+   static const bool available = __builtin_cpu_supports("ssse3");
+   return available;
+}
+
+#endif
+
+// encode [pData, pData + n) into pOut, which must provide room for
+// encoded_size(n) bytes; returns one past the last byte written. when
+// useSimd is set (standard alphabet only) the bulk of the input is
+// encoded in 16-byte lanes
+Byte* encodeBuffer(const Byte* pData,
+                   std::size_t n,
+                   const Byte* pTable,
+                   bool useSimd,
+                   Byte* pOut)
+{
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+   if (useSimd && simdEncodeAvailable())
+      encodeChunksSimd(&pData, &n, &pOut);
+#endif
+
+   while (n >= 3)
+   {
+      *pOut++ = pTable[pData[0] >> 2];
+      *pOut++ = pTable[((pData[0] & 0x03) << 4) | ((pData[1] & 0xF0) >> 4)];
+      *pOut++ = pTable[((pData[1] & 0x0F) << 2) | ((pData[2] & 0xC0) >> 6)];
+      *pOut++ = pTable[pData[2] & 0x3F];
+
+      n -= 3;
+      pData += 3;
+   }
+
+   if (n == 1)
+   {
+      *pOut++ = pTable[pData[0] >> 2];
+      *pOut++ = pTable[(pData[0] & 0x03) << 4];
+      *pOut++ = '=';
+      *pOut++ = '=';
+   }
+   else if (n == 2)
+   {
+      *pOut++ = pTable[pData[0] >> 2];
+      *pOut++ = pTable[((pData[0] & 0x03) << 4) | ((pData[1] & 0xF0) >> 4)];
+      *pOut++ = pTable[(pData[1] & 0x0F) << 2];
+      *pOut++ = '=';
+   }
+
+   return pOut;
+}
+
 class Encoder
 {
 public:
 
    Encoder()
+      : isDefaultTable_(true)
    {
       init(table());
    }
 
-   explicit Encoder(const std::string& table)
+   explicit Encoder(const std::string& encodeTable)
+      : isDefaultTable_(encodeTable == table())
    {
-      init(table);
+      init(encodeTable);
    }
-   
+
    // COPYING: copyable members
-   
+
 private:
-   
+
    void init(const std::string& table)
    {
       const Byte* pData = (const Byte*) table.c_str();
@@ -63,7 +180,7 @@ private:
    }
 
 public:
-   
+
    Error operator()(const std::string& string, std::string* pOutput)
    {
       return (*this)(string.c_str(), string.size(), pOutput);
@@ -73,51 +190,32 @@ public:
    {
       return (*this)((const Byte*) pData, n, pOutput);
    }
-   
+
    Error operator()(const Byte* pData, std::size_t n, std::string* pOutput)
    {
-      std::size_t size = encoded_size(n);
-      boost::scoped_array<Byte> pBuffer(new Byte[size + 1]);
-      pBuffer[size] = '\0';
-      
-      Byte* pTable = &table_[0];
-      Byte* it = pBuffer.get();
-      while (n >= 3)
-      {
-         *it++ = pTable[pData[0] >> 2];
-         *it++ = pTable[((pData[0] & 0x03) << 4) | ((pData[1] & 0xF0) >> 4)];
-         *it++ = pTable[((pData[1] & 0x0F) << 2) | ((pData[2] & 0xC0) >> 6)];
-         *it++ = pTable[pData[2] & 0x3F];
-
-         n -= 3;
-         pData += 3;
-      }
-
+      // encode directly into the output buffer -- no scratch allocation,
+      // so peak memory is input + output rather than input + 2x output
+      pOutput->resize(encoded_size(n));
       if (n == 0)
-         goto FINISH;
-
-      *it++ = pTable[pData[0] >> 2];
-      if (n == 1)
-      {
-         *it++ = pTable[(pData[0] & 0x03) << 4];
-         *it++ = '=';
-         *it++ = '=';
-         goto FINISH;
-      }
-
-      *it++ = pTable[((pData[0] & 0x03) << 4) | ((pData[1] & 0xF0) >> 4)];
-      *it++ = pTable[(pData[1] & 0x0F) << 2];
-      *it++ = '=';
+         return Success();
 
-FINISH:
-      pOutput->assign((const char*) pBuffer.get(), size);
+      encodeBuffer(pData,
+                   n,
+                   &table_[0],
+                   isDefaultTable_,
+                   reinterpret_cast<Byte*>(&(*pOutput)[0]));
       return Success();
    }
 
 private:
    std::vector<Byte> table_;
+   bool isDefaultTable_;
 };
 
+// fixed chunk size for the streaming paths -- a multiple of 3, so that
+// padding can only be emitted on the final chunk
+const std::size_t kStreamChunkBytes = 3 * 16384;
+
 } // end anonymous namespace
 
 Error encode(const char* pData, std::size_t n, std::string* pOutput)
@@ -134,12 +232,59 @@ Error encode(const std::string& input, std::string* pOutput)
 
 Error encode(const FilePath& inputFile, std::string* pOutput)
 {
-   std::string contents;
-   Error error = core::readStringFromFile(inputFile, &contents);
+   // stream the file through a fixed-size chunk buffer rather than
+   // reading it into memory first -- only one chunk of the input is
+   // ever resident alongside the (pre-reserved) output
+   boost::shared_ptr<std::istream> pStream;
+   Error error = inputFile.open_r(&pStream);
    if (error)
       return error;
 
-   return encode(contents, pOutput);
+   pOutput->clear();
+   pOutput->reserve(encoded_size(inputFile.size()));
+
+   Encoder encode;
+   std::vector<char> inBuffer(kStreamChunkBytes);
+   std::string chunk;
+   while (pStream->read(&inBuffer[0], inBuffer.size()) || pStream->gcount() > 0)
+   {
+      error = encode(&inBuffer[0],
+                     static_cast<std::size_t>(pStream->gcount()),
+                     &chunk);
+      if (error)
+         return error;
+
+      pOutput->append(chunk);
+   }
+
+   if (pStream->bad())
+      return systemError(boost::system::errc::io_error, ERROR_LOCATION);
+
+   return Success();
+}
+
+Error encode(std::istream& input, std::ostream& output)
+{
+   Encoder encode;
+   std::vector<char> inBuffer(kStreamChunkBytes);
+   std::string chunk;
+   while (input.read(&inBuffer[0], inBuffer.size()) || input.gcount() > 0)
+   {
+      Error error = encode(&inBuffer[0],
+                           static_cast<std::size_t>(input.gcount()),
+                           &chunk);
+      if (error)
+         return error;
+
+      output.write(chunk.data(), chunk.size());
+      if (output.fail())
+         return systemError(boost::system::errc::io_error, ERROR_LOCATION);
+   }
+
+   if (input.bad())
+      return systemError(boost::system::errc::io_error, ERROR_LOCATION);
+
+   return Success();
 }
 
 namespace {
@@ -230,10 +375,14 @@ public:
       if (n % 4 != 0)
          return decodeLengthError(n, ERROR_LOCATION);
 
+      // decode directly into the output buffer (on error its contents
+      // are unspecified); trailing padding is trimmed at the end
       std::size_t size = decoded_size(n);
-      boost::scoped_array<Byte> pBuffer(new Byte[size + 1]);
-      pBuffer.get()[size] = '\0';
-      Byte* it = pBuffer.get();
+      pOutput->resize(size);
+      if (n == 0)
+         return Success();
+
+      Byte* it = reinterpret_cast<Byte*>(&(*pOutput)[0]);
 
       Byte* pTable = &table_[0];
       
@@ -301,9 +450,7 @@ public:
       *it++ = (lhsByte << 6) | rhsByte;
 
 FINISH:
-      pOutput->assign(
-               reinterpret_cast<const char*>(pBuffer.get()),
-               size);
+      pOutput->resize(size);
       return Success();
    }
 
@@ -0,0 +1,84 @@
+/*
+ * Base64Benchmarks.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <benchmark/Benchmark.hpp>
+
+#include <string>
+
+#include <core/Base64.hpp>
+#include <core/Error.hpp>
+
+namespace rstudio {
+namespace core {
+namespace benchmarks {
+namespace {
+
+// binary-ish payload about the size of an embedded plot image
+const std::size_t kPayloadBytes = 1024 * 1024;
+
+const std::string& payloadFixture()
+{
+   static std::string s_payload;
+   if (s_payload.empty())
+   {
+      s_payload.reserve(kPayloadBytes);
+      unsigned seed = 2654435761u;
+      for (std::size_t i = 0; i < kPayloadBytes; i++)
+      {
+         seed = seed * 1103515245 + 12345;
+         s_payload.push_back(static_cast<char>(seed >> 16));
+      }
+   }
+   return s_payload;
+}
+
+} // anonymous namespace
+
+BENCHMARK(benchmarkBase64Encode)
+{
+   const std::string& payload = payloadFixture();
+   state.setBytesPerIteration(payload.size());
+
+   while (state.keepRunning())
+   {
+      std::string encoded;
+      Error error = base64::encode(payload, &encoded);
+      benchmark::doNotOptimize(encoded);
+      if (error)
+         return;
+   }
+}
+
+BENCHMARK(benchmarkBase64Decode)
+{
+   std::string encoded;
+   Error error = base64::encode(payloadFixture(), &encoded);
+   if (error)
+      return;
+   state.setBytesPerIteration(encoded.size());
+
+   while (state.keepRunning())
+   {
+      std::string decoded;
+      error = base64::decode(encoded, &decoded);
+      benchmark::doNotOptimize(decoded);
+      if (error)
+         return;
+   }
+}
+
+} // namespace benchmarks
+} // namespace core
+} // namespace rstudio
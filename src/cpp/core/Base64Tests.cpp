@@ -13,6 +13,8 @@
  *
  */
 
+#include <sstream>
+
 #include <tests/TestThat.hpp>
 
 #include <core/Error.hpp>
@@ -89,6 +91,48 @@ context("Base64 Encoding")
          expect_true(random == decoded);
       }
    }
+
+   test_that("Contents are preserved around vectorized lane boundaries")
+   {
+      // sizes chosen to exercise the 12-byte-per-lane hardware encoder's
+      // main loop, its scalar tail, and each padding case
+      std::size_t sizes[] = { 11, 12, 13, 15, 16, 17, 23, 24, 25,
+                              47, 48, 49, 1023, 1024, 1025 };
+
+      Error error;
+      ::srand(2);
+      for (std::size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+      {
+         std::string random = string_utils::makeRandomByteString(sizes[i]);
+
+         std::string encoded;
+         error = encode(random, &encoded);
+         expect_true(error == Success());
+
+         std::string decoded;
+         error = decode(encoded, &decoded);
+         expect_true(error == Success());
+
+         expect_true(random == decoded);
+      }
+   }
+
+   test_that("Stream encoding matches buffer encoding")
+   {
+      ::srand(3);
+      std::string random = string_utils::makeRandomByteString(256 * 1024 + 1);
+
+      std::string encoded;
+      Error error = encode(random, &encoded);
+      expect_true(error == Success());
+
+      std::istringstream input(random);
+      std::ostringstream output;
+      error = encode(input, output);
+      expect_true(error == Success());
+
+      expect_true(output.str() == encoded);
+   }
 }
 
 } // end namespace base64
@@ -0,0 +1,393 @@
+/*
+ * Diff.cpp
+ *
+ * Copyright (C) 2009-16 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/Diff.hpp>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include <boost/foreach.hpp>
+
+namespace rstudio {
+namespace core {
+namespace diff {
+namespace {
+
+// cap on the recursion depth of the matcher, and on the number of
+// occurrences a line may have before the histogram fallback refuses to
+// split on it; both bound the cost of pathological inputs (many repeats
+// of the same few lines) at the expense of a coarser -- but still
+// correct -- diff
+const std::size_t kMaxMatchDepth = 64;
+const std::size_t kMaxOccurrences = 64;
+
+// a text split into lines, with comparison keys precomputed so that
+// whitespace normalization and end-of-file newline state are folded in
+// up front (lines are always compared by key)
+struct LineSet
+{
+   LineSet() : noNewlineAtEof(false) {}
+
+   // COPYING: via compiler (copyable members)
+
+   std::vector<std::string> lines;  // line contents, without newlines
+   std::vector<std::string> keys;
+   bool noNewlineAtEof;
+};
+
+void splitLines(const std::string& text, bool ignoreWhitespace,
+                LineSet* pSet)
+{
+   pSet->noNewlineAtEof = !text.empty() && text[text.size() - 1] != '\n';
+
+   std::string::size_type pos = 0;
+   while (pos < text.size())
+   {
+      std::string::size_type eol = text.find('\n', pos);
+      if (eol == std::string::npos)
+      {
+         pSet->lines.push_back(text.substr(pos));
+         break;
+      }
+      pSet->lines.push_back(text.substr(pos, eol - pos));
+      pos = eol + 1;
+   }
+
+   pSet->keys.reserve(pSet->lines.size());
+   for (std::size_t i = 0; i < pSet->lines.size(); i++)
+   {
+      std::string key;
+      if (ignoreWhitespace)
+      {
+         BOOST_FOREACH(char ch, pSet->lines[i])
+         {
+            if (ch != ' ' && ch != '\t' && ch != '\r')
+               key.push_back(ch);
+         }
+      }
+      else
+      {
+         key = pSet->lines[i];
+      }
+
+      // a line at the end of a file with no trailing newline never
+      // matches a newline-terminated copy of itself (lines never contain
+      // '\n' so this marker can't collide with real content)
+      if (i == pSet->lines.size() - 1 && pSet->noNewlineAtEof)
+         key.push_back('\n');
+
+      pSet->keys.push_back(key);
+   }
+}
+
+typedef std::pair<std::size_t, std::size_t> LinePair;
+
+// tallies of a line's occurrences within the ranges under consideration,
+// along with the first position seen on each side
+struct LineUsage
+{
+   LineUsage() : countA(0), countB(0), firstA(0), firstB(0) {}
+
+   // COPYING: via compiler (copyable members)
+
+   std::size_t countA;
+   std::size_t countB;
+   std::size_t firstA;
+   std::size_t firstB;
+};
+
+// computes the longest increasing subsequence (by second element) of the
+// candidate anchors, which are already ordered by first element; this is
+// the classic patience sorting step
+void longestIncreasingSubsequence(const std::vector<LinePair>& candidates,
+                                  std::vector<LinePair>* pAnchors)
+{
+   std::vector<std::size_t> piles;        // index of top card of each pile
+   std::vector<std::size_t> previous(candidates.size(), 0);
+   std::vector<bool> hasPrevious(candidates.size(), false);
+
+   for (std::size_t i = 0; i < candidates.size(); i++)
+   {
+      // binary search for the leftmost pile whose top is >= this value
+      std::size_t lo = 0, hi = piles.size();
+      while (lo < hi)
+      {
+         std::size_t mid = (lo + hi) / 2;
+         if (candidates[piles[mid]].second < candidates[i].second)
+            lo = mid + 1;
+         else
+            hi = mid;
+      }
+
+      if (lo > 0)
+      {
+         previous[i] = piles[lo - 1];
+         hasPrevious[i] = true;
+      }
+
+      if (lo == piles.size())
+         piles.push_back(i);
+      else
+         piles[lo] = i;
+   }
+
+   if (piles.empty())
+      return;
+
+   // walk the back-pointers to recover the subsequence
+   std::vector<LinePair> reversed;
+   std::size_t at = piles[piles.size() - 1];
+   for (;;)
+   {
+      reversed.push_back(candidates[at]);
+      if (!hasPrevious[at])
+         break;
+      at = previous[at];
+   }
+
+   pAnchors->assign(reversed.rbegin(), reversed.rend());
+}
+
+// recursively matches common lines between a[aStart,aEnd) and
+// b[bStart,bEnd), appending matched pairs (ordered and strictly
+// increasing on both sides) to pMatches
+void matchLines(const LineSet& a, std::size_t aStart, std::size_t aEnd,
+                const LineSet& b, std::size_t bStart, std::size_t bEnd,
+                std::size_t depth,
+                std::vector<LinePair>* pMatches)
+{
+   // trim the common prefix
+   while (aStart < aEnd && bStart < bEnd &&
+          a.keys[aStart] == b.keys[bStart])
+   {
+      pMatches->push_back(LinePair(aStart++, bStart++));
+   }
+
+   // trim the common suffix (appended after the interior is matched so
+   // the output stays ordered)
+   std::vector<LinePair> suffix;
+   while (aEnd > aStart && bEnd > bStart &&
+          a.keys[aEnd - 1] == b.keys[bEnd - 1])
+   {
+      suffix.push_back(LinePair(--aEnd, --bEnd));
+   }
+
+   if (aStart < aEnd && bStart < bEnd && depth < kMaxMatchDepth)
+   {
+      // tally line usage within the two ranges
+      std::map<std::string, LineUsage> usage;
+      for (std::size_t i = aStart; i < aEnd; i++)
+      {
+         LineUsage& entry = usage[a.keys[i]];
+         if (entry.countA++ == 0)
+            entry.firstA = i;
+      }
+      for (std::size_t i = bStart; i < bEnd; i++)
+      {
+         LineUsage& entry = usage[b.keys[i]];
+         if (entry.countB++ == 0)
+            entry.firstB = i;
+      }
+
+      // collect lines unique within both ranges (ordered by position in a)
+      std::vector<LinePair> candidates;
+      for (std::size_t i = aStart; i < aEnd; i++)
+      {
+         const LineUsage& entry = usage[a.keys[i]];
+         if (entry.countA == 1 && entry.countB == 1)
+            candidates.push_back(LinePair(i, entry.firstB));
+      }
+
+      std::vector<LinePair> anchors;
+      if (!candidates.empty())
+      {
+         longestIncreasingSubsequence(candidates, &anchors);
+      }
+      else
+      {
+         // histogram fallback: no unique common lines, so split on the
+         // least frequent line the ranges have in common (if it's rare
+         // enough to be a meaningful anchor)
+         std::size_t bestCount = kMaxOccurrences + 1;
+         LinePair best;
+         bool haveBest = false;
+         typedef std::map<std::string, LineUsage>::const_iterator Iterator;
+         for (Iterator it = usage.begin(); it != usage.end(); ++it)
+         {
+            const LineUsage& entry = it->second;
+            if (entry.countA > 0 && entry.countB > 0 &&
+                entry.countA + entry.countB < bestCount)
+            {
+               bestCount = entry.countA + entry.countB;
+               best = LinePair(entry.firstA, entry.firstB);
+               haveBest = true;
+            }
+         }
+         if (haveBest)
+            anchors.push_back(best);
+      }
+
+      // recurse between consecutive anchors
+      std::size_t prevA = aStart, prevB = bStart;
+      BOOST_FOREACH(const LinePair& anchor, anchors)
+      {
+         matchLines(a, prevA, anchor.first, b, prevB, anchor.second,
+                    depth + 1, pMatches);
+         pMatches->push_back(anchor);
+         prevA = anchor.first + 1;
+         prevB = anchor.second + 1;
+      }
+      if (!anchors.empty())
+         matchLines(a, prevA, aEnd, b, prevB, bEnd, depth + 1, pMatches);
+   }
+
+   pMatches->insert(pMatches->end(), suffix.rbegin(), suffix.rend());
+}
+
+// a contiguous changed region: lines a[aStart,aStart+aCount) were
+// replaced by b[bStart,bStart+bCount)
+struct Change
+{
+   Change() : aStart(0), aCount(0), bStart(0), bCount(0) {}
+
+   // COPYING: via compiler (copyable members)
+
+   std::size_t aStart;
+   std::size_t aCount;
+   std::size_t bStart;
+   std::size_t bCount;
+};
+
+void appendLine(std::ostringstream& ostr, char prefix,
+                const LineSet& set, std::size_t index)
+{
+   ostr << prefix << set.lines[index] << "\n";
+   if (index == set.lines.size() - 1 && set.noNewlineAtEof)
+      ostr << "\\ No newline at end of file\n";
+}
+
+void appendRange(std::ostringstream& ostr, std::size_t start,
+                 std::size_t count)
+{
+   // for empty ranges unified format shows the line *before* the range
+   ostr << (count == 0 ? start : start + 1);
+   if (count != 1)
+      ostr << "," << count;
+}
+
+} // anonymous namespace
+
+std::string unifiedDiff(const std::string& fromText,
+                        const std::string& toText,
+                        const DiffOptions& options)
+{
+   LineSet a, b;
+   splitLines(fromText, options.ignoreWhitespace, &a);
+   splitLines(toText, options.ignoreWhitespace, &b);
+
+   std::vector<LinePair> matches;
+   matchLines(a, 0, a.lines.size(), b, 0, b.lines.size(), 0, &matches);
+
+   // derive the changed regions from the matching
+   std::vector<Change> changes;
+   std::size_t ai = 0, bi = 0, mi = 0;
+   while (ai < a.lines.size() || bi < b.lines.size())
+   {
+      if (mi < matches.size() &&
+          matches[mi].first == ai && matches[mi].second == bi)
+      {
+         ai++;
+         bi++;
+         mi++;
+         continue;
+      }
+
+      Change change;
+      change.aStart = ai;
+      change.bStart = bi;
+      std::size_t nextA = mi < matches.size() ? matches[mi].first
+                                              : a.lines.size();
+      std::size_t nextB = mi < matches.size() ? matches[mi].second
+                                              : b.lines.size();
+      change.aCount = nextA - ai;
+      change.bCount = nextB - bi;
+      changes.push_back(change);
+      ai = nextA;
+      bi = nextB;
+   }
+
+   if (changes.empty())
+      return std::string();
+
+   std::size_t context = options.contextLines > 0 ?
+            static_cast<std::size_t>(options.contextLines) : 0;
+
+   // emit hunks, merging changes whose context would overlap or abut
+   std::ostringstream ostr;
+   std::size_t first = 0;
+   while (first < changes.size())
+   {
+      std::size_t last = first;
+      while (last + 1 < changes.size() &&
+             changes[last + 1].aStart -
+                (changes[last].aStart + changes[last].aCount) <= 2 * context)
+      {
+         last++;
+      }
+
+      // compute the hunk extents (clamped to the file)
+      std::size_t hunkAStart = changes[first].aStart > context ?
+               changes[first].aStart - context : 0;
+      std::size_t changesAEnd = changes[last].aStart + changes[last].aCount;
+      std::size_t hunkAEnd = std::min(changesAEnd + context, a.lines.size());
+
+      // the regions surrounding the changes are common, so the b extents
+      // follow from the a extents by offset
+      std::size_t hunkBStart = changes[first].bStart -
+               (changes[first].aStart - hunkAStart);
+      std::size_t hunkBEnd = changes[last].bStart + changes[last].bCount +
+               (hunkAEnd - changesAEnd);
+
+      ostr << "@@ -";
+      appendRange(ostr, hunkAStart, hunkAEnd - hunkAStart);
+      ostr << " +";
+      appendRange(ostr, hunkBStart, hunkBEnd - hunkBStart);
+      ostr << " @@\n";
+
+      std::size_t cursorA = hunkAStart, cursorB = hunkBStart;
+      for (std::size_t i = first; i <= last; i++)
+      {
+         for ( ; cursorA < changes[i].aStart; cursorA++, cursorB++)
+            appendLine(ostr, ' ', a, cursorA);
+         for ( ; cursorA < changes[i].aStart + changes[i].aCount; cursorA++)
+            appendLine(ostr, '-', a, cursorA);
+         for ( ; cursorB < changes[i].bStart + changes[i].bCount; cursorB++)
+            appendLine(ostr, '+', b, cursorB);
+      }
+      for ( ; cursorA < hunkAEnd; cursorA++)
+         appendLine(ostr, ' ', a, cursorA);
+
+      first = last + 1;
+   }
+
+   return ostr.str();
+}
+
+} // namespace diff
+} // namespace core
+} // namespace rstudio
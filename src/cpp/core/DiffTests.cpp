@@ -0,0 +1,99 @@
+/*
+ * DiffTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+
+#include <core/Diff.hpp>
+
+namespace rstudio {
+namespace core {
+
+context("Unified diff generation")
+{
+   test_that("Identical texts produce an empty diff")
+   {
+      diff::DiffOptions options;
+      expect_true(diff::unifiedDiff("a\nb\nc\n", "a\nb\nc\n", options).empty());
+      expect_true(diff::unifiedDiff("", "", options).empty());
+   }
+
+   test_that("A single changed line produces the expected hunk")
+   {
+      diff::DiffOptions options;
+      std::string diff = diff::unifiedDiff("a\nb\nc\n", "a\nx\nc\n", options);
+      expect_true(diff == "@@ -1,3 +1,3 @@\n a\n-b\n+x\n c\n");
+   }
+
+   test_that("Zero context emits only the changed lines")
+   {
+      diff::DiffOptions options;
+      options.contextLines = 0;
+      std::string diff = diff::unifiedDiff("a\nb\nc\n", "a\nx\nc\n", options);
+      expect_true(diff == "@@ -2 +2 @@\n-b\n+x\n");
+   }
+
+   test_that("Pure insertions and deletions are represented")
+   {
+      diff::DiffOptions options;
+      options.contextLines = 0;
+      std::string diff = diff::unifiedDiff("a\nc\n", "a\nb\nc\n", options);
+      expect_true(diff == "@@ -1,0 +2 @@\n+b\n");
+
+      diff = diff::unifiedDiff("a\nb\nc\n", "a\nc\n", options);
+      expect_true(diff == "@@ -2 +1,0 @@\n-b\n");
+   }
+
+   test_that("Distant changes land in separate hunks")
+   {
+      diff::DiffOptions options;
+      options.contextLines = 1;
+      std::string diff = diff::unifiedDiff(
+               "a\nb\nc\nd\ne\nf\ng\n",
+               "a\nx\nc\nd\ne\ny\ng\n",
+               options);
+      expect_true(diff ==
+            "@@ -1,3 +1,3 @@\n a\n-b\n+x\n c\n"
+            "@@ -5,3 +5,3 @@\n e\n-f\n+y\n g\n");
+   }
+
+   test_that("A missing trailing newline is marked")
+   {
+      diff::DiffOptions options;
+      std::string diff = diff::unifiedDiff("a\nb\n", "a\nb", options);
+      expect_true(diff ==
+            "@@ -1,2 +1,2 @@\n a\n-b\n+b\n\\ No newline at end of file\n");
+   }
+
+   test_that("Whitespace differences can be ignored")
+   {
+      diff::DiffOptions options;
+      expect_false(diff::unifiedDiff("a  1\nb\n", "a 1\r\nb\n", options).empty());
+
+      options.ignoreWhitespace = true;
+      expect_true(diff::unifiedDiff("a  1\nb\n", "a 1\r\nb\n", options).empty());
+   }
+
+   test_that("Repeated lines still diff correctly")
+   {
+      diff::DiffOptions options;
+      options.contextLines = 0;
+      std::string diff = diff::unifiedDiff(
+               "x\nx\nx\nx\n", "x\nx\ny\nx\nx\n", options);
+      expect_true(diff == "@@ -2,0 +3 @@\n+y\n");
+   }
+}
+
+} // namespace core
+} // namespace rstudio
@@ -15,6 +15,15 @@
 
 #include <core/Exec.hpp>
 
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <boost/system/error_code.hpp>
+
+#include <core/BoostThread.hpp>
 #include <core/Error.hpp>
 
 namespace rstudio {
@@ -38,12 +47,292 @@ Error ExecBlock::execute() const
    return Success();
 }
    
-Error ExecBlock::operator()() const 
-{  
-   return execute(); 
+Error ExecBlock::operator()() const
+{
+   return execute();
 }
-   
-} // namespace core 
+
+namespace {
+
+enum TaskStatus
+{
+   TaskPending,
+   TaskRunning,
+   TaskComplete
+};
+
+// shared state for one ParallelExecBlock::execute run. the calling
+// thread and the pool threads coordinate exclusively through this
+// structure (under its mutex)
+struct ParallelExecState
+{
+   ParallelExecState() : stopped(false) {}
+
+   boost::mutex mutex;
+   boost::condition condition;
+   std::vector<TaskStatus> status;
+
+   // task snapshot and prerequisite indices (resolved from names before
+   // any thread starts, read-only thereafter)
+   std::vector<std::string> names;
+   std::vector<ExecBlock::Function> functions;
+   std::vector<bool> concurrent;
+   std::vector<std::vector<std::size_t> > prerequisites;
+
+   // first error which occurred; once set no new tasks are started
+   Error error;
+   bool stopped;
+};
+
+// callers hold state.mutex
+bool prerequisitesComplete(const ParallelExecState& state, std::size_t index)
+{
+   const std::vector<std::size_t>& prereqs = state.prerequisites[index];
+   for (std::size_t i = 0; i < prereqs.size(); i++)
+   {
+      if (state.status[prereqs[i]] != TaskComplete)
+         return false;
+   }
+   return true;
+}
+
+boost::int64_t runTask(const ExecBlock::Function& function, Error* pError)
+{
+   using namespace boost::posix_time;
+   ptime startTime = microsec_clock::universal_time();
+   *pError = function();
+   return (microsec_clock::universal_time() - startTime).total_microseconds();
+}
+
+// callers hold state.mutex; records the completion of a task and wakes
+// anything waiting on it
+void completeTask(ParallelExecState* pState, std::size_t index, const Error& error)
+{
+   pState->status[index] = TaskComplete;
+   if (error && !pState->stopped)
+   {
+      pState->error = error;
+      pState->stopped = true;
+   }
+   pState->condition.notify_all();
+}
+
+// pool thread: repeatedly claim the first pending concurrent task whose
+// prerequisites have completed, run it, and record the result; exits
+// when no concurrent tasks remain (or an error has stopped the block)
+void parallelExecWorker(boost::shared_ptr<ParallelExecState> pState,
+                        ParallelExecBlock::TaskObserver observer)
+{
+   for (;;)
+   {
+      std::size_t index = 0;
+      {
+         boost::mutex::scoped_lock lock(pState->mutex);
+         for (;;)
+         {
+            if (pState->stopped)
+               return;
+
+            bool anyPending = false;
+            std::size_t ready = pState->functions.size();
+            for (std::size_t i = 0; i < pState->functions.size(); i++)
+            {
+               if (!pState->concurrent[i] ||
+                   pState->status[i] != TaskPending)
+               {
+                  continue;
+               }
+
+               anyPending = true;
+               if (prerequisitesComplete(*pState, i))
+               {
+                  ready = i;
+                  break;
+               }
+            }
+
+            if (ready < pState->functions.size())
+            {
+               index = ready;
+               pState->status[index] = TaskRunning;
+               break;
+            }
+
+            if (!anyPending)
+               return;
+
+            // pending tasks exist but none are ready -- wait for a
+            // prerequisite to complete (prerequisites always refer to
+            // earlier tasks, so one is guaranteed to be in progress)
+            pState->condition.wait(lock);
+         }
+      }
+
+      Error error;
+      boost::int64_t microseconds = runTask(pState->functions[index], &error);
+
+      {
+         boost::mutex::scoped_lock lock(pState->mutex);
+         completeTask(pState.get(), index, error);
+      }
+
+      if (observer)
+         observer(pState->names[index], microseconds);
+   }
+}
+
+} // anonymous namespace
+
+ParallelExecBlock& ParallelExecBlock::add(const std::string& name,
+                                          const Function& function)
+{
+   return addTask(name, function, false, std::vector<std::string>());
+}
+
+ParallelExecBlock& ParallelExecBlock::add(
+                           const std::string& name,
+                           const Function& function,
+                           const std::vector<std::string>& prerequisites)
+{
+   return addTask(name, function, false, prerequisites);
+}
+
+ParallelExecBlock& ParallelExecBlock::addConcurrent(const std::string& name,
+                                                    const Function& function)
+{
+   return addTask(name, function, true, std::vector<std::string>());
+}
+
+ParallelExecBlock& ParallelExecBlock::addConcurrent(
+                           const std::string& name,
+                           const Function& function,
+                           const std::vector<std::string>& prerequisites)
+{
+   return addTask(name, function, true, prerequisites);
+}
+
+std::vector<std::string> ParallelExecBlock::dependsOn(const std::string& name)
+{
+   std::vector<std::string> prerequisites;
+   prerequisites.push_back(name);
+   return prerequisites;
+}
+
+std::vector<std::string> ParallelExecBlock::dependsOn(const std::string& name1,
+                                                      const std::string& name2)
+{
+   std::vector<std::string> prerequisites;
+   prerequisites.push_back(name1);
+   prerequisites.push_back(name2);
+   return prerequisites;
+}
+
+ParallelExecBlock& ParallelExecBlock::addTask(
+                           const std::string& name,
+                           const Function& function,
+                           bool concurrent,
+                           const std::vector<std::string>& prerequisites)
+{
+   Task task;
+   task.name = name;
+   task.function = function;
+   task.concurrent = concurrent;
+   task.prerequisites = prerequisites;
+   tasks_.push_back(task);
+   return *this;
+}
+
+Error ParallelExecBlock::execute()
+{
+   // snapshot the tasks into the shared state and resolve prerequisite
+   // names to indices -- a prerequisite must refer to a previously
+   // declared task, which also guarantees the graph has no cycles
+   boost::shared_ptr<ParallelExecState> pState(new ParallelExecState());
+   pState->status.resize(tasks_.size(), TaskPending);
+   pState->prerequisites.resize(tasks_.size());
+   std::size_t numConcurrent = 0;
+   for (std::size_t i = 0; i < tasks_.size(); i++)
+   {
+      pState->names.push_back(tasks_[i].name);
+      pState->functions.push_back(tasks_[i].function);
+      pState->concurrent.push_back(tasks_[i].concurrent);
+      if (tasks_[i].concurrent)
+         numConcurrent++;
+
+      const std::vector<std::string>& prereqs = tasks_[i].prerequisites;
+      for (std::size_t p = 0; p < prereqs.size(); p++)
+      {
+         std::size_t target = tasks_.size();
+         for (std::size_t j = 0; j < i; j++)
+         {
+            if (tasks_[j].name == prereqs[p])
+            {
+               target = j;
+               break;
+            }
+         }
+         if (target == tasks_.size())
+         {
+            return systemError(boost::system::errc::invalid_argument,
+                               "unknown prerequisite '" + prereqs[p] +
+                               "' for task '" + tasks_[i].name + "'",
+                               ERROR_LOCATION);
+         }
+         pState->prerequisites[i].push_back(target);
+      }
+   }
+
+   // start the pool (only as many threads as there are concurrent tasks)
+   std::vector<boost::shared_ptr<boost::thread> > threads;
+   std::size_t numThreads = std::min(numThreads_, numConcurrent);
+   for (std::size_t i = 0; i < numThreads; i++)
+   {
+      threads.push_back(boost::shared_ptr<boost::thread>(new boost::thread(
+         boost::bind(parallelExecWorker, pState, observer_))));
+   }
+
+   // run calling-thread tasks in declaration order, waiting for any
+   // declared prerequisites (which may be running on the pool)
+   for (std::size_t i = 0; i < tasks_.size(); i++)
+   {
+      if (tasks_[i].concurrent)
+         continue;
+
+      {
+         boost::mutex::scoped_lock lock(pState->mutex);
+         while (!pState->stopped && !prerequisitesComplete(*pState, i))
+            pState->condition.wait(lock);
+         if (pState->stopped)
+            break;
+         pState->status[i] = TaskRunning;
+      }
+
+      Error error;
+      boost::int64_t microseconds = runTask(tasks_[i].function, &error);
+
+      {
+         boost::mutex::scoped_lock lock(pState->mutex);
+         completeTask(pState.get(), i, error);
+      }
+
+      if (observer_)
+         observer_(tasks_[i].name, microseconds);
+   }
+
+   // wait for in-flight concurrent tasks to finish
+   for (std::size_t i = 0; i < threads.size(); i++)
+      threads[i]->join();
+
+   boost::mutex::scoped_lock lock(pState->mutex);
+   return pState->error;
+}
+
+Error ParallelExecBlock::operator()()
+{
+   return execute();
+}
+
+} // namespace core
 } // namespace rstudio
 
 
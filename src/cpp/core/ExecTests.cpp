@@ -0,0 +1,162 @@
+/*
+ * ExecTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+
+#include <vector>
+
+#include <boost/bind.hpp>
+
+#include <core/BoostThread.hpp>
+#include <core/Error.hpp>
+#include <core/Exec.hpp>
+
+namespace rstudio {
+namespace core {
+namespace tests {
+
+namespace {
+
+boost::mutex s_recordMutex;
+
+Error recordTask(std::vector<std::string>* pOrder, const std::string& name)
+{
+   boost::mutex::scoped_lock lock(s_recordMutex);
+   pOrder->push_back(name);
+   return Success();
+}
+
+Error failingTask()
+{
+   return systemError(boost::system::errc::operation_canceled,
+                      ERROR_LOCATION);
+}
+
+Error checkFlagTask(bool* pFlag, bool* pResult)
+{
+   boost::mutex::scoped_lock lock(s_recordMutex);
+   *pResult = *pFlag;
+   return Success();
+}
+
+Error setFlagTask(bool* pFlag)
+{
+   boost::mutex::scoped_lock lock(s_recordMutex);
+   *pFlag = true;
+   return Success();
+}
+
+void observeTask(std::vector<std::string>* pObserved,
+                 const std::string& name,
+                 boost::int64_t microseconds)
+{
+   boost::mutex::scoped_lock lock(s_recordMutex);
+   pObserved->push_back(name);
+}
+
+} // anonymous namespace
+
+context("ParallelExecBlock")
+{
+   test_that("calling-thread tasks run in declaration order")
+   {
+      std::vector<std::string> order;
+      ParallelExecBlock block;
+      block.addFunctions()
+         ("first", boost::bind(recordTask, &order, "first"))
+         ("second", boost::bind(recordTask, &order, "second"))
+         ("third", boost::bind(recordTask, &order, "third"));
+
+      Error error = block.execute();
+      expect_false(error);
+      expect_true(order.size() == 3);
+      expect_true(order[0] == "first");
+      expect_true(order[1] == "second");
+      expect_true(order[2] == "third");
+   }
+
+   test_that("concurrent tasks complete before execute returns")
+   {
+      std::vector<std::string> order;
+      ParallelExecBlock block;
+      block.add("serial", boost::bind(recordTask, &order, "serial"));
+      block.addConcurrent("pool1", boost::bind(recordTask, &order, "pool1"));
+      block.addConcurrent("pool2", boost::bind(recordTask, &order, "pool2"));
+
+      Error error = block.execute();
+      expect_false(error);
+      expect_true(order.size() == 3);
+   }
+
+   test_that("prerequisites complete before dependent tasks start")
+   {
+      bool flag = false;
+      bool sawFlag = false;
+      ParallelExecBlock block;
+      block.add("prereq", boost::bind(setFlagTask, &flag));
+      block.addConcurrent("dependent",
+                          boost::bind(checkFlagTask, &flag, &sawFlag),
+                          ParallelExecBlock::dependsOn("prereq"));
+
+      Error error = block.execute();
+      expect_false(error);
+      expect_true(sawFlag);
+   }
+
+   test_that("an error stops subsequent calling-thread tasks")
+   {
+      std::vector<std::string> order;
+      ParallelExecBlock block;
+      block.add("first", boost::bind(recordTask, &order, "first"));
+      block.add("failing", failingTask);
+      block.add("skipped", boost::bind(recordTask, &order, "skipped"));
+
+      Error error = block.execute();
+      expect_true(error != Success());
+      expect_true(order.size() == 1);
+      expect_true(order[0] == "first");
+   }
+
+   test_that("unknown prerequisites are reported as errors")
+   {
+      std::vector<std::string> order;
+      ParallelExecBlock block;
+      block.add("task",
+                boost::bind(recordTask, &order, "task"),
+                ParallelExecBlock::dependsOn("no-such-task"));
+
+      Error error = block.execute();
+      expect_true(error != Success());
+      expect_true(order.empty());
+   }
+
+   test_that("the task observer sees every task")
+   {
+      std::vector<std::string> order;
+      std::vector<std::string> observed;
+      ParallelExecBlock block;
+      block.setTaskObserver(boost::bind(observeTask, &observed, _1, _2));
+      block.add("serial", boost::bind(recordTask, &order, "serial"));
+      block.addConcurrent("pool", boost::bind(recordTask, &order, "pool"));
+
+      Error error = block.execute();
+      expect_false(error);
+      expect_true(observed.size() == 2);
+   }
+}
+
+} // namespace tests
+} // namespace core
+} // namespace rstudio
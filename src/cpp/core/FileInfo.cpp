@@ -15,18 +15,78 @@
 
 #include <core/FileInfo.hpp>
 
+#include <algorithm>
+
+#include <boost/weak_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
 #include <core/FilePath.hpp>
+#include <core/Thread.hpp>
 
 namespace rstudio {
 namespace core {
 
+namespace {
+
+typedef boost::unordered_map<std::string,
+                             boost::weak_ptr<const std::string> > InternMap;
+
+// intern a directory prefix -- callers holding the same prefix share a
+// single heap copy of it. entries are held weakly so the table doesn't
+// pin directories which no longer have any FileInfo referencing them;
+// expired entries are swept opportunistically as the table grows
+boost::shared_ptr<const std::string> internDirectory(const std::string& dir)
+{
+   static boost::mutex s_mutex;
+   static InternMap s_directories;
+   static std::size_t s_sweepThreshold = 512;
+
+   LOCK_MUTEX(s_mutex)
+   {
+      InternMap::iterator it = s_directories.find(dir);
+      if (it != s_directories.end())
+      {
+         boost::shared_ptr<const std::string> pDir = it->second.lock();
+         if (pDir)
+            return pDir;
+      }
+
+      boost::shared_ptr<const std::string> pDir(new std::string(dir));
+      s_directories[dir] = pDir;
+
+      if (s_directories.size() >= s_sweepThreshold)
+      {
+         for (InternMap::iterator sweepIt = s_directories.begin();
+              sweepIt != s_directories.end();
+              )
+         {
+            if (sweepIt->second.expired())
+               sweepIt = s_directories.erase(sweepIt);
+            else
+               ++sweepIt;
+         }
+         s_sweepThreshold = std::max<std::size_t>(512,
+                                                  s_directories.size() * 2);
+      }
+
+      return pDir;
+   }
+   END_LOCK_MUTEX
+
+   // keep compiler happy
+   return boost::shared_ptr<const std::string>();
+}
+
+} // anonymous namespace
+
 FileInfo::FileInfo(const FilePath& filePath, bool isSymlink)
-   :  absolutePath_(filePath.absolutePath()),
-      isDirectory_(filePath.isDirectory()),
+   :  isDirectory_(filePath.isDirectory()),
       size_(0),
       lastWriteTime_(0),
       isSymlink_(isSymlink)
 {
+   initFromPath(filePath.absolutePath());
+
    if (!isDirectory_ && filePath.exists())
    {
       size_ = filePath.size();
@@ -37,25 +97,43 @@ FileInfo::FileInfo(const FilePath& filePath, bool isSymlink)
 FileInfo::FileInfo(const std::string& absolutePath,
                    bool isDirectory,
                    bool isSymlink)
- :    absolutePath_(absolutePath),
-      isDirectory_(isDirectory),
+ :    isDirectory_(isDirectory),
       size_(0),
       lastWriteTime_(0),
       isSymlink_(isSymlink)
 {
+   initFromPath(absolutePath);
 }
-   
+
 FileInfo::FileInfo(const std::string& absolutePath,
                    bool isDirectory,
                    uintmax_t size,
                    std::time_t lastWriteTime,
                    bool isSymlink)
-   :  absolutePath_(absolutePath),
-      isDirectory_(isDirectory),
+   :  isDirectory_(isDirectory),
       size_(size),
       lastWriteTime_(lastWriteTime),
       isSymlink_(isSymlink)
 {
+   initFromPath(absolutePath);
+}
+
+void FileInfo::initFromPath(const std::string& absolutePath)
+{
+   // split at the last path separator: everything up to and including it
+   // is the (shared) directory prefix, the remainder is the leaf name.
+   // note that the split is deterministic for a given path so splitting
+   // and re-concatenating always reproduces the original string exactly
+   std::string::size_type lastSlash = absolutePath.find_last_of('/');
+   if (lastSlash == std::string::npos)
+   {
+      name_ = absolutePath;
+   }
+   else
+   {
+      directory_ = internDirectory(absolutePath.substr(0, lastSlash + 1));
+      name_ = absolutePath.substr(lastSlash + 1);
+   }
 }
    
 std::ostream& operator << (std::ostream& stream, const FileInfo& fileInfo)
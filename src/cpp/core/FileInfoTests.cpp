@@ -0,0 +1,72 @@
+/*
+ * FileInfoTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+
+#include <core/FileInfo.hpp>
+
+namespace rstudio {
+namespace core {
+
+context("FileInfo path interning")
+{
+   test_that("Paths round-trip through the interned representation")
+   {
+      const char* paths[] = {
+         "/",
+         "/foo",
+         "/foo/",
+         "/foo/bar.R",
+         "/foo/bar/baz.R",
+         "relative.R",
+         ""
+      };
+
+      for (std::size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++)
+      {
+         FileInfo fileInfo(paths[i], false);
+         expect_true(fileInfo.absolutePath() == std::string(paths[i]));
+      }
+   }
+
+   test_that("Equality respects the full path")
+   {
+      expect_true(FileInfo("/foo/bar.R", false) ==
+                  FileInfo("/foo/bar.R", false));
+      expect_true(FileInfo("/foo/bar.R", false) !=
+                  FileInfo("/foo/baz.R", false));
+      expect_true(FileInfo("/foo/bar.R", false) !=
+                  FileInfo("/fool/bar.R", false));
+   }
+
+   test_that("Path comparisons order by full path")
+   {
+      // files in different directories whose piecewise ordering differs
+      // from their full-path ordering
+      FileInfo a("/ab", false);
+      FileInfo b("/a/c", false);
+      expect_true(fileInfoPathLessThan(b, a));
+      expect_false(fileInfoPathLessThan(a, b));
+   }
+
+   test_that("Empty FileInfo reports empty")
+   {
+      expect_true(FileInfo().empty());
+      expect_false(FileInfo("/foo", true).empty());
+   }
+}
+
+} // namespace core
+} // namespace rstudio
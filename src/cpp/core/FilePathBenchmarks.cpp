@@ -0,0 +1,149 @@
+/*
+ * FilePathBenchmarks.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <benchmark/Benchmark.hpp>
+
+#include <string>
+#include <vector>
+
+#include <core/FilePath.hpp>
+#include <core/SafeConvert.hpp>
+
+namespace rstudio {
+namespace core {
+namespace benchmarks {
+namespace {
+
+// a deep relative path of the kind produced by package source trees
+const int kPathDepth = 16;
+
+std::string deepRelativePath()
+{
+   std::string path;
+   for (int i = 0; i < kPathDepth; i++)
+   {
+      if (i > 0)
+         path += "/";
+      path += "directory" + safe_convert::numberToString(i);
+   }
+   return path + "/SomeSourceFile.R";
+}
+
+// build a deep on-disk directory tree under a temp directory (created
+// once and shared by the scan benchmarks; left for the OS to clean up
+// with the rest of the temp directory)
+FilePath directoryTreeFixture()
+{
+   static FilePath s_treePath;
+   if (s_treePath.empty())
+   {
+      FilePath tempPath;
+      Error error = FilePath::tempFilePath(&tempPath);
+      if (error)
+         return FilePath();
+
+      s_treePath = tempPath;
+
+      // three levels of four directories, four files in each leaf
+      for (int i = 0; i < 4; i++)
+      {
+         for (int j = 0; j < 4; j++)
+         {
+            for (int k = 0; k < 4; k++)
+            {
+               FilePath dirPath = s_treePath
+                     .childPath("dir" + safe_convert::numberToString(i))
+                     .childPath("dir" + safe_convert::numberToString(j))
+                     .childPath("dir" + safe_convert::numberToString(k));
+               error = dirPath.ensureDirectory();
+               if (error)
+                  return FilePath();
+
+               for (int f = 0; f < 4; f++)
+               {
+                  dirPath.childPath(
+                     "file" + safe_convert::numberToString(f) + ".R")
+                        .ensureFile();
+               }
+            }
+         }
+      }
+   }
+   return s_treePath;
+}
+
+int scanTree(const FilePath& dirPath)
+{
+   std::vector<FilePath> children;
+   Error error = dirPath.children(&children);
+   if (error)
+      return 0;
+
+   int count = 0;
+   for (std::size_t i = 0; i < children.size(); i++)
+   {
+      if (children[i].isDirectory())
+         count += scanTree(children[i]);
+      else
+         count++;
+   }
+   return count;
+}
+
+} // anonymous namespace
+
+BENCHMARK(benchmarkFilePathConstruction)
+{
+   std::string path = "/opt/R/library/" + deepRelativePath();
+
+   std::size_t sink = 0;
+   while (state.keepRunning())
+   {
+      FilePath filePath(path);
+      sink += filePath.filename().size();
+      sink += filePath.extension().size();
+   }
+   benchmark::doNotOptimize(sink);
+}
+
+BENCHMARK(benchmarkFilePathComplete)
+{
+   FilePath basePath("/opt/R/library");
+   std::string relativePath = deepRelativePath();
+
+   std::size_t sink = 0;
+   while (state.keepRunning())
+   {
+      FilePath completed = basePath.complete(relativePath);
+      sink += completed.absolutePath().size();
+   }
+   benchmark::doNotOptimize(sink);
+}
+
+BENCHMARK(benchmarkFilePathTreeScan)
+{
+   FilePath treePath = directoryTreeFixture();
+   if (treePath.empty())
+      return;
+
+   int sink = 0;
+   while (state.keepRunning())
+      sink += scanTree(treePath);
+   benchmark::doNotOptimize(sink);
+}
+
+} // namespace benchmarks
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,118 @@
+/*
+ * FileSerializerTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+
+#include <core/FileSerializer.hpp>
+#include <core/SafeConvert.hpp>
+
+namespace rstudio {
+namespace core {
+
+context("File serializer collections")
+{
+   test_that("String vectors round trip through a file")
+   {
+      FilePath filePath;
+      Error error = FilePath::tempFilePath(&filePath);
+      REQUIRE_FALSE(error);
+
+      std::vector<std::string> lines;
+      for (int i = 0; i < 1000; i++)
+         lines.push_back("line " + safe_convert::numberToString(i));
+
+      error = writeStringVectorToFile(filePath, lines);
+      REQUIRE_FALSE(error);
+
+      std::vector<std::string> readLines;
+      error = readStringVectorFromFile(filePath, &readLines);
+      REQUIRE_FALSE(error);
+
+      expect_true(readLines == lines);
+
+      filePath.removeIfExists();
+   }
+
+   test_that("Blank lines are trimmed and ignored when requested")
+   {
+      FilePath filePath;
+      Error error = FilePath::tempFilePath(&filePath);
+      REQUIRE_FALSE(error);
+
+      error = writeStringToFile(filePath, "  one  \n\n   \ntwo\n");
+      REQUIRE_FALSE(error);
+
+      std::vector<std::string> readLines;
+      error = readStringVectorFromFile(filePath, &readLines);
+      REQUIRE_FALSE(error);
+
+      expect_true(readLines.size() == 2);
+      expect_true(readLines[0] == "one");
+      expect_true(readLines[1] == "two");
+
+      // without trimming every terminated line is preserved as-is
+      readLines.clear();
+      error = readStringVectorFromFile(filePath, &readLines, false);
+      REQUIRE_FALSE(error);
+
+      expect_true(readLines.size() == 4);
+      expect_true(readLines[0] == "  one  ");
+
+      filePath.removeIfExists();
+   }
+
+   test_that("String maps round trip through a file")
+   {
+      FilePath filePath;
+      Error error = FilePath::tempFilePath(&filePath);
+      REQUIRE_FALSE(error);
+
+      std::map<std::string,std::string> map;
+      map["alpha"] = "1";
+      map["beta"] = "2";
+
+      error = writeStringMapToFile(filePath, map);
+      REQUIRE_FALSE(error);
+
+      std::map<std::string,std::string> readMap;
+      error = readStringMapFromFile(filePath, &readMap);
+      REQUIRE_FALSE(error);
+
+      expect_true(readMap == map);
+
+      filePath.removeIfExists();
+   }
+
+   test_that("Empty files yield empty collections")
+   {
+      FilePath filePath;
+      Error error = FilePath::tempFilePath(&filePath);
+      REQUIRE_FALSE(error);
+
+      error = writeStringToFile(filePath, "");
+      REQUIRE_FALSE(error);
+
+      std::vector<std::string> readLines;
+      error = readStringVectorFromFile(filePath, &readLines);
+      REQUIRE_FALSE(error);
+
+      expect_true(readLines.empty());
+
+      filePath.removeIfExists();
+   }
+}
+
+} // namespace core
+} // namespace rstudio
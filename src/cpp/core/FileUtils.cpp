@@ -13,14 +13,19 @@
  *
  */
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/function.hpp>
 
 #include <core/FileUtils.hpp>
 #include <core/FilePath.hpp>
 #include <core/StringUtils.hpp>
+#include <core/Thread.hpp>
 
 #include <core/system/System.hpp>
 
@@ -56,6 +61,104 @@ bool copySourceFile(const FilePath& sourceDir,
    return true;
 }
 
+// parallel file operation engine: a set of paths (typically the
+// top-level subtrees of a directory) is distributed across a small pool
+// of worker threads, each applying the same operation. the first error
+// stops further dispatch (in-flight items still complete)
+const std::size_t kNumFileOpWorkers = 4;
+
+struct ParallelFileOp
+{
+   ParallelFileOp() : nextItem(0) {}
+
+   boost::mutex mutex;
+   std::vector<FilePath> items;
+   std::size_t nextItem;
+   boost::function<Error(const FilePath&)> operation;
+   Error error;
+};
+
+void fileOpWorker(boost::shared_ptr<ParallelFileOp> pOp)
+{
+   for (;;)
+   {
+      FilePath item;
+      LOCK_MUTEX(pOp->mutex)
+      {
+         if (pOp->error || pOp->nextItem >= pOp->items.size())
+            return;
+         item = pOp->items[pOp->nextItem++];
+      }
+      END_LOCK_MUTEX
+
+      Error error = pOp->operation(item);
+      if (error)
+      {
+         LOCK_MUTEX(pOp->mutex)
+         {
+            if (!pOp->error)
+               pOp->error = error;
+         }
+         END_LOCK_MUTEX
+      }
+   }
+}
+
+Error performParallelFileOp(
+               const std::vector<FilePath>& items,
+               const boost::function<Error(const FilePath&)>& operation)
+{
+   // sequential when the pool wouldn't help
+   if (items.size() < 2)
+   {
+      BOOST_FOREACH(const FilePath& item, items)
+      {
+         Error error = operation(item);
+         if (error)
+            return error;
+      }
+      return Success();
+   }
+
+   boost::shared_ptr<ParallelFileOp> pOp(new ParallelFileOp());
+   pOp->items = items;
+   pOp->operation = operation;
+
+   std::size_t numWorkers = std::min(kNumFileOpWorkers, items.size());
+   std::vector<boost::shared_ptr<boost::thread> > threads;
+   for (std::size_t i = 0; i < numWorkers; i++)
+   {
+      try
+      {
+         threads.push_back(boost::shared_ptr<boost::thread>(
+                              new boost::thread(fileOpWorker, pOp)));
+      }
+      catch(const boost::thread_resource_error&)
+      {
+         break;
+      }
+   }
+
+   // if no threads could be created then just do the work here
+   if (threads.empty())
+      fileOpWorker(pOp);
+
+   BOOST_FOREACH(boost::shared_ptr<boost::thread>& pThread, threads)
+      pThread->join();
+
+   return pOp->error;
+}
+
+Error copyDirectoryEntry(const FilePath& targetDirectory,
+                         const FilePath& sourcePath)
+{
+   FilePath targetPath = targetDirectory.childPath(sourcePath.filename());
+   if (sourcePath.isDirectory())
+      return copyDirectory(sourcePath, targetPath);
+   else
+      return sourcePath.copy(targetPath);
+}
+
 } // anonymous namespace
 
 FilePath uniqueFilePath(const FilePath& parent, const std::string& prefix)
@@ -133,6 +236,45 @@ Error copyDirectory(const FilePath& sourceDirectory,
      boost::bind(copySourceFile, sourceDirectory, targetDirectory, _2));
 }
 
+Error copyDirectoryParallel(const FilePath& sourceDirectory,
+                            const FilePath& targetDirectory)
+{
+   // create the target directory
+   Error error = targetDirectory.ensureDirectory();
+   if (error)
+      return error;
+
+   // distribute the top-level subtrees across the worker pool
+   std::vector<FilePath> children;
+   error = sourceDirectory.children(&children);
+   if (error)
+      return error;
+
+   return performParallelFileOp(
+            children,
+            boost::bind(copyDirectoryEntry, targetDirectory, _1));
+}
+
+Error removeParallel(const FilePath& filePath)
+{
+   if (!filePath.isDirectory())
+      return filePath.remove();
+
+   // distribute the top-level subtrees across the worker pool
+   std::vector<FilePath> children;
+   Error error = filePath.children(&children);
+   if (error)
+      return error;
+
+   error = performParallelFileOp(children,
+                                 boost::bind(&FilePath::remove, _1));
+   if (error)
+      return error;
+
+   // remove the (now empty) root
+   return filePath.remove();
+}
+
 
 } // namespace file_utils
 } // namespace core
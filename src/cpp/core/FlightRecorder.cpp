@@ -0,0 +1,98 @@
+/*
+ * FlightRecorder.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/FlightRecorder.hpp>
+
+#include <cstring>
+#include <atomic>
+#include <sstream>
+
+#include <boost/cstdint.hpp>
+
+#include <core/DateTime.hpp>
+
+namespace rstudio {
+namespace core {
+namespace flight_recorder {
+
+namespace {
+
+// ring dimensions -- the entry count must be a power of two so the
+// ring index can be computed with a mask
+const std::size_t kEntryCount = 2048;
+const std::size_t kDetailLength = 64;
+
+struct Entry
+{
+   double timestampMs;
+   const char* event;
+   char detail[kDetailLength];
+};
+
+Entry s_entries[kEntryCount];
+
+// next slot to write -- monotonically increasing so the total number of
+// recorded events is also available
+std::atomic<boost::uint64_t> s_nextIndex(0);
+
+} // anonymous namespace
+
+void record(const char* event, const std::string& detail)
+{
+   // claim a slot (relaxed ordering: entries are self-contained and a
+   // torn read by a concurrent dump only garbles that one line)
+   boost::uint64_t index = s_nextIndex.fetch_add(1,
+                                                 std::memory_order_relaxed);
+   Entry& entry = s_entries[index & (kEntryCount - 1)];
+
+   entry.timestampMs = date_time::millisecondsSinceEpoch();
+   entry.event = event;
+   entry.detail[0] = '\0';
+   if (!detail.empty())
+   {
+      ::strncpy(entry.detail, detail.c_str(), kDetailLength - 1);
+      entry.detail[kDetailLength - 1] = '\0';
+   }
+}
+
+std::string contents()
+{
+   // snapshot the write position. the dump is best-effort: entries
+   // written while we read may garble individual lines, but the
+   // recorder must never block or slow the threads being observed
+   boost::uint64_t endIndex = s_nextIndex.load(std::memory_order_relaxed);
+   boost::uint64_t startIndex = endIndex > kEntryCount ?
+                                             endIndex - kEntryCount : 0;
+
+   std::ostringstream ostr;
+   for (boost::uint64_t i = startIndex; i < endIndex; i++)
+   {
+      const Entry& entry = s_entries[i & (kEntryCount - 1)];
+      if (entry.event == NULL)
+         continue;
+
+      ostr << date_time::millisecondsSinceEpochAsString(entry.timestampMs)
+           << " " << entry.event;
+      if (entry.detail[0] != '\0')
+         ostr << " " << entry.detail;
+      ostr << "\n";
+   }
+
+   return ostr.str();
+}
+
+} // namespace flight_recorder
+} // namespace core
+} // namespace rstudio
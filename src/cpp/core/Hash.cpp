@@ -15,6 +15,7 @@
 
 #include <core/Hash.hpp>
 
+#include <cstring>
 #include <sstream>
 
 #include <boost/crc.hpp>
@@ -24,7 +25,116 @@
 
 namespace rstudio {
 namespace core {
-namespace hash {   
+namespace hash {
+
+namespace {
+
+inline uint64_t rotateLeft(uint64_t value, int bits)
+{
+   return (value << bits) | (value >> (64 - bits));
+}
+
+// final mixing step -- spreads the accumulated entropy across all bits
+// so that similar inputs don't produce clustered hash values
+inline uint64_t avalanche(uint64_t hash)
+{
+   hash ^= hash >> 33;
+   hash *= 14029467366897019727ULL;
+   hash ^= hash >> 29;
+   hash *= 1609587929392839161ULL;
+   hash ^= hash >> 32;
+   return hash;
+}
+
+// software implementation: xxHash-style mixing over 8-byte rounds
+uint64_t softwareHash64(const char* pData, std::size_t length)
+{
+   const uint64_t kPrime1 = 11400714785074694791ULL;
+   const uint64_t kPrime2 = 14029467366897019727ULL;
+
+   uint64_t hash = kPrime1 + length;
+   std::size_t remaining = length;
+   while (remaining >= 8)
+   {
+      uint64_t chunk;
+      ::memcpy(&chunk, pData, 8);
+      chunk *= kPrime2;
+      chunk = rotateLeft(chunk, 31);
+      chunk *= kPrime1;
+      hash ^= chunk;
+      hash = rotateLeft(hash, 27) * kPrime1 + kPrime2;
+      pData += 8;
+      remaining -= 8;
+   }
+   while (remaining > 0)
+   {
+      hash ^= static_cast<unsigned char>(*pData++) * kPrime1;
+      hash = rotateLeft(hash, 11) * kPrime2;
+      remaining--;
+   }
+
+   return avalanche(hash);
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+
+// hardware implementation: the SSE4.2 CRC32 instruction over two
+// interleaved lanes (the instruction has multi-cycle latency, so two
+// independent chains roughly double throughput), combined into a 64-bit
+// result. compiled with the sse4.2 target attribute and only invoked
+// after a runtime cpu check
+__attribute__((target("sse4.2")))
+uint64_t hardwareHash64(const char* pData, std::size_t length)
+{
+   uint64_t crcA = 0xFFFFFFFFu;
+   uint64_t crcB = length;
+   std::size_t remaining = length;
+   while (remaining >= 16)
+   {
+      uint64_t chunkA, chunkB;
+      ::memcpy(&chunkA, pData, 8);
+      ::memcpy(&chunkB, pData + 8, 8);
+      crcA = __builtin_ia32_crc32di(crcA, chunkA);
+      crcB = __builtin_ia32_crc32di(crcB, chunkB);
+      pData += 16;
+      remaining -= 16;
+   }
+   while (remaining >= 8)
+   {
+      uint64_t chunk;
+      ::memcpy(&chunk, pData, 8);
+      crcA = __builtin_ia32_crc32di(crcA, chunk);
+      pData += 8;
+      remaining -= 8;
+   }
+   while (remaining > 0)
+   {
+      crcA = __builtin_ia32_crc32qi(static_cast<unsigned int>(crcA),
+                                    static_cast<unsigned char>(*pData++));
+      remaining--;
+   }
+
+   return avalanche((crcB << 32) | (crcA & 0xFFFFFFFFu));
+}
+
+bool hardwareHashAvailable()
+{
+   static const bool available = __builtin_cpu_supports("sse4.2");
+   return available;
+}
+
+#endif
+
+uint64_t fastHash64(const std::string& content)
+{
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+   if (hardwareHashAvailable())
+      return hardwareHash64(content.data(), content.length());
+#endif
+   return softwareHash64(content.data(), content.length());
+}
+
+} // anonymous namespace
 
 std::string crc32Hash(const std::string& content)
 {
@@ -44,7 +154,20 @@ std::string crc32HexHash(const std::string& content)
    output << std::uppercase << std::hex << result.checksum();
    return output.str();
 }
-   
+
+std::string fastHash(const std::string& content)
+{
+   return safe_convert::numberToString(fastHash64(content));
+}
+
+std::string fastHexHash(const std::string& content)
+{
+   std::ostringstream output;
+   output << std::uppercase << std::hex << fastHash64(content);
+   return output.str();
+}
+
+
 } // namespace hash
 } // namespace core 
 } // namespace rstudio
@@ -0,0 +1,55 @@
+/*
+ * HashTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+
+#include <core/Hash.hpp>
+
+namespace rstudio {
+namespace core {
+namespace hash {
+
+context("Fast hashing")
+{
+   test_that("Hashes are deterministic")
+   {
+      std::string content(100000, 'x');
+      content += "variation";
+      expect_true(fastHash(content) == fastHash(content));
+      expect_true(fastHexHash(content) == fastHexHash(content));
+   }
+
+   test_that("Hashes are sensitive to content changes")
+   {
+      std::string content(100000, 'x');
+      std::string modified(content);
+      modified[50000] = 'y';
+      expect_true(fastHash(content) != fastHash(modified));
+
+      // appending a byte changes the hash (length is mixed in)
+      expect_true(fastHash(content) != fastHash(content + 'x'));
+   }
+
+   test_that("Short and empty inputs hash without error")
+   {
+      expect_true(!fastHash("").empty());
+      expect_true(fastHash("a") != fastHash("b"));
+      expect_true(fastHash("abcdefg") != fastHash("abcdefgh"));
+   }
+}
+
+} // namespace hash
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,110 @@
+/*
+ * JsonBenchmarks.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <benchmark/Benchmark.hpp>
+
+#include <string>
+
+#include <core/SafeConvert.hpp>
+#include <core/json/Json.hpp>
+
+namespace rstudio {
+namespace core {
+namespace benchmarks {
+namespace {
+
+// a large json-rpc body shaped like the save_document / source index
+// traffic the session actually sees: an envelope holding an array of
+// objects mixing strings, numbers, booleans and nested arrays
+const int kRecordCount = 2000;
+
+json::Object makeRpcBody()
+{
+   json::Array recordsJson;
+   for (int i = 0; i < kRecordCount; i++)
+   {
+      json::Object recordJson;
+      recordJson["id"] = "record-" + safe_convert::numberToString(i);
+      recordJson["path"] = "~/projects/analysis/R/model-" +
+                           safe_convert::numberToString(i) + ".R";
+      recordJson["row"] = i;
+      recordJson["column"] = (i * 7) % 80;
+      recordJson["dirty"] = (i % 3) == 0;
+      recordJson["contents"] = std::string(256, 'x') + "\"quoted\"\n";
+
+      json::Array tagsJson;
+      tagsJson.push_back(std::string("function"));
+      tagsJson.push_back(std::string("exported"));
+      recordJson["tags"] = tagsJson;
+
+      recordsJson.push_back(recordJson);
+   }
+
+   json::Object bodyJson;
+   bodyJson["method"] = std::string("save_document");
+   json::Array paramsJson;
+   paramsJson.push_back(recordsJson);
+   bodyJson["params"] = paramsJson;
+   return bodyJson;
+}
+
+const std::string& rpcBodyFixture()
+{
+   static std::string s_body = json::write(makeRpcBody());
+   return s_body;
+}
+
+} // anonymous namespace
+
+BENCHMARK(benchmarkJsonParse)
+{
+   const std::string& body = rpcBodyFixture();
+   state.setBytesPerIteration(body.size());
+
+   while (state.keepRunning())
+   {
+      json::Value value;
+      bool ok = json::parse(body, &value);
+      benchmark::doNotOptimize(ok);
+   }
+}
+
+BENCHMARK(benchmarkJsonWrite)
+{
+   json::Object bodyJson = makeRpcBody();
+   state.setBytesPerIteration(rpcBodyFixture().size());
+
+   while (state.keepRunning())
+   {
+      std::string output = json::write(bodyJson);
+      benchmark::doNotOptimize(output);
+   }
+}
+
+BENCHMARK(benchmarkJsonWriteFormatted)
+{
+   json::Object bodyJson = makeRpcBody();
+   state.setBytesPerIteration(rpcBodyFixture().size());
+
+   while (state.keepRunning())
+   {
+      std::string output = json::writeFormatted(bodyJson);
+      benchmark::doNotOptimize(output);
+   }
+}
+
+} // namespace benchmarks
+} // namespace core
+} // namespace rstudio
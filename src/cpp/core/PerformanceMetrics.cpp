@@ -0,0 +1,158 @@
+/*
+ * PerformanceMetrics.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/PerformanceMetrics.hpp>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+#include <boost/cstdint.hpp>
+
+#include <core/Thread.hpp>
+
+namespace rstudio {
+namespace core {
+namespace performance {
+
+namespace {
+
+// bucket upper bounds are spaced by a factor of sqrt(2), i.e. two
+// buckets per power of two, starting at one microsecond. 48 buckets
+// cover values up to ~16 seconds; everything beyond lands in the
+// +Inf bucket
+const int kBucketCount = 48;
+
+struct HistogramData
+{
+   HistogramData() : sum(0), count(0)
+   {
+      std::fill(buckets, buckets + kBucketCount + 1,
+                static_cast<boost::uint64_t>(0));
+   }
+
+   double sum;                               // total microseconds
+   boost::uint64_t count;
+   boost::uint64_t buckets[kBucketCount+1];  // final bucket is +Inf
+};
+
+boost::mutex s_metricsMutex;
+std::map<std::string, HistogramData> s_histograms;
+std::map<std::string, boost::uint64_t> s_counters;
+
+// bucket upper bounds in microseconds (callers hold s_metricsMutex)
+const double* bucketBounds()
+{
+   static double s_bounds[kBucketCount];
+   static bool s_initialized = false;
+   if (!s_initialized)
+   {
+      double bound = 1.0;
+      for (int i = 0; i < kBucketCount; i++)
+      {
+         s_bounds[i] = bound;
+         bound *= 1.4142135623730951;
+      }
+      s_initialized = true;
+   }
+   return s_bounds;
+}
+
+} // anonymous namespace
+
+void recordDuration(const std::string& name,
+                    const boost::posix_time::time_duration& duration)
+{
+   double microseconds = static_cast<double>(duration.total_microseconds());
+   if (microseconds < 0)
+      microseconds = 0;
+
+   LOCK_MUTEX(s_metricsMutex)
+   {
+      const double* bounds = bucketBounds();
+
+      // first bucket whose upper bound contains the value (if none do
+      // then the index lands on the trailing +Inf bucket)
+      int index = static_cast<int>(
+            std::lower_bound(bounds, bounds + kBucketCount, microseconds) -
+            bounds);
+
+      HistogramData& data = s_histograms[name];
+      data.buckets[index]++;
+      data.sum += microseconds;
+      data.count++;
+   }
+   END_LOCK_MUTEX
+}
+
+void incrementCounter(const std::string& name)
+{
+   incrementCounterBy(name, 1);
+}
+
+void incrementCounterBy(const std::string& name, boost::uint64_t value)
+{
+   LOCK_MUTEX(s_metricsMutex)
+   {
+      s_counters[name] += value;
+   }
+   END_LOCK_MUTEX
+}
+
+std::string metricsAsText()
+{
+   std::ostringstream ostr;
+
+   LOCK_MUTEX(s_metricsMutex)
+   {
+      const double* bounds = bucketBounds();
+
+      for (std::map<std::string, HistogramData>::const_iterator
+           it = s_histograms.begin(); it != s_histograms.end(); ++it)
+      {
+         const std::string& name = it->first;
+         const HistogramData& data = it->second;
+
+         // buckets are cumulative in the exposition format, with bounds
+         // expressed in seconds
+         ostr << "# TYPE " << name << " histogram\n";
+         boost::uint64_t cumulative = 0;
+         for (int i = 0; i < kBucketCount; i++)
+         {
+            cumulative += data.buckets[i];
+            ostr << name << "_bucket{le=\"" << (bounds[i] / 1e6) << "\"} "
+                 << cumulative << "\n";
+         }
+         cumulative += data.buckets[kBucketCount];
+         ostr << name << "_bucket{le=\"+Inf\"} " << cumulative << "\n";
+         ostr << name << "_sum " << (data.sum / 1e6) << "\n";
+         ostr << name << "_count " << data.count << "\n";
+      }
+
+      for (std::map<std::string, boost::uint64_t>::const_iterator
+           it = s_counters.begin(); it != s_counters.end(); ++it)
+      {
+         ostr << "# TYPE " << it->first << " counter\n";
+         ostr << it->first << " " << it->second << "\n";
+      }
+   }
+   END_LOCK_MUTEX
+
+   return ostr.str();
+}
+
+} // namespace performance
+} // namespace core
+} // namespace rstudio
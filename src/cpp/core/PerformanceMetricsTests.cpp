@@ -0,0 +1,55 @@
+/*
+ * PerformanceMetricsTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+
+#include <core/PerformanceMetrics.hpp>
+
+namespace rstudio {
+namespace core {
+namespace performance {
+
+context("Performance Metrics")
+{
+   test_that("Recorded durations appear in the text exposition")
+   {
+      recordDuration("test_metric_seconds",
+                     boost::posix_time::milliseconds(5));
+      recordDuration("test_metric_seconds",
+                     boost::posix_time::milliseconds(50));
+
+      std::string metrics = metricsAsText();
+      expect_true(metrics.find("# TYPE test_metric_seconds histogram") !=
+                  std::string::npos);
+      expect_true(metrics.find("test_metric_seconds_count 2") !=
+                  std::string::npos);
+      expect_true(metrics.find("test_metric_seconds_bucket{le=\"+Inf\"} 2") !=
+                  std::string::npos);
+   }
+
+   test_that("Values beyond the largest bucket land in the +Inf bucket")
+   {
+      recordDuration("test_overflow_seconds",
+                     boost::posix_time::minutes(5));
+
+      std::string metrics = metricsAsText();
+      expect_true(metrics.find("test_overflow_seconds_bucket{le=\"+Inf\"} 1") !=
+                  std::string::npos);
+   }
+}
+
+} // namespace performance
+} // namespace core
+} // namespace rstudio
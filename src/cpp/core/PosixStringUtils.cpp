@@ -40,6 +40,12 @@ namespace string_utils {
 
 std::string wideToUtf8(const std::wstring& value)
 {
+   // fast path: ASCII requires no transcoding (and dominates in
+   // practice -- these conversions are on the path of every tokenizer
+   // pass and console write)
+   if (isAsciiOnly(value))
+      return std::string(value.begin(), value.end());
+
    try
    {
       boost::program_options::detail::utf8_codecvt_facet utf8_facet;
@@ -55,6 +61,10 @@ std::string wideToUtf8(const std::wstring& value)
 
 std::wstring utf8ToWide(const std::string& value, const std::string& context)
 {
+   // fast path: ASCII requires no transcoding
+   if (isAsciiOnly(value))
+      return std::wstring(value.begin(), value.end());
+
    try
    {
       boost::program_options::detail::utf8_codecvt_facet utf8_facet;
@@ -15,11 +15,15 @@
 
 #include <core/RegexUtils.hpp>
 
+#include <cctype>
+#include <cstring>
 #include <vector>
 #include <sstream>
+#include <algorithm>
 
 #include <boost/regex.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
 #include <boost/iostreams/copy.hpp>
 #include <boost/iostreams/concepts.hpp>
@@ -31,6 +35,16 @@ namespace rstudio {
 namespace core {
 namespace regex_utils {
 
+namespace {
+
+bool charEqualsIgnoreCase(char lhs, char rhs)
+{
+   return ::tolower(static_cast<unsigned char>(lhs)) ==
+          ::tolower(static_cast<unsigned char>(rhs));
+}
+
+} // anonymous namespace
+
 boost::regex wildcardPatternToRegex(const std::string& pattern)
 {
    // split into componenents
@@ -76,6 +90,231 @@ bool textMatches(const std::string& text,
                        flags);
 }
 
+std::string requiredLiteral(const std::string& pattern)
+{
+   std::string best;
+   std::string current;
+
+   std::size_t i = 0;
+   while (i < pattern.size())
+   {
+      char ch = pattern[i];
+
+      // alternation: nothing is required (grouped expressions are
+      // skipped below so any '|' seen here is top level)
+      if (ch == '|')
+         return std::string();
+
+      // quantifiers make the preceding element optional or repeatable;
+      // conservatively drop the last collected character (except for
+      // '+', which requires at least one occurrence)
+      if (ch == '?' || ch == '*' || ch == '+' || ch == '{')
+      {
+         if (!current.empty() && ch != '+')
+            current.erase(current.size() - 1);
+         if (current.size() > best.size())
+            best = current;
+         current.clear();
+
+         // skip interval expressions (e.g. "{2,3}") entirely
+         if (ch == '{')
+         {
+            std::size_t close = pattern.find('}', i);
+            if (close == std::string::npos)
+               break;
+            i = close + 1;
+            continue;
+         }
+
+         i++;
+         continue;
+      }
+
+      // escapes: which characters are special depends on the regex
+      // flavor (e.g. "\(" groups in grep syntax but matches a literal
+      // paren in extended syntax) so treat every escape as opaque
+      if (ch == '\\')
+      {
+         if (current.size() > best.size())
+            best = current;
+         current.clear();
+         i += 2;
+         continue;
+      }
+
+      // grouped expressions: their contents may be optional or
+      // alternated so skip them entirely (under-extraction is safe,
+      // it just filters less)
+      if (ch == '(')
+      {
+         if (current.size() > best.size())
+            best = current;
+         current.clear();
+
+         int depth = 1;
+         i++;
+         while ((i < pattern.size()) && (depth > 0))
+         {
+            if (pattern[i] == '\\')
+               i++;
+            else if (pattern[i] == '(')
+               depth++;
+            else if (pattern[i] == ')')
+               depth--;
+            i++;
+         }
+         continue;
+      }
+
+      // bracket expressions match a set of characters; skip them
+      if (ch == '[')
+      {
+         if (current.size() > best.size())
+            best = current;
+         current.clear();
+
+         i++;
+         if ((i < pattern.size()) && (pattern[i] == '^'))
+            i++;
+         if ((i < pattern.size()) && (pattern[i] == ']'))
+            i++;
+         std::size_t close = pattern.find(']', i);
+         if (close == std::string::npos)
+            break;
+         i = close + 1;
+         continue;
+      }
+
+      // remaining metacharacters just end the current run
+      if (ch == '.' || ch == '^' || ch == '$' ||
+          ch == ')' || ch == '}' || ch == ']')
+      {
+         if (current.size() > best.size())
+            best = current;
+         current.clear();
+         i++;
+         continue;
+      }
+
+      current.push_back(ch);
+      i++;
+   }
+
+   if (current.size() > best.size())
+      best = current;
+   return best;
+}
+
+bool searchLines(const char* pBegin,
+                 const char* pEnd,
+                 const boost::regex& pattern,
+                 const std::string& literal,
+                 bool ignoreCase,
+                 int timeBudgetMs,
+                 const LineMatchHandler& onMatch)
+{
+   using namespace boost::posix_time;
+
+   // cheap literal scan rejects most input before the regex ever runs
+   if (!literal.empty())
+   {
+      bool found;
+      if (ignoreCase)
+      {
+         found = std::search(pBegin, pEnd,
+                             literal.begin(), literal.end(),
+                             charEqualsIgnoreCase) != pEnd;
+      }
+      else
+      {
+         found = std::search(pBegin, pEnd,
+                             literal.begin(), literal.end()) != pEnd;
+      }
+      if (!found)
+         return true;
+   }
+
+   ptime deadline = not_a_date_time;
+   if (timeBudgetMs > 0)
+      deadline = microsec_clock::universal_time() + milliseconds(timeBudgetMs);
+
+   int lineNumber = 0;
+   std::size_t sinceDeadlineCheck = 0;
+   const char* pLine = pBegin;
+   while (pLine < pEnd)
+   {
+      const char* pNewline = static_cast<const char*>(
+                  std::memchr(pLine, '\n', pEnd - pLine));
+      const char* pLineEnd = (pNewline != NULL) ? pNewline : pEnd;
+      lineNumber++;
+
+      // note that search() traps exceptions, so a pathological pattern
+      // which exceeds the regex engine's internal complexity limit on
+      // some line is reported and treated as a non-match rather than
+      // propagating (or backtracking unboundedly)
+      boost::cmatch match;
+      if (search(pLine, pLineEnd, match, pattern))
+      {
+         LineMatch result;
+         result.lineNumber = lineNumber;
+         result.line.assign(pLine, pLineEnd);
+
+         // collect every match on the line
+         const char* pPos = pLine;
+         boost::match_flag_type flags = boost::match_default;
+         for (;;)
+         {
+            std::size_t on = (pPos - pLine) + match.position();
+            result.matchOn.push_back(on);
+            result.matchOff.push_back(on + match.length());
+
+            // guard against zero-length matches
+            std::size_t advance = std::max<std::size_t>(
+                                       match.position() + match.length(), 1);
+            pPos += advance;
+            flags = boost::match_not_bol | boost::match_prev_avail;
+            if (pPos >= pLineEnd)
+               break;
+            if (!search(pPos, pLineEnd, match, pattern, flags))
+               break;
+         }
+
+         if (!onMatch(result))
+            return false;
+      }
+
+      // enforce the time budget (checked every ~64kb so the clock reads
+      // don't dominate on small lines)
+      sinceDeadlineCheck += (pLineEnd - pLine) + 1;
+      if (!deadline.is_not_a_date_time() && (sinceDeadlineCheck >= 65536))
+      {
+         sinceDeadlineCheck = 0;
+         if (microsec_clock::universal_time() > deadline)
+            return false;
+      }
+
+      pLine = pLineEnd + 1;
+   }
+
+   return true;
+}
+
+bool searchLines(const std::string& text,
+                 const boost::regex& pattern,
+                 const std::string& literal,
+                 bool ignoreCase,
+                 int timeBudgetMs,
+                 const LineMatchHandler& onMatch)
+{
+   return searchLines(text.data(),
+                      text.data() + text.length(),
+                      pattern,
+                      literal,
+                      ignoreCase,
+                      timeBudgetMs,
+                      onMatch);
+}
+
 Error filterString(const std::string& input,
                    const std::vector<boost::iostreams::regex_filter>& filters,
                    std::string* pOutput)
@@ -0,0 +1,137 @@
+/*
+ * RegexUtilsTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+
+#include <boost/bind.hpp>
+
+#include <core/RegexUtils.hpp>
+
+namespace rstudio {
+namespace core {
+namespace regex_utils {
+
+namespace {
+
+bool collectMatch(std::vector<LineMatch>* pMatches, const LineMatch& match)
+{
+   pMatches->push_back(match);
+   return true;
+}
+
+bool collectFirstMatch(std::vector<LineMatch>* pMatches,
+                       const LineMatch& match)
+{
+   pMatches->push_back(match);
+   return false;
+}
+
+} // anonymous namespace
+
+context("requiredLiteral")
+{
+   test_that("literal patterns are returned whole")
+   {
+      expect_true(requiredLiteral("foobar") == "foobar");
+      expect_true(requiredLiteral("^needle$") == "needle");
+   }
+
+   test_that("quantifiers drop only the affected character")
+   {
+      expect_true(requiredLiteral("foo.*bar") == "foo");
+      expect_true(requiredLiteral("abc+") == "abc");
+      expect_true(requiredLiteral("abc?") == "ab");
+      expect_true(requiredLiteral("abc*def") == "def");
+      expect_true(requiredLiteral("x{2,3}y") == "y");
+   }
+
+   test_that("grouped and bracketed expressions are skipped")
+   {
+      expect_true(requiredLiteral("[abc]xyz") == "xyz");
+      expect_true(requiredLiteral("(foo)?bar") == "bar");
+      expect_true(requiredLiteral("\\w+ident") == "ident");
+   }
+
+   test_that("alternation yields no required literal")
+   {
+      expect_true(requiredLiteral("foo|bar").empty());
+   }
+}
+
+context("searchLines")
+{
+   test_that("matching lines stream back with offsets")
+   {
+      std::string text("apple\nbanana split\nbandana\n");
+      boost::regex pattern("ban\\w+");
+      std::string literal = requiredLiteral("ban\\w+");
+      expect_true(literal == "ban");
+
+      std::vector<LineMatch> matches;
+      bool completed = searchLines(text,
+                                   pattern,
+                                   literal,
+                                   false,
+                                   0,
+                                   boost::bind(collectMatch, &matches, _1));
+
+      expect_true(completed);
+      expect_true(matches.size() == 2);
+      expect_true(matches[0].lineNumber == 2);
+      expect_true(matches[0].line == "banana split");
+      expect_true(matches[0].matchOn[0] == 0);
+      expect_true(matches[0].matchOff[0] == 6);
+      expect_true(matches[1].lineNumber == 3);
+   }
+
+   test_that("the handler can stop the search early")
+   {
+      std::string text("banana\nbandana\n");
+      boost::regex pattern("ban\\w+");
+
+      std::vector<LineMatch> matches;
+      bool completed = searchLines(text,
+                                   pattern,
+                                   "ban",
+                                   false,
+                                   0,
+                                   boost::bind(collectFirstMatch,
+                                               &matches, _1));
+
+      expect_false(completed);
+      expect_true(matches.size() == 1);
+   }
+
+   test_that("an absent literal rejects the text without matching")
+   {
+      std::string text("apple\nbanana\n");
+      boost::regex pattern("ban\\w+");
+
+      std::vector<LineMatch> matches;
+      bool completed = searchLines(text,
+                                   pattern,
+                                   "zebra",
+                                   false,
+                                   0,
+                                   boost::bind(collectMatch, &matches, _1));
+
+      expect_true(completed);
+      expect_true(matches.empty());
+   }
+}
+
+} // namespace regex_utils
+} // namespace core
+} // namespace rstudio
@@ -15,28 +15,56 @@
 
 #include <core/Settings.hpp>
 
+#include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
 
 #include <core/Log.hpp>
 #include <core/FilePath.hpp>
 #include <core/SafeConvert.hpp>
 #include <core/FileSerializer.hpp>
+#include <core/Thread.hpp>
 
 namespace rstudio {
 namespace core {
 
 Settings::Settings()
    : updatePending_(false),
-     isDirty_(false)
+     isDirty_(false),
+     delayedWrites_(false),
+     debounceMillis_(0),
+     stopRequested_(false)
 {
 }
 
 Settings::~Settings()
 {
+   try
+   {
+      // stop the flush thread (if any) and write pending changes
+      if (thread_.joinable())
+      {
+         {
+            boost::unique_lock<boost::mutex> lock(mutex_);
+            stopRequested_ = true;
+         }
+         condition_.notify_all();
+         thread_.join();
+      }
+
+      if (delayedWrites_ && isDirty_)
+         writeSettingsFile(settingsMap_);
+   }
+   catch(...)
+   {
+   }
 }
 
-Error Settings::initialize(const FilePath& filePath) 
+Error Settings::initialize(const FilePath& filePath)
 {
+   // guard against a concurrent delayed-write snapshot (settings can be
+   // re-initialized when the underlying file changes on disk)
+   boost::unique_lock<boost::mutex> lock(mutex_);
+
    settingsFile_ = filePath ;
    settingsMap_.clear() ;
    Error error = core::readStringMapFromFile(settingsFile_, &settingsMap_) ;
@@ -56,11 +84,27 @@ Error Settings::initialize(const FilePath& filePath)
 
 void Settings::set(const std::string& name, const std::string& value)
 {
+   // delayed mode: record the change and wake the flush thread (which
+   // coalesces bursts of changes into a single debounced write)
+   if (delayedWrites_)
+   {
+      {
+         boost::unique_lock<boost::mutex> lock(mutex_);
+         if (value == settingsMap_[name])
+            return;
+         settingsMap_[name] = value;
+         isDirty_ = true;
+         lastChangeTime_ = boost::get_system_time();
+      }
+      condition_.notify_all();
+      return;
+   }
+
    if (value != settingsMap_[name])
    {
       settingsMap_[name] = value ;
       isDirty_ = true;
-      
+
       if (!updatePending_)
          writeSettings() ;
    }
@@ -144,18 +188,98 @@ void Settings::beginUpdate()
 void Settings::endUpdate()
 {
    updatePending_ = false ;
+
+   // in delayed mode changes are already pending with the flush thread
+   if (delayedWrites_)
+      return;
+
    if (isDirty_)
       writeSettings();
 }
 
-void Settings::writeSettings() 
+void Settings::enableDelayedWrites(int debounceMillis)
+{
+   // no-op if already enabled
+   if (delayedWrites_)
+      return;
+
+   debounceMillis_ = debounceMillis;
+   core::thread::safeLaunchThread(boost::bind(&Settings::flushThread, this),
+                                  &thread_);
+   delayedWrites_ = thread_.joinable();
+}
+
+void Settings::flush()
+{
+   if (!delayedWrites_)
+      return;
+
+   // snapshot pending changes then write outside the lock
+   std::map<std::string,std::string> settingsMap;
+   {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      if (!isDirty_)
+         return;
+      settingsMap = settingsMap_;
+      isDirty_ = false;
+   }
+   writeSettingsFile(settingsMap);
+}
+
+void Settings::writeSettings()
 {
    isDirty_ = false;
-   Error error = core::writeStringMapToFile(settingsFile_, settingsMap_) ; 
+   writeSettingsFile(settingsMap_);
+}
+
+void Settings::writeSettingsFile(
+               const std::map<std::string,std::string>& settingsMap) const
+{
+   // write to a temp file alongside the settings file then rename it
+   // into place so a crash mid-write can't leave a truncated file
+   FilePath tempFile = settingsFile_.parent().childPath(
+                                       settingsFile_.filename() + ".new");
+   Error error = core::writeStringMapToFile(tempFile, settingsMap);
+   if (!error)
+      error = tempFile.move(settingsFile_);
    if (error)
      LOG_ERROR(error);
 }
 
+void Settings::flushThread()
+{
+   try
+   {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      while (!stopRequested_)
+      {
+         // wait for a change
+         if (!isDirty_)
+         {
+            condition_.wait(lock);
+            continue;
+         }
+
+         // debounce: hold off while changes are still arriving
+         boost::system_time deadline = lastChangeTime_ +
+                        boost::posix_time::milliseconds(debounceMillis_);
+         if (boost::get_system_time() < deadline)
+         {
+            condition_.timed_wait(lock, deadline);
+            continue;
+         }
+
+         // snapshot the settings and write them outside the lock
+         std::map<std::string,std::string> settingsMap = settingsMap_;
+         isDirty_ = false;
+         lock.unlock();
+         writeSettingsFile(settingsMap);
+         lock.lock();
+      }
+   }
+   CATCH_UNEXPECTED_EXCEPTION
+}
+
 
 }
 }
@@ -13,7 +13,13 @@
  *
  */
 
+#include <map>
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
 #include <core/Error.hpp>
+#include <core/Thread.hpp>
 #include <core/json/Json.hpp>
 #include <core/json/JsonRpc.hpp>
 #include <core/http/LocalStreamBlockingClient.hpp>
@@ -40,10 +46,10 @@ void constructRequest(const std::string& endpoint,
    std::ostringstream oss;
    core::json::write(payload, oss);
 
-   // form the request
+   // form the request (connection semantics are decided by the client:
+   // keep-alive when a persistent connection is in use, close otherwise)
    pRequest->setMethod("POST");
    pRequest->setUri(endpoint);
-   pRequest->setHeader("Connection", "close");
    pRequest->setBody(oss.str());
 }
 
@@ -77,6 +83,118 @@ Error handleResponse(const std::string& endpoint,
    return Success();
 }
 
+// persistent keep-alive connection per rpc socket path -- control rpcs
+// are frequent and small, so a single long-lived connection per
+// destination is kept and reused serially instead of paying
+// connect/teardown per call. when the cached connection has gone stale
+// (or the peer closes per-response) calls fall back to a fresh
+// connection, so the worst case is the old per-call behavior
+struct PersistentRpcConnection
+{
+   boost::shared_ptr<boost::asio::io_service> pIoService;
+   boost::shared_ptr<http::LocalStreamAsyncClient> pClient;
+};
+
+boost::mutex s_rpcConnectionsMutex;
+std::map<std::string, PersistentRpcConnection> s_rpcConnections;
+
+PersistentRpcConnection claimRpcConnection(const FilePath& socketPath)
+{
+   PersistentRpcConnection connection;
+   LOCK_MUTEX(s_rpcConnectionsMutex)
+   {
+      std::map<std::string, PersistentRpcConnection>::iterator it =
+                           s_rpcConnections.find(socketPath.absolutePath());
+      if (it != s_rpcConnections.end())
+      {
+         connection = it->second;
+         s_rpcConnections.erase(it);
+      }
+   }
+   END_LOCK_MUTEX
+
+   // health-check before handing it out
+   if (connection.pClient && !connection.pClient->isConnected())
+   {
+      connection.pClient->close();
+      connection = PersistentRpcConnection();
+   }
+
+   return connection;
+}
+
+void parkRpcConnection(const FilePath& socketPath,
+                       const PersistentRpcConnection& connection)
+{
+   connection.pClient->disableHandlers();
+
+   LOCK_MUTEX(s_rpcConnectionsMutex)
+   {
+      // keep at most one parked connection per destination
+      if (s_rpcConnections.count(socketPath.absolutePath()) == 0)
+      {
+         s_rpcConnections[socketPath.absolutePath()] = connection;
+         return;
+      }
+   }
+   END_LOCK_MUTEX
+
+   connection.pClient->close();
+}
+
+void assignResponse(const http::Response& response,
+                    http::Response* pTargetResponse)
+{
+   pTargetResponse->assign(response);
+}
+
+void assignError(const Error& error, Error* pTargetError)
+{
+   *pTargetError = error;
+}
+
+void noteConnectionReusable(bool* pReusable)
+{
+   *pReusable = true;
+}
+
+Error executeRpcRequest(PersistentRpcConnection* pConnection,
+                        const FilePath& socketPath,
+                        const http::Request& request,
+                        http::Response* pResponse,
+                        bool* pReusable)
+{
+   if (!pConnection->pClient)
+   {
+      pConnection->pIoService.reset(new boost::asio::io_service());
+      pConnection->pClient.reset(new http::LocalStreamAsyncClient(
+                                 *pConnection->pIoService, socketPath, true));
+   }
+   else
+   {
+      // the io service completed a previous run; ready it for another
+      pConnection->pIoService->reset();
+   }
+
+   *pReusable = false;
+   pConnection->pClient->enableConnectionReuse(
+                        boost::bind(noteConnectionReusable, pReusable));
+
+   pConnection->pClient->request().assign(request);
+
+   Error requestError;
+   pConnection->pClient->execute(
+                        boost::bind(assignResponse, _1, pResponse),
+                        boost::bind(assignError, _1, &requestError));
+
+   boost::system::error_code ec;
+   pConnection->pIoService->run(ec);
+   if (ec)
+      return Error(ec, ERROR_LOCATION);
+
+   return requestError;
+}
+
 Error sendRequest(const FilePath& socketPath,
                   const std::string& endpoint,
                   const http::Request& request,
@@ -84,10 +202,39 @@ Error sendRequest(const FilePath& socketPath,
 {
    core::http::Response response;
 
-   Error error = core::http::sendRequest(socketPath, request, &response);
+   // reuse the persistent connection for this destination if we have one
+   PersistentRpcConnection connection = claimRpcConnection(socketPath);
+   bool reused = connection.pClient.get() != NULL;
+   bool reusable = false;
+
+   Error error = executeRpcRequest(&connection,
+                                   socketPath,
+                                   request,
+                                   &response,
+                                   &reusable);
+
+   // a reused connection can fail if the peer closed it underneath us;
+   // retry exactly once on a fresh connection before giving up
+   if (error && reused)
+   {
+      connection.pClient->close();
+      connection = PersistentRpcConnection();
+      reusable = false;
+      error = executeRpcRequest(&connection,
+                                socketPath,
+                                request,
+                                &response,
+                                &reusable);
+   }
+
    if (error)
       return error;
 
+   if (reusable)
+      parkRpcConnection(socketPath, connection);
+   else if (connection.pClient)
+      connection.pClient->close();
+
    return handleResponse(endpoint, response, pResult);
 }
 
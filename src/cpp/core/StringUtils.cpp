@@ -16,9 +16,12 @@
 #include <core/StringUtils.hpp>
 
 #include <algorithm>
+#include <cstring>
 #include <map>
 #include <ostream>
 
+#include <boost/cstdint.hpp>
+
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/algorithm/string/classification.hpp>
@@ -239,12 +242,51 @@ bool detectLineEndings(const FilePath& filePath, LineEnding* pType)
    return false;
 }
 
+bool isAsciiOnly(const std::string& value)
+{
+   // scan a word at a time so the common all-ASCII case (source code,
+   // console output) is limited by memory bandwidth rather than
+   // per-byte branching
+   const char* pData = value.data();
+   std::size_t length = value.length();
+   std::size_t i = 0;
+   boost::uint64_t word = 0;
+   for ( ; (i + sizeof(word)) <= length; i += sizeof(word))
+   {
+      std::memcpy(&word, pData + i, sizeof(word));
+      if (word & 0x8080808080808080ULL)
+         return false;
+   }
+   for ( ; i < length; i++)
+   {
+      if (static_cast<unsigned char>(pData[i]) > 0x7F)
+         return false;
+   }
+   return true;
+}
+
+bool isAsciiOnly(const std::wstring& value)
+{
+   for (std::size_t i = 0; i < value.length(); i++)
+   {
+      // cast so that platforms with a signed wchar_t treat negative
+      // values as non-ASCII rather than comparing less than 0x7F
+      if (static_cast<boost::uint32_t>(value[i]) > 0x7F)
+         return false;
+   }
+   return true;
+}
+
 std::string utf8ToSystem(const std::string& str,
                          bool escapeInvalidChars)
 {
    if (str.empty())
       return std::string();
 
+   // ASCII is identical in UTF-8 and all system codepages
+   if (isAsciiOnly(str))
+      return str;
+
 #ifdef _WIN32
    std::vector<wchar_t> wide(str.length() + 1);
    int chars = ::MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, &wide[0], static_cast<int>(wide.size()));
@@ -282,6 +324,10 @@ std::string systemToUtf8(const std::string& str, int codepage)
    if (str.empty())
       return std::string();
 
+   // ASCII is identical in UTF-8 and all system codepages
+   if (isAsciiOnly(str))
+      return str;
+
 #ifdef _WIN32
    std::vector<wchar_t> wide(str.length() + 1);
    int chars = ::MultiByteToWideChar(codepage, 0, str.c_str(), static_cast<int>(str.length()),
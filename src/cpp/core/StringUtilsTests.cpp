@@ -148,6 +148,31 @@ context("Comment extraction")
    }
 }
 
+context("isAsciiOnly")
+{
+   test_that("ASCII detection handles word-sized scanning")
+   {
+      expect_true(isAsciiOnly(""));
+      expect_true(isAsciiOnly("abc"));
+      expect_true(isAsciiOnly("exactly8"));
+      expect_true(isAsciiOnly("a string longer than one word"));
+
+      // non-ASCII byte in the word-at-a-time portion and in the tail
+      expect_false(isAsciiOnly("caf\xC3\xA9 au lait, s'il vous plait"));
+      expect_false(isAsciiOnly("plain ascii then caf\xC3\xA9"));
+   }
+
+   test_that("ASCII round trips through wide conversions unchanged")
+   {
+      std::string ascii("the quick brown fox jumps over the lazy dog");
+      expect_true(wideToUtf8(utf8ToWide(ascii)) == ascii);
+
+      std::string utf8("caf\xC3\xA9");
+      expect_false(isAsciiOnly(utf8ToWide(utf8)));
+      expect_true(wideToUtf8(utf8ToWide(utf8)) == utf8);
+   }
+}
+
 } // end namespace string_utils
 } // end namespace core
 } // end namespace rstudio
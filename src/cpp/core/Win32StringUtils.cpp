@@ -29,6 +29,10 @@ std::string wideToUtf8(const std::wstring& value)
    if (value.size() == 0)
       return std::string();
 
+   // fast path: ASCII requires no transcoding
+   if (isAsciiOnly(value))
+      return std::string(value.begin(), value.end());
+
    const wchar_t * cstr = value.c_str();
    int chars = ::WideCharToMultiByte(CP_UTF8, 0,
                                      cstr, -1,
@@ -54,6 +58,10 @@ std::wstring utf8ToWide(const std::string& value,
    if (value.size() == 0)
       return std::wstring();
 
+   // fast path: ASCII requires no transcoding
+   if (isAsciiOnly(value))
+      return std::wstring(value.begin(), value.end());
+
    const char * cstr = value.c_str();
    int chars = ::MultiByteToWideChar(CP_UTF8, 0,
                                      cstr, -1,
@@ -0,0 +1,306 @@
+/*
+ * ZipWriter.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/ZipWriter.hpp>
+
+#include <ctime>
+#include <ostream>
+
+#include <boost/bind.hpp>
+#include <boost/crc.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/foreach.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <core/Error.hpp>
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+
+namespace rstudio {
+namespace core {
+namespace zip {
+
+namespace {
+
+// maximum size representable without zip64 extensions
+const uintmax_t kMaxZipSize = 0xFFFFFFFEu;
+
+// compression methods
+const boost::uint16_t kMethodStore = 0;
+const boost::uint16_t kMethodDeflate = 8;
+
+void writeUint16(std::ostream& os, boost::uint16_t value)
+{
+   char bytes[2] = { static_cast<char>(value & 0xFF),
+                     static_cast<char>((value >> 8) & 0xFF) };
+   os.write(bytes, 2);
+}
+
+void writeUint32(std::ostream& os, boost::uint32_t value)
+{
+   char bytes[4] = { static_cast<char>(value & 0xFF),
+                     static_cast<char>((value >> 8) & 0xFF),
+                     static_cast<char>((value >> 16) & 0xFF),
+                     static_cast<char>((value >> 24) & 0xFF) };
+   os.write(bytes, 4);
+}
+
+// convert a time to the MS-DOS date/time format used by zip
+void dosDateTime(std::time_t time,
+                 boost::uint16_t* pDate,
+                 boost::uint16_t* pTime)
+{
+   struct tm t;
+#ifdef _WIN32
+   ::localtime_s(&t, &time);
+#else
+   ::localtime_r(&time, &t);
+#endif
+
+   // the epoch of the MS-DOS format is 1980
+   int year = t.tm_year + 1900;
+   if (year < 1980)
+   {
+      *pDate = (1 << 5) | 1;
+      *pTime = 0;
+      return;
+   }
+
+   *pDate = static_cast<boost::uint16_t>(
+               ((year - 1980) << 9) | ((t.tm_mon + 1) << 5) | t.tm_mday);
+   *pTime = static_cast<boost::uint16_t>(
+               (t.tm_hour << 11) | (t.tm_min << 5) | (t.tm_sec / 2));
+}
+
+// what we need to remember about each entry in order to write the
+// central directory at the end of the archive
+struct ZipEntry
+{
+   ZipEntry()
+      : crc32(0), compressedSize(0), uncompressedSize(0),
+        method(kMethodStore), modDate(0), modTime(0), headerOffset(0)
+   {
+   }
+
+   // COPYING: via compiler (copyable members)
+
+   std::string name;
+   boost::uint32_t crc32;
+   boost::uint32_t compressedSize;
+   boost::uint32_t uncompressedSize;
+   boost::uint16_t method;
+   boost::uint16_t modDate;
+   boost::uint16_t modTime;
+   boost::uint32_t headerOffset;
+};
+
+Error tooLargeError(const std::string& name, const ErrorLocation& location)
+{
+   Error error = systemError(boost::system::errc::file_too_large, location);
+   error.addProperty("path", name);
+   return error;
+}
+
+// compress content with raw deflate (no zlib header, as zip requires)
+std::string deflate(const std::string& content)
+{
+   namespace io = boost::iostreams;
+
+   io::zlib_params params;
+   params.noheader = true;
+
+   std::string compressed;
+   io::filtering_ostream stream;
+   stream.push(io::zlib_compressor(params));
+   stream.push(io::back_inserter(compressed));
+   stream.write(content.data(), content.size());
+   stream.reset(); // flush and finalize
+
+   return compressed;
+}
+
+Error addEntry(const FilePath& filePath,
+               const std::string& name,
+               std::ostream& os,
+               std::vector<ZipEntry>* pEntries)
+{
+   ZipEntry entry;
+   entry.name = name;
+   dosDateTime(filePath.lastWriteTime(), &entry.modDate, &entry.modTime);
+
+   std::string data;
+   if (!filePath.isDirectory())
+   {
+      // read the file (exactly as it is on disk)
+      std::string contents;
+      Error error = readStringFromFile(filePath, &contents);
+      if (error)
+         return error;
+      if (contents.length() > kMaxZipSize)
+         return tooLargeError(name, ERROR_LOCATION);
+
+      // compute the crc of the uncompressed content
+      boost::crc_32_type crc;
+      crc.process_bytes(contents.data(), contents.length());
+      entry.crc32 = static_cast<boost::uint32_t>(crc.checksum());
+      entry.uncompressedSize =
+            static_cast<boost::uint32_t>(contents.length());
+
+      // deflate, but fall back to storing when that doesn't actually
+      // make the entry smaller (e.g. already-compressed content)
+      data = deflate(contents);
+      if (data.length() < contents.length())
+      {
+         entry.method = kMethodDeflate;
+      }
+      else
+      {
+         entry.method = kMethodStore;
+         data = contents;
+      }
+      entry.compressedSize = static_cast<boost::uint32_t>(data.length());
+   }
+
+   // note where this entry's header begins
+   std::ostream::pos_type offset = os.tellp();
+   if (offset < 0 || static_cast<uintmax_t>(offset) > kMaxZipSize)
+      return tooLargeError(name, ERROR_LOCATION);
+   entry.headerOffset = static_cast<boost::uint32_t>(offset);
+
+   // local file header
+   writeUint32(os, 0x04034b50);
+   writeUint16(os, 20);            // version needed (2.0, for deflate)
+   writeUint16(os, 0);             // flags
+   writeUint16(os, entry.method);
+   writeUint16(os, entry.modTime);
+   writeUint16(os, entry.modDate);
+   writeUint32(os, entry.crc32);
+   writeUint32(os, entry.compressedSize);
+   writeUint32(os, entry.uncompressedSize);
+   writeUint16(os, static_cast<boost::uint16_t>(entry.name.length()));
+   writeUint16(os, 0);             // extra field length
+   os.write(entry.name.data(), entry.name.length());
+
+   // entry data
+   os.write(data.data(), data.length());
+
+   pEntries->push_back(entry);
+   return Success();
+}
+
+bool collectChild(std::vector<FilePath>* pChildren, const FilePath& child)
+{
+   pChildren->push_back(child);
+   return true;
+}
+
+} // anonymous namespace
+
+Error writeArchive(const FilePath& parentPath,
+                   const std::vector<std::string>& files,
+                   std::ostream* pOstream)
+{
+   std::ostream& os = *pOstream;
+   std::vector<ZipEntry> entries;
+
+   BOOST_FOREACH(const std::string& file, files)
+   {
+      FilePath filePath = parentPath.complete(file);
+
+      if (filePath.isDirectory())
+      {
+         // emit the directory itself (so empty directories survive)...
+         Error error = addEntry(filePath, file + "/", os, &entries);
+         if (error)
+            return error;
+
+         // ...then everything beneath it
+         std::vector<FilePath> children;
+         error = filePath.childrenRecursive(
+                              boost::bind(collectChild, &children, _2));
+         if (error)
+            return error;
+
+         BOOST_FOREACH(const FilePath& child, children)
+         {
+            std::string name = child.relativePath(parentPath);
+            if (child.isDirectory())
+               name += "/";
+            error = addEntry(child, name, os, &entries);
+            if (error)
+               return error;
+         }
+      }
+      else
+      {
+         Error error = addEntry(filePath, file, os, &entries);
+         if (error)
+            return error;
+      }
+   }
+
+   // central directory
+   std::ostream::pos_type directoryStart = os.tellp();
+   BOOST_FOREACH(const ZipEntry& entry, entries)
+   {
+      writeUint32(os, 0x02014b50);
+      writeUint16(os, 20);         // version made by
+      writeUint16(os, 20);         // version needed
+      writeUint16(os, 0);          // flags
+      writeUint16(os, entry.method);
+      writeUint16(os, entry.modTime);
+      writeUint16(os, entry.modDate);
+      writeUint32(os, entry.crc32);
+      writeUint32(os, entry.compressedSize);
+      writeUint32(os, entry.uncompressedSize);
+      writeUint16(os, static_cast<boost::uint16_t>(entry.name.length()));
+      writeUint16(os, 0);          // extra field length
+      writeUint16(os, 0);          // comment length
+      writeUint16(os, 0);          // disk number
+      writeUint16(os, 0);          // internal attributes
+      writeUint32(os, 0);          // external attributes
+      writeUint32(os, entry.headerOffset);
+      os.write(entry.name.data(), entry.name.length());
+   }
+
+   // end of central directory
+   std::ostream::pos_type directoryEnd = os.tellp();
+   if (directoryEnd < 0 ||
+       static_cast<uintmax_t>(directoryEnd) > kMaxZipSize ||
+       entries.size() > 0xFFFF)
+   {
+      return tooLargeError("(archive)", ERROR_LOCATION);
+   }
+   writeUint32(os, 0x06054b50);
+   writeUint16(os, 0);             // this disk
+   writeUint16(os, 0);             // directory start disk
+   writeUint16(os, static_cast<boost::uint16_t>(entries.size()));
+   writeUint16(os, static_cast<boost::uint16_t>(entries.size()));
+   writeUint32(os, static_cast<boost::uint32_t>(
+                                 directoryEnd - directoryStart));
+   writeUint32(os, static_cast<boost::uint32_t>(directoryStart));
+   writeUint16(os, 0);             // comment length
+
+   if (os.fail())
+      return systemError(boost::system::errc::io_error, ERROR_LOCATION);
+
+   return Success();
+}
+
+} // namespace zip
+} // namespace core
+} // namespace rstudio
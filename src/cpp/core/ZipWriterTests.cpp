@@ -0,0 +1,89 @@
+/*
+ * ZipWriterTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <sstream>
+
+#include <tests/TestThat.hpp>
+
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/ZipWriter.hpp>
+
+namespace rstudio {
+namespace core {
+namespace zip {
+
+context("Zip writing")
+{
+   test_that("An archive of files has the expected structure")
+   {
+      // stage a couple of files (and a subdirectory) to archive
+      FilePath tempPath;
+      expect_true(!FilePath::tempFilePath(&tempPath));
+      expect_true(!tempPath.ensureDirectory());
+      expect_true(!writeStringToFile(tempPath.complete("one.txt"),
+                                     "hello, hello, hello"));
+      expect_true(!tempPath.complete("sub").ensureDirectory());
+      expect_true(!writeStringToFile(tempPath.complete("sub/two.txt"),
+                                     "world"));
+
+      std::vector<std::string> files;
+      files.push_back("one.txt");
+      files.push_back("sub");
+
+      std::ostringstream ostream;
+      Error error = writeArchive(tempPath, files, &ostream);
+      expect_true(!error);
+      std::string archive = ostream.str();
+
+      // local file header signature up front
+      expect_true(archive.substr(0, 4) == std::string("PK\x03\x04", 4));
+
+      // end of central directory record at the back (fixed size since
+      // we write no archive comment); 3 entries: one.txt, sub/ and
+      // sub/two.txt
+      expect_true(archive.length() > 22);
+      std::string eocd = archive.substr(archive.length() - 22);
+      expect_true(eocd.substr(0, 4) == std::string("PK\x05\x06", 4));
+      expect_true(eocd[10] == 3 && eocd[11] == 0);
+
+      // entry names all appear in the archive
+      expect_true(archive.find("one.txt") != std::string::npos);
+      expect_true(archive.find("sub/") != std::string::npos);
+      expect_true(archive.find("sub/two.txt") != std::string::npos);
+
+      expect_true(!tempPath.remove());
+   }
+
+   test_that("Archiving a missing file yields an error")
+   {
+      FilePath tempPath;
+      expect_true(!FilePath::tempFilePath(&tempPath));
+      expect_true(!tempPath.ensureDirectory());
+
+      std::vector<std::string> files;
+      files.push_back("no-such-file");
+
+      std::ostringstream ostream;
+      Error error = writeArchive(tempPath, files, &ostream);
+      expect_true(error != Success());
+
+      expect_true(!tempPath.remove());
+   }
+}
+
+} // namespace zip
+} // namespace core
+} // namespace rstudio
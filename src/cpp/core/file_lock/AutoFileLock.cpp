@@ -0,0 +1,139 @@
+/*
+ * AutoFileLock.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/FileLock.hpp>
+
+#include <map>
+
+#include <core/Error.hpp>
+#include <core/Log.hpp>
+#include <core/FilePath.hpp>
+#include <core/Thread.hpp>
+
+#ifndef _WIN32
+# include <core/system/PosixNfs.hpp>
+#endif
+
+namespace rstudio {
+namespace core {
+
+namespace {
+
+// caches the per-directory NFS determination so lock operations don't
+// pay a filesystem round trip after the first lock in a directory
+class FileSystemTypeCache : boost::noncopyable
+{
+public:
+   bool isNfs(const FilePath& directory)
+   {
+      bool result = false;
+      LOCK_MUTEX(mutex_)
+      {
+         std::map<std::string, bool>::const_iterator it =
+                                 cache_.find(directory.absolutePath());
+         if (it != cache_.end())
+            return it->second;
+
+         result = detectNfs(directory);
+         cache_[directory.absolutePath()] = result;
+      }
+      END_LOCK_MUTEX
+
+      return result;
+   }
+
+private:
+   static bool detectNfs(const FilePath& directory)
+   {
+#ifndef _WIN32
+      bool isNfs = false;
+      Error error = core::system::nfs::isNfs(directory, &isNfs);
+      if (error)
+      {
+         // if we can't interrogate the filesystem assume NFS (the
+         // link-based protocol is correct everywhere, just slower)
+         LOG_ERROR(error);
+         return true;
+      }
+      return isNfs;
+#else
+      return false;
+#endif
+   }
+
+   boost::mutex mutex_;
+   std::map<std::string, bool> cache_;
+};
+
+FileSystemTypeCache& fileSystemTypeCache()
+{
+   static FileSystemTypeCache instance;
+   return instance;
+}
+
+boost::shared_ptr<FileLock> createDelegate(const FilePath& lockFilePath)
+{
+   if (fileSystemTypeCache().isNfs(lockFilePath.parent()))
+      return boost::shared_ptr<FileLock>(new LinkBasedFileLock());
+   else
+      return boost::shared_ptr<FileLock>(new AdvisoryFileLock());
+}
+
+} // end anonymous namespace
+
+struct AutoFileLock::Impl
+{
+   boost::shared_ptr<FileLock> pDelegate;
+};
+
+AutoFileLock::AutoFileLock()
+   : pImpl_(new Impl())
+{
+}
+
+AutoFileLock::~AutoFileLock()
+{
+}
+
+Error AutoFileLock::acquire(const FilePath& lockFilePath)
+{
+   pImpl_->pDelegate = createDelegate(lockFilePath);
+   return pImpl_->pDelegate->acquire(lockFilePath);
+}
+
+Error AutoFileLock::release()
+{
+   if (!pImpl_->pDelegate)
+      return systemError(boost::system::errc::operation_not_permitted,
+                         ERROR_LOCATION);
+
+   return pImpl_->pDelegate->release();
+}
+
+bool AutoFileLock::isLocked(const FilePath& lockFilePath) const
+{
+   return createDelegate(lockFilePath)->isLocked(lockFilePath);
+}
+
+FilePath AutoFileLock::lockFilePath() const
+{
+   if (!pImpl_->pDelegate)
+      return FilePath();
+
+   return pImpl_->pDelegate->lockFilePath();
+}
+
+} // end namespace core
+} // end namespace rstudio
@@ -23,6 +23,7 @@
 #include <core/Log.hpp>
 #include <core/FileSerializer.hpp>
 #include <core/http/SocketUtils.hpp>
+#include <core/Thread.hpp>
 #include <core/system/Environment.hpp>
 
 #include <boost/algorithm/string.hpp>
@@ -37,13 +38,15 @@ namespace {
 
 const char * const kLockTypeAdvisory  = "advisory";
 const char * const kLockTypeLinkBased = "linkbased";
+const char * const kLockTypeAuto      = "auto";
 
-// use advisory locks on Windows by default; link-based elsewhere
+// use advisory locks on Windows by default; automatic selection
+// (advisory locally, link-based on NFS) elsewhere
 #ifdef _WIN32
 # define kLockTypeDefault kLockTypeAdvisory
 #else
-# define kLockTypeDefault kLockTypeLinkBased
-#endif 
+# define kLockTypeDefault kLockTypeAuto
+#endif
 
 const char * const kLocksConfPath    = "/etc/rstudio/file-locks";
 const double kDefaultRefreshRate     = 20.0;
@@ -55,6 +58,7 @@ std::string lockTypeToString(FileLock::LockType type)
    {
    case FileLock::LOCKTYPE_ADVISORY:  return kLockTypeAdvisory;
    case FileLock::LOCKTYPE_LINKBASED: return kLockTypeLinkBased;
+   case FileLock::LOCKTYPE_AUTO:      return kLockTypeAuto;
    }
    
    // not reached
@@ -69,7 +73,9 @@ FileLock::LockType stringToLockType(const std::string& lockType)
       return FileLock::LOCKTYPE_ADVISORY;
    else if (boost::iequals(lockType, kLockTypeLinkBased))
       return FileLock::LOCKTYPE_LINKBASED;
-   
+   else if (boost::iequals(lockType, kLockTypeAuto))
+      return FileLock::LOCKTYPE_AUTO;
+
    LOG_WARNING_MESSAGE("unrecognized lock type '" + lockType + "'");
    return FileLock::LOCKTYPE_LINKBASED;
 }
@@ -226,6 +232,7 @@ boost::shared_ptr<FileLock> FileLock::create(LockType type)
    {
    case LOCKTYPE_ADVISORY:  return boost::shared_ptr<FileLock>(new AdvisoryFileLock());
    case LOCKTYPE_LINKBASED: return boost::shared_ptr<FileLock>(new LinkBasedFileLock());
+   case LOCKTYPE_AUTO:      return boost::shared_ptr<FileLock>(new AutoFileLock());
    }
    
    // shouldn't be reached
@@ -297,6 +304,40 @@ void schedulePeriodicExecution(
 
 } // end anonymous namespace
 
+namespace {
+
+void refreshThreadMain()
+{
+   try
+   {
+      while (true)
+      {
+         boost::this_thread::sleep(FileLock::getRefreshRate());
+         FileLock::refresh();
+      }
+   }
+   catch (...)
+   {
+      // swallow errors (thread exits at process shutdown via detach)
+   }
+}
+
+} // end anonymous namespace
+
+void FileLock::refreshPeriodically()
+{
+   // protect against re-entrancy
+   static bool s_isRefreshing = false;
+   if (s_isRefreshing)
+      return;
+   s_isRefreshing = true;
+
+   verifyInitialized();
+
+   static boost::thread s_refreshThread;
+   core::thread::safeLaunchThread(refreshThreadMain, &s_refreshThread);
+}
+
 void FileLock::refreshPeriodically(boost::asio::io_service& service,
                                    boost::posix_time::seconds interval)
 {
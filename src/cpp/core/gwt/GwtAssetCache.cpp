@@ -0,0 +1,175 @@
+/*
+ * GwtAssetCache.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/gwt/GwtAssetCache.hpp>
+
+#include <map>
+#include <sstream>
+
+#include <boost/shared_ptr.hpp>
+
+#ifndef _WIN32
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#endif
+
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/Hash.hpp>
+#include <core/Log.hpp>
+#include <core/Thread.hpp>
+#include <core/http/Request.hpp>
+#include <core/http/Response.hpp>
+
+namespace rstudio {
+namespace core {
+namespace gwt {
+
+namespace {
+
+struct AssetCacheEntry
+{
+   AssetCacheEntry() : fileSize(0), lastWriteTime(0) {}
+
+   // validation state (a new gwt build replaces the files in place)
+   uintmax_t fileSize;
+   std::time_t lastWriteTime;
+
+   // content hash of the uncompressed asset
+   std::string eTag;
+
+   // gzipped variant, shared so responses can reference it with no copy
+   // (empty on platforms where we never gzip)
+   boost::shared_ptr<std::string> gzipContent;
+};
+
+typedef std::map<std::string, AssetCacheEntry> AssetCache;
+
+AssetCache s_assetCache;
+boost::mutex s_assetCacheMutex;
+
+Error buildCacheEntry(const FilePath& filePath, AssetCacheEntry* pEntry)
+{
+   // read the asset (this is the only time we materialize the raw bytes)
+   std::string contents;
+   Error error = core::readStringFromFile(filePath, &contents);
+   if (error)
+      return error;
+
+   // strong etag from the content hash
+   pEntry->eTag = core::hash::fastHash(contents);
+
+#ifndef _WIN32
+   // precompress (gzip at default level -- this happens once per build
+   // of each asset rather than once per request)
+   try
+   {
+      std::istringstream contentStream(contents);
+      boost::iostreams::filtering_ostream compressingStream;
+      std::ostringstream compressedStream;
+      compressingStream.push(boost::iostreams::gzip_compressor());
+      compressingStream.push(compressedStream);
+      boost::iostreams::copy(contentStream, compressingStream);
+
+      pEntry->gzipContent.reset(new std::string(compressedStream.str()));
+   }
+   catch(const std::exception& e)
+   {
+      // compression failure isn't fatal -- we'll serve identity
+      LOG_WARNING_MESSAGE(std::string("error compressing gwt asset: ") +
+                          e.what());
+      pEntry->gzipContent.reset();
+   }
+#endif
+
+   pEntry->fileSize = filePath.size();
+   pEntry->lastWriteTime = filePath.lastWriteTime();
+
+   return Success();
+}
+
+} // anonymous namespace
+
+void handleCachedAssetRequest(const FilePath& filePath,
+                              const http::Request& request,
+                              http::Response* pResponse)
+{
+   // ensure that the file exists
+   if (!filePath.exists())
+   {
+      pResponse->setNotFoundError(request.uri());
+      return;
+   }
+
+   // get (or build/refresh) the cache entry for this asset
+   AssetCacheEntry entry;
+   LOCK_MUTEX(s_assetCacheMutex)
+   {
+      AssetCache::iterator it = s_assetCache.find(filePath.absolutePath());
+      if (it == s_assetCache.end() ||
+          it->second.fileSize != filePath.size() ||
+          it->second.lastWriteTime != filePath.lastWriteTime())
+      {
+         AssetCacheEntry newEntry;
+         Error error = buildCacheEntry(filePath, &newEntry);
+         if (error)
+         {
+            LOG_ERROR(error);
+
+            // serve conventionally if we couldn't cache
+            pResponse->setFile(filePath, request);
+            return;
+         }
+         s_assetCache[filePath.absolutePath()] = newEntry;
+         entry = newEntry;
+      }
+      else
+      {
+         entry = it->second;
+      }
+   }
+   END_LOCK_MUTEX
+
+   // the representation varies with Accept-Encoding
+   pResponse->setHeader("Vary", "Accept-Encoding");
+
+   // strong etag / conditional request handling
+   pResponse->setHeader("ETag", entry.eTag);
+   if (entry.eTag == request.headerValue("If-None-Match"))
+   {
+      pResponse->removeHeader("Content-Type");
+      pResponse->setStatusCode(http::status::NotModified);
+      return;
+   }
+
+   // serve the precompressed variant from memory when we can
+   if (entry.gzipContent && request.acceptsEncoding(http::kGzipEncoding))
+   {
+      pResponse->setContentType(filePath.mimeContentType());
+      pResponse->setContentEncoding(http::kGzipEncoding);
+      pResponse->addBodyBuffer(entry.gzipContent);
+   }
+   else
+   {
+      // identity: zero-copy from the file itself (keeps multi-megabyte
+      // uncompressed permutations out of the cache)
+      pResponse->setMemoryMappedFile(filePath, request);
+   }
+}
+
+} // namespace gwt
+} // namespace core
+} // namespace rstudio
@@ -14,6 +14,7 @@
  */
 
 #include <core/gwt/GwtFileHandler.hpp>
+#include <core/gwt/GwtAssetCache.hpp>
 
 #include <boost/regex.hpp>
 #include <boost/algorithm/string/predicate.hpp>
@@ -104,14 +105,14 @@ void handleFileRequest(const std::string& wwwLocalPath,
    if (regex_utils::match(uri, boost::regex(".*\\.cache\\..*")))
    {
       pResponse->setCacheForeverHeaders();
-      pResponse->setFile(filePath, request);
+      handleCachedAssetRequest(filePath, request, pResponse);
    }
-   
-   // case: files designated to never be cached 
+
+   // case: files designated to never be cached
    else if (regex_utils::match(uri, boost::regex(".*\\.nocache\\..*")))
    {
       pResponse->setNoCacheHeaders();
-      pResponse->setFile(filePath, request);
+      handleCachedAssetRequest(filePath, request, pResponse);
    }
    // case: main page -- don't cache and dynamically set compiler stack mode
    else if (uri == mainPage)
@@ -251,6 +251,12 @@ void initializeSymbolMaps(const core::FilePath& symbolMapsPath)
       LOG_ERROR(error);
 }
 
+void evictIdleSymbolMaps()
+{
+   if (s_pSymbolMaps != NULL)
+      s_pSymbolMaps->evictIdle();
+}
+
 void handleLogRequest(const std::string& username,
                       const http::Request& request, 
                       http::Response* pResponse)
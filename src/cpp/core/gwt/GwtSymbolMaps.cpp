@@ -15,14 +15,19 @@
 
 #include <core/gwt/GwtSymbolMaps.hpp>
 
+#include <cstring>
 #include <string>
 #include <map>
 #include <set>
+#include <vector>
 #include <algorithm>
 
 #include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/foreach.hpp>
 #include <boost/regex.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 
@@ -30,6 +35,7 @@
 #include <core/RegexUtils.hpp>
 #include <core/SafeConvert.hpp>
 #include <core/FileSerializer.hpp>
+#include <core/system/MemoryMappedFile.hpp>
 
 // NOTE: this is a port of the following GWT class:
 // (our rev was 11565, we should track to future changes)
@@ -73,6 +79,257 @@ ReadCollectionAction parseSymbolMapLine(
    return ReadCollectionAddLine;
 }
 
+// binary index over a .symbolMap file. symbol maps are tens of MB and
+// scanning one on the first client exception stalls the log handler, so
+// we build a sorted (hash of obfuscated symbol -> line offset) index once
+// per GWT build and thereafter binary search it via mmap. the index is a
+// local cache (native endianness, not portable across machines) and is
+// regenerated whenever the symbol map it was built from changes
+const char kSymbolIndexMagic[4] = { 'R', 'S', 'S', 'X' };
+const boost::uint32_t kSymbolIndexVersion = 1;
+
+struct SymbolIndexHeader
+{
+   char magic[4];
+   boost::uint32_t version;
+   boost::uint32_t recordCount;
+   boost::uint32_t reserved;
+   boost::uint64_t mapSize;       // size of the source .symbolMap
+   boost::int64_t mapTime;        // last write time of the source .symbolMap
+};
+
+struct SymbolIndexRecord
+{
+   boost::uint64_t hash;
+   boost::uint32_t offset;        // offset of the line in the .symbolMap
+   boost::uint32_t length;        // length of the line (sans newline)
+};
+
+bool recordLessThan(const SymbolIndexRecord& a, const SymbolIndexRecord& b)
+{
+   return a.hash < b.hash;
+}
+
+// FNV-1a (64-bit)
+boost::uint64_t hashSymbol(const std::string& symbol)
+{
+   boost::uint64_t hash = 14695981039346656037ULL;
+   for (std::size_t i = 0; i < symbol.length(); i++)
+   {
+      hash ^= static_cast<unsigned char>(symbol[i]);
+      hash *= 1099511628211ULL;
+   }
+   return hash;
+}
+
+FilePath symbolIndexPath(const FilePath& mapPath)
+{
+   return mapPath.parent().childPath(mapPath.filename() + ".idx");
+}
+
+Error buildSymbolMapIndex(const FilePath& mapPath, const FilePath& indexPath)
+{
+   std::string contents;
+   Error error = readStringFromFile(mapPath, &contents);
+   if (error)
+      return error;
+
+   // one record per symbol line -- we index the offset/length of the full
+   // line so a lookup can verify the symbol on hash collision
+   std::vector<SymbolIndexRecord> records;
+   std::size_t pos = 0;
+   while (pos < contents.length())
+   {
+      std::size_t eol = contents.find('\n', pos);
+      if (eol == std::string::npos)
+         eol = contents.length();
+
+      if ((eol > pos) && (contents[pos] != '#'))
+      {
+         std::size_t commaPos = contents.find(',', pos);
+         if ((commaPos != std::string::npos) && (commaPos < eol))
+         {
+            SymbolIndexRecord record;
+            record.hash = hashSymbol(contents.substr(pos, commaPos - pos));
+            record.offset = static_cast<boost::uint32_t>(pos);
+            record.length = static_cast<boost::uint32_t>(eol - pos);
+            records.push_back(record);
+         }
+      }
+      pos = eol + 1;
+   }
+   std::sort(records.begin(), records.end(), recordLessThan);
+
+   SymbolIndexHeader header;
+   std::memcpy(header.magic, kSymbolIndexMagic, sizeof(header.magic));
+   header.version = kSymbolIndexVersion;
+   header.recordCount = static_cast<boost::uint32_t>(records.size());
+   header.reserved = 0;
+   header.mapSize = contents.length();
+   header.mapTime = static_cast<boost::int64_t>(mapPath.lastWriteTime());
+
+   std::string buffer;
+   buffer.reserve(sizeof(header) + (records.size() * sizeof(SymbolIndexRecord)));
+   buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+   if (!records.empty())
+   {
+      buffer.append(reinterpret_cast<const char*>(&records[0]),
+                    records.size() * sizeof(SymbolIndexRecord));
+   }
+
+   // write to a temp file then move into place so a concurrent reader
+   // never sees a partially written index
+   FilePath tempPath = indexPath.parent().childPath(
+                                       indexPath.filename() + ".tmp");
+   error = writeStringToFile(tempPath, buffer);
+   if (error)
+      return error;
+   return tempPath.move(indexPath);
+}
+
+class SymbolMapIndex : boost::noncopyable
+{
+public:
+   SymbolMapIndex()
+      : pHeader_(NULL), pRecords_(NULL)
+   {
+   }
+
+   Error open(const FilePath& mapPath)
+   {
+      FilePath indexPath = symbolIndexPath(mapPath);
+
+      // try an existing index first
+      Error error = tryOpen(mapPath, indexPath);
+      if (!error)
+         return Success();
+
+      // no index (or it was stale/invalid) -- (re)build it. this occurs
+      // once per GWT build since the strong name of the symbol map (and
+      // thus of the index) changes whenever the client is recompiled
+      close();
+      error = buildSymbolMapIndex(mapPath, indexPath);
+      if (error)
+         return error;
+      return tryOpen(mapPath, indexPath);
+   }
+
+   void close()
+   {
+      pHeader_ = NULL;
+      pRecords_ = NULL;
+      indexFile_.close();
+      mapFile_.close();
+   }
+
+   // lookup the symbol data for the given symbol (returns
+   // SYMBOL_DATA_UNKNOWN if the symbol isn't in the map -- the index is
+   // complete over the map so there is never a need to rescan the text)
+   std::string lookup(const std::string& symbol) const
+   {
+      const char* pMapData = static_cast<const char*>(mapFile_.data());
+
+      SymbolIndexRecord key;
+      key.hash = hashSymbol(symbol);
+      key.offset = 0;
+      key.length = 0;
+
+      const SymbolIndexRecord* pEnd = pRecords_ + pHeader_->recordCount;
+      const SymbolIndexRecord* pIt = std::lower_bound(pRecords_,
+                                                      pEnd,
+                                                      key,
+                                                      recordLessThan);
+      for ( ; (pIt != pEnd) && (pIt->hash == key.hash); ++pIt)
+      {
+         // defend against a corrupt index
+         if ((static_cast<std::size_t>(pIt->offset) + pIt->length) >
+                                                            mapFile_.size())
+            break;
+
+         // verify the symbol (hash collisions) then return the data
+         // portion of the line
+         std::string line(pMapData + pIt->offset, pIt->length);
+         if ((line.length() > symbol.length()) &&
+             (line.compare(0, symbol.length(), symbol) == 0) &&
+             (line[symbol.length()] == ','))
+         {
+            std::string data = line.substr(symbol.length() + 1);
+            if (!data.empty() && (data[data.length()-1] == '\r'))
+               data.erase(data.length()-1);
+            return data;
+         }
+      }
+
+      return SYMBOL_DATA_UNKNOWN;
+   }
+
+private:
+   Error tryOpen(const FilePath& mapPath, const FilePath& indexPath)
+   {
+      Error error = indexFile_.open(indexPath);
+      if (error)
+         return error;
+
+      // validate the header (and that the index matches the current
+      // symbol map -- i.e. it isn't left over from a previous build)
+      if (indexFile_.size() < sizeof(SymbolIndexHeader))
+         return invalidIndexError(indexPath, ERROR_LOCATION);
+
+      const SymbolIndexHeader* pHeader =
+         static_cast<const SymbolIndexHeader*>(indexFile_.data());
+      if ((std::memcmp(pHeader->magic,
+                       kSymbolIndexMagic,
+                       sizeof(kSymbolIndexMagic)) != 0) ||
+          (pHeader->version != kSymbolIndexVersion) ||
+          (indexFile_.size() != (sizeof(SymbolIndexHeader) +
+             (pHeader->recordCount * sizeof(SymbolIndexRecord)))) ||
+          (pHeader->mapSize != mapPath.size()) ||
+          (pHeader->mapTime !=
+             static_cast<boost::int64_t>(mapPath.lastWriteTime())))
+      {
+         return invalidIndexError(indexPath, ERROR_LOCATION);
+      }
+
+      error = mapFile_.open(mapPath);
+      if (error)
+         return error;
+
+      pHeader_ = pHeader;
+      pRecords_ = reinterpret_cast<const SymbolIndexRecord*>(
+         static_cast<const char*>(indexFile_.data()) +
+         sizeof(SymbolIndexHeader));
+
+      return Success();
+   }
+
+   static Error invalidIndexError(const FilePath& indexPath,
+                                  const ErrorLocation& location)
+   {
+      Error error = systemError(boost::system::errc::protocol_error,
+                                location);
+      error.addProperty("path", indexPath);
+      return error;
+   }
+
+private:
+   system::MemoryMappedFile indexFile_;
+   system::MemoryMappedFile mapFile_;
+   const SymbolIndexHeader* pHeader_;
+   const SymbolIndexRecord* pRecords_;
+};
+
+// resident permutation budget. each permutation a client reports an
+// error from pins its mmap'd symbol map and index plus a parsed symbol
+// cache, and a deployment serves one symbol map per GWT permutation
+// while any given browser population typically exercises only one or
+// two -- so beyond a small working set the least recently used
+// permutation's state is released
+const std::size_t kMaxResidentPermutations = 4;
+
+// permutations which haven't resolved a trace for this long are
+// released by evictIdle() regardless of the cap
+const int kPermutationIdleSeconds = 600;
+
 class SymbolCache : boost::noncopyable
 {
 public:
@@ -118,6 +375,15 @@ public:
       return toReturn;
    }
 
+   void evict(const std::string& strongName)
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         cache_.erase(strongName);
+      }
+      END_LOCK_MUTEX
+   }
+
 private:
    boost::mutex mutex_;
    std::map<std::string, std::map<std::string,std::string> > cache_;
@@ -131,6 +397,118 @@ struct SymbolMaps::Impl
    FilePath symbolMapsPath;
    SymbolCache symbolCache;
 
+   boost::mutex indexMutex;
+   std::map<std::string, boost::shared_ptr<SymbolMapIndex> > indexes;
+
+   // last trace resolution time per permutation (guarded by indexMutex)
+   std::map<std::string, boost::posix_time::ptime> lastUsed;
+
+   // note use of a permutation and release the least recently used
+   // state when over the resident budget (the cache is evicted outside
+   // the lock; an in-flight lookup holding the index shared_ptr keeps
+   // its mappings alive until it completes)
+   void touchPermutation(const std::string& strongName)
+   {
+      std::vector<std::string> evicted;
+
+      LOCK_MUTEX(indexMutex)
+      {
+         lastUsed[strongName] =
+                     boost::posix_time::microsec_clock::universal_time();
+
+         while (lastUsed.size() > kMaxResidentPermutations)
+         {
+            std::map<std::string, boost::posix_time::ptime>::iterator
+                                                   oldest = lastUsed.end();
+            for (std::map<std::string, boost::posix_time::ptime>::iterator
+                 it = lastUsed.begin(); it != lastUsed.end(); ++it)
+            {
+               if (it->first != strongName &&
+                   (oldest == lastUsed.end() || it->second < oldest->second))
+               {
+                  oldest = it;
+               }
+            }
+            if (oldest == lastUsed.end())
+               break;
+
+            evicted.push_back(oldest->first);
+            indexes.erase(oldest->first);
+            lastUsed.erase(oldest);
+         }
+      }
+      END_LOCK_MUTEX
+
+      BOOST_FOREACH(const std::string& name, evicted)
+      {
+         symbolCache.evict(name);
+      }
+   }
+
+   // release state for permutations which haven't resolved a trace
+   // recently
+   void evictIdle()
+   {
+      using namespace boost::posix_time;
+
+      std::vector<std::string> evicted;
+
+      LOCK_MUTEX(indexMutex)
+      {
+         ptime now = microsec_clock::universal_time();
+         for (std::map<std::string, ptime>::iterator it = lastUsed.begin();
+              it != lastUsed.end(); )
+         {
+            if ((now - it->second) > seconds(kPermutationIdleSeconds))
+            {
+               evicted.push_back(it->first);
+               indexes.erase(it->first);
+               lastUsed.erase(it++);
+            }
+            else
+            {
+               ++it;
+            }
+         }
+      }
+      END_LOCK_MUTEX
+
+      BOOST_FOREACH(const std::string& name, evicted)
+      {
+         symbolCache.evict(name);
+      }
+   }
+
+   // get (opening or building on first use) the binary index for the
+   // given strong name; returns an empty ptr if no index is available
+   // (e.g. the symbol maps directory isn't writable)
+   boost::shared_ptr<SymbolMapIndex> symbolIndex(const std::string& strongName,
+                                                 const FilePath& mapPath)
+   {
+      LOCK_MUTEX(indexMutex)
+      {
+         std::map<std::string, boost::shared_ptr<SymbolMapIndex> >
+                                    ::const_iterator it = indexes.find(strongName);
+         if (it != indexes.end())
+            return it->second;
+
+         boost::shared_ptr<SymbolMapIndex> pIndex(new SymbolMapIndex());
+         Error error = pIndex->open(mapPath);
+         if (error)
+         {
+            LOG_ERROR(error);
+            pIndex.reset();
+         }
+
+         // cache even on failure so we don't retry on every trace
+         indexes[strongName] = pIndex;
+         return pIndex;
+      }
+      END_LOCK_MUTEX
+
+      return boost::shared_ptr<SymbolMapIndex>();
+   }
+
    std::string loadOneSymbol(const std::string& strongName,
                              const std::string& symbol)
    {
@@ -146,6 +524,10 @@ struct SymbolMaps::Impl
                            const std::string& strongName,
                            const std::set<std::string>& requiredSymbols)
    {
+      // track permutation usage (may evict the least recently used
+      // permutation's state to stay within the resident budget)
+      touchPermutation(strongName);
+
       // cache lookup first
       std::map<std::string,std::string> toReturn = symbolCache.getAll(
                                                                strongName,
@@ -162,14 +544,28 @@ struct SymbolMaps::Impl
       FilePath mapPath = symbolMapsPath.childPath(strongName + ".symbolMap");
       if (mapPath.exists())
       {
-         Error error = readCollectionFromFile
-                                    <std::map<std::string,std::string> >(
-                 mapPath,
-                 &toReturn,
-                 boost::bind(parseSymbolMapLine, _1, _2, &symbolsLeftToFind));
-         if (error)
-            LOG_ERROR(error);
-
+         // constant time resolution via the binary index when available
+         boost::shared_ptr<SymbolMapIndex> pIndex = symbolIndex(strongName,
+                                                                mapPath);
+         if (pIndex)
+         {
+            BOOST_FOREACH(const std::string& symbol, symbolsLeftToFind)
+            {
+               toReturn[symbol] = pIndex->lookup(symbol);
+            }
+            symbolsLeftToFind.clear();
+         }
+         else
+         {
+            // no index available -- fall back to scanning the text map
+            Error error = readCollectionFromFile
+                                       <std::map<std::string,std::string> >(
+                    mapPath,
+                    &toReturn,
+                    boost::bind(parseSymbolMapLine, _1, _2, &symbolsLeftToFind));
+            if (error)
+               LOG_ERROR(error);
+         }
       }
 
       // mark all remaining symbols as having been looked for
@@ -208,6 +604,11 @@ Error SymbolMaps::initialize(const FilePath& symbolMapsPath)
    return Success();
 }
 
+void SymbolMaps::evictIdle()
+{
+   pImpl_->evictIdle();
+}
+
 std::vector<StackElement> SymbolMaps::resymbolize(
                                   const std::vector<StackElement>& stack,
                                   const std::string& strongName)
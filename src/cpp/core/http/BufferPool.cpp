@@ -0,0 +1,75 @@
+/*
+ * BufferPool.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/http/BufferPool.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+BufferPool::BufferPool(std::size_t bufferSize, std::size_t poolSize)
+   : bufferSize_(bufferSize), poolSize_(poolSize)
+{
+   // pre-allocate the arena
+   freeList_.reserve(poolSize);
+   for (std::size_t i = 0; i < poolSize; i++)
+      freeList_.push_back(Buffer(new std::vector<char>(bufferSize)));
+}
+
+BufferPool::Buffer BufferPool::acquire()
+{
+   LOCK_MUTEX(mutex_)
+   {
+      if (!freeList_.empty())
+      {
+         Buffer buffer = freeList_.back();
+         freeList_.pop_back();
+         return buffer;
+      }
+   }
+   END_LOCK_MUTEX
+
+   // arena exhausted -- allocate (the buffer joins the pool on release)
+   return Buffer(new std::vector<char>(bufferSize_));
+}
+
+void BufferPool::release(Buffer buffer)
+{
+   if (!buffer)
+      return;
+
+   LOCK_MUTEX(mutex_)
+   {
+      if (freeList_.size() < poolSize_)
+         freeList_.push_back(buffer);
+   }
+   END_LOCK_MUTEX
+}
+
+std::size_t BufferPool::available() const
+{
+   LOCK_MUTEX(mutex_)
+   {
+      return freeList_.size();
+   }
+   END_LOCK_MUTEX
+
+   // keep compiler happy (never reached)
+   return 0;
+}
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
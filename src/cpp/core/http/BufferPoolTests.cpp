@@ -0,0 +1,61 @@
+/*
+ * BufferPoolTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+
+#include <core/http/BufferPool.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+context("Buffer pooling")
+{
+   test_that("Buffers are recycled through the pool")
+   {
+      BufferPool pool(1024, 2);
+      expect_true(pool.available() == 2);
+
+      BufferPool::Buffer buffer = pool.acquire();
+      expect_true(buffer->size() == 1024);
+      expect_true(pool.available() == 1);
+
+      pool.release(buffer);
+      expect_true(pool.available() == 2);
+
+      // the released buffer is handed back out
+      expect_true(pool.acquire().get() == buffer.get());
+   }
+
+   test_that("Exhausted pool allocates rather than blocking")
+   {
+      BufferPool pool(64, 1);
+
+      BufferPool::Buffer first = pool.acquire();
+      BufferPool::Buffer second = pool.acquire();
+      expect_true(second.get() != NULL);
+      expect_true(second->size() == 64);
+      expect_true(pool.available() == 0);
+
+      // releases beyond the arena size are dropped
+      pool.release(first);
+      pool.release(second);
+      expect_true(pool.available() == 1);
+   }
+}
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,210 @@
+/*
+ * Compression.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/http/Compression.hpp>
+
+#include <sstream>
+
+#ifndef _WIN32
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#endif
+
+#include <boost/bind.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <core/Error.hpp>
+#include <core/Thread.hpp>
+
+#include <core/http/Request.hpp>
+#include <core/http/Response.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+namespace compression {
+
+namespace {
+
+// don't bother compressing small bodies -- the gzip header and deflate
+// dictionary overhead eat most of the savings and the round trip through
+// the worker pool isn't free
+const std::size_t kMinimumCompressibleBytes = 1024;
+
+bool isCompressibleContentType(const std::string& contentType)
+{
+   // all text types compress well
+   if (boost::algorithm::starts_with(contentType, "text/"))
+      return true;
+
+   // prefix match so parameters (e.g. "; charset=UTF-8") don't defeat us
+   static const char* const kCompressibleTypes[] = {
+      "application/json",
+      "application/javascript",
+      "application/x-javascript",
+      "application/xml",
+      "application/rss+xml",
+      "application/xhtml+xml",
+      "image/svg+xml"
+   };
+   for (std::size_t i = 0;
+        i < sizeof(kCompressibleTypes)/sizeof(kCompressibleTypes[0]);
+        i++)
+   {
+      if (boost::algorithm::starts_with(contentType, kCompressibleTypes[i]))
+         return true;
+   }
+
+   return false;
+}
+
+#ifndef _WIN32
+
+// lazily started worker pool shared by every connection in the process.
+// the threads run for the life of the process (http servers here have no
+// orderly shutdown path) so they are deliberately never joined
+const std::size_t kCompressionThreads = 2;
+boost::mutex s_poolMutex;
+boost::asio::io_service* s_pCompressionService = NULL;
+boost::asio::io_service::work* s_pCompressionWork = NULL;
+
+void runCompressionThread()
+{
+   s_pCompressionService->run();
+}
+
+boost::asio::io_service& compressionService()
+{
+   LOCK_MUTEX(s_poolMutex)
+   {
+      if (s_pCompressionService == NULL)
+      {
+         s_pCompressionService = new boost::asio::io_service();
+         s_pCompressionWork = new boost::asio::io_service::work(
+                                                      *s_pCompressionService);
+         for (std::size_t i = 0; i < kCompressionThreads; i++)
+            core::thread::safeLaunchThread(runCompressionThread);
+      }
+   }
+   END_LOCK_MUTEX
+
+   return *s_pCompressionService;
+}
+
+// runs on a pool thread -- compress then bounce the result back to the
+// caller's io_service
+void compressOnPoolThread(boost::asio::io_service* pIoService,
+                          boost::shared_ptr<std::string> pBody,
+                          CompressHandler handler)
+{
+   boost::shared_ptr<std::string> pCompressed(new std::string());
+   Error error = gzipCompress(*pBody, pCompressed.get());
+   pIoService->post(boost::bind(handler, error, pCompressed));
+}
+
+#endif // !_WIN32
+
+} // anonymous namespace
+
+
+bool shouldCompressResponse(const Request& request, const Response& response)
+{
+#ifdef _WIN32
+   return false;
+#else
+   return response.statusCode() == status::Ok &&
+          response.contentEncoding().empty() &&
+          response.bodyBuffers().empty() &&
+          response.body().size() >= kMinimumCompressibleBytes &&
+          isCompressibleContentType(response.contentType()) &&
+          request.acceptsEncoding(kGzipEncoding);
+#endif
+}
+
+Error gzipCompress(const std::string& input, std::string* pOutput)
+{
+#ifdef _WIN32
+   return systemError(boost::system::errc::not_supported, ERROR_LOCATION);
+#else
+   try
+   {
+      std::istringstream inputStream(input);
+      boost::iostreams::filtering_ostream filteringStream;
+      filteringStream.push(boost::iostreams::gzip_compressor());
+      std::ostringstream outputStream;
+      filteringStream.push(outputStream);
+      boost::iostreams::copy(inputStream, filteringStream);
+      *pOutput = outputStream.str();
+      return Success();
+   }
+   catch(const std::exception& e)
+   {
+      Error error = systemError(boost::system::errc::io_error,
+                                ERROR_LOCATION);
+      error.addProperty("what", e.what());
+      return error;
+   }
+#endif
+}
+
+Error gzipDecompress(const std::string& input, std::string* pOutput)
+{
+#ifdef _WIN32
+   return systemError(boost::system::errc::not_supported, ERROR_LOCATION);
+#else
+   try
+   {
+      std::istringstream inputStream(input);
+      boost::iostreams::filtering_istream filteringStream;
+      filteringStream.push(boost::iostreams::gzip_decompressor());
+      filteringStream.push(inputStream);
+      std::ostringstream outputStream;
+      boost::iostreams::copy(filteringStream, outputStream);
+      *pOutput = outputStream.str();
+      return Success();
+   }
+   catch(const std::exception& e)
+   {
+      Error error = systemError(boost::system::errc::io_error,
+                                ERROR_LOCATION);
+      error.addProperty("what", e.what());
+      return error;
+   }
+#endif
+}
+
+void gzipCompressAsync(boost::asio::io_service& ioService,
+                       const boost::shared_ptr<std::string>& pBody,
+                       const CompressHandler& handler)
+{
+#ifdef _WIN32
+   // no gzip on win32 -- complete inline with an error
+   boost::shared_ptr<std::string> pCompressed(new std::string());
+   ioService.post(boost::bind(handler,
+                              gzipCompress(*pBody, pCompressed.get()),
+                              pCompressed));
+#else
+   compressionService().post(boost::bind(compressOnPoolThread,
+                                         &ioService,
+                                         pBody,
+                                         handler));
+#endif
+}
+
+} // namespace compression
+} // namespace http
+} // namespace core
+} // namespace rstudio
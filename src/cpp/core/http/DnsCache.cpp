@@ -0,0 +1,147 @@
+/*
+ * DnsCache.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/http/DnsCache.hpp>
+
+#include <boost/bind.hpp>
+
+#include <boost/asio/io_service.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+namespace {
+
+// how long cached resolutions remain valid. failures are cached for a
+// much shorter interval so a transient resolver problem doesn't pin
+// an endpoint as unreachable
+const int kPositiveTtlSeconds = 60;
+const int kNegativeTtlSeconds = 10;
+
+std::string cacheKey(const std::string& address, const std::string& port)
+{
+   return address + ":" + port;
+}
+
+void resolveAndStore(const std::string& address, const std::string& port)
+{
+   boost::asio::io_service ioService;
+   boost::asio::ip::tcp::resolver resolver(ioService);
+   boost::asio::ip::tcp::resolver::query query(address, port);
+
+   boost::system::error_code ec;
+   boost::asio::ip::tcp::resolver::iterator it = resolver.resolve(query, ec);
+
+   if (ec)
+   {
+      DnsCache::instance().storeNegative(address, port, ec);
+   }
+   else
+   {
+      std::vector<boost::asio::ip::tcp::endpoint> endpoints;
+      for ( ; it != boost::asio::ip::tcp::resolver::iterator(); ++it)
+         endpoints.push_back(*it);
+      DnsCache::instance().store(address, port, endpoints);
+   }
+}
+
+} // anonymous namespace
+
+DnsCache& DnsCache::instance()
+{
+   static DnsCache instance;
+   return instance;
+}
+
+bool DnsCache::lookup(const std::string& address,
+                      const std::string& port,
+                      std::vector<boost::asio::ip::tcp::endpoint>* pEndpoints,
+                      boost::system::error_code* pEc)
+{
+   LOCK_MUTEX(mutex_)
+   {
+      std::map<std::string,Entry>::iterator it =
+                                       cache_.find(cacheKey(address, port));
+      if (it == cache_.end())
+         return false;
+
+      // expired entries are misses (and are dropped so the map doesn't
+      // accumulate endpoints which are never connected to again)
+      if (boost::posix_time::microsec_clock::universal_time() >
+          it->second.expiry)
+      {
+         cache_.erase(it);
+         return false;
+      }
+
+      *pEndpoints = it->second.endpoints;
+      *pEc = it->second.ec;
+      return true;
+   }
+   END_LOCK_MUTEX
+
+   // keep compiler happy
+   return false;
+}
+
+void DnsCache::store(
+            const std::string& address,
+            const std::string& port,
+            const std::vector<boost::asio::ip::tcp::endpoint>& endpoints)
+{
+   // never store an empty positive entry (lookup would yield a hit
+   // with nothing to connect to)
+   if (endpoints.empty())
+      return;
+
+   Entry entry;
+   entry.endpoints = endpoints;
+   entry.expiry = boost::posix_time::microsec_clock::universal_time() +
+                  boost::posix_time::seconds(kPositiveTtlSeconds);
+
+   LOCK_MUTEX(mutex_)
+   {
+      cache_[cacheKey(address, port)] = entry;
+   }
+   END_LOCK_MUTEX
+}
+
+void DnsCache::storeNegative(const std::string& address,
+                             const std::string& port,
+                             const boost::system::error_code& ec)
+{
+   Entry entry;
+   entry.ec = ec;
+   entry.expiry = boost::posix_time::microsec_clock::universal_time() +
+                  boost::posix_time::seconds(kNegativeTtlSeconds);
+
+   LOCK_MUTEX(mutex_)
+   {
+      cache_[cacheKey(address, port)] = entry;
+   }
+   END_LOCK_MUTEX
+}
+
+void DnsCache::prewarm(const std::string& address, const std::string& port)
+{
+   core::thread::safeLaunchThread(boost::bind(resolveAndStore,
+                                              address,
+                                              port));
+}
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
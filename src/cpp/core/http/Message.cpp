@@ -155,7 +155,8 @@ void Message::reset()
    httpVersion_.clear() ;
    headers_.clear() ;
    body_.clear() ;
-   
+   bodyBuffers_.clear() ;
+
    // allow additional reseting by subclasses
    resetMembers() ;
 }
@@ -190,10 +191,30 @@ std::vector<boost::asio::const_buffer> Message::toBuffers(
    // body
    buffers.push_back(boost::asio::buffer(body_)) ;
 
+   // scatter-gather body buffers (memory owned by bodyBuffers_ entries)
+   for (BodyBuffers::const_iterator it = bodyBuffers_.begin();
+        it != bodyBuffers_.end();
+        ++it)
+   {
+      buffers.push_back(boost::asio::buffer(it->data, it->length)) ;
+   }
+
    // return the buffers
    return buffers ;
 }
 
+std::size_t Message::bodyLength() const
+{
+   std::size_t length = body_.length();
+   for (BodyBuffers::const_iterator it = bodyBuffers_.begin();
+        it != bodyBuffers_.end();
+        ++it)
+   {
+      length += it->length;
+   }
+   return length;
+}
+
 std::vector<boost::asio::const_buffer> Message::headerBuffers(
                                           const Header& overrideHeader) const
 {
@@ -0,0 +1,184 @@
+/*
+ * MultipartStreamParser.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/http/MultipartStreamParser.hpp>
+
+#include <boost/algorithm/string/find.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+namespace {
+
+// extract a quoted parameter (e.g. name="file") from a header line
+std::string headerParamValue(const std::string& header,
+                             const std::string& param)
+{
+   std::string token = param + "=\"";
+   std::string::size_type pos = header.find(token);
+   if (pos == std::string::npos)
+      return std::string();
+
+   std::string::size_type start = pos + token.length();
+   std::string::size_type end = header.find('"', start);
+   if (end == std::string::npos)
+      return std::string();
+
+   return header.substr(start, end - start);
+}
+
+} // anonymous namespace
+
+MultipartStreamParser::MultipartStreamParser(const std::string& boundary,
+                                             MultipartHandler* pHandler)
+   : delimiter_("\r\n--" + boundary),
+     pHandler_(pHandler),
+     state_(StatePreamble)
+{
+}
+
+bool MultipartStreamParser::parse(const char* pData, std::size_t length)
+{
+   if (state_ == StateError)
+      return false;
+
+   buffer_.append(pData, length);
+
+   return consumeBuffer();
+}
+
+void MultipartStreamParser::beginPart()
+{
+   // locate the Content-Disposition header within the buffered part
+   // headers and pull out the field name and (optional) filename
+   std::string name, filename;
+   std::string::size_type pos = 0;
+   while (pos < partHeaders_.length())
+   {
+      std::string::size_type eol = partHeaders_.find("\r\n", pos);
+      if (eol == std::string::npos)
+         eol = partHeaders_.length();
+
+      std::string line = partHeaders_.substr(pos, eol - pos);
+      if (boost::algorithm::istarts_with(line, "Content-Disposition:"))
+      {
+         name = headerParamValue(line, "name");
+         filename = headerParamValue(line, "filename");
+      }
+
+      pos = eol + 2;
+   }
+
+   pHandler_->onPartBegin(name, filename);
+}
+
+bool MultipartStreamParser::consumeBuffer()
+{
+   while (true)
+   {
+      switch (state_)
+      {
+         case StatePreamble:
+         {
+            // the first boundary line isn't preceded by CRLF so search
+            // for the delimiter without its leading CRLF
+            std::string openDelim = delimiter_.substr(2);
+            std::string::size_type pos = buffer_.find(openDelim);
+            if (pos == std::string::npos)
+            {
+               // retain enough bytes to match a delimiter which straddles
+               // the next chunk boundary
+               if (buffer_.length() > openDelim.length())
+                  buffer_.erase(0, buffer_.length() - openDelim.length());
+               return true;
+            }
+
+            buffer_.erase(0, pos + openDelim.length());
+            state_ = StatePartHeaders;
+            break;
+         }
+
+         case StatePartHeaders:
+         {
+            // the boundary line ends with CRLF (or "--" for the closing
+            // boundary); wait until we can see which
+            if (buffer_.length() < 2)
+               return true;
+
+            if (buffer_.compare(0, 2, "--") == 0)
+            {
+               state_ = StateComplete;
+               return true;
+            }
+
+            if (buffer_.compare(0, 2, "\r\n") != 0)
+            {
+               state_ = StateError;
+               return false;
+            }
+
+            // accumulate headers until the blank line which ends them
+            std::string::size_type pos = buffer_.find("\r\n\r\n");
+            if (pos == std::string::npos)
+               return true;
+
+            partHeaders_ = buffer_.substr(2, pos - 2);
+            buffer_.erase(0, pos + 4);
+
+            beginPart();
+            state_ = StatePartData;
+            break;
+         }
+
+         case StatePartData:
+         {
+            std::string::size_type pos = buffer_.find(delimiter_);
+            if (pos != std::string::npos)
+            {
+               // delimiter found -- flush the remainder of this part
+               if (pos > 0)
+                  pHandler_->onPartData(buffer_.data(), pos);
+               pHandler_->onPartEnd();
+
+               buffer_.erase(0, pos + delimiter_.length());
+               state_ = StatePartHeaders;
+               break;
+            }
+
+            // no delimiter -- flush everything except a delimiter's worth
+            // of lookback (a delimiter could straddle the chunk edge)
+            if (buffer_.length() > delimiter_.length())
+            {
+               std::size_t flush = buffer_.length() - delimiter_.length();
+               pHandler_->onPartData(buffer_.data(), flush);
+               buffer_.erase(0, flush);
+            }
+            return true;
+         }
+
+         case StateComplete:
+            return true;
+
+         case StateError:
+            return false;
+      }
+   }
+}
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,128 @@
+/*
+ * MultipartStreamParserTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include <core/http/MultipartStreamParser.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+namespace {
+
+class RecordingHandler : public MultipartHandler
+{
+public:
+   void onPartBegin(const std::string& name, const std::string& filename)
+   {
+      names.push_back(name);
+      filenames.push_back(filename);
+      data[name] = std::string();
+   }
+
+   void onPartData(const char* pData, std::size_t length)
+   {
+      data[names.back()].append(pData, length);
+   }
+
+   void onPartEnd()
+   {
+      ends++;
+   }
+
+   std::vector<std::string> names;
+   std::vector<std::string> filenames;
+   std::map<std::string, std::string> data;
+   int ends = 0;
+};
+
+const char * const kBody =
+   "--XYZ\r\n"
+   "Content-Disposition: form-data; name=\"targetDirectory\"\r\n"
+   "\r\n"
+   "~/uploads\r\n"
+   "--XYZ\r\n"
+   "Content-Disposition: form-data; name=\"file\"; filename=\"a.bin\"\r\n"
+   "Content-Type: application/octet-stream\r\n"
+   "\r\n"
+   "binary\r\ncontents\r\n"
+   "--XYZ--\r\n";
+
+} // anonymous namespace
+
+context("Multipart stream parsing")
+{
+   test_that("Parts are delivered with names, filenames, and data")
+   {
+      RecordingHandler handler;
+      MultipartStreamParser parser("XYZ", &handler);
+
+      expect_true(parser.parse(kBody, strlen(kBody)));
+      expect_true(parser.complete());
+      expect_true(handler.names.size() == 2);
+      expect_true(handler.ends == 2);
+      expect_true(handler.names[0] == "targetDirectory");
+      expect_true(handler.filenames[0] == "");
+      expect_true(handler.data["targetDirectory"] == "~/uploads");
+      expect_true(handler.names[1] == "file");
+      expect_true(handler.filenames[1] == "a.bin");
+      expect_true(handler.data["file"] == "binary\r\ncontents");
+   }
+
+   test_that("Parsing is chunk-size independent")
+   {
+      // feed the body one byte at a time to exercise every possible
+      // split across boundaries and headers
+      RecordingHandler handler;
+      MultipartStreamParser parser("XYZ", &handler);
+
+      std::size_t length = strlen(kBody);
+      for (std::size_t i = 0; i < length; i++)
+         expect_true(parser.parse(kBody + i, 1));
+
+      expect_true(parser.complete());
+      expect_true(handler.ends == 2);
+      expect_true(handler.data["targetDirectory"] == "~/uploads");
+      expect_true(handler.data["file"] == "binary\r\ncontents");
+   }
+
+   test_that("Truncated bodies are not reported as complete")
+   {
+      RecordingHandler handler;
+      MultipartStreamParser parser("XYZ", &handler);
+
+      expect_true(parser.parse(kBody, strlen(kBody) - 10));
+      expect_true(!parser.complete());
+   }
+
+   test_that("Malformed boundary lines produce an error")
+   {
+      const char * const body = "--XYZ@@garbage";
+
+      RecordingHandler handler;
+      MultipartStreamParser parser("XYZ", &handler);
+
+      expect_true(!parser.parse(body, strlen(body)));
+   }
+}
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,97 @@
+/*
+ * QosScheduler.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/http/QosScheduler.hpp>
+
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+QosScheduler::QosScheduler()
+{
+}
+
+void QosScheduler::setMaxConcurrent(RequestClass requestClass,
+                                    std::size_t maxConcurrent)
+{
+   classes_[requestClass].maxConcurrent = maxConcurrent;
+}
+
+void QosScheduler::beginTask(RequestClass requestClass,
+                             const boost::function<void()>& task)
+{
+   LOCK_MUTEX(mutex_)
+   {
+      ClassState& state = classes_[requestClass];
+      if (state.maxConcurrent > 0 && state.active >= state.maxConcurrent)
+      {
+         // class is at capacity -- queue for dispatch on completion of
+         // a running request of the same class
+         state.queue.push_back(task);
+         return;
+      }
+
+      state.active++;
+   }
+   END_LOCK_MUTEX
+
+   // run outside the lock
+   task();
+}
+
+void QosScheduler::taskComplete(RequestClass requestClass)
+{
+   boost::function<void()> nextTask;
+
+   LOCK_MUTEX(mutex_)
+   {
+      ClassState& state = classes_[requestClass];
+      if (!state.queue.empty())
+      {
+         // hand the slot directly to the next queued task
+         nextTask = state.queue.front();
+         state.queue.pop_front();
+      }
+      else if (state.active > 0)
+      {
+         state.active--;
+      }
+   }
+   END_LOCK_MUTEX
+
+   if (nextTask)
+      nextTask();
+}
+
+QosScheduler::ClassMetrics QosScheduler::metricsFor(
+                                          RequestClass requestClass) const
+{
+   ClassMetrics metrics;
+
+   LOCK_MUTEX(mutex_)
+   {
+      const ClassState& state = classes_[requestClass];
+      metrics.active = state.active;
+      metrics.queued = state.queue.size();
+   }
+   END_LOCK_MUTEX
+
+   return metrics;
+}
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,94 @@
+/*
+ * QosSchedulerTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+
+#include <boost/bind.hpp>
+
+#include <core/http/QosScheduler.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+namespace {
+
+void incrementCounter(int* pCounter)
+{
+   (*pCounter)++;
+}
+
+} // anonymous namespace
+
+context("Qos scheduling")
+{
+   test_that("Unlimited classes dispatch immediately")
+   {
+      QosScheduler scheduler;
+      int runs = 0;
+
+      scheduler.beginTask(InteractiveClass,
+                          boost::bind(incrementCounter, &runs));
+      scheduler.beginTask(InteractiveClass,
+                          boost::bind(incrementCounter, &runs));
+
+      expect_true(runs == 2);
+      expect_true(scheduler.metricsFor(InteractiveClass).active == 2);
+      expect_true(scheduler.metricsFor(InteractiveClass).queued == 0);
+   }
+
+   test_that("Tasks over the limit are queued and dispatched on completion")
+   {
+      QosScheduler scheduler;
+      scheduler.setMaxConcurrent(BulkClass, 1);
+
+      int runs = 0;
+      scheduler.beginTask(BulkClass, boost::bind(incrementCounter, &runs));
+      scheduler.beginTask(BulkClass, boost::bind(incrementCounter, &runs));
+
+      expect_true(runs == 1);
+      expect_true(scheduler.metricsFor(BulkClass).active == 1);
+      expect_true(scheduler.metricsFor(BulkClass).queued == 1);
+
+      // completing the running task dispatches the queued one
+      scheduler.taskComplete(BulkClass);
+      expect_true(runs == 2);
+      expect_true(scheduler.metricsFor(BulkClass).active == 1);
+      expect_true(scheduler.metricsFor(BulkClass).queued == 0);
+
+      // completing the second task frees the slot
+      scheduler.taskComplete(BulkClass);
+      expect_true(scheduler.metricsFor(BulkClass).active == 0);
+   }
+
+   test_that("Classes are limited independently")
+   {
+      QosScheduler scheduler;
+      scheduler.setMaxConcurrent(BulkClass, 1);
+
+      int bulkRuns = 0, rpcRuns = 0;
+      scheduler.beginTask(BulkClass, boost::bind(incrementCounter, &bulkRuns));
+      scheduler.beginTask(BulkClass, boost::bind(incrementCounter, &bulkRuns));
+      scheduler.beginTask(InteractiveClass,
+                          boost::bind(incrementCounter, &rpcRuns));
+
+      expect_true(bulkRuns == 1);
+      expect_true(rpcRuns == 1);
+   }
+}
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
@@ -27,7 +27,8 @@ RequestParser::RequestParser()
   : state_(method_start), 
     content_length_(0), 
     parsing_content_length_(false), 
-    parsing_body_(false)
+    parsing_body_(false),
+    body_bytes_streamed_(0)
 {
 }
 
@@ -37,6 +38,8 @@ void RequestParser::reset()
   content_length_ = 0 ;
   parsing_content_length_ = false ;
   parsing_body_ = false ;
+  bodyConsumer_ = BodyConsumer() ;
+  body_bytes_streamed_ = 0 ;
 }
 
 RequestParser::status RequestParser::consume(Request& req, char input)
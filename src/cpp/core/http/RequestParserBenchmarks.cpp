@@ -0,0 +1,81 @@
+/*
+ * RequestParserBenchmarks.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <benchmark/Benchmark.hpp>
+
+#include <string>
+
+#include <core/SafeConvert.hpp>
+#include <core/http/Request.hpp>
+#include <core/http/RequestParser.hpp>
+
+namespace rstudio {
+namespace core {
+namespace benchmarks {
+namespace {
+
+// a raw json-rpc POST of the shape the session receives, with a body
+// large enough that body consumption dominates header parsing
+const std::size_t kBodyBytes = 256 * 1024;
+
+const std::string& rawRequestFixture()
+{
+   static std::string s_request;
+   if (s_request.empty())
+   {
+      std::string body = "{\"method\":\"save_document\",\"params\":[\"";
+      body += std::string(kBodyBytes, 'x');
+      body += "\"]}";
+
+      s_request =
+         "POST /rpc/save_document HTTP/1.1\r\n"
+         "Host: localhost:8787\r\n"
+         "Accept: application/json\r\n"
+         "Accept-Encoding: gzip, deflate\r\n"
+         "Content-Type: application/json\r\n"
+         "Cookie: user-id=benchmark|Thu%2C%2001%20Jan%202026; "
+            "csrf-token=00112233445566778899aabbccddeeff\r\n"
+         "Content-Length: " +
+            safe_convert::numberToString(body.size()) + "\r\n"
+         "\r\n" +
+         body;
+   }
+   return s_request;
+}
+
+} // anonymous namespace
+
+BENCHMARK(benchmarkRequestParser)
+{
+   const std::string& rawRequest = rawRequestFixture();
+   state.setBytesPerIteration(rawRequest.size());
+
+   while (state.keepRunning())
+   {
+      http::RequestParser parser;
+      http::Request request;
+      http::RequestParser::status status = parser.parse(
+                                       request,
+                                       rawRequest.data(),
+                                       rawRequest.data() + rawRequest.size());
+      benchmark::doNotOptimize(status);
+      if (status != http::RequestParser::complete)
+         return;
+   }
+}
+
+} // namespace benchmarks
+} // namespace core
+} // namespace rstudio
@@ -29,6 +29,7 @@
 #include <core/http/Cookie.hpp>
 #include <core/Hash.hpp>
 #include <core/RegexUtils.hpp>
+#include <core/system/MemoryMappedFile.hpp>
 
 #include <core/FileSerializer.hpp>
 
@@ -189,6 +190,95 @@ void Response::setDynamicHtml(const std::string& html,
    setBody(html);
 }
 
+void Response::setMemoryMappedFile(const FilePath& filePath,
+                                   const Request& request)
+{
+   // ensure that the file exists
+   if (!filePath.exists())
+   {
+      setNotFoundError(request.uri());
+      return;
+   }
+
+   // attempt to map the file -- if this fails for any reason (e.g. a
+   // filesystem which doesn't support mapping) then fall back to the
+   // conventional streaming path
+   boost::shared_ptr<system::MemoryMappedFile> pMappedFile(
+                                          new system::MemoryMappedFile());
+   Error error = pMappedFile->open(filePath);
+   if (error)
+   {
+      LOG_ERROR(error);
+      setFile(filePath, request);
+      return;
+   }
+
+   // set content type
+   setContentType(filePath.mimeContentType());
+
+   // mapped bytes are written as-is so make sure no stale encoding
+   // header is carried over
+   removeHeader("Content-Encoding");
+
+   // advertise byte range support (the mapping makes serving an
+   // arbitrary sub-range free)
+   addHeader("Accept-Ranges", "bytes");
+
+   // honor a range request against the mapped pages
+   std::string range = request.headerValue("Range");
+   if (!range.empty())
+   {
+      std::size_t total = pMappedFile->size();
+
+      boost::regex re("bytes=(\\d*)\\-(\\d*)");
+      boost::smatch match;
+      if (regex_utils::match(range, match, re) && total > 0)
+      {
+         // determine the byte range
+         const std::size_t kNone = -1;
+         std::size_t begin = safe_convert::stringTo<std::size_t>(match[1],
+                                                                 kNone);
+         std::size_t end = safe_convert::stringTo<std::size_t>(match[2],
+                                                               kNone);
+         if (end == kNone)
+         {
+            end = total-1;
+         }
+         if (begin == kNone)
+         {
+            begin = total - end;
+            end = total-1;
+         }
+
+         if (begin <= end && end < total)
+         {
+            // specify partial content
+            setStatusCode(http::status::PartialContent);
+            boost::format fmt("bytes %1%-%2%/%3%");
+            addHeader("Content-Range", boost::str(fmt % begin % end % total));
+
+            // serve the requested span directly from the mapping
+            addBodyBuffer(static_cast<const char*>(pMappedFile->data()) + begin,
+                          end - begin + 1,
+                          pMappedFile);
+            return;
+         }
+      }
+
+      // unparseable or unsatisfiable range
+      setStatusCode(http::status::RangeNotSatisfiable);
+      boost::format fmt("bytes */%1%");
+      addHeader("Content-Range", boost::str(fmt % total));
+      return;
+   }
+
+   // attach the mapping (which stays alive as long as the response does)
+   if (pMappedFile->size() > 0)
+      addBodyBuffer(pMappedFile->data(), pMappedFile->size(), pMappedFile);
+   else
+      setContentLength(0);
+}
+
 void Response::setRangeableFile(const FilePath& filePath,
                                 const Request& request)
 {
@@ -261,6 +351,19 @@ void Response::setRangeableFile(const std::string& contents,
    }
 }
    
+void Response::addBodyBuffer(const boost::shared_ptr<std::string>& content)
+{
+   addBodyBuffer(content->data(), content->length(), content);
+}
+
+void Response::addBodyBuffer(const void* data,
+                             std::size_t length,
+                             const boost::shared_ptr<void>& keepAlive)
+{
+   bodyBuffers_.push_back(BodyBuffer(data, length, keepAlive));
+   setContentLength(static_cast<int>(bodyLength()));
+}
+
 void Response::setBodyUnencoded(const std::string& body)
 {
    removeHeader("Content-Encoding");
@@ -338,8 +441,8 @@ void Response::removeCachingHeaders()
    
 std::string Response::eTagForContent(const std::string& content)
 {
-   return core::hash::crc32Hash(content);
-}   
+   return core::hash::fastHash(content);
+}
 
 void Response::appendFirstLineBuffers(
       std::vector<boost::asio::const_buffer>& buffers) const 
@@ -376,6 +479,7 @@ namespace Message {
 	const char * const NotFound = "Not Found" ;
 	const char * const MethodNotAllowed = "Method Not Allowed" ;
    const char * const RangeNotSatisfiable = "Range Not Satisfyable";
+   const char * const TooManyRequests = "Too Many Requests";
 	const char * const InternalServerError = "Internal Server Error" ;
 	const char * const NotImplemented = "Not Implemented" ;
 	const char * const BadGateway = "Bad Gateway" ;
@@ -451,6 +555,10 @@ void Response::ensureStatusMessage() const
 
          case RangeNotSatisfiable:
             statusMessage_ = status::Message::RangeNotSatisfiable;
+            break;
+
+         case TooManyRequests:
+            statusMessage_ = status::Message::TooManyRequests;
             break;
 
 			case InternalServerError:
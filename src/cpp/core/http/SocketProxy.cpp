@@ -41,10 +41,44 @@ namespace rstudio {
 namespace core {
 namespace http {
 
+namespace {
+
+// shared arena of proxy read buffers -- proxied app connections (e.g.
+// shiny apps in the viewer pane) churn quickly, so recycle buffers
+// rather than allocating a fresh pair per connection
+BufferPool& proxyBufferPool()
+{
+   static BufferPool instance(8192, 128);
+   return instance;
+}
+
+} // anonymous namespace
+
+SocketProxy::SocketProxy(boost::shared_ptr<core::http::Socket> ptrClient,
+                         boost::shared_ptr<core::http::Socket> ptrServer)
+   : ptrClient_(ptrClient),
+     ptrServer_(ptrServer),
+     clientBuffer_(proxyBufferPool().acquire()),
+     serverBuffer_(proxyBufferPool().acquire())
+{
+}
+
+SocketProxy::~SocketProxy()
+{
+   try
+   {
+      proxyBufferPool().release(clientBuffer_);
+      proxyBufferPool().release(serverBuffer_);
+   }
+   catch(...)
+   {
+   }
+}
+
 void SocketProxy::readClient()
 {
    ptrClient_->asyncReadSome(
-        boost::asio::buffer(clientBuffer_),
+        boost::asio::buffer(clientBuffer_->data(), clientBuffer_->size()),
          boost::bind(
             &SocketProxy::handleClientRead,
             SocketProxy::shared_from_this(),
@@ -55,7 +89,7 @@ void SocketProxy::readClient()
 void SocketProxy::readServer()
 {
    ptrServer_->asyncReadSome(
-        boost::asio::buffer(serverBuffer_),
+        boost::asio::buffer(serverBuffer_->data(), serverBuffer_->size()),
          boost::bind(
             &SocketProxy::handleServerRead,
             SocketProxy::shared_from_this(),
@@ -75,7 +109,7 @@ void SocketProxy::handleClientRead(const boost::system::error_code& e,
       if (!e)
       {
          std::vector<boost::asio::const_buffer> buffers;
-         buffers.push_back(boost::asio::buffer(clientBuffer_.data(),
+         buffers.push_back(boost::asio::buffer(clientBuffer_->data(),
                                                bytesTransferred));
          ptrServer_->asyncWrite(buffers,
                                 boost::bind(
@@ -100,7 +134,7 @@ void SocketProxy::handleServerRead(const boost::system::error_code& e,
       if (!e)
       {
          std::vector<boost::asio::const_buffer> buffers;
-         buffers.push_back(boost::asio::buffer(serverBuffer_.data(),
+         buffers.push_back(boost::asio::buffer(serverBuffer_->data(),
                                                bytesTransferred));
          ptrClient_->asyncWrite(buffers,
                                 boost::bind(
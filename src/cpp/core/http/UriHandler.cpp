@@ -73,25 +73,94 @@ void UriHandler::operator()(const Request& request,
    function_(request, cont);
 }
    
-void UriHandlers::add(const UriHandler& handler) 
+void UriHandlers::add(const UriHandler& handler)
 {
    uriHandlers_.push_back(handler);
+
+   // insert the prefix into the tree
+   if (!root_)
+      root_.reset(new PrefixTreeNode());
+
+   boost::shared_ptr<PrefixTreeNode> pNode = root_;
+   const std::string& prefix = handler.prefix();
+   for (std::string::const_iterator it = prefix.begin();
+        it != prefix.end();
+        ++it)
+   {
+      boost::shared_ptr<PrefixTreeNode>& pChild = pNode->children[*it];
+      if (!pChild)
+         pChild.reset(new PrefixTreeNode());
+      pNode = pChild;
+   }
+
+   // first registration of a given prefix wins (identical to the
+   // behavior of scanning the handler list in registration order)
+   if (pNode->handlerIndex == -1)
+      pNode->handlerIndex = static_cast<int>(uriHandlers_.size()) - 1;
+}
+
+void UriHandlers::replace(const UriHandler& handler)
+{
+   // locate the tree node for the exact prefix (if it exists)
+   if (root_)
+   {
+      boost::shared_ptr<PrefixTreeNode> pNode = root_;
+      const std::string& prefix = handler.prefix();
+      std::string::const_iterator it = prefix.begin();
+      for ( ; it != prefix.end(); ++it)
+      {
+         std::map<char, boost::shared_ptr<PrefixTreeNode> >::const_iterator
+               childIt = pNode->children.find(*it);
+         if (childIt == pNode->children.end())
+            break;
+         pNode = childIt->second;
+      }
+
+      if (it == prefix.end() && pNode->handlerIndex != -1)
+      {
+         uriHandlers_[pNode->handlerIndex] = handler;
+         return;
+      }
+   }
+
+   add(handler);
 }
 
 UriAsyncHandlerFunction UriHandlers::handlerFor(const std::string& uri) const
 {
-   std::vector<UriHandler>::const_iterator handler = std::find_if(
-                              uriHandlers_.begin(), 
-                              uriHandlers_.end(), 
-                              boost::bind(&UriHandler::matches, _1, uri));
-   if ( handler != uriHandlers_.end() )
+   if (!root_)
+      return UriAsyncHandlerFunction();
+
+   // walk the tree along the uri collecting every registered prefix we
+   // pass through, keeping the earliest-registered match (which is what
+   // a linear scan of the handler list would have returned)
+   int matchIndex = -1;
+   boost::shared_ptr<PrefixTreeNode> pNode = root_;
+   std::string::const_iterator it = uri.begin();
+   while (true)
    {
-      return handler->function();
+      if (pNode->handlerIndex != -1 &&
+          (matchIndex == -1 || pNode->handlerIndex < matchIndex))
+      {
+         matchIndex = pNode->handlerIndex;
+      }
+
+      if (it == uri.end())
+         break;
+
+      std::map<char, boost::shared_ptr<PrefixTreeNode> >::const_iterator
+            childIt = pNode->children.find(*it);
+      if (childIt == pNode->children.end())
+         break;
+
+      pNode = childIt->second;
+      ++it;
    }
+
+   if (matchIndex != -1)
+      return uriHandlers_[matchIndex].function();
    else
-   {
       return UriAsyncHandlerFunction();
-   }
 }
    
 } // namespace http
@@ -0,0 +1,100 @@
+/*
+ * UriHandlerTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+
+#include <boost/bind.hpp>
+
+#include <core/http/UriHandler.hpp>
+#include <core/http/Request.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+namespace {
+
+void taggingHandler(std::string tag, const Request& request,
+                    Response* pResponse)
+{
+   pResponse->setStatusMessage(tag);
+}
+
+UriHandlerFunction tagged(const std::string& tag)
+{
+   return boost::bind(taggingHandler, tag, _1, _2);
+}
+
+void captureTag(std::string* pTag, Response* pResponse)
+{
+   *pTag = pResponse->statusMessage();
+}
+
+std::string handlerTagFor(const UriHandlers& handlers, const std::string& uri)
+{
+   UriAsyncHandlerFunction handler = handlers.handlerFor(uri);
+   if (!handler)
+      return std::string();
+
+   Request request;
+   std::string tag;
+   handler(request, boost::bind(captureTag, &tag, _1));
+   return tag;
+}
+
+} // anonymous namespace
+
+context("Uri handler routing")
+{
+   test_that("Longest path isn't preferred over registration order")
+   {
+      UriHandlers handlers;
+      handlers.add(UriHandler("/foo", tagged("foo")));
+      handlers.add(UriHandler("/foo/bar", tagged("foobar")));
+
+      expect_true(handlerTagFor(handlers, "/foo/bar/baz") == "foo");
+   }
+
+   test_that("Prefix matching works as expected")
+   {
+      UriHandlers handlers;
+      handlers.add(UriHandler("/help/", tagged("help")));
+      handlers.add(UriHandler("/content", tagged("content")));
+
+      expect_true(handlerTagFor(handlers, "/help/index.html") == "help");
+      expect_true(handlerTagFor(handlers, "/content?id=1") == "content");
+      expect_true(handlerTagFor(handlers, "/helper") == "");
+      expect_true(handlerTagFor(handlers, "/other") == "");
+   }
+
+   test_that("Exact prefix match is honored")
+   {
+      UriHandlers handlers;
+      handlers.add(UriHandler("/rpc/", tagged("rpc")));
+
+      expect_true(handlerTagFor(handlers, "/rpc/") == "rpc");
+      expect_true(handlerTagFor(handlers, "/rpc") == "");
+   }
+
+   test_that("Empty handler set matches nothing")
+   {
+      UriHandlers handlers;
+      expect_true(!handlers.handlerFor("/anything"));
+   }
+}
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
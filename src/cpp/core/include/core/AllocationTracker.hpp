@@ -0,0 +1,90 @@
+/*
+ * AllocationTracker.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_ALLOCATION_TRACKER_HPP
+#define CORE_ALLOCATION_TRACKER_HPP
+
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/utility.hpp>
+
+namespace rstudio {
+namespace core {
+namespace allocation {
+
+// opt-in heap allocation tracker. when enabled, the global operator
+// new/delete replacements (defined in AllocationTracker.cpp) sample one
+// in every N allocations and attribute it to the module tagged on the
+// calling thread via Scope, so that resident-size growth can be broken
+// down by subsystem on a live process. when disabled -- the default --
+// the interposed operators cost a single predictable branch, so linking
+// the tracker into every binary that links core is safe. tracking is
+// not available on Windows (the operators are not replaced there)
+
+// begin tracking, attributing one of every sampleRate allocations.
+// enabling resets any counters from a previous tracking run. returns
+// false if tracking is not supported on this platform
+bool enable(int sampleRate = 64);
+
+// stop tracking. counters retain their last values so a final breakdown
+// can still be read; live estimates go stale from this point (frees are
+// no longer observed)
+void disable();
+
+bool isEnabled();
+
+// tag allocations made on the calling thread while in scope. the module
+// name must be a string literal (it is retained by pointer). scopes
+// nest; the previous tag is restored on destruction
+class Scope : boost::noncopyable
+{
+public:
+   explicit Scope(const char* moduleName);
+   ~Scope();
+
+private:
+   int previousIndex_;
+};
+
+// estimated per-module allocation activity, scaled up from the sampled
+// counts by the sample rate. untagged allocations report as "untagged"
+struct ModuleStats
+{
+   ModuleStats()
+      : liveAllocations(0), liveBytes(0),
+        totalAllocations(0), totalBytes(0)
+   {
+   }
+
+   std::string module;
+   boost::uint64_t liveAllocations;
+   boost::uint64_t liveBytes;
+   boost::uint64_t totalAllocations;
+   boost::uint64_t totalBytes;
+};
+
+std::vector<ModuleStats> stats();
+
+// render the per-module breakdown in the prometheus text exposition
+// format (empty if tracking has never been enabled)
+std::string statsAsText();
+
+} // namespace allocation
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_ALLOCATION_TRACKER_HPP
@@ -0,0 +1,90 @@
+/*
+ * AsyncLogWriter.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef ASYNC_LOG_WRITER_HPP
+#define ASYNC_LOG_WRITER_HPP
+
+#include <deque>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+#include <core/BoostThread.hpp>
+#include <core/LogWriter.hpp>
+
+namespace rstudio {
+namespace core {
+
+// decorates another LogWriter so that log calls just enqueue the entry
+// and return; a dedicated writer thread drains the queue in batches and
+// performs the actual (potentially blocking) writes. useful when verbose
+// logging is enabled and the synchronous open/append/flush performed by
+// the file writer would otherwise perturb request latency.
+//
+// the queue is bounded: if the writer thread can't keep up, new entries
+// are dropped (and a single entry noting how many were dropped is
+// emitted once the queue drains) rather than blocking the logging thread
+// or growing without bound
+class AsyncLogWriter : public LogWriter, boost::noncopyable
+{
+public:
+   explicit AsyncLogWriter(boost::shared_ptr<LogWriter> pSink,
+                           std::size_t maxQueueSize = kDefaultMaxQueueSize);
+
+   // flushes any queued entries before returning
+   virtual ~AsyncLogWriter();
+
+   virtual void log(core::system::LogLevel level,
+                    const std::string& message);
+
+   virtual void log(const std::string& programIdentity,
+                    core::system::LogLevel level,
+                    const std::string& message);
+
+   virtual void setLogToStderr(bool logToStderr);
+
+private:
+   enum { kDefaultMaxQueueSize = 2048 };
+
+   struct LogEntry
+   {
+      LogEntry() : level(core::system::kLogLevelInfo) {}
+      std::string programIdentity;
+      core::system::LogLevel level;
+      std::string message;
+   };
+
+   void enqueue(const LogEntry& entry);
+   void writerThread();
+   void writeBatch(const std::deque<LogEntry>& entries,
+                   std::size_t droppedEntries);
+
+private:
+   boost::shared_ptr<LogWriter> pSink_;
+   std::size_t maxQueueSize_;
+
+   boost::mutex mutex_;
+   boost::condition_variable condition_;
+   std::deque<LogEntry> queue_;
+   std::size_t droppedEntries_;
+   bool stopRequested_;
+
+   boost::thread thread_;
+};
+
+} // namespace core
+} // namespace rstudio
+
+#endif // ASYNC_LOG_WRITER_HPP
@@ -16,6 +16,7 @@
 #ifndef CORE_SYSTEM_BASE64_HPP
 #define CORE_SYSTEM_BASE64_HPP
 
+#include <iosfwd>
 #include <string>
 
 namespace rstudio {
@@ -25,11 +26,19 @@ class Error;
 class FilePath;
 
 namespace base64 {
-      
+
+// NOTE: output is written in place as input is read, so for the buffer
+// variants the input and output must not overlap
 
 Error encode(const char* pData, std::size_t n, std::string* pOutput);
 Error encode(const std::string& input, std::string* pOutput);
+
+// streaming variants: the input is encoded through a fixed-size chunk
+// buffer and written directly to the output, so large payloads (e.g.
+// exported plot images) are never fully resident alongside a scratch
+// copy of their encoding
 Error encode(const FilePath& inputFile, std::string* pOutput);
+Error encode(std::istream& input, std::ostream& output);
 
 Error decode(const char* pData, std::size_t n, std::string* pOutput);
 Error decode(const std::string& input, std::string* pOutput);
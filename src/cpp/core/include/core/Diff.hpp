@@ -0,0 +1,52 @@
+/*
+ * Diff.hpp
+ *
+ * Copyright (C) 2009-16 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_DIFF_HPP
+#define CORE_DIFF_HPP
+
+#include <string>
+
+namespace rstudio {
+namespace core {
+namespace diff {
+
+// options controlling unified diff generation
+struct DiffOptions
+{
+   DiffOptions()
+      : contextLines(3),
+        ignoreWhitespace(false)
+   {
+   }
+
+   // COPYING: via compiler (copyable members)
+
+   int contextLines;
+   bool ignoreWhitespace;
+};
+
+// computes a line-based unified diff (hunks only, without file headers)
+// between two texts, using a patience line matching strategy with a
+// histogram fallback for non-unique lines. returns an empty string when
+// the texts are identical.
+std::string unifiedDiff(const std::string& fromText,
+                        const std::string& toText,
+                        const DiffOptions& options);
+
+} // namespace diff
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_DIFF_HPP
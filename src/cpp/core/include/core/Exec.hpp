@@ -16,9 +16,12 @@
 #ifndef CORE_EXEC_HPP
 #define CORE_EXEC_HPP
 
+#include <string>
 #include <vector>
 
+#include <boost/cstdint.hpp>
 #include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
 
 namespace rstudio {
 namespace core {
@@ -65,9 +68,114 @@ public:
 private:
    std::vector<Function> functions_ ;
 };
-   
 
-} // namespace core 
+// variant of ExecBlock for sequences where some entries are independent
+// of one another. tasks are named and may declare prerequisites (which
+// must refer to previously declared tasks, so the graph is acyclic by
+// construction). tasks added with add() run on the calling thread in
+// declaration order -- exactly like ExecBlock -- while tasks added with
+// addConcurrent() run on a small thread pool as soon as their
+// prerequisites have completed. execute() joins the pool before
+// returning, so all tasks have finished (or been skipped due to an
+// earlier error) by the time it returns
+class ParallelExecBlock : boost::noncopyable
+{
+public:
+   typedef ExecBlock::Function Function;
+
+   // invoked after each task completes with its name and duration in
+   // microseconds (may be called from a pool thread)
+   typedef boost::function<void(const std::string&,
+                                boost::int64_t)> TaskObserver;
+
+public:
+   explicit ParallelExecBlock(std::size_t numThreads = 4)
+      : numThreads_(numThreads)
+   {
+   }
+
+   void setTaskObserver(const TaskObserver& observer)
+   {
+      observer_ = observer;
+   }
+
+   // add a task which runs on the calling thread, after all previously
+   // added calling-thread tasks (and any declared prerequisites)
+   ParallelExecBlock& add(const std::string& name, const Function& function);
+   ParallelExecBlock& add(const std::string& name,
+                          const Function& function,
+                          const std::vector<std::string>& prerequisites);
+
+   // add a task which may run on a pool thread once its prerequisites
+   // have completed
+   ParallelExecBlock& addConcurrent(const std::string& name,
+                                    const Function& function);
+   ParallelExecBlock& addConcurrent(
+                          const std::string& name,
+                          const Function& function,
+                          const std::vector<std::string>& prerequisites);
+
+   // convenience builders for prerequisite lists
+   static std::vector<std::string> dependsOn(const std::string& name);
+   static std::vector<std::string> dependsOn(const std::string& name1,
+                                             const std::string& name2);
+
+   // easy init style (mirrors ExecBlock::addFunctions)
+   class EasyInit;
+   EasyInit addFunctions() { return EasyInit(this); }
+
+   // execute all tasks; returns the first error which occurred (no new
+   // tasks are started after an error, but in-flight tasks complete)
+   core::Error execute();
+
+   core::Error operator()();
+
+public:
+   // easy init helper class (calling-thread tasks only)
+   class EasyInit
+   {
+   public:
+      EasyInit(ParallelExecBlock* pBlock) : pBlock_(pBlock) {}
+      EasyInit& operator()(const std::string& name, const Function& function)
+      {
+         pBlock_->add(name, function);
+         return *this;
+      }
+      EasyInit& operator()(const std::string& name,
+                           const Function& function,
+                           const std::vector<std::string>& prerequisites)
+      {
+         pBlock_->add(name, function, prerequisites);
+         return *this;
+      }
+   private:
+      ParallelExecBlock* pBlock_;
+   };
+
+private:
+   struct Task
+   {
+      Task() : concurrent(false) {}
+
+      std::string name;
+      Function function;
+      bool concurrent;
+      std::vector<std::string> prerequisites;
+   };
+
+   ParallelExecBlock& addTask(const std::string& name,
+                              const Function& function,
+                              bool concurrent,
+                              const std::vector<std::string>& prerequisites);
+
+private:
+   std::size_t numThreads_;
+   TaskObserver observer_;
+   std::vector<Task> tasks_;
+};
+
+
+} // namespace core
 } // namespace rstudio
 
 #endif // CORE_EXEC_HPP
@@ -23,6 +23,8 @@
 #include <string>
 #include <iosfwd>
 
+#include <boost/shared_ptr.hpp>
+
 #include <core/FilePath.hpp>
 
 // TODO: satisfy outselves that it is safe to query for symlink status
@@ -35,9 +37,8 @@ class FileInfo
 {
 public:
    FileInfo()
-      : absolutePath_(), 
-        isDirectory_(false), 
-        size_(0), 
+      : isDirectory_(false),
+        size_(0),
         lastWriteTime_(0)
    {
    }
@@ -71,32 +72,61 @@ public:
    // COPYING: via compliler (copyable members)
 
 public:
-   bool empty() const { return absolutePath_.empty(); }
-   
+   bool empty() const { return !directory_ && name_.empty(); }
+
    // NOTE: because symlink status is optional, it is NOT taken
    // into account for equality tests
    bool operator==(const FileInfo& other) const
    {
-      return absolutePath_ == other.absolutePath_ &&
+      return name_ == other.name_ &&
+             directoryEquals(other) &&
              isDirectory_ == other.isDirectory_ &&
              size_ == other.size_ &&
              lastWriteTime_ == other.lastWriteTime_;
    }
-   
+
    bool operator!=(const FileInfo& other) const
    {
-      return !(*this == other); 
+      return !(*this == other);
    }
-   
+
 public:
-   std::string absolutePath() const { return absolutePath_.c_str(); }
+   std::string absolutePath() const
+   {
+      if (!directory_)
+         return name_;
+
+      std::string path;
+      path.reserve(directory_->size() + name_.size());
+      path.append(*directory_);
+      path.append(name_);
+      return path;
+   }
    bool isDirectory() const { return isDirectory_; }
    uintmax_t size() const { return size_; }
    std::time_t lastWriteTime() const { return lastWriteTime_; }
    bool isSymlink() const { return isSymlink_; }
-   
+
+private:
+   // paths are stored as an interned directory prefix plus a leaf name --
+   // the many FileInfo objects produced by scanning a tree then share a
+   // single copy of each directory prefix rather than duplicating it per
+   // file (see initFromPath)
+   void initFromPath(const std::string& absolutePath);
+
+   bool directoryEquals(const FileInfo& other) const
+   {
+      if (directory_ == other.directory_)
+         return true;
+      else if (!directory_ || !other.directory_)
+         return false;
+      else
+         return *directory_ == *other.directory_;
+   }
+
 private:
-   std::string absolutePath_;
+   boost::shared_ptr<const std::string> directory_;
+   std::string name_;
    bool isDirectory_;
    uintmax_t size_;
    std::time_t lastWriteTime_;
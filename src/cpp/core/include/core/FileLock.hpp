@@ -39,7 +39,7 @@ class FileLock : boost::noncopyable
 {
 public:
    
-   enum LockType { LOCKTYPE_ADVISORY, LOCKTYPE_LINKBASED };
+   enum LockType { LOCKTYPE_ADVISORY, LOCKTYPE_LINKBASED, LOCKTYPE_AUTO };
    
    // initialize (read configuration)
    static void initialize(FilePath locksConfPath = FilePath());
@@ -56,6 +56,10 @@ public:
    static void refresh();
    static void refreshPeriodically(boost::asio::io_service& service,
                                    boost::posix_time::seconds interval = s_refreshRate);
+
+   // variant of 'refreshPeriodically()' which renews leases from a
+   // dedicated background thread (for processes without an io_service)
+   static void refreshPeriodically();
    
    // sub-classes implement locking semantics
    virtual Error acquire(const FilePath& lockFilePath) = 0;
@@ -141,6 +145,25 @@ private:
    boost::scoped_ptr<Impl> pImpl_;
 };
 
+// resolves (per lock file) to an advisory lock on local filesystems --
+// where kernel locks are cheap and reliable -- and to the link-based
+// protocol on NFS; filesystem detection is cached per directory
+class AutoFileLock : public FileLock
+{
+public:
+   Error acquire(const FilePath& lockFilePath);
+   Error release();
+   bool isLocked(const FilePath& lockFilePath) const;
+   FilePath lockFilePath() const;
+
+   AutoFileLock();
+   ~AutoFileLock();
+
+private:
+   struct Impl;
+   boost::scoped_ptr<Impl> pImpl_;
+};
+
 // ScopedFileLock for acquiring a lock on construction
 // and ensuring the lock is released on destruction
 class ScopedFileLock : boost::noncopyable
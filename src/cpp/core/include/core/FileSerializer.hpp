@@ -16,6 +16,8 @@
 #ifndef CORE_FILE_SERIALIZER_HPP
 #define CORE_FILE_SERIALIZER_HPP
 
+#include <cctype>
+#include <cstring>
 #include <string>
 #include <map>
 #include <iterator>
@@ -33,6 +35,8 @@
 #include <core/FilePath.hpp>
 #include <core/StringUtils.hpp>
 
+#include <core/system/MemoryMappedFile.hpp>
+
 namespace rstudio {
 namespace core {
 
@@ -54,16 +58,34 @@ Error writeCollectionToFile(
 
    try
    {
-      // write each line
+      // accumulate lines and write them in large batches (a flushed
+      // write per line is prohibitively slow for large collections)
+      const std::size_t kWriteBufferSize = 64 * 1024;
+      std::string buffer;
+      buffer.reserve(kWriteBufferSize);
       for (typename CollectionType::const_iterator
             it = collection.begin();
             it != collection.end();
             ++it)
       {
-         *pOfs << stringifyFunction(*it) << std::endl ;
+         buffer.append(stringifyFunction(*it));
+         buffer.push_back('\n');
 
-        if (pOfs->fail())
-             return systemError(io_error, ERROR_LOCATION);
+         if (buffer.size() >= kWriteBufferSize)
+         {
+            pOfs->write(buffer.data(), buffer.size());
+            if (pOfs->fail())
+               return systemError(io_error, ERROR_LOCATION);
+            buffer.clear();
+         }
+      }
+
+      // write any remainder
+      if (!buffer.empty())
+      {
+         pOfs->write(buffer.data(), buffer.size());
+         if (pOfs->fail())
+            return systemError(io_error, ERROR_LOCATION);
       }
    }
    catch(const std::exception& e)
@@ -95,16 +117,83 @@ Error readCollectionFromFile(
                          bool trimAndIgnoreBlankLines=true)
 {
    using namespace boost::system::errc ;
-   
-   // open the file stream
+
+   // create insert iterator
+   std::insert_iterator<CollectionType> insertIterator(*pCollection,
+                                                       pCollection->begin());
+
+   // fast path: map the file and scan lines in place (avoids stream
+   // overhead and a heap allocation per line -- large collections like
+   // console history are read at session startup)
+   core::system::MemoryMappedFile mappedFile;
+   if (!mappedFile.open(filePath))
+   {
+      try
+      {
+         const char* pData = static_cast<const char*>(mappedFile.data());
+         const char* pEnd = pData + mappedFile.size();
+         std::string nextLine;
+         while (pData < pEnd)
+         {
+            // locate the end of the line (as with the stream path below,
+            // a trailing line with no newline terminator is discarded)
+            const char* pEOL = static_cast<const char*>(
+                                 std::memchr(pData, '\n', pEnd - pData));
+            if (pEOL == NULL)
+               break;
+            const char* pBegin = pData;
+            const char* pLineEnd = pEOL;
+            pData = pEOL + 1;
+
+            // trim whitespace in place then skip it if it is a blank line
+            if (trimAndIgnoreBlankLines)
+            {
+               while (pBegin < pLineEnd &&
+                      std::isspace(static_cast<unsigned char>(*pBegin)))
+                  pBegin++;
+               while (pLineEnd > pBegin &&
+                      std::isspace(static_cast<unsigned char>(*(pLineEnd-1))))
+                  pLineEnd--;
+               if (pBegin == pLineEnd)
+                  continue;
+            }
+
+            // parse it and add it to the collection (reuse the line
+            // buffer across iterations)
+            nextLine.assign(pBegin, pLineEnd - pBegin);
+            typename CollectionType::value_type value ;
+            ReadCollectionAction action = parseFunction(nextLine, &value);
+            if (action == ReadCollectionAddLine)
+            {
+               *insertIterator++ = value ;
+            }
+            else if (action == ReadCollectionIgnoreLine)
+            {
+               // do nothing
+            }
+            else if (action == ReadCollectionTerminate)
+            {
+               break; // exit read loop
+            }
+         }
+
+         return Success() ;
+      }
+      catch(const std::exception& e)
+      {
+         Error error = systemError(boost::system::errc::io_error,
+                                   ERROR_LOCATION);
+         error.addProperty("what", e.what());
+         error.addProperty("path", filePath.absolutePath());
+         return error;
+      }
+   }
+
+   // fallback: open the file stream
    boost::shared_ptr<std::istream> pIfs;
    Error error = filePath.open_r(&pIfs);
    if (error)
       return error;
-   
-   // create insert iterator
-   std::insert_iterator<CollectionType> insertIterator(*pCollection, 
-                                                       pCollection->begin());
 
    try
    {
@@ -40,6 +40,15 @@ bool isWindowsReservedName(const std::string& name);
 Error copyDirectory(const FilePath& sourceDirectory,
                     const FilePath& targetDirectory);
 
+// variants which distribute a directory's top-level subtrees across a
+// small pool of worker threads. parallelism buys little on a local disk
+// but substantially overlaps round trips on network file systems when
+// operating on large trees
+Error copyDirectoryParallel(const FilePath& sourceDirectory,
+                            const FilePath& targetDirectory);
+
+Error removeParallel(const FilePath& filePath);
+
 } // namespace file_utils
 } // namespace core
 } // namespace rstudio
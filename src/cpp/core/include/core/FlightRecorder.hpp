@@ -0,0 +1,43 @@
+/*
+ * FlightRecorder.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_FLIGHT_RECORDER_HPP
+#define CORE_FLIGHT_RECORDER_HPP
+
+#include <string>
+
+namespace rstudio {
+namespace core {
+namespace flight_recorder {
+
+// always-on in-process flight recorder. timestamped events are written
+// into a fixed-size lock-free ring buffer so recording costs an atomic
+// increment and a bounded copy -- cheap enough to leave on in
+// production. when something goes wrong the most recent entries can be
+// dumped to see what the process was doing right before the problem.
+//
+// the event string must have static storage duration (only the pointer
+// is recorded); the detail string is copied (and truncated to a bounded
+// length)
+void record(const char* event, const std::string& detail = std::string());
+
+// the most recent entries, oldest first, one formatted line per entry
+std::string contents();
+
+} // namespace flight_recorder
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_FLIGHT_RECORDER_HPP
@@ -26,6 +26,17 @@ std::string crc32Hash(const std::string& content);
 
 std::string crc32HexHash(const std::string& content);
 
+// fast non-cryptographic 64-bit hash suitable for change detection and
+// ETag generation (never use it where an adversary controls the input).
+// processes 8 bytes per round and uses the SSE4.2 CRC32 instruction when
+// the processor supports it (selected at runtime), so it is considerably
+// faster than crc32Hash on large content. because the implementation is
+// selected per-machine, hash values must not be persisted and compared
+// across machines
+std::string fastHash(const std::string& content);
+
+std::string fastHexHash(const std::string& content);
+
 } // namespace hash
 } // namespace core 
 } // namespace rstudio
@@ -49,6 +49,7 @@ public:
 public:
    virtual void execute()
    {
+      executedLast_ = !finished_;
       executeUntil(now() + incrementalDuration_);
    }
 
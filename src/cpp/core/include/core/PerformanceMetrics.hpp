@@ -0,0 +1,52 @@
+/*
+ * PerformanceMetrics.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_PERFORMANCE_METRICS_HPP
+#define CORE_PERFORMANCE_METRICS_HPP
+
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+namespace rstudio {
+namespace core {
+namespace performance {
+
+// in-process latency histograms. durations are recorded by name into
+// logarithmically spaced buckets (in the style of HDR histograms) so
+// that recording is a bounded amount of arithmetic with no allocation,
+// and the full latency distribution -- not just an average -- can be
+// scraped while the process runs. histograms are created on first
+// record, so instrumentation points don't require registration
+
+void recordDuration(const std::string& name,
+                    const boost::posix_time::time_duration& duration);
+
+// monotonically increasing event counters, exported alongside the
+// histograms (name counters with a _total suffix per the prometheus
+// conventions)
+void incrementCounter(const std::string& name);
+void incrementCounterBy(const std::string& name, boost::uint64_t value);
+
+// render all histograms in the prometheus text exposition format
+// (durations are exported in seconds)
+std::string metricsAsText();
+
+} // namespace performance
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_PERFORMANCE_METRICS_HPP
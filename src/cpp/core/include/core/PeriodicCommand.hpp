@@ -34,7 +34,7 @@ public:
       if (immediate)
          nextExecutionTime_ = now();
       else
-         nextExecutionTime_ = now() + period_;
+         nextExecutionTime_ = alignToTick(now() + period_);
 
    }
 
@@ -45,11 +45,12 @@ public:
 public:
    virtual void execute()
    {
-      if (now() > nextExecutionTime_)
+      executedLast_ = now() > nextExecutionTime_;
+      if (executedLast_)
       {
          if (execute_())
          {
-            nextExecutionTime_ = now() + period_;
+            nextExecutionTime_ = alignToTick(now() + period_);
          }
          else
          {
@@ -63,6 +64,23 @@ public:
       return period_;
    }
 
+private:
+   // align wakeups to shared quarter-second ticks so commands created
+   // at uncorrelated times (but with similar periods) become due in the
+   // same polling pass rather than each waking the process separately
+   boost::posix_time::ptime alignToTick(
+                              const boost::posix_time::ptime& time) const
+   {
+      const long tickMs = 250;
+      if (period_.total_milliseconds() < tickMs)
+         return time;
+
+      long ms = time.time_of_day().total_milliseconds() % tickMs;
+      if (ms == 0)
+         return time;
+      return time + boost::posix_time::milliseconds(tickMs - ms);
+   }
+
 private:
    const boost::posix_time::time_duration period_;
    boost::posix_time::ptime nextExecutionTime_;
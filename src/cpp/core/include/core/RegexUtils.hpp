@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 
+#include <boost/function.hpp>
 #include <boost/regex.hpp>
 #include <boost/iostreams/filter/regex.hpp>
 
@@ -47,6 +48,50 @@ bool textMatches(const std::string& text,
                  bool prefixOnly,
                  bool caseSensitive);
 
+// extract the longest literal string which must appear in any match of
+// the given pattern. the extraction is conservative (escapes, grouped
+// and bracketed expressions are treated as opaque, and alternation
+// yields an empty result) so the literal is usable with any regex
+// flavor as a cheap memmem-style prefilter which rejects most input
+// before the regex engine runs
+std::string requiredLiteral(const std::string& pattern);
+
+// a single matching line produced by searchLines
+struct LineMatch
+{
+   LineMatch() : lineNumber(0) {}
+   int lineNumber;
+   std::string line;                    // line contents (sans newline)
+   std::vector<std::size_t> matchOn;    // byte offsets within line
+   std::vector<std::size_t> matchOff;
+};
+
+// callback invoked for each matching line (return false to stop)
+typedef boost::function<bool(const LineMatch&)> LineMatchHandler;
+
+// search text line by line, streaming each matching line (with the
+// offsets of every match on it) to onMatch. when literal is non-empty
+// (typically from requiredLiteral above) the text is cheaply scanned
+// for it before the regex runs at all, and when timeBudgetMs > 0 the
+// search gives up once the budget elapses -- boost::regex backtracking
+// on large inputs can otherwise freeze the session for good. returns
+// true if the entire text was searched, false if the search stopped
+// early (budget exceeded or the handler returned false)
+bool searchLines(const char* pBegin,
+                 const char* pEnd,
+                 const boost::regex& pattern,
+                 const std::string& literal,
+                 bool ignoreCase,
+                 int timeBudgetMs,
+                 const LineMatchHandler& onMatch);
+
+bool searchLines(const std::string& text,
+                 const boost::regex& pattern,
+                 const std::string& literal,
+                 bool ignoreCase,
+                 int timeBudgetMs,
+                 const LineMatchHandler& onMatch);
+
 core::Error filterString(
                 const std::string& input,
                 const std::vector<boost::iostreams::regex_filter>& filters,
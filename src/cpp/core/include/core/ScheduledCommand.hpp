@@ -32,7 +32,7 @@ class ScheduledCommand : boost::noncopyable
 {
 public:
    explicit ScheduledCommand(const boost::function<bool()>& execute)
-      : execute_(execute), finished_(false)
+      : execute_(execute), finished_(false), executedLast_(false)
    {
    }
 
@@ -45,9 +45,14 @@ public:
 
    bool finished() const { return finished_; }
 
+   // did the most recent call to execute() actually run the command
+   // (rather than e.g. determine that its period hadn't yet elapsed)?
+   bool executedLast() const { return executedLast_; }
+
 protected:
    boost::function<bool()> execute_;
    bool finished_;
+   bool executedLast_;
 
 protected:
    static boost::posix_time::ptime now()
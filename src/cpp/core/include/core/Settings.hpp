@@ -22,6 +22,7 @@
 #include <boost/utility.hpp>
 #include <boost/function.hpp>
 
+#include <core/BoostThread.hpp>
 #include <core/FilePath.hpp>
 
 namespace rstudio {
@@ -57,14 +58,38 @@ public:
    void beginUpdate();
    void endUpdate();
 
+   // write changes from a background thread, coalescing bursts of set()
+   // calls into a single write performed once the settings have been
+   // quiet for debounceMillis. note that writes always go to a temp file
+   // which is then renamed into place, so an ill-timed crash can't leave
+   // a partially written settings file behind
+   void enableDelayedWrites(int debounceMillis = 250);
+
+   // synchronously write any pending delayed changes (no-op if there
+   // are none or delayed writes aren't enabled)
+   void flush();
+
 private:
    void writeSettings() ;
+   void writeSettingsFile(
+               const std::map<std::string,std::string>& settingsMap) const;
+   void flushThread();
 
 private:
    FilePath settingsFile_ ;
    std::map<std::string, std::string> settingsMap_ ;
    bool updatePending_ ;
    bool isDirty_;
+
+   // delayed write state (mutex_ guards settingsMap_ and isDirty_
+   // against the flush thread once delayed writes are enabled)
+   bool delayedWrites_;
+   int debounceMillis_;
+   bool stopRequested_;
+   boost::system_time lastChangeTime_;
+   boost::mutex mutex_;
+   boost::condition_variable condition_;
+   boost::thread thread_;
 };
 
 }
@@ -75,6 +75,12 @@ bool subsequenceIndices(std::string const& sequence,
 
 std::string getExtension(std::string const& str);
 
+// returns true if the string contains only 7-bit ASCII characters (in
+// which case it is valid UTF-8 as-is and conversions can skip
+// transcoding entirely)
+bool isAsciiOnly(const std::string& value);
+bool isAsciiOnly(const std::wstring& value);
+
 std::string utf8ToSystem(const std::string& str,
                          bool escapeInvalidChars=false);
 
@@ -0,0 +1,44 @@
+/*
+ * ZipWriter.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_ZIP_WRITER_HPP
+#define CORE_ZIP_WRITER_HPP
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace rstudio {
+namespace core {
+
+class Error;
+class FilePath;
+
+namespace zip {
+
+// write a zip archive to the stream containing the specified files
+// (paths relative to parentPath; directories are expanded recursively).
+// entries are deflated in process and written as they are produced, so
+// no temp file or external zip utility is required. note that zip64 is
+// not supported -- entries or archives of 4GB and beyond yield an error
+Error writeArchive(const FilePath& parentPath,
+                   const std::vector<std::string>& files,
+                   std::ostream* pOstream);
+
+} // namespace zip
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_ZIP_WRITER_HPP
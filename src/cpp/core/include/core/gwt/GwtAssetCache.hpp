@@ -0,0 +1,47 @@
+/*
+ * GwtAssetCache.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_GWT_GWT_ASSET_CACHE_HPP
+#define CORE_GWT_GWT_ASSET_CACHE_HPP
+
+namespace rstudio {
+namespace core {
+
+class FilePath;
+
+namespace http {
+   class Request;
+   class Response;
+}
+
+namespace gwt {
+
+// in-process cache of precompressed gwt assets. on first access each
+// asset is gzipped and content-hashed; subsequent requests are served
+// from memory with a strong ETag, honoring Accept-Encoding and
+// If-None-Match. entries are revalidated against the file's size and
+// last write time so a new gwt build is picked up automatically.
+//
+// serves the asset from the cache (compressing and caching it first if
+// necessary). callers remain responsible for cache-control headers
+void handleCachedAssetRequest(const FilePath& filePath,
+                              const http::Request& request,
+                              http::Response* pResponse);
+
+} // namespace gwt
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_GWT_GWT_ASSET_CACHE_HPP
@@ -33,6 +33,10 @@ namespace gwt {
 
 void initializeSymbolMaps(const core::FilePath& symbolMapsPath);
 
+// release symbol map state for permutations which haven't reported an
+// error recently (no-op if symbol maps weren't initialized)
+void evictIdleSymbolMaps();
+
 void handleLogRequest(const std::string& username,
                       const http::Request& request, 
                       http::Response* pResponse);
@@ -54,6 +54,10 @@ public:
    StackElement resymbolize(const StackElement& se,
                             const std::string& strongName);
 
+   // release symbol map state for permutations which haven't resolved
+   // a trace recently (suitable for calling from a periodic task)
+   void evictIdle();
+
 private:
    struct Impl;
    boost::scoped_ptr<Impl> pImpl_;
@@ -94,6 +94,10 @@ public:
         connectionRetryContext_(ioService),
         logToStderr_(logToStderr),
         chunkedEncoding_(false),
+        reuseConnection_(false),
+        bytesExpected_(0),
+        lengthKnown_(false),
+        responseComplete_(false),
         closed_(false)
    {
    }
@@ -113,6 +117,20 @@ public:
       connectionRetryContext_.profile = connectionRetryProfile;
    }
 
+   // request that the connection be kept open after the response so it
+   // can be reused for a subsequent request. the request is then sent
+   // without a Connection: close override, and when a response completes
+   // cleanly with a known length (Content-Length or chunked) the socket
+   // is left open and the supplied handler is invoked so the owner can
+   // return the client to a pool. responses whose end is signalled by
+   // connection close still close as usual. must be called before execute
+   virtual void enableConnectionReuse(
+                        const boost::function<void()>& connectionReusable)
+   {
+      reuseConnection_ = true;
+      connectionReusableHandler_ = connectionReusable;
+   }
+
    // execute the async client
    virtual void execute(const ResponseHandler& responseHandler,
                         const ErrorHandler& errorHandler,
@@ -123,6 +141,16 @@ public:
       errorHandler_ = errorHandler;
       chunkHandler_ = chunkHandler;
 
+      // reset state from any previous request (a client whose connection
+      // was kept alive can be executed again)
+      response_.reset();
+      responseBuffer_.consume(responseBuffer_.size());
+      chunkParser_.reset();
+      chunkedEncoding_ = false;
+      bytesExpected_ = 0;
+      lengthKnown_ = false;
+      responseComplete_ = false;
+
       // connect and write request (implmented in a protocol
       // specific manner by subclassees)
       connectAndWriteRequest();
@@ -204,9 +232,11 @@ protected:
    void writeRequest()
    {
       // specify closing of the connection after the request unless this is
-      // an attempt to upgrade to websockets
+      // an attempt to upgrade to websockets or the connection is eligible
+      // for reuse (http/1.1 persistent connection semantics)
       Header overrideHeader;
-      if (!boost::algorithm::iequals(request_.headerValue("Connection"),
+      if (!reuseConnection_ &&
+          !boost::algorithm::iequals(request_.headerValue("Connection"),
                                      "Upgrade"))
       {
          overrideHeader = Header::connectionClose();
@@ -474,10 +504,25 @@ private:
                }
             }
 
+            // record the expected body length (when known this lets us
+            // detect response completion without waiting for the server
+            // to close the connection)
+            lengthKnown_ = !response_.headerValue("Content-Length").empty();
+            if (lengthKnown_)
+               bytesExpected_ = response_.contentLength();
+
             // append any lefover buffer contents to the body
             if (responseBuffer_.size() > 0)
                ResponseParser::appendToBody(&responseBuffer_, &response_);
 
+            // the entire body may already be in hand
+            if (lengthKnown_ && response_.body().length() >= bytesExpected_)
+            {
+               responseComplete_ = true;
+               closeAndRespond();
+               return;
+            }
+
             // start reading content
             readSomeContent();
          }
@@ -506,6 +551,14 @@ private:
             // copy content
             ResponseParser::appendToBody(&responseBuffer_, &response_);
 
+            // check for body completion by length
+            if (lengthKnown_ && response_.body().length() >= bytesExpected_)
+            {
+               responseComplete_ = true;
+               closeAndRespond();
+               return;
+            }
+
             // continue reading content
             readSomeContent();
          }
@@ -565,7 +618,9 @@ private:
       }
       else
       {
-         // no more chunks
+         // no more chunks (a complete chunked response is a clean
+         // completion point so the connection is eligible for reuse)
+         responseComplete_ = true;
          closeAndRespond();
       }
    }
@@ -577,13 +632,25 @@ private:
 
    void closeAndRespond()
    {
-      if (!keepConnectionAlive())
+      // a cleanly completed response on a reuse-enabled connection is
+      // left open (unless the server asked us to close)
+      bool reusable = reuseConnection_ &&
+                      responseComplete_ &&
+                      !boost::algorithm::iequals(
+                                 response_.headerValue("Connection"), "close");
+
+      if (!reusable && !keepConnectionAlive())
          close();
 
       if (responseHandler_ && (!chunkedEncoding_ || !chunkHandler_))
          responseHandler_(response_);
       else if (chunkHandler_)
          chunkHandler_(response_, ""); // completion of chunks signified by empty chunk
+
+      // notify the owner that the connection can be reused (after the
+      // response handler so the client isn't re-executed underneath it)
+      if (reusable && connectionReusableHandler_)
+         connectionReusableHandler_();
    }
 
    void logError(const Error& error) const
@@ -628,6 +695,13 @@ private:
    ChunkHandler chunkHandler_;
    bool chunkedEncoding_;
 
+   // connection reuse state
+   bool reuseConnection_;
+   boost::function<void()> connectionReusableHandler_;
+   std::size_t bytesExpected_;
+   bool lengthKnown_;
+   bool responseComplete_;
+
    boost::mutex socketMutex_;
    bool closed_;
 };
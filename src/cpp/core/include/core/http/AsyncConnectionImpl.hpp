@@ -34,6 +34,7 @@
 
 #include <core/http/Request.hpp>
 #include <core/http/Response.hpp>
+#include <core/http/Compression.hpp>
 #include <core/http/SocketUtils.hpp>
 #include <core/http/RequestParser.hpp>
 #include <core/http/AsyncConnection.hpp>
@@ -168,22 +169,38 @@ public:
       // make sure that if no body and content-length were specified,
       // we send 0 for Content-Length
       // otherwise, this response will be invalid
-      if (response_.body().empty() && response_.headerValue("Content-Length").empty())
+      if (response_.body().empty() &&
+          response_.bodyBuffers().empty() &&
+          response_.headerValue("Content-Length").empty())
+      {
           response_.setContentLength(0);
+      }
 
       // call the response filter if we have one
       if (responseFilter_)
          responseFilter_(originalUri_, &response_);
 
-      // write
-      socketOperations_->asyncWrite(
-          response_.toBuffers(),
-          boost::bind(
-               &AsyncConnectionImpl<SocketType>::handleWrite,
+      // if the client negotiated gzip and the response qualifies (large
+      // compressible body with no Content-Encoding of its own) then
+      // deflate on the shared compression pool rather than on this
+      // io_service thread, and come back to write the compressed bytes
+      if (compression::shouldCompressResponse(request_, response_))
+      {
+         boost::shared_ptr<std::string> pBody(
+                                          new std::string(response_.body()));
+         compression::gzipCompressAsync(
+            ioService_,
+            pBody,
+            boost::bind(
+               &AsyncConnectionImpl<SocketType>::handleCompressedBody,
                AsyncConnectionImpl<SocketType>::shared_from_this(),
-               boost::asio::placeholders::error,
-               close)
-      );
+               _1,
+               _2,
+               close));
+         return;
+      }
+
+      startWriteResponse(close);
    }
 
    virtual void writeResponse(const http::Response& response, bool close = true)
@@ -225,10 +242,19 @@ public:
       socketOperations_->asyncWrite(buffers, handler);
    }
 
+   // set a handler invoked (at most once, when the connection closes)
+   // to signal that the connection is done servicing its request -- used
+   // by the server for admission control accounting
+   void setRequestCompleteHandler(const boost::function<void()>& handler)
+   {
+      requestCompleteHandler_ = handler;
+   }
+
    virtual void close()
    {
       // ensure the socket is only closed once - boost considers
       // multiple closes an error, and this can lead to a segfault
+      boost::function<void()> requestCompleteHandler;
       LOCK_MUTEX(socketMutex_)
       {
          if (!closed_)
@@ -238,9 +264,16 @@ public:
                LOG_ERROR(error);
 
             closed_ = true;
+
+            // claim the completion handler (so it fires exactly once,
+            // outside the lock)
+            requestCompleteHandler.swap(requestCompleteHandler_);
          }
       }
       END_LOCK_MUTEX;
+
+      if (requestCompleteHandler)
+         requestCompleteHandler();
    }
    
 private:
@@ -336,6 +369,40 @@ private:
                &request_);
    }
 
+   void startWriteResponse(bool close)
+   {
+      socketOperations_->asyncWrite(
+          response_.toBuffers(),
+          boost::bind(
+               &AsyncConnectionImpl<SocketType>::handleWrite,
+               AsyncConnectionImpl<SocketType>::shared_from_this(),
+               boost::asio::placeholders::error,
+               close)
+      );
+   }
+
+   // continuation posted back to our io_service by the compression pool
+   void handleCompressedBody(const Error& error,
+                             boost::shared_ptr<std::string> pCompressed,
+                             bool close)
+   {
+      if (error)
+      {
+         // just send the original body -- it's still intact in the
+         // response so the client sees correct (if larger) output
+         LOG_ERROR(error);
+      }
+      else
+      {
+         // note: setBodyUnencoded strips Content-Encoding so the gzip
+         // header has to be (re)applied afterwards
+         response_.setBodyUnencoded(*pCompressed);
+         response_.setContentEncoding(kGzipEncoding);
+      }
+
+      startWriteResponse(close);
+   }
+
    void handleWrite(const boost::system::error_code& e, bool closeSocket)
    {
       try
@@ -411,6 +478,7 @@ private:
 
    boost::mutex socketMutex_;
    bool closed_ = false;
+   boost::function<void()> requestCompleteHandler_;
 };
 
 } // namespace http
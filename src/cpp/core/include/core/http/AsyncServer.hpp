@@ -45,6 +45,10 @@ public:
    virtual void addHandler(const std::string& prefix,
                            const AsyncUriHandlerFunction& handler) = 0;
 
+   virtual void addHandler(const std::string& prefix,
+                           const AsyncUriHandlerFunction& handler,
+                           RequestClass requestClass) = 0;
+
    virtual void addProxyHandler(const std::string& prefix,
                                 const AsyncUriHandlerFunction& handler) = 0;
 
@@ -65,6 +69,15 @@ public:
    virtual void setRequestFilter(RequestFilter requestFilter) = 0;
    virtual void setResponseFilter(ResponseFilter responseFilter) = 0;
 
+   // admission control: limit the number of requests of a class which
+   // may execute concurrently (0 means unlimited)
+   virtual void setRequestClassLimit(RequestClass requestClass,
+                                     std::size_t maxConcurrent) = 0;
+
+   // current active/queued counts for a request class
+   virtual QosScheduler::ClassMetrics requestClassMetrics(
+                                     RequestClass requestClass) const = 0;
+
    virtual Error runSingleThreaded() = 0;
 
    virtual Error run(std::size_t threadPoolSize = 1) = 0;
@@ -40,6 +40,7 @@
 #include <core/http/AsyncServer.hpp>
 #include <core/http/AsyncConnectionImpl.hpp>
 #include <core/http/AsyncUriHandler.hpp>
+#include <core/http/QosScheduler.hpp>
 #include <core/http/Util.hpp>
 #include <core/http/UriHandler.hpp>
 #include <core/http/SocketUtils.hpp>
@@ -95,6 +96,17 @@ public:
       uriHandlers_.add(AsyncUriHandler(baseUri_ + prefix, handler));
    }
 
+   virtual void addHandler(const std::string& prefix,
+                           const AsyncUriHandlerFunction& handler,
+                           RequestClass requestClass)
+   {
+      BOOST_ASSERT(!running_);
+      uriHandlers_.add(AsyncUriHandler(baseUri_ + prefix,
+                                       handler,
+                                       false,
+                                       requestClass));
+   }
+
    virtual void addBlockingHandler(const std::string& prefix,
                                    const UriHandlerFunction& handler)
    {
@@ -142,6 +154,19 @@ public:
       responseFilter_ = responseFilter;
    }
 
+   virtual void setRequestClassLimit(RequestClass requestClass,
+                                     std::size_t maxConcurrent)
+   {
+      BOOST_ASSERT(!running_);
+      qosScheduler_.setMaxConcurrent(requestClass, maxConcurrent);
+   }
+
+   virtual QosScheduler::ClassMetrics requestClassMetrics(
+                                     RequestClass requestClass) const
+   {
+      return qosScheduler_.metricsFor(requestClass);
+   }
+
    virtual Error runSingleThreaded()
    {
 
@@ -361,9 +386,20 @@ private:
             }
          }
 
-         // call handler if we have one
+         // call handler if we have one (dispatch through the qos
+         // scheduler so that bulk traffic can't monopolize the worker
+         // pool -- interactive rpc is never limited)
          if (handlerFunc)
-            handlerFunc(pAsyncConnection) ;
+         {
+            RequestClass requestClass = handler.requestClass();
+            pConnection->setRequestCompleteHandler(
+                     boost::bind(&QosScheduler::taskComplete,
+                                 &qosScheduler_,
+                                 requestClass));
+            qosScheduler_.beginTask(requestClass,
+                                    boost::bind(handlerFunc,
+                                                pAsyncConnection));
+         }
          else
          {
             // log error
@@ -533,6 +569,7 @@ private:
    std::vector<boost::shared_ptr<ScheduledCommand> > scheduledCommands_;
    RequestFilter requestFilter_;
    ResponseFilter responseFilter_;
+   QosScheduler qosScheduler_;
    bool running_;
 };
 
@@ -27,6 +27,7 @@
 
 #include <core/http/UriHandler.hpp>
 #include <core/http/AsyncConnection.hpp>
+#include <core/http/QosScheduler.hpp>
 
 
 namespace rstudio {
@@ -40,12 +41,20 @@ typedef boost::function<void(
 class AsyncUriHandler
 {
 public:
-   AsyncUriHandler() : isProxyHandler_(false) {} // other members default initialized
+   AsyncUriHandler()
+      : isProxyHandler_(false),
+        requestClass_(InteractiveClass) // other members default initialized
+   {
+   }
 
    AsyncUriHandler(const std::string& prefix,
                    AsyncUriHandlerFunction function,
-                   bool isProxyHandler = false)
-       : prefix_(prefix), function_(function), isProxyHandler_(isProxyHandler)
+                   bool isProxyHandler = false,
+                   RequestClass requestClass = InteractiveClass)
+       : prefix_(prefix),
+         function_(function),
+         isProxyHandler_(isProxyHandler),
+         requestClass_(requestClass)
    {
    }
 
@@ -73,10 +82,16 @@ public:
       return isProxyHandler_;
    }
 
+   RequestClass requestClass() const
+   {
+      return requestClass_;
+   }
+
 private:
    std::string prefix_;
    AsyncUriHandlerFunction function_ ;
    bool isProxyHandler_;
+   RequestClass requestClass_;
 
 };
 
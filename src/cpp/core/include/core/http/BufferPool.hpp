@@ -0,0 +1,60 @@
+/*
+ * BufferPool.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_HTTP_BUFFER_POOL_HPP
+#define CORE_HTTP_BUFFER_POOL_HPP
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+#include <core/Thread.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+// arena of reusable fixed-size i/o buffers. buffers are recycled through
+// a free list so that high connection churn (e.g. proxied app traffic)
+// doesn't continually allocate and free read buffers. the pool never
+// blocks: if the arena is empty a fresh buffer is allocated, and
+// released buffers are retained only up to the arena size
+class BufferPool : boost::noncopyable
+{
+public:
+   typedef boost::shared_ptr<std::vector<char> > Buffer;
+
+public:
+   BufferPool(std::size_t bufferSize, std::size_t poolSize);
+
+   Buffer acquire();
+   void release(Buffer buffer);
+
+   // number of buffers currently available for reuse
+   std::size_t available() const;
+
+private:
+   std::size_t bufferSize_;
+   std::size_t poolSize_;
+   mutable boost::mutex mutex_;
+   std::vector<Buffer> freeList_;
+};
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_HTTP_BUFFER_POOL_HPP
@@ -0,0 +1,69 @@
+/*
+ * Compression.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_HTTP_COMPRESSION_HPP
+#define CORE_HTTP_COMPRESSION_HPP
+
+#include <string>
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/asio/io_service.hpp>
+
+namespace rstudio {
+namespace core {
+
+class Error;
+
+namespace http {
+
+class Request;
+class Response;
+
+namespace compression {
+
+// returns true if the response is worth gzip-compressing before it goes
+// on the wire: the client accepts gzip, the body is above a minimum size
+// threshold, the content type is compressible (text, javascript, json,
+// xml, svg) and no Content-Encoding has been set. setting an encoding --
+// including "identity" -- is the per-response opt-out for bodies that
+// are already compressed. always false on win32 (we never gzip there,
+// see Response::setBody) and for scatter-gather responses whose body
+// buffers are written to the socket as-is
+bool shouldCompressResponse(const Request& request, const Response& response);
+
+// synchronously gzip input into *pOutput
+Error gzipCompress(const std::string& input, std::string* pOutput);
+
+// synchronously inflate gzipped input into *pOutput
+Error gzipDecompress(const std::string& input, std::string* pOutput);
+
+// gzip *pBody on a small shared worker thread pool (so callers running
+// on an io_service thread never block on deflate) and then post the
+// completion handler back to ioService with the compressed bytes (or
+// with the error if compression failed)
+typedef boost::function<void(const Error&,
+                             boost::shared_ptr<std::string>)> CompressHandler;
+
+void gzipCompressAsync(boost::asio::io_service& ioService,
+                       const boost::shared_ptr<std::string>& pBody,
+                       const CompressHandler& handler);
+
+} // namespace compression
+} // namespace http
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_HTTP_COMPRESSION_HPP
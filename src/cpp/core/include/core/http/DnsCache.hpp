@@ -0,0 +1,92 @@
+/*
+ * DnsCache.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_HTTP_DNS_CACHE_HPP
+#define CORE_HTTP_DNS_CACHE_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <boost/asio/ip/tcp.hpp>
+
+#include <core/Thread.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+// process-wide cache of hostname resolutions shared by all http client
+// instances. successful resolutions are cached with a positive TTL and
+// failures with a (shorter) negative TTL, so repeated connections to the
+// same endpoint don't each pay for a resolver round trip -- and a slow
+// or unreachable resolver doesn't stall every request
+class DnsCache : boost::noncopyable
+{
+public:
+   static DnsCache& instance();
+
+   // look for a fresh cache entry for address:port. returns false on a
+   // miss; on a hit either *pEndpoints is filled (positive entry) or
+   // *pEc holds the cached resolution error (negative entry)
+   bool lookup(const std::string& address,
+               const std::string& port,
+               std::vector<boost::asio::ip::tcp::endpoint>* pEndpoints,
+               boost::system::error_code* pEc);
+
+   void store(const std::string& address,
+              const std::string& port,
+              const std::vector<boost::asio::ip::tcp::endpoint>& endpoints);
+
+   void storeNegative(const std::string& address,
+                      const std::string& port,
+                      const boost::system::error_code& ec);
+
+   // resolve address:port on a background thread so that subsequent
+   // connections find a warm cache entry (e.g. for endpoints known to
+   // be needed shortly after startup)
+   void prewarm(const std::string& address, const std::string& port);
+
+private:
+   DnsCache()
+   {
+   }
+
+private:
+   struct Entry
+   {
+      Entry()
+      {
+      }
+
+      // COPYING: via compiler (copyable members)
+
+      std::vector<boost::asio::ip::tcp::endpoint> endpoints;
+      boost::system::error_code ec;
+      boost::posix_time::ptime expiry;
+   };
+
+   boost::mutex mutex_;
+   std::map<std::string,Entry> cache_;
+};
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_HTTP_DNS_CACHE_HPP
@@ -54,6 +54,29 @@ public:
       setConnectionRetryProfile(retryProfile);
    }
 
+public:
+
+   // returns true if the underlying socket is open and (as far as a
+   // non-blocking peek can tell) the peer hasn't closed its end. used by
+   // connection pools to health-check idle connections before reuse
+   bool isConnected()
+   {
+      if (!socket_.is_open())
+         return false;
+
+      char byte;
+      ssize_t result = ::recv(socket_.native_handle(),
+                              &byte,
+                              1,
+                              MSG_PEEK | MSG_DONTWAIT);
+      if (result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+         return true;   // no data pending -- connection is idle and open
+
+      // orderly shutdown (0), error, or unexpected pending data -- in
+      // all of these cases the connection shouldn't be reused
+      return false;
+   }
+
 protected:
 
    virtual boost::asio::local::stream_protocol::socket& socket()
@@ -65,6 +88,14 @@ private:
 
    virtual void connectAndWriteRequest()
    {
+      // if we already hold an open connection (i.e. we were acquired from
+      // a keep-alive connection pool) then just write the request
+      if (socket().is_open())
+      {
+         writeRequest();
+         return;
+      }
+
       // validate if requested
       if (validateUid_.is_initialized() && localStreamPath_.exists())
       {
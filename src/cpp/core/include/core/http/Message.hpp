@@ -22,6 +22,7 @@
 
 #include <boost/bind.hpp>
 #include <boost/utility.hpp>
+#include <boost/shared_ptr.hpp>
 
 namespace RSTUDIO_BOOST_NAMESPACE {
 namespace asio {
@@ -45,7 +46,28 @@ extern const char * const kTransferEncoding;
 extern const char * const kChunkedTransferEncoding;
 
 class Response;
-   
+
+// a scatter-gather body part referencing memory owned elsewhere. the
+// keepAlive member guarantees the referenced memory remains valid until
+// the message (and any copies made via assign) has been written to the
+// socket
+struct BodyBuffer
+{
+   BodyBuffer() : data(NULL), length(0) {}
+   BodyBuffer(const void* data,
+              std::size_t length,
+              const boost::shared_ptr<void>& keepAlive)
+      : data(data), length(length), keepAlive(keepAlive)
+   {
+   }
+
+   const void* data;
+   std::size_t length;
+   boost::shared_ptr<void> keepAlive;
+};
+
+typedef std::vector<BodyBuffer> BodyBuffers;
+
 class Message : boost::noncopyable
 {
 public:
@@ -91,7 +113,14 @@ public:
    const Headers& headers() const  { return headers_; }
    
    const std::string& body() const { return body_; }
-   
+
+   // scatter-gather body buffers (written to the socket after body_, with
+   // no intermediate copies; see BodyBuffer above for ownership semantics)
+   const BodyBuffers& bodyBuffers() const { return bodyBuffers_; }
+
+   // full body length (body_ plus any attached buffers)
+   std::size_t bodyLength() const;
+
    void reset();
    
    std::vector<boost::asio::const_buffer> toBuffers(
@@ -105,7 +134,11 @@ protected:
    // RVO for potentially large buffers). note this means that you MUST always
    // remember to call setContentLength after setting the body!
    std::string body_;
-   
+
+   // scatter-gather body buffers (buffer copies share ownership of the
+   // underlying memory via BodyBuffer::keepAlive so assign is cheap)
+   BodyBuffers bodyBuffers_;
+
    void appendSpaceBuffer(
          std::vector<boost::asio::const_buffer>& buffers) const ;
    
@@ -115,6 +148,7 @@ protected:
    void assign(const Message& message, const Headers& extraHeaders)
    {
       body_ = message.body_;
+      bodyBuffers_ = message.bodyBuffers_;
       httpVersionMajor_ = message.httpVersionMajor_;
       httpVersionMinor_ = message.httpVersionMinor_;
       headers_ = message.headers_;
@@ -0,0 +1,87 @@
+/*
+ * MultipartStreamParser.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_HTTP_MULTIPART_STREAM_PARSER_HPP
+#define CORE_HTTP_MULTIPART_STREAM_PARSER_HPP
+
+#include <string>
+
+#include <boost/utility.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+// handler interface for MultipartStreamParser. part data is delivered
+// incrementally (in whatever chunk sizes the input arrives in) so very
+// large parts can be consumed with bounded memory
+class MultipartHandler : boost::noncopyable
+{
+public:
+   virtual ~MultipartHandler() {}
+
+   // a new part has begun; name and filename come from the part's
+   // Content-Disposition header (filename is empty for ordinary fields)
+   virtual void onPartBegin(const std::string& name,
+                            const std::string& filename) = 0;
+
+   virtual void onPartData(const char* pData, std::size_t length) = 0;
+
+   virtual void onPartEnd() = 0;
+};
+
+// incremental push parser for multipart/form-data bodies. feed data as
+// it arrives via parse(); events are dispatched to the handler. the
+// parser buffers at most one part-header block plus one boundary's
+// worth of lookback, never the part payloads themselves
+class MultipartStreamParser : boost::noncopyable
+{
+public:
+   MultipartStreamParser(const std::string& boundary,
+                         MultipartHandler* pHandler);
+
+   // feed the next span of body bytes; returns false if the input is
+   // not well-formed (parsing cannot continue after an error)
+   bool parse(const char* pData, std::size_t length);
+
+   // true once the terminating boundary has been seen
+   bool complete() const { return state_ == StateComplete; }
+
+private:
+   void beginPart();
+   bool consumeBuffer();
+
+private:
+   enum State
+   {
+      StatePreamble,
+      StatePartHeaders,
+      StatePartData,
+      StateComplete,
+      StateError
+   };
+
+   std::string delimiter_;       // "\r\n--" + boundary
+   MultipartHandler* pHandler_;
+   State state_;
+   std::string buffer_;
+   std::string partHeaders_;
+};
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_HTTP_MULTIPART_STREAM_PARSER_HPP
@@ -0,0 +1,93 @@
+/*
+ * QosScheduler.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_HTTP_QOS_SCHEDULER_HPP
+#define CORE_HTTP_QOS_SCHEDULER_HPP
+
+#include <deque>
+
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+
+#include <core/Thread.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+// classes of request traffic -- used to give each type of work a bounded
+// share of the server's worker threads so that bulk transfers can't
+// starve latency-sensitive rpc
+enum RequestClass
+{
+   InteractiveClass = 0,   // interactive json-rpc (never limited)
+   BulkClass = 1,          // large transfers (uploads, downloads, exports)
+   EventStreamClass = 2    // long-polling event streams
+};
+
+// admission control for request dispatch: each request class may have a
+// limit on the number of requests executing concurrently; requests over
+// the limit are queued (FIFO within their class) and dispatched as
+// running requests of that class complete
+class QosScheduler : boost::noncopyable
+{
+public:
+   struct ClassMetrics
+   {
+      ClassMetrics() : active(0), queued(0) {}
+
+      std::size_t active;
+      std::size_t queued;
+   };
+
+public:
+   QosScheduler();
+
+   // set the maximum number of requests of a class which may execute
+   // concurrently (0 means unlimited, the default). not thread-safe:
+   // call before the server starts dispatching requests
+   void setMaxConcurrent(RequestClass requestClass, std::size_t maxConcurrent);
+
+   // run the task now if its class has spare capacity, otherwise queue
+   // it. taskComplete must be called (exactly once) when the request
+   // finishes so that queued work can be dispatched
+   void beginTask(RequestClass requestClass,
+                  const boost::function<void()>& task);
+   void taskComplete(RequestClass requestClass);
+
+   // current active/queued counts for a class (for status reporting)
+   ClassMetrics metricsFor(RequestClass requestClass) const;
+
+private:
+   struct ClassState
+   {
+      ClassState() : maxConcurrent(0), active(0) {}
+
+      std::size_t maxConcurrent;
+      std::size_t active;
+      std::deque<boost::function<void()> > queue;
+   };
+
+   enum { kNumRequestClasses = 3 };
+
+   mutable boost::mutex mutex_;
+   ClassState classes_[kNumRequestClasses];
+};
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_HTTP_QOS_SCHEDULER_HPP
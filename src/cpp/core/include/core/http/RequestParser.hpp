@@ -17,6 +17,10 @@
 #ifndef CORE_HTTP_REQUEST_PARSER_HPP
 #define CORE_HTTP_REQUEST_PARSER_HPP
 
+#include <algorithm>
+
+#include <boost/function.hpp>
+
 #include <core/http/Request.hpp>
 
 namespace rstudio {
@@ -26,6 +30,15 @@ namespace http {
 /// Parser for incoming requests.
 class RequestParser
 {
+public:
+  // streaming body support: a consumer receives body bytes as they
+  // arrive instead of having them accumulated in Request::body(). the
+  // factory is invoked once headers are complete (so it can examine the
+  // uri / content type) and may return an empty consumer to keep the
+  // default buffering behavior
+  typedef boost::function<void(const char*, std::size_t)> BodyConsumer;
+  typedef boost::function<BodyConsumer(Request*)> BodyConsumerFactory;
+
 public:
   /// Construct ready to parse the request method.
   RequestParser();
@@ -33,6 +46,11 @@ public:
   /// Reset to initial parser state.
   void reset();
 
+  void setBodyConsumerFactory(const BodyConsumerFactory& factory)
+  {
+     bodyConsumerFactory_ = factory;
+  }
+
   // enum for parse results
   enum status
   {
@@ -60,6 +78,12 @@ public:
             if (content_length_ > 0)
             {
                parsing_body_ = true ;
+
+               // give the consumer factory a chance to claim the body
+               // now that the uri and headers are available
+               if (bodyConsumerFactory_)
+                  bodyConsumer_ = bodyConsumerFactory_(&req);
+
                continue ;
             }
             else
@@ -69,6 +93,26 @@ public:
          }
       }
       // body parsing
+      else if (bodyConsumer_)
+      {
+         // streaming mode (note this relies on the input iterators being
+         // contiguous, which is true of every caller -- they parse raw
+         // socket buffers) -- hand the available span to the consumer
+         // rather than accumulating it in the request
+         std::size_t available = end - begin;
+         std::size_t remaining = content_length_ - body_bytes_streamed_;
+         std::size_t consume = std::min(available, remaining);
+         bodyConsumer_(&(*begin), consume);
+         begin += consume;
+         body_bytes_streamed_ += consume;
+         if (body_bytes_streamed_ == content_length_)
+         {
+            // release the consumer so it can flush/close its sink before
+            // the request is handed off for processing
+            bodyConsumer_ = BodyConsumer();
+            return complete ;
+         }
+      }
       else
       {
          req.body_.push_back(*begin++) ;
@@ -124,6 +168,11 @@ private:
   std::size_t content_length_ ;
   bool parsing_content_length_ ;
   bool parsing_body_ ;
+
+  // streaming body state
+  BodyConsumerFactory bodyConsumerFactory_ ;
+  BodyConsumer bodyConsumer_ ;
+  std::size_t body_bytes_streamed_ ;
 };
 
 } // namespace http
@@ -62,6 +62,7 @@ enum Code {
    NotFound = 404,
    MethodNotAllowed = 405,
    RangeNotSatisfiable = 416,
+   TooManyRequests = 429,
    InternalServerError = 500 ,
    NotImplemented = 501, 
    BadGateway = 502,
@@ -329,12 +330,31 @@ public:
       }
    }
 
+   // zero-copy file response: memory-map the file and attach the mapping
+   // as a scatter-gather body buffer written directly to the socket. the
+   // mapped bytes are served as-is (no content encoding is applied) so
+   // this is best suited to content that is already compressed, binary
+   // attachments, or clients that don't accept gzip. falls back to the
+   // streaming setFile path if the file can't be mapped
+   void setMemoryMappedFile(const FilePath& filePath, const Request& request);
+
    void setRangeableFile(const FilePath& filePath, const Request& request);
 
    void setRangeableFile(const std::string& contents,
                          const std::string& mimeType,
                          const Request& request);
 
+   // scatter-gather body: attach buffers that are written directly to the
+   // socket with no intermediate copy. the keepAlive argument shares
+   // ownership of the referenced memory so it remains valid for the
+   // lifetime of the response (including copies made via assign). note
+   // that attached buffers are written as-is -- callers are responsible
+   // for any content encoding. Content-Length is maintained automatically
+   void addBodyBuffer(const boost::shared_ptr<std::string>& content);
+   void addBodyBuffer(const void* data,
+                      std::size_t length,
+                      const boost::shared_ptr<void>& keepAlive);
+
    // these calls do no stream io or encoding so don't return errors
    void setBodyUnencoded(const std::string& body);
    void setError(int statusCode, const std::string& message);
@@ -18,13 +18,13 @@
 
 #include <string>
 
-#include <boost/array.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
 
 #include <core/Thread.hpp>
 #include <core/Error.hpp>
 #include <core/http/Socket.hpp>
+#include <core/http/BufferPool.hpp>
 
 namespace rstudio {
 namespace core {
@@ -42,12 +42,11 @@ public:
       pProxy->readServer();
    }
 
+   ~SocketProxy();
+
 private:
    SocketProxy(boost::shared_ptr<core::http::Socket> ptrClient,
-               boost::shared_ptr<core::http::Socket> ptrServer)
-      : ptrClient_(ptrClient), ptrServer_(ptrServer)
-   {
-   }
+               boost::shared_ptr<core::http::Socket> ptrServer);
 
    void readClient();
    void readServer();
@@ -68,8 +67,12 @@ private:
 private:
    boost::shared_ptr<core::http::Socket> ptrClient_;
    boost::shared_ptr<core::http::Socket> ptrServer_;
-   boost::array<char, 8192> clientBuffer_;
-   boost::array<char, 8192> serverBuffer_;
+
+   // read buffers, acquired from a shared pool for the lifetime of the
+   // connection (returned on destruction)
+   BufferPool::Buffer clientBuffer_;
+   BufferPool::Buffer serverBuffer_;
+
    boost::mutex socketMutex_;
 };
 
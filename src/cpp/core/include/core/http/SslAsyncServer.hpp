@@ -16,9 +16,13 @@
 #ifndef CORE_HTTP_SSL_ASYNC_SERVER_HPP
 #define CORE_HTTP_SSL_ASYNC_SERVER_HPP
 
+#include <cstring>
+
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/ssl.hpp>
 
+#include <openssl/ssl.h>
+
 #include <core/FilePath.hpp>
 #include <core/http/AsyncServerImpl.hpp>
 #include <core/http/TcpIpSocketUtils.hpp>
@@ -29,6 +33,16 @@ namespace http {
 
 class SslAsyncServer : public AsyncServerImpl<boost::asio::ip::tcp>
 {
+private:
+   // tls session cache tuning: large enough that a busy multi-tenant
+   // server doesn't thrash the cache, with a timeout matching typical
+   // workbench usage patterns
+   enum
+   {
+      kSslSessionCacheSize = 20 * 1024,
+      kSslSessionTimeoutSeconds = 300
+   };
+
 public:
 
    SslAsyncServer(const std::string& serverName,
@@ -71,6 +85,24 @@ public:
       if (ec)
          return Error(ec, ERROR_LOCATION);
 
+      // enable server-side session caching so that the browser's many
+      // short-lived connections (source streams, uploads, satellite
+      // windows) can resume a prior session rather than paying for a
+      // full handshake each time. session tickets are also issued by
+      // default so resumption works even for clients we've evicted from
+      // the cache. a session id context is required for resumption to
+      // function when client verification is in play (and is harmless
+      // otherwise)
+      SSL_CTX* pSslCtx = context->native_handle();
+      SSL_CTX_set_session_cache_mode(pSslCtx, SSL_SESS_CACHE_SERVER);
+      SSL_CTX_sess_set_cache_size(pSslCtx, kSslSessionCacheSize);
+      SSL_CTX_set_timeout(pSslCtx, kSslSessionTimeoutSeconds);
+      const char* const kSessionIdContext = "rstudio";
+      SSL_CTX_set_session_id_context(
+               pSslCtx,
+               reinterpret_cast<const unsigned char*>(kSessionIdContext),
+               ::strlen(kSessionIdContext));
+
       setSslContext(context);
 
       return initTcpIpAcceptor(acceptorService(), address, port);
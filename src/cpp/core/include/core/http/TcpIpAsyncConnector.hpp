@@ -16,6 +16,8 @@
 #ifndef CORE_HTTP_TCP_IP_ASYNC_CONNECTOR_HPP
 #define CORE_HTTP_TCP_IP_ASYNC_CONNECTOR_HPP
 
+#include <vector>
+
 #include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
@@ -24,6 +26,7 @@
 #include <boost/asio/placeholders.hpp>
 
 
+#include <core/http/DnsCache.hpp>
 #include <core/http/TcpIpSocketUtils.hpp>
 
 // special version of unexpected exception handler which makes
@@ -54,8 +57,10 @@ public:
 public:
    TcpIpAsyncConnector(boost::asio::io_service& ioService,
                        boost::asio::ip::tcp::socket* pSocket)
-     : pSocket_(pSocket),
-       resolver_(ioService)
+     : ioService_(ioService),
+       pSocket_(pSocket),
+       resolver_(ioService),
+       endpointIndex_(0)
    {
    }
 
@@ -69,6 +74,33 @@ public:
       connectedHandler_ = connectedHandler;
       errorHandler_ = errorHandler;
 
+      // save the endpoint so resolutions can be cached under it
+      address_ = address;
+      port_ = port;
+
+      // consult the shared resolution cache before going to the resolver
+      // (post rather than call directly so handlers are never invoked
+      // re-entrantly from connect)
+      boost::system::error_code cachedEc;
+      if (DnsCache::instance().lookup(address, port, &endpoints_, &cachedEc))
+      {
+         if (cachedEc)
+         {
+            ioService_.post(
+               boost::bind(&TcpIpAsyncConnector::handleErrorCode,
+                           TcpIpAsyncConnector::shared_from_this(),
+                           cachedEc,
+                           ERROR_LOCATION));
+         }
+         else
+         {
+            ioService_.post(
+               boost::bind(&TcpIpAsyncConnector::tryNextEndpoint,
+                           TcpIpAsyncConnector::shared_from_this()));
+         }
+         return;
+      }
+
       // start an async resolve
       boost::asio::ip::tcp::resolver::query query(address, port);
       resolver_.async_resolve(
@@ -89,26 +121,51 @@ private:
       {
          if (!ec)
          {
+            // collect the endpoints and share them with other clients
+            for ( ; endpoint_iterator !=
+                    boost::asio::ip::tcp::resolver::iterator();
+                  ++endpoint_iterator)
+            {
+               endpoints_.push_back(*endpoint_iterator);
+            }
+            DnsCache::instance().store(address_, port_, endpoints_);
+
             // try endpoints until we successfully connect with one
-            boost::asio::ip::tcp::endpoint endpoint = *endpoint_iterator;
+            tryNextEndpoint();
+         }
+         else
+         {
+            DnsCache::instance().storeNegative(address_, port_, ec);
+            handleErrorCode(ec, ERROR_LOCATION);
+         }
+      }
+      CATCH_UNEXPECTED_ASYNC_CONNECTOR_EXCEPTION
+   }
+
+   void tryNextEndpoint()
+   {
+      try
+      {
+         if (endpointIndex_ < endpoints_.size())
+         {
+            boost::asio::ip::tcp::endpoint endpoint =
+                                             endpoints_[endpointIndex_++];
             pSocket_->async_connect(
                endpoint,
                boost::bind(&TcpIpAsyncConnector::handleConnect,
                            TcpIpAsyncConnector::shared_from_this(),
-                           boost::asio::placeholders::error,
-                           ++endpoint_iterator));
+                           boost::asio::placeholders::error));
          }
          else
          {
-            handleErrorCode(ec, ERROR_LOCATION);
+            handleErrorCode(boost::asio::error::host_not_found,
+                            ERROR_LOCATION);
          }
       }
       CATCH_UNEXPECTED_ASYNC_CONNECTOR_EXCEPTION
    }
 
-   void handleConnect(
-         const boost::system::error_code& ec,
-         boost::asio::ip::tcp::resolver::iterator endpoint_iterator)
+   void handleConnect(const boost::system::error_code& ec)
    {
       try
       {
@@ -117,18 +174,11 @@ private:
             if (connectedHandler_)
                connectedHandler_();
          }
-         else if (endpoint_iterator !=
-                  boost::asio::ip::tcp::resolver::iterator())
+         else if (endpointIndex_ < endpoints_.size())
          {
             // try next endpoint
             pSocket_->close();
-            boost::asio::ip::tcp::endpoint endpoint = *endpoint_iterator;
-            pSocket_->async_connect(
-               endpoint,
-               boost::bind(&TcpIpAsyncConnector::handleConnect,
-                           TcpIpAsyncConnector::shared_from_this(),
-                           boost::asio::placeholders::error,
-                           ++endpoint_iterator));
+            tryNextEndpoint();
          }
          else
          {
@@ -160,8 +210,13 @@ private:
    }
 
 private:
+   boost::asio::io_service& ioService_;
    boost::asio::ip::tcp::socket* pSocket_;
    boost::asio::ip::tcp::resolver resolver_;
+   std::string address_;
+   std::string port_;
+   std::vector<boost::asio::ip::tcp::endpoint> endpoints_;
+   std::size_t endpointIndex_;
    ConnectedHandler connectedHandler_;
    ErrorHandler errorHandler_;
 };
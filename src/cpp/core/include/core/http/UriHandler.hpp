@@ -18,8 +18,10 @@
 
 #include <string>
 #include <vector>
+#include <map>
 
 #include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <core/http/Response.hpp>
 
@@ -51,7 +53,9 @@ public:
    // COPYING: via compiler
    
    bool matches(const std::string& uri) const;
-   
+
+   const std::string& prefix() const { return prefix_; }
+
    UriAsyncHandlerFunction function() const;
   
    // implement UriHandlerFunction concept
@@ -71,11 +75,29 @@ public:
    // COPYING: via compiler
    
    void add(const UriHandler& handler);
-   
+
+   // replace the handler registered for exactly the same prefix (or
+   // add the handler if the prefix has not been registered)
+   void replace(const UriHandler& handler);
+
    UriAsyncHandlerFunction handlerFor(const std::string& uri) const;
-   
+
+private:
+   // prefix tree used for O(prefix-length) handler lookup. each node
+   // which terminates a registered prefix records the index of that
+   // handler within uriHandlers_ so that registration-order semantics
+   // are preserved when multiple prefixes match a uri
+   struct PrefixTreeNode
+   {
+      PrefixTreeNode() : handlerIndex(-1) {}
+
+      int handlerIndex;
+      std::map<char, boost::shared_ptr<PrefixTreeNode> > children;
+   };
+
 private:
    std::vector<UriHandler> uriHandlers_;
+   boost::shared_ptr<PrefixTreeNode> root_;
 };
 
 inline void notFoundHandler(const Request& request, Response* pResponse)
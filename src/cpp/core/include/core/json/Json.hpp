@@ -25,6 +25,7 @@
 
 #include <boost/type_traits/is_same.hpp>
 #include <boost/optional.hpp>
+#include <boost/noncopyable.hpp>
 
 #include <core/json/spirit/json_spirit_value.h>
 
@@ -214,6 +215,39 @@ bool fillMap(const Object& array, std::map< std::string, std::vector<std::string
 
 bool parse(const std::string& input, Value* pValue);
 
+// streaming (SAX-style) parse support. rather than materializing a DOM
+// for the entire input, the parser walks the document and fires an event
+// for each syntactic element it encounters. handlers override only the
+// events they care about; returning false from any event stops the parse
+// immediately (parseStream then also returns false, so handlers that
+// terminate early on purpose should track that state themselves)
+class SaxHandler : boost::noncopyable
+{
+public:
+   virtual ~SaxHandler() {}
+
+   virtual bool onNull() { return true; }
+   virtual bool onBool(bool value) { return true; }
+   virtual bool onInt(int64_t value) { return true; }
+   virtual bool onDouble(double value) { return true; }
+   virtual bool onString(const std::string& value) { return true; }
+   virtual bool onStartObject() { return true; }
+   virtual bool onMemberName(const std::string& name) { return true; }
+   virtual bool onEndObject() { return true; }
+   virtual bool onStartArray() { return true; }
+   virtual bool onEndArray() { return true; }
+};
+
+// parse the input incrementally, dispatching events to the handler as
+// they are scanned (no DOM is built). returns false on malformed input
+// or if the handler stopped the parse
+bool parseStream(const std::string& input, SaxHandler* pHandler);
+
+// scan only as much of a json-rpc request body as necessary to extract
+// the top-level "method" field (no DOM is built). returns false if the
+// input is malformed or contains no method
+bool parseMethod(const std::string& input, std::string* pMethod);
+
 void write(const Value& value, std::ostream& os);
 void writeFormatted(const Value& value, std::ostream& os);
 
@@ -1113,6 +1113,23 @@ public:
       setField(kRpcResult, result);
    }
 
+   // move overloads so large results can be built locally and handed
+   // off without deep-copying the tree into the response
+   void setResult(json::Value&& result)
+   {
+      setField(kRpcResult, std::move(result));
+   }
+
+   void setResult(json::Object&& result)
+   {
+      setField(kRpcResult, json::Value(std::move(result)));
+   }
+
+   void setResult(json::Array&& result)
+   {
+      setField(kRpcResult, json::Value(std::move(result)));
+   }
+
    json::Value& result()
    {
       return response_[kRpcResult];
@@ -1132,17 +1149,22 @@ public:
 
    void setAsyncHandle(const std::string& handle);
 
-   void setField(const std::string& name, const json::Value& value) 
-   { 
+   void setField(const std::string& name, const json::Value& value)
+   {
       response_[name] = value;
-   }             
-                
+   }
+
+   void setField(const std::string& name, json::Value&& value)
+   {
+      response_[name] = std::move(value);
+   }
+
    template <typename T>
-   void setField(const std::string& name, const T& value) 
-   { 
+   void setField(const std::string& name, const T& value)
+   {
       setField(name, json::Value(value));
    }
-   
+
    // low level hook to set the full response
    void setResponse(const json::Object& response)
    {
@@ -18,10 +18,12 @@
 #include <cassert>
 #include <sstream>
 #include <stdexcept>
-#include <boost/config.hpp> 
-#include <boost/cstdint.hpp> 
-#include <boost/shared_ptr.hpp> 
-#include <boost/variant.hpp> 
+#include <utility>
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/pool/pool_alloc.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/variant.hpp>
 
 namespace json_spirit
 {
@@ -52,10 +54,22 @@ namespace json_spirit
 
         Value_impl( const Value_impl& other );
 
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+        Value_impl( String_type&&   value );
+        Value_impl( Object&&        value );
+        Value_impl( Array&&         value );
+
+        Value_impl( Value_impl&& other );
+#endif
+
         bool operator==( const Value_impl& lhs ) const;
 
         Value_impl& operator=( const Value_impl& lhs );
 
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+        Value_impl& operator=( Value_impl&& lhs );
+#endif
+
         Value_type type() const;
 
         bool is_uint64() const;
@@ -162,8 +176,17 @@ namespace json_spirit
     {
         typedef String String_type;
         typedef Value_impl< Config_map > Value_type;
-        typedef std::vector< Value_type > Array_type;
-        typedef std::map< String_type, Value_type > Object_type;
+
+        // allocate nodes from thread-safe free-list pools rather than the
+        // general-purpose heap -- json trees are built and torn down for
+        // every rpc request and node churn dominates malloc traffic, so
+        // freed nodes are recycled within the pool instead of round
+        // tripping through malloc/free
+        typedef std::vector< Value_type,
+                             boost::pool_allocator< Value_type > > Array_type;
+        typedef std::map< String_type, Value_type, std::less< String_type >,
+                          boost::fast_pool_allocator<
+                             std::pair< const String_type, Value_type > > > Object_type;
         typedef typename Object_type::value_type Pair_type;
 
         static Value_type& add( Object_type& obj, const String_type& name, const Value_type& value )
@@ -296,6 +319,40 @@ namespace json_spirit
     {
     }
 
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    template< class Config >
+    Value_impl< Config >::Value_impl( String_type&& value )
+    :   type_( str_type )
+    ,   v_( std::move( value ) )
+    ,   is_uint64_( false )
+    {
+    }
+
+    template< class Config >
+    Value_impl< Config >::Value_impl( Object&& value )
+    :   type_( obj_type )
+    ,   v_( std::move( value ) )
+    ,   is_uint64_( false )
+    {
+    }
+
+    template< class Config >
+    Value_impl< Config >::Value_impl( Array&& value )
+    :   type_( array_type )
+    ,   v_( std::move( value ) )
+    ,   is_uint64_( false )
+    {
+    }
+
+    template< class Config >
+    Value_impl< Config >::Value_impl( Value_impl< Config >&& other )
+    :   type_( other.type_ )
+    ,   v_( std::move( other.v_ ) )
+    ,   is_uint64_( other.is_uint64_ )
+    {
+    }
+#endif
+
     template< class Config >
     Value_impl< Config >& Value_impl< Config >::operator=( const Value_impl& lhs )
     {
@@ -308,6 +365,21 @@ namespace json_spirit
         return *this;
     }
 
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    template< class Config >
+    Value_impl< Config >& Value_impl< Config >::operator=( Value_impl&& lhs )
+    {
+        if( this != &lhs )
+        {
+            type_ = lhs.type_;
+            v_ = std::move( lhs.v_ );
+            is_uint64_ = lhs.is_uint64_;
+        }
+
+        return *this;
+    }
+#endif
+
     template< class Config >
     bool Value_impl< Config >::operator==( const Value_impl& lhs ) const
     {
@@ -62,6 +62,12 @@ public:
 
    int verbose() const { return verbose_; }
 
+   // cap (in megabytes) on the aggregate memory consumed by in-memory
+   // translation units -- when exceeded the least recently used units
+   // are evicted (0 means no limit)
+   void setMemoryLimitMb(int limitMb) { memoryLimitMb_ = limitMb; }
+   int memoryLimitMb() const { return memoryLimitMb_; }
+
    // functions used to keep the index "hot" based on recent user edits
    void primeEditorTranslationUnit(const std::string& filename);
    void reprimeEditorTranslationUnit(const std::string& filename);
@@ -88,23 +94,31 @@ private:
 
    struct StoredTranslationUnit
    {
-      StoredTranslationUnit() : lastWriteTime(0), tu(NULL) {}
+      StoredTranslationUnit() : lastWriteTime(0), tu(NULL), lastUsed(0) {}
       StoredTranslationUnit(const std::vector<std::string>& compileArgs,
                             std::time_t lastWriteTime,
                             CXTranslationUnit tu)
-         : compileArgs(compileArgs), lastWriteTime(lastWriteTime), tu(tu)
+         : compileArgs(compileArgs), lastWriteTime(lastWriteTime), tu(tu),
+           lastUsed(0)
       {
       }
       std::vector<std::string> compileArgs;
       std::time_t lastWriteTime;
       CXTranslationUnit tu;
+      unsigned long lastUsed;
    };
    typedef std::map<std::string,StoredTranslationUnit> TranslationUnits;
    TranslationUnits translationUnits_;
 
+   // evict least recently used translation units until we are under the
+   // memory limit (never evicts the protected filename)
+   void enforceMemoryLimit(const std::string& protectedFilename);
+
    CompilationDatabase compilationDB_;
 
    int verbose_;
+   int memoryLimitMb_;
+   unsigned long accessCounter_;
 };
 
 } // namespace libclang
@@ -82,6 +82,9 @@ public:
                                       unsigned line,
                                       unsigned column) const;
 
+   // total memory (in bytes) attributed to this translation unit
+   unsigned long getMemoryUsage() const;
+
    void printResourceUsage(std::ostream& ostr, bool detailed = false) const;
 
 private:
@@ -18,9 +18,11 @@
 
 #include <map>
 #include <iosfwd>
+#include <string>
 #include <vector>
 
 #include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include "clang-c/Index.h"
 
@@ -34,9 +36,19 @@ public:
    UnsavedFiles() {}
    virtual ~UnsavedFiles();
 
+   // update with a shared buffer -- no copy of the contents is made, so
+   // the buffer must not be mutated for the lifetime of the shared_ptr
+   // (callers with document storage can use the shared_ptr aliasing
+   // constructor to reference it directly)
+   void update(const std::string& filename,
+               boost::shared_ptr<const std::string> pContents,
+               bool dirty);
+
+   // update with a copy of the passed contents
    void update(const std::string& filename,
                const std::string& contents,
                bool dirty);
+
    void remove(const std::string& filename);
    void removeAll();
 
@@ -44,7 +56,18 @@ public:
    unsigned numUnsavedFiles() { return static_cast<unsigned>(files_.size()); }
 
 private:
-   // vector of unsaved files we pass to various clang functions
+   // shared buffers backing the CXUnsavedFile entries (the filename is
+   // heap-allocated as well so the pointers stored in files_ remain
+   // stable across vector reallocations)
+   struct UnsavedFile
+   {
+      boost::shared_ptr<const std::string> pFilename;
+      boost::shared_ptr<const std::string> pContents;
+   };
+   std::vector<UnsavedFile> storage_;
+
+   // vector of unsaved files we pass to various clang functions (entries
+   // point into the buffers held by storage_)
    std::vector<CXUnsavedFile> files_;
 };
 
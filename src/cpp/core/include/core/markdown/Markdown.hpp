@@ -17,6 +17,9 @@
 #define CORE_MARKDOWN_MARKDOWN_HPP
 
 #include <string>
+#include <vector>
+
+#include <boost/function.hpp>
 
 namespace rstudio {
 namespace core {
@@ -101,6 +104,31 @@ Error markdownToHTML(const std::string& markdownInput,
                      const HTMLOptions& htmlOptions,
                      std::string* pHTMLOutput);
 
+// sink which receives rendered HTML incrementally (see the streaming
+// markdownToHTML overload below)
+typedef boost::function<void(const std::string&)> HTMLSink;
+
+// split markdown into independently renderable top-level segments (cut at
+// ATX headings which sit outside fenced code blocks). reference link
+// definitions are shared between segments (a link can be used in one
+// segment and defined in another) so they're also collected into
+// *pRefDefs for callers to fold into each segment's render.
+void splitMarkdownSegments(const std::string& markdownInput,
+                           std::vector<std::string>* pSegments,
+                           std::string* pRefDefs);
+
+// render markdown to HTML segment-by-segment, emitting the HTML for each
+// top-level segment to the sink as soon as it's rendered; for large
+// documents the caller can begin consuming output for the head of the
+// document immediately and peak memory is bounded by the largest segment
+// rather than the document. a table of contents requires the whole
+// document, so htmlOptions.toc falls back to rendering (and emitting) in
+// one piece.
+Error markdownToHTML(const std::string& markdownInput,
+                     const Extensions& extensions,
+                     const HTMLOptions& htmlOptions,
+                     const HTMLSink& htmlSink);
+
 
 bool isMathJaxRequired(const std::string& htmlOutput);
 
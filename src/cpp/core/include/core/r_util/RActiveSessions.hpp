@@ -17,6 +17,8 @@
 #ifndef CORE_R_UTIL_ACTIVE_SESSIONS_HPP
 #define CORE_R_UTIL_ACTIVE_SESSIONS_HPP
 
+#include <map>
+
 #include <boost/noncopyable.hpp>
 
 #include <core/Error.hpp>
@@ -339,6 +341,12 @@ private:
    std::string id_;
    FilePath scratchPath_;
    FilePath propertiesPath_;
+
+   // cache of property values already read or written through this
+   // object -- properties are only ever written by the process that owns
+   // the session, so repeated reads (e.g. during list/sort) don't need
+   // to hit the property files again
+   mutable std::map<std::string, std::string> propertyCache_;
 };
 
 
@@ -124,6 +124,36 @@ struct RProjectConfig
    std::string defaultOpenDocs;
 };
 
+// scoped description of what differs between two project configs. used
+// by consumers to react only to the settings they actually depend on
+// (rather than redoing all config-dependent work on every edit)
+struct RProjectConfigDiff
+{
+   RProjectConfigDiff()
+      : any(false),
+        workspace(false),
+        editor(false),
+        indexing(false),
+        build(false),
+        authoring(false),
+        rVersion(false)
+   {
+   }
+
+   bool any;        // some field (including ones below) changed
+   bool workspace;  // save/restore workspace, history, child processes,
+                    // Rprofile execution
+   bool editor;     // whitespace, line endings, encoding
+   bool indexing;   // code indexing enabled/disabled
+   bool build;      // build type plus package/makefile/website/custom
+                    // paths and args
+   bool authoring;  // sweave engine, latex program, root document
+   bool rVersion;   // default R version
+};
+
+RProjectConfigDiff computeConfigDiff(const RProjectConfig& oldConfig,
+                                     const RProjectConfig& newConfig);
+
 Error findProjectFile(FilePath filePath,
                       FilePath anchorPath,
                       FilePath* pProjPath);
@@ -372,6 +372,21 @@ public:
       inferredPkgNames_.push_back(packageName);
       s_allInferredPkgNames_.insert(packageName);
    }
+
+   // record an inferred package in this index only, without touching the
+   // global (static) set -- the static set is not synchronized so indexes
+   // built on background threads must use this and then have
+   // registerInferredPackages called on the main thread
+   void addInferredPackageLocal(const std::string& packageName)
+   {
+      inferredPkgNames_.push_back(packageName);
+   }
+
+   void registerInferredPackages()
+   {
+      s_allInferredPkgNames_.insert(inferredPkgNames_.begin(),
+                                    inferredPkgNames_.end());
+   }
    
    static void addGloballyInferredPackage(const std::string& pkgName)
    {
@@ -410,15 +425,35 @@ public:
    {
       items_.push_back(item);
    }
-   
+
    const std::vector<RSourceItem>& items() const
    {
       return items_;
    }
 
+   // symbol use sites recorded during tokenization (1-based line and
+   // column, matching RSourceItem). these support reverse-reference
+   // lookups (find all uses of a symbol) without rescanning the source
+   typedef std::pair<std::size_t, std::size_t> ReferencePosition;
+   typedef std::map<std::string, std::vector<ReferencePosition> >
+                                                            ReferenceMap;
+
+   void addReference(const std::string& name,
+                     std::size_t line,
+                     std::size_t column)
+   {
+      references_[name].push_back(ReferencePosition(line, column));
+   }
+
+   const ReferenceMap& references() const
+   {
+      return references_;
+   }
+
 private:
    std::string context_;
    std::vector<RSourceItem> items_;
+   ReferenceMap references_;
    
    // private fields related to the current set of library completions
    // NOTE: each index tracks the 'library' calls encountered within,
@@ -95,7 +95,7 @@ public:
    // accessors
    TokenType type() const { return type_; }
    std::wstring content() const { return std::wstring(begin_, end_); }
-   const std::string& contentAsUtf8() const;
+   std::string contentAsUtf8() const;
    std::size_t offset() const { return offset_; }
    std::size_t length() const { return end_ - begin_; }
    std::size_t row() const { return row_; }
@@ -177,10 +177,14 @@ public:
    }
 
 private:
-   std::wstring emptyToken_;
+   // shared storage backing default-constructed tokens -- tokens carry
+   // only iterators into their source buffer, so a vector of them is a
+   // flat arena of token metadata with no per-token allocations
+   static const std::wstring& emptyTokenData();
+
    TokenType type_ = TokenType::ERR;
-   std::wstring::const_iterator begin_ = emptyToken_.cbegin();
-   std::wstring::const_iterator end_ = emptyToken_.cend();
+   std::wstring::const_iterator begin_ = emptyTokenData().begin();
+   std::wstring::const_iterator end_ = emptyTokenData().end();
    std::size_t offset_ = -1;
    std::size_t row_ = 0;
    std::size_t column_ = 0;
@@ -203,6 +207,17 @@ public:
    {
    }
 
+   // tokenize without copying the source buffer. the buffer must outlive
+   // both this tokenizer and any tokens it yields
+   explicit RTokenizer(const std::wstring* pData)
+      : begin_(pData->begin()),
+        end_(pData->end()),
+        pos_(pData->begin()),
+        row_(0),
+        column_(0)
+   {
+   }
+
    virtual ~RTokenizer() {}
 
    // COPYING: boost::noncopyable
@@ -281,8 +296,34 @@ public:
    const_iterator end() const { return tokens_.end(); }
    
    explicit RTokens(const std::wstring& code, int flags = None)
-      : tokenizer_(code)
+      : code_(code), tokenizer_(&code_)
+   {
+      tokenize(code_.size(), flags);
+   }
+
+   // tokenize without copying the source buffer -- *pCode must outlive
+   // this object (tokens are iterators into it)
+   explicit RTokens(const std::wstring* pCode, int flags = None)
+      : tokenizer_(pCode)
+   {
+      tokenize(pCode->size(), flags);
+   }
+
+   friend std::ostream& operator <<(std::ostream& os,
+                                    const RTokens& rTokens)
+   {
+      for (std::size_t i = 0, n = rTokens.size(); i < n; ++i)
+         os << rTokens.atUnsafe(i) << std::endl;
+      return os;
+   }
+
+private:
+   void tokenize(std::size_t codeSize, int flags)
    {
+      // a rough lower bound on token density so that the token vector
+      // isn't grown one doubling at a time for large files
+      tokens_.reserve(codeSize / 8);
+
       while (RToken token = tokenizer_.nextToken())
       {
          if ((flags & StripWhitespace) && token.type() == RToken::WHITESPACE)
@@ -294,16 +335,9 @@ public:
          push_back(token);
       }
    }
-   
-   friend std::ostream& operator <<(std::ostream& os,
-                                    const RTokens& rTokens)
-   {
-      for (std::size_t i = 0, n = rTokens.size(); i < n; ++i)
-         os << rTokens.atUnsafe(i) << std::endl;
-      return os;
-   }
 
 private:
+    std::wstring code_;
     RTokenizer tokenizer_;
     Tokens tokens_;
     RToken dummyToken_;
@@ -125,6 +125,22 @@ std::vector<RVersion> enumerateRVersions(
                               const FilePath& ldPathsScript,
                               const std::string& ldLibraryPath);
 
+// enable a persistent store of R environment detection results. probing
+// an R installation spawns a full R process, and the answers only change
+// when the installation itself changes -- results are keyed by a
+// fingerprint of the R script (path, modification time, size) so that
+// unchanged installations are never re-probed
+void initializeRVersionDetectionCache(const FilePath& cacheFilePath);
+
+bool detectREnvironmentCached(const FilePath& rScriptPath,
+                              const FilePath& ldPathsScript,
+                              const std::string& ldLibraryPath,
+                              std::string* pRScriptPath,
+                              std::string* pVersion,
+                              core::system::Options* pEnvironment,
+                              std::string* pErrMsg,
+                              const std::string& prelaunchScript = "");
+
 RVersion selectVersion(const std::string& number,
                        const std::string& rHomeDir,
                        std::vector<RVersion> versions);
@@ -50,6 +50,9 @@ public:
    Error checkSpelling(const std::string& word,
                        bool *pCorrect);
 
+   Error checkSpelling(const std::vector<std::string>& words,
+                       std::vector<bool>* pCorrect);
+
    Error suggestionList(const std::string& word,
                         std::vector<std::string>* pSugs);
 
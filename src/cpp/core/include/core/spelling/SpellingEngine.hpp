@@ -38,6 +38,12 @@ public:
    virtual Error checkSpelling(const std::string& word,
                                bool *pCorrect) = 0;
 
+   // check a batch of words with a single call -- on return *pCorrect
+   // holds one entry per word; words which could not be checked (e.g.
+   // due to an iconv failure) are logged and reported as correct
+   virtual Error checkSpelling(const std::vector<std::string>& words,
+                               std::vector<bool>* pCorrect) = 0;
+
    virtual Error suggestionList(const std::string& word,
                                 std::vector<std::string>* pSugs) = 0;
 
@@ -39,12 +39,22 @@ namespace system {
 struct FileScannerOptions
 {
    FileScannerOptions()
-      : recursive(false), yield(false)
+      : recursive(false), yield(false), concurrentScanners(1)
    {
    }
 
    bool recursive;
    bool yield;
+
+   // number of directories to scan concurrently (posix only; other
+   // platforms always scan sequentially). values > 1 enable a parallel
+   // scan in which subtrees are partitioned across a pool of worker
+   // threads -- useful for large trees on high-latency filesystems
+   // (e.g. NFS). note that in parallel mode the filter and
+   // onBeforeScanDir callbacks are invoked from worker threads and so
+   // must be thread-safe
+   std::size_t concurrentScanners;
+
    boost::function<bool(const FileInfo&)> filter;
    boost::function<Error(const FileInfo&)> onBeforeScanDir;
 };
@@ -60,6 +70,13 @@ inline Error scanFiles(const FileInfo& fromRoot,
    return scanFiles(pTree->set_head(fromRoot), options, pTree);
 }
 
+// enumerate a single directory, statting each entry exactly once and
+// caching the results in the returned FileInfo objects (so callers don't
+// stat again for type/size/mtime). unlike scanFiles, symlinks are
+// traversed (matching FilePath::children); entries which disappear
+// mid-enumeration are skipped
+Error readDirectory(const FilePath& dirPath, std::vector<FileInfo>* pEntries);
+
 
 } // namespace system
 } // namespace core
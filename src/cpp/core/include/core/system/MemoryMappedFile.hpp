@@ -0,0 +1,66 @@
+/*
+ * MemoryMappedFile.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_SYSTEM_MEMORY_MAPPED_FILE_HPP
+#define CORE_SYSTEM_MEMORY_MAPPED_FILE_HPP
+
+#include <string>
+
+#include <boost/utility.hpp>
+
+#include <core/Error.hpp>
+
+namespace rstudio {
+namespace core {
+
+class FilePath;
+
+namespace system {
+
+// read-only memory mapped file. the mapping remains valid until close is
+// called (or the object is destroyed) so instances are typically held in
+// a shared_ptr and handed to consumers which need to extend the lifetime
+// of the mapped pages (e.g. http::Response::addBodyBuffer)
+class MemoryMappedFile : boost::noncopyable
+{
+public:
+   MemoryMappedFile();
+   virtual ~MemoryMappedFile();
+
+   // map the file read-only (note that zero-length files yield a
+   // successful open with data() == NULL and size() == 0)
+   Error open(const FilePath& filePath);
+
+   void close();
+
+   bool isOpen() const { return open_; }
+   const void* data() const { return data_; }
+   std::size_t size() const { return size_; }
+
+private:
+   bool open_;
+   void* data_;
+   std::size_t size_;
+#ifdef _WIN32
+   void* hFile_;
+   void* hMapping_;
+#endif
+};
+
+} // namespace system
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_SYSTEM_MEMORY_MAPPED_FILE_HPP
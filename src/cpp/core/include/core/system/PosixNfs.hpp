@@ -34,7 +34,12 @@ namespace nfs {
 
 core::Error statWithCacheClear(const core::FilePath& path, bool *pCleared,
                                struct stat* pSt);
-   
+
+// Determines whether 'path' resides on an NFS mount. Returns an error when
+// the filesystem type cannot be queried (in which case *pIsNfs is false).
+core::Error isNfs(const core::FilePath& path, bool* pIsNfs);
+
+
 } // nfs
 } // namespace system
 } // namespace core
@@ -112,7 +112,8 @@ struct ProcessOptions
         redirectStdErrToStdOut(false),
         reportHasSubprocs(false),
         trackCwd(false),
-        threadSafe(false)
+        threadSafe(false),
+        fastLaunch(false)
 #endif
    {
    }
@@ -182,6 +183,17 @@ struct ProcessOptions
    // and cannot accomplish many things that the thread unsafe mode can
    bool threadSafe;
 
+#ifndef _WIN32
+   // launch the child via posix_spawn with close-on-exec pipes rather than
+   // fork + exec. this avoids both duplicating the parent address space
+   // and the close-every-descriptor loop which runs before exec (a real
+   // cost when the file descriptor limit is large). ignored (falls back
+   // to fork + exec) when used with options which require running code
+   // between fork and exec: pseudoterminal, detachSession, onAfterFork,
+   // runAsUser and workingDir
+   bool fastLaunch;
+#endif
+
    // If not empty, these two provide paths that stdout and stderr
    // (respectively) should be redirected to. Note that this ONLY works
    // if you use runCommand, not runProgram, as we use the shell to do
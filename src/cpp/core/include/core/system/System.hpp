@@ -202,6 +202,14 @@ void initializeLog(const std::string& programIdentity,
                    int logLevel,
                    const FilePath& logDir);
 
+// variant of initializeLog which performs the file writes from a
+// background thread (see AsyncLogWriter) -- appropriate for servers
+// where verbose logging is enabled and log i/o shouldn't add latency
+// to request handling
+void initializeAsyncLog(const std::string& programIdentity,
+                        int logLevel,
+                        const FilePath& logDir);
+
 Error setExitFunction(void (*exitFunction) (void));
    
 // exit
@@ -0,0 +1,104 @@
+/*
+ * DelimitedReader.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_TEXT_DELIMITED_READER_HPP
+#define CORE_TEXT_DELIMITED_READER_HPP
+
+#include <climits>
+#include <string>
+#include <vector>
+
+namespace rstudio {
+namespace core {
+
+class Error;
+class FilePath;
+
+namespace text {
+
+// typed storage for a parsed column. integer and logical values use
+// kDelimitedNAInteger to represent missing values (it matches R's
+// NA_INTEGER so columns can be handed to R without translation) and
+// doubles use NaN
+enum DelimitedColumnType
+{
+   DelimitedColumnLogical   = 0,
+   DelimitedColumnInteger   = 1,
+   DelimitedColumnDouble    = 2,
+   DelimitedColumnCharacter = 3
+};
+
+#define kDelimitedNAInteger INT_MIN
+
+struct DelimitedColumn
+{
+   DelimitedColumn()
+      : type(DelimitedColumnCharacter), parseFailures(0)
+   {
+   }
+
+   std::string name;
+   DelimitedColumnType type;
+
+   // exactly one of these is populated, per type
+   std::vector<int> intData;            // logical and integer columns
+   std::vector<double> doubleData;      // double columns
+   std::vector<std::string> textData;   // character columns
+
+   // values which could not be parsed as the column's type (stored as
+   // missing); a large count suggests re-reading as character
+   std::size_t parseFailures;
+};
+
+struct DelimitedReadOptions
+{
+   DelimitedReadOptions()
+      : delimiter(','), header(true), numThreads(4)
+   {
+   }
+
+   char delimiter;
+   bool header;
+   int numThreads;
+
+   // per-column types; when empty, types are inferred from rows sampled
+   // throughout the file
+   std::vector<DelimitedColumnType> columnTypes;
+};
+
+// parse a single delimited record (quote-aware, so quoted fields may
+// contain delimiters and newlines) starting at *pPos; advances *pPos
+// past the record's terminating newline. returns false at end of input.
+bool parseDelimitedRecord(const char* pData,
+                          std::size_t size,
+                          std::size_t* pPos,
+                          char delimiter,
+                          std::vector<std::string>* pFields);
+
+// read a delimited text file into typed columns. the file is memory
+// mapped and split into ranges parsed on a small thread pool; ranges
+// are aligned to record boundaries (including quoted fields spanning
+// lines) by a quote-parity prescan. rows with too few fields are padded
+// with missing values and extra fields are dropped.
+Error readDelimitedFile(const FilePath& filePath,
+                        const DelimitedReadOptions& options,
+                        std::vector<DelimitedColumn>* pColumns,
+                        std::size_t* pNumRows);
+
+} // namespace text
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_TEXT_DELIMITED_READER_HPP
@@ -16,9 +16,12 @@
 #include <core/json/Json.hpp>
 #include <core/json/JsonRpc.hpp>
 
+#include <cstdio>
 #include <cstdlib>
 #include <sstream>
 
+#include <boost/cstdint.hpp>
+
 #include <boost/format.hpp>
 #include <boost/foreach.hpp>
 #include <boost/scoped_array.hpp>
@@ -136,9 +139,574 @@ bool parse(const std::string& input, Value* pValue)
    return false;
 }
 
+namespace {
+
+// hand-rolled recursive descent scanner used by parseStream. unlike the
+// spirit-based json::parse above it allocates only for the string or
+// member name currently being delivered to the handler, so large bodies
+// can be consumed without building (or locking around) a DOM
+class SaxScanner : boost::noncopyable
+{
+public:
+   SaxScanner(const std::string& input, SaxHandler* pHandler)
+      : pos_(input.data()),
+        end_(input.data() + input.length()),
+        pHandler_(pHandler)
+   {
+   }
+
+   bool scan()
+   {
+      skipWhitespace();
+      if (!scanValue())
+         return false;
+      skipWhitespace();
+
+      // trailing garbage is malformed
+      return pos_ == end_;
+   }
+
+private:
+   void skipWhitespace()
+   {
+      while (pos_ != end_ &&
+             (*pos_ == ' ' || *pos_ == '\t' || *pos_ == '\r' || *pos_ == '\n'))
+      {
+         ++pos_;
+      }
+   }
+
+   bool scanLiteral(const char* literal)
+   {
+      while (*literal != '\0')
+      {
+         if (pos_ == end_ || *pos_ != *literal)
+            return false;
+         ++pos_;
+         ++literal;
+      }
+      return true;
+   }
+
+   bool scanValue()
+   {
+      if (pos_ == end_)
+         return false;
+
+      switch (*pos_)
+      {
+         case '{':
+            return scanObject();
+         case '[':
+            return scanArray();
+         case '"':
+         {
+            std::string value;
+            return scanString(&value) && pHandler_->onString(value);
+         }
+         case 't':
+            return scanLiteral("true") && pHandler_->onBool(true);
+         case 'f':
+            return scanLiteral("false") && pHandler_->onBool(false);
+         case 'n':
+            return scanLiteral("null") && pHandler_->onNull();
+         default:
+            return scanNumber();
+      }
+   }
+
+   bool scanObject()
+   {
+      ++pos_; // consume '{'
+      if (!pHandler_->onStartObject())
+         return false;
+
+      skipWhitespace();
+      if (pos_ != end_ && *pos_ == '}')
+      {
+         ++pos_;
+         return pHandler_->onEndObject();
+      }
+
+      while (true)
+      {
+         skipWhitespace();
+         std::string name;
+         if (!scanString(&name) || !pHandler_->onMemberName(name))
+            return false;
+
+         skipWhitespace();
+         if (pos_ == end_ || *pos_++ != ':')
+            return false;
+
+         skipWhitespace();
+         if (!scanValue())
+            return false;
+
+         skipWhitespace();
+         if (pos_ == end_)
+            return false;
+         else if (*pos_ == ',')
+            ++pos_;
+         else if (*pos_ == '}')
+         {
+            ++pos_;
+            return pHandler_->onEndObject();
+         }
+         else
+            return false;
+      }
+   }
+
+   bool scanArray()
+   {
+      ++pos_; // consume '['
+      if (!pHandler_->onStartArray())
+         return false;
+
+      skipWhitespace();
+      if (pos_ != end_ && *pos_ == ']')
+      {
+         ++pos_;
+         return pHandler_->onEndArray();
+      }
+
+      while (true)
+      {
+         skipWhitespace();
+         if (!scanValue())
+            return false;
+
+         skipWhitespace();
+         if (pos_ == end_)
+            return false;
+         else if (*pos_ == ',')
+            ++pos_;
+         else if (*pos_ == ']')
+         {
+            ++pos_;
+            return pHandler_->onEndArray();
+         }
+         else
+            return false;
+      }
+   }
+
+   bool scanHex(int* pDigit)
+   {
+      if (pos_ == end_)
+         return false;
+
+      char ch = *pos_++;
+      if (ch >= '0' && ch <= '9')
+         *pDigit = ch - '0';
+      else if (ch >= 'a' && ch <= 'f')
+         *pDigit = ch - 'a' + 10;
+      else if (ch >= 'A' && ch <= 'F')
+         *pDigit = ch - 'A' + 10;
+      else
+         return false;
+
+      return true;
+   }
+
+   bool scanUnicodeEscape(std::string* pValue)
+   {
+      unsigned int codepoint = 0;
+      for (int i = 0; i < 4; i++)
+      {
+         int digit;
+         if (!scanHex(&digit))
+            return false;
+         codepoint = (codepoint << 4) | digit;
+      }
+
+      // utf-16 surrogate pair (escaped as two \uXXXX sequences)
+      if (codepoint >= 0xD800 && codepoint <= 0xDBFF)
+      {
+         if (pos_ == end_ || *pos_++ != '\\')
+            return false;
+         if (pos_ == end_ || *pos_++ != 'u')
+            return false;
+
+         unsigned int low = 0;
+         for (int i = 0; i < 4; i++)
+         {
+            int digit;
+            if (!scanHex(&digit))
+               return false;
+            low = (low << 4) | digit;
+         }
+         if (low < 0xDC00 || low > 0xDFFF)
+            return false;
+
+         codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+      }
+
+      // encode as utf-8
+      if (codepoint < 0x80)
+      {
+         pValue->push_back(static_cast<char>(codepoint));
+      }
+      else if (codepoint < 0x800)
+      {
+         pValue->push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+         pValue->push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+      }
+      else if (codepoint < 0x10000)
+      {
+         pValue->push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+         pValue->push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+         pValue->push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+      }
+      else
+      {
+         pValue->push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+         pValue->push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+         pValue->push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+         pValue->push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+      }
+
+      return true;
+   }
+
+   bool scanString(std::string* pValue)
+   {
+      if (pos_ == end_ || *pos_++ != '"')
+         return false;
+
+      while (pos_ != end_)
+      {
+         char ch = *pos_++;
+         if (ch == '"')
+            return true;
+         else if (ch != '\\')
+            pValue->push_back(ch);
+         else
+         {
+            if (pos_ == end_)
+               return false;
+
+            char escape = *pos_++;
+            switch (escape)
+            {
+               case '"':  pValue->push_back('"');  break;
+               case '\\': pValue->push_back('\\'); break;
+               case '/':  pValue->push_back('/');  break;
+               case 'b':  pValue->push_back('\b'); break;
+               case 'f':  pValue->push_back('\f'); break;
+               case 'n':  pValue->push_back('\n'); break;
+               case 'r':  pValue->push_back('\r'); break;
+               case 't':  pValue->push_back('\t'); break;
+               case 'u':
+                  if (!scanUnicodeEscape(pValue))
+                     return false;
+                  break;
+               default:
+                  return false;
+            }
+         }
+      }
+
+      // unterminated string
+      return false;
+   }
+
+   bool scanNumber()
+   {
+      const char* start = pos_;
+      bool isDouble = false;
+
+      if (pos_ != end_ && *pos_ == '-')
+         ++pos_;
+
+      while (pos_ != end_ && (*pos_ >= '0' && *pos_ <= '9'))
+         ++pos_;
+
+      if (pos_ != end_ && *pos_ == '.')
+      {
+         isDouble = true;
+         ++pos_;
+         while (pos_ != end_ && (*pos_ >= '0' && *pos_ <= '9'))
+            ++pos_;
+      }
+
+      if (pos_ != end_ && (*pos_ == 'e' || *pos_ == 'E'))
+      {
+         isDouble = true;
+         ++pos_;
+         if (pos_ != end_ && (*pos_ == '+' || *pos_ == '-'))
+            ++pos_;
+         while (pos_ != end_ && (*pos_ >= '0' && *pos_ <= '9'))
+            ++pos_;
+      }
+
+      if (pos_ == start)
+         return false;
+
+      std::string token(start, pos_);
+      char* tokenEnd = NULL;
+      if (isDouble)
+      {
+         double value = ::strtod(token.c_str(), &tokenEnd);
+         if (*tokenEnd != '\0')
+            return false;
+         return pHandler_->onDouble(value);
+      }
+      else
+      {
+         int64_t value = ::strtoll(token.c_str(), &tokenEnd, 10);
+         if (*tokenEnd != '\0')
+            return false;
+         return pHandler_->onInt(value);
+      }
+   }
+
+private:
+   const char* pos_;
+   const char* end_;
+   SaxHandler* pHandler_;
+};
+
+// extracts the top-level "method" member of a json-rpc request and then
+// stops the parse, skipping over (but still validating) any members that
+// precede it
+class MethodScanHandler : public SaxHandler
+{
+public:
+   MethodScanHandler()
+      : depth_(0), pendingMethod_(false)
+   {
+   }
+
+   const std::string& method() const { return method_; }
+
+   bool onStartObject()
+   {
+      depth_++;
+      return true;
+   }
+
+   bool onEndObject()
+   {
+      depth_--;
+      pendingMethod_ = false;
+      return true;
+   }
+
+   bool onStartArray()
+   {
+      depth_++;
+      return true;
+   }
+
+   bool onEndArray()
+   {
+      depth_--;
+      return true;
+   }
+
+   bool onMemberName(const std::string& name)
+   {
+      pendingMethod_ = (depth_ == 1 && name == "method");
+      return true;
+   }
+
+   bool onString(const std::string& value)
+   {
+      if (pendingMethod_)
+      {
+         method_ = value;
+
+         // stop the parse -- we have what we came for
+         return false;
+      }
+      return true;
+   }
+
+private:
+   int depth_;
+   bool pendingMethod_;
+   std::string method_;
+};
+
+} // anonymous namespace
+
+bool parseStream(const std::string& input, SaxHandler* pHandler)
+{
+   return SaxScanner(input, pHandler).scan();
+}
+
+bool parseMethod(const std::string& input, std::string* pMethod)
+{
+   // note that the handler terminates the parse as soon as it sees the
+   // method (parseStream returns false in that case) so we key success
+   // off of whether a method was captured rather than the parse result
+   MethodScanHandler handler;
+   parseStream(input, &handler);
+   if (handler.method().empty())
+      return false;
+
+   *pMethod = handler.method();
+   return true;
+}
+
+namespace {
+
+// compact serialization directly into a string buffer. the json_spirit
+// generator formats every token through an ostream, which allocates and
+// locale-checks per token; large payloads (data viewer, environment
+// listings) spend measurable cpu there so the hot compact path formats
+// numbers into stack buffers and appends escaped strings in bulk runs
+
+void writeEscapedString(const std::string& value, std::string* pOutput)
+{
+   pOutput->push_back('"');
+
+   const char* pBegin = value.data();
+   const char* pEnd = pBegin + value.size();
+   const char* pRun = pBegin;
+   for (const char* pCh = pBegin; pCh != pEnd; ++pCh)
+   {
+      unsigned char ch = static_cast<unsigned char>(*pCh);
+
+      // bytes requiring no escape extend the current run (the common
+      // case by far -- utf-8 continuation bytes are all >= 0x80)
+      if (ch >= 0x20 && ch != '"' && ch != '\\')
+         continue;
+
+      // flush the unescaped run in one append
+      pOutput->append(pRun, pCh - pRun);
+      pRun = pCh + 1;
+
+      switch (ch)
+      {
+         case '"':  pOutput->append("\\\"", 2); break;
+         case '\\': pOutput->append("\\\\", 2); break;
+         case '\b': pOutput->append("\\b", 2);  break;
+         case '\f': pOutput->append("\\f", 2);  break;
+         case '\n': pOutput->append("\\n", 2);  break;
+         case '\r': pOutput->append("\\r", 2);  break;
+         case '\t': pOutput->append("\\t", 2);  break;
+         default:
+         {
+            // remaining control characters as \u00XX
+            static const char kHexDigits[] = "0123456789ABCDEF";
+            char unicode[6] = { '\\', 'u', '0', '0',
+                                kHexDigits[(ch >> 4) & 0xF],
+                                kHexDigits[ch & 0xF] };
+            pOutput->append(unicode, 6);
+            break;
+         }
+      }
+   }
+
+   pOutput->append(pRun, pEnd - pRun);
+   pOutput->push_back('"');
+}
+
+void writeUInt64(boost::uint64_t value, std::string* pOutput)
+{
+   char buffer[20];
+   char* pCh = buffer + sizeof(buffer);
+   do
+   {
+      *--pCh = static_cast<char>('0' + (value % 10));
+      value /= 10;
+   }
+   while (value != 0);
+
+   pOutput->append(pCh, buffer + sizeof(buffer) - pCh);
+}
+
+void writeInt64(boost::int64_t value, std::string* pOutput)
+{
+   boost::uint64_t magnitude = static_cast<boost::uint64_t>(value);
+   if (value < 0)
+   {
+      pOutput->push_back('-');
+      magnitude = 0 - magnitude;
+   }
+   writeUInt64(magnitude, pOutput);
+}
+
+void writeDouble(double value, std::string* pOutput)
+{
+   // shortest representation which round trips a double (the spirit
+   // generator's fixed showpoint/precision(16) form parses identically
+   // but pads with trailing zeros)
+   char buffer[32];
+   int written = ::snprintf(buffer, sizeof(buffer), "%.17g", value);
+   if (written > 0 && written < static_cast<int>(sizeof(buffer)))
+      pOutput->append(buffer, written);
+}
+
+void writeValue(const Value& value, std::string* pOutput)
+{
+   switch (value.type())
+   {
+      case json_spirit::obj_type:
+      {
+         pOutput->push_back('{');
+         const Object& object = value.get_obj();
+         for (Object::const_iterator it = object.begin();
+              it != object.end();
+              ++it)
+         {
+            if (it != object.begin())
+               pOutput->push_back(',');
+            writeEscapedString(it->first, pOutput);
+            pOutput->push_back(':');
+            writeValue(it->second, pOutput);
+         }
+         pOutput->push_back('}');
+         break;
+      }
+      case json_spirit::array_type:
+      {
+         pOutput->push_back('[');
+         const Array& array = value.get_array();
+         for (Array::const_iterator it = array.begin();
+              it != array.end();
+              ++it)
+         {
+            if (it != array.begin())
+               pOutput->push_back(',');
+            writeValue(*it, pOutput);
+         }
+         pOutput->push_back(']');
+         break;
+      }
+      case json_spirit::str_type:
+         writeEscapedString(value.get_str(), pOutput);
+         break;
+      case json_spirit::bool_type:
+         pOutput->append(value.get_bool() ? "true" : "false");
+         break;
+      case json_spirit::int_type:
+         if (value.is_uint64())
+            writeUInt64(value.get_uint64(), pOutput);
+         else
+            writeInt64(value.get_int64(), pOutput);
+         break;
+      case json_spirit::real_type:
+         writeDouble(value.get_real(), pOutput);
+         break;
+      case json_spirit::null_type:
+      default:
+         pOutput->append("null");
+         break;
+   }
+}
+
+} // anonymous namespace
+
 void write(const Value& value, std::ostream& os)
 {
-   json_spirit::write(value, os);
+   std::string output;
+   output.reserve(1024);
+   writeValue(value, &output);
+   os.write(output.data(), output.length());
 }
 
 void writeFormatted(const Value& value, std::ostream& os)
@@ -148,7 +716,10 @@ void writeFormatted(const Value& value, std::ostream& os)
 
 std::string write(const Value& value)
 {
-   return json_spirit::write(value);
+   std::string output;
+   output.reserve(1024);
+   writeValue(value, &output);
+   return output;
 }
 
 std::string writeFormatted(const Value& value)
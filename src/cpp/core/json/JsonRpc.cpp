@@ -124,6 +124,19 @@ bool parseJsonRpcRequestForMethod(const std::string& input,
                                   json::JsonRpcRequest* pRequest,
                                   http::Response* pResponse)
 {
+   // scan for the method up front using the streaming parser -- for
+   // requests with large bodies (e.g. save_document) this rejects
+   // mismatches without ever materializing a DOM
+   std::string requestMethod;
+   if (json::parseMethod(input, &requestMethod) && requestMethod != method)
+   {
+      Error methodError = Error(errc::MethodNotFound, ERROR_LOCATION);
+      methodError.addProperty("method", requestMethod);
+      LOG_ERROR(methodError);
+      setJsonRpcError(methodError, pResponse);
+      return false;
+   }
+
    // parse request
    Error parseError = parseJsonRpcRequest(input, pRequest) ;
    if (parseError)
@@ -132,7 +145,7 @@ bool parseJsonRpcRequestForMethod(const std::string& input,
       setJsonRpcError(parseError, pResponse);
       return false;
    }
-   
+
    // check for method
    if (pRequest->method != method)
    {
@@ -0,0 +1,153 @@
+/*
+ * JsonTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+
+#include <core/json/Json.hpp>
+
+namespace rstudio {
+namespace core {
+namespace json {
+
+namespace {
+
+// records every event fired during a parse so tests can verify both
+// the event stream and values delivered
+class RecordingHandler : public SaxHandler
+{
+public:
+   std::string events;
+
+   bool onNull()                            { events += "N";  return true; }
+   bool onBool(bool value)                  { events += (value ? "T" : "F");
+                                              return true; }
+   bool onInt(int64_t value)                { events += "i";  return true; }
+   bool onDouble(double value)              { events += "d";  return true; }
+   bool onString(const std::string& value)  { events += "s";  return true; }
+   bool onStartObject()                     { events += "{";  return true; }
+   bool onMemberName(const std::string& name) { events += "m"; return true; }
+   bool onEndObject()                       { events += "}";  return true; }
+   bool onStartArray()                      { events += "[";  return true; }
+   bool onEndArray()                        { events += "]";  return true; }
+};
+
+} // anonymous namespace
+
+context("Streaming JSON parser")
+{
+   test_that("Scalar documents fire the expected events")
+   {
+      RecordingHandler handler;
+      expect_true(parseStream("42", &handler));
+      expect_true(handler.events == "i");
+   }
+
+   test_that("Nested documents fire the expected event stream")
+   {
+      RecordingHandler handler;
+      expect_true(parseStream(
+         "{\"a\": [1, 2.5, null], \"b\": {\"c\": true}}", &handler));
+      expect_true(handler.events == "{m[idN]m{mT}}");
+   }
+
+   test_that("Malformed documents are rejected")
+   {
+      RecordingHandler handler;
+      expect_false(parseStream("{\"a\": }", &handler));
+      expect_false(parseStream("[1, 2", &handler));
+      expect_false(parseStream("{} trailing", &handler));
+      expect_false(parseStream("", &handler));
+   }
+
+   test_that("String escapes are decoded")
+   {
+      class StringHandler : public SaxHandler
+      {
+      public:
+         std::string value;
+         bool onString(const std::string& str) { value = str; return true; }
+      };
+
+      StringHandler handler;
+      expect_true(parseStream("\"a\\n\\\"b\\\"\\u00e9\"", &handler));
+      expect_true(handler.value == "a\n\"b\"\xC3\xA9");
+   }
+
+   test_that("parseMethod extracts the method without a full parse")
+   {
+      std::string method;
+      expect_true(parseMethod(
+         "{\"method\": \"save_document\", \"params\": [1]}", &method));
+      expect_true(method == "save_document");
+   }
+
+   test_that("parseMethod ignores nested method members")
+   {
+      std::string method;
+      expect_true(parseMethod(
+         "{\"params\": [{\"method\": \"inner\"}], \"method\": \"outer\"}",
+         &method));
+      expect_true(method == "outer");
+   }
+
+   test_that("parseMethod fails when no method is present")
+   {
+      std::string method;
+      expect_false(parseMethod("{\"params\": []}", &method));
+      expect_false(parseMethod("not json", &method));
+   }
+}
+
+context("Compact JSON writer")
+{
+   test_that("Values serialize compactly")
+   {
+      Object object;
+      object["a"] = 42;
+      object["b"] = true;
+      object["c"] = Value();
+      Array array;
+      array.push_back("x");
+      array.push_back(-7);
+      object["d"] = array;
+
+      expect_true(write(object) ==
+                  "{\"a\":42,\"b\":true,\"c\":null,\"d\":[\"x\",-7]}");
+   }
+
+   test_that("Strings are escaped")
+   {
+      Value value(std::string("a\n\"b\"\\\x01 caf\xC3\xA9"));
+      expect_true(write(value) == "\"a\\n\\\"b\\\"\\\\\\u0001 caf\xC3\xA9\"");
+   }
+
+   test_that("Numbers round trip through write and parse")
+   {
+      Array array;
+      array.push_back(0.1);
+      array.push_back(boost::int64_t(1234567890123456789LL));
+      array.push_back(-1);
+
+      Value parsed;
+      expect_true(parse(write(array), &parsed));
+      expect_true(parsed.get_array()[0].get_real() == 0.1);
+      expect_true(parsed.get_array()[1].get_int64() == 1234567890123456789LL);
+      expect_true(parsed.get_array()[2].get_int() == -1);
+   }
+}
+
+} // namespace json
+} // namespace core
+} // namespace rstudio
@@ -15,8 +15,12 @@
 
 #include <core/libclang/SourceIndex.hpp>
 
+#include <algorithm>
+#include <utility>
+
 #include <boost/foreach.hpp>
 
+#include <core/AllocationTracker.hpp>
 #include <core/FilePath.hpp>
 #include <core/PerformanceTimer.hpp>
 
@@ -33,8 +37,16 @@ namespace {
 
 inline unsigned applyTranslationUnitOptions(unsigned defaultOptions)
 {
-   // for now just reflect back the defaults
-   return defaultOptions;
+   // ensure that preamble precompilation and code completion caching are
+   // enabled -- these are typically part of the default editing options
+   // however we don't want to depend on the defaults of whichever build
+   // of libclang we happen to have loaded (without the precompiled
+   // preamble every reparse re-lexes all of the headers included at the
+   // top of the file, which for heavily templated code dominates the
+   // cost of the reparse)
+   return defaultOptions |
+          CXTranslationUnit_PrecompiledPreamble |
+          CXTranslationUnit_CacheCompletionResults;
 }
 
 bool isHeaderExtension(const std::string& ex)
@@ -67,6 +79,8 @@ SourceIndex::SourceIndex(CompilationDatabase compilationDB, int verbose)
    verbose_ = verbose;
    index_ = clang().createIndex(0, (verbose_ > 0) ? 1 : 0);
    compilationDB_ = compilationDB;
+   memoryLimitMb_ = 0;
+   accessCounter_ = 0;
 }
 
 SourceIndex::~SourceIndex()
@@ -152,6 +166,11 @@ std::map<std::string,TranslationUnit>
 TranslationUnit SourceIndex::getTranslationUnit(const std::string& filename,
                                                 bool alwaysReparse)
 {
+   // attribute parse-side allocations to the libclang module when the
+   // allocation tracker is on (memory allocated inside libclang itself
+   // bypasses operator new and is covered by getCXTUResourceUsage)
+   core::allocation::Scope allocationScope("libclang_translation_units");
+
    FilePath filePath(filename);
 
    boost::scoped_ptr<core::PerformanceTimer> pTimer;
@@ -187,6 +206,7 @@ TranslationUnit SourceIndex::getTranslationUnit(const std::string& filename,
       {
          if (verbose_ > 0)
             std::cerr << "  (Index already up to date)" << std::endl;
+         stored.lastUsed = ++accessCounter_;
          return TranslationUnit(filename, stored.tu, &unsavedFiles_);
       }
 
@@ -202,8 +222,11 @@ TranslationUnit SourceIndex::getTranslationUnit(const std::string& filename,
             std::cerr << "  " << reason << std::endl;
          }
 
-         unsigned options = applyTranslationUnitOptions(
-                                    clang().defaultReparseOptions(stored.tu));
+         // note: reparse options live in a different flag space than the
+         // CXTranslationUnit_* parsing options (the translation unit
+         // options -- including preamble use -- were fixed when the unit
+         // was first parsed) so we just take the defaults here
+         unsigned options = clang().defaultReparseOptions(stored.tu);
          int ret = clang().reparseTranslationUnit(
                                 stored.tu,
                                 unsavedFiles().numUnsavedFiles(),
@@ -214,6 +237,7 @@ TranslationUnit SourceIndex::getTranslationUnit(const std::string& filename,
          {
             // update last write time
             stored.lastWriteTime = lastWriteTime;
+            stored.lastUsed = ++accessCounter_;
 
             // return it
             return TranslationUnit(filename, stored.tu, &unsavedFiles_);
@@ -259,10 +283,16 @@ TranslationUnit SourceIndex::getTranslationUnit(const std::string& filename,
       translationUnits_[filename] = StoredTranslationUnit(args,
                                                           lastWriteTime,
                                                           tu);
+      translationUnits_[filename].lastUsed = ++accessCounter_;
 
       TranslationUnit unit(filename, tu, &unsavedFiles_);
       if (verbose_ > 0)
          unit.printResourceUsage(std::cerr, false);
+
+      // creating a new translation unit is the only operation which can
+      // grow our aggregate memory usage, so check the limit here
+      enforceMemoryLimit(filename);
+
       return unit;
    }
    else
@@ -272,6 +302,48 @@ TranslationUnit SourceIndex::getTranslationUnit(const std::string& filename,
    }
 }
 
+void SourceIndex::enforceMemoryLimit(const std::string& protectedFilename)
+{
+   // no limit configured
+   if (memoryLimitMb_ <= 0)
+      return;
+
+   unsigned long long limitBytes =
+         static_cast<unsigned long long>(memoryLimitMb_) * 1024 * 1024;
+
+   // measure the memory attributed to each stored translation unit
+   unsigned long long totalBytes = 0;
+   std::map<std::string,unsigned long> usage;
+   std::vector<std::pair<unsigned long,std::string> > lruOrder;
+   BOOST_FOREACH(TranslationUnits::value_type& t, translationUnits_)
+   {
+      TranslationUnit unit(t.first, t.second.tu, &unsavedFiles_);
+      unsigned long bytes = unit.getMemoryUsage();
+      usage[t.first] = bytes;
+      totalBytes += bytes;
+      lruOrder.push_back(std::make_pair(t.second.lastUsed, t.first));
+   }
+
+   // under the limit, nothing to do
+   if (totalBytes <= limitBytes)
+      return;
+
+   // evict the least recently used translation units until we are back
+   // under the limit (but never the unit we are about to hand back)
+   std::sort(lruOrder.begin(), lruOrder.end());
+   for (std::size_t i = 0;
+        i < lruOrder.size() && totalBytes > limitBytes;
+        i++)
+   {
+      const std::string& filename = lruOrder[i].second;
+      if (filename == protectedFilename)
+         continue;
+
+      totalBytes -= usage[filename];
+      removeTranslationUnit(filename);
+   }
+}
+
 Cursor SourceIndex::referencedCursorForFileLocation(const FileLocation &loc)
 {
    // get the translation unit
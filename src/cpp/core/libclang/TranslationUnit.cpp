@@ -147,6 +147,26 @@ boost::shared_ptr<CodeCompleteResults> TranslationUnit::codeCompleteAt(
    }
 }
 
+unsigned long TranslationUnit::getMemoryUsage() const
+{
+   CXTUResourceUsage usage = clang().getCXTUResourceUsage(tu_);
+
+   unsigned long totalBytes = 0;
+   for (unsigned i = 0; i < usage.numEntries; i++)
+   {
+      CXTUResourceUsageEntry entry = usage.entries[i];
+      if (entry.kind >= CXTUResourceUsage_MEMORY_IN_BYTES_BEGIN &&
+          entry.kind <= CXTUResourceUsage_MEMORY_IN_BYTES_END)
+      {
+         totalBytes += entry.amount;
+      }
+   }
+
+   clang().disposeCXTUResourceUsage(usage);
+
+   return totalBytes;
+}
+
 void TranslationUnit::printResourceUsage(std::ostream& ostr, bool detailed) const
 {
    CXTUResourceUsage usage = clang().getCXTUResourceUsage(tu_);
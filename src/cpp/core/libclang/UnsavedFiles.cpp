@@ -21,17 +21,6 @@ namespace rstudio {
 namespace core {
 namespace libclang {
 
-namespace {
-
-void freeUnsavedFile(CXUnsavedFile unsavedFile)
-{
-   delete [] unsavedFile.Filename;
-   delete [] unsavedFile.Contents;
-}
-
-
-} // anonymous namespace
-
 UnsavedFiles::~UnsavedFiles()
 {
    try
@@ -44,7 +33,7 @@ UnsavedFiles::~UnsavedFiles()
 }
 
 void UnsavedFiles::update(const std::string& filename,
-                          const std::string& contents,
+                          boost::shared_ptr<const std::string> pContents,
                           bool dirty)
 {
    // always remove any existing version
@@ -53,36 +42,44 @@ void UnsavedFiles::update(const std::string& filename,
    // add it if it's dirty
    if (dirty)
    {
-      // allocate an CXUnsavedFile
+      // hold a reference to the shared buffer (no copy of the contents)
+      UnsavedFile unsavedStorage;
+      unsavedStorage.pFilename.reset(new std::string(filename));
+      unsavedStorage.pContents = pContents;
+      storage_.push_back(unsavedStorage);
+
+      // create a CXUnsavedFile pointing into the shared buffer
       CXUnsavedFile unsavedFile;
-      char* Filename = new char[filename.length() + 1];
-      std::copy(filename.c_str(),
-                filename.data() + filename.length() + 1,
-                Filename);
-      unsavedFile.Filename = Filename;
-      char* buffContents = new char[contents.length()];
-      std::copy(contents.data(),
-                contents.data() + contents.length(),
-                buffContents);
-      unsavedFile.Contents = buffContents;
-      unsavedFile.Length = static_cast<unsigned long>(contents.length());
+      unsavedFile.Filename = unsavedStorage.pFilename->c_str();
+      unsavedFile.Contents = unsavedStorage.pContents->data();
+      unsavedFile.Length = static_cast<unsigned long>(
+                                          unsavedStorage.pContents->length());
 
       // add it to the list
       files_.push_back(unsavedFile);
    }
 }
 
+void UnsavedFiles::update(const std::string& filename,
+                          const std::string& contents,
+                          bool dirty)
+{
+   update(filename,
+          boost::shared_ptr<const std::string>(new std::string(contents)),
+          dirty);
+}
+
 void UnsavedFiles::remove(const std::string& filename)
 {
    // scan for an unsaved file with this filename, if we find it
-   // then free it and remove it from the vector
-   for (std::vector<CXUnsavedFile>::iterator pos = files_.begin();
-        pos != files_.end(); ++pos)
+   // then remove it from our vectors (the buffers are freed when
+   // the last reference to them is released)
+   for (std::size_t i = 0; i < files_.size(); i++)
    {
-      if (pos->Filename == filename)
+      if (files_[i].Filename == filename)
       {
-         freeUnsavedFile(*pos);
-         files_.erase(pos);
+         files_.erase(files_.begin() + i);
+         storage_.erase(storage_.begin() + i);
          break;
       }
    }
@@ -90,11 +87,9 @@ void UnsavedFiles::remove(const std::string& filename)
 
 void UnsavedFiles::removeAll()
 {
-   // free all of the CXUnsavedFile structures
-   std::for_each(files_.begin(), files_.end(), freeUnsavedFile);
-
    // empty out our data structures
    files_.clear();
+   storage_.clear();
 }
 
 std::ostream& operator << (std::ostream& ostr, UnsavedFiles& unsaved)
@@ -109,4 +104,3 @@ std::ostream& operator << (std::ostream& ostr, UnsavedFiles& unsaved)
 } // namespace core
 } // namespace rstudio
 
-
@@ -16,6 +16,7 @@
 #include <core/markdown/Markdown.hpp>
 
 #include <iostream>
+#include <sstream>
 
 #include <boost/foreach.hpp>
 #include <boost/scoped_ptr.hpp>
@@ -462,6 +463,89 @@ Error markdownToHTML(const std::string& markdownInput,
    return Success();
 }
 
+void splitMarkdownSegments(const std::string& markdownInput,
+                           std::vector<std::string>* pSegments,
+                           std::string* pRefDefs)
+{
+   boost::regex headingRegex("^#{1,6}[ \\t].*");
+   boost::regex fenceRegex("^(```|~~~).*");
+   boost::regex refDefRegex("^\\[[^\\]]+\\]:\\s+\\S.*");
+
+   std::string segment;
+   bool inFence = false;
+   std::istringstream istr(markdownInput);
+   std::string line;
+   while (std::getline(istr, line))
+   {
+      if (regex_utils::match(line, fenceRegex))
+         inFence = !inFence;
+
+      if (!inFence)
+      {
+         // cut a new segment at each top-level heading
+         if (!segment.empty() && regex_utils::match(line, headingRegex))
+         {
+            pSegments->push_back(segment);
+            segment.clear();
+         }
+
+         // collect reference link definitions
+         if (regex_utils::match(line, refDefRegex))
+            pRefDefs->append(line + "\n");
+      }
+
+      segment.append(line + "\n");
+   }
+   if (!segment.empty())
+      pSegments->push_back(segment);
+}
+
+// render markdown to HTML segment-by-segment -- assumes UTF-8 encoding
+Error markdownToHTML(const std::string& markdownInput,
+                     const Extensions& extensions,
+                     const HTMLOptions& options,
+                     const HTMLSink& htmlSink)
+{
+   // a table of contents requires the whole document, so render (and emit)
+   // in one piece when one was requested
+   if (options.toc)
+   {
+      std::string html;
+      Error error = markdownToHTML(markdownInput, extensions, options, &html);
+      if (error)
+         return error;
+      htmlSink(html);
+      return Success();
+   }
+
+   // strip metadata once up front -- it would otherwise only be detected
+   // at the head of the first segment
+   std::string input = markdownInput;
+   if (extensions.stripMetadata)
+      stripMetadata(&input);
+   Extensions segmentExtensions = extensions;
+   segmentExtensions.stripMetadata = false;
+
+   // render each top-level segment independently, folding in the
+   // document's reference link definitions so cross-segment links resolve
+   std::vector<std::string> segments;
+   std::string refDefs;
+   splitMarkdownSegments(input, &segments, &refDefs);
+   BOOST_FOREACH(const std::string& segment, segments)
+   {
+      std::string html;
+      Error error = markdownToHTML(segment + "\n" + refDefs,
+                                   segmentExtensions,
+                                   options,
+                                   &html);
+      if (error)
+         return error;
+      htmlSink(html);
+   }
+
+   return Success();
+}
+
 bool isMathJaxRequired(const std::string& htmlOutput)
 {
    return requiresMathjax(htmlOutput);
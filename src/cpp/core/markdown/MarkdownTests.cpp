@@ -0,0 +1,94 @@
+/*
+ * MarkdownTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+
+#include <core/Error.hpp>
+#include <core/markdown/Markdown.hpp>
+
+namespace rstudio {
+namespace core {
+namespace markdown {
+
+context("Markdown segmentation")
+{
+   test_that("Documents split at top-level headings")
+   {
+      std::vector<std::string> segments;
+      std::string refDefs;
+      splitMarkdownSegments("# One\ntext\n\n# Two\nmore text\n",
+                            &segments, &refDefs);
+      expect_true(segments.size() == 2);
+      expect_true(refDefs.empty());
+   }
+
+   test_that("Headings inside fenced code blocks don't split")
+   {
+      std::vector<std::string> segments;
+      std::string refDefs;
+      splitMarkdownSegments("# One\n```\n# not a heading\n```\ntext\n",
+                            &segments, &refDefs);
+      expect_true(segments.size() == 1);
+   }
+
+   test_that("Reference link definitions are collected")
+   {
+      std::vector<std::string> segments;
+      std::string refDefs;
+      splitMarkdownSegments("# One\n[a link][ref]\n\n# Two\n[ref]: http://x/\n",
+                            &segments, &refDefs);
+      expect_true(segments.size() == 2);
+      expect_true(refDefs == "[ref]: http://x/\n");
+   }
+}
+
+context("Streaming markdown rendering")
+{
+   test_that("Streamed output matches whole-document output")
+   {
+      std::string input = "# One\n\nsome *text*\n\n# Two\n\nmore text\n";
+
+      std::string whole;
+      Error error = markdownToHTML(input, Extensions(), HTMLOptions(), &whole);
+      expect_true(!error);
+
+      std::string streamed;
+      int emissions = 0;
+      error = markdownToHTML(input, Extensions(), HTMLOptions(),
+                             [&](const std::string& html)
+                             {
+                                streamed.append(html);
+                                emissions++;
+                             });
+      expect_true(!error);
+      expect_true(emissions == 2);
+      expect_true(streamed == whole);
+   }
+
+   test_that("Cross-segment reference links resolve")
+   {
+      std::string streamed;
+      Error error = markdownToHTML(
+         "# One\n\n[a link][ref]\n\n# Two\n\n[ref]: http://x/\n",
+         Extensions(), HTMLOptions(),
+         [&](const std::string& html) { streamed.append(html); });
+      expect_true(!error);
+      expect_true(streamed.find("href=\"http://x/\"") != std::string::npos);
+   }
+}
+
+} // namespace markdown
+} // namespace core
+} // namespace rstudio
@@ -313,6 +313,64 @@ std::ostream& operator << (std::ostream& stream, const YesNoAskValue& val)
    return stream ;
 }
 
+RProjectConfigDiff computeConfigDiff(const RProjectConfig& oldConfig,
+                                     const RProjectConfig& newConfig)
+{
+   RProjectConfigDiff diff;
+
+   diff.workspace =
+         oldConfig.saveWorkspace != newConfig.saveWorkspace ||
+         oldConfig.restoreWorkspace != newConfig.restoreWorkspace ||
+         oldConfig.alwaysSaveHistory != newConfig.alwaysSaveHistory ||
+         oldConfig.quitChildProcessesOnExit !=
+                                    newConfig.quitChildProcessesOnExit ||
+         oldConfig.disableExecuteRprofile !=
+                                    newConfig.disableExecuteRprofile;
+
+   diff.editor =
+         oldConfig.useSpacesForTab != newConfig.useSpacesForTab ||
+         oldConfig.numSpacesForTab != newConfig.numSpacesForTab ||
+         oldConfig.autoAppendNewline != newConfig.autoAppendNewline ||
+         oldConfig.stripTrailingWhitespace !=
+                                    newConfig.stripTrailingWhitespace ||
+         oldConfig.lineEndings != newConfig.lineEndings ||
+         oldConfig.encoding != newConfig.encoding;
+
+   diff.indexing =
+         oldConfig.enableCodeIndexing != newConfig.enableCodeIndexing;
+
+   diff.build =
+         oldConfig.buildType != newConfig.buildType ||
+         oldConfig.packagePath != newConfig.packagePath ||
+         oldConfig.packageInstallArgs != newConfig.packageInstallArgs ||
+         oldConfig.packageBuildArgs != newConfig.packageBuildArgs ||
+         oldConfig.packageBuildBinaryArgs !=
+                                    newConfig.packageBuildBinaryArgs ||
+         oldConfig.packageCheckArgs != newConfig.packageCheckArgs ||
+         oldConfig.packageRoxygenize != newConfig.packageRoxygenize ||
+         oldConfig.packageUseDevtools != newConfig.packageUseDevtools ||
+         oldConfig.makefilePath != newConfig.makefilePath ||
+         oldConfig.websitePath != newConfig.websitePath ||
+         oldConfig.customScriptPath != newConfig.customScriptPath ||
+         oldConfig.tutorialPath != newConfig.tutorialPath;
+
+   diff.authoring =
+         oldConfig.defaultSweaveEngine != newConfig.defaultSweaveEngine ||
+         oldConfig.defaultLatexProgram != newConfig.defaultLatexProgram ||
+         oldConfig.rootDocument != newConfig.rootDocument;
+
+   diff.rVersion =
+         oldConfig.rVersion.number != newConfig.rVersion.number ||
+         oldConfig.rVersion.arch != newConfig.rVersion.arch;
+
+   diff.any = diff.workspace || diff.editor || diff.indexing ||
+              diff.build || diff.authoring || diff.rVersion ||
+              oldConfig.version != newConfig.version ||
+              oldConfig.defaultOpenDocs != newConfig.defaultOpenDocs;
+
+   return diff;
+}
+
 Error findProjectFile(FilePath filePath,
                       FilePath anchorPath,
                       FilePath* pProjPath)
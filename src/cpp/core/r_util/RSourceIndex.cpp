@@ -331,7 +331,7 @@ void libraryCallIndexer(const RTokenCursor& cursor, const IndexStatus& status, R
    {
       std::string pkgName = string_utils::strippedOfQuotes(clone.contentAsUtf8());
       if (isValidRPackageName(pkgName))
-         pIndex->addInferredPackage(pkgName);
+         pIndex->addInferredPackageLocal(pkgName);
    }
    
    // If the package name is a symbol, then look forward and check for
@@ -340,7 +340,7 @@ void libraryCallIndexer(const RTokenCursor& cursor, const IndexStatus& status, R
    {
       std::string pkgName = clone.contentAsUtf8();
       if (isValidRPackageName(pkgName))
-         pIndex->addInferredPackage(pkgName);
+         pIndex->addInferredPackageLocal(pkgName);
    }
 }
 
@@ -433,14 +433,59 @@ void variableAssignmentIndexer(const RTokenCursor& cursor, const IndexStatus& st
    }
 }
 
+// language keywords and constants tokenize as identifiers but aren't
+// meaningful reference targets (nobody asks for the uses of 'function')
+bool isLanguageKeyword(const RToken& token)
+{
+   static std::set<std::wstring> keywords;
+   if (keywords.empty())
+   {
+      keywords.insert(L"function");
+      keywords.insert(L"if");
+      keywords.insert(L"else");
+      keywords.insert(L"for");
+      keywords.insert(L"in");
+      keywords.insert(L"while");
+      keywords.insert(L"repeat");
+      keywords.insert(L"break");
+      keywords.insert(L"next");
+      keywords.insert(L"TRUE");
+      keywords.insert(L"FALSE");
+      keywords.insert(L"NULL");
+      keywords.insert(L"NA");
+      keywords.insert(L"NA_integer_");
+      keywords.insert(L"NA_real_");
+      keywords.insert(L"NA_character_");
+      keywords.insert(L"Inf");
+      keywords.insert(L"NaN");
+   }
+
+   return keywords.count(token.content()) > 0;
+}
+
+void symbolReferenceIndexer(const RTokenCursor& cursor, const IndexStatus& status, RSourceIndex* pIndex)
+{
+   if (!cursor.isType(RToken::ID))
+      return;
+
+   if (isLanguageKeyword(cursor.currentToken()))
+      return;
+
+   pIndex->addReference(
+            string_utils::strippedOfQuotes(cursor.contentAsUtf8()),
+            cursor.currentToken().row() + 1,
+            cursor.currentToken().column() + 1);
+}
+
 std::vector<Indexer> makeIndexers()
 {
    std::vector<Indexer> indexers;
-   
+
    indexers.push_back(libraryCallIndexer);
    indexers.push_back(s4MethodIndexer);
    indexers.push_back(variableAssignmentIndexer);
-   
+   indexers.push_back(symbolReferenceIndexer);
+
    return indexers;
 }
 
@@ -456,7 +501,7 @@ RSourceIndex::RSourceIndex(const std::string& context, const std::string& code)
 
    // tokenize and create token cursor
    std::wstring wCode = string_utils::utf8ToWide(code, context);
-   RTokens rTokens(wCode, RTokens::StripWhitespace | RTokens::StripComments);
+   RTokens rTokens(&wCode, RTokens::StripWhitespace | RTokens::StripComments);
    if (rTokens.empty())
       return;
    
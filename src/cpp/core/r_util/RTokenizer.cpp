@@ -261,7 +261,7 @@ RToken RTokenizer::matchStringLiteral()
    return RToken(RToken::STRING,
                  start,
                  pos_,
-                 start - data_.begin(),
+                 start - begin_,
                  row,
                  column);
 }
@@ -289,7 +289,7 @@ RToken RTokenizer::matchIdentifier()
    return RToken(RToken::ID,
                  start,
                  pos_,
-                 start - data_.begin(),
+                 start - begin_,
                  row,
                  column);
 }
@@ -379,7 +379,7 @@ RToken RTokenizer::matchOperator()
 
 bool RTokenizer::eol()
 {
-   return pos_ >= data_.end();
+   return pos_ >= end_;
 }
 
 wchar_t RTokenizer::peek()
@@ -389,7 +389,7 @@ wchar_t RTokenizer::peek()
 
 wchar_t RTokenizer::peek(std::size_t lookahead)
 {
-   if ((pos_ + lookahead) >= data_.end())
+   if ((pos_ + lookahead) >= end_)
       return 0 ;
    else
       return *(pos_ + lookahead) ;
@@ -405,7 +405,7 @@ wchar_t RTokenizer::eat()
 std::size_t RTokenizer::tokenLength(const boost::wregex& regex)
 {
    boost::wsmatch match;
-   std::wstring::const_iterator end = data_.end();
+   std::wstring::const_iterator end = end_;
    boost::match_flag_type flg = boost::match_default | boost::match_continuous;
    if (regex_utils::search(pos_, end, match, regex, flg))
       return match.length();
@@ -416,7 +416,7 @@ std::size_t RTokenizer::tokenLength(const boost::wregex& regex)
 void RTokenizer::eatUntil(const boost::wregex& regex)
 {
    boost::wsmatch match;
-   std::wstring::const_iterator end = data_.end();
+   std::wstring::const_iterator end = end_;
    if (regex_utils::search(pos_, end, match, regex))
    {
       pos_ = match[0].first;
@@ -424,7 +424,7 @@ void RTokenizer::eatUntil(const boost::wregex& regex)
    else
    {
       // eat all on failure to match
-      pos_ = data_.end();
+      pos_ = end_;
    }
 }
 
@@ -437,7 +437,7 @@ RToken RTokenizer::consumeToken(RToken::TokenType tokenType,
       LOG_WARNING_MESSAGE("Can't create zero-length token");
       return RToken();
    }
-   else if ((pos_ + length) > data_.end())
+   else if ((pos_ + length) > end_)
    {
       LOG_WARNING_MESSAGE("Premature EOF");
       return RToken();
@@ -455,52 +455,24 @@ RToken RTokenizer::consumeToken(RToken::TokenType tokenType,
    return RToken(tokenType,
                  start,
                  pos_,
-                 start - data_.begin(),
+                 start - begin_,
                  row,
                  column);
 }
 
-class ConversionCache
+const std::wstring& RToken::emptyTokenData()
 {
-public:
-   
-   typedef std::wstring key_type;
-   typedef std::string mapped_type;
-   
-   bool contains(const RToken& token) const
-   {
-      return database_.count(token.content());
-   }
-   
-   std::string& get(const RToken& token)
-   {
-      return database_[token.content()];
-   }
-   
-   void put(const RToken& token, const mapped_type& value)
-   {
-      database_[token.content()] = value;
-   }
-   
-private:
-   std::map<key_type, mapped_type> database_;
-};
-
-ConversionCache& conversionCache()
-{
-   static ConversionCache instance;
+   static const std::wstring instance;
    return instance;
 }
 
-const std::string& RToken::contentAsUtf8() const
+std::string RToken::contentAsUtf8() const
 {
-   ConversionCache& cache = conversionCache();
-   if (cache.contains(*this))
-      return cache.get(*this);
-   
-   std::string result = string_utils::wideToUtf8(content());
-   cache.put(*this, result);
-   return cache.get(*this);
+   // NOTE: we previously cached conversions in a global map, but the
+   // lookup itself materialized a std::wstring key per call (usually
+   // costing as much as the conversion) and the map was unsynchronized
+   // so couldn't be used from background indexing threads
+   return string_utils::wideToUtf8(content());
 }
 
 std::string RToken::asString() const
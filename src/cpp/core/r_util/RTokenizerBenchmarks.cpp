@@ -0,0 +1,90 @@
+/*
+ * RTokenizerBenchmarks.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <benchmark/Benchmark.hpp>
+
+#include <string>
+
+#include <core/StringUtils.hpp>
+#include <core/r_util/RTokenizer.hpp>
+
+namespace rstudio {
+namespace core {
+namespace benchmarks {
+namespace {
+
+// a big R source built by repeating a representative snippet (function
+// definitions, pipes-by-another-name, strings, comments, operators) to
+// roughly the size of a large package source file
+const int kSnippetRepeats = 400;
+
+const char* const kSnippet =
+   "# fit models across the grid of tuning parameters\n"
+   "fitModels <- function(data, grid, control = list()) {\n"
+   "   results <- lapply(seq_len(nrow(grid)), function(i) {\n"
+   "      params <- grid[i, , drop = FALSE]\n"
+   "      model <- stats::lm(y ~ x1 + x2 * x3, data = data,\n"
+   "                         weights = data$w)\n"
+   "      list(params = params, rmse = sqrt(mean(resid(model)^2)),\n"
+   "           label = paste0(\"model-\", i, \" (\", nrow(data), \" rows)\"))\n"
+   "   })\n"
+   "   results[order(vapply(results, `[[`, numeric(1), \"rmse\"))]\n"
+   "}\n";
+
+const std::wstring& rSourceFixture()
+{
+   static std::wstring s_source;
+   if (s_source.empty())
+   {
+      std::string source;
+      for (int i = 0; i < kSnippetRepeats; i++)
+         source += kSnippet;
+      s_source = string_utils::utf8ToWide(source);
+   }
+   return s_source;
+}
+
+} // anonymous namespace
+
+BENCHMARK(benchmarkRTokenizer)
+{
+   const std::wstring& source = rSourceFixture();
+   state.setBytesPerIteration(source.size());
+
+   while (state.keepRunning())
+   {
+      r_util::RTokenizer tokenizer(source);
+      int tokenCount = 0;
+      while (r_util::RToken token = tokenizer.nextToken())
+         tokenCount++;
+      benchmark::doNotOptimize(tokenCount);
+   }
+}
+
+BENCHMARK(benchmarkRTokensVector)
+{
+   const std::wstring& source = rSourceFixture();
+   state.setBytesPerIteration(source.size());
+
+   while (state.keepRunning())
+   {
+      r_util::RTokens rTokens(source);
+      benchmark::doNotOptimize(rTokens.size());
+   }
+}
+
+} // namespace benchmarks
+} // namespace core
+} // namespace rstudio
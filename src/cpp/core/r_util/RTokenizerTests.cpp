@@ -269,6 +269,20 @@ context("RTokenizer")
       expect_true(rTokens.at(2).isType(RToken::OPER));
       expect_true(rTokens.at(2).contentEquals(L"**"));
    }
+
+   test_that("Tokenizing over a caller-owned buffer matches the copying mode")
+   {
+      std::wstring code(L"x <- foo(1, 'two')");
+      RTokens copied(code);
+      RTokens referenced(&code);
+      expect_true(copied.size() == referenced.size());
+      for (std::size_t i = 0; i < copied.size(); i++)
+      {
+         expect_true(copied.at(i).type() == referenced.at(i).type());
+         expect_true(copied.at(i).offset() == referenced.at(i).offset());
+         expect_true(copied.at(i).content() == referenced.at(i).content());
+      }
+   }
 }
 
 } // namespace r_util
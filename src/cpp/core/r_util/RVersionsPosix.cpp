@@ -17,6 +17,7 @@
 
 #include <iostream>
 #include <algorithm>
+#include <map>
 
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
@@ -84,8 +85,177 @@ void scanForRHomePaths(const core::FilePath& rootDir,
 }
 
 
+// persistent store of R environment detection results -- each detection
+// spawns a full R process to interrogate version/home/lib paths, and the
+// answers only change when the R installation itself changes. entries
+// are keyed by the R script path and validated against a fingerprint of
+// the script (modification time and size) plus the detection inputs, so
+// a changed installation is simply re-probed
+struct DetectedREnvironment
+{
+   DetectedREnvironment() : lastWriteTime(0), size(0) {}
+
+   double lastWriteTime;
+   double size;
+   std::string ldPathsScript;
+   std::string ldLibraryPath;
+   std::string prelaunchScript;
+   std::string rScriptPath;
+   std::string version;
+   core::system::Options environment;
+};
+
+FilePath s_detectionCacheFile;
+std::map<std::string, DetectedREnvironment> s_detectionCache;
+
+void loadDetectionCache()
+{
+   if (!s_detectionCacheFile.exists())
+      return;
+
+   std::string contents;
+   Error error = core::readStringFromFile(s_detectionCacheFile, &contents);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   json::Value cacheJson;
+   if (!json::parse(contents, &cacheJson) ||
+       !json::isType<json::Array>(cacheJson))
+   {
+      LOG_WARNING_MESSAGE("Unexpected format for R environment cache: " +
+                          s_detectionCacheFile.absolutePath());
+      return;
+   }
+
+   BOOST_FOREACH(const json::Value& entryJson, cacheJson.get_array())
+   {
+      if (!json::isType<json::Object>(entryJson))
+         continue;
+
+      std::string script;
+      DetectedREnvironment entry;
+      json::Object environmentJson;
+      Error error = json::readObject(entryJson.get_obj(),
+                                     "script", &script,
+                                     "last_write_time", &entry.lastWriteTime,
+                                     "size", &entry.size,
+                                     "ld_paths_script", &entry.ldPathsScript,
+                                     "ld_library_path", &entry.ldLibraryPath,
+                                     "prelaunch_script", &entry.prelaunchScript,
+                                     "discovered_script", &entry.rScriptPath,
+                                     "version", &entry.version,
+                                     "environment", &environmentJson);
+      if (error)
+      {
+         LOG_ERROR(error);
+         continue;
+      }
+
+      entry.environment = json::optionsFromJson(environmentJson);
+      s_detectionCache[script] = entry;
+   }
+}
+
+void saveDetectionCache()
+{
+   json::Array cacheJson;
+   for (std::map<std::string, DetectedREnvironment>::const_iterator
+        it = s_detectionCache.begin(); it != s_detectionCache.end(); ++it)
+   {
+      json::Object entryJson;
+      entryJson["script"] = it->first;
+      entryJson["last_write_time"] = it->second.lastWriteTime;
+      entryJson["size"] = it->second.size;
+      entryJson["ld_paths_script"] = it->second.ldPathsScript;
+      entryJson["ld_library_path"] = it->second.ldLibraryPath;
+      entryJson["prelaunch_script"] = it->second.prelaunchScript;
+      entryJson["discovered_script"] = it->second.rScriptPath;
+      entryJson["version"] = it->second.version;
+      entryJson["environment"] = json::toJsonObject(it->second.environment);
+      cacheJson.push_back(entryJson);
+   }
+
+   std::ostringstream ostr;
+   json::writeFormatted(cacheJson, ostr);
+   Error error = core::writeStringToFile(s_detectionCacheFile, ostr.str());
+   if (error)
+      LOG_ERROR(error);
+}
+
 } // anonymous namespace
 
+void initializeRVersionDetectionCache(const FilePath& cacheFilePath)
+{
+   s_detectionCacheFile = cacheFilePath;
+   loadDetectionCache();
+}
+
+bool detectREnvironmentCached(const FilePath& rScriptPath,
+                              const FilePath& ldPathsScript,
+                              const std::string& ldLibraryPath,
+                              std::string* pRScriptPath,
+                              std::string* pVersion,
+                              core::system::Options* pEnvironment,
+                              std::string* pErrMsg,
+                              const std::string& prelaunchScript)
+{
+   // serve from the cache when the fingerprint and detection inputs are
+   // unchanged (double check that the detected home still exists so a
+   // removed installation isn't resurrected from the cache)
+   std::string cacheKey = rScriptPath.absolutePath();
+   std::map<std::string, DetectedREnvironment>::const_iterator it =
+                                             s_detectionCache.find(cacheKey);
+   if (it != s_detectionCache.end())
+   {
+      const DetectedREnvironment& entry = it->second;
+      if (entry.lastWriteTime == (double)rScriptPath.lastWriteTime() &&
+          entry.size == (double)rScriptPath.size() &&
+          entry.ldPathsScript == ldPathsScript.absolutePath() &&
+          entry.ldLibraryPath == ldLibraryPath &&
+          entry.prelaunchScript == prelaunchScript &&
+          FilePath(core::system::getenv(entry.environment,
+                                        "R_HOME")).exists())
+      {
+         *pRScriptPath = entry.rScriptPath;
+         *pVersion = entry.version;
+         *pEnvironment = entry.environment;
+         return true;
+      }
+   }
+
+   // probe the installation
+   if (!detectREnvironment(rScriptPath,
+                           ldPathsScript,
+                           ldLibraryPath,
+                           pRScriptPath,
+                           pVersion,
+                           pEnvironment,
+                           pErrMsg,
+                           prelaunchScript))
+      return false;
+
+   // refresh the entry (and the store, so subsequent processes get the
+   // fast path as well)
+   DetectedREnvironment entry;
+   entry.lastWriteTime = (double)rScriptPath.lastWriteTime();
+   entry.size = (double)rScriptPath.size();
+   entry.ldPathsScript = ldPathsScript.absolutePath();
+   entry.ldLibraryPath = ldLibraryPath;
+   entry.prelaunchScript = prelaunchScript;
+   entry.rScriptPath = *pRScriptPath;
+   entry.version = *pVersion;
+   entry.environment = *pEnvironment;
+   s_detectionCache[cacheKey] = entry;
+
+   if (!s_detectionCacheFile.empty())
+      saveDetectionCache();
+
+   return true;
+}
+
 std::ostream& operator<<(std::ostream& os, const RVersion& version)
 {
    os << version.number();
@@ -157,14 +327,14 @@ std::vector<RVersion> enumerateRVersions(
 
       std::string rDiscoveredScriptPath, rVersion, errMsg;
       core::system::Options env;
-      if (detectREnvironment(rScriptPath,
-                             ldPathsScript,
-                             ldLibraryPath,
-                             &rDiscoveredScriptPath,
-                             &rVersion,
-                             &env,
-                             &errMsg,
-                             prelaunchScript))
+      if (detectREnvironmentCached(rScriptPath,
+                                   ldPathsScript,
+                                   ldLibraryPath,
+                                   &rDiscoveredScriptPath,
+                                   &rVersion,
+                                   &env,
+                                   &errMsg,
+                                   prelaunchScript))
       {
          // merge the found environment with the existing user-overridden environment
          // we ensure that the user overrides overwrite whatever environment we established automatically
@@ -212,13 +382,13 @@ std::vector<RVersion> enumerateRVersions(
 
       std::string rDiscoveredScriptPath, rVersion, errMsg;
       core::system::Options env;
-      if (detectREnvironment(rScriptPath,
-                             ldPathsScript,
-                             ldLibraryPath,
-                             &rDiscoveredScriptPath,
-                             &rVersion,
-                             &env,
-                             &errMsg))
+      if (detectREnvironmentCached(rScriptPath,
+                                   ldPathsScript,
+                                   ldLibraryPath,
+                                   &rDiscoveredScriptPath,
+                                   &rVersion,
+                                   &env,
+                                   &errMsg))
       {
          RVersion version(rVersion, env);
          rVersions.push_back(version);
@@ -112,6 +112,8 @@ class SpellChecker : boost::noncopyable
 public:
    virtual ~SpellChecker() {}
    virtual Error checkSpelling(const std::string& word, bool *pCorrect) = 0;
+   virtual Error checkSpelling(const std::vector<std::string>& words,
+                               std::vector<bool>* pCorrect) = 0;
    virtual Error suggestionList(const std::string& word,
                                 std::vector<std::string>* pSugs) = 0;
    virtual Error wordChars(std::wstring* pWordChars) = 0;
@@ -126,6 +128,13 @@ public:
       return Success();
    }
 
+   Error checkSpelling(const std::vector<std::string>& words,
+                       std::vector<bool>* pCorrect)
+   {
+      pCorrect->assign(words.size(), true);
+      return Success();
+   }
+
    Error suggestionList(const std::string& word,
                         std::vector<std::string>* pSugs)
    {
@@ -279,6 +288,33 @@ public:
       return Success();
    }
 
+   Error checkSpelling(const std::vector<std::string>& words,
+                       std::vector<bool>* pCorrect)
+   {
+      pCorrect->clear();
+      pCorrect->reserve(words.size());
+
+      std::string encoded;
+      BOOST_FOREACH(const std::string& word, words)
+      {
+         // if we can't check a word then log and report it as correct --
+         // some combinations of platform, non-ASCII characters, and locale
+         // are known to fail in iconv, and a single unconvertable word
+         // shouldn't invalidate the rest of the batch
+         Error error = iconvstrFunc_(word,"UTF-8",encoding_,false,&encoded);
+         if (error)
+         {
+            LOG_ERROR(error);
+            pCorrect->push_back(true);
+            continue;
+         }
+
+         pCorrect->push_back(pHunspell_->spell(encoded.c_str()) != 0);
+      }
+
+      return Success();
+   }
+
    Error suggestionList(const std::string& word, std::vector<std::string>* pSug)
    {
       std::string encoded;
@@ -472,6 +508,13 @@ Error HunspellSpellingEngine::checkSpelling(const std::string& word,
    return pImpl_->spellChecker().checkSpelling(word, pCorrect);
 }
 
+Error HunspellSpellingEngine::checkSpelling(
+                                       const std::vector<std::string>& words,
+                                       std::vector<bool>* pCorrect)
+{
+   return pImpl_->spellChecker().checkSpelling(words, pCorrect);
+}
+
 Error HunspellSpellingEngine::suggestionList(const std::string& word,
                                              std::vector<std::string>* pSugs)
 {
@@ -5,6 +5,13 @@
 #include <string.h>
 #include <stdio.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include "filemgr.hxx"
 
 int FileMgr::fail(const char * err, const char * par) {
@@ -15,6 +22,28 @@ int FileMgr::fail(const char * err, const char * par) {
 FileMgr::FileMgr(const char * file, const char * key) {
     linenum = 0;
     hin = NULL;
+    fin = NULL;
+#ifndef _WIN32
+    mapdata = NULL;
+    mapsize = 0;
+    mappos = 0;
+    // map the file read-only so that concurrent processes loading the
+    // same dictionary share a single copy of its pages
+    int fd = open(file, O_RDONLY);
+    if (fd != -1) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void * p = mmap(NULL, (size_t) st.st_size, PROT_READ,
+                            MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED) {
+                mapdata = (const char *) p;
+                mapsize = (size_t) st.st_size;
+            }
+        }
+        close(fd);
+    }
+    if (mapdata) return;
+#endif
     fin = fopen(file, "r");
     if (!fin) {
         // check hzipped file
@@ -31,6 +60,9 @@ FileMgr::FileMgr(const char * file, const char * key) {
 
 FileMgr::~FileMgr()
 {
+#ifndef _WIN32
+    if (mapdata) munmap((void *) mapdata, mapsize);
+#endif
     if (fin) fclose(fin);
     if (hin) delete hin;
 }
@@ -38,6 +70,24 @@ FileMgr::~FileMgr()
 char * FileMgr::getline() {
     const char * l;
     linenum++;
+#ifndef _WIN32
+    if (mapdata) {
+        if (mappos >= mapsize) {
+            linenum--;
+            return NULL;
+        }
+        // copy the next line out of the mapping (same truncation
+        // behavior as the fgets call below)
+        size_t i = 0;
+        while (mappos < mapsize && i < BUFSIZE - 2) {
+            char c = mapdata[mappos++];
+            in[i++] = c;
+            if (c == '\n') break;
+        }
+        in[i] = '\0';
+        return in;
+    }
+#endif
     if (fin) return fgets(in, BUFSIZE - 1, fin);
     if (hin && (l = hin->getline())) return strcpy(in, l);
     linenum--;
@@ -12,6 +12,11 @@ class LIBHUNSPELL_DLL_EXPORTED FileMgr
 protected:
     FILE * fin;
     Hunzip * hin;
+#ifndef _WIN32
+    const char * mapdata; // read-only mmap of [filename] (or NULL)
+    size_t mapsize;
+    size_t mappos;
+#endif
     char in[BUFSIZE + 50]; // input buffer
     int fail(const char * err, const char * par);
     int linenum;
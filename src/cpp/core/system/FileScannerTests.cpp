@@ -0,0 +1,97 @@
+/*
+ * FileScannerTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef _WIN32
+
+#include <tests/TestThat.hpp>
+
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/system/FileScanner.hpp>
+
+namespace rstudio {
+namespace core {
+namespace system {
+
+namespace {
+
+void createTestTree(const FilePath& rootPath)
+{
+   // a/one.txt, a/two.txt, a/b/three.txt, c/four.txt, five.txt
+   FilePath aPath = rootPath.complete("a");
+   FilePath bPath = aPath.complete("b");
+   FilePath cPath = rootPath.complete("c");
+   REQUIRE_FALSE(bPath.ensureDirectory());
+   REQUIRE_FALSE(cPath.ensureDirectory());
+   REQUIRE_FALSE(writeStringToFile(aPath.complete("one.txt"), "one"));
+   REQUIRE_FALSE(writeStringToFile(aPath.complete("two.txt"), "two"));
+   REQUIRE_FALSE(writeStringToFile(bPath.complete("three.txt"), "three"));
+   REQUIRE_FALSE(writeStringToFile(cPath.complete("four.txt"), "four"));
+   REQUIRE_FALSE(writeStringToFile(rootPath.complete("five.txt"), "five"));
+}
+
+bool notHidden(const FileInfo& fileInfo)
+{
+   return FilePath(fileInfo.absolutePath()).filename()[0] != '.';
+}
+
+} // anonymous namespace
+
+context("File scanning")
+{
+   test_that("Parallel scans produce the same tree as sequential scans")
+   {
+      FilePath rootPath;
+      REQUIRE_FALSE(FilePath::tempFilePath(&rootPath));
+      REQUIRE_FALSE(rootPath.ensureDirectory());
+      createTestTree(rootPath);
+
+      FileScannerOptions options;
+      options.recursive = true;
+      options.filter = notHidden;
+
+      tree<FileInfo> sequentialTree;
+      REQUIRE_FALSE(scanFiles(FileInfo(rootPath), options, &sequentialTree));
+
+      options.concurrentScanners = 4;
+      tree<FileInfo> parallelTree;
+      REQUIRE_FALSE(scanFiles(FileInfo(rootPath), options, &parallelTree));
+
+      expect_true(sequentialTree.size() == parallelTree.size());
+      expect_true(std::equal(sequentialTree.begin(),
+                             sequentialTree.end(),
+                             parallelTree.begin()));
+
+      REQUIRE_FALSE(rootPath.removeIfExists());
+   }
+
+   test_that("Scanning a nonexistent root returns an error")
+   {
+      FileScannerOptions options;
+      options.recursive = true;
+      options.concurrentScanners = 4;
+
+      tree<FileInfo> fileTree;
+      FileInfo missing("/nonexistent/path/for/scanner/test", true);
+      Error error = scanFiles(missing, options, &fileTree);
+      expect_true(!!error);
+   }
+}
+
+} // namespace system
+} // namespace core
+} // namespace rstudio
+
+#endif // !_WIN32
@@ -17,9 +17,13 @@
 
 #include <atomic>
 #include <fcntl.h>
+#include <poll.h>
 #include <signal.h>
+#include <spawn.h>
 #include <unistd.h>
 
+#include <set>
+
 #ifdef __APPLE__
 #include <util.h>
 #include <sys/ttycom.h>
@@ -34,6 +38,7 @@
 
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
 
 #include <core/Error.hpp>
 #include <core/Log.hpp>
@@ -45,6 +50,10 @@
 
 #include <core/PerformanceTimer.hpp>
 
+// the parent environment (not declared by headers on all platforms); used
+// by the posix_spawn fast-launch path to match execv's environment behavior
+extern char** environ;
+
 namespace rstudio {
 namespace core {
 namespace system {
@@ -97,6 +106,35 @@ void closePipe(int* pipeDescriptors, const ErrorLocation& location)
    closePipe(pipeDescriptors[WRITE], location);
 }
 
+// create a pipe with both ends marked close-on-exec (used by the
+// posix_spawn fast-launch path -- the descriptors the child needs are
+// re-created via dup2 file actions, which clears the flag, so nothing
+// leaks into the child and no fd-close loop is required before exec)
+Error cloexecPipe(int* pipeDescriptors)
+{
+#ifdef __linux__
+   return posixCall<int>(boost::bind(::pipe2, pipeDescriptors, O_CLOEXEC),
+                         ERROR_LOCATION);
+#else
+   Error error = posixCall<int>(boost::bind(::pipe, pipeDescriptors),
+                                ERROR_LOCATION);
+   if (error)
+      return error;
+
+   for (int i = 0; i < 2; i++)
+   {
+      if (::fcntl(pipeDescriptors[i], F_SETFD, FD_CLOEXEC) == -1)
+      {
+         Error error = systemError(errno, ERROR_LOCATION);
+         closePipe(pipeDescriptors, ERROR_LOCATION);
+         return error;
+      }
+   }
+
+   return Success();
+#endif
+}
+
 Error readPipe(int pipeFd, std::string* pOutput, bool *pEOF = NULL)
 {
    // default to not eof
@@ -475,6 +513,108 @@ Error ChildProcess::run()
                          ERROR_LOCATION);
    }
 
+   // fast-launch mode: launch via posix_spawn rather than fork + exec.
+   // this avoids duplicating the parent address space and -- because the
+   // pipes are close-on-exec -- the loop which closes every descriptor up
+   // to the fd limit before exec (with a large fd limit that loop can
+   // dominate the cost of launching small processes). options which
+   // require running code between fork and exec can't be honored here so
+   // we fall back to conventional fork + exec when any are present
+   if (options_.fastLaunch &&
+       !options_.pseudoterminal &&
+       !options_.detachSession &&
+       !options_.onAfterFork &&
+       options_.runAsUser.empty() &&
+       options_.workingDir.empty())
+   {
+      // create close-on-exec pipes for the standard streams
+      Error error = cloexecPipe(fdInput);
+      if (error)
+         return error;
+      error = cloexecPipe(fdOutput);
+      if (error)
+      {
+         closePipe(fdInput, ERROR_LOCATION);
+         return error;
+      }
+      error = cloexecPipe(fdError);
+      if (error)
+      {
+         closePipe(fdInput, ERROR_LOCATION);
+         closePipe(fdOutput, ERROR_LOCATION);
+         return error;
+      }
+
+      // wire the child ends of the pipes to the standard streams (dup2
+      // clears close-on-exec so these are the only descriptors the
+      // child inherits)
+      posix_spawn_file_actions_t fileActions;
+      ::posix_spawn_file_actions_init(&fileActions);
+      ::posix_spawn_file_actions_adddup2(&fileActions,
+                                         fdInput[READ],
+                                         STDIN_FILENO);
+      ::posix_spawn_file_actions_adddup2(&fileActions,
+                                         fdOutput[WRITE],
+                                         STDOUT_FILENO);
+      ::posix_spawn_file_actions_adddup2(
+            &fileActions,
+            options_.redirectStdErrToStdOut ? fdOutput[WRITE] : fdError[WRITE],
+            STDERR_FILENO);
+
+      // reset the signal mask and dispositions in the child, and create
+      // a new process group if terminateChildren was requested (to mirror
+      // the setpgid(0,0) performed on the fork + exec path)
+      posix_spawnattr_t attr;
+      ::posix_spawnattr_init(&attr);
+      short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+      sigset_t emptyMask;
+      ::sigemptyset(&emptyMask);
+      ::posix_spawnattr_setsigmask(&attr, &emptyMask);
+      sigset_t defaultSignals;
+      ::sigfillset(&defaultSignals);
+      ::posix_spawnattr_setsigdefault(&attr, &defaultSignals);
+      if (options_.terminateChildren)
+      {
+         flags |= POSIX_SPAWN_SETPGROUP;
+         ::posix_spawnattr_setpgroup(&attr, 0);
+      }
+      ::posix_spawnattr_setflags(&attr, flags);
+
+      // spawn the child (posix_spawn returns the error number directly)
+      int result = ::posix_spawn(
+                        &pid,
+                        exe_.c_str(),
+                        &fileActions,
+                        &attr,
+                        pProcessArgs->args(),
+                        pEnvironment ? pEnvironment->args() : environ);
+
+      ::posix_spawnattr_destroy(&attr);
+      ::posix_spawn_file_actions_destroy(&fileActions);
+
+      // close the child ends of the pipes
+      closePipe(fdInput[READ], ERROR_LOCATION);
+      closePipe(fdOutput[WRITE], ERROR_LOCATION);
+      closePipe(fdError[WRITE], ERROR_LOCATION);
+
+      if (result != 0)
+      {
+         closePipe(fdInput[WRITE], ERROR_LOCATION);
+         closePipe(fdOutput[READ], ERROR_LOCATION);
+         closePipe(fdError[READ], ERROR_LOCATION);
+         Error error = systemError(result, ERROR_LOCATION);
+         error.addProperty("exe", exe_);
+         return error;
+      }
+
+      // record pipe handles
+      pImpl_->init(pid, fdInput[WRITE], fdOutput[READ], fdError[READ]);
+
+      delete pProcessArgs;
+
+      return Success();
+   }
+
    // pseudoterminal mode: fork using the special forkpty call
    if (options_.pseudoterminal)
    {
@@ -836,6 +976,384 @@ Error SyncChildProcess::waitForExit(int* pExitStatus)
    }
 }
 
+namespace {
+
+// output captured off the reactor thread for a multiplexed child. the
+// reactor appends under the mutex as output arrives and
+// AsyncChildProcess::poll collects from the supervisor thread
+class MultiplexedOutput : boost::noncopyable
+{
+public:
+   MultiplexedOutput()
+      : stdoutEof_(false), stderrEof_(false)
+   {
+   }
+
+   void append(const std::string& output, bool eof, bool isStdout)
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         if (isStdout)
+         {
+            stdout_.append(output);
+            stdoutEof_ = stdoutEof_ || eof;
+         }
+         else
+         {
+            stderr_.append(output);
+            stderrEof_ = stderrEof_ || eof;
+         }
+      }
+      END_LOCK_MUTEX
+   }
+
+   void setError(const Error& error)
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         if (!error_)
+            error_ = error;
+      }
+      END_LOCK_MUTEX
+   }
+
+   void collect(std::string* pStdout,
+                bool* pStdoutEof,
+                std::string* pStderr,
+                bool* pStderrEof,
+                Error* pError)
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         pStdout->swap(stdout_);
+         stdout_.clear();
+         *pStdoutEof = stdoutEof_;
+         pStderr->swap(stderr_);
+         stderr_.clear();
+         *pStderrEof = stderrEof_;
+         *pError = error_;
+         error_ = Error();
+      }
+      END_LOCK_MUTEX
+   }
+
+private:
+   boost::mutex mutex_;
+   std::string stdout_;
+   std::string stderr_;
+   bool stdoutEof_;
+   bool stderrEof_;
+   Error error_;
+};
+
+// reactor thread which waits on the output descriptors of all multiplexed
+// children with a single poll(2) call and drains them as output arrives.
+// this replaces the per-child read attempts (which mostly return EAGAIN)
+// performed on every supervisor poll, and means output is consumed from
+// the kernel as soon as it is produced rather than on the next poll tick
+// (the callbacks themselves still fire from the supervisor's poll, which
+// delivers everything accumulated since the last poll as a single batch).
+// the reactor owns duplicates of the child descriptors so that it never
+// races with the supervisor thread closing the originals
+class OutputReactor : boost::noncopyable
+{
+public:
+   static OutputReactor& instance()
+   {
+      // deliberately leaked so the reactor (and its thread) survive
+      // static destruction
+      static OutputReactor* pInstance = new OutputReactor();
+      return *pInstance;
+   }
+
+   // register duplicates of the given descriptors with the reactor
+   // (returns false if the reactor couldn't be started, in which case
+   // the caller should fall back to direct reads)
+   bool registerChild(const boost::shared_ptr<MultiplexedOutput>& pOutput,
+                      int fdStdout,
+                      int fdStderr)
+   {
+      int fdOut = dupCloexec(fdStdout);
+      if (fdOut == -1)
+         return false;
+      int fdErr = dupCloexec(fdStderr);
+      if (fdErr == -1)
+      {
+         ::close(fdOut);
+         return false;
+      }
+
+      LOCK_MUTEX(mutex_)
+      {
+         if (!ensureThreadRunning())
+         {
+            ::close(fdOut);
+            ::close(fdErr);
+            return false;
+         }
+
+         Registration registration;
+         registration.pOutput = pOutput;
+         registration.fdStdout = fdOut;
+         registration.fdStderr = fdErr;
+         registrations_.push_back(registration);
+      }
+      END_LOCK_MUTEX
+
+      wake();
+      return true;
+   }
+
+   // unregister a child, blocking until the reactor thread has stopped
+   // reading from (and has closed) its descriptors -- after this returns
+   // the caller can safely drain any remaining output from the original
+   // descriptors directly
+   void unregisterChild(const boost::shared_ptr<MultiplexedOutput>& pOutput)
+   {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      bool found = false;
+      BOOST_FOREACH(Registration& registration, registrations_)
+      {
+         if (registration.pOutput == pOutput)
+         {
+            registration.unregistered = true;
+            found = true;
+         }
+      }
+      if (!found)
+         return;
+
+      wake();
+      while (hasRegistration(pOutput))
+         condition_.wait(lock);
+   }
+
+private:
+   OutputReactor()
+      : started_(false)
+   {
+      wakeupPipe_[READ] = -1;
+      wakeupPipe_[WRITE] = -1;
+   }
+
+   struct Registration
+   {
+      Registration() : fdStdout(-1), fdStderr(-1), unregistered(false) {}
+      boost::shared_ptr<MultiplexedOutput> pOutput;
+      int fdStdout;
+      int fdStderr;
+      bool unregistered;
+   };
+
+   static int dupCloexec(int fd)
+   {
+      int duplicate = ::dup(fd);
+      if (duplicate != -1)
+         ::fcntl(duplicate, F_SETFD, FD_CLOEXEC);
+      return duplicate;
+   }
+
+   // NOTE: callers must hold mutex_
+   bool ensureThreadRunning()
+   {
+      if (started_)
+         return true;
+
+      Error error = cloexecPipe(wakeupPipe_);
+      if (error)
+      {
+         LOG_ERROR(error);
+         return false;
+      }
+      setPipeNonBlocking(wakeupPipe_[READ]);
+      setPipeNonBlocking(wakeupPipe_[WRITE]);
+
+      try
+      {
+         boost::thread thread(boost::bind(&OutputReactor::threadMain, this));
+         thread.detach();
+      }
+      catch(const boost::thread_resource_error&)
+      {
+         closePipe(wakeupPipe_, ERROR_LOCATION);
+         wakeupPipe_[READ] = -1;
+         wakeupPipe_[WRITE] = -1;
+         return false;
+      }
+
+      started_ = true;
+      return true;
+   }
+
+   // NOTE: callers must hold mutex_
+   bool hasRegistration(const boost::shared_ptr<MultiplexedOutput>& pOutput)
+                                                                         const
+   {
+      BOOST_FOREACH(const Registration& registration, registrations_)
+      {
+         if (registration.pOutput == pOutput)
+            return true;
+      }
+      return false;
+   }
+
+   void wake()
+   {
+      // a full wakeup pipe already guarantees a wakeup so a failed
+      // (would-block) write is fine
+      char byte = 0;
+      int result = ::write(wakeupPipe_[WRITE], &byte, 1);
+      (void)result;
+   }
+
+   static void addPollFd(int fd, std::vector<struct pollfd>* pPollFds)
+   {
+      if (fd != -1)
+      {
+         struct pollfd pollFd;
+         pollFd.fd = fd;
+         pollFd.events = POLLIN;
+         pollFd.revents = 0;
+         pPollFds->push_back(pollFd);
+      }
+   }
+
+   // read available output into the child's buffer (closing the
+   // descriptor on eof or error)
+   void drain(int* pFd, const boost::shared_ptr<MultiplexedOutput>& pOutput,
+              bool isStdout)
+   {
+      std::string output;
+      bool eof = false;
+      Error error = readPipe(*pFd, &output, &eof);
+      if (error)
+      {
+         pOutput->setError(error);
+         eof = true;
+      }
+      pOutput->append(output, eof, isStdout);
+      if (eof)
+      {
+         ::close(*pFd);
+         *pFd = -1;
+      }
+   }
+
+   void closeRegistration(Registration* pRegistration)
+   {
+      if (pRegistration->fdStdout != -1)
+      {
+         ::close(pRegistration->fdStdout);
+         pRegistration->fdStdout = -1;
+      }
+      if (pRegistration->fdStderr != -1)
+      {
+         ::close(pRegistration->fdStderr);
+         pRegistration->fdStderr = -1;
+      }
+   }
+
+   void threadMain()
+   {
+      try
+      {
+         std::vector<struct pollfd> pollFds;
+         while (true)
+         {
+            // seed the descriptor set with the wakeup pipe
+            pollFds.clear();
+            addPollFd(wakeupPipe_[READ], &pollFds);
+
+            LOCK_MUTEX(mutex_)
+            {
+               // close the descriptors of unregistered children here
+               // (rather than in unregisterChild) so that closing can
+               // never race with a read in progress, then notify any
+               // blocked unregisterChild calls
+               for (std::size_t i = 0; i < registrations_.size(); )
+               {
+                  if (registrations_[i].unregistered)
+                  {
+                     closeRegistration(&registrations_[i]);
+                     registrations_.erase(registrations_.begin() + i);
+                  }
+                  else
+                  {
+                     i++;
+                  }
+               }
+               condition_.notify_all();
+
+               BOOST_FOREACH(const Registration& registration, registrations_)
+               {
+                  addPollFd(registration.fdStdout, &pollFds);
+                  addPollFd(registration.fdStderr, &pollFds);
+               }
+            }
+            END_LOCK_MUTEX
+
+            // wait for output to arrive (or a wakeup)
+            int result = ::poll(&pollFds[0], pollFds.size(), -1);
+            if (result == -1)
+            {
+               if (errno != EINTR)
+                  LOG_ERROR(systemError(errno, ERROR_LOCATION));
+               continue;
+            }
+
+            // drain the wakeup pipe
+            if (pollFds[0].revents != 0)
+            {
+               char buffer[64];
+               while (::read(wakeupPipe_[READ], buffer, sizeof(buffer)) > 0)
+               {
+               }
+            }
+
+            // collect the set of ready descriptors
+            std::set<int> readyFds;
+            for (std::size_t i = 1; i < pollFds.size(); i++)
+            {
+               if (pollFds[i].revents & (POLLIN | POLLHUP | POLLERR))
+                  readyFds.insert(pollFds[i].fd);
+            }
+
+            // read from the ready descriptors (the reads are non-blocking
+            // so holding the mutex here is bounded by the pipe capacity)
+            LOCK_MUTEX(mutex_)
+            {
+               BOOST_FOREACH(Registration& registration, registrations_)
+               {
+                  if (registration.unregistered)
+                     continue;
+                  if (registration.fdStdout != -1 &&
+                      readyFds.count(registration.fdStdout) > 0)
+                  {
+                     drain(&registration.fdStdout, registration.pOutput, true);
+                  }
+                  if (registration.fdStderr != -1 &&
+                      readyFds.count(registration.fdStderr) > 0)
+                  {
+                     drain(&registration.fdStderr, registration.pOutput, false);
+                  }
+               }
+            }
+            END_LOCK_MUTEX
+         }
+      }
+      CATCH_UNEXPECTED_EXCEPTION
+   }
+
+private:
+   boost::mutex mutex_;
+   boost::condition_variable condition_;
+   std::vector<Registration> registrations_;
+   int wakeupPipe_[2];
+   bool started_;
+};
+
+} // anonymous namespace
+
 struct AsyncChildProcess::AsyncImpl
 {
    AsyncImpl()
@@ -850,6 +1368,7 @@ struct AsyncChildProcess::AsyncImpl
    bool finishedStderr_;
    bool exited_;
    boost::scoped_ptr<ChildProcessSubprocPoll> pSubprocPoll_;
+   boost::shared_ptr<MultiplexedOutput> pMultiplexedOutput_;
 };
 
 AsyncChildProcess::AsyncChildProcess(const std::string& exe,
@@ -880,6 +1399,10 @@ AsyncChildProcess::AsyncChildProcess(const ProcessOptions& options)
 
 AsyncChildProcess::~AsyncChildProcess()
 {
+   // make sure the output reactor is no longer referencing our pipes
+   if (pAsyncImpl_->pMultiplexedOutput_)
+      OutputReactor::instance().unregisterChild(
+                                          pAsyncImpl_->pMultiplexedOutput_);
 }
 
 Error AsyncChildProcess::terminate()
@@ -947,7 +1470,24 @@ void AsyncChildProcess::poll()
       if (options().pseudoterminal)
          pAsyncImpl_->finishedStderr_ = true;
       else
-         setPipeNonBlocking(pImpl_->fdStderr);         
+         setPipeNonBlocking(pImpl_->fdStderr);
+
+      // hand the output descriptors to the shared reactor thread, which
+      // waits on the descriptors of all children at once and drains
+      // output as it arrives (rather than this thread attempting reads
+      // on every poll). pseudoterminal children are excluded because
+      // their shutdown sequence relies on closing every handle to the
+      // terminal, which duplicated descriptors would defeat
+      if (!options().pseudoterminal)
+      {
+         boost::shared_ptr<MultiplexedOutput> pOutput(new MultiplexedOutput());
+         if (OutputReactor::instance().registerChild(pOutput,
+                                                     pImpl_->fdStdout,
+                                                     pImpl_->fdStderr))
+         {
+            pAsyncImpl_->pMultiplexedOutput_ = pOutput;
+         }
+      }
 
       // setup for subprocess polling
       pAsyncImpl_->pSubprocPoll_.reset(new ChildProcessSubprocPoll(
@@ -975,50 +1515,82 @@ void AsyncChildProcess::poll()
 
    bool hasRecentOutput = false;
 
-   // check stdout and fire event if we got output
-   if (!pAsyncImpl_->finishedStdout_)
+   // multiplexed mode: deliver whatever the reactor thread has drained
+   // since the last poll as a single batch
+   if (pAsyncImpl_->pMultiplexedOutput_)
    {
-      bool eof;
-      std::string out;
-      Error error = readPipe(pImpl_->fdStdout, &out, &eof);
+      std::string out, err;
+      bool outEof = false, errEof = false;
+      Error error;
+      pAsyncImpl_->pMultiplexedOutput_->collect(&out, &outEof,
+                                                &err, &errEof,
+                                                &error);
       if (error)
-      {
          reportError(error);
-      }
-      else
+
+      if (!out.empty() && callbacks_.onStdout)
       {
-         if (!out.empty() && callbacks_.onStdout)
-         {
-            hasRecentOutput = true;
-            callbacks_.onStdout(*this, out);
-         }
+         hasRecentOutput = true;
+         callbacks_.onStdout(*this, out);
+      }
+      if (outEof)
+         pAsyncImpl_->finishedStdout_ = true;
 
-         if (eof)
-           pAsyncImpl_->finishedStdout_ = true;
+      if (!err.empty() && callbacks_.onStderr)
+      {
+         hasRecentOutput = true;
+         callbacks_.onStderr(*this, err);
       }
+      if (errEof)
+         pAsyncImpl_->finishedStderr_ = true;
    }
-
-   // check stderr and fire event if we got output
-   if (!pAsyncImpl_->finishedStderr_)
+   else
    {
-      bool eof;
-      std::string err;
-      Error error = readPipe(pImpl_->fdStderr, &err, &eof);
-
-      if (error)
+      // check stdout and fire event if we got output
+      if (!pAsyncImpl_->finishedStdout_)
       {
-         reportError(error);
+         bool eof;
+         std::string out;
+         Error error = readPipe(pImpl_->fdStdout, &out, &eof);
+         if (error)
+         {
+            reportError(error);
+         }
+         else
+         {
+            if (!out.empty() && callbacks_.onStdout)
+            {
+               hasRecentOutput = true;
+               callbacks_.onStdout(*this, out);
+            }
+
+            if (eof)
+              pAsyncImpl_->finishedStdout_ = true;
+         }
       }
-      else
+
+      // check stderr and fire event if we got output
+      if (!pAsyncImpl_->finishedStderr_)
       {
-         if (!err.empty() && callbacks_.onStderr)
+         bool eof;
+         std::string err;
+         Error error = readPipe(pImpl_->fdStderr, &err, &eof);
+
+         if (error)
          {
-            hasRecentOutput = true;
-            callbacks_.onStderr(*this, err);
+            reportError(error);
          }
+         else
+         {
+            if (!err.empty() && callbacks_.onStderr)
+            {
+               hasRecentOutput = true;
+               callbacks_.onStderr(*this, err);
+            }
 
-         if (eof)
-           pAsyncImpl_->finishedStderr_ = true;
+            if (eof)
+              pAsyncImpl_->finishedStderr_ = true;
+         }
       }
    }
 
@@ -1035,6 +1607,39 @@ void AsyncChildProcess::poll()
    // either a normal exit or an error while waiting
    if (result != 0)
    {
+      // stop multiplexing and synchronously drain anything the reactor
+      // hadn't consumed yet (the child may have produced final output
+      // between the reactor's last read and its exit)
+      if (pAsyncImpl_->pMultiplexedOutput_)
+      {
+         OutputReactor::instance().unregisterChild(
+                                          pAsyncImpl_->pMultiplexedOutput_);
+
+         std::string out, err;
+         bool outEof = false, errEof = false;
+         Error error;
+         pAsyncImpl_->pMultiplexedOutput_->collect(&out, &outEof,
+                                                   &err, &errEof,
+                                                   &error);
+         if (error)
+            reportError(error);
+
+         bool ignoredEof;
+         error = readPipe(pImpl_->fdStdout, &out, &ignoredEof);
+         if (error)
+            reportError(error);
+         error = readPipe(pImpl_->fdStderr, &err, &ignoredEof);
+         if (error)
+            reportError(error);
+
+         if (!out.empty() && callbacks_.onStdout)
+            callbacks_.onStdout(*this, out);
+         if (!err.empty() && callbacks_.onStderr)
+            callbacks_.onStderr(*this, err);
+
+         pAsyncImpl_->pMultiplexedOutput_.reset();
+      }
+
       // close all of our pipes
       pImpl_->closeAll(ERROR_LOCATION);
 
@@ -18,12 +18,16 @@
 #include <dirent.h>
 #include <sys/stat.h>
 
+#include <deque>
+#include <map>
+
 #include <boost/foreach.hpp>
+#include <boost/utility.hpp>
 
 #include <core/Error.hpp>
 #include <core/Log.hpp>
 #include <core/FilePath.hpp>
-#include <core/BoostThread.hpp>
+#include <core/Thread.hpp>
 
 #include "config.h"
 
@@ -98,45 +102,33 @@ Error scanDir(const std::string& dirPath, std::vector<std::string>* pNames)
    return Success();
 }
 
-} // anonymous namespace
-
-Error scanFiles(const tree<FileInfo>::iterator_base& fromNode,
-                const FileScannerOptions& options,
-                tree<FileInfo>* pTree)
+// stat the named entries of a directory, producing a FileInfo per entry
+// with the attributes cached (so callers never need to stat again). the
+// child paths are composed with plain string appends (rather than
+// FilePath/boost::filesystem temporaries) since this loop runs once per
+// entry of every scanned directory
+Error statEntries(const std::string& dirPath,
+                  const std::vector<std::string>& names,
+                  bool traverseSymlinks,
+                  const boost::function<bool(const FileInfo&)>& filter,
+                  std::vector<FileInfo>* pEntries)
 {
-   // clear all existing
-   pTree->erase_children(fromNode);
+   // seed the path buffer with the directory prefix (reused per entry)
+   std::string path = dirPath;
+   if (!path.empty() && path[path.size()-1] != '/')
+      path += '/';
+   std::string::size_type prefixLength = path.size();
 
-   // create FilePath for root
-   FilePath rootPath(fromNode->absolutePath());
-
-   // yield if requested (only applies to recursive scans)
-   if (options.recursive && options.yield)
-      boost::this_thread::yield();
-
-   // call onBeforeScanDir hook
-   if (options.onBeforeScanDir)
-   {
-      Error error = options.onBeforeScanDir(*fromNode);
-      if (error)
-         return error;
-   }
-
-   // read directory contents
-   std::vector<std::string> names;
-   Error error = scanDir(fromNode->absolutePath(), &names);
-   if (error)
-      return error;
-
-   // iterate over the names
    BOOST_FOREACH(const std::string& name, names)
    {
       // compute the path
-      std::string path = rootPath.childPath(name).absolutePath();
+      path.resize(prefixLength);
+      path += name;
 
       // get the attributes
       struct stat st;
-      int res = ::lstat(path.c_str(), &st);
+      int res = traverseSymlinks ? ::stat(path.c_str(), &st)
+                                 : ::lstat(path.c_str(), &st);
       if (res == -1)
       {
          if (errno != ENOENT && errno != EACCES)
@@ -169,37 +161,223 @@ Error scanFiles(const tree<FileInfo>::iterator_base& fromNode,
       }
 
       // apply the filter (if any)
-      if (!options.filter || options.filter(fileInfo))
+      if (!filter || filter(fileInfo))
+         pEntries->push_back(fileInfo);
+   }
+
+   return Success();
+}
+
+// scan a single directory: read the entries, stat them, and apply the
+// filter (if any). shared by the sequential and parallel scan paths
+Error listDirectory(const FileInfo& dirInfo,
+                    const FileScannerOptions& options,
+                    std::vector<FileInfo>* pEntries)
+{
+   // call onBeforeScanDir hook
+   if (options.onBeforeScanDir)
+   {
+      Error error = options.onBeforeScanDir(dirInfo);
+      if (error)
+         return error;
+   }
+
+   // read directory contents
+   std::vector<std::string> names;
+   Error error = scanDir(dirInfo.absolutePath(), &names);
+   if (error)
+      return error;
+
+   // stat and filter the entries (lstat so symlinks aren't traversed)
+   return statEntries(dirInfo.absolutePath(), names, false,
+                      options.filter, pEntries);
+}
+
+// parallel scan: a pool of workers drains a shared queue of directories,
+// producing a listing per directory; the FileInfo tree is then assembled
+// (single-threaded) from the listings. directories which fail to scan
+// are logged and skipped, matching the sequential behavior
+class ParallelFileScanner : boost::noncopyable
+{
+public:
+   explicit ParallelFileScanner(const FileScannerOptions& options)
+      : options_(options), pendingCount_(0)
+   {
+   }
+
+   Error scan(const tree<FileInfo>::iterator_base& fromNode,
+              tree<FileInfo>* pTree)
+   {
+      // scan the root synchronously (so that an unreadable root fails
+      // the entire scan, as in the sequential case)
+      std::vector<FileInfo>& rootEntries = listings_[fromNode->absolutePath()];
+      Error error = listDirectory(*fromNode, options_, &rootEntries);
+      if (error)
+         return error;
+      enqueueSubdirectories(rootEntries);
+
+      // run the workers (the calling thread participates, so start
+      // concurrentScanners - 1 additional threads)
+      std::vector<boost::shared_ptr<boost::thread> > threads;
+      for (std::size_t i = 1; i < options_.concurrentScanners; i++)
       {
-         // add the correct type of FileEntry
-         if (fileInfo.isDirectory())
+         threads.push_back(boost::shared_ptr<boost::thread>(new boost::thread(
+                              &ParallelFileScanner::workerThread, this)));
+      }
+      workerThread();
+      for (std::size_t i = 0; i < threads.size(); i++)
+         threads[i]->join();
+
+      // assemble the tree from the listings
+      appendListing(fromNode, pTree);
+
+      return Success();
+   }
+
+private:
+   void enqueueSubdirectories(const std::vector<FileInfo>& entries)
+   {
+      // NOTE: callers hold mutex_ (or no workers are running yet)
+      BOOST_FOREACH(const FileInfo& fileInfo, entries)
+      {
+         if (fileInfo.isDirectory() && !fileInfo.isSymlink())
          {
-            tree<FileInfo>::iterator_base child = pTree->append_child(fromNode,
-                                                                      fileInfo);
-            // recurse if requested and this isn't a link
-            if (options.recursive && !fileInfo.isSymlink())
-            {
-               // try to scan the files in the subdirectory -- if we fail
-               // we continue because we don't want one "bad" directory
-               // to cause us to abort the entire scan. yes the tree
-               // will be incomplete however it will be even more incompete
-               // if we fail entirely
-               Error error = scanFiles(child, options, pTree);
-               if (error)
-                  LOG_ERROR(error);
-            }
+            queue_.push_back(fileInfo);
+            pendingCount_++;
          }
-         else
+      }
+   }
+
+   void workerThread()
+   {
+      try
+      {
+         while (true)
          {
-            pTree->append_child(fromNode, fileInfo);
+            FileInfo dirInfo;
+            {
+               boost::unique_lock<boost::mutex> lock(mutex_);
+               while (queue_.empty() && pendingCount_ > 0)
+                  condition_.wait(lock);
+
+               // no queued work and nothing in flight which could
+               // produce more -- we're done
+               if (queue_.empty())
+                  break;
+
+               dirInfo = queue_.front();
+               queue_.pop_front();
+            }
+
+            // scan outside the lock (if we fail we continue because we
+            // don't want one "bad" directory to abort the entire scan)
+            std::vector<FileInfo> entries;
+            Error error = listDirectory(dirInfo, options_, &entries);
+            if (error)
+               LOG_ERROR(error);
+
+            // merge the listing and enqueue its subdirectories
+            {
+               boost::unique_lock<boost::mutex> lock(mutex_);
+               listings_[dirInfo.absolutePath()].swap(entries);
+               enqueueSubdirectories(listings_[dirInfo.absolutePath()]);
+               pendingCount_--;
+               condition_.notify_all();
+            }
          }
       }
+      CATCH_UNEXPECTED_EXCEPTION
+   }
+
+   void appendListing(const tree<FileInfo>::iterator_base& node,
+                      tree<FileInfo>* pTree)
+   {
+      std::map<std::string, std::vector<FileInfo> >::const_iterator it =
+                                       listings_.find(node->absolutePath());
+      if (it == listings_.end())
+         return;
+
+      BOOST_FOREACH(const FileInfo& fileInfo, it->second)
+      {
+         tree<FileInfo>::iterator_base child = pTree->append_child(node,
+                                                                   fileInfo);
+         if (fileInfo.isDirectory() && !fileInfo.isSymlink())
+            appendListing(child, pTree);
+      }
+   }
+
+private:
+   FileScannerOptions options_;
+   boost::mutex mutex_;
+   boost::condition_variable condition_;
+   std::deque<FileInfo> queue_;
+   std::size_t pendingCount_;
+   std::map<std::string, std::vector<FileInfo> > listings_;
+};
+
+} // anonymous namespace
+
+Error scanFiles(const tree<FileInfo>::iterator_base& fromNode,
+                const FileScannerOptions& options,
+                tree<FileInfo>* pTree)
+{
+   // clear all existing
+   pTree->erase_children(fromNode);
+
+   // use the parallel scanner if requested (recursive scans only --
+   // there is no win for a single directory)
+   if (options.recursive && options.concurrentScanners > 1)
+   {
+      ParallelFileScanner scanner(options);
+      return scanner.scan(fromNode, pTree);
+   }
+
+   // yield if requested (only applies to recursive scans)
+   if (options.recursive && options.yield)
+      boost::this_thread::yield();
+
+   // scan this directory
+   std::vector<FileInfo> entries;
+   Error error = listDirectory(*fromNode, options, &entries);
+   if (error)
+      return error;
+
+   // append the entries to the tree (recursing into subdirectories)
+   BOOST_FOREACH(const FileInfo& fileInfo, entries)
+   {
+      tree<FileInfo>::iterator_base child = pTree->append_child(fromNode,
+                                                                fileInfo);
+      // recurse if requested and this isn't a link
+      if (fileInfo.isDirectory() && options.recursive && !fileInfo.isSymlink())
+      {
+         // try to scan the files in the subdirectory -- if we fail
+         // we continue because we don't want one "bad" directory
+         // to cause us to abort the entire scan. yes the tree
+         // will be incomplete however it will be even more incompete
+         // if we fail entirely
+         Error error = scanFiles(child, options, pTree);
+         if (error)
+            LOG_ERROR(error);
+      }
    }
 
    // return success
    return Success();
 }
 
+Error readDirectory(const FilePath& dirPath, std::vector<FileInfo>* pEntries)
+{
+   // read directory contents
+   std::vector<std::string> names;
+   Error error = scanDir(dirPath.absolutePath(), &names);
+   if (error)
+      return error;
+
+   // stat the entries (traversing symlinks, as FilePath::children does)
+   return statEntries(dirPath.absolutePath(), names, true,
+                      boost::function<bool(const FileInfo&)>(), pEntries);
+}
+
 } // namespace system
 } // namespace core
 } // namespace rstudio
@@ -0,0 +1,116 @@
+/*
+ * PosixMemoryMappedFile.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/system/MemoryMappedFile.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <core/FilePath.hpp>
+#include <core/Log.hpp>
+
+namespace rstudio {
+namespace core {
+namespace system {
+
+MemoryMappedFile::MemoryMappedFile()
+   : open_(false), data_(NULL), size_(0)
+{
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+   try
+   {
+      close();
+   }
+   catch(...)
+   {
+   }
+}
+
+Error MemoryMappedFile::open(const FilePath& filePath)
+{
+   // close any existing mapping
+   close();
+
+   // open the file
+   int fd = ::open(filePath.absolutePath().c_str(), O_RDONLY);
+   if (fd == -1)
+   {
+      Error error = systemError(errno, ERROR_LOCATION);
+      error.addProperty("path", filePath.absolutePath());
+      return error;
+   }
+
+   // determine its size
+   struct stat st;
+   if (::fstat(fd, &st) == -1)
+   {
+      Error error = systemError(errno, ERROR_LOCATION);
+      error.addProperty("path", filePath.absolutePath());
+      ::close(fd);
+      return error;
+   }
+
+   // zero-length files can't be mapped (and don't need to be)
+   if (st.st_size == 0)
+   {
+      ::close(fd);
+      open_ = true;
+      return Success();
+   }
+
+   // map it read-only (private since we never write)
+   void* pData = ::mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+   // the mapping holds its own reference to the file
+   ::close(fd);
+
+   if (pData == MAP_FAILED)
+   {
+      Error error = systemError(errno, ERROR_LOCATION);
+      error.addProperty("path", filePath.absolutePath());
+      return error;
+   }
+
+   // advise the kernel that we'll read the mapping sequentially
+#ifdef POSIX_MADV_SEQUENTIAL
+   ::posix_madvise(pData, st.st_size, POSIX_MADV_SEQUENTIAL);
+#endif
+
+   data_ = pData;
+   size_ = st.st_size;
+   open_ = true;
+   return Success();
+}
+
+void MemoryMappedFile::close()
+{
+   if (data_ != NULL)
+   {
+      if (::munmap(data_, size_) == -1)
+         LOG_ERROR(systemError(errno, ERROR_LOCATION));
+      data_ = NULL;
+      size_ = 0;
+   }
+   open_ = false;
+}
+
+} // namespace system
+} // namespace core
+} // namespace rstudio
@@ -18,6 +18,16 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+
+#ifdef __APPLE__
+# include <sys/param.h>
+# include <sys/mount.h>
+#else
+# include <sys/vfs.h>
+#endif
+
+#include <boost/algorithm/string/predicate.hpp>
+
 #include <core/Error.hpp>
 #include <core/FilePath.hpp>
 
@@ -73,6 +83,28 @@ core::Error statWithCacheClear(const core::FilePath& path,
    return core::Success();
 }
 
+core::Error isNfs(const core::FilePath& path, bool* pIsNfs)
+{
+   *pIsNfs = false;
+
+   struct statfs fs;
+   if (::statfs(path.absolutePath().c_str(), &fs) == -1)
+   {
+      Error error = systemError(errno, ERROR_LOCATION);
+      error.addProperty("path", path.absolutePath());
+      return error;
+   }
+
+#ifdef __APPLE__
+   *pIsNfs = boost::algorithm::iequals(fs.f_fstypename, "nfs");
+#else
+   // NFS_SUPER_MAGIC (linux/magic.h, which we avoid depending on)
+   *pIsNfs = (fs.f_type == 0x6969);
+#endif
+
+   return core::Success();
+}
+
 } // namespace nfs
 } // namespace system
 } // namespace core
@@ -65,6 +65,7 @@
 #include <core/Log.hpp>
 #include <core/FilePath.hpp>
 #include <core/FileInfo.hpp>
+#include <core/AsyncLogWriter.hpp>
 #include <core/FileLogWriter.hpp>
 #include <core/Exec.hpp>
 #include <core/SyslogLogWriter.hpp>
@@ -221,6 +222,18 @@ void initializeLog(const std::string& programIdentity,
    s_pLogWriter = new FileLogWriter(programIdentity, logLevel, logDir);
 }
 
+void initializeAsyncLog(const std::string& programIdentity,
+                        int logLevel,
+                        const FilePath& logDir)
+{
+   if (s_pLogWriter)
+      delete s_pLogWriter;
+
+   boost::shared_ptr<LogWriter> pFileLogWriter(
+                        new FileLogWriter(programIdentity, logLevel, logDir));
+   s_pLogWriter = new AsyncLogWriter(pFileLogWriter);
+}
+
 void setLogToStderr(bool logToStderr)
 {
    if (s_pLogWriter)
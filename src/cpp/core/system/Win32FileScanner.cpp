@@ -141,6 +141,33 @@ Error scanFiles(const tree<FileInfo>::iterator_base& fromNode,
    return Success();
 }
 
+Error readDirectory(const FilePath& dirPath, std::vector<FileInfo>* pEntries)
+{
+   // read directory entries
+   std::vector<FilePath> children;
+   Error error = dirPath.children(&children);
+   if (error)
+      return error;
+
+   // convert to FileInfo (entries deleted mid-listing are skipped)
+   BOOST_FOREACH(const FilePath& filePath, children)
+   {
+      if (filePath.isDirectory())
+      {
+         pEntries->push_back(FileInfo(filePath.absolutePath(), true));
+      }
+      else if (filePath.exists())
+      {
+         pEntries->push_back(FileInfo(filePath.absolutePath(),
+                                      false,
+                                      filePath.size(),
+                                      filePath.lastWriteTime()));
+      }
+   }
+
+   return Success();
+}
+
 
 } // namespace system
 } // namespace core
@@ -0,0 +1,144 @@
+/*
+ * Win32MemoryMappedFile.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/system/MemoryMappedFile.hpp>
+
+#include <windows.h>
+
+#include <core/FilePath.hpp>
+#include <core/Log.hpp>
+#include <core/StringUtils.hpp>
+
+namespace rstudio {
+namespace core {
+namespace system {
+
+MemoryMappedFile::MemoryMappedFile()
+   : open_(false),
+     data_(NULL),
+     size_(0),
+     hFile_(INVALID_HANDLE_VALUE),
+     hMapping_(NULL)
+{
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+   try
+   {
+      close();
+   }
+   catch(...)
+   {
+   }
+}
+
+Error MemoryMappedFile::open(const FilePath& filePath)
+{
+   // close any existing mapping
+   close();
+
+   // open the file
+   std::wstring widePath = string_utils::utf8ToWide(filePath.absolutePath());
+   HANDLE hFile = ::CreateFileW(widePath.c_str(),
+                                GENERIC_READ,
+                                FILE_SHARE_READ,
+                                NULL,
+                                OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL,
+                                NULL);
+   if (hFile == INVALID_HANDLE_VALUE)
+   {
+      Error error = systemError(::GetLastError(), ERROR_LOCATION);
+      error.addProperty("path", filePath.absolutePath());
+      return error;
+   }
+
+   // determine its size
+   LARGE_INTEGER fileSize;
+   if (!::GetFileSizeEx(hFile, &fileSize))
+   {
+      Error error = systemError(::GetLastError(), ERROR_LOCATION);
+      error.addProperty("path", filePath.absolutePath());
+      ::CloseHandle(hFile);
+      return error;
+   }
+
+   // zero-length files can't be mapped (and don't need to be)
+   if (fileSize.QuadPart == 0)
+   {
+      ::CloseHandle(hFile);
+      open_ = true;
+      return Success();
+   }
+
+   // create the read-only mapping
+   HANDLE hMapping = ::CreateFileMappingW(hFile, NULL, PAGE_READONLY,
+                                          0, 0, NULL);
+   if (hMapping == NULL)
+   {
+      Error error = systemError(::GetLastError(), ERROR_LOCATION);
+      error.addProperty("path", filePath.absolutePath());
+      ::CloseHandle(hFile);
+      return error;
+   }
+
+   // map the view
+   void* pData = ::MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+   if (pData == NULL)
+   {
+      Error error = systemError(::GetLastError(), ERROR_LOCATION);
+      error.addProperty("path", filePath.absolutePath());
+      ::CloseHandle(hMapping);
+      ::CloseHandle(hFile);
+      return error;
+   }
+
+   hFile_ = hFile;
+   hMapping_ = hMapping;
+   data_ = pData;
+   size_ = static_cast<std::size_t>(fileSize.QuadPart);
+   open_ = true;
+   return Success();
+}
+
+void MemoryMappedFile::close()
+{
+   if (data_ != NULL)
+   {
+      if (!::UnmapViewOfFile(data_))
+         LOG_ERROR(systemError(::GetLastError(), ERROR_LOCATION));
+      data_ = NULL;
+      size_ = 0;
+   }
+
+   if (hMapping_ != NULL)
+   {
+      ::CloseHandle(hMapping_);
+      hMapping_ = NULL;
+   }
+
+   if (hFile_ != INVALID_HANDLE_VALUE)
+   {
+      ::CloseHandle(hFile_);
+      hFile_ = INVALID_HANDLE_VALUE;
+   }
+
+   open_ = false;
+}
+
+} // namespace system
+} // namespace core
+} // namespace rstudio
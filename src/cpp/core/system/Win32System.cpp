@@ -41,6 +41,7 @@
 #include <core/Log.hpp>
 #include <core/LogWriter.hpp>
 #include <core/Error.hpp>
+#include <core/AsyncLogWriter.hpp>
 #include <core/FileLogWriter.hpp>
 #include <core/StderrLogWriter.hpp>
 #include <core/FilePath.hpp>
@@ -202,6 +203,18 @@ void initializeLog(const std::string& programIdentity, int logLevel, const FileP
    s_pLogWriter = new FileLogWriter(programIdentity, logLevel, settingsDir);
 }
 
+void initializeAsyncLog(const std::string& programIdentity,
+                        int logLevel,
+                        const FilePath& settingsDir)
+{
+   if (s_pLogWriter)
+      delete s_pLogWriter;
+
+   boost::shared_ptr<LogWriter> pFileLogWriter(
+                   new FileLogWriter(programIdentity, logLevel, settingsDir));
+   s_pLogWriter = new AsyncLogWriter(pFileLogWriter);
+}
+
 void setLogToStderr(bool logToStderr)
 {
    if (s_pLogWriter)
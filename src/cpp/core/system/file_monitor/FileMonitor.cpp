@@ -24,6 +24,7 @@
 
 #include <core/Log.hpp>
 #include <core/Error.hpp>
+#include <core/FlightRecorder.hpp>
 #include <core/Thread.hpp>
 #include <core/PeriodicCommand.hpp>
 
@@ -675,7 +676,11 @@ void checkForChanges()
 {
    boost::function<void()> callback;
    while (callbackQueue().deque(&callback))
+   {
+      flight_recorder::record("file-monitor callback begin");
       callback();
+      flight_recorder::record("file-monitor callback end");
+   }
 }
 
 namespace {
@@ -21,11 +21,14 @@
 #include <sys/types.h>
 #include <sys/inotify.h>
 
+#include <deque>
+#include <map>
 #include <set>
 
 #include <boost/utility.hpp>
 #include <boost/foreach.hpp>
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/hashed_index.hpp>
@@ -34,7 +37,9 @@
 #include <core/Log.hpp>
 #include <core/Error.hpp>
 #include <core/FileInfo.hpp>
+#include <core/SafeConvert.hpp>
 
+#include <core/system/Environment.hpp>
 #include <core/system/FileScanner.hpp>
 #include <core/system/System.hpp>
 
@@ -158,6 +163,84 @@ private:
    WatchesContainer watches_;
 };
 
+// directories we were unable to watch because the inotify watch limit
+// (fs.inotify.max_user_watches) was reached. maintained as a round-robin
+// queue so that every unwatched directory is eventually rescanned, with
+// directories which changed on their last rescan moved to the front so
+// that active subtrees are polled ahead of cold ones
+class UnwatchedDirs
+{
+public:
+   bool empty() const { return queue_.empty(); }
+
+   std::size_t size() const { return queue_.size(); }
+
+   void add(const std::string& path)
+   {
+      if (dirs_.count(path) > 0)
+         return;
+
+      // don't queue a directory if an ancestor is already queued (rescans
+      // of the ancestor are recursive and so already cover this directory)
+      for (FilePath parentPath = FilePath(path).parent();
+           !parentPath.empty();
+           parentPath = parentPath.parent())
+      {
+         if (dirs_.count(parentPath.absolutePath()) > 0)
+            return;
+      }
+
+      queue_.push_back(path);
+      dirs_.insert(path);
+   }
+
+   void remove(const std::string& path)
+   {
+      if (dirs_.erase(path) > 0)
+         queue_.erase(std::remove(queue_.begin(), queue_.end(), path),
+                      queue_.end());
+   }
+
+   // pop up to n directories from the front of the queue
+   std::vector<std::string> next(std::size_t n)
+   {
+      std::vector<std::string> dirs;
+      while (!queue_.empty() && dirs.size() < n)
+      {
+         dirs.push_back(queue_.front());
+         queue_.pop_front();
+         dirs_.erase(dirs.back());
+      }
+      return dirs;
+   }
+
+   // re-queue as hot (changed on its last rescan)
+   void toFront(const std::string& path)
+   {
+      remove(path);
+      queue_.push_front(path);
+      dirs_.insert(path);
+   }
+
+   // re-queue as cold
+   void toBack(const std::string& path)
+   {
+      remove(path);
+      queue_.push_back(path);
+      dirs_.insert(path);
+   }
+
+   void clear()
+   {
+      queue_.clear();
+      dirs_.clear();
+   }
+
+private:
+   std::deque<std::string> queue_;
+   std::set<std::string> dirs_;
+};
+
 
 class FileEventContext : boost::noncopyable
 {
@@ -172,11 +255,16 @@ public:
    Handle handle;
    int fd;
    Watches watches;
+   UnwatchedDirs unwatchedDirs;
    FilePath rootPath;
    bool recursive;
    boost::function<bool(const FileInfo&)> filter;
    tree<FileInfo> fileTree;
    Callbacks callbacks;
+   std::vector<FileChangeEvent> pendingChanges;
+   boost::posix_time::ptime firstPendingTime;
+   boost::posix_time::ptime lastPendingTime;
+   boost::posix_time::ptime nextUnwatchedRescanTime;
 };
 
 void terminateWithMonitoringError(FileEventContext* pContext,
@@ -190,10 +278,8 @@ void terminateWithMonitoringError(FileEventContext* pContext,
 }
 
 Error addWatch(const FileInfo& fileInfo,
-               const FilePath& rootPath,
                bool allowRootSymlink,
-               int fd,
-               Watches* pWatches)
+               FileEventContext* pContext)
 {
    // NOTE: both inotify_add_watch and std::set::insert gracefully
    // handle duplicate additions, inotify_add_watch by modifying the
@@ -214,22 +300,35 @@ Error addWatch(const FileInfo& fileInfo,
    // add IN_DONT_FOLLOW unless we are explicitly allowing root symlinks
    // and this is a watch for the root path
    if (!allowRootSymlink ||
-       (fileInfo.absolutePath() != rootPath.absolutePath()))
+       (fileInfo.absolutePath() != pContext->rootPath.absolutePath()))
    {
       mask |= IN_DONT_FOLLOW;
    }
 
    // initialize watch
-   int wd = ::inotify_add_watch(fd, fileInfo.absolutePath().c_str(), mask);
+   int wd = ::inotify_add_watch(pContext->fd,
+                                fileInfo.absolutePath().c_str(),
+                                mask);
    if (wd < 0)
    {
+      // if we've hit the inotify watch limit then fall back to
+      // periodically rescanning this subtree rather than failing
+      // the entire monitor
+      if (errno == ENOSPC)
+      {
+         pContext->unwatchedDirs.add(fileInfo.absolutePath());
+         return Success();
+      }
+
       Error error = systemError(errno, ERROR_LOCATION);
       error.addProperty("path", fileInfo.absolutePath());
       return error;
    }
 
-   // record it
-   pWatches->insert(Watch(wd, fileInfo.absolutePath()));
+   // record it (the directory may have previously been unwatched if
+   // watch capacity has been freed up since we last tried)
+   pContext->watches.insert(Watch(wd, fileInfo.absolutePath()));
+   pContext->unwatchedDirs.remove(fileInfo.absolutePath());
 
    // return success
    return Success();
@@ -241,10 +340,8 @@ boost::function<Error(const FileInfo&)> addWatchFunction(
 {
    return boost::bind(addWatch,
                         _1,
-                        pContext->rootPath,
                         allowRootSymlink,
-                        pContext->fd,
-                        &pContext->watches);
+                        pContext);
 }
 
 void removeWatch(int fd, const Watch& watch)
@@ -268,6 +365,7 @@ void removeAllWatches(FileEventContext* pContext)
                                           pContext->fd,
                                           _1));
    pContext->watches.clear();
+   pContext->unwatchedDirs.clear();
 }
 
 void closeContext(FileEventContext* pContext)
@@ -286,6 +384,180 @@ void closeContext(FileEventContext* pContext)
    }
 }
 
+// quiescence window for event delivery. once changes begin arriving they
+// are buffered until no new changes have been observed for this interval
+// (so that e.g. a build which touches thousands of files produces a few
+// large batches of events rather than thousands of tiny ones). can be
+// tuned via the RSTUDIO_FILE_MONITOR_QUIESCENCE_MS environment variable
+// (0 disables buffering entirely)
+const int kDefaultQuiescenceMillis = 250;
+
+// never hold buffered events longer than this during sustained activity
+const int kMaxQuiescentDelayMillis = 1000;
+
+// interval between rescans of unwatched directories and the maximum
+// number of directories to rescan per interval
+const int kUnwatchedRescanIntervalMillis = 2000;
+const std::size_t kUnwatchedRescansPerInterval = 20;
+
+boost::posix_time::time_duration quiescenceWindow()
+{
+   static int millis = -1;
+   if (millis < 0)
+   {
+      millis = safe_convert::stringTo<int>(
+                  core::system::getenv("RSTUDIO_FILE_MONITOR_QUIESCENCE_MS"),
+                  kDefaultQuiescenceMillis);
+      if (millis < 0)
+         millis = kDefaultQuiescenceMillis;
+   }
+   return boost::posix_time::milliseconds(millis);
+}
+
+// coalesce buffered events so that at most one event per path survives
+// wherever that preserves meaning: runs of modifications collapse into
+// one, a modification of a just-added file folds into the add, and an
+// add followed by a remove cancels out entirely. a remove followed by
+// an add is preserved as two events (the file was replaced)
+void coalesceFileChanges(std::vector<FileChangeEvent>* pFileChanges)
+{
+   std::vector<FileChangeEvent> coalesced;
+   coalesced.reserve(pFileChanges->size());
+   std::map<std::string, std::size_t> lastIndex;
+   BOOST_FOREACH(const FileChangeEvent& event, *pFileChanges)
+   {
+      const std::string& path = event.fileInfo().absolutePath();
+      std::map<std::string, std::size_t>::iterator it = lastIndex.find(path);
+      if (it == lastIndex.end())
+      {
+         coalesced.push_back(event);
+         lastIndex[path] = coalesced.size() - 1;
+         continue;
+      }
+
+      FileChangeEvent& previous = coalesced[it->second];
+      switch (event.type())
+      {
+         case FileChangeEvent::FileModified:
+            if (previous.type() == FileChangeEvent::FileRemoved)
+            {
+               // shouldn't occur (a recreated file produces an add first)
+               // but if it does then preserve both events
+               coalesced.push_back(event);
+               it->second = coalesced.size() - 1;
+            }
+            else if (previous.type() == FileChangeEvent::FileAdded)
+            {
+               // keep the add but refresh the file attributes
+               previous = FileChangeEvent(FileChangeEvent::FileAdded,
+                                          event.fileInfo());
+            }
+            else
+            {
+               previous = event;
+            }
+            break;
+         case FileChangeEvent::FileAdded:
+            if (previous.type() == FileChangeEvent::FileRemoved)
+            {
+               // the file was replaced -- preserve both events
+               coalesced.push_back(event);
+               it->second = coalesced.size() - 1;
+            }
+            else
+            {
+               previous = event;
+            }
+            break;
+         case FileChangeEvent::FileRemoved:
+            if (previous.type() == FileChangeEvent::FileAdded)
+            {
+               // added then removed within the window -- a net no-op
+               previous = FileChangeEvent(FileChangeEvent::None,
+                                          event.fileInfo());
+            }
+            else
+            {
+               previous = event;
+            }
+            break;
+         case FileChangeEvent::None:
+            break;
+      }
+   }
+
+   // copy back, dropping events which cancelled out
+   pFileChanges->clear();
+   BOOST_FOREACH(const FileChangeEvent& event, coalesced)
+   {
+      if (event.type() != FileChangeEvent::None)
+         pFileChanges->push_back(event);
+   }
+}
+
+void firePendingChanges(FileEventContext* pContext)
+{
+   std::vector<FileChangeEvent> fileChanges;
+   fileChanges.swap(pContext->pendingChanges);
+   coalesceFileChanges(&fileChanges);
+   if (!fileChanges.empty())
+      pContext->callbacks.onFilesChanged(fileChanges);
+}
+
+void accumulateFileChanges(const std::vector<FileChangeEvent>& events,
+                           std::vector<FileChangeEvent>* pFileChanges)
+{
+   std::copy(events.begin(), events.end(), std::back_inserter(*pFileChanges));
+}
+
+// rescan a batch of unwatched directories, accumulating any changes
+// discovered. the rescan passes addWatchFunction as the onBeforeScanDir
+// hook so that if watch capacity has been freed up in the meantime the
+// directory is promoted back to inotify-based monitoring
+void rescanUnwatchedDirs(FileEventContext* pContext,
+                         std::vector<FileChangeEvent>* pFileChanges)
+{
+   std::vector<std::string> dirs = pContext->unwatchedDirs.next(
+                                             kUnwatchedRescansPerInterval);
+   BOOST_FOREACH(const std::string& dir, dirs)
+   {
+      // the directory may have been removed since it was queued (if so
+      // its removal was detected via its parent's watch and it has
+      // already been purged from the file tree)
+      if (!FilePath(dir).exists())
+         continue;
+
+      std::size_t previousChanges = pFileChanges->size();
+      Error error = impl::discoverAndProcessFileChanges(
+                              FileInfo(dir, true),
+                              pContext->recursive,
+                              pContext->filter,
+                              addWatchFunction(pContext),
+                              &pContext->fileTree,
+                              boost::bind(accumulateFileChanges,
+                                          _1,
+                                          pFileChanges));
+      if (error)
+      {
+         // log and re-queue (the error may be transient)
+         LOG_ERROR(error);
+         pContext->unwatchedDirs.toBack(dir);
+         continue;
+      }
+
+      // if the directory is now watched then rescans are no longer required
+      if (!pContext->watches.find(dir).empty())
+         continue;
+
+      // re-queue: directories which just changed go to the front so that
+      // active subtrees are polled ahead of cold ones
+      if (pFileChanges->size() > previousChanges)
+         pContext->unwatchedDirs.toFront(dir);
+      else
+         pContext->unwatchedDirs.toBack(dir);
+   }
+}
+
 Error processEvent(FileEventContext* pContext,
                    struct inotify_event* pEvent,
                    std::vector<FileChangeEvent>* pFileChanges)
@@ -370,6 +642,11 @@ Error processEvent(FileEventContext* pContext,
                      removeWatch(pContext->fd, watch);
                      pContext->watches.erase(watch);
                   }
+
+                  // also purge it from the unwatched list (no-op if it
+                  // wasn't subject to the watch-budget fallback)
+                  pContext->unwatchedDirs.remove(
+                                             event.fileInfo().absolutePath());
                }
             }
 
@@ -492,6 +769,18 @@ Handle registerMonitor(const core::FilePath& filePath,
        return Handle();
    }
 
+   // if the inotify watch limit was reached during the scan then some
+   // subtrees can't be monitored via events -- warn that we are falling
+   // back to periodically rescanning them
+   if (!pContext->unwatchedDirs.empty())
+   {
+      LOG_WARNING_MESSAGE("inotify watch limit reached while monitoring " +
+            filePath.absolutePath() + " (" +
+            safe_convert::numberToString(pContext->unwatchedDirs.size()) +
+            " directories will be polled for changes; consider increasing "
+            "fs.inotify.max_user_watches)");
+   }
+
    // now that we have finished the file listing we know we have a valid
    // file-monitor so set the callbacks
    pContext->callbacks = callbacks;
@@ -589,6 +878,11 @@ void run(const boost::function<void()>& checkForInput)
                // we start over because we missed events
                if (pEvent->mask & IN_Q_OVERFLOW)
                {
+                  // flush any buffered changes first (they have already
+                  // been applied to the file tree, so the scan below
+                  // won't re-discover them)
+                  firePendingChanges(pContext);
+
                   // remove all watches
                   removeAllWatches(pContext);
 
@@ -622,9 +916,51 @@ void run(const boost::function<void()>& checkForInput)
             }
          }
 
-         // fire any events we got
+         // watch-budget fallback: if the watch limit prevented some
+         // directories from being watched then periodically rescan them
+         // (the changes are merged into the same buffer as the inotify
+         // events so they flow through the quiescence logic below)
+         boost::posix_time::ptime now =
+                        boost::posix_time::microsec_clock::universal_time();
+         if (!pContext->unwatchedDirs.empty() &&
+             (pContext->nextUnwatchedRescanTime.is_not_a_date_time() ||
+              now >= pContext->nextUnwatchedRescanTime))
+         {
+            rescanUnwatchedDirs(pContext, &fileChanges);
+            pContext->nextUnwatchedRescanTime = now +
+               boost::posix_time::milliseconds(kUnwatchedRescanIntervalMillis);
+         }
+
+         // if buffering is disabled then fire any events immediately
+         boost::posix_time::time_duration quiescence = quiescenceWindow();
+         if (quiescence.total_milliseconds() == 0)
+         {
+            if (!fileChanges.empty())
+               pContext->callbacks.onFilesChanged(fileChanges);
+            continue;
+         }
+
+         // buffer the events we got
          if (!fileChanges.empty())
-            pContext->callbacks.onFilesChanged(fileChanges);
+         {
+            if (pContext->pendingChanges.empty())
+               pContext->firstPendingTime = now;
+            std::copy(fileChanges.begin(),
+                      fileChanges.end(),
+                      std::back_inserter(pContext->pendingChanges));
+            pContext->lastPendingTime = now;
+         }
+
+         // deliver buffered events once no new events have arrived for the
+         // quiescence window (but never hold events longer than the
+         // maximum delay during sustained activity)
+         if (!pContext->pendingChanges.empty() &&
+             ((now - pContext->lastPendingTime) >= quiescence ||
+              (now - pContext->firstPendingTime) >=
+               boost::posix_time::milliseconds(kMaxQuiescentDelayMillis)))
+         {
+            firePendingChanges(pContext);
+         }
       }
 
       // check for input (register/unregister of monitors)
@@ -0,0 +1,531 @@
+/*
+ * DelimitedReader.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/text/DelimitedReader.hpp>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include <core/Error.hpp>
+#include <core/Exec.hpp>
+#include <core/FilePath.hpp>
+#include <core/SafeConvert.hpp>
+#include <core/system/MemoryMappedFile.hpp>
+
+// don't bother splitting small files across threads -- the thread and
+// merge overhead outweighs the parallelism
+#define kMinBytesPerRange   (4 * 1024 * 1024)
+
+// rows sampled for type inference when no column types are supplied
+#define kInferenceSampleRows 500
+
+namespace rstudio {
+namespace core {
+namespace text {
+
+bool parseDelimitedRecord(const char* pData,
+                          std::size_t size,
+                          std::size_t* pPos,
+                          char delimiter,
+                          std::vector<std::string>* pFields)
+{
+   if (*pPos >= size)
+      return false;
+
+   pFields->clear();
+   std::string field;
+   bool inQuote = false;
+   std::size_t i = *pPos;
+   for (; i < size; i++)
+   {
+      char c = pData[i];
+      if (inQuote)
+      {
+         if (c == '"')
+         {
+            // doubled quote is an escaped quote
+            if (i + 1 < size && pData[i + 1] == '"')
+            {
+               field.push_back('"');
+               i++;
+            }
+            else
+               inQuote = false;
+         }
+         else
+            field.push_back(c);
+      }
+      else if (c == '"' && field.empty())
+         inQuote = true;
+      else if (c == delimiter)
+      {
+         pFields->push_back(field);
+         field.clear();
+      }
+      else if (c == '\n')
+      {
+         i++;
+         break;
+      }
+      else if (c != '\r')
+         field.push_back(c);
+   }
+   pFields->push_back(field);
+   *pPos = i;
+   return true;
+}
+
+namespace {
+
+bool isBlankRecord(const std::vector<std::string>& fields)
+{
+   return fields.size() == 1 && fields[0].empty();
+}
+
+bool isMissingValue(const std::string& value)
+{
+   return value.empty() || value == "NA";
+}
+
+int parseLogical(const std::string& value, bool* pOk)
+{
+   *pOk = true;
+   if (value == "TRUE" || value == "T" || value == "true")
+      return 1;
+   if (value == "FALSE" || value == "F" || value == "false")
+      return 0;
+   *pOk = false;
+   return kDelimitedNAInteger;
+}
+
+int parseInteger(const std::string& value, bool* pOk)
+{
+   const char* pBegin = value.c_str();
+   char* pEnd = NULL;
+   errno = 0;
+   long parsed = ::strtol(pBegin, &pEnd, 10);
+   *pOk = errno == 0 &&
+          pEnd == pBegin + value.size() &&
+          !value.empty() &&
+          parsed > kDelimitedNAInteger &&
+          parsed <= std::numeric_limits<int>::max();
+   return *pOk ? static_cast<int>(parsed) : kDelimitedNAInteger;
+}
+
+double parseDouble(const std::string& value, bool* pOk)
+{
+   const char* pBegin = value.c_str();
+   char* pEnd = NULL;
+   errno = 0;
+   double parsed = ::strtod(pBegin, &pEnd);
+   *pOk = errno == 0 && !value.empty() && pEnd == pBegin + value.size();
+   return *pOk ? parsed : std::numeric_limits<double>::quiet_NaN();
+}
+
+// append one value to a typed column; unparseable values are stored as
+// missing and counted so callers can detect a badly typed column
+void appendValue(const std::string& value, DelimitedColumn* pColumn)
+{
+   bool ok = true;
+   bool missing = isMissingValue(value);
+   switch (pColumn->type)
+   {
+      case DelimitedColumnLogical:
+         pColumn->intData.push_back(
+                  missing ? kDelimitedNAInteger : parseLogical(value, &ok));
+         break;
+      case DelimitedColumnInteger:
+         pColumn->intData.push_back(
+                  missing ? kDelimitedNAInteger : parseInteger(value, &ok));
+         break;
+      case DelimitedColumnDouble:
+         pColumn->doubleData.push_back(
+                  missing ? std::numeric_limits<double>::quiet_NaN()
+                          : parseDouble(value, &ok));
+         break;
+      case DelimitedColumnCharacter:
+      default:
+         pColumn->textData.push_back(value);
+         break;
+   }
+   if (!ok && !missing)
+      pColumn->parseFailures++;
+}
+
+void appendMissing(DelimitedColumn* pColumn)
+{
+   appendValue(std::string(), pColumn);
+}
+
+// a contiguous byte range of the mapped file assigned to one worker
+struct Range
+{
+   Range() : begin(0), end(0), quotes(0), startsInQuote(false) {}
+   std::size_t begin;
+   std::size_t end;
+   std::size_t quotes;
+   bool startsInQuote;
+};
+
+// phase 1: count the quote characters in a raw range. memchr is used so
+// the scan runs at (libc-vectorized) memory bandwidth; the per-range
+// counts establish, by parity, whether each range begins inside a
+// quoted field
+Error scanRangeQuotes(const char* pData, Range* pRange)
+{
+   const char* p = pData + pRange->begin;
+   const char* pEnd = pData + pRange->end;
+   while ((p = static_cast<const char*>(
+                  ::memchr(p, '"', pEnd - p))) != NULL)
+   {
+      pRange->quotes++;
+      ++p;
+   }
+   return Success();
+}
+
+// find the offset of the first record starting at or after 'from' given
+// whether 'from' lies inside a quoted field
+std::size_t alignToRecordStart(const char* pData,
+                               std::size_t size,
+                               std::size_t from,
+                               bool startsInQuote)
+{
+   bool inQuote = startsInQuote;
+   for (std::size_t i = from; i < size; i++)
+   {
+      char c = pData[i];
+      if (c == '"')
+         inQuote = !inQuote;
+      else if (c == '\n' && !inQuote)
+         return i + 1;
+   }
+   return size;
+}
+
+// phase 2: parse every record within an aligned range into the typed
+// columns of *pResult (whose types have already been assigned)
+Error parseRange(const char* pData,
+                 std::size_t begin,
+                 std::size_t end,
+                 char delimiter,
+                 std::vector<DelimitedColumn>* pResult,
+                 std::size_t* pNumRows)
+{
+   std::size_t numColumns = pResult->size();
+   std::size_t pos = begin;
+   std::vector<std::string> fields;
+   while (pos < end && parseDelimitedRecord(pData, end, &pos, delimiter, &fields))
+   {
+      if (isBlankRecord(fields))
+         continue;
+
+      // rows with too few fields are padded with missing values; extra
+      // fields are dropped
+      for (std::size_t i = 0; i < numColumns; i++)
+      {
+         if (i < fields.size())
+            appendValue(fields[i], &(*pResult)[i]);
+         else
+            appendMissing(&(*pResult)[i]);
+      }
+      (*pNumRows)++;
+   }
+   return Success();
+}
+
+DelimitedColumnType classifyValue(const std::string& value)
+{
+   bool ok = false;
+   parseLogical(value, &ok);
+   if (ok)
+      return DelimitedColumnLogical;
+   parseInteger(value, &ok);
+   if (ok)
+      return DelimitedColumnInteger;
+   parseDouble(value, &ok);
+   if (ok)
+      return DelimitedColumnDouble;
+   return DelimitedColumnCharacter;
+}
+
+DelimitedColumnType widenType(DelimitedColumnType a, DelimitedColumnType b)
+{
+   if (a == b)
+      return a;
+
+   // integers widen to doubles; any other disagreement is character
+   if ((a == DelimitedColumnInteger && b == DelimitedColumnDouble) ||
+       (a == DelimitedColumnDouble && b == DelimitedColumnInteger))
+      return DelimitedColumnDouble;
+
+   return DelimitedColumnCharacter;
+}
+
+// infer column types from the first rows plus rows sampled evenly
+// through the rest of the file
+void inferColumnTypes(const char* pData,
+                      std::size_t size,
+                      std::size_t dataStart,
+                      char delimiter,
+                      std::size_t numColumns,
+                      std::vector<DelimitedColumnType>* pTypes)
+{
+   // track whether each column has been observed at all; columns with
+   // only missing values default to character
+   std::vector<bool> observed(numColumns, false);
+   pTypes->assign(numColumns, DelimitedColumnCharacter);
+
+   std::vector<std::string> fields;
+   std::size_t pos = dataStart;
+   int sampled = 0;
+   while (sampled < kInferenceSampleRows &&
+          parseDelimitedRecord(pData, size, &pos, delimiter, &fields))
+   {
+      if (isBlankRecord(fields))
+         continue;
+      sampled++;
+
+      std::size_t n = std::min(fields.size(), numColumns);
+      for (std::size_t i = 0; i < n; i++)
+      {
+         if (isMissingValue(fields[i]))
+            continue;
+         DelimitedColumnType type = classifyValue(fields[i]);
+         if (!observed[i])
+         {
+            (*pTypes)[i] = type;
+            observed[i] = true;
+         }
+         else
+         {
+            (*pTypes)[i] = widenType((*pTypes)[i], type);
+         }
+      }
+   }
+
+   // sample the remainder of the file with a fixed stride. a sampled
+   // offset can land inside a quoted field; records parsed there come
+   // out with the wrong field count and are simply ignored
+   if (pos >= size)
+      return;
+   std::size_t stride = (size - pos) / (kInferenceSampleRows + 1);
+   if (stride == 0)
+      return;
+   for (int i = 1; i <= kInferenceSampleRows; i++)
+   {
+      std::size_t samplePos = pos + (stride * i);
+      if (samplePos >= size)
+         break;
+      while (samplePos < size && pData[samplePos] != '\n')
+         samplePos++;
+      samplePos++;
+
+      if (!parseDelimitedRecord(pData, size, &samplePos, delimiter, &fields))
+         continue;
+      if (fields.size() != numColumns)
+         continue;
+
+      for (std::size_t j = 0; j < numColumns; j++)
+      {
+         if (isMissingValue(fields[j]))
+            continue;
+         DelimitedColumnType type = classifyValue(fields[j]);
+         if (!observed[j])
+         {
+            (*pTypes)[j] = type;
+            observed[j] = true;
+         }
+         else
+         {
+            (*pTypes)[j] = widenType((*pTypes)[j], type);
+         }
+      }
+   }
+}
+
+// append a range's parsed column data onto the merged column
+void appendColumnData(DelimitedColumn* pTarget, DelimitedColumn* pSource)
+{
+   pTarget->intData.insert(pTarget->intData.end(),
+                           pSource->intData.begin(),
+                           pSource->intData.end());
+   pTarget->doubleData.insert(pTarget->doubleData.end(),
+                              pSource->doubleData.begin(),
+                              pSource->doubleData.end());
+   pTarget->textData.insert(pTarget->textData.end(),
+                            pSource->textData.begin(),
+                            pSource->textData.end());
+   pTarget->parseFailures += pSource->parseFailures;
+
+   // release the source storage eagerly so peak memory stays near one
+   // copy of the data
+   std::vector<int>().swap(pSource->intData);
+   std::vector<double>().swap(pSource->doubleData);
+   std::vector<std::string>().swap(pSource->textData);
+}
+
+} // anonymous namespace
+
+
+Error readDelimitedFile(const FilePath& filePath,
+                        const DelimitedReadOptions& options,
+                        std::vector<DelimitedColumn>* pColumns,
+                        std::size_t* pNumRows)
+{
+   pColumns->clear();
+   *pNumRows = 0;
+
+   system::MemoryMappedFile mappedFile;
+   Error error = mappedFile.open(filePath);
+   if (error)
+      return error;
+
+   const char* pData = static_cast<const char*>(mappedFile.data());
+   std::size_t size = mappedFile.size();
+
+   // skip a UTF-8 byte order mark if present
+   if (size >= 3 && ::memcmp(pData, "\xEF\xBB\xBF", 3) == 0)
+   {
+      pData += 3;
+      size -= 3;
+   }
+
+   if (size == 0)
+      return Success();
+
+   // read the first record to establish the column count (and names)
+   std::size_t pos = 0;
+   std::vector<std::string> firstRecord;
+   while (parseDelimitedRecord(pData, size, &pos, options.delimiter, &firstRecord) &&
+          isBlankRecord(firstRecord))
+   {
+   }
+   if (firstRecord.empty() || isBlankRecord(firstRecord))
+      return Success();
+
+   std::size_t numColumns = firstRecord.size();
+   std::size_t dataStart = options.header ? pos : 0;
+
+   // resolve the column types
+   std::vector<DelimitedColumnType> types = options.columnTypes;
+   if (!types.empty() && types.size() != numColumns)
+   {
+      return systemError(boost::system::errc::invalid_argument,
+                         "column type count does not match column count",
+                         ERROR_LOCATION);
+   }
+   if (types.empty())
+      inferColumnTypes(pData, size, dataStart, options.delimiter, numColumns,
+                       &types);
+
+   // divide the data into ranges, one per worker
+   int numThreads = std::max(1, options.numThreads);
+   std::size_t dataSize = size - dataStart;
+   std::size_t numRanges = std::max<std::size_t>(
+            1, std::min<std::size_t>(numThreads,
+                                     dataSize / kMinBytesPerRange));
+
+   std::vector<Range> ranges(numRanges);
+   std::size_t rangeBytes = dataSize / numRanges;
+   for (std::size_t i = 0; i < numRanges; i++)
+   {
+      ranges[i].begin = dataStart + (i * rangeBytes);
+      ranges[i].end = (i == numRanges - 1) ? size
+                                           : dataStart + ((i + 1) * rangeBytes);
+   }
+
+   if (numRanges > 1)
+   {
+      // phase 1: count quotes per raw range in parallel, then use the
+      // running parity to learn whether each range begins inside a
+      // quoted field
+      ParallelExecBlock scanBlock(numThreads);
+      for (std::size_t i = 0; i < numRanges; i++)
+      {
+         scanBlock.addConcurrent(
+                  "scan range " + safe_convert::numberToString(i),
+                  boost::bind(scanRangeQuotes, pData, &ranges[i]));
+      }
+      error = scanBlock.execute();
+      if (error)
+         return error;
+
+      std::size_t quotes = 0;
+      for (std::size_t i = 0; i < numRanges; i++)
+      {
+         ranges[i].startsInQuote = (quotes % 2) != 0;
+         quotes += ranges[i].quotes;
+      }
+
+      // align each range to the start of a record; a range's end is the
+      // next range's (aligned) start
+      for (std::size_t i = 1; i < numRanges; i++)
+      {
+         ranges[i].begin = alignToRecordStart(pData, size, ranges[i].begin,
+                                              ranges[i].startsInQuote);
+         ranges[i - 1].end = ranges[i].begin;
+      }
+   }
+
+   // phase 2: parse each range into its own typed columns in parallel
+   std::vector<std::vector<DelimitedColumn> > rangeColumns(numRanges);
+   std::vector<std::size_t> rangeRows(numRanges, 0);
+   for (std::size_t i = 0; i < numRanges; i++)
+   {
+      rangeColumns[i].resize(numColumns);
+      for (std::size_t j = 0; j < numColumns; j++)
+         rangeColumns[i][j].type = types[j];
+   }
+
+   ParallelExecBlock parseBlock(numThreads);
+   for (std::size_t i = 0; i < numRanges; i++)
+   {
+      parseBlock.addConcurrent(
+               "parse range " + safe_convert::numberToString(i),
+               boost::bind(parseRange, pData, ranges[i].begin, ranges[i].end,
+                           options.delimiter, &rangeColumns[i],
+                           &rangeRows[i]));
+   }
+   error = parseBlock.execute();
+   if (error)
+      return error;
+
+   // merge the per-range columns in order
+   pColumns->resize(numColumns);
+   for (std::size_t j = 0; j < numColumns; j++)
+   {
+      DelimitedColumn& column = (*pColumns)[j];
+      column.name = options.header
+               ? firstRecord[j]
+               : "V" + safe_convert::numberToString(j + 1);
+      column.type = types[j];
+      for (std::size_t i = 0; i < numRanges; i++)
+         appendColumnData(&column, &rangeColumns[i][j]);
+   }
+   for (std::size_t i = 0; i < numRanges; i++)
+      *pNumRows += rangeRows[i];
+
+   return Success();
+}
+
+} // namespace text
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,238 @@
+/*
+ * DelimitedReaderTests.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/text/DelimitedReader.hpp>
+
+#include <core/Error.hpp>
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/system/System.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace tests {
+
+namespace {
+
+FilePath writeTempFile(const std::string& contents)
+{
+   FilePath tempFile;
+   Error error = FilePath::tempFilePath(&tempFile);
+   CHECK(!error);
+   error = writeStringToFile(tempFile, contents);
+   CHECK(!error);
+   return tempFile;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Delimited record parsing")
+{
+   SECTION("Simple fields")
+   {
+      std::string input = "a,b,c\n";
+      std::size_t pos = 0;
+      std::vector<std::string> fields;
+      CHECK(text::parseDelimitedRecord(input.data(), input.size(), &pos, ',',
+                                       &fields));
+      CHECK(fields.size() == 3);
+      CHECK(fields[0] == "a");
+      CHECK(fields[2] == "c");
+      CHECK(pos == input.size());
+   }
+
+   SECTION("Quoted fields may contain delimiters and newlines")
+   {
+      std::string input = "\"a,b\",\"c\nd\",e\nnext\n";
+      std::size_t pos = 0;
+      std::vector<std::string> fields;
+      CHECK(text::parseDelimitedRecord(input.data(), input.size(), &pos, ',',
+                                       &fields));
+      CHECK(fields.size() == 3);
+      CHECK(fields[0] == "a,b");
+      CHECK(fields[1] == "c\nd");
+      CHECK(fields[2] == "e");
+
+      CHECK(text::parseDelimitedRecord(input.data(), input.size(), &pos, ',',
+                                       &fields));
+      CHECK(fields.size() == 1);
+      CHECK(fields[0] == "next");
+   }
+
+   SECTION("Doubled quotes are unescaped")
+   {
+      std::string input = "\"say \"\"hi\"\"\",x\n";
+      std::size_t pos = 0;
+      std::vector<std::string> fields;
+      CHECK(text::parseDelimitedRecord(input.data(), input.size(), &pos, ',',
+                                       &fields));
+      CHECK(fields.size() == 2);
+      CHECK(fields[0] == "say \"hi\"");
+   }
+
+   SECTION("Carriage returns are stripped")
+   {
+      std::string input = "a,b\r\nc,d\r\n";
+      std::size_t pos = 0;
+      std::vector<std::string> fields;
+      CHECK(text::parseDelimitedRecord(input.data(), input.size(), &pos, ',',
+                                       &fields));
+      CHECK(fields[1] == "b");
+   }
+
+   SECTION("End of input")
+   {
+      std::string input = "";
+      std::size_t pos = 0;
+      std::vector<std::string> fields;
+      CHECK_FALSE(text::parseDelimitedRecord(input.data(), input.size(), &pos,
+                                             ',', &fields));
+   }
+}
+
+TEST_CASE("Delimited file reading")
+{
+   SECTION("Types are inferred and values parsed")
+   {
+      FilePath file = writeTempFile(
+               "id,score,flag,name\n"
+               "1,1.5,TRUE,alice\n"
+               "2,2.25,FALSE,bob\n"
+               "3,NA,TRUE,carol\n");
+
+      text::DelimitedReadOptions options;
+      std::vector<text::DelimitedColumn> columns;
+      std::size_t numRows = 0;
+      Error error = text::readDelimitedFile(file, options, &columns, &numRows);
+      CHECK(!error);
+      CHECK(numRows == 3);
+      CHECK(columns.size() == 4);
+
+      CHECK(columns[0].name == "id");
+      CHECK(columns[0].type == text::DelimitedColumnInteger);
+      CHECK(columns[0].intData.size() == 3);
+      CHECK(columns[0].intData[2] == 3);
+
+      CHECK(columns[1].type == text::DelimitedColumnDouble);
+      CHECK(columns[1].doubleData[1] == 2.25);
+
+      // missing value stored as NaN
+      CHECK(columns[1].doubleData[2] != columns[1].doubleData[2]);
+
+      CHECK(columns[2].type == text::DelimitedColumnLogical);
+      CHECK(columns[2].intData[0] == 1);
+      CHECK(columns[2].intData[1] == 0);
+
+      CHECK(columns[3].type == text::DelimitedColumnCharacter);
+      CHECK(columns[3].textData[2] == "carol");
+
+      file.remove();
+   }
+
+   SECTION("Explicit column types override inference")
+   {
+      FilePath file = writeTempFile("a,b\n1,2\n3,4\n");
+
+      text::DelimitedReadOptions options;
+      options.columnTypes.push_back(text::DelimitedColumnCharacter);
+      options.columnTypes.push_back(text::DelimitedColumnDouble);
+
+      std::vector<text::DelimitedColumn> columns;
+      std::size_t numRows = 0;
+      Error error = text::readDelimitedFile(file, options, &columns, &numRows);
+      CHECK(!error);
+      CHECK(columns[0].type == text::DelimitedColumnCharacter);
+      CHECK(columns[0].textData[0] == "1");
+      CHECK(columns[1].type == text::DelimitedColumnDouble);
+      CHECK(columns[1].doubleData[1] == 4.0);
+
+      file.remove();
+   }
+
+   SECTION("Unparseable values become missing and are counted")
+   {
+      FilePath file = writeTempFile("n\n1\nnot-a-number\n3\n");
+
+      text::DelimitedReadOptions options;
+      options.columnTypes.push_back(text::DelimitedColumnInteger);
+
+      std::vector<text::DelimitedColumn> columns;
+      std::size_t numRows = 0;
+      Error error = text::readDelimitedFile(file, options, &columns, &numRows);
+      CHECK(!error);
+      CHECK(numRows == 3);
+      CHECK(columns[0].intData[1] == kDelimitedNAInteger);
+      CHECK(columns[0].parseFailures == 1);
+
+      file.remove();
+   }
+
+   SECTION("Short rows are padded with missing values")
+   {
+      FilePath file = writeTempFile("a,b\n1,2\n3\n");
+
+      text::DelimitedReadOptions options;
+      std::vector<text::DelimitedColumn> columns;
+      std::size_t numRows = 0;
+      Error error = text::readDelimitedFile(file, options, &columns, &numRows);
+      CHECK(!error);
+      CHECK(numRows == 2);
+      CHECK(columns[1].intData.size() == 2);
+      CHECK(columns[1].intData[1] == kDelimitedNAInteger);
+
+      file.remove();
+   }
+
+   SECTION("Headerless files get generated column names")
+   {
+      FilePath file = writeTempFile("1,2\n3,4\n");
+
+      text::DelimitedReadOptions options;
+      options.header = false;
+
+      std::vector<text::DelimitedColumn> columns;
+      std::size_t numRows = 0;
+      Error error = text::readDelimitedFile(file, options, &columns, &numRows);
+      CHECK(!error);
+      CHECK(numRows == 2);
+      CHECK(columns[0].name == "V1");
+      CHECK(columns[1].name == "V2");
+      CHECK(columns[0].intData[0] == 1);
+
+      file.remove();
+   }
+
+   SECTION("Empty file yields no columns")
+   {
+      FilePath file = writeTempFile("");
+
+      text::DelimitedReadOptions options;
+      std::vector<text::DelimitedColumn> columns;
+      std::size_t numRows = 0;
+      Error error = text::readDelimitedFile(file, options, &columns, &numRows);
+      CHECK(!error);
+      CHECK(columns.empty());
+      CHECK(numRows == 0);
+
+      file.remove();
+   }
+}
+
+} // namespace tests
+} // namespace core
+} // namespace rstudio
@@ -1293,6 +1293,16 @@ void GwtCallback::setClipboardMonitoring(bool monitoring)
    options().setClipboardMonitoring(monitoring);
 }
 
+bool GwtCallback::getDetachSession()
+{
+   return options().detachSession();
+}
+
+void GwtCallback::setDetachSession(bool detach)
+{
+   options().setDetachSession(detach);
+}
+
 void GwtCallback::showLicenseDialog()
 {
    activation().showLicenseDialog(false /*showQuitButton*/);
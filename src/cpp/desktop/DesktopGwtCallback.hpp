@@ -200,6 +200,9 @@ public Q_SLOTS:
    bool getClipboardMonitoring();
    void setClipboardMonitoring(bool monitoring);
 
+   bool getDetachSession();
+   void setDetachSession(bool detach);
+
    void showLicenseDialog();
    QString getInitMessages();
    QString getLicenseStatusMessage();
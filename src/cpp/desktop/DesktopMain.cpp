@@ -98,9 +98,22 @@ Error removeStaleOptionsLockfile()
 
 void initializeSharedSecret()
 {
-   sharedSecret = QString::number(rand())
-                  + QString::number(rand())
-                  + QString::number(rand());
+   // in detach mode re-use the secret from the previous run so that we
+   // can authenticate with an rsession left running by a previous
+   // instance of the frontend
+   if (desktop::options().detachSession())
+      sharedSecret = desktop::options().lastSessionSecret();
+
+   if (sharedSecret.isEmpty())
+   {
+      sharedSecret = QString::number(rand())
+                     + QString::number(rand())
+                     + QString::number(rand());
+
+      if (desktop::options().detachSession())
+         desktop::options().setLastSessionSecret(sharedSecret);
+   }
+
    std::string value = sharedSecret.toUtf8().constData();
    core::system::setenv("RS_SHARED_SECRET", value);
 }
@@ -230,6 +230,15 @@ void MainWindow::closeEvent(QCloseEvent* pEvent)
       return;
    }
 
+   // in detach mode leave the session running; the next instance of the
+   // frontend will reattach to it (the session applies its disconnected
+   // timeout as the grace period, suspending if we never come back)
+   if (desktop::options().detachSession())
+   {
+      pEvent->accept();
+      return;
+   }
+
    pEvent->ignore();
    webPage()->runJavaScript(
             QStringLiteral("!!window.desktopHooks"),
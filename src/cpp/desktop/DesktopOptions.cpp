@@ -244,6 +244,37 @@ void Options::setClipboardMonitoring(bool monitoring)
    settings_.setValue(QString::fromUtf8("clipboard.monitoring"), monitoring);
 }
 
+bool Options::detachSession() const
+{
+   QVariant detach = settings_.value(QString::fromUtf8("session.detach"), false);
+   return detach.toBool();
+}
+
+void Options::setDetachSession(bool detach)
+{
+   settings_.setValue(QString::fromUtf8("session.detach"), detach);
+}
+
+QString Options::lastSessionPort() const
+{
+   return settings_.value(QString::fromUtf8("session.lastPort")).toString();
+}
+
+void Options::setLastSessionPort(QString port)
+{
+   settings_.setValue(QString::fromUtf8("session.lastPort"), port);
+}
+
+QString Options::lastSessionSecret() const
+{
+   return settings_.value(QString::fromUtf8("session.lastSecret")).toString();
+}
+
+void Options::setLastSessionSecret(QString secret)
+{
+   settings_.setValue(QString::fromUtf8("session.lastSecret"), secret);
+}
+
 #ifdef _WIN32
 QString Options::rBinDir() const
 {
@@ -63,6 +63,17 @@ public:
    bool clipboardMonitoring() const;
    void setClipboardMonitoring(bool monitoring);
 
+   // detach mode: leave the rsession running when the frontend exits
+   // and reattach to it on the next launch
+   bool detachSession() const;
+   void setDetachSession(bool detach);
+
+   QString lastSessionPort() const;
+   void setLastSessionPort(QString port);
+
+   QString lastSessionSecret() const;
+   void setLastSessionSecret(QString secret);
+
 #ifdef _WIN32
    // If "", then use automatic detection
    QString rBinDir() const;
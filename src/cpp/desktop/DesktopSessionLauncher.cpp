@@ -25,7 +25,9 @@
 #include <core/system/ParentProcessMonitor.hpp>
 #include <core/r_util/RUserData.hpp>
 
+#include <QElapsedTimer>
 #include <QPushButton>
+#include <QTcpSocket>
 
 #include "DesktopOptions.hpp"
 #include "DesktopSlotBinders.hpp"
@@ -41,6 +43,10 @@ namespace desktop {
 
 namespace {
 
+// how long (in minutes) a detached session waits for the frontend to
+// reattach before timing out (it suspends, so no work is lost)
+const int kDetachedSessionTimeoutMinutes = 60;
+
 std::string s_launcherToken;
 
 void launchProcess(const std::string& absPath,
@@ -68,6 +74,35 @@ void logEnvVar(const std::string& name)
       RUN_DIAGNOSTICS_LOG("  " + name + "=" + value);
 }
 
+// check (with a short timeout) whether anything is accepting connections
+// on the given port -- used to detect a detached session to reattach to
+bool sessionAlive(const QString& host, quint16 port)
+{
+   QTcpSocket socket;
+   socket.connectToHost(host, port);
+   return socket.waitForConnected(300);
+}
+
+// wait (bounded) for the session to accept connections so the first
+// load from the webengine finds a live socket rather than rendering a
+// connection-refused page; the session starts listening while R
+// initializes so this returns quickly in practice
+void waitForSession(const QString& host, quint16 port)
+{
+   QElapsedTimer timer;
+   timer.start();
+   while (timer.elapsed() < 10000)
+   {
+      QTcpSocket socket;
+      socket.connectToHost(host, port);
+      if (socket.waitForConnected(50))
+         return;
+
+      // keep the ui responsive while we wait
+      QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents, 25);
+   }
+}
+
 } // anonymous namespace
 
 void SessionLauncher::launchFirstSession(const core::FilePath& installPath,
@@ -87,35 +122,65 @@ Error SessionLauncher::launchFirstSession()
    QString host, port;
    QStringList argList;
    QUrl url;
+
+   // in detach mode attempt to reattach to a session left running by a
+   // previous instance of the frontend (it was launched with the same
+   // shared secret, which was restored before we were called)
+   bool reattached = false;
+   if (options().detachSession())
+   {
+      QString lastPort = options().lastSessionPort();
+      if (!lastPort.isEmpty() &&
+          sessionAlive(QString::fromUtf8("127.0.0.1"), lastPort.toUShort()))
+      {
+         port = lastPort;
+         reattached = true;
+      }
+   }
+
    buildLaunchContext(&host, &port, &argList, &url);
 
-   // show help home on first run
-   argList.push_back(QString::fromUtf8("--show-help-home"));
-   argList.push_back(QString::fromUtf8("1"));
-
-   RUN_DIAGNOSTICS_LOG("\nAttempting to launch R session...");
-   logEnvVar("RSTUDIO_WHICH_R");
-   logEnvVar("R_HOME");
-   logEnvVar("R_DOC_DIR");
-   logEnvVar("R_INCLUDE_DIR");
-   logEnvVar("R_SHARE_DIR");
-   logEnvVar("R_LIBS");
-   logEnvVar("R_LIBS_USER");
-   logEnvVar("DYLD_LIBRARY_PATH");
-   logEnvVar("LD_LIBRARY_PATH");
-   logEnvVar("PATH");
-   logEnvVar("HOME");
-   logEnvVar("R_USER");
+   // remember the port so the next instance of the frontend can find
+   // the session if we detach
+   if (options().detachSession())
+      options().setLastSessionPort(port);
 
-   // launch the process
-   Error error = launchSession(argList, &pRSessionProcess_);
-   if (error)
-     return error;
+   if (reattached)
+   {
+      RUN_DIAGNOSTICS_LOG("\nReattaching to R session on port "
+                              + port.toStdString() +
+                              "...");
+   }
+   else
+   {
+      // show help home on first run
+      argList.push_back(QString::fromUtf8("--show-help-home"));
+      argList.push_back(QString::fromUtf8("1"));
+
+      RUN_DIAGNOSTICS_LOG("\nAttempting to launch R session...");
+      logEnvVar("RSTUDIO_WHICH_R");
+      logEnvVar("R_HOME");
+      logEnvVar("R_DOC_DIR");
+      logEnvVar("R_INCLUDE_DIR");
+      logEnvVar("R_SHARE_DIR");
+      logEnvVar("R_LIBS");
+      logEnvVar("R_LIBS_USER");
+      logEnvVar("DYLD_LIBRARY_PATH");
+      logEnvVar("LD_LIBRARY_PATH");
+      logEnvVar("PATH");
+      logEnvVar("HOME");
+      logEnvVar("R_USER");
+
+      // launch the process
+      Error error = launchSession(argList, &pRSessionProcess_);
+      if (error)
+        return error;
 
-   RUN_DIAGNOSTICS_LOG("\nR session launched, "
-                           "attempting to connect on port "
-                           + port.toStdString() +
-                           "...");
+      RUN_DIAGNOSTICS_LOG("\nR session launched, "
+                              "attempting to connect on port "
+                              + port.toStdString() +
+                              "...");
+   }
 
    pMainWindow_ = new MainWindow(url);
    pMainWindow_->setAttribute(Qt::WA_DeleteOnClose);
@@ -147,9 +212,13 @@ Error SessionLauncher::launchFirstSession()
                          pMainWindow_,
                          SLOT(openFileInRStudio(QString)));
 
-   pMainWindow_->connect(pRSessionProcess_,
-                         SIGNAL(finished(int,QProcess::ExitStatus)),
-                         this, SLOT(onRSessionExited(int,QProcess::ExitStatus)));
+   // no process object when we reattached to a detached session
+   if (pRSessionProcess_)
+   {
+      pMainWindow_->connect(pRSessionProcess_,
+                            SIGNAL(finished(int,QProcess::ExitStatus)),
+                            this, SLOT(onRSessionExited(int,QProcess::ExitStatus)));
+   }
 
    pMainWindow_->connect(&activation(),
                          SIGNAL(licenseLost(QString)),
@@ -166,6 +235,11 @@ Error SessionLauncher::launchFirstSession()
       pMainWindow_->show();
       desktop::activation().setMainWindow(pMainWindow_);
       pAppLaunch_->activateWindow();
+
+      // preconnect before the initial load -- by now the session (which
+      // was launched before the webengine spun up) is typically already
+      // accepting connections
+      waitForSession(host, port.toUShort());
       pMainWindow_->loadUrl(url);
    }
    qApp->setQuitOnLastWindowClosed(true);
@@ -282,6 +356,11 @@ Error SessionLauncher::launchNextSession(bool reload)
    QUrl url;
    buildLaunchContext(&host, &port, &argList, &url);
 
+   // remember the port so the next instance of the frontend can find
+   // the session if we detach
+   if (options().detachSession())
+      options().setLastSessionPort(port);
+
    // launch the process
    Error error = launchSession(argList, &pRSessionProcess_);
    if (error)
@@ -309,6 +388,8 @@ Error SessionLauncher::launchNextSession(bool reload)
 
 void SessionLauncher::onReloadFrameForNextSession()
 {
+   waitForSession(nextSessionUrl_.host(),
+                  static_cast<quint16>(nextSessionUrl_.port()));
    pMainWindow_->loadUrl(nextSessionUrl_);
    nextSessionUrl_.clear();
 }
@@ -438,6 +519,16 @@ void SessionLauncher::buildLaunchContext(QString* pHost,
 
    *pArgList << QString::fromUtf8("--www-port") << *pPort;
 
+   if (desktop::options().detachSession())
+   {
+      // tell the session to outlive us (it suppresses parent termination
+      // detection when this is set) and to apply a disconnected timeout
+      // as the grace period for reattaching
+      core::system::setenv("RS_DETACH_SESSION", "1");
+      *pArgList << QString::fromUtf8("--session-disconnected-timeout-minutes")
+                << QString::number(kDetachedSessionTimeoutMinutes);
+   }
+
    // create launch token if we haven't already
    if (s_launcherToken.empty())
       s_launcherToken = core::system::generateShortenedUuid();
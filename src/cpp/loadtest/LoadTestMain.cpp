@@ -0,0 +1,344 @@
+/*
+ * LoadTestMain.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+// Replayable json-rpc load harness for measuring interactive session
+// latency. Drives a running rsession through its HTTP interface with a
+// recorded workload (console input, completions, file listings, saves)
+// and reports the per-method latency distribution. Point --address and
+// --port either directly at an rsession www port or at an rserver that
+// proxies to one -- the delta between the two runs isolates the proxy
+// overhead.
+//
+// A workload file is a json array of steps:
+//
+//   [
+//     { "method": "console_input", "params": ["1 + 1", ""], "repeat": 20 },
+//     { "method": "list_files", "params": ["~", false], "repeat": 5 }
+//   ]
+//
+// Methods that reference per-session state (document ids for
+// save_document, completion contexts, etc.) should be recorded against
+// a session prepared for the workload. Without --workload a small
+// built-in smoke workload (console input and file listings) is run.
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <core/Error.hpp>
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/Log.hpp>
+#include <core/ProgramOptions.hpp>
+#include <core/ProgramStatus.hpp>
+#include <core/SafeConvert.hpp>
+#include <core/http/Request.hpp>
+#include <core/http/Response.hpp>
+#include <core/http/TcpIpBlockingClient.hpp>
+#include <core/json/Json.hpp>
+#include <core/json/JsonRpc.hpp>
+#include <core/system/System.hpp>
+
+using namespace rstudio;
+using namespace rstudio::core;
+
+namespace {
+
+struct WorkloadStep
+{
+   WorkloadStep() : repeat(1) {}
+
+   std::string method;
+   json::Array params;
+   int repeat;
+};
+
+// per-method latency samples (microseconds) and error count
+struct MethodResults
+{
+   MethodResults() : errors(0) {}
+
+   std::vector<double> latencies;
+   int errors;
+};
+
+std::vector<WorkloadStep> builtinWorkload()
+{
+   std::vector<WorkloadStep> workload;
+
+   WorkloadStep consoleInput;
+   consoleInput.method = "console_input";
+   consoleInput.params.push_back(std::string("invisible(1 + 1)"));
+   consoleInput.params.push_back(std::string(""));
+   consoleInput.repeat = 20;
+   workload.push_back(consoleInput);
+
+   WorkloadStep listFiles;
+   listFiles.method = "list_files";
+   listFiles.params.push_back(std::string("~"));
+   listFiles.params.push_back(false);
+   listFiles.repeat = 5;
+   workload.push_back(listFiles);
+
+   return workload;
+}
+
+Error readWorkloadFile(const FilePath& workloadPath,
+                       std::vector<WorkloadStep>* pWorkload)
+{
+   std::string contents;
+   Error error = readStringFromFile(workloadPath, &contents);
+   if (error)
+      return error;
+
+   json::Value workloadJson;
+   if (!json::parse(contents, &workloadJson) ||
+       !json::isType<json::Array>(workloadJson))
+   {
+      return systemError(boost::system::errc::protocol_error,
+                         "Workload file is not a json array",
+                         ERROR_LOCATION);
+   }
+
+   const json::Array& stepsJson = workloadJson.get_array();
+   for (std::size_t i = 0; i < stepsJson.size(); i++)
+   {
+      if (!json::isType<json::Object>(stepsJson[i]))
+      {
+         return systemError(boost::system::errc::protocol_error,
+                            "Workload step is not a json object",
+                            ERROR_LOCATION);
+      }
+
+      WorkloadStep step;
+      const json::Object& stepJson = stepsJson[i].get_obj();
+      error = json::readObject(stepJson,
+                               "method", &step.method,
+                               "params", &step.params);
+      if (error)
+         return error;
+
+      json::Object::const_iterator it = stepJson.find("repeat");
+      if (it != stepJson.end() && json::isType<int>(it->second))
+         step.repeat = it->second.get_int();
+      if (step.repeat < 1)
+         step.repeat = 1;
+
+      pWorkload->push_back(step);
+   }
+
+   return Success();
+}
+
+// execute a single json-rpc round trip, recording its latency (and
+// whether the rpc failed) into the method's results
+void executeStep(const std::string& address,
+                 const std::string& port,
+                 const std::string& sharedSecret,
+                 const WorkloadStep& step,
+                 MethodResults* pResults)
+{
+   // build the json-rpc request body
+   json::Object bodyJson;
+   bodyJson["method"] = step.method;
+   bodyJson["params"] = step.params;
+   std::string body = json::write(bodyJson);
+
+   http::Request request;
+   request.setMethod("POST");
+   request.setUri("/rpc/" + step.method);
+   request.setHeader("Host", address + ":" + port);
+   request.setHeader("Connection", "close");
+   request.setHeader("Accept", "application/json");
+   request.setContentType("application/json");
+   if (!sharedSecret.empty())
+      request.setHeader("X-Shared-Secret", sharedSecret);
+   request.setBody(body);
+
+   using namespace boost::posix_time;
+   ptime startTime = microsec_clock::universal_time();
+
+   http::Response response;
+   Error error = http::sendRequest(address, port, request, &response);
+
+   double latency = static_cast<double>(
+      (microsec_clock::universal_time() - startTime).total_microseconds());
+   pResults->latencies.push_back(latency);
+
+   // classify failures: transport errors, http errors, and json-rpc
+   // responses bearing an error member
+   if (error || response.statusCode() != http::status::Ok)
+   {
+      pResults->errors++;
+      return;
+   }
+
+   json::Value resultJson;
+   if (json::parse(response.body(), &resultJson) &&
+       json::isType<json::Object>(resultJson))
+   {
+      const json::Object& resultObj = resultJson.get_obj();
+      json::Object::const_iterator it = resultObj.find("error");
+      if (it != resultObj.end() && !it->second.is_null())
+         pResults->errors++;
+   }
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+   if (sorted.empty())
+      return 0;
+   std::size_t index = static_cast<std::size_t>(p * (sorted.size() - 1));
+   return sorted[index];
+}
+
+void reportResults(const std::map<std::string, MethodResults>& results,
+                   double totalSeconds)
+{
+   std::cout << std::endl
+             << std::left << std::setw(28) << "method"
+             << std::right << std::setw(8) << "count"
+             << std::setw(8) << "errors"
+             << std::setw(10) << "mean ms"
+             << std::setw(10) << "p50 ms"
+             << std::setw(10) << "p90 ms"
+             << std::setw(10) << "p99 ms"
+             << std::setw(10) << "max ms" << std::endl;
+
+   int totalRequests = 0;
+   for (std::map<std::string, MethodResults>::const_iterator
+            it = results.begin(); it != results.end(); ++it)
+   {
+      std::vector<double> latencies = it->second.latencies;
+      std::sort(latencies.begin(), latencies.end());
+      totalRequests += static_cast<int>(latencies.size());
+
+      double sum = 0;
+      for (std::size_t i = 0; i < latencies.size(); i++)
+         sum += latencies[i];
+      double mean = latencies.empty() ? 0 : (sum / latencies.size());
+
+      std::cout << std::left << std::setw(28) << it->first
+                << std::right << std::setw(8) << latencies.size()
+                << std::setw(8) << it->second.errors
+                << std::fixed << std::setprecision(2)
+                << std::setw(10) << (mean / 1000)
+                << std::setw(10) << (percentile(latencies, 0.50) / 1000)
+                << std::setw(10) << (percentile(latencies, 0.90) / 1000)
+                << std::setw(10) << (percentile(latencies, 0.99) / 1000)
+                << std::setw(10)
+                << (latencies.empty() ? 0 : latencies.back() / 1000)
+                << std::endl;
+   }
+
+   std::cout << std::endl
+             << totalRequests << " requests in "
+             << std::fixed << std::setprecision(2) << totalSeconds
+             << "s (" << (totalSeconds > 0 ? totalRequests / totalSeconds : 0)
+             << " req/s)" << std::endl;
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char** argv)
+{
+   core::system::initializeStderrLog("rsession-loadtest",
+                                     core::system::kLogLevelWarning);
+
+   // command line options
+   std::string address, port, workloadFile, sharedSecret;
+   int iterations;
+
+   program_options::OptionsDescription optionsDesc("rsession-loadtest");
+   optionsDesc.commandLine.add_options()
+      ("address",
+       boost::program_options::value<std::string>(&address)->default_value(
+                                                            "127.0.0.1"),
+       "address of the rsession or rserver to drive")
+      ("port",
+       boost::program_options::value<std::string>(&port)->default_value(
+                                                            "8787"),
+       "port of the rsession or rserver to drive")
+      ("workload",
+       boost::program_options::value<std::string>(&workloadFile)->
+                                                default_value(""),
+       "json workload file (defaults to a built-in smoke workload)")
+      ("iterations",
+       boost::program_options::value<int>(&iterations)->default_value(10),
+       "number of times to replay the workload")
+      ("shared-secret",
+       boost::program_options::value<std::string>(&sharedSecret)->
+                                                default_value(""),
+       "value for the X-Shared-Secret header (direct rsession connections)");
+
+   ProgramStatus status = program_options::read(optionsDesc, argc, argv);
+   if (status.exit())
+      return status.exitCode();
+
+   // resolve the workload
+   std::vector<WorkloadStep> workload;
+   if (!workloadFile.empty())
+   {
+      Error error = readWorkloadFile(FilePath(workloadFile), &workload);
+      if (error)
+      {
+         LOG_ERROR(error);
+         return EXIT_FAILURE;
+      }
+   }
+   else
+   {
+      workload = builtinWorkload();
+   }
+
+   if (iterations < 1)
+      iterations = 1;
+
+   std::cout << "driving " << address << ":" << port << " with "
+             << workload.size() << " workload step(s) x "
+             << iterations << " iteration(s)" << std::endl;
+
+   // replay the workload
+   using namespace boost::posix_time;
+   ptime runStartTime = microsec_clock::universal_time();
+
+   std::map<std::string, MethodResults> results;
+   for (int i = 0; i < iterations; i++)
+   {
+      for (std::size_t s = 0; s < workload.size(); s++)
+      {
+         const WorkloadStep& step = workload[s];
+         for (int r = 0; r < step.repeat; r++)
+         {
+            executeStep(address, port, sharedSecret, step,
+                        &results[step.method]);
+         }
+      }
+   }
+
+   double totalSeconds =
+      (microsec_clock::universal_time() - runStartTime).total_microseconds() /
+      1e6;
+
+   reportResults(results, totalSeconds);
+
+   return EXIT_SUCCESS;
+}
@@ -318,7 +318,15 @@ RFunction::RFunction(SEXP functionSEXP)
    functionSEXP_ = functionSEXP;
    preserver_.add(functionSEXP_);
 }
-   
+
+RFunction::RFunction(PreparedFunction& preparedFunction)
+{
+   functionSEXP_ = preparedFunction.functionSEXP();
+   functionName_ = preparedFunction.name();
+   if (functionSEXP_ != R_UnboundValue)
+      preserver_.add(functionSEXP_);
+}
+
 RFunction::~RFunction()
 {
 }
@@ -420,6 +428,49 @@ Error RFunction::call(SEXP evalNS, bool safely, SEXP* pResultSEXP,
    return Success();
 }
 
+namespace {
+
+// current prepared call generation -- bumped by invalidatePreparedCalls
+// so that cached function bindings are re-resolved on their next use.
+// instances start at generation 0 so their first use always resolves
+unsigned s_preparedCallGeneration = 1;
+
+} // anonymous namespace
+
+SEXP PreparedFunction::functionSEXP()
+{
+   if (functionSEXP_ == R_UnboundValue ||
+       generation_ != s_preparedCallGeneration)
+   {
+      // check for namespace qualifier
+      std::string name = functionName_, ns;
+      std::string nsQual(":::");
+      size_t pos = functionName_.find(nsQual);
+      if (pos != std::string::npos)
+      {
+         ns = functionName_.substr(0, pos);
+         name = functionName_.substr(pos + nsQual.size());
+      }
+
+      // lookup and preserve the function. note that on a failed lookup we
+      // leave the stale generation in place so resolution is re-attempted
+      // on the next call (the function may simply not be defined yet)
+      functionSEXP_ = sexp::findFunction(name, ns);
+      if (functionSEXP_ != R_UnboundValue)
+      {
+         preserver_.add(functionSEXP_);
+         generation_ = s_preparedCallGeneration;
+      }
+   }
+
+   return functionSEXP_;
+}
+
+void invalidatePreparedCalls()
+{
+   s_preparedCallGeneration++;
+}
+
 FilePath rBinaryPath()
 {
    FilePath binPath = FilePath(R_HomeDir()).complete("bin");
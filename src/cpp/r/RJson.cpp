@@ -46,6 +46,7 @@
  
 */
 
+#include <cstdio>
 #include <iostream>
 
 #define R_INTERNAL_FUNCTIONS
@@ -319,6 +320,326 @@ Error jsonObjectArrayFromDataFrame(SEXP listSEXP, core::json::Value* pValue)
    return Success();
 }
 
+// streaming serializer helpers -- these append JSON text directly to an
+// output buffer (one SEXP walk, no intermediate json::Value tree)
+
+void appendJsonString(const char* value, std::string* pOutput)
+{
+   pOutput->push_back('"');
+   for (const char* pCh = value; *pCh != '\0'; pCh++)
+   {
+      char ch = *pCh;
+      switch(ch)
+      {
+         case '"':  pOutput->append("\\\""); break;
+         case '\\': pOutput->append("\\\\"); break;
+         case '\b': pOutput->append("\\b");  break;
+         case '\f': pOutput->append("\\f");  break;
+         case '\n': pOutput->append("\\n");  break;
+         case '\r': pOutput->append("\\r");  break;
+         case '\t': pOutput->append("\\t");  break;
+         default:
+         {
+            if (static_cast<unsigned char>(ch) < 0x20)
+            {
+               char buffer[8];
+               ::snprintf(buffer, sizeof(buffer), "\\u%04x",
+                          static_cast<unsigned>(static_cast<unsigned char>(ch)));
+               pOutput->append(buffer);
+            }
+            else
+            {
+               pOutput->push_back(ch);
+            }
+            break;
+         }
+      }
+   }
+   pOutput->push_back('"');
+}
+
+void appendJsonNumber(int value, std::string* pOutput)
+{
+   char buffer[32];
+   ::snprintf(buffer, sizeof(buffer), "%d", value);
+   pOutput->append(buffer);
+}
+
+void appendJsonNumber(double value, std::string* pOutput)
+{
+   char buffer[32];
+   ::snprintf(buffer, sizeof(buffer), "%.15g", value);
+   pOutput->append(buffer);
+}
+
+Error writeJsonFromVectorElement(SEXP vectorSEXP, int i, std::string* pOutput)
+{
+   // mirrors the conversions in jsonValueFromVectorElement (see the NOTEs
+   // there regarding NaN/NA representation)
+   switch(TYPEOF(vectorSEXP))
+   {
+      case NILSXP:
+      {
+         pOutput->append("null");
+         break;
+      }
+      case STRSXP:
+      {
+         SEXP stringSEXP = STRING_ELT(vectorSEXP, i);
+         if (stringSEXP != NA_STRING)
+            appendJsonString(Rf_translateCharUTF8(stringSEXP), pOutput);
+         else
+            pOutput->append("null");
+         break;
+      }
+      case INTSXP:
+      {
+         int value = INTEGER(vectorSEXP)[i];
+         if (value != NA_INTEGER)
+            appendJsonNumber(value, pOutput);
+         else
+            pOutput->append("null");
+         break;
+      }
+      case REALSXP:
+      {
+         double value = REAL(vectorSEXP)[i];
+         if (!ISNAN(value))
+            appendJsonNumber(value, pOutput);
+         else
+            pOutput->append("null");
+         break;
+      }
+      case LGLSXP:
+      {
+         int value = LOGICAL(vectorSEXP)[i];
+         if (value != NA_LOGICAL)
+            pOutput->append(value == TRUE ? "true" : "false");
+         else
+            pOutput->append("null");
+         break;
+      }
+      case CPLXSXP:
+      {
+         double real = COMPLEX(vectorSEXP)[i].r;
+         double imaginary = COMPLEX(vectorSEXP)[i].i;
+         if (!ISNAN(real) && !ISNAN(imaginary))
+         {
+            // note: fields in alphabetical order to match the output of
+            // the json::Object (map) based writer
+            pOutput->append("{\"i\":");
+            appendJsonNumber(imaginary, pOutput);
+            pOutput->append(",\"r\":");
+            appendJsonNumber(real, pOutput);
+            pOutput->push_back('}');
+         }
+         else
+         {
+            pOutput->append("null");
+         }
+         break;
+      }
+      case ENVSXP:
+      {
+         appendJsonString("<environment>", pOutput);
+         break;
+      }
+      default:
+      {
+         return Error(errc::UnexpectedDataTypeError, ERROR_LOCATION);
+      }
+   }
+
+   return Success();
+}
+
+Error writeJsonFromVector(SEXP vectorSEXP, std::string* pOutput)
+{
+   int vectorLength = Rf_length(vectorSEXP);
+
+   if (Rf_inherits(vectorSEXP, "rs.scalar"))
+   {
+      if (vectorLength > 0)
+         return writeJsonFromVectorElement(vectorSEXP, 0, pOutput);
+
+      pOutput->append("null");
+      return Success();
+   }
+
+   pOutput->push_back('[');
+
+   // fast paths for atomic vectors -- dispatch on the vector type once
+   // and format elements in a tight loop
+   switch(TYPEOF(vectorSEXP))
+   {
+      case INTSXP:
+      {
+         int* pInt = INTEGER(vectorSEXP);
+         for (int i=0; i<vectorLength; i++)
+         {
+            if (i > 0)
+               pOutput->push_back(',');
+            if (pInt[i] != NA_INTEGER)
+               appendJsonNumber(pInt[i], pOutput);
+            else
+               pOutput->append("null");
+         }
+         break;
+      }
+      case REALSXP:
+      {
+         double* pReal = REAL(vectorSEXP);
+         for (int i=0; i<vectorLength; i++)
+         {
+            if (i > 0)
+               pOutput->push_back(',');
+            if (!ISNAN(pReal[i]))
+               appendJsonNumber(pReal[i], pOutput);
+            else
+               pOutput->append("null");
+         }
+         break;
+      }
+      case LGLSXP:
+      {
+         int* pLogical = LOGICAL(vectorSEXP);
+         for (int i=0; i<vectorLength; i++)
+         {
+            if (i > 0)
+               pOutput->push_back(',');
+            if (pLogical[i] != NA_LOGICAL)
+               pOutput->append(pLogical[i] == TRUE ? "true" : "false");
+            else
+               pOutput->append("null");
+         }
+         break;
+      }
+      case STRSXP:
+      {
+         for (int i=0; i<vectorLength; i++)
+         {
+            if (i > 0)
+               pOutput->push_back(',');
+            SEXP stringSEXP = STRING_ELT(vectorSEXP, i);
+            if (stringSEXP != NA_STRING)
+               appendJsonString(Rf_translateCharUTF8(stringSEXP), pOutput);
+            else
+               pOutput->append("null");
+         }
+         break;
+      }
+      default:
+      {
+         for (int i=0; i<vectorLength; i++)
+         {
+            if (i > 0)
+               pOutput->push_back(',');
+            Error error = writeJsonFromVectorElement(vectorSEXP, i, pOutput);
+            if (error)
+               return error;
+         }
+         break;
+      }
+   }
+
+   pOutput->push_back(']');
+   return Success();
+}
+
+Error writeJsonArrayFromList(SEXP listSEXP, std::string* pOutput)
+{
+   pOutput->push_back('[');
+
+   int listLength = Rf_length(listSEXP);
+   for (int i=0; i<listLength; i++)
+   {
+      if (i > 0)
+         pOutput->push_back(',');
+
+      Error error = writeJsonFromObject(VECTOR_ELT(listSEXP, i), pOutput);
+      if (error)
+         return error;
+   }
+
+   pOutput->push_back(']');
+   return Success();
+}
+
+//
+// NOTE: this function assumes that isNamedList has been called
+// and returned true for this list (validates a name for each element)
+//
+Error writeJsonObjectFromList(SEXP listSEXP, std::string* pOutput)
+{
+   std::vector<std::string> fieldNames;
+   Error error = sexp::getNames(listSEXP, &fieldNames);
+   if (error)
+      return error;
+
+   pOutput->push_back('{');
+
+   int fields = Rf_length(listSEXP);
+   for (int i=0; i<fields; i++)
+   {
+      if (i > 0)
+         pOutput->push_back(',');
+
+      appendJsonString(fieldNames[i].c_str(), pOutput);
+      pOutput->push_back(':');
+
+      error = writeJsonFromObject(VECTOR_ELT(listSEXP, i), pOutput);
+      if (error)
+         return error;
+   }
+
+   pOutput->push_back('}');
+   return Success();
+}
+
+//
+// NOTE: this function assumes that isNamedList has been called
+// and returned true for this list (validates a name for each element)
+//
+Error writeJsonObjectArrayFromDataFrame(SEXP listSEXP, std::string* pOutput)
+{
+   std::vector<std::string> fieldNames;
+   Error error = sexp::getNames(listSEXP, &fieldNames);
+   if (error)
+      return error;
+
+   int fields = Rf_length(listSEXP);
+   int values = Rf_length(VECTOR_ELT(listSEXP, 0));
+
+   pOutput->push_back('[');
+   for (int v=0; v<values; v++)
+   {
+      if (v > 0)
+         pOutput->push_back(',');
+
+      pOutput->push_back('{');
+      for (int f=0; f<fields; f++)
+      {
+         if (f > 0)
+            pOutput->push_back(',');
+
+         appendJsonString(fieldNames[f].c_str(), pOutput);
+         pOutput->push_back(':');
+
+         SEXP fieldSEXP = VECTOR_ELT(listSEXP, f);
+         if (TYPEOF(fieldSEXP) == VECSXP)
+            error = writeJsonFromObject(VECTOR_ELT(fieldSEXP, v), pOutput);
+         else
+            error = writeJsonFromVectorElement(fieldSEXP, v, pOutput);
+         if (error)
+            return error;
+      }
+      pOutput->push_back('}');
+   }
+   pOutput->push_back(']');
+
+   return Success();
+}
+
 } // anonymous namespace
 
 Error jsonValueFromScalar(SEXP scalarSEXP, core::json::Value* pValue)
@@ -411,8 +732,53 @@ Error jsonValueFromObject(SEXP objectSEXP, core::json::Value* pValue)
          return jsonValueFromVector(objectSEXP, pValue);
       }
    }
-} 
-   
+}
+
+void writeJsonString(const std::string& value, std::string* pOutput)
+{
+   appendJsonString(value.c_str(), pOutput);
+}
+
+Error writeJsonFromObject(SEXP objectSEXP, std::string* pOutput)
+{
+   // streaming analogue of jsonValueFromObject. note that for named lists
+   // fields are emitted in list order (the json::Value based writer emits
+   // them in alphabetical order since json::Object is a map) -- clients
+   // look fields up by name so the two are interchangeable on the wire
+   switch(TYPEOF(objectSEXP))
+   {
+      case NILSXP:
+      {
+         pOutput->append("null");
+         return Success();
+      }
+      case VECSXP:
+      {
+         if (isNamedList(objectSEXP))
+         {
+            if (Rf_inherits(objectSEXP, "data.frame"))
+               return writeJsonObjectArrayFromDataFrame(objectSEXP, pOutput);
+            else
+               return writeJsonObjectFromList(objectSEXP, pOutput);
+         }
+         else
+         {
+            return writeJsonArrayFromList(objectSEXP, pOutput);
+         }
+      }
+      case SYMSXP:
+      case LANGSXP:
+      {
+         appendJsonString(sexp::asString(objectSEXP).c_str(), pOutput);
+         return Success();
+      }
+      default:
+      {
+         return writeJsonFromVector(objectSEXP, pOutput);
+      }
+   }
+}
+
 } // namespace json
 } // namespace r
 } // namespace rstudio
@@ -20,6 +20,8 @@
 #include <r/RSexp.hpp>
 #include <r/RInternal.hpp>
 
+#include <algorithm>
+
 #include <core/Algorithm.hpp>
 
 #include <boost/bind.hpp>
@@ -363,6 +365,83 @@ void listEnvironment(SEXP env,
 }
 
 
+namespace {
+
+// orders binding fingerprints by symbol pointer (symbols are interned by
+// R, so pointer order is stable for the lifetime of the session)
+bool compareBindingSymbol(const BindingFingerprint& lhs,
+                          const BindingFingerprint& rhs)
+{
+   return lhs.symbol < rhs.symbol;
+}
+
+} // anonymous namespace
+
+void fingerprintEnvironment(SEXP env,
+                            bool includeLastDotValue,
+                            std::vector<BindingFingerprint>* pBindings)
+{
+   // reset passed fingerprints
+   pBindings->clear();
+
+   // get the list of binding names (protect locally; the fingerprints hold
+   // interned symbols rather than elements of this listing)
+   SEXP namesSEXP;
+   Protect rProtect(namesSEXP = R_lsInternal(env, FALSE));
+   if (TYPEOF(namesSEXP) != STRSXP)
+      return;
+
+   int numNames = Rf_length(namesSEXP);
+   pBindings->reserve(numNames + 1);
+   for (int i = 0; i < numNames; i++)
+   {
+      SEXP symbolSEXP = Rf_install(CHAR(STRING_ELT(namesSEXP, i)));
+
+      // merely reading an active binding fires it; record active bindings
+      // with a nil value (as listEnvironment does)
+      SEXP valueSEXP = R_NilValue;
+      bool active = R_BindingIsActive(symbolSEXP, env);
+      if (!active)
+         valueSEXP = Rf_findVarInFrame(env, symbolSEXP);
+      if (valueSEXP == R_UnboundValue)
+         continue;
+
+      pBindings->push_back(BindingFingerprint(
+            symbolSEXP,
+            valueSEXP,
+            !active &&
+               TYPEOF(valueSEXP) == PROMSXP &&
+               PRVALUE(valueSEXP) == R_UnboundValue));
+   }
+
+   // add in .Last.value if it exists (it lives in the base environment, so
+   // look it up along the search path rather than in the frame)
+   if (includeLastDotValue)
+   {
+      SEXP symbolSEXP = Rf_install(".Last.value");
+      SEXP valueSEXP = Rf_findVar(symbolSEXP, env);
+      if (valueSEXP != R_UnboundValue)
+      {
+         pBindings->push_back(BindingFingerprint(
+               symbolSEXP,
+               valueSEXP,
+               TYPEOF(valueSEXP) == PROMSXP &&
+                  PRVALUE(valueSEXP) == R_UnboundValue));
+      }
+   }
+
+   // sort into symbol pointer order so callers can diff fingerprint lists
+   // with a single merge pass
+   std::sort(pBindings->begin(), pBindings->end(), compareBindingSymbol);
+}
+
+std::string symbolName(SEXP symbolSEXP)
+{
+   if (TYPEOF(symbolSEXP) != SYMSXP)
+      return std::string();
+   return std::string(Rf_translateCharUTF8(PRINTNAME(symbolSEXP)));
+}
+
 void listNamedAttributes(SEXP obj, Protect *pProtect, std::vector<Variable>* pVariables)
 {
    // reset passed vars
@@ -1224,7 +1303,119 @@ SEXP createList(const std::vector<std::string>& names, Protect* pProtect)
 
    return listSEXP;
 }
-   
+
+SEXP createVector(const json::Array& value, Protect* pProtect)
+{
+   // scan the array for a homogeneous scalar type
+   bool hasString = false, hasReal = false, hasInteger = false,
+        hasBool = false, hasOther = false;
+   for (json::Array::size_type i = 0; i < value.size(); i++)
+   {
+      json_spirit::Value_type type = value[i].type();
+      if (type == json::StringType)
+         hasString = true;
+      else if (type == json::IntegerType)
+         hasInteger = true;
+      else if (type == json::RealType)
+         hasReal = true;
+      else if (type == json::BooleanType)
+         hasBool = true;
+      else if (type != json::NullType)
+         hasOther = true;
+   }
+
+   // heterogeneous -- fall back to element-by-element conversion
+   if (hasOther ||
+       (hasString && (hasReal || hasInteger || hasBool)) ||
+       (hasBool && (hasReal || hasInteger)))
+   {
+      return create(value, pProtect);
+   }
+
+   std::size_t n = value.size();
+   SEXP vectorSEXP;
+   if (hasString)
+   {
+      pProtect->add(vectorSEXP = Rf_allocVector(STRSXP, n));
+      for (std::size_t i = 0; i < n; i++)
+      {
+         if (value[i].is_null())
+            SET_STRING_ELT(vectorSEXP, i, NA_STRING);
+         else
+            SET_STRING_ELT(vectorSEXP, i,
+                           Rf_mkChar(value[i].get_str().c_str()));
+      }
+   }
+   else if (hasReal)
+   {
+      pProtect->add(vectorSEXP = Rf_allocVector(REALSXP, n));
+      double* pReal = REAL(vectorSEXP);
+      for (std::size_t i = 0; i < n; i++)
+         pReal[i] = value[i].is_null() ? NA_REAL : value[i].get_real();
+   }
+   else if (hasInteger)
+   {
+      pProtect->add(vectorSEXP = Rf_allocVector(INTSXP, n));
+      int* pInt = INTEGER(vectorSEXP);
+      for (std::size_t i = 0; i < n; i++)
+         pInt[i] = value[i].is_null() ? NA_INTEGER : value[i].get_int();
+   }
+   else // booleans (or all nulls / empty)
+   {
+      pProtect->add(vectorSEXP = Rf_allocVector(LGLSXP, n));
+      int* pLogical = LOGICAL(vectorSEXP);
+      for (std::size_t i = 0; i < n; i++)
+         pLogical[i] = value[i].is_null() ? NA_LOGICAL : value[i].get_bool();
+   }
+
+   return vectorSEXP;
+}
+
+SEXP createDataFrame(const json::Array& columns,
+                     const std::vector<std::string>& names,
+                     Protect* pProtect)
+{
+   // create the column list
+   SEXP dataSEXP;
+   pProtect->add(dataSEXP = Rf_allocVector(VECSXP, columns.size()));
+
+   // convert each column in bulk (one allocation/protection apiece)
+   int rows = 0;
+   for (json::Array::size_type i = 0; i < columns.size(); i++)
+   {
+      SEXP columnSEXP;
+      if (json::isType<json::Array>(columns[i]))
+         columnSEXP = createVector(columns[i].get_array(), pProtect);
+      else
+         columnSEXP = create(columns[i], pProtect);
+
+      if (i == 0)
+         rows = Rf_length(columnSEXP);
+
+      SET_VECTOR_ELT(dataSEXP, i, columnSEXP);
+   }
+
+   // attach column names
+   SEXP namesSEXP;
+   pProtect->add(namesSEXP = Rf_allocVector(STRSXP, names.size()));
+   for (std::size_t i = 0; i < names.size(); i++)
+      SET_STRING_ELT(namesSEXP, i, Rf_mkChar(names[i].c_str()));
+   Rf_setAttrib(dataSEXP, R_NamesSymbol, namesSEXP);
+
+   // attach compact row names (c(NA, -rows)) and the data.frame class
+   SEXP rowNamesSEXP;
+   pProtect->add(rowNamesSEXP = Rf_allocVector(INTSXP, 2));
+   INTEGER(rowNamesSEXP)[0] = NA_INTEGER;
+   INTEGER(rowNamesSEXP)[1] = -rows;
+   Rf_setAttrib(dataSEXP, R_RowNamesSymbol, rowNamesSEXP);
+
+   SEXP classSEXP;
+   pProtect->add(classSEXP = Rf_mkString("data.frame"));
+   Rf_setAttrib(dataSEXP, R_ClassSymbol, classSEXP);
+
+   return dataSEXP;
+}
+
 Protect::~Protect()
 {
    try
@@ -1249,6 +1440,55 @@ void Protect::unprotectAll()
    protectCount_ = 0;
 }
 
+ProtectArena::ProtectArena()
+   : arenaSEXP_(R_NilValue),
+     index_(0),
+     count_(0)
+{
+   // claim a single reprotectable slot on the protection stack; the
+   // guard vector itself is allocated lazily on first add
+   R_ProtectWithIndex(R_NilValue, &index_);
+}
+
+ProtectArena::~ProtectArena()
+{
+   try
+   {
+      UNPROTECT(1);
+   }
+   catch(...)
+   {
+   }
+}
+
+void ProtectArena::add(SEXP sexp)
+{
+   // grow (or create) the guard vector as needed
+   int capacity = arenaSEXP_ == R_NilValue ? 0 : Rf_length(arenaSEXP_);
+   if (count_ == capacity)
+   {
+      // protect the incoming object across the allocation below
+      PROTECT(sexp);
+      SEXP grownSEXP = Rf_allocVector(VECSXP, std::max(capacity * 2, 32));
+      for (int i = 0; i < count_; i++)
+         SET_VECTOR_ELT(grownSEXP, i, VECTOR_ELT(arenaSEXP_, i));
+      arenaSEXP_ = grownSEXP;
+      R_Reprotect(arenaSEXP_, index_);
+      UNPROTECT(1);
+   }
+
+   SET_VECTOR_ELT(arenaSEXP_, count_++, sexp);
+}
+
+void ProtectArena::unprotectAll()
+{
+   // release references so the guarded objects become collectable; the
+   // stack slot itself is relinquished by the destructor
+   for (int i = 0; i < count_; i++)
+      SET_VECTOR_ELT(arenaSEXP_, i, R_NilValue);
+   count_ = 0;
+}
+
 
 PreservedSEXP::PreservedSEXP()
    : sexp_(R_NilValue)
@@ -1261,6 +1501,23 @@ PreservedSEXP::PreservedSEXP(SEXP sexp)
    set(sexp);
 }
 
+PreservedSEXP::PreservedSEXP(PreservedSEXP&& other)
+   : sexp_(other.sexp_)
+{
+   other.sexp_ = R_NilValue;
+}
+
+PreservedSEXP& PreservedSEXP::operator=(PreservedSEXP&& other)
+{
+   if (this != &other)
+   {
+      releaseNow();
+      sexp_ = other.sexp_;
+      other.sexp_ = R_NilValue;
+   }
+   return *this;
+}
+
 void PreservedSEXP::set(SEXP sexp)
 {
    releaseNow();
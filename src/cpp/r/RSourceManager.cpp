@@ -18,6 +18,8 @@
 #include <algorithm>
 
 #include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string/replace.hpp>
 
 #include <core/Error.hpp>
@@ -37,7 +39,20 @@ SourceManager& sourceManager()
    static SourceManager instance ;
    return instance ;
 }
-   
+
+void SourceManager::setCompiledCacheDir(const core::FilePath& cacheDir)
+{
+   Error error = cacheDir.ensureDirectory();
+   if (error)
+   {
+      // cache remains disabled; sourcing falls back to plain source()
+      LOG_ERROR(error);
+      return;
+   }
+
+   compiledCacheDir_ = cacheDir;
+}
+
 Error SourceManager::sourceTools(const core::FilePath& filePath)
 {
    Error error = sourceLocal(filePath);
@@ -95,6 +110,13 @@ void SourceManager::reSourceTools(const core::FilePath& filePath)
    
 Error SourceManager::source(const FilePath& filePath, bool local)
 {
+#ifdef NDEBUG
+   // use the compiled-expression cache when enabled (debug builds skip
+   // it so that source references are preserved for debugging)
+   if (!compiledCacheDir_.empty())
+      return sourceCompiled(filePath, local);
+#endif
+
    std::string localPrefix = local ? "local(" : "";
    std::string localParam = local ? "TRUE" : "FALSE" ;
    std::string localSuffix = local ? ")" : "";
@@ -125,6 +147,66 @@ Error SourceManager::source(const FilePath& filePath, bool local)
    return r::exec::executeString(rCode); 
 }
 
+Error SourceManager::sourceCompiled(const FilePath& filePath, bool local)
+{
+   // key the cache entry by file identity (name, size, and mtime) so
+   // that a new installation -- or any edit to the file -- generates a
+   // fresh entry rather than reusing a stale one
+   std::string stem = filePath.stem();
+   std::string cacheName = stem + "-" +
+      boost::lexical_cast<std::string>(filePath.size()) + "-" +
+      boost::lexical_cast<std::string>(
+            static_cast<boost::int64_t>(filePath.lastWriteTime())) + ".rds";
+   FilePath cachePath = compiledCacheDir_.complete(cacheName);
+
+   // do \ escaping (for windows)
+   std::string path = filePath.absolutePath();
+   boost::algorithm::replace_all(path, "\\", "\\\\");
+   std::string cache = cachePath.absolutePath();
+   boost::algorithm::replace_all(cache, "\\", "\\\\");
+
+   // pattern matching all cache entries for this file (used to clean up
+   // entries left behind by previous versions)
+   std::string stalePattern = "^" + stem + "-";
+   boost::algorithm::replace_all(stalePattern, ".", "\\\\.");
+
+   // evaluate the cached compiled expressions if they exist; otherwise
+   // parse and byte-compile the file, cache the result (best-effort --
+   // the cache directory is shared so the write is staged through a
+   // temp file and renamed into place), and evaluate
+   std::string rCode = std::string() +
+      "local({ " +
+         "file <- \"" + path + "\"; " +
+         "cache <- \"" + cache + "\"; " +
+         "envir <- " + (local ? "new.env(parent = globalenv())"
+                              : "globalenv()") + "; " +
+         "exprs <- NULL; " +
+         "if (file.exists(cache)) " +
+            "exprs <- tryCatch(readRDS(cache), error = function(e) NULL); " +
+         "if (is.null(exprs)) { " +
+            "exprs <- parse(file, keep.source = FALSE, encoding = \"UTF-8\"); " +
+            "exprs <- tryCatch(lapply(exprs, compiler::compile), " +
+                              "error = function(e) as.list(exprs)); " +
+            "tryCatch({ " +
+               "stale <- list.files(dirname(cache), " +
+                                   "pattern = \"" + stalePattern + "\", " +
+                                   "full.names = TRUE); " +
+               "unlink(stale[stale != cache]); " +
+               "tmp <- tempfile(tmpdir = dirname(cache)); " +
+               "saveRDS(exprs, tmp); " +
+               "file.rename(tmp, cache) " +
+            "}, error = function(e) NULL); " +
+         "}; " +
+         "for (expr in exprs) eval(expr, envir = envir); " +
+         "invisible(NULL) " +
+      "})";
+
+   // record that we sourced the file
+   recordSourcedFile(filePath, local);
+
+   return r::exec::executeString(rCode);
+}
+
 void SourceManager::recordSourcedFile(const FilePath& filePath, bool local)
 {
    SourcedFileInfo fileInfo(filePath.lastWriteTime(), local); 
@@ -98,6 +98,8 @@ core::Error evaluateString(const std::string& str, T* pValue)
    return sexp::extract(valueSEXP, pValue);
 }
    
+class PreparedFunction;
+
 // call R functions
 class RFunction : boost::noncopyable
 {
@@ -176,7 +178,9 @@ public:
    }
    
    explicit RFunction(SEXP functionSEXP);
-   
+
+   explicit RFunction(PreparedFunction& preparedFunction);
+
    virtual ~RFunction() ;
    
    // COPYING: boost::noncopyable
@@ -264,6 +268,43 @@ private:
    std::vector<Param> params_ ;
 };
 
+// prepared call support -- caches the function binding for R functions
+// which the session invokes repeatedly (e.g. from change detection),
+// eliminating the per-invocation lookup. bindings are resolved lazily on
+// first use (so instances can safely be statics) and re-resolved after
+// invalidatePreparedCalls() has been called. typical usage:
+//
+//   static r::exec::PreparedFunction libPathsFunction("base:::.libPaths");
+//   Error error = r::exec::RFunction(libPathsFunction).call(&libPaths);
+//
+class PreparedFunction : boost::noncopyable
+{
+public:
+   explicit PreparedFunction(const std::string& name)
+      : functionName_(name),
+        functionSEXP_(R_UnboundValue),
+        generation_(0)
+   {
+   }
+
+   // resolved function (R_UnboundValue if the lookup fails -- in that
+   // case resolution is re-attempted on the next call)
+   SEXP functionSEXP();
+
+   const std::string& name() const { return functionName_; }
+
+private:
+   std::string functionName_;
+   SEXP functionSEXP_;
+   unsigned generation_;
+   r::sexp::SEXPPreserver preserver_;
+};
+
+// drop all prepared function bindings so they are re-resolved on next
+// use -- call this whenever function bindings may have changed out from
+// under us (e.g. a package namespace was loaded or unloaded)
+void invalidatePreparedCalls();
+
 void warning(const std::string& warning);
    
 void message(const std::string& message);
@@ -38,6 +38,15 @@ core::Error jsonValueFromScalar(SEXP scalarSEXP, core::json::Value* pValue);
 core::Error jsonValueFromVector(SEXP vectorSEXP, core::json::Value* pValue);
 core::Error jsonValueFromList(SEXP listSEXP, core::json::Value* pValue);
 core::Error jsonValueFromObject(SEXP objectSEXP, core::json::Value* pValue);
+
+// streaming serializer -- walks the object once and appends JSON text
+// directly to *pOutput rather than materializing an intermediate
+// json::Value tree (conversion rules are identical to jsonValueFromObject).
+// on error the contents of *pOutput are undefined.
+core::Error writeJsonFromObject(SEXP objectSEXP, std::string* pOutput);
+
+// append a JSON string literal (quoted and escaped) for the given text
+void writeJsonString(const std::string& value, std::string* pOutput);
    
 } // namespace json
 } // namespace r
@@ -60,12 +60,46 @@ SEXP forcePromise(SEXP objectSEXP);
    
 // variables within an environment
 typedef std::pair<std::string,SEXP> Variable ;
-void listEnvironment(SEXP env, 
+void listEnvironment(SEXP env,
                      bool includeAll,
                      bool includeLastDotValue,
                      Protect* pProtect,
                      std::vector<Variable>* pVariables);
-      
+
+// a compact fingerprint of a single binding: the interned symbol, the bound
+// value, and whether the value is an unevaluated promise. R interns symbols,
+// so fingerprints can be ordered and compared by pointer without translating
+// binding names.
+struct BindingFingerprint
+{
+   BindingFingerprint() : symbol(NULL), value(NULL), unevaledPromise(false) {}
+   BindingFingerprint(SEXP symbol, SEXP value, bool unevaledPromise)
+      : symbol(symbol), value(value), unevaledPromise(unevaledPromise)
+   {
+   }
+
+   bool operator==(const BindingFingerprint& other) const
+   {
+      return symbol == other.symbol &&
+             value == other.value &&
+             unevaledPromise == other.unevaledPromise;
+   }
+
+   SEXP symbol;
+   SEXP value;
+   bool unevaledPromise;
+};
+
+// fingerprints every binding in an environment, sorted by symbol pointer;
+// evaluates no R code, translates no binding names, and doesn't fire active
+// bindings (they're recorded with a nil value, as listEnvironment does)
+void fingerprintEnvironment(SEXP env,
+                            bool includeLastDotValue,
+                            std::vector<BindingFingerprint>* pBindings);
+
+// the translated name of an interned symbol
+std::string symbolName(SEXP symbolSEXP);
+
 // object info
 SEXP findVar(const std::string& name,
              const std::string& ns = std::string()); 
@@ -166,6 +200,18 @@ SEXP createRawVector(const std::string& data, Protect* pProtect);
 // Create a named list
 SEXP createList(const std::vector<std::string>& names, Protect* pProtect);
 
+// Convert a homogeneous json array into an atomic vector with a single
+// allocation and a single protection (json nulls become NAs and integers
+// are promoted to reals when the two are mixed); falls back to generic
+// element-by-element conversion for heterogeneous arrays
+SEXP createVector(const core::json::Array& value, Protect* pProtect);
+
+// Convert a json array of (columnar) json arrays into a data.frame, with
+// one allocation and one protection per column
+SEXP createDataFrame(const core::json::Array& columns,
+                     const std::vector<std::string>& names,
+                     Protect* pProtect);
+
 inline int indexOfElementNamed(SEXP listSEXP, const std::string& name)
 {
    // get the names so we can determine which slot the element is in are in
@@ -261,16 +307,39 @@ public:
    }
    
    virtual ~Protect();
-   
+
    // COPYING: boost::noncopyable
-   
-   void add(SEXP sexp);
-   void unprotectAll();
-   
+
+   virtual void add(SEXP sexp);
+   virtual void unprotectAll();
+
 private:
    int protectCount_ ;
 };
 
+// batched alternative to Protect for conversion-heavy code paths (e.g.
+// bulk json -> SEXP conversion). guards any number of objects with a
+// single slot on R's protection stack -- a growable list reprotected in
+// place -- instead of one slot per object, which matters when converting
+// structures with many thousands of elements. accepted anywhere a
+// Protect* is taken, so hot loops can opt in without signature changes.
+class ProtectArena : public Protect
+{
+public:
+   ProtectArena();
+   virtual ~ProtectArena();
+
+   // COPYING: boost::noncopyable (via Protect)
+
+   virtual void add(SEXP sexp);
+   virtual void unprotectAll();
+
+private:
+   SEXP arenaSEXP_;
+   int index_;    // PROTECT_INDEX of the guard vector's slot
+   int count_;
+};
+
 // set list element by name. note that the specified element MUST already
 // exist before the call
 template <typename T>
@@ -306,6 +375,12 @@ class PreservedSEXP : boost::noncopyable
 public:
    PreservedSEXP();
    explicit PreservedSEXP(SEXP sexp);
+
+   // movable (though not copyable) so handles can be returned from
+   // factories and stored in containers without double-release
+   PreservedSEXP(PreservedSEXP&& other);
+   PreservedSEXP& operator=(PreservedSEXP&& other);
+
    virtual ~PreservedSEXP();
 
    void set(SEXP sexp);
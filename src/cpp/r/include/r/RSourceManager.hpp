@@ -50,7 +50,14 @@ public:
    
    bool autoReload() const { return autoReload_; }
    void setAutoReload(bool autoReload) { autoReload_ = autoReload; }
-   
+
+   // enable the compiled-expression cache: files sourced after this
+   // call are parsed and byte-compiled once (keyed by file identity)
+   // into serialized expression lists within cacheDir, and subsequent
+   // sessions evaluate the compiled form rather than re-parsing. the
+   // cache is best-effort -- any failure falls back to plain source()
+   void setCompiledCacheDir(const core::FilePath& cacheDir);
+
    core::Error sourceTools(const core::FilePath& filePath);
    void ensureToolsLoaded();
 
@@ -75,12 +82,14 @@ private:
    
    // helper functions
    core::Error source(const core::FilePath& filePath, bool local);
+   core::Error sourceCompiled(const core::FilePath& filePath, bool local);
    void reSourceTools(const core::FilePath& filePath);
    void recordSourcedFile(const core::FilePath& filePath, bool local);
    void reloadSourceIfNecessary(const SourcedFileMap::value_type& value);
-   
+
    // members
    bool autoReload_ ;
+   core::FilePath compiledCacheDir_;
    SourcedFileMap sourcedFiles_ ;
    std::vector<core::FilePath> toolsFilePaths_;
 };
@@ -53,6 +53,14 @@ void permanentlyDisablePolledEventHandler();
 // check whether the polled event handler has already been initialized
 bool polledEventHandlerInitialized();
 
+// signal the event loop's wakeup fd -- may be called from any thread to
+// interrupt the select() that R performs between polled event
+// invocations, so pending work (e.g. a newly arrived http connection or
+// client event) is picked up immediately rather than after up to a full
+// poll interval. no-op where fd-based wakeup isn't available (win32, or
+// before initializePolledEventHandler has been called)
+void signalWakeup();
+
 // event processing (allowing R gui components like GraphApp or the quartz
 // device to remain responsive)
 void processEvents();
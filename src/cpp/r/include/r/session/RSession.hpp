@@ -161,7 +161,16 @@ core::Error run(const ROptions& options, const RCallbacks& callbacks);
    
 // deferred deserialization of the session
 void ensureDeserialized();
-      
+
+// progressive restore: when a suspended session's environment cache is
+// restored, global objects are installed as lazy bindings which load on
+// first touch. these functions let the client materialize whatever
+// remains during idle time (most recently used objects first).
+// forceNextPendingGlobalObject materializes a single object and returns
+// true if unrestored objects remain
+bool hasPendingGlobalObjects();
+bool forceNextPendingGlobalObject();
+
 // set client metrics 
 void setClientMetrics(const RClientMetrics& metrics);
 
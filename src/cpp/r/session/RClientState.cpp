@@ -36,7 +36,17 @@ namespace {
 const char * const kTemporaryExt = ".temporary";
 const char * const kPersistentExt = ".persistent";
 const char * const kProjPersistentExt = ".pper";
-   
+
+// all state within a directory is committed as a single combined
+// document (one sequential write) rather than a file per scope --
+// scattered small synchronous writes are very expensive on network
+// file systems. the legacy one-file-per-scope layout (above
+// extensions) is still read for migration of older session data
+const char * const kClientStateFile = "client-state";
+const char * const kTemporarySection = "temporary";
+const char * const kPersistentSection = "persistent";
+const char * const kProjPersistentSection = "project_persistent";
+
 void putState(const std::string& scope, 
               const json::Object::value_type& entry,
               json::Object* pStateContainer)
@@ -82,25 +92,58 @@ void mergeState(const json::Object& sourceState,
                  boost::bind(mergeStateScope, _1, pTargetState));
 }
 
-void commitState(const json::Object& stateContainer,
-                 const std::string& fileExt,
-                 const core::FilePath& stateDir)
+void commitCombinedState(const json::Object& stateDoc,
+                         const core::FilePath& stateDir)
+{
+   // generate json
+   std::ostringstream ostr ;
+   json::writeFormatted(stateDoc, ostr);
+
+   // write to file
+   FilePath stateFile = stateDir.complete(kClientStateFile);
+   Error error = writeStringToFile(stateFile, ostr.str());
+   if (error)
+      LOG_ERROR(error);
+}
+
+// read the combined state document for a directory; returns false if it
+// doesn't exist (i.e. the directory uses the legacy per-scope layout)
+bool restoreCombinedState(const core::FilePath& stateDir,
+                          json::Object* pStateDoc)
 {
-   for (json::Object::const_iterator
-        it = stateContainer.begin(); it != stateContainer.end(); ++it)
+   FilePath stateFile = stateDir.complete(kClientStateFile);
+   if (!stateFile.exists())
+      return false;
+
+   std::string contents ;
+   Error error = readStringFromFile(stateFile, &contents);
+   if (error)
    {
-      // generate json
-      std::ostringstream ostr ;
-      json::writeFormatted(it->second, ostr);
-      
-      // write to file
-      FilePath stateFile = stateDir.complete(it->first + fileExt);
-      Error error = writeStringToFile(stateFile, ostr.str());
-      if (error)
-         LOG_ERROR(error);   
+      LOG_ERROR(error);
+      return true;
    }
+
+   json::Value value;
+   if (!json::parse(contents, &value) ||
+       !json::isType<json::Object>(value))
+   {
+      LOG_ERROR_MESSAGE("Error parsing client state");
+      return true;
+   }
+
+   *pStateDoc = value.get_obj();
+   return true;
 }
-   
+
+void restoreSection(const json::Object& stateDoc,
+                    const std::string& name,
+                    json::Object* pStateContainer)
+{
+   json::Object::const_iterator it = stateDoc.find(name);
+   if ((it != stateDoc.end()) && json::isType<json::Object>(it->second))
+      *pStateContainer = it->second.get_obj();
+}
+
 void restoreState(const core::FilePath& stateFilePath,
                   json::Object* pStateContainer)
 {
@@ -267,7 +310,8 @@ Error ClientState::commit(ClientStateCommitType commitType,
                           const core::FilePath& stateDir,
                           const core::FilePath& projectStateDir)
 {
-   // remove and re-create the stateDirs
+   // remove and re-create the stateDirs (this also clears out any
+   // legacy per-scope state files written by older versions)
    Error error = removeAndRecreateStateDir(stateDir);
    if (error)
       return error;
@@ -275,16 +319,19 @@ Error ClientState::commit(ClientStateCommitType commitType,
    if (error)
       return error;
 
-   // always commit persistent state
-   commitState(persistentState_, kPersistentExt, stateDir);
-   commitState(projectPersistentState_, kProjPersistentExt, projectStateDir);
-  
-   // commit all state if requested
+   // always commit persistent state; commit all state if requested
+   json::Object stateDoc;
+   stateDoc[kPersistentSection] = persistentState_;
    if (commitType == ClientStateCommitAll)
-      commitState(temporaryState_, kTemporaryExt, stateDir);
+      stateDoc[kTemporarySection] = temporaryState_;
    else
       temporaryState_.clear();
-   
+   commitCombinedState(stateDoc, stateDir);
+
+   json::Object projectStateDoc;
+   projectStateDoc[kProjPersistentSection] = projectPersistentState_;
+   commitCombinedState(projectStateDoc, projectStateDir);
+
    return Success();
 }
    
@@ -293,18 +340,39 @@ Error ClientState::restore(const FilePath& stateDir,
 {
    // clear existing values
    clear();
-   
-   // restore global state
-   Error error = restoreStateFiles(
-                  stateDir,
-                  boost::bind(&ClientState::restoreGlobalState, this, _1));
-   if (error)
-      return error;
+
+   // restore global state (prefer the combined document, fall back to
+   // scanning the legacy per-scope layout)
+   json::Object stateDoc;
+   if (restoreCombinedState(stateDir, &stateDoc))
+   {
+      restoreSection(stateDoc, kTemporarySection, &temporaryState_);
+      restoreSection(stateDoc, kPersistentSection, &persistentState_);
+   }
+   else
+   {
+      Error error = restoreStateFiles(
+                     stateDir,
+                     boost::bind(&ClientState::restoreGlobalState, this, _1));
+      if (error)
+         return error;
+   }
 
    // restore project state
-   return restoreStateFiles(
-                  projectStateDir,
-                  boost::bind(&ClientState::restoreProjectState, this, _1));
+   json::Object projectStateDoc;
+   if (restoreCombinedState(projectStateDir, &projectStateDoc))
+   {
+      restoreSection(projectStateDoc,
+                     kProjPersistentSection,
+                     &projectPersistentState_);
+      return Success();
+   }
+   else
+   {
+      return restoreStateFiles(
+                     projectStateDir,
+                     boost::bind(&ClientState::restoreProjectState, this, _1));
+   }
 }
 
 // generate current state by merging temporary and persistent states
@@ -13,6 +13,10 @@
  *
  */
 
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
 #include <r/RExec.hpp>
 
 #include <core/FilePath.hpp>
@@ -177,6 +181,56 @@ void polledEventHandler()
       s_oldPolledEventHandler();
 }
 
+// wakeup pipe -- written by signalWakeup() (from any thread) so that
+// activity interrupts the select() R performs between polled event
+// invocations (rather than waiting out the full poll interval)
+int s_wakeupFds[2] = { -1, -1 };
+
+// input handler registered with R for the read end of the wakeup pipe:
+// drains the pipe and processes the pending work immediately
+void wakeupHandler(void*)
+{
+   // drain the pipe (multiple signals may have accumulated)
+   char buffer[64];
+   while (::read(s_wakeupFds[0], buffer, sizeof(buffer)) > 0)
+   {
+   }
+
+   // process pending work (guard against reentrancy in case event
+   // processing itself pumps R's input handlers)
+   static bool s_processingWakeup = false;
+   if (!s_processingWakeup)
+   {
+      s_processingWakeup = true;
+      polledEventHandler();
+      s_processingWakeup = false;
+   }
+}
+
+void initializeWakeupPipe()
+{
+   if (::pipe(s_wakeupFds) == -1)
+   {
+      // not fatal -- we simply fall back to pure polling
+      LOG_ERROR(systemError(errno, ERROR_LOCATION));
+      return;
+   }
+
+   // non-blocking on both ends (so signaling never blocks a writer and
+   // draining never blocks the event loop) and closed on exec
+   for (int i = 0; i < 2; i++)
+   {
+      ::fcntl(s_wakeupFds[i], F_SETFL,
+              ::fcntl(s_wakeupFds[i], F_GETFL) | O_NONBLOCK);
+      ::fcntl(s_wakeupFds[i], F_SETFD, FD_CLOEXEC);
+   }
+
+   // register the read end with R's input handler list so activity on it
+   // wakes the event loop's select()
+   ::addInputHandler(R_InputHandlers, s_wakeupFds[0], wakeupHandler,
+                     XActivity);
+}
+
 
 #ifdef __APPLE__
 
@@ -324,6 +378,11 @@ void initializePolledEventHandler(void (*newPolledEventHandler)(void))
    // set R_wait_usec
    if (R_wait_usec > 10000 || R_wait_usec == 0)
       R_wait_usec = 10000;
+
+   // create the wakeup pipe so other threads (e.g. the http connection
+   // listener) can interrupt the select rather than have their work wait
+   // out the poll interval
+   initializeWakeupPipe();
 }
 
 // NOTE: this call is used in child process after multicore forks
@@ -347,6 +406,20 @@ bool polledEventHandlerInitialized()
    return s_polledEventHandler != NULL;
 }
 
+void signalWakeup()
+{
+   // no-op when the wakeup pipe isn't available (e.g. before
+   // initializePolledEventHandler has been called)
+   if (s_wakeupFds[1] == -1)
+      return;
+
+   // a full pipe (EAGAIN) means a wakeup is already pending. note that
+   // this is safe to call from any thread so we don't log errors here
+   char byte = 0;
+   int result = ::write(s_wakeupFds[1], &byte, 1);
+   (void) result;
+}
+
 void processEvents()
 {
 #ifdef __APPLE__
@@ -271,6 +271,11 @@ bool polledEventHandlerInitialized()
    return s_polledEventHandler != NULL;
 }
 
+void signalWakeup()
+{
+   // no fd-based wakeup on win32 (the event loop relies on polling)
+}
+
 void processEvents()
 {
    R_ProcessEvents();
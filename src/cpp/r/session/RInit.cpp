@@ -131,7 +131,12 @@ void deferredRestoreNewSession()
 
       std::string path = string_utils::utf8ToSystem(globalEnvPath.absolutePath());
       std::string aliasedPath = createAliasedPath(globalEnvPath);
-      
+
+      // NOTE: the .RData image is a single serialized stream owned by R
+      // so it can't be restored progressively -- contrast with session
+      // resume, where the environment cache installs lazy per-object
+      // bindings (see RSearchPath.cpp)
+
       std::string errMessage;
       Error error = restoreGlobalEnvFromFile(path, &errMessage);
       if (error)
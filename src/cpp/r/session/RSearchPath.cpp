@@ -23,6 +23,9 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include <set>
+#include <deque>
 #include <algorithm>
 
 #include <boost/bind.hpp>
@@ -35,6 +38,7 @@
 #include <core/Error.hpp>
 #include <core/FilePath.hpp>
 #include <core/SafeConvert.hpp>
+#include <core/Thread.hpp>
 #include <core/FileSerializer.hpp>
 
 #define R_INTERNAL_FUNCTIONS
@@ -80,22 +84,455 @@ void reportRestoreError(const std::string& context,
    REprintf(report.c_str());
 }   
    
-Error saveGlobalEnvironmentToFile(const FilePath& environmentFile)
-{
-   std::string envPath =
-            string_utils::utf8ToSystem(environmentFile.absolutePath());
-   return executeSafely(boost::bind(R_SaveGlobalEnvToFile, envPath.c_str()));
-}
-   
+// defined with the package prefetch machinery below; reused here to
+// warm workspace image files ahead of the R-side loads
+void prefetchFile(const FilePath& filePath);
+void beginFileReadahead(const std::vector<FilePath>& filePaths);
+
 Error restoreGlobalEnvironment(const core::FilePath& environmentFile)
 {
    // tolerate no environment saved
    if (!environmentFile.exists())
       return Success();
-   
+
+   // R's load interleaves many small reads as it parses the image; a
+   // sequential reader warming the page cache ahead of it converts most
+   // of those into cache hits (the difference is substantial on NFS)
+   core::thread::safeLaunchThread(boost::bind(prefetchFile,
+                                              environmentFile));
+
    return RFunction("load", environmentFile.absolutePath()).call();
 }
 
+// incremental global environment persistence: rather than one
+// monolithic image, each global object is serialized to its own file
+// within an environment cache directory, and objects whose bindings
+// haven't changed since the previous suspend (or since they were
+// restored) keep their existing file rather than being re-serialized.
+// for workspaces dominated by large, rarely-touched objects this makes
+// routine suspends proportional to what changed rather than to the
+// size of the workspace
+
+const char * const kEnvironmentCacheDir = "environment_cache";
+const char * const kEnvironmentCacheIndex = "INDEX";
+const char * const kEnvironmentCacheOrder = "ORDER";
+
+// traversal budget for isCacheableObject (on exhaustion we
+// conservatively report non-cacheable)
+const int kCacheableCheckBudget = 10000;
+
+// identity stamp for a global binding. R's copy-on-modify semantics
+// mean that changing a top-level object rebinds its symbol to a new
+// SEXP, so an unchanged (address, type, length) triple indicates the
+// serialized form on disk is still current. objects whose contents can
+// mutate in place without rebinding are screened out by
+// isCacheableObject below
+struct ObjectStamp
+{
+   ObjectStamp() : address(NULL), type(-1), length(-1) {}
+   void* address;
+   int type;
+   int length;
+};
+
+ObjectStamp objectStamp(SEXP valueSEXP)
+{
+   ObjectStamp stamp;
+   stamp.address = (void*)valueSEXP;
+   stamp.type = TYPEOF(valueSEXP);
+   stamp.length = Rf_length(valueSEXP);
+   return stamp;
+}
+
+bool stampsMatch(const ObjectStamp& a, const ObjectStamp& b)
+{
+   return a.address == b.address &&
+          a.type == b.type &&
+          a.length == b.length;
+}
+
+struct CachedObject
+{
+   CachedObject() : cacheable(false), lazy(false), generation(0) {}
+   std::string file;
+   ObjectStamp stamp;
+   bool cacheable;
+
+   // lazy bindings installed by a progressive restore are backed
+   // verbatim by their file on disk until they are forced
+   bool lazy;
+
+   // save generation at which the object was last serialized (or, for
+   // a forced lazy binding, re-serialized) -- used to order the next
+   // restore by recency of use
+   int generation;
+};
+
+// stamps recorded at the last save/restore. NOTE: stamps are only
+// meaningful within this process (addresses don't survive a restore)
+// so they aren't persisted -- the restore path re-stamps each object
+// as it's loaded
+std::map<std::string, CachedObject> s_environmentCache;
+int s_nextCacheFileId = 0;
+int s_cacheGeneration = 0;
+
+// lazily-restored global objects which haven't been materialized yet,
+// most recently used first (see forceNextPendingGlobalObject below)
+std::deque<std::string> s_pendingRestoreObjects;
+
+// can this object's serialized form be reused for as long as its
+// binding remains unchanged? environments, external pointers, and
+// friends can mutate in place without rebinding the top-level symbol
+// (including when buried inside a list element or an attribute), so
+// anything that contains one is always re-serialized. pBudget bounds
+// the traversal so the check itself stays cheap for pathological
+// structures
+bool isCacheableObject(SEXP valueSEXP, int* pBudget)
+{
+   if (--(*pBudget) < 0)
+      return false;
+
+   switch(TYPEOF(valueSEXP))
+   {
+      case NILSXP:
+         return true;
+
+      case ENVSXP:
+      case EXTPTRSXP:
+      case WEAKREFSXP:
+      case PROMSXP:
+      case CLOSXP:
+      case SPECIALSXP:
+      case BUILTINSXP:
+      case BCODESXP:
+         return false;
+
+      case VECSXP:
+      case EXPRSXP:
+      {
+         for (int i = 0, n = Rf_length(valueSEXP); i < n; i++)
+            if (!isCacheableObject(VECTOR_ELT(valueSEXP, i), pBudget))
+               return false;
+         break;
+      }
+
+      case LISTSXP:
+      case LANGSXP:
+      case DOTSXP:
+      {
+         for (SEXP cons = valueSEXP; cons != R_NilValue; cons = CDR(cons))
+            if (!isCacheableObject(CAR(cons), pBudget))
+               return false;
+         break;
+      }
+
+      default:
+         break; // atomic vectors, strings, symbols, S4 cells, etc.
+   }
+
+   // attributes (including S4 slots) can hang mutable state off of
+   // any object
+   for (SEXP cons = ATTRIB(valueSEXP); cons != R_NilValue; cons = CDR(cons))
+      if (!isCacheableObject(CAR(cons), pBudget))
+         return false;
+
+   return true;
+}
+
+Error saveGlobalEnvironmentIncrementally(const FilePath& statePath)
+{
+   FilePath cacheDir = statePath.complete(kEnvironmentCacheDir);
+   Error error = cacheDir.ensureDirectory();
+   if (error)
+      return error;
+
+   // enumerate global objects (including hidden ones)
+   std::vector<std::string> objectNames;
+   error = r::exec::evaluateString("ls(envir = .GlobalEnv, all.names = TRUE)",
+                                   &objectNames);
+   if (error)
+      return error;
+
+   // new save generation (used to order the next restore by recency)
+   int generation = ++s_cacheGeneration;
+
+   std::map<std::string, CachedObject> cache;
+   std::map<std::string, std::string> index;
+   for (std::vector<std::string>::const_iterator it = objectNames.begin();
+        it != objectNames.end();
+        ++it)
+   {
+      const std::string& name = *it;
+
+      // don't fire active bindings just to stamp them -- they're
+      // serialized unconditionally below
+      bool activeBinding = r::sexp::isActiveBinding(name, R_GlobalEnv);
+      SEXP valueSEXP = R_UnboundValue;
+      if (!activeBinding)
+         valueSEXP = r::sexp::findVar(name, R_GlobalEnv);
+      if (!activeBinding && valueSEXP == R_UnboundValue)
+         continue;
+
+      // look up the prior cache entry
+      CachedObject object;
+      std::map<std::string, CachedObject>::const_iterator itCache =
+                                             s_environmentCache.find(name);
+      if (itCache != s_environmentCache.end())
+         object = itCache->second;
+
+      // unwrap promises: a forced lazy binding is stamped against its
+      // value; an unforced one is still backed verbatim by its file on
+      // disk, so reuse the file rather than forcing a (potentially
+      // huge) load just to serialize the object again. promises we
+      // didn't install ourselves fall through to save() below, which
+      // forces them (as it always has)
+      if (!activeBinding && TYPEOF(valueSEXP) == PROMSXP)
+      {
+         SEXP forcedSEXP = PRVALUE(valueSEXP);
+         if (forcedSEXP != R_UnboundValue)
+         {
+            valueSEXP = forcedSEXP;
+         }
+         else if (object.lazy &&
+                  !object.file.empty() &&
+                  cacheDir.complete(object.file).exists())
+         {
+            cache[name] = object;
+            index[name] = object.file;
+            continue;
+         }
+      }
+
+      bool cacheable = false;
+      ObjectStamp stamp;
+      if (!activeBinding)
+      {
+         int budget = kCacheableCheckBudget;
+         cacheable = isCacheableObject(valueSEXP, &budget);
+         stamp = objectStamp(valueSEXP);
+      }
+
+      // reuse the prior serialization when the binding is unchanged
+      bool current = cacheable &&
+                     object.cacheable &&
+                     stampsMatch(object.stamp, stamp) &&
+                     !object.file.empty() &&
+                     cacheDir.complete(object.file).exists();
+      if (!current)
+      {
+         if (object.file.empty())
+            object.file = "obj_" +
+                  safe_convert::numberToString(s_nextCacheFileId++);
+
+         FilePath objectFile = cacheDir.complete(object.file);
+         error = RFunction("save")
+                     .addParam("list", name)
+                     .addParam("file", string_utils::utf8ToSystem(
+                                             objectFile.absolutePath()))
+                     .addParam("envir", R_GlobalEnv)
+                     .call();
+         if (error)
+            return error;
+
+         // re-serialization implies recent use -- order the next
+         // restore accordingly
+         object.generation = generation;
+      }
+
+      object.stamp = stamp;
+      object.cacheable = cacheable;
+      object.lazy = false;
+      cache[name] = object;
+      index[name] = object.file;
+   }
+
+   // remove files belonging to objects which no longer exist
+   std::vector<FilePath> children;
+   error = cacheDir.children(&children);
+   if (error)
+      LOG_ERROR(error);
+   std::set<std::string> referencedFiles;
+   for (std::map<std::string, std::string>::const_iterator it = index.begin();
+        it != index.end();
+        ++it)
+   {
+      referencedFiles.insert(it->second);
+   }
+   for (std::vector<FilePath>::const_iterator it = children.begin();
+        it != children.end();
+        ++it)
+   {
+      std::string filename = it->filename();
+      if (filename != kEnvironmentCacheIndex &&
+          filename != kEnvironmentCacheOrder &&
+          referencedFiles.count(filename) == 0)
+      {
+         Error error = it->remove();
+         if (error)
+            LOG_ERROR(error);
+      }
+   }
+
+   s_environmentCache = cache;
+
+   error = writeStringMapToFile(cacheDir.complete(kEnvironmentCacheIndex),
+                                index);
+   if (error)
+      return error;
+
+   // write the restore order (most recently used objects first) so the
+   // next restore materializes the objects users touch first ahead of
+   // long-dormant ones
+   std::vector<std::pair<int, std::string> > order;
+   for (std::map<std::string, CachedObject>::const_iterator it = cache.begin();
+        it != cache.end();
+        ++it)
+   {
+      order.push_back(std::make_pair(-it->second.generation, it->first));
+   }
+   std::sort(order.begin(), order.end());
+   std::vector<std::string> orderedNames;
+   for (std::size_t i = 0; i < order.size(); i++)
+      orderedNames.push_back(order[i].second);
+   error = writeStringVectorToFile(cacheDir.complete(kEnvironmentCacheOrder),
+                                   orderedNames);
+   if (error)
+      return error;
+
+   // the cache supersedes the monolithic environment file
+   return statePath.complete(kEnvironmentFile).removeIfExists();
+}
+
+Error restoreGlobalEnvironmentFromCache(const FilePath& cacheDir)
+{
+   std::map<std::string, std::string> index;
+   Error error = readStringMapFromFile(
+                        cacheDir.complete(kEnvironmentCacheIndex), &index);
+   if (error)
+      return error;
+
+   // determine the restore order -- the order file lists objects most
+   // recently used first (older caches don't have one, in which case
+   // we fall back to index order)
+   std::vector<std::string> restoreOrder;
+   FilePath orderFile = cacheDir.complete(kEnvironmentCacheOrder);
+   if (orderFile.exists())
+   {
+      error = readStringVectorFromFile(orderFile, &restoreOrder);
+      if (error)
+      {
+         LOG_ERROR(error);
+         restoreOrder.clear();
+      }
+   }
+   for (std::map<std::string, std::string>::const_iterator it = index.begin();
+        it != index.end();
+        ++it)
+   {
+      if (std::find(restoreOrder.begin(), restoreOrder.end(), it->first) ==
+          restoreOrder.end())
+      {
+         restoreOrder.push_back(it->first);
+      }
+   }
+
+   // warm the object files with advisory readahead in restore order so
+   // both first-touch loads and the idle-time materialization sweep run
+   // against a hot page cache (sequential large reads rather than the
+   // interleaved small reads R's unserialize would otherwise issue)
+   std::vector<FilePath> readaheadFiles;
+   for (std::vector<std::string>::const_iterator it = restoreOrder.begin();
+        it != restoreOrder.end();
+        ++it)
+   {
+      std::map<std::string, std::string>::const_iterator itIndex =
+                                                         index.find(*it);
+      if (itIndex != index.end())
+         readaheadFiles.push_back(cacheDir.complete(itIndex->second));
+   }
+   beginFileReadahead(readaheadFiles);
+
+   int maxFileId = -1;
+   int generation = 0;
+   for (std::vector<std::string>::const_iterator it = restoreOrder.begin();
+        it != restoreOrder.end();
+        ++it)
+   {
+      const std::string& name = *it;
+      std::map<std::string, std::string>::const_iterator itIndex =
+                                                         index.find(name);
+      if (itIndex == index.end())
+         continue;
+
+      FilePath objectFile = cacheDir.complete(itIndex->second);
+      if (!objectFile.exists())
+      {
+         LOG_WARNING_MESSAGE("environment cache file not found: " +
+                             objectFile.absolutePath());
+         continue;
+      }
+
+      // install a lazy binding rather than loading the object now: the
+      // console becomes available immediately and each object is loaded
+      // the moment it is touched (anything not touched is materialized
+      // during idle time, most recently used first)
+      error = RFunction(".rs.lazyRestoreObject",
+                        name,
+                        objectFile.absolutePath()).call();
+      if (error)
+      {
+         reportRestoreError("restoring global object " + name,
+                            error,
+                            ERROR_LOCATION);
+         continue;
+      }
+
+      // record the cache entry; an unforced binding is backed verbatim
+      // by its file so the next suspend can reuse it directly
+      CachedObject object;
+      object.file = itIndex->second;
+      object.lazy = true;
+      object.generation = generation--;
+      s_environmentCache[name] = object;
+
+      s_pendingRestoreObjects.push_back(name);
+
+      // keep the file id sequence ahead of existing files
+      if (boost::algorithm::starts_with(itIndex->second, "obj_"))
+      {
+         int fileId = safe_convert::stringTo<int>(itIndex->second.substr(4),
+                                                  -1);
+         maxFileId = std::max(maxFileId, fileId);
+      }
+   }
+   s_nextCacheFileId = maxFileId + 1;
+   s_cacheGeneration = 0;
+
+   return Success();
+}
+
+// record the stamp for a just-materialized lazy binding so the next
+// suspend can reuse the object's existing file if it remains unchanged
+void stampRestoredObject(const std::string& name)
+{
+   SEXP valueSEXP = r::sexp::findVar(name, R_GlobalEnv);
+   if (valueSEXP != R_UnboundValue && TYPEOF(valueSEXP) == PROMSXP)
+      valueSEXP = PRVALUE(valueSEXP);
+   if (valueSEXP == R_UnboundValue)
+      return;
+
+   std::map<std::string, CachedObject>::iterator it =
+                                             s_environmentCache.find(name);
+   if (it == s_environmentCache.end())
+      return;
+
+   CachedObject& object = it->second;
+   object.stamp = objectStamp(valueSEXP);
+   int budget = kCacheableCheckBudget;
+   object.cacheable = isCacheableObject(valueSEXP, &budget);
+   object.lazy = false;
+}
+
 bool isPackage(const std::string& elementName, std::string* pPackageName)
 {
    std::string packagePrefix("package:");
@@ -199,7 +636,131 @@ void loadPackage(const std::string& packageName, const std::string& path)
    }
 }
    
-void attachEnvironmentData(const FilePath& dataFilePath, 
+// Parallel package prefetch ----
+//
+// packages must be re-attached serially (attach order is part of R's
+// semantics) but on cold caches -- NFS home directories especially --
+// most of the restore wall time is spent faulting in each package's DLL
+// and lazy-load databases. before the sequential attach loop we warm
+// those files with a few concurrent readahead threads so the attach
+// runs against a hot page cache. the readahead is purely advisory: the
+// attach loop never waits on it, and loads that outrun it just read
+// from disk as before
+
+const std::size_t kMaxPrefetchThreads = 4;
+
+void prefetchFile(const FilePath& filePath)
+{
+   if (!filePath.exists())
+      return;
+
+   boost::shared_ptr<std::istream> pIfs;
+   Error error = filePath.open_r(&pIfs);
+   if (error)
+      return;
+
+   try
+   {
+      char buffer[65536];
+      while (pIfs->read(buffer, sizeof(buffer)))
+      {
+      }
+   }
+   catch(...)
+   {
+   }
+}
+
+void prefetchPackage(const std::string& name, const FilePath& packagePath)
+{
+   // namespace + metadata consulted by loadNamespace
+   prefetchFile(packagePath.childPath("DESCRIPTION"));
+   prefetchFile(packagePath.childPath("NAMESPACE"));
+   prefetchFile(packagePath.childPath("Meta/package.rds"));
+   prefetchFile(packagePath.childPath("Meta/nsInfo.rds"));
+
+   // lazy-load databases
+   prefetchFile(packagePath.childPath("R/" + name + ".rdx"));
+   prefetchFile(packagePath.childPath("R/" + name + ".rdb"));
+   prefetchFile(packagePath.childPath("data/Rdata.rdx"));
+   prefetchFile(packagePath.childPath("data/Rdata.rdb"));
+
+   // native libraries (file names can be decorated so just walk the
+   // libs directory rather than guessing)
+   std::vector<FilePath> libFiles;
+   Error error = packagePath.childPath("libs").children(&libFiles);
+   if (error)
+      return;
+   for (std::size_t i = 0; i < libFiles.size(); i++)
+   {
+      if (!libFiles[i].isDirectory())
+         prefetchFile(libFiles[i]);
+   }
+}
+
+// executed on a background thread (filesystem reads only -- never
+// touches the R runtime). each thread takes a strided slice so the
+// packages attached first are also warmed first
+void prefetchPackageSlice(
+               std::vector<std::pair<std::string, FilePath> > packages,
+               std::size_t offset,
+               std::size_t stride)
+{
+   try
+   {
+      for (std::size_t i = offset; i < packages.size(); i += stride)
+         prefetchPackage(packages[i].first, packages[i].second);
+   }
+   catch(...)
+   {
+   }
+}
+
+void beginPackagePrefetch(
+         const std::vector<std::pair<std::string, FilePath> >& packages)
+{
+   std::size_t numThreads = std::min(kMaxPrefetchThreads, packages.size());
+   for (std::size_t i = 0; i < numThreads; i++)
+   {
+      core::thread::safeLaunchThread(boost::bind(prefetchPackageSlice,
+                                                 packages,
+                                                 i,
+                                                 numThreads));
+   }
+}
+
+// executed on a background thread (filesystem reads only)
+void prefetchFileSlice(std::vector<FilePath> filePaths,
+                       std::size_t offset,
+                       std::size_t stride)
+{
+   try
+   {
+      for (std::size_t i = offset; i < filePaths.size(); i += stride)
+         prefetchFile(filePaths[i]);
+   }
+   catch(...)
+   {
+   }
+}
+
+// advisory readahead over an explicit list of files (used to warm the
+// workspace image ahead of the R-side loads). threads take strided
+// slices so the files listed first are also warmed first
+void beginFileReadahead(const std::vector<FilePath>& filePaths)
+{
+   std::size_t numThreads = std::min(kMaxPrefetchThreads,
+                                     filePaths.size());
+   for (std::size_t i = 0; i < numThreads; i++)
+   {
+      core::thread::safeLaunchThread(boost::bind(prefetchFileSlice,
+                                                 filePaths,
+                                                 i,
+                                                 numThreads));
+   }
+}
+
+void attachEnvironmentData(const FilePath& dataFilePath,
                            const std::string& name)
 {
    if (dataFilePath.exists())
@@ -229,11 +790,10 @@ void attachEnvironmentData(const FilePath& dataFilePath,
 Error save(const FilePath& statePath)
 {
    // save the global environment
-   FilePath environmentFile = statePath.complete(kEnvironmentFile);
-   Error error = saveGlobalEnvironmentToFile(environmentFile);
+   Error error = saveGlobalEnvironmentIncrementally(statePath);
    if (error)
       return error;
-   
+
    // reset the contents of the search path dir
    FilePath searchPathDir = statePath.complete(kSearchPathDir);
    error = searchPathDir.resetDirectory();
@@ -322,8 +882,7 @@ Error save(const FilePath& statePath)
 
 Error saveGlobalEnvironment(const FilePath& statePath)
 {
-   FilePath environmentFile = statePath.complete(kEnvironmentFile);
-   return saveGlobalEnvironmentToFile(environmentFile);
+   return saveGlobalEnvironmentIncrementally(statePath);
 }
 
 Error restoreSearchPath(const FilePath& statePath)
@@ -364,8 +923,27 @@ Error restoreSearchPath(const FilePath& statePath)
    if (error)
       return error;
    
-   // iterate though the saved list in reverse, loading packages and 
-   // environments saved in external data files as necessary. note that 
+   // warm the packages we're about to attach with concurrent readahead
+   // threads, in attach order (the saved element list resolved the
+   // attach order and package locations at suspend time so no lookups
+   // are needed here)
+   std::vector<std::pair<std::string, FilePath> > prefetchPackages;
+   for (int i = (savedSearchPathList.size() - 2); i > 0; i--)
+   {
+      std::string packageName;
+      if (isPackage(savedSearchPathList[i], &packageName) &&
+          !packageIsLoaded(packageName, currentSearchPathList) &&
+          !packagePaths[packageName].empty())
+      {
+         prefetchPackages.push_back(std::make_pair(
+                           packageName, FilePath(packagePaths[packageName])));
+      }
+   }
+   if (!prefetchPackages.empty())
+      beginPackagePrefetch(prefetchPackages);
+
+   // iterate though the saved list in reverse, loading packages and
+   // environments saved in external data files as necessary. note that
    // this excludes the first and last entries in the list (.GlobalEnv and
    // package:base respectively)
    FilePath environmentDataPath = searchPathDir.complete(kEnvDataDir);
@@ -401,9 +979,20 @@ Error restoreSearchPath(const FilePath& statePath)
 
 Error restore(const FilePath& statePath, bool isCompatibleSessionState)
 {
-   // restore global environment
-   FilePath environmentFile = statePath.complete(kEnvironmentFile);
-   Error error = restoreGlobalEnvironment(environmentFile);
+   // restore the global environment -- prefer the incremental cache,
+   // falling back to the monolithic environment file written by older
+   // versions
+   Error error;
+   FilePath cacheDir = statePath.complete(kEnvironmentCacheDir);
+   if (cacheDir.complete(kEnvironmentCacheIndex).exists())
+   {
+      error = restoreGlobalEnvironmentFromCache(cacheDir);
+   }
+   else
+   {
+      FilePath environmentFile = statePath.complete(kEnvironmentFile);
+      error = restoreGlobalEnvironment(environmentFile);
+   }
    if (error)
       return error;
    
@@ -421,6 +1010,53 @@ Error restore(const FilePath& statePath, bool isCompatibleSessionState)
 }
    
 } // namespace search_path
+
+bool hasPendingGlobalObjects()
+{
+   return !search_path::s_pendingRestoreObjects.empty();
+}
+
+bool forceNextPendingGlobalObject()
+{
+   using namespace search_path;
+
+   while (!s_pendingRestoreObjects.empty())
+   {
+      std::string name = s_pendingRestoreObjects.front();
+      s_pendingRestoreObjects.pop_front();
+
+      // the user may have already replaced or removed the binding --
+      // nothing to do in that case
+      SEXP valueSEXP = r::sexp::findVar(name, R_GlobalEnv);
+      if (valueSEXP == R_UnboundValue || TYPEOF(valueSEXP) != PROMSXP)
+         continue;
+
+      // already forced on demand? just record its stamp
+      if (PRVALUE(valueSEXP) != R_UnboundValue)
+      {
+         stampRestoredObject(name);
+         continue;
+      }
+
+      Error error = RFunction(".rs.forceGlobalObject", name).call();
+      if (error)
+      {
+         reportRestoreError("restoring global object " + name,
+                            error,
+                            ERROR_LOCATION);
+         continue;
+      }
+
+      // stamp the materialized value so the next suspend can reuse
+      // the object's existing file
+      stampRestoredObject(name);
+
+      return !s_pendingRestoreObjects.empty();
+   }
+
+   return false;
+}
+
 } // namespace session
 } // namespace r
 } // namespace rstudio
@@ -34,6 +34,15 @@ namespace rstudio {
 namespace r {
 namespace session {
 namespace graphics {
+
+namespace {
+
+// maximum number of cached renderings (per plot) kept for sizes other
+// than the current one -- beyond this the least recently used entry
+// (and its files) are evicted
+const std::size_t kMaxCachedRenderings = 4;
+
+} // anonymous namespace
       
 Plot::Plot(const GraphicsDeviceFunctions& graphicsDevice,
            const FilePath& baseDirPath,
@@ -121,37 +130,59 @@ void Plot::saveManipulator() const
    
 Error Plot::renderFromDisplay()
 {
-   // we can use our cached representation if we don't need an update and our 
+   // we can use our cached representation if we don't need an update and our
    // rendered size is the same as the current graphics device size
    if ( !needsUpdate_ &&
         (renderedSize() == graphicsDevice_.displaySize()) )
    {
       return Success();
    }
-   
+
+   bool cachedCurrent = false;
+   if (!needsUpdate_)
+   {
+      // only the size changed, so the current rendering remains valid
+      // at its own size -- move it into the render cache rather than
+      // deleting it, and serve an existing rendering for the new size
+      // if we have one (resizes commonly revisit recent sizes, and
+      // replaying the display list through the shadow device can take
+      // seconds for complex plots)
+      cacheCurrentRendering();
+      cachedCurrent = true;
+      if (restoreCachedRendering(graphicsDevice_.displaySize()))
+         return Success();
+   }
+   else
+   {
+      // the plot itself changed -- renderings at other sizes are stale
+      purgeRenderCache();
+   }
+
    // generate a new storage uuid
    std::string storageUuid = core::system::generateUuid();
-   
+
    // generate snapshot and image files
    Error error = graphicsDevice_.saveSnapshot(snapshotFilePath(storageUuid),
                                               imageFilePath(storageUuid));
    if (error)
       return Error(errc::PlotRenderingError, error, ERROR_LOCATION);
-   
+
    // save rendered size
    renderedSize_ = graphicsDevice_.displaySize();
-   
+
    // save manipulator (if any)
    saveManipulator(storageUuid);
 
-   // delete existing files (if any)
-   Error removeError = removeFiles();
-        
+   // delete existing files unless they were moved to the render cache
+   Error removeError = Success();
+   if (!cachedCurrent)
+      removeError = removeFiles(storageUuid_);
+
    // update state
    storageUuid_ = storageUuid;
    needsUpdate_ = false;
-   
-   // return error status 
+
+   // return error status
    return removeError;
 }
    
@@ -220,15 +251,22 @@ Error Plot::renderToDisplay()
 }
    
 Error Plot::removeFiles()
+{
+   // remove cached renderings along with the active one
+   purgeRenderCache();
+   return removeFiles(storageUuid_);
+}
+
+Error Plot::removeFiles(const std::string& storageUuid)
 {
    // bail if we don't have any storage
-   if (storageUuid_.empty())
+   if (storageUuid.empty())
       return Success();
-   
-   Error snapshotError = snapshotFilePath(storageUuid_).removeIfExists();
-   Error imageError = imageFilePath(storageUuid_).removeIfExists();
-   Error manipulatorError = manipulatorFilePath(storageUuid_).removeIfExists();
-   
+
+   Error snapshotError = snapshotFilePath(storageUuid).removeIfExists();
+   Error imageError = imageFilePath(storageUuid).removeIfExists();
+   Error manipulatorError = manipulatorFilePath(storageUuid).removeIfExists();
+
    if (snapshotError)
       return Error(errc::PlotFileError, snapshotError, ERROR_LOCATION);
    else if (imageError)
@@ -239,6 +277,82 @@ Error Plot::removeFiles()
       return Success();
 }
 
+// move the current rendering into the render cache, evicting the least
+// recently used entry (and its files) when the cache is full
+void Plot::cacheCurrentRendering()
+{
+   if (storageUuid_.empty())
+      return;
+
+   // drop any stale entry for the same size
+   for (RenderCache::iterator it = renderCache_.begin();
+        it != renderCache_.end();
+        ++it)
+   {
+      if (it->first == renderedSize_)
+      {
+         Error error = removeFiles(it->second);
+         if (error)
+            LOG_ERROR(error);
+         renderCache_.erase(it);
+         break;
+      }
+   }
+
+   renderCache_.push_front(std::make_pair(renderedSize_, storageUuid_));
+
+   while (renderCache_.size() > kMaxCachedRenderings)
+   {
+      Error error = removeFiles(renderCache_.back().second);
+      if (error)
+         LOG_ERROR(error);
+      renderCache_.pop_back();
+   }
+}
+
+// make a cached rendering for the specified size current (if one
+// exists). the entry leaves the cache so that the cache never aliases
+// the active rendering
+bool Plot::restoreCachedRendering(const DisplaySize& size)
+{
+   for (RenderCache::iterator it = renderCache_.begin();
+        it != renderCache_.end();
+        ++it)
+   {
+      if (it->first == size)
+      {
+         // entries can be removed out from under us (e.g. the graphics
+         // path was blown away) -- fall back to a fresh render
+         if (!snapshotFilePath(it->second).exists() ||
+             !imageFilePath(it->second).exists())
+         {
+            renderCache_.erase(it);
+            return false;
+         }
+
+         storageUuid_ = it->second;
+         renderedSize_ = it->first;
+         renderCache_.erase(it);
+         return true;
+      }
+   }
+
+   return false;
+}
+
+void Plot::purgeRenderCache()
+{
+   for (RenderCache::iterator it = renderCache_.begin();
+        it != renderCache_.end();
+        ++it)
+   {
+      Error error = removeFiles(it->second);
+      if (error)
+         LOG_ERROR(error);
+   }
+   renderCache_.clear();
+}
+
 void Plot::purgeInMemoryResources()
 {
    manipulator_.clear();
@@ -17,6 +17,8 @@
 #define R_SESSION_GRAPHICS_PLOT_HPP
 
 #include <string>
+#include <list>
+#include <utility>
 
 #include <boost/utility.hpp>
 
@@ -74,10 +76,17 @@ public:
    core::Error removeFiles();
 
    void purgeInMemoryResources();
-   
+   void purgeRenderCache();
+
 private:
    bool hasStorage() const;
 
+   core::Error removeFiles(const std::string& storageUuid);
+
+   // render cache (previous renderings of this plot at other sizes)
+   void cacheCurrentRendering();
+   bool restoreCachedRendering(const DisplaySize& size);
+
    core::FilePath snapshotFilePath() const ;
    core::FilePath snapshotFilePath(const std::string& storageUuid) const;
    core::FilePath imageFilePath(const std::string& storageUuid) const;
@@ -94,6 +103,13 @@ private:
    DisplaySize renderedSize_ ;
    bool needsUpdate_;
 
+   // renderings of this plot at other sizes, most recently used first.
+   // revisiting a cached size (e.g. dragging a splitter back and forth)
+   // serves the existing image rather than replaying the display list.
+   // NOTE: never contains the active rendering (storageUuid_)
+   typedef std::list<std::pair<DisplaySize, std::string> > RenderCache;
+   RenderCache renderCache_;
+
    // manipulator and protection scope for it
    mutable PlotManipulator manipulator_;
 };
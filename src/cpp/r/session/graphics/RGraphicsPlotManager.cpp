@@ -703,6 +703,15 @@ Error copyDirectory(const FilePath& srcDir, const FilePath& targetDir)
 
 Error PlotManager::serialize(const FilePath& saveToPath)
 {
+   // drop cached renderings -- only each plot's live rendering is
+   // referenced by the persisted state
+   for (boost::circular_buffer<PtrPlot>::const_iterator it = plots_.begin();
+        it != plots_.end();
+        ++it)
+   {
+      (*it)->purgeRenderCache();
+   }
+
    // save plots state
    Error error = savePlotsState();
    if (error)
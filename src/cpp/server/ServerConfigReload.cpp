@@ -0,0 +1,229 @@
+/*
+ * ServerConfigReload.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "ServerConfigReload.hpp"
+
+#include <iostream>
+#include <vector>
+
+#include <boost/algorithm/string/join.hpp>
+#include <boost/foreach.hpp>
+#include <boost/program_options.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <core/Error.hpp>
+#include <core/FilePath.hpp>
+#include <core/Log.hpp>
+#include <core/SafeConvert.hpp>
+
+#include <core/http/LocalStreamBlockingClient.hpp>
+#include <core/http/Request.hpp>
+#include <core/http/Response.hpp>
+
+#include <core/json/Json.hpp>
+
+#include <session/SessionConstants.hpp>
+#include <session/SessionLocalStreams.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace server {
+namespace config_reload {
+
+namespace {
+
+// location of the session configuration file
+const char * const kSessionConfigFile = "/etc/rstudio/rsession.conf";
+
+// the subset of rsession.conf options which sessions can apply in place
+// (keep in sync with Options::applyReloadableOption on the session side)
+const char * const kReloadableSessionOptions[] = {
+   kTimeoutSessionOption,
+   kDisconnectedTimeoutSessionOption,
+   "limit-file-upload-size-mb",
+   "limit-cpu-time-minutes",
+   "memory-target-mb",
+   kWebSocketPingInterval,
+   kWebSocketConnectTimeout
+};
+
+// read the values of the reloadable options currently present in
+// rsession.conf (options not present in the file are left alone -- we
+// can't distinguish "removed" from "never set" without re-deriving
+// defaults, and sessions already hold the default in that case)
+Error readReloadableSessionOptions(json::Object* pOptionsJson)
+{
+   namespace po = boost::program_options;
+
+   FilePath configFilePath(kSessionConfigFile);
+   if (!configFilePath.exists())
+      return Success();
+
+   boost::shared_ptr<std::istream> pIfs;
+   Error error = configFilePath.open_r(&pIfs);
+   if (error)
+      return error;
+
+   po::options_description reloadableDesc("reloadable");
+   std::size_t numOptions = sizeof(kReloadableSessionOptions) /
+                            sizeof(kReloadableSessionOptions[0]);
+   for (std::size_t i = 0; i < numOptions; i++)
+   {
+      reloadableDesc.add_options()
+         (kReloadableSessionOptions[i], po::value<std::string>(), "");
+   }
+
+   try
+   {
+      // parse the config file, ignoring everything but the options above
+      po::variables_map vm;
+      po::store(po::parse_config_file(*pIfs, reloadableDesc, true), vm);
+      po::notify(vm);
+
+      for (std::size_t i = 0; i < numOptions; i++)
+      {
+         if (vm.count(kReloadableSessionOptions[i]) > 0)
+         {
+            (*pOptionsJson)[kReloadableSessionOptions[i]] =
+                  vm[kReloadableSessionOptions[i]].as<std::string>();
+         }
+      }
+   }
+   catch(const std::exception& e)
+   {
+      error = systemError(boost::system::errc::protocol_error,
+                          ERROR_LOCATION);
+      error.addProperty("config-file", kSessionConfigFile);
+      error.addProperty("description", e.what());
+      return error;
+   }
+
+   return Success();
+}
+
+// push the changed options to a single session over its local stream;
+// returns the options the session reported as requiring a restart
+Error pushOptionsToSession(const FilePath& streamPath,
+                           const json::Object& optionsJson,
+                           std::vector<std::string>* pRestartRequired)
+{
+   // build the reload_options rpc request
+   json::Array paramsJson;
+   paramsJson.push_back(optionsJson);
+   json::Object requestJson;
+   requestJson["method"] = std::string(kReloadOptions);
+   requestJson["params"] = paramsJson;
+
+   http::Request request;
+   request.setMethod("POST");
+   request.setUri("/rpc/" + std::string(kReloadOptions));
+   request.setHeader("Connection", "close");
+   request.setBody(json::write(requestJson));
+
+   http::Response response;
+   Error error = http::sendRequest(streamPath, request, &response);
+   if (error)
+      return error;
+
+   // collect the options the session couldn't apply in place
+   json::Value responseJson;
+   if (!json::parse(response.body(), &responseJson) ||
+       !json::isType<json::Object>(responseJson))
+   {
+      error = systemError(boost::system::errc::protocol_error,
+                          ERROR_LOCATION);
+      error.addProperty("body", response.body());
+      return error;
+   }
+
+   json::Object& resultJson = responseJson.get_obj();
+   if (json::isType<json::Object>(resultJson["result"]))
+   {
+      json::Object& fieldsJson = resultJson["result"].get_obj();
+      if (json::isType<json::Array>(fieldsJson["restart_required"]))
+      {
+         BOOST_FOREACH(const json::Value& nameJson,
+                       fieldsJson["restart_required"].get_array())
+         {
+            if (json::isType<std::string>(nameJson))
+               pRestartRequired->push_back(nameJson.get_str());
+         }
+      }
+   }
+
+   return Success();
+}
+
+} // anonymous namespace
+
+void reloadSessionConfiguration()
+{
+   // re-read the reloadable option values
+   json::Object optionsJson;
+   Error error = readReloadableSessionOptions(&optionsJson);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+   if (optionsJson.empty())
+   {
+      LOG_INFO_MESSAGE("Config reload requested but " +
+                       std::string(kSessionConfigFile) +
+                       " sets no reloadable options");
+      return;
+   }
+
+   // push them to each running session (one stream file per session)
+   std::vector<FilePath> streamPaths;
+   error = FilePath(kSessionLocalStreamsDir).children(&streamPaths);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   int numSessions = 0;
+   BOOST_FOREACH(const FilePath& streamPath, streamPaths)
+   {
+      std::vector<std::string> restartRequired;
+      error = pushOptionsToSession(streamPath, optionsJson, &restartRequired);
+      if (error)
+      {
+         // sessions can exit between enumeration and push -- log and
+         // continue so one dead stream doesn't block the rollout
+         error.addProperty("stream", streamPath.absolutePath());
+         LOG_ERROR(error);
+         continue;
+      }
+
+      numSessions++;
+      if (!restartRequired.empty())
+      {
+         LOG_WARNING_MESSAGE(
+            "Session " + streamPath.filename() + " requires a restart to "
+            "apply: " + boost::algorithm::join(restartRequired, ", "));
+      }
+   }
+
+   LOG_INFO_MESSAGE("Pushed reloadable config to " +
+                    safe_convert::numberToString(numSessions) +
+                    " running session(s)");
+}
+
+} // namespace config_reload
+} // namespace server
+} // namespace rstudio
@@ -0,0 +1,33 @@
+/*
+ * ServerConfigReload.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SERVER_CONFIG_RELOAD_HPP
+#define SERVER_CONFIG_RELOAD_HPP
+
+namespace rstudio {
+namespace server {
+namespace config_reload {
+
+// re-read the reloadable subset of rsession.conf and push the values to
+// all running sessions (invoked on SIGHUP). sessions apply what they can
+// in place and report back which options require a restart; those are
+// logged rather than forcing a fleet-wide suspend/resume cycle
+void reloadSessionConfiguration();
+
+} // namespace config_reload
+} // namespace server
+} // namespace rstudio
+
+#endif // SERVER_CONFIG_RELOAD_HPP
@@ -17,8 +17,12 @@
 #include <pthread.h>
 #include <signal.h>
 
+#include <algorithm>
+
 #include <core/Error.hpp>
 #include <core/LogWriter.hpp>
+#include <core/PerformanceMetrics.hpp>
+#include <core/PeriodicCommand.hpp>
 #include <core/ProgramStatus.hpp>
 #include <core/ProgramOptions.hpp>
 
@@ -54,12 +58,16 @@
 #include "ServerAddins.hpp"
 #include "ServerAppArmor.hpp"
 #include "ServerBrowser.hpp"
+#include "ServerConfigReload.hpp"
 #include "ServerEval.hpp"
 #include "ServerInit.hpp"
 #include "ServerMeta.hpp"
 #include "ServerOffline.hpp"
 #include "ServerPAMAuth.hpp"
 #include "ServerREnvironment.hpp"
+#include "ServerSessionCgroups.hpp"
+#include "ServerSessionGovernor.hpp"
+#include "ServerSessionRouting.hpp"
 
 using namespace rstudio;
 using namespace rstudio::core;
@@ -136,6 +144,17 @@ auth::SecureAsyncUriHandlerFunction secureAsyncFileHandler()
    return boost::bind(asyncFileHandler, _2);
 }
 
+// serve the latency histograms accumulated by this process in the
+// prometheus text exposition format
+void handleMetricsRequest(const std::string& /*username*/,
+                          const http::Request& /*request*/,
+                          http::Response* pResponse)
+{
+   pResponse->setNoCacheHeaders();
+   pResponse->setContentType("text/plain");
+   pResponse->setBody(performance::metricsAsText());
+}
+
 // http server
 boost::shared_ptr<http::AsyncServer> s_pHttpServer;
 
@@ -148,24 +167,49 @@ Error httpServerInit()
    s_pHttpServer->setScheduledCommandInterval(
                                     boost::posix_time::milliseconds(500));
 
+   // give bulk transfers a bounded share of the worker pool so that a
+   // handful of users downloading large files can't starve interactive
+   // rpc for everyone (event streams are unlimited -- they occupy no
+   // worker thread while waiting)
+   int threadPoolSize = server::options().wwwThreadPoolSize();
+   s_pHttpServer->setRequestClassLimit(
+                     http::BulkClass,
+                     std::max<std::size_t>(1, threadPoolSize / 2));
+
    // initialize
    return server::httpServerInit(s_pHttpServer.get());
 }
 
+bool evictIdleSymbolMaps()
+{
+   gwt::evictIdleSymbolMaps();
+   return true;
+}
+
 void httpServerAddHandlers()
 {
    // establish json-rpc handlers
    using namespace server::auth;
    using namespace server::session_proxy;
    uri_handlers::add("/rpc", secureAsyncJsonRpcHandler(proxyRpcRequest));
-   uri_handlers::add("/events", secureAsyncJsonRpcHandler(proxyEventsRequest));
+   uri_handlers::add("/events",
+                     secureAsyncJsonRpcHandler(proxyEventsRequest),
+                     http::EventStreamClass);
 
-   // establish content handlers
+   // establish content handlers (bulk transfers are dispatched in the
+   // BulkClass so they can't starve interactive rpc -- see
+   // setRequestClassLimit in httpServerInit)
    uri_handlers::add("/graphics", secureAsyncHttpHandler(proxyContentRequest));
-   uri_handlers::add("/upload", secureAsyncUploadHandler(proxyContentRequest));
-   uri_handlers::add("/export", secureAsyncHttpHandler(proxyContentRequest));
+   uri_handlers::add("/upload",
+                     secureAsyncUploadHandler(proxyContentRequest),
+                     http::BulkClass);
+   uri_handlers::add("/export",
+                     secureAsyncHttpHandler(proxyContentRequest),
+                     http::BulkClass);
    uri_handlers::add("/source", secureAsyncHttpHandler(proxyContentRequest));
-   uri_handlers::add("/content", secureAsyncHttpHandler(proxyContentRequest));
+   uri_handlers::add("/content",
+                     secureAsyncHttpHandler(proxyContentRequest),
+                     http::BulkClass);
    uri_handlers::add("/diff", secureAsyncHttpHandler(proxyContentRequest));
    uri_handlers::add("/file_show", secureAsyncHttpHandler(proxyContentRequest));
    uri_handlers::add("/view_pdf", secureAsyncHttpHandler(proxyContentRequest));
@@ -201,6 +245,9 @@ void httpServerAddHandlers()
    // establish meta
    uri_handlers::addBlocking("/meta", secureJsonRpcHandler(meta::handleMetaRequest));
 
+   // establish metrics handler
+   uri_handlers::addBlocking("/metrics", secureHttpHandler(handleMetricsRequest));
+
    // establish progress handler
    FilePath wwwPath(server::options().wwwLocalPath());
    FilePath progressPagePath = wwwPath.complete("progress.htm");
@@ -220,6 +267,13 @@ void httpServerAddHandlers()
    // initialize gwt symbol maps
    gwt::initializeSymbolMaps(server::options().wwwSymbolMapsPath());
 
+   // periodically release symbol map state for permutations that are
+   // no longer reporting errors
+   scheduler::addCommand(
+      boost::shared_ptr<ScheduledCommand>(new PeriodicCommand(
+         boost::posix_time::minutes(5), evictIdleSymbolMaps, false))
+   );
+
    // add default handler for gwt app
    uri_handlers::setBlockingDefault(blockingFileHandler());
 }
@@ -249,6 +303,7 @@ Error waitForSignals()
    sigset_t wait_mask;
    sigemptyset(&wait_mask);
    sigaddset(&wait_mask, SIGCHLD);
+   sigaddset(&wait_mask, SIGHUP);
    sigaddset(&wait_mask, SIGINT);
    sigaddset(&wait_mask, SIGQUIT);
    sigaddset(&wait_mask, SIGTERM);
@@ -271,6 +326,12 @@ Error waitForSignals()
          sessionManager().notifySIGCHLD();
       }
 
+      // SIGHUP: push reloadable config changes to running sessions
+      else if (sig == SIGHUP)
+      {
+         config_reload::reloadSessionConfiguration();
+      }
+
       // SIGINT, SIGQUIT, SIGTERM
       else if (sig == SIGINT || sig == SIGQUIT || sig == SIGTERM)
       {
@@ -324,6 +385,13 @@ void add(const std::string& prefix,
    s_pHttpServer->addHandler(prefix, handler);
 }
 
+void add(const std::string& prefix,
+         const http::AsyncUriHandlerFunction& handler,
+         http::RequestClass requestClass)
+{
+   s_pHttpServer->addHandler(prefix, handler, requestClass);
+}
+
 void addProxyHandler(const std::string& prefix,
                      const http::AsyncUriHandlerFunction& handler)
 {
@@ -461,16 +529,41 @@ int main(int argc, char * const argv[])
       if (error)
          return core::system::exitFailure(error, ERROR_LOCATION);
 
+      // initialize multi-node session routing (no-op unless configured;
+      // needs to happen post http server init for access to the scheduled
+      // command list)
+      error = session_routing::initialize();
+      if (error)
+         return core::system::exitFailure(error, ERROR_LOCATION);
+
       // initialize monitor (needs to happen post http server init for access
       // to the server's io service)
       monitor::initializeMonitorClient(kMonitorSocketPath,
                                        server::options().monitorSharedSecret(),
                                        s_pHttpServer->ioService());
 
+      // provide the session manager with the server's io service so it
+      // can prelaunch sessions at authentication time
+      sessionManager().setIoService(s_pHttpServer->ioService());
+
       // add a monitor log writer
       core::system::addLogWriter(
                 monitor::client().createLogWriter(kProgramIdentity));
 
+      // initialize the session memory governor (no-op unless a limit is
+      // configured; needs to happen post monitor init since it reports
+      // session memory through the monitor)
+      error = session_governor::initialize();
+      if (error)
+         return core::system::exitFailure(error, ERROR_LOCATION);
+
+      // initialize per-user session cgroups (no-op unless resource
+      // isolation is configured; needs to happen post monitor init since
+      // it reports per-session utilization through the monitor)
+      error = session_cgroups::initialize();
+      if (error)
+         return core::system::exitFailure(error, ERROR_LOCATION);
+
       // call overlay initialize
       error = overlay::initialize();
       if (error)
@@ -202,7 +202,25 @@ ProgramStatus Options::read(int argc,
          "is app armor enabled for this session")
       ("server-set-umask",
          value<bool>(&serverSetUmask_)->default_value(1),
-         "set the umask to 022 on startup");
+         "set the umask to 022 on startup")
+      ("server-node-address",
+         value<std::string>(&serverNodeAddress_)->default_value(""),
+         "address (host:port) of this node as reachable by peer nodes")
+      ("server-shared-storage-path",
+         value<std::string>(&serverSharedStoragePath_)->default_value(""),
+         "path to storage shared by all nodes")
+      ("server-session-memory-limit-mb",
+         value<int>(&serverSessionMemoryLimitMb_)->default_value(0),
+         "aggregate session memory (in MB) at which idle sessions are "
+         "asked to suspend (0 to disable)")
+      ("server-session-cpu-weight",
+         value<int>(&serverSessionCpuWeight_)->default_value(0),
+         "cgroup v2 cpu.weight applied to each user's sessions "
+         "(1-10000, 0 to disable)")
+      ("server-session-io-max",
+         value<std::string>(&serverSessionIoMax_)->default_value(""),
+         "cgroup v2 io.max limit applied to each user's sessions "
+         "(e.g. \"8:0 rbps=52428800 wbps=52428800\", empty for none)");
 
    // www - web server options
    options_description www("www") ;
@@ -14,7 +14,14 @@
  */
 #include "ServerPAMAuth.hpp"
 
+#include <map>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
 #include <core/Error.hpp>
+#include <core/Hash.hpp>
 #include <core/PeriodicCommand.hpp>
 #include <core/Thread.hpp>
 #include <core/system/Process.hpp>
@@ -39,6 +46,8 @@
 #include <server/auth/ServerAuthHandler.hpp>
 
 #include <server/ServerOptions.hpp>
+#include <server/ServerProcessSupervisor.hpp>
+#include <server/ServerSessionManager.hpp>
 #include <server/ServerUriHandlers.hpp>
 #include <server/ServerSessionProxy.hpp>
 
@@ -309,9 +318,197 @@ void setSignInCookies(const core::http::Request& request,
    auth::csrf::setCSRFTokenCookie(request, expiry, "", pResponse);
 }
 
-void doSignIn(const http::Request& request,
-              http::Response* pResponse)
+// short-ttl cache of failed login attempts -- absorbs immediate
+// brute-force retries of the same credentials without burning a PAM
+// conversation (which can take seconds against a directory server)
+const int kFailedLoginCacheSeconds = 10;
+boost::mutex s_failedLoginsMutex;
+std::map<std::string, boost::posix_time::ptime> s_failedLogins;
+
+std::string failedLoginKey(const std::string& username,
+                           const std::string& password)
+{
+   return username + "\n" + core::hash::crc32HexHash(password);
+}
+
+bool recentlyFailedLogin(const std::string& username,
+                         const std::string& password)
+{
+   using namespace boost::posix_time;
+   LOCK_MUTEX(s_failedLoginsMutex)
+   {
+      std::map<std::string, ptime>::iterator it =
+                     s_failedLogins.find(failedLoginKey(username, password));
+      if (it != s_failedLogins.end())
+      {
+         if (microsec_clock::universal_time() <
+             it->second + seconds(kFailedLoginCacheSeconds))
+         {
+            return true;
+         }
+
+         s_failedLogins.erase(it);
+      }
+   }
+   END_LOCK_MUTEX
+   return false;
+}
+
+void registerFailedLogin(const std::string& username,
+                         const std::string& password)
+{
+   using namespace boost::posix_time;
+   LOCK_MUTEX(s_failedLoginsMutex)
+   {
+      // prune expired entries so the cache can't grow without bound
+      // during a login storm
+      ptime now = microsec_clock::universal_time();
+      std::map<std::string, ptime>::iterator it = s_failedLogins.begin();
+      while (it != s_failedLogins.end())
+      {
+         if (now >= it->second + seconds(kFailedLoginCacheSeconds))
+            s_failedLogins.erase(it++);
+         else
+            ++it;
+      }
+
+      s_failedLogins[failedLoginKey(username, password)] = now;
+   }
+   END_LOCK_MUTEX
+}
+
+void clearFailedLogin(const std::string& username,
+                      const std::string& password)
+{
+   LOCK_MUTEX(s_failedLoginsMutex)
+   {
+      s_failedLogins.erase(failedLoginKey(username, password));
+   }
+   END_LOCK_MUTEX
+}
+
+void onPamHelperCompleted(const boost::function<void(bool)>& onCompleted,
+                          const core::system::ProcessResult& result)
+{
+   onCompleted(result.exitStatus == 0);
+}
+
+// run the pam helper through the server's process supervisor so the
+// (potentially seconds-long) PAM conversation doesn't tie up an
+// io_service thread
+void pamLoginAsync(const std::string& username,
+                   const std::string& password,
+                   const boost::function<void(bool)>& onCompleted)
+{
+   // get path to pam helper
+   FilePath pamHelperPath(server::options().authPamHelperPath());
+   if (!pamHelperPath.exists())
+   {
+      LOG_ERROR_MESSAGE("PAM helper binary does not exist at " +
+                        pamHelperPath.absolutePath());
+      onCompleted(false);
+      return;
+   }
+
+   // don't try to login with an empty password (this hangs PAM as it waits for input)
+   if (password.empty())
+   {
+      LOG_WARNING_MESSAGE("No PAM password provided for user '" + username + "'; refusing login");
+      onCompleted(false);
+      return;
+   }
+
+   // form args
+   std::vector<std::string> args;
+   args.push_back(username);
+
+   // options (assume priv after fork)
+   core::system::ProcessOptions options;
+   options.onAfterFork = assumeRootPriv;
+
+   Error error = process_supervisor::runProgram(
+                              pamHelperPath.absolutePath(),
+                              args,
+                              password,
+                              options,
+                              boost::bind(onPamHelperCompleted,
+                                          onCompleted,
+                                          _1));
+   if (error)
+   {
+      LOG_ERROR(error);
+      onCompleted(false);
+   }
+}
+
+void completeSignIn(boost::shared_ptr<core::http::AsyncConnection> pConnection,
+                    const std::string& appUri,
+                    const std::string& username,
+                    const std::string& password,
+                    bool persist,
+                    bool authenticated)
+{
+   const http::Request& request = pConnection->request();
+   http::Response* pResponse = &pConnection->response();
+
+   if (authenticated && server::auth::validateUser(username))
+   {
+      clearFailedLogin(username, password);
+
+      std::string targetUri = appUri;
+      if (targetUri.size() > 0 && targetUri[0] != '/')
+         targetUri = "/" + targetUri;
+
+      setSignInCookies(request, username, persist, pResponse);
+      pResponse->setMovedTemporarily(request, targetUri);
+
+      // register login with monitor
+      using namespace monitor;
+      client().logEvent(Event(kAuthScope,
+                              kAuthLoginEvent,
+                              "",
+                              username));
+
+      onUserAuthenticated(username, password);
+
+      // start the user's session now so R initialization overlaps the
+      // redirect back to the application
+      sessionManager().prelaunchSession(username);
+   }
+   else
+   {
+      if (authenticated)
+      {
+         // pam succeeded but the user isn't authorized for this server;
+         // don't negative-cache valid credentials
+      }
+      else
+      {
+         registerFailedLogin(username, password);
+      }
+
+      // register failed login with monitor
+      using namespace monitor;
+      client().logEvent(Event(kAuthScope,
+                              kAuthLoginFailedEvent,
+                              "",
+                              username));
+
+      pResponse->setMovedTemporarily(
+            request,
+            applicationSignInURL(request,
+                                 appUri,
+                                 kErrorInvalidLogin));
+   }
+
+   pConnection->writeResponse();
+}
+
+void doSignIn(boost::shared_ptr<core::http::AsyncConnection> pConnection)
 {
+   const http::Request& request = pConnection->request();
+   http::Response* pResponse = &pConnection->response();
+
    std::string appUri = request.formFieldValue(kAppUri);
    if (appUri.empty())
       appUri = "/";
@@ -335,6 +532,7 @@ void doSignIn(const http::Request& request,
                applicationSignInURL(request,
                                     appUri,
                                     kErrorServer));
+         pConnection->writeResponse();
          return;
       }
 
@@ -347,6 +545,7 @@ void doSignIn(const http::Request& request,
                applicationSignInURL(request,
                                     appUri,
                                     kErrorServer));
+         pConnection->writeResponse();
          return;
       }
 
@@ -366,38 +565,23 @@ void doSignIn(const http::Request& request,
 
    onUserUnauthenticated(username);
 
-   if ( pamLogin(username, password) && server::auth::validateUser(username))
+   // if these exact credentials just failed then reject them without
+   // going back to PAM
+   if (recentlyFailedLogin(username, password))
    {
-      if (appUri.size() > 0 && appUri[0] != '/')
-         appUri = "/" + appUri;
-
-      setSignInCookies(request, username, persist, pResponse);
-      pResponse->setMovedTemporarily(request, appUri);
-
-      // register login with monitor
-      using namespace monitor;
-      client().logEvent(Event(kAuthScope,
-                              kAuthLoginEvent,
-                              "",
-                              username));
-
-      onUserAuthenticated(username, password);
+      completeSignIn(pConnection, appUri, username, password, persist, false);
+      return;
    }
-   else
-   {
-      // register failed login with monitor
-      using namespace monitor;
-      client().logEvent(Event(kAuthScope,
-                              kAuthLoginFailedEvent,
-                              "",
-                              username));
 
-      pResponse->setMovedTemporarily(
-            request,
-            applicationSignInURL(request,
-                                 appUri,
-                                 kErrorInvalidLogin));
-   }
+   pamLoginAsync(username,
+                 password,
+                 boost::bind(completeSignIn,
+                             pConnection,
+                             appUri,
+                             username,
+                             password,
+                             persist,
+                             _1));
 }
 
 void signOut(const http::Request& request,
@@ -491,8 +675,9 @@ Error initialize()
       pamHandler.setSignInCookies = setSignInCookies;
    auth::handler::registerHandler(pamHandler);
 
-   // add pam-specific auth handlers
-   uri_handlers::addBlocking(kDoSignIn, doSignIn);
+   // add pam-specific auth handlers (sign-in is async so the PAM
+   // conversation doesn't occupy a server thread)
+   uri_handlers::add(kDoSignIn, doSignIn);
    uri_handlers::addBlocking(kPublicKey, publicKey);
 
    // initialize overlay
@@ -20,6 +20,8 @@
 #include <core/Thread.hpp>
 #include <core/r_util/REnvironment.hpp>
 
+#include <core/system/System.hpp>
+
 #include <server/ServerOptions.hpp>
 #include <server/ServerUriHandlers.hpp>
 
@@ -46,6 +48,15 @@ core::r_util::RVersion s_rVersion;
 
 bool initialize(std::string* pErrMsg)
 {
+   // enable the persistent store of detection results (probing R spawns
+   // a full R process and the results only change when the installation
+   // does, so restarts can skip the probe entirely)
+   FilePath cacheDir = core::system::effectiveUserIsRoot() ?
+                                 FilePath("/var/lib/rstudio-server") :
+                                 FilePath("/tmp/rstudio-server");
+   r_util::initializeRVersionDetectionCache(
+                                 cacheDir.complete("r-versions-cache"));
+
    // attempt to detect system R version
    bool detected = detectSystemRVersion(&s_rVersion, pErrMsg);
 
@@ -138,7 +149,7 @@ bool detectRVersion(const core::FilePath& rScriptPath,
    std::string rDetectedScriptPath;
    std::string rVersion;
    core::r_util::EnvironmentVars environment;
-   bool result = r_util::detectREnvironment(
+   bool result = r_util::detectREnvironmentCached(
                                      rScriptPath,
                                      rLdScriptPath,
                                      ldLibraryPath,
@@ -0,0 +1,330 @@
+/*
+ * ServerSessionCgroups.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "ServerSessionCgroups.hpp"
+
+#include <unistd.h>
+
+#include <map>
+#include <vector>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/foreach.hpp>
+
+#include <core/Error.hpp>
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/Log.hpp>
+#include <core/PeriodicCommand.hpp>
+#include <core/SafeConvert.hpp>
+
+#include <monitor/MonitorClient.hpp>
+
+#include <server/ServerOptions.hpp>
+#include <server/ServerScheduler.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace server {
+namespace session_cgroups {
+
+namespace {
+
+// mount point of the cgroup v2 unified hierarchy
+const char* const kCgroupRoot = "/sys/fs/cgroup";
+
+// name of our cgroup under the hierarchy root (the root cgroup is the
+// only one allowed to host processes while delegating controllers to
+// children, so sessions are grouped here rather than under the server's
+// own cgroup)
+const char* const kSessionsCgroup = "rstudio-sessions";
+
+// how often we sample per-user cgroup stats for the monitor
+const int kSweepSeconds = 60;
+
+// set after the hierarchy has been prepared successfully
+bool s_enabled = false;
+
+// usage counters from the previous sweep (keyed by username) so cpu
+// and io can be reported as rates rather than raw counters
+struct UserUsage
+{
+   UserUsage() : cpuUsec(0), ioReadBytes(0), ioWriteBytes(0) {}
+
+   double cpuUsec;
+   double ioReadBytes;
+   double ioWriteBytes;
+};
+std::map<std::string,UserUsage> s_lastUsage;
+
+FilePath sessionsCgroupDir()
+{
+   return FilePath(kCgroupRoot).complete(kSessionsCgroup);
+}
+
+// cgroup interface files interpret each write as a command, so a plain
+// truncating write is the correct way to poke them
+Error writeCgroupFile(const FilePath& dir,
+                      const std::string& file,
+                      const std::string& value)
+{
+   return core::writeStringToFile(dir.complete(file), value);
+}
+
+// delegate the cpu, io, and memory controllers (those of them the
+// kernel has available) to the children of the given cgroup
+Error enableControllers(const FilePath& dir)
+{
+   std::string controllers;
+   Error error = core::readStringFromFile(dir.complete("cgroup.controllers"),
+                                          &controllers);
+   if (error)
+      return error;
+
+   std::string enable;
+   const char* const wanted[] = { "cpu", "io", "memory" };
+   for (std::size_t i = 0; i < sizeof(wanted)/sizeof(wanted[0]); i++)
+   {
+      if (controllers.find(wanted[i]) != std::string::npos)
+         enable += std::string(enable.empty() ? "" : " ") + "+" + wanted[i];
+   }
+
+   if (enable.empty())
+      return Success();
+
+   return writeCgroupFile(dir, "cgroup.subtree_control", enable);
+}
+
+// read a single numeric field (e.g. usage_usec from cpu.stat); flat
+// keyed stat files are lines of the form "<key> <value>"
+double statValue(const std::string& contents, const std::string& key)
+{
+   std::vector<std::string> lines;
+   boost::algorithm::split(lines, contents, boost::algorithm::is_any_of("\n"));
+   BOOST_FOREACH(const std::string& line, lines)
+   {
+      if (boost::algorithm::starts_with(line, key + " "))
+         return safe_convert::stringTo<double>(line.substr(key.size() + 1),
+                                               0.0);
+   }
+   return 0.0;
+}
+
+// sum a "<key>=<value>" field across the per-device lines of io.stat
+double ioStatValue(const std::string& contents, const std::string& key)
+{
+   double total = 0.0;
+   std::vector<std::string> lines;
+   boost::algorithm::split(lines, contents, boost::algorithm::is_any_of("\n"));
+   BOOST_FOREACH(const std::string& line, lines)
+   {
+      std::vector<std::string> fields;
+      boost::algorithm::split(fields,
+                              boost::algorithm::trim_copy(line),
+                              boost::algorithm::is_any_of(" "),
+                              boost::algorithm::token_compress_on);
+      BOOST_FOREACH(const std::string& field, fields)
+      {
+         if (boost::algorithm::starts_with(field, key + "="))
+            total += safe_convert::stringTo<double>(
+                                 field.substr(key.size() + 1), 0.0);
+      }
+   }
+   return total;
+}
+
+bool reportCgroupStats()
+{
+   std::vector<FilePath> children;
+   Error error = sessionsCgroupDir().children(&children);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return true;
+   }
+
+   using namespace monitor;
+   std::vector<metrics::MetricData> data;
+
+   BOOST_FOREACH(const FilePath& cgroup, children)
+   {
+      if (!cgroup.isDirectory())
+         continue;
+
+      std::string username = cgroup.filename();
+
+      // reclaim cgroups whose sessions have all exited (a cgroup with
+      // member processes can't be removed, so failure means in-use)
+      std::string procs;
+      if (!core::readStringFromFile(cgroup.complete("cgroup.procs"), &procs) &&
+          boost::algorithm::trim_copy(procs).empty())
+      {
+         if (::rmdir(cgroup.absolutePath().c_str()) == 0)
+         {
+            s_lastUsage.erase(username);
+            continue;
+         }
+      }
+
+      // sample the usage counters
+      UserUsage usage;
+      std::string contents;
+      if (!core::readStringFromFile(cgroup.complete("cpu.stat"), &contents))
+         usage.cpuUsec = statValue(contents, "usage_usec");
+      if (!core::readStringFromFile(cgroup.complete("io.stat"), &contents))
+      {
+         usage.ioReadBytes = ioStatValue(contents, "rbytes");
+         usage.ioWriteBytes = ioStatValue(contents, "wbytes");
+      }
+
+      double memoryBytes = 0.0;
+      if (!core::readStringFromFile(cgroup.complete("memory.current"),
+                                    &contents))
+         memoryBytes = safe_convert::stringTo<double>(
+                           boost::algorithm::trim_copy(contents), 0.0);
+
+      data.push_back(metrics::MetricData("memory-mb." + username,
+                                         memoryBytes / (1024.0 * 1024.0)));
+
+      // report cpu and io as rates over the sweep interval (requires a
+      // previous sample; the first sweep just records the baselines)
+      std::map<std::string,UserUsage>::const_iterator it =
+                                                s_lastUsage.find(username);
+      if (it != s_lastUsage.end())
+      {
+         data.push_back(metrics::MetricData(
+            "cpu-pct." + username,
+            (usage.cpuUsec - it->second.cpuUsec) /
+               (kSweepSeconds * 1000000.0) * 100.0));
+         data.push_back(metrics::MetricData(
+            "io-read-kb." + username,
+            (usage.ioReadBytes - it->second.ioReadBytes) / 1024.0));
+         data.push_back(metrics::MetricData(
+            "io-write-kb." + username,
+            (usage.ioWriteBytes - it->second.ioWriteBytes) / 1024.0));
+      }
+
+      s_lastUsage[username] = usage;
+   }
+
+   if (!data.empty())
+   {
+      client().sendMultiMetrics(std::vector<metrics::MultiMetric>(
+         1, metrics::MultiMetric("rserver-sessions", kSweepSeconds, data)));
+   }
+
+   return true;
+}
+
+} // anonymous namespace
+
+void assignSession(const std::string& username, PidType pid)
+{
+   if (!s_enabled)
+      return;
+
+   // everything here is best effort -- a session that can't be confined
+   // still runs, it just isn't isolated from its neighbors
+
+   FilePath cgroup = sessionsCgroupDir().complete(username);
+   Error error = cgroup.ensureDirectory();
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   // apply the configured limits (idempotent, so applying them on every
+   // launch also picks up configuration changes across server restarts)
+   int cpuWeight = options().serverSessionCpuWeight();
+   if (cpuWeight > 0)
+   {
+      error = writeCgroupFile(cgroup,
+                              "cpu.weight",
+                              safe_convert::numberToString(cpuWeight));
+      if (error)
+         LOG_ERROR(error);
+   }
+
+   std::string ioMax = options().serverSessionIoMax();
+   if (!ioMax.empty())
+   {
+      error = writeCgroupFile(cgroup, "io.max", ioMax);
+      if (error)
+         LOG_ERROR(error);
+   }
+
+   // move the session into the cgroup
+   error = writeCgroupFile(cgroup,
+                           "cgroup.procs",
+                           safe_convert::numberToString(pid));
+   if (error)
+      LOG_ERROR(error);
+}
+
+Error initialize()
+{
+   // no-op unless resource isolation has been configured
+   if (options().serverSessionCpuWeight() <= 0 &&
+       options().serverSessionIoMax().empty())
+   {
+      return Success();
+   }
+
+   // require the cgroup v2 unified hierarchy
+   FilePath root(kCgroupRoot);
+   if (!root.complete("cgroup.controllers").exists())
+   {
+      LOG_WARNING_MESSAGE("cgroup v2 unified hierarchy is not mounted at " +
+                          std::string(kCgroupRoot) + "; session resource "
+                          "isolation is disabled");
+      return Success();
+   }
+
+   // prepare our branch of the hierarchy: delegate controllers from the
+   // root, create our cgroup, and delegate on to the per-user children
+   Error error = enableControllers(root);
+   if (!error)
+      error = sessionsCgroupDir().ensureDirectory();
+   if (!error)
+      error = enableControllers(sessionsCgroupDir());
+   if (error)
+   {
+      LOG_ERROR(error);
+      LOG_WARNING_MESSAGE("unable to prepare session cgroups; session "
+                          "resource isolation is disabled");
+      return Success();
+   }
+
+   s_enabled = true;
+
+   // periodically report per-user utilization through the monitor
+   scheduler::addCommand(
+      boost::shared_ptr<ScheduledCommand>(new PeriodicCommand(
+         boost::posix_time::seconds(kSweepSeconds),
+         reportCgroupStats,
+         false))
+   );
+
+   return Success();
+}
+
+} // namespace session_cgroups
+} // namespace server
+} // namespace rstudio
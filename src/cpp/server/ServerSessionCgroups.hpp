@@ -0,0 +1,51 @@
+/*
+ * ServerSessionCgroups.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SERVER_SESSION_CGROUPS_HPP
+#define SERVER_SESSION_CGROUPS_HPP
+
+#include <string>
+
+#include <core/system/System.hpp>
+
+namespace rstudio {
+namespace core {
+   class Error;
+}
+}
+
+namespace rstudio {
+namespace server {
+namespace session_cgroups {
+
+// cgroup v2 based resource isolation for sessions. when enabled (one of
+// server-session-cpu-weight or server-session-io-max is configured and
+// the unified cgroup hierarchy is mounted) each rsession is placed in a
+// per-user cgroup so the kernel shares cpu and io fairly between users
+// rather than between processes -- one user's parallel job then can't
+// starve their neighbors. per-user cpu, memory, and io figures are also
+// sampled from the cgroups and reported through the monitor
+
+// place a newly launched session in its user's cgroup (best effort --
+// the session runs unconfined if the assignment fails)
+void assignSession(const std::string& username, PidType pid);
+
+core::Error initialize();
+
+} // namespace session_cgroups
+} // namespace server
+} // namespace rstudio
+
+#endif // SERVER_SESSION_CGROUPS_HPP
@@ -0,0 +1,314 @@
+/*
+ * ServerSessionGovernor.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "ServerSessionGovernor.hpp"
+
+#include <csignal>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/foreach.hpp>
+
+#include <core/DateTime.hpp>
+#include <core/Error.hpp>
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/Log.hpp>
+#include <core/PeriodicCommand.hpp>
+#include <core/SafeConvert.hpp>
+#include <core/Thread.hpp>
+#include <core/system/PosixSystem.hpp>
+
+#include <monitor/MonitorClient.hpp>
+
+#include <server/ServerOptions.hpp>
+#include <server/ServerScheduler.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace server {
+namespace session_governor {
+
+namespace {
+
+// how often we sample session memory and check the limit
+const int kSweepSeconds = 15;
+
+// sessions active more recently than this are never asked to suspend --
+// this also gives just-resumed sessions a grace period so a session
+// brought back by a user request isn't immediately suspended again
+const int kIdleGraceSeconds = 60;
+
+// minimum time between suspend requests to the same session (a session
+// may legitimately decline to suspend, e.g. it has a busy child process)
+const int kResuspendSeconds = 5 * 60;
+
+struct SessionProcess
+{
+   SessionProcess()
+      : rssKb(0), cpuJiffies(0), lastActiveMs(0), lastSuspendRequestMs(0)
+   {
+   }
+
+   long rssKb;
+   unsigned long cpuJiffies;
+   double lastActiveMs;
+   double lastSuspendRequestMs;
+};
+
+boost::mutex s_processesMutex;
+std::map<PidType,SessionProcess> s_processes;
+
+// resident memory of a process in kilobytes (from /proc/<pid>/statm)
+Error processResidentKb(PidType pid, long* pRssKb)
+{
+   std::string statm;
+   Error error = core::readStringFromFile(
+      FilePath("/proc").complete(safe_convert::numberToString(pid))
+                       .complete("statm"),
+      &statm);
+   if (error)
+      return error;
+
+   std::vector<std::string> fields;
+   boost::algorithm::split(fields,
+                           statm,
+                           boost::algorithm::is_any_of(" "),
+                           boost::algorithm::token_compress_on);
+   if (fields.size() < 2)
+      return systemError(boost::system::errc::protocol_error, ERROR_LOCATION);
+
+   long pages = safe_convert::stringTo<long>(fields[1], 0);
+   *pRssKb = pages * (::sysconf(_SC_PAGESIZE) / 1024);
+   return Success();
+}
+
+// cpu time consumed by a process in jiffies (from /proc/<pid>/stat) --
+// used to detect whether the session has done any work since the last
+// sweep (i.e. whether it is idle)
+Error processCpuJiffies(PidType pid, unsigned long* pJiffies)
+{
+   std::string stat;
+   Error error = core::readStringFromFile(
+      FilePath("/proc").complete(safe_convert::numberToString(pid))
+                       .complete("stat"),
+      &stat);
+   if (error)
+      return error;
+
+   // fields follow the comm field (which can itself contain spaces
+   // and parens, so scan from the last closing paren)
+   std::string::size_type pos = stat.rfind(')');
+   if (pos == std::string::npos)
+      return systemError(boost::system::errc::protocol_error, ERROR_LOCATION);
+
+   std::vector<std::string> fields;
+   boost::algorithm::split(fields,
+                           boost::algorithm::trim_copy(stat.substr(pos + 1)),
+                           boost::algorithm::is_any_of(" "),
+                           boost::algorithm::token_compress_on);
+
+   // utime and stime are fields 14 and 15 of /proc/<pid>/stat; the
+   // first field after the comm is field 3 (state)
+   if (fields.size() < 13)
+      return systemError(boost::system::errc::protocol_error, ERROR_LOCATION);
+
+   *pJiffies = safe_convert::stringTo<unsigned long>(fields[11], 0) +
+               safe_convert::stringTo<unsigned long>(fields[12], 0);
+   return Success();
+}
+
+struct SuspendCandidate
+{
+   SuspendCandidate() : pid(0), rssKb(0), lastActiveMs(0) {}
+
+   PidType pid;
+   long rssKb;
+   double lastActiveMs;
+};
+
+bool leastRecentlyActive(const SuspendCandidate& a, const SuspendCandidate& b)
+{
+   return a.lastActiveMs < b.lastActiveMs;
+}
+
+bool governSessions()
+{
+   double nowMs = date_time::millisecondsSinceEpoch();
+
+   // snapshot the tracked pids
+   std::vector<PidType> pids;
+   LOCK_MUTEX(s_processesMutex)
+   {
+      for (std::map<PidType,SessionProcess>::const_iterator
+               it = s_processes.begin(); it != s_processes.end(); ++it)
+      {
+         pids.push_back(it->first);
+      }
+   }
+   END_LOCK_MUTEX
+
+   // sample memory and cpu for each session (failures just mean the
+   // process exited between the snapshot and the sample -- the process
+   // tracker will reap it)
+   long totalRssKb = 0;
+   std::vector<SuspendCandidate> candidates;
+   BOOST_FOREACH(PidType pid, pids)
+   {
+      long rssKb = 0;
+      unsigned long jiffies = 0;
+      if (processResidentKb(pid, &rssKb) || processCpuJiffies(pid, &jiffies))
+         continue;
+
+      totalRssKb += rssKb;
+
+      LOCK_MUTEX(s_processesMutex)
+      {
+         std::map<PidType,SessionProcess>::iterator it =
+                                                      s_processes.find(pid);
+         if (it == s_processes.end())
+            continue;
+
+         SessionProcess& process = it->second;
+         process.rssKb = rssKb;
+
+         // any cpu consumption since the last sweep counts as activity
+         if (jiffies > process.cpuJiffies)
+         {
+            process.cpuJiffies = jiffies;
+            process.lastActiveMs = nowMs;
+         }
+
+         // collect idle sessions we haven't recently asked to suspend
+         if ((nowMs - process.lastActiveMs) > (kIdleGraceSeconds * 1000.0) &&
+             (nowMs - process.lastSuspendRequestMs) >
+                                               (kResuspendSeconds * 1000.0))
+         {
+            SuspendCandidate candidate;
+            candidate.pid = pid;
+            candidate.rssKb = rssKb;
+            candidate.lastActiveMs = process.lastActiveMs;
+            candidates.push_back(candidate);
+         }
+      }
+      END_LOCK_MUTEX
+   }
+
+   // report aggregate session memory through the monitor
+   using namespace monitor;
+   std::vector<metrics::Metric> reportMetrics;
+   reportMetrics.push_back(metrics::Metric(
+            "rserver",
+            kSweepSeconds,
+            metrics::MetricData("session-memory-mb", totalRssKb / 1024.0)));
+   client().sendMetrics(reportMetrics);
+
+   // under the limit (or governor disabled) -- nothing more to do
+   long limitKb = options().serverSessionMemoryLimitMb() * 1024L;
+   if (limitKb <= 0 || totalRssKb <= limitKb)
+      return true;
+
+   // over the limit: ask idle sessions to suspend in least recently
+   // active order until the projected total falls below the limit.
+   // SIGUSR1 is cooperative -- the session saves its state and exits
+   // the next time it is safely able to do so
+   std::sort(candidates.begin(), candidates.end(), leastRecentlyActive);
+   long projectedRssKb = totalRssKb;
+   BOOST_FOREACH(const SuspendCandidate& candidate, candidates)
+   {
+      if (projectedRssKb <= limitKb)
+         break;
+
+      Error error = core::system::killProcess(candidate.pid, SIGUSR1);
+      if (error)
+      {
+         LOG_ERROR(error);
+         continue;
+      }
+
+      LOCK_MUTEX(s_processesMutex)
+      {
+         std::map<PidType,SessionProcess>::iterator it =
+                                          s_processes.find(candidate.pid);
+         if (it != s_processes.end())
+            it->second.lastSuspendRequestMs = nowMs;
+      }
+      END_LOCK_MUTEX
+
+      projectedRssKb -= candidate.rssKb;
+   }
+
+   if (projectedRssKb > limitKb)
+   {
+      LOG_WARNING_MESSAGE("Session memory (" +
+         safe_convert::numberToString(totalRssKb / 1024) + " MB) exceeds "
+         "limit (" + safe_convert::numberToString(limitKb / 1024) + " MB) "
+         "and there are no idle sessions left to suspend");
+   }
+
+   return true;
+}
+
+} // anonymous namespace
+
+void noteSessionLaunched(PidType pid)
+{
+   LOCK_MUTEX(s_processesMutex)
+   {
+      SessionProcess process;
+
+      // count the launch itself as activity so brand new (and just
+      // resumed) sessions get the full idle grace period
+      process.lastActiveMs = date_time::millisecondsSinceEpoch();
+      s_processes[pid] = process;
+   }
+   END_LOCK_MUTEX
+}
+
+void noteSessionExited(PidType pid)
+{
+   LOCK_MUTEX(s_processesMutex)
+   {
+      s_processes.erase(pid);
+   }
+   END_LOCK_MUTEX
+}
+
+Error initialize()
+{
+   if (options().serverSessionMemoryLimitMb() <= 0)
+      return Success();
+
+   // periodically sample session memory and enforce the limit
+   scheduler::addCommand(
+      boost::shared_ptr<ScheduledCommand>(new PeriodicCommand(
+         boost::posix_time::seconds(kSweepSeconds),
+         governSessions,
+         false))
+   );
+
+   return Success();
+}
+
+} // namespace session_governor
+} // namespace server
+} // namespace rstudio
@@ -0,0 +1,48 @@
+/*
+ * ServerSessionGovernor.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SERVER_SESSION_GOVERNOR_HPP
+#define SERVER_SESSION_GOVERNOR_HPP
+
+#include <core/system/System.hpp>
+
+namespace rstudio {
+namespace core {
+   class Error;
+}
+}
+
+namespace rstudio {
+namespace server {
+namespace session_governor {
+
+// cooperative session memory governor. periodically sums the resident
+// memory of all sessions launched by this server and, when the total
+// crosses server-session-memory-limit-mb, asks idle sessions to suspend
+// (via SIGUSR1, i.e. the same save-and-exit path used for idle timeout
+// suspends) in least-recently-active order. suspended sessions resume
+// transparently on their next request
+
+// track session processes launched by the server
+void noteSessionLaunched(PidType pid);
+void noteSessionExited(PidType pid);
+
+core::Error initialize();
+
+} // namespace session_governor
+} // namespace server
+} // namespace rstudio
+
+#endif // SERVER_SESSION_GOVERNOR_HPP
@@ -24,6 +24,7 @@
 
 #include <monitor/MonitorClient.hpp>
 #include <session/SessionConstants.hpp>
+#include <session/SessionLocalStreams.hpp>
 
 #include <server/ServerOptions.hpp>
 
@@ -32,6 +33,9 @@
 #include <server/auth/ServerValidateUser.hpp>
 
 #include "ServerREnvironment.hpp"
+#include "ServerSessionCgroups.hpp"
+#include "ServerSessionGovernor.hpp"
+#include "ServerSessionRouting.hpp"
 
 
 using namespace rstudio::core;
@@ -149,6 +153,7 @@ core::system::ProcessConfig sessionProcessConfig(
 
 void onProcessExit(const std::string& username, PidType pid)
 {
+   session_governor::noteSessionExited(pid);
 }
 
 } // anonymous namespace
@@ -160,12 +165,41 @@ SessionManager& sessionManager()
 }
 
 SessionManager::SessionManager()
+   : pIoService_(NULL)
 {
    // set default session launcher
    sessionLaunchFunction_ = boost::bind(&SessionManager::launchAndTrackSession,
                                            this, _1, _2);
 }
 
+void SessionManager::setIoService(boost::asio::io_service& ioService)
+{
+   pIoService_ = &ioService;
+}
+
+void SessionManager::prelaunchSession(const std::string& username)
+{
+   // prelaunching is strictly an optimization: it starts the user's
+   // default session during the sign-in redirect so R initialization
+   // overlaps client startup rather than waiting on the first proxied
+   // request; failures are non-fatal because the connection-driven
+   // launch (with its retry profile) remains in place
+   if (pIoService_ == NULL)
+      return;
+
+   // if the session's stream file already exists then the session is
+   // likely already running -- don't disturb it
+   r_util::SessionContext context(username);
+   FilePath streamPath = session::local_streams::streamPath(
+                                    r_util::sessionContextFile(context));
+   if (streamPath.exists())
+      return;
+
+   Error error = launchSession(*pIoService_, context, http::Request());
+   if (error)
+      LOG_ERROR(error);
+}
+
 Error SessionManager::launchSession(boost::asio::io_service& ioService,
                                     const r_util::SessionContext& context,
                                     const http::Request& request,
@@ -222,6 +256,10 @@ Error SessionManager::launchSession(boost::asio::io_service& ioService,
       return error;
    }
 
+   // claim the session for this node so peer nodes route its
+   // requests here (no-op unless multi-node routing is configured)
+   session_routing::noteSessionLocation(context);
+
    return Success();
 }
 
@@ -257,11 +295,18 @@ Error SessionManager::launchAndTrackSession(
    if (error)
       return error;
 
+   // place the session in its user's cgroup (no-op unless resource
+   // isolation is configured)
+   session_cgroups::assignSession(profile.context.username, pid);
+
    // track it for subsequent reaping
    processTracker_.addProcess(pid, boost::bind(onProcessExit,
                                                profile.context.username,
                                                pid));
 
+   // track it for memory governance
+   session_governor::noteSessionLaunched(pid);
+
    // return success
    return Success();
 }
@@ -18,6 +18,7 @@
 #include <vector>
 #include <sstream>
 #include <map>
+#include <deque>
 
 #include <boost/regex.hpp>
 #include <boost/algorithm/string/join.hpp>
@@ -33,6 +34,7 @@
 #include <core/Error.hpp>
 #include <core/BoostErrors.hpp>
 #include <core/Log.hpp>
+#include <core/PerformanceMetrics.hpp>
 #include <core/Thread.hpp>
 #include <core/WaitUtils.hpp>
 #include <core/RegexUtils.hpp>
@@ -42,6 +44,7 @@
 #include <core/http/Request.hpp>
 #include <core/http/Response.hpp>
 #include <core/http/LocalStreamAsyncClient.hpp>
+#include <core/http/TcpIpAsyncClient.hpp>
 #include <core/http/Util.hpp>
 #include <core/http/URL.hpp>
 #include <core/system/PosixSystem.hpp>
@@ -64,6 +67,8 @@
 
 #include <server/ServerConstants.hpp>
 
+#include "ServerSessionRouting.hpp"
+
 using namespace rstudio::core ;
 
 namespace rstudio {
@@ -142,6 +147,103 @@ ProxyFilter s_proxyFilter;
 
 ProxyRequestFilter s_proxyRequestFilter;
 
+// keep-alive connection pool for proxied rsession traffic, keyed by the
+// session stream path. connections whose responses complete cleanly are
+// returned here and reused for subsequent requests to the same session,
+// avoiding per-request connect/teardown on the unix domain sockets.
+// idle connections are health-checked (non-blocking peek) before being
+// handed out and evicted after an idle timeout
+class SessionConnectionPool : boost::noncopyable
+{
+private:
+   // bound the pooled connections per session (rpc traffic is serialized
+   // through just a few concurrent connections in practice) and don't
+   // reuse sockets that have sat idle long enough for the session to
+   // have plausibly exited or suspended
+   static const std::size_t kMaxConnectionsPerSession = 4;
+   static const int kMaxIdleSeconds = 30;
+
+   struct PooledConnection
+   {
+      boost::posix_time::ptime idleSince;
+      boost::shared_ptr<http::LocalStreamAsyncClient> pClient;
+   };
+
+public:
+   boost::shared_ptr<http::LocalStreamAsyncClient> acquire(
+                                             const std::string& streamPath)
+   {
+      using namespace boost::posix_time;
+
+      LOCK_MUTEX(mutex_)
+      {
+         std::deque<PooledConnection>& connections = pool_[streamPath];
+         ptime now = microsec_clock::universal_time();
+         while (!connections.empty())
+         {
+            // most recently released first (front) -- it's the most
+            // likely to still be healthy
+            PooledConnection connection = connections.front();
+            connections.pop_front();
+
+            if (now - connection.idleSince > seconds(kMaxIdleSeconds) ||
+                !connection.pClient->isConnected())
+            {
+               connection.pClient->close();
+               continue;
+            }
+
+            return connection.pClient;
+         }
+      }
+      END_LOCK_MUTEX
+
+      return boost::shared_ptr<http::LocalStreamAsyncClient>();
+   }
+
+   void release(const std::string& streamPath,
+                const boost::shared_ptr<http::LocalStreamAsyncClient>& pClient)
+   {
+      // drop references to the completed request's handlers so pooling
+      // the client doesn't pin the proxied connection objects
+      pClient->disableHandlers();
+
+      LOCK_MUTEX(mutex_)
+      {
+         std::deque<PooledConnection>& connections = pool_[streamPath];
+         if (connections.size() >= kMaxConnectionsPerSession)
+         {
+            pClient->close();
+            return;
+         }
+
+         PooledConnection connection;
+         connection.idleSince = boost::posix_time::microsec_clock::universal_time();
+         connection.pClient = pClient;
+         connections.push_front(connection);
+      }
+      END_LOCK_MUTEX
+   }
+
+private:
+   boost::mutex mutex_;
+   std::map<std::string, std::deque<PooledConnection> > pool_;
+};
+
+SessionConnectionPool s_sessionConnectionPool;
+
+// note: bound with a weak_ptr to avoid a reference cycle (the client
+// owns the handler that would otherwise own the client)
+void returnConnectionToPool(
+               const std::string& streamPath,
+               boost::weak_ptr<http::LocalStreamAsyncClient> pWeakClient)
+{
+   boost::shared_ptr<http::LocalStreamAsyncClient> pClient =
+                                                      pWeakClient.lock();
+   if (pClient)
+      s_sessionConnectionPool.release(streamPath, pClient);
+}
+
 void invokeRequestFilter(http::Request* pRequest)
 {
    if (s_proxyRequestFilter)
@@ -176,14 +278,35 @@ bool sessionContextForRequest(
    }
 }
 
+std::string proxyMetricName(int requestType)
+{
+   switch (requestType)
+   {
+      case RequestType::Rpc:
+         return "rserver_proxy_rpc_duration_seconds";
+      case RequestType::Events:
+         return "rserver_proxy_events_duration_seconds";
+      case RequestType::Content:
+      default:
+         return "rserver_proxy_content_duration_seconds";
+   }
+}
+
 void handleProxyResponse(
       boost::shared_ptr<core::http::AsyncConnection> ptrConnection,
       const r_util::SessionContext& context,
+      int requestType,
+      const boost::posix_time::ptime& startTime,
       const http::Response& response)
 {
    // if there was a launch pending then remove it
    sessionManager().removePendingLaunch(context);
 
+   // record the time spent on the hop to the session and back
+   core::performance::recordDuration(
+         proxyMetricName(requestType),
+         boost::posix_time::microsec_clock::universal_time() - startTime);
+
    // write the response
    ptrConnection->writeResponse(response);
 }
@@ -544,6 +667,39 @@ Error userIdForUsername(const std::string& username, UidType* pUID)
    return Success();
 }
 
+void handleForwardResponse(
+      boost::shared_ptr<core::http::AsyncConnection> ptrConnection,
+      const http::Response& response)
+{
+   ptrConnection->response().assign(response);
+   ptrConnection->writeResponse();
+}
+
+// forward a request to a peer node which owns (or should launch) the
+// session it is addressed to
+void forwardToNode(
+      boost::shared_ptr<core::http::AsyncConnection> ptrConnection,
+      const std::string& nodeAddress,
+      boost::shared_ptr<http::Request> pRequest,
+      const http::ErrorHandler& errorHandler)
+{
+   // split the address into host and port
+   std::string host = nodeAddress;
+   std::string port = "8787";
+   std::string::size_type pos = nodeAddress.find(':');
+   if (pos != std::string::npos)
+   {
+      host = nodeAddress.substr(0, pos);
+      port = nodeAddress.substr(pos + 1);
+   }
+
+   boost::shared_ptr<http::TcpIpAsyncClient> pClient(
+         new http::TcpIpAsyncClient(ptrConnection->ioService(), host, port));
+   pClient->request().assign(*pRequest);
+   pClient->execute(boost::bind(handleForwardResponse, ptrConnection, _1),
+                    errorHandler);
+}
+
 void proxyRequest(
       int requestType,
       const r_util::SessionContext& context,
@@ -577,6 +733,21 @@ void proxyRequest(
    std::string streamFile = r_util::sessionContextFile(context);
    FilePath streamPath = session::local_streams::streamPath(streamFile);
 
+   // in a multi-node cluster, forward requests for sessions owned by a
+   // peer node; place brand new sessions on the least loaded node
+   if (session_routing::enabled())
+   {
+      std::string nodeAddress = session_routing::sessionNodeAddress(context);
+      if (nodeAddress.empty() && !streamPath.exists())
+         nodeAddress = session_routing::placementNodeAddress();
+      if (!nodeAddress.empty() &&
+          nodeAddress != session_routing::localNodeAddress())
+      {
+         forwardToNode(ptrConnection, nodeAddress, pRequest, errorHandler);
+         return;
+      }
+   }
+
    // determine the uid for the username (for validation)
    UidType uid;
    boost::optional<UidType> validateUid;
@@ -606,12 +777,25 @@ void proxyRequest(
       }
    }
 
-   // create client
-   // if the user is available on the system pass in the uid for validation to ensure
-   // that we only connect to the socket if it was created by the user
-    boost::shared_ptr<http::IAsyncClient> pClient(new http::LocalStreamAsyncClient(
+   // reuse a pooled keep-alive connection to this session if we have one,
+   // otherwise create a client (if the user is available on the system
+   // pass in the uid for validation to ensure that we only connect to the
+   // socket if it was created by the user)
+    boost::shared_ptr<http::LocalStreamAsyncClient> pClient =
+          s_sessionConnectionPool.acquire(streamPath.absolutePath());
+    if (!pClient)
+    {
+       pClient.reset(new http::LocalStreamAsyncClient(
                                                      ptrConnection->ioService(),
                                                      streamPath, false, validateUid));
+    }
+
+    // hand the connection back to the pool when the response completes
+    // cleanly (bound weakly to avoid a handler/client reference cycle)
+    pClient->enableConnectionReuse(
+          boost::bind(returnConnectionToPool,
+                      streamPath.absolutePath(),
+                      boost::weak_ptr<http::LocalStreamAsyncClient>(pClient)));
 
     // setup retry context
     if (!connectionRetryProfile.empty())
@@ -620,7 +804,12 @@ void proxyRequest(
     // assign request
     pClient->request().assign(*pRequest);
 
-    pClient->execute(boost::bind(handleProxyResponse, ptrConnection, context, _1),
+    pClient->execute(boost::bind(handleProxyResponse,
+                                 ptrConnection,
+                                 context,
+                                 requestType,
+                                 boost::posix_time::microsec_clock::universal_time(),
+                                 _1),
                      errorHandler);
 }
 
@@ -0,0 +1,208 @@
+/*
+ * ServerSessionRouting.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "ServerSessionRouting.hpp"
+
+#include <vector>
+
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/foreach.hpp>
+
+#include <core/DateTime.hpp>
+#include <core/Error.hpp>
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/Log.hpp>
+#include <core/PeriodicCommand.hpp>
+#include <core/SafeConvert.hpp>
+
+#include <core/r_util/RSessionContext.hpp>
+
+#include <server/ServerOptions.hpp>
+#include <server/ServerScheduler.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace server {
+namespace session_routing {
+
+namespace {
+
+// interval at which nodes publish their load -- load files older than
+// a few missed intervals belong to a dead node and are ignored
+const int kPublishLoadSeconds = 30;
+const int kNodeLoadStaleSeconds = kPublishLoadSeconds * 3;
+
+FilePath sessionLocationsPath()
+{
+   return FilePath(options().serverSharedStoragePath()).complete(
+                                                      "session-locations");
+}
+
+FilePath nodeLoadsPath()
+{
+   return FilePath(options().serverSharedStoragePath()).complete(
+                                                      "node-loads");
+}
+
+FilePath sessionLocationFile(const r_util::SessionContext& context)
+{
+   return sessionLocationsPath().complete(r_util::sessionContextFile(context));
+}
+
+// publish the number of sessions this node owns so peers can make
+// placement decisions
+bool publishNodeLoad()
+{
+   int load = 0;
+   std::vector<FilePath> locationFiles;
+   Error error = sessionLocationsPath().children(&locationFiles);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return true;
+   }
+
+   BOOST_FOREACH(const FilePath& locationFile, locationFiles)
+   {
+      std::string address;
+      Error error = core::readStringFromFile(locationFile, &address);
+      if (error)
+         continue;
+
+      if (boost::algorithm::trim_copy(address) == localNodeAddress())
+         load++;
+   }
+
+   error = core::writeStringToFile(
+                     nodeLoadsPath().complete(localNodeAddress()),
+                     safe_convert::numberToString(load));
+   if (error)
+      LOG_ERROR(error);
+
+   return true;
+}
+
+} // anonymous namespace
+
+bool enabled()
+{
+   return !options().serverNodeAddress().empty() &&
+          !options().serverSharedStoragePath().empty();
+}
+
+std::string localNodeAddress()
+{
+   return options().serverNodeAddress();
+}
+
+void noteSessionLocation(const r_util::SessionContext& context)
+{
+   if (!enabled())
+      return;
+
+   Error error = core::writeStringToFile(sessionLocationFile(context),
+                                         localNodeAddress());
+   if (error)
+      LOG_ERROR(error);
+}
+
+std::string sessionNodeAddress(const r_util::SessionContext& context)
+{
+   FilePath locationFile = sessionLocationFile(context);
+   if (!locationFile.exists())
+      return std::string();
+
+   std::string address;
+   Error error = core::readStringFromFile(locationFile, &address);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return std::string();
+   }
+
+   return boost::algorithm::trim_copy(address);
+}
+
+std::string placementNodeAddress()
+{
+   std::vector<FilePath> loadFiles;
+   Error error = nodeLoadsPath().children(&loadFiles);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return localNodeAddress();
+   }
+
+   // pick the least loaded node with a recent load file (prefer this
+   // node on ties so we don't forward without a reason to)
+   std::string bestAddress = localNodeAddress();
+   int bestLoad = -1;
+   double nowMs = date_time::millisecondsSinceEpoch();
+   BOOST_FOREACH(const FilePath& loadFile, loadFiles)
+   {
+      if (nowMs - date_time::millisecondsSinceEpoch(
+                     loadFile.lastWriteTime()) >
+          kNodeLoadStaleSeconds * 1000.0)
+      {
+         continue;
+      }
+
+      std::string contents;
+      Error error = core::readStringFromFile(loadFile, &contents);
+      if (error)
+         continue;
+
+      int load = safe_convert::stringTo<int>(
+                     boost::algorithm::trim_copy(contents), 0);
+      if (bestLoad == -1 ||
+          load < bestLoad ||
+          (load == bestLoad && loadFile.filename() == localNodeAddress()))
+      {
+         bestAddress = loadFile.filename();
+         bestLoad = load;
+      }
+   }
+
+   return bestAddress;
+}
+
+Error initialize()
+{
+   if (!enabled())
+      return Success();
+
+   // ensure registry directories exist
+   Error error = sessionLocationsPath().ensureDirectory();
+   if (error)
+      return error;
+   error = nodeLoadsPath().ensureDirectory();
+   if (error)
+      return error;
+
+   // periodically publish this node's load for placement decisions
+   scheduler::addCommand(
+      boost::shared_ptr<ScheduledCommand>(new PeriodicCommand(
+         boost::posix_time::seconds(kPublishLoadSeconds),
+         publishNodeLoad))
+   );
+
+   return Success();
+}
+
+} // namespace session_routing
+} // namespace server
+} // namespace rstudio
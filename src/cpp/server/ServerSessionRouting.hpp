@@ -0,0 +1,63 @@
+/*
+ * ServerSessionRouting.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SERVER_SESSION_ROUTING_HPP
+#define SERVER_SESSION_ROUTING_HPP
+
+#include <string>
+
+namespace rstudio {
+namespace core {
+   class Error;
+   namespace r_util {
+      struct SessionContext;
+   }
+}
+}
+
+namespace rstudio {
+namespace server {
+namespace session_routing {
+
+// multi-node session routing. each node in a cluster records which
+// sessions it owns in a registry on shared storage and periodically
+// publishes its load; requests for a session owned by a peer are
+// forwarded to that peer, and brand new sessions are placed on the
+// least loaded node. active when both server-node-address and
+// server-shared-storage-path are configured
+
+bool enabled();
+
+// address of this node as reachable by peer nodes
+std::string localNodeAddress();
+
+// record that this node owns the session for the specified context
+void noteSessionLocation(const core::r_util::SessionContext& context);
+
+// address of the node which owns the session for the specified context
+// (empty if no node has claimed it)
+std::string sessionNodeAddress(const core::r_util::SessionContext& context);
+
+// address of the least loaded node in the cluster -- the node a brand
+// new session should be placed on (may be this node)
+std::string placementNodeAddress();
+
+core::Error initialize();
+
+} // namespace session_routing
+} // namespace server
+} // namespace rstudio
+
+#endif // SERVER_SESSION_ROUTING_HPP
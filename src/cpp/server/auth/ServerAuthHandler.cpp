@@ -18,6 +18,11 @@
 
 #include <server/auth/ServerAuthHandler.hpp>
 
+#include <map>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <core/Thread.hpp>
 #include <core/json/JsonRpc.hpp>
 
 #include <server/ServerUriHandlers.hpp>
@@ -36,6 +41,24 @@ namespace {
 // global auth handler
 Handler s_handler;
 
+// cache of validated auth cookies -- a page load issues dozens of asset
+// requests bearing identical cookies, and validating each one means an
+// HMAC computation plus cookie parsing. cookie headers which recently
+// validated successfully are remembered here so repeat requests cost a
+// map lookup instead. the window is kept short since a cached entry
+// outlives the underlying cookie by at most its length
+const int kValidatedCookieCacheSeconds = 30;
+const std::size_t kValidatedCookieCacheMaxSize = 5000;
+
+struct ValidatedCookie
+{
+   std::string userIdentifier;
+   boost::posix_time::ptime validatedAt;
+};
+
+boost::mutex s_validatedCookiesMutex;
+std::map<std::string, ValidatedCookie> s_validatedCookies;
+
 void updateCredentialsNotSupported(
       boost::shared_ptr<core::http::AsyncConnection> pConnection)
 {
@@ -63,7 +86,68 @@ const char * const kRefreshCredentialsAndContinue = "/auth-refresh-credentials";
 
 std::string getUserIdentifier(const core::http::Request& request)
 {
-   return s_handler.getUserIdentifier(request);
+   using namespace boost::posix_time;
+
+   // check for a recently validated identical cookie header
+   std::string cookieHeader = request.headerValue("Cookie");
+   if (!cookieHeader.empty())
+   {
+      LOCK_MUTEX(s_validatedCookiesMutex)
+      {
+         std::map<std::string, ValidatedCookie>::iterator it =
+                                       s_validatedCookies.find(cookieHeader);
+         if (it != s_validatedCookies.end())
+         {
+            if (microsec_clock::universal_time() <
+                it->second.validatedAt +
+                seconds(kValidatedCookieCacheSeconds))
+            {
+               return it->second.userIdentifier;
+            }
+
+            s_validatedCookies.erase(it);
+         }
+      }
+      END_LOCK_MUTEX
+   }
+
+   // full validation
+   std::string userIdentifier = s_handler.getUserIdentifier(request);
+
+   // remember successful validations only (failures are cheap to repeat
+   // and must not be cacheable by construction)
+   if (!userIdentifier.empty() && !cookieHeader.empty())
+   {
+      LOCK_MUTEX(s_validatedCookiesMutex)
+      {
+         if (s_validatedCookies.size() >= kValidatedCookieCacheMaxSize)
+         {
+            // prune entries past their window; if that isn't enough
+            // (e.g. a client manufacturing distinct valid headers)
+            // start over rather than grow without bound
+            ptime now = microsec_clock::universal_time();
+            std::map<std::string, ValidatedCookie>::iterator it =
+                                                   s_validatedCookies.begin();
+            while (it != s_validatedCookies.end())
+            {
+               if (now >= it->second.validatedAt +
+                          seconds(kValidatedCookieCacheSeconds))
+                  s_validatedCookies.erase(it++);
+               else
+                  ++it;
+            }
+            if (s_validatedCookies.size() >= kValidatedCookieCacheMaxSize)
+               s_validatedCookies.clear();
+         }
+
+         ValidatedCookie& entry = s_validatedCookies[cookieHeader];
+         entry.userIdentifier = userIdentifier;
+         entry.validatedAt = microsec_clock::universal_time();
+      }
+      END_LOCK_MUTEX
+   }
+
+   return userIdentifier;
 }
 
 std::string userIdentifierToLocalUsername(const std::string& userIdentifier)
@@ -0,0 +1,144 @@
+/*
+ * ServerRateLimiter.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <server/auth/ServerRateLimiter.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <core/PerformanceMetrics.hpp>
+#include <core/SafeConvert.hpp>
+#include <core/Thread.hpp>
+
+#include <core/http/Request.hpp>
+#include <core/http/Response.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace server {
+namespace auth {
+namespace rate_limit {
+
+namespace {
+
+// per-class budgets: sustained refill rate (tokens/second) and burst
+// capacity. interactive covers rpc and ui traffic -- a busy IDE fires
+// bursts of requests, so the burst is sized well above anything a human
+// can generate while the sustained rate still caps a runaway script.
+// bulk covers uploads and exports, where each request is itself
+// expensive
+const double kRefillRate[] = { 50.0, 2.0 };
+const double kBurstCapacity[] = { 200.0, 20.0 };
+
+struct TokenBucket
+{
+   TokenBucket() : tokens(0) {}
+
+   // COPYING: via compiler (copyable members)
+
+   double tokens;
+   boost::posix_time::ptime lastRefill;
+};
+
+boost::mutex s_bucketsMutex;
+std::map<std::string, TokenBucket> s_buckets[2];
+
+} // anonymous namespace
+
+EndpointClass classifyRequest(const http::Request& request)
+{
+   const std::string& uri = request.uri();
+   if (boost::algorithm::ends_with(uri, "/upload") ||
+       boost::algorithm::ends_with(uri, "/export") ||
+       uri.find("/export/") != std::string::npos)
+   {
+      return EndpointBulk;
+   }
+
+   return EndpointInteractive;
+}
+
+bool consumeToken(const std::string& username,
+                  EndpointClass endpointClass,
+                  int* pRetryAfterSeconds)
+{
+   using namespace boost::posix_time;
+
+   double rate = kRefillRate[endpointClass];
+   double burst = kBurstCapacity[endpointClass];
+   ptime now = microsec_clock::universal_time();
+
+   LOCK_MUTEX(s_bucketsMutex)
+   {
+      TokenBucket& bucket = s_buckets[endpointClass][username];
+
+      // first sighting of this user gets a full bucket
+      if (bucket.lastRefill.is_not_a_date_time())
+      {
+         bucket.tokens = burst;
+         bucket.lastRefill = now;
+      }
+
+      // refill for the time elapsed since the last consumption attempt
+      double elapsedSeconds =
+            (now - bucket.lastRefill).total_microseconds() / 1e6;
+      if (elapsedSeconds > 0)
+      {
+         bucket.tokens = std::min(burst,
+                                  bucket.tokens + (rate * elapsedSeconds));
+         bucket.lastRefill = now;
+      }
+
+      if (bucket.tokens >= 1.0)
+      {
+         bucket.tokens -= 1.0;
+         return true;
+      }
+
+      // exhausted -- report when a token will next be available
+      *pRetryAfterSeconds = std::max(
+            1, static_cast<int>(::ceil((1.0 - bucket.tokens) / rate)));
+   }
+   END_LOCK_MUTEX
+
+   performance::incrementCounter(
+            endpointClass == EndpointBulk ?
+               "rserver_rate_limited_bulk_total" :
+               "rserver_rate_limited_interactive_total");
+
+   return false;
+}
+
+void setTooManyRequestsResponse(int retryAfterSeconds,
+                                http::Response* pResponse)
+{
+   pResponse->setStatusCode(http::status::TooManyRequests);
+   pResponse->setHeader("Retry-After",
+                        safe_convert::numberToString(retryAfterSeconds));
+   pResponse->setContentType("text/plain");
+   pResponse->setBody("Too many requests; retry after " +
+                      safe_convert::numberToString(retryAfterSeconds) +
+                      " seconds");
+}
+
+} // namespace rate_limit
+} // namespace auth
+} // namespace server
+} // namespace rstudio
@@ -27,6 +27,7 @@
 #include <core/gwt/GwtFileHandler.hpp>
 
 #include <server/auth/ServerAuthHandler.hpp>
+#include <server/auth/ServerRateLimiter.hpp>
 #include <server/auth/ServerValidateUser.hpp>
 
 using namespace rstudio::core;
@@ -63,6 +64,18 @@ public:
       std::string username = handler::userIdentifierToLocalUsername(
                                                             userIdentifier);
 
+      // enforce per-user rate limits so one runaway client can't
+      // degrade the box for everyone
+      int retryAfterSeconds = 0;
+      if (!rate_limit::consumeToken(username,
+                                    rate_limit::classifyRequest(request),
+                                    &retryAfterSeconds))
+      {
+         rate_limit::setTooManyRequestsResponse(retryAfterSeconds,
+                                                pResponse);
+         return;
+      }
+
       // call the handler
       handlerFunction_(username, request, pResponse);
    }
@@ -100,6 +113,20 @@ public:
       std::string username = handler::userIdentifierToLocalUsername(
                                                             userIdentifier);
 
+      // enforce per-user rate limits so one runaway client can't
+      // degrade the box for everyone
+      int retryAfterSeconds = 0;
+      if (!rate_limit::consumeToken(
+                           username,
+                           rate_limit::classifyRequest(pConnection->request()),
+                           &retryAfterSeconds))
+      {
+         rate_limit::setTooManyRequestsResponse(retryAfterSeconds,
+                                                &(pConnection->response()));
+         pConnection->writeResponse();
+         return;
+      }
+
       // call the handler
       handlerFunction_(username, pConnection);
    }
@@ -82,6 +82,31 @@ public:
 
    bool serverSetUmask() const { return serverSetUmask_; }
 
+   std::string serverNodeAddress() const
+   {
+      return std::string(serverNodeAddress_.c_str());
+   }
+
+   std::string serverSharedStoragePath() const
+   {
+      return std::string(serverSharedStoragePath_.c_str());
+   }
+
+   int serverSessionMemoryLimitMb() const
+   {
+      return serverSessionMemoryLimitMb_;
+   }
+
+   int serverSessionCpuWeight() const
+   {
+      return serverSessionCpuWeight_;
+   }
+
+   std::string serverSessionIoMax() const
+   {
+      return std::string(serverSessionIoMax_.c_str());
+   }
+
    // www 
    std::string wwwAddress() const
    { 
@@ -261,6 +286,11 @@ private:
    bool serverDaemonize_;
    bool serverAppArmorEnabled_;
    bool serverSetUmask_;
+   std::string serverNodeAddress_;
+   std::string serverSharedStoragePath_;
+   int serverSessionMemoryLimitMb_;
+   int serverSessionCpuWeight_;
+   std::string serverSessionIoMax_;
    bool serverOffline_;
    std::string wwwAddress_ ;
    std::string wwwPort_ ;
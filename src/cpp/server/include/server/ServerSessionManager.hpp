@@ -67,6 +67,15 @@ public:
                              const core::http::ErrorHandler& onError = core::http::ErrorHandler());
    void removePendingLaunch(const core::r_util::SessionContext& context);
 
+   // provide the io service used for launches initiated outside of a
+   // connection (i.e. prelaunching at authentication time)
+   void setIoService(boost::asio::io_service& ioService);
+
+   // prelaunch a user's default session at authentication time so that
+   // rsession startup overlaps the redirect back to the application
+   // (rather than waiting for the first proxied request to miss)
+   void prelaunchSession(const std::string& username);
+
    // set a custom session launcher
    typedef boost::function<core::Error(
                            boost::asio::io_service&,
@@ -106,6 +115,9 @@ private:
    // session launch profile filters
    std::vector<SessionLaunchProfileFilter> sessionLaunchProfileFilters_;
 
+   // io service for connection-less launches (set after http server init)
+   boost::asio::io_service* pIoService_;
+
    // child process tracker
    core::system::ChildProcessTracker processTracker_;
 };
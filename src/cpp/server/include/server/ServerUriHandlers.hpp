@@ -29,6 +29,12 @@ namespace uri_handlers {
 void add(const std::string& prefix,
          const core::http::AsyncUriHandlerFunction& handler);
 
+// add async uri handler with an explicit request class (used for qos
+// scheduling -- see AsyncServer::setRequestClassLimit)
+void add(const std::string& prefix,
+         const core::http::AsyncUriHandlerFunction& handler,
+         core::http::RequestClass requestClass);
+
 // add proxy handler
 // proxy handlers have special behavior to allow them to route all traffic
 void addProxyHandler(const std::string& prefix,
@@ -0,0 +1,60 @@
+/*
+ * ServerRateLimiter.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SERVER_AUTH_RATE_LIMITER_HPP
+#define SERVER_AUTH_RATE_LIMITER_HPP
+
+#include <string>
+
+namespace rstudio {
+namespace core {
+   namespace http {
+      class Request;
+      class Response;
+   }
+}
+}
+
+namespace rstudio {
+namespace server {
+namespace auth {
+namespace rate_limit {
+
+// endpoint classes with separate token budgets
+enum EndpointClass
+{
+   EndpointInteractive,  // rpc and ui traffic
+   EndpointBulk          // uploads, exports and other bulk transfers
+};
+
+EndpointClass classifyRequest(const core::http::Request& request);
+
+// consume a token from the user's bucket for the endpoint class;
+// returns false when the bucket is exhausted, in which case
+// *pRetryAfterSeconds indicates when a token will next be available
+bool consumeToken(const std::string& username,
+                  EndpointClass endpointClass,
+                  int* pRetryAfterSeconds);
+
+// write a 429 response carrying a Retry-After hint
+void setTooManyRequestsResponse(int retryAfterSeconds,
+                                core::http::Response* pResponse);
+
+} // namespace rate_limit
+} // namespace auth
+} // namespace server
+} // namespace rstudio
+
+#endif // SERVER_AUTH_RATE_LIMITER_HPP
@@ -13,12 +13,17 @@
  *
  */
 
+#include <algorithm>
+
 #include <boost/foreach.hpp>
 
 #include <session/SessionUserSettings.hpp>
 #include <session/SessionConsoleProcess.hpp>
 #include <session/SessionModuleContext.hpp>
 
+#include <core/DateTime.hpp>
+#include <core/SafeConvert.hpp>
+#include <core/StringUtils.hpp>
 #include <core/system/Environment.hpp>
 #include <core/system/Process.hpp>
 
@@ -30,6 +35,309 @@ namespace rstudio {
 namespace session {
 namespace async_r {
 
+namespace {
+
+// how long a pre-warmed worker may sit idle before it's recycled (the
+// library paths and package state it was forked against can grow stale)
+const double kWorkerMaxIdleMs = 5 * 60 * 1000;
+
+// number of idle workers to keep warm
+const std::size_t kMaxIdleWorkers = 2;
+
+void removeIdleWorker(PooledRWorker* pWorker);
+
+} // anonymous namespace
+
+// a pre-warmed R worker: the process is launched ahead of time with an
+// '-e' bootstrap that blocks reading a framed command from stdin, so
+// claiming jobs skip R startup (profile, package loads) entirely and
+// begin executing in milliseconds
+class PooledRWorker : public boost::enable_shared_from_this<PooledRWorker>,
+                      boost::noncopyable
+{
+public:
+   static boost::shared_ptr<PooledRWorker> warm(AsyncRProcessOptions rOptions,
+                                                const std::string& preload)
+   {
+      boost::shared_ptr<PooledRWorker> pWorker(
+               new PooledRWorker(rOptions, preload));
+      core::Error error = pWorker->launch();
+      if (error)
+      {
+         LOG_ERROR(error);
+         return boost::shared_ptr<PooledRWorker>();
+      }
+      return pWorker;
+   }
+
+   // hand a claimed worker its job -- the composed R command is framed
+   // and written to the worker's stdin on the next supervisor poll
+   void run(boost::shared_ptr<AsyncRProcess> pJob, const std::string& command)
+   {
+      std::size_t lines = std::count(command.begin(), command.end(), '\n') + 1;
+      pendingInput_ = core::safe_convert::numberToString(lines) + "\n" +
+                      command + "\n";
+      pJob_ = pJob;
+   }
+
+   bool matches(AsyncRProcessOptions rOptions,
+                const std::string& preload,
+                const std::string& libPaths) const
+   {
+      return rOptions_ == rOptions &&
+             preload_ == preload &&
+             libPaths_ == libPaths;
+   }
+
+   bool stale() const
+   {
+      return core::date_time::millisecondsSinceEpoch() - warmedAtMs_ >
+                                                         kWorkerMaxIdleMs;
+   }
+
+   // ask an idle worker to exit (it's terminated on the next poll)
+   void retire()
+   {
+      retired_ = true;
+   }
+
+private:
+   PooledRWorker(AsyncRProcessOptions rOptions, const std::string& preload)
+      : rOptions_(rOptions),
+        preload_(preload),
+        libPaths_(module_context::libPathsString()),
+        warmedAtMs_(core::date_time::millisecondsSinceEpoch()),
+        retired_(false)
+   {
+   }
+
+   core::Error launch()
+   {
+      // R binary
+      core::FilePath rProgramPath;
+      core::Error error = module_context::rScriptPath(&rProgramPath);
+      if (error)
+         return error;
+
+      // args (mirrors AsyncRProcess::start so a claimed worker behaves
+      // like a cold-started one)
+      std::vector<std::string> args;
+      args.push_back("--slave");
+      if (rOptions_ & R_PROCESS_VANILLA)
+         args.push_back("--vanilla");
+      if (rOptions_ & R_PROCESS_NO_RDATA)
+      {
+         args.push_back("--no-save");
+         args.push_back("--no-restore");
+      }
+
+#ifdef _WIN32
+      if (!r::session::utils::isR3_3() && userSettings().useInternet2())
+         args.push_back("--internet2");
+#endif
+
+      args.push_back("-e");
+
+      // bootstrap: run the preload (e.g. package loads), then block until
+      // a job arrives on stdin (a line with the command's line count,
+      // then the command itself), then execute it
+      std::string bootstrap =
+            "local({ " +
+            (preload_.empty() ? std::string() : preload_ + "; ") +
+            "con <- file('stdin', 'r'); "
+            "n <- as.integer(readLines(con, n = 1L)); "
+            "cmd <- readLines(con, n = n); "
+            "eval(parse(text = cmd), envir = globalenv()) })";
+
+#ifdef _WIN32
+      bootstrap = "\"" + bootstrap + "\"";
+#endif
+
+      args.push_back(bootstrap);
+
+      // options
+      core::system::ProcessOptions options;
+      options.terminateChildren = true;
+      if (rOptions_ & R_PROCESS_REDIRECTSTDERR)
+         options.redirectStdErrToStdOut = true;
+
+      // forward R_LIBS so the worker has access to the same libraries
+      // we do
+      core::system::Options childEnv;
+      core::system::environment(&childEnv);
+      if (!libPaths_.empty())
+         core::system::setenv(&childEnv, "R_LIBS", libPaths_);
+      options.environment = childEnv;
+
+      core::system::ProcessCallbacks cb;
+      cb.onContinue = boost::bind(&PooledRWorker::onContinue,
+                                  PooledRWorker::shared_from_this(),
+                                  _1);
+      cb.onStdout = boost::bind(&PooledRWorker::onStdout,
+                                PooledRWorker::shared_from_this(),
+                                _2);
+      cb.onStderr = boost::bind(&PooledRWorker::onStderr,
+                                PooledRWorker::shared_from_this(),
+                                _2);
+      cb.onExit = boost::bind(&PooledRWorker::onExit,
+                              PooledRWorker::shared_from_this(),
+                              _1);
+
+      return module_context::processSupervisor().runProgram(
+               rProgramPath.absolutePath(),
+               args,
+               options,
+               cb);
+   }
+
+   bool onContinue(core::system::ProcessOperations& operations)
+   {
+      if (pJob_)
+      {
+         // deliver the job command if we haven't yet
+         if (!pendingInput_.empty())
+         {
+            std::string input;
+            input.swap(pendingInput_);
+            core::Error error = operations.writeToStdin(input, true);
+            if (error)
+            {
+               LOG_ERROR(error);
+               return false;
+            }
+         }
+
+         return pJob_->onContinue();
+      }
+
+      // idle: exit when retired or when our warm state has gone stale
+      return !retired_ && !stale();
+   }
+
+   void onStdout(const std::string& output)
+   {
+      if (pJob_)
+         pJob_->onStdout(output);
+   }
+
+   void onStderr(const std::string& output)
+   {
+      if (pJob_)
+         pJob_->onStderr(output);
+   }
+
+   void onExit(int exitStatus)
+   {
+      removeIdleWorker(this);
+      if (pJob_)
+      {
+         boost::shared_ptr<AsyncRProcess> pJob = pJob_;
+         pJob_.reset();
+         pJob->onProcessCompleted(exitStatus);
+      }
+   }
+
+private:
+   AsyncRProcessOptions rOptions_;
+   std::string preload_;
+   std::string libPaths_;
+   double warmedAtMs_;
+   bool retired_;
+   std::string pendingInput_;
+   boost::shared_ptr<AsyncRProcess> pJob_;
+};
+
+namespace {
+
+// idle workers awaiting a job. NOTE: the pool is only accessed from the
+// main thread (jobs are started there and the process supervisor polls
+// there) so no synchronization is required
+std::vector<boost::shared_ptr<PooledRWorker> > s_idleWorkers;
+
+void removeIdleWorker(PooledRWorker* pWorker)
+{
+   for (std::vector<boost::shared_ptr<PooledRWorker> >::iterator
+           it = s_idleWorkers.begin(); it != s_idleWorkers.end(); ++it)
+   {
+      if (it->get() == pWorker)
+      {
+         s_idleWorkers.erase(it);
+         break;
+      }
+   }
+}
+
+// claim an idle worker compatible with the given profile; workers that
+// have gone stale are retired, while workers warmed for a different
+// profile are left in the pool for the jobs they were warmed for
+boost::shared_ptr<PooledRWorker> claimWorker(AsyncRProcessOptions rOptions,
+                                             const std::string& preload)
+{
+   std::string libPaths = module_context::libPathsString();
+
+   boost::shared_ptr<PooledRWorker> pClaimed;
+   std::vector<boost::shared_ptr<PooledRWorker> > idle;
+   BOOST_FOREACH(const boost::shared_ptr<PooledRWorker>& pWorker,
+                 s_idleWorkers)
+   {
+      if (pWorker->stale())
+         pWorker->retire();
+      else if (!pClaimed && pWorker->matches(rOptions, preload, libPaths))
+         pClaimed = pWorker;
+      else
+         idle.push_back(pWorker);
+   }
+   s_idleWorkers = idle;
+   return pClaimed;
+}
+
+// recycle idle workers when the package library changes beneath them
+// (their loaded packages and search paths may now be stale)
+void onPackageLibraryChanged()
+{
+   BOOST_FOREACH(const boost::shared_ptr<PooledRWorker>& pWorker,
+                 s_idleWorkers)
+   {
+      pWorker->retire();
+   }
+   s_idleWorkers.clear();
+}
+
+void ensureLibraryHooksRegistered()
+{
+   static bool s_registered = false;
+   if (s_registered)
+      return;
+   s_registered = true;
+
+   module_context::events().onLibPathsChanged.connect(
+            boost::bind(onPackageLibraryChanged));
+   module_context::events().onPackageLibraryMutated.connect(
+            boost::bind(onPackageLibraryChanged));
+}
+
+// keep a worker warm for the next job with this profile
+void warmWorker(AsyncRProcessOptions rOptions, const std::string& preload)
+{
+   if (s_idleWorkers.size() >= kMaxIdleWorkers)
+      return;
+
+   ensureLibraryHooksRegistered();
+
+   boost::shared_ptr<PooledRWorker> pWorker =
+         PooledRWorker::warm(rOptions, preload);
+   if (pWorker)
+      s_idleWorkers.push_back(pWorker);
+}
+
+} // anonymous namespace
+
+void warmAsyncRProcess(AsyncRProcessOptions rOptions,
+                       const std::string& preload)
+{
+   warmWorker(rOptions, preload);
+}
+
 AsyncRProcess::AsyncRProcess():
    isRunning_(false),
    terminationRequested_(false)
@@ -41,7 +349,8 @@ void AsyncRProcess::start(const char* rCommand,
                           const core::FilePath& workingDir,
                           AsyncRProcessOptions rOptions,
                           std::vector<core::FilePath> rSourceFiles,
-                          const std::string& input)
+                          const std::string& input,
+                          const std::string& preload)
 {
    // R binary
    core::FilePath rProgramPath;
@@ -100,31 +409,61 @@ void AsyncRProcess::start(const char* rCommand,
    needsQuote = strlen(rCommand) > 0 && rCommand[0] != '"';
 #endif
 
+   // add in the r source files requested, then the command itself
+   std::stringstream jobCommand;
+   for (std::vector<core::FilePath>::const_iterator it = rSourceFiles.begin();
+        it != rSourceFiles.end();
+        ++it)
+   {
+      jobCommand << "source('" << it->absolutePath() << "');";
+   }
+   jobCommand << rCommand;
+
+   // jobs with no stdin input can run on a pre-warmed worker, skipping R
+   // startup (and any preloaded packages) entirely; custom environment
+   // variables and the working directory are applied by a prelude in the
+   // delivered command, which travels over stdin and so needs no shell
+   // quoting. either way, keep the pool warm for the next job with this
+   // profile
+   if (input.empty())
+   {
+      std::stringstream prelude;
+      BOOST_FOREACH(const core::system::Option& var, environment)
+      {
+         prelude << "Sys.setenv('" << var.first << "' = '"
+                 << core::string_utils::singleQuotedStrEscape(var.second)
+                 << "');";
+      }
+      if (!workingDir.empty())
+      {
+         prelude << "setwd('"
+                 << core::string_utils::singleQuotedStrEscape(
+                       workingDir.absolutePath())
+                 << "');";
+      }
+
+      boost::shared_ptr<PooledRWorker> pWorker =
+            claimWorker(rOptions, preload);
+      warmWorker(rOptions, preload);
+      if (pWorker)
+      {
+         pWorker->run(AsyncRProcess::shared_from_this(),
+                      prelude.str() + jobCommand.str());
+         isRunning_ = true;
+         return;
+      }
+   }
+
    std::stringstream command;
    if (needsQuote)
       command << "\"";
 
-   std::string escapedCommand = rCommand;
+   std::string escapedCommand = jobCommand.str();
 
    if (needsQuote)
       boost::algorithm::replace_all(escapedCommand, "\"", "\\\"");
-    
-   if (rSourceFiles.size())
-   {
-      // add in the r source files requested
-      for (std::vector<core::FilePath>::const_iterator it = rSourceFiles.begin();
-           it != rSourceFiles.end();
-           ++it)
-      {
-         command << "source('" << it->absolutePath() << "');";
-      }
-      
-      command << escapedCommand;
-   }
-   else
-   {
-      command << escapedCommand;
-   }
+
+   command << escapedCommand;
 
    if (needsQuote)
       command << "\"";
@@ -193,6 +193,13 @@ void ClientEvent::init(int type, const json::Value& data)
    data_ = data;
    id_ = core::system::generateUuid();
 }
+
+void ClientEvent::init(int type, json::Value&& data)
+{
+   type_ = type;
+   data_ = std::move(data);
+   id_ = core::system::generateUuid();
+}
    
 void ClientEvent::asJsonObject(int id, json::Object* pObject) const
 {
@@ -17,15 +17,19 @@
 
 #include "modules/SessionConsole.hpp"
 
+#include <limits>
+
 #include <boost/foreach.hpp>
 
 
 #include <core/BoostThread.hpp>
 #include <core/Thread.hpp>
 #include <core/json/Json.hpp>
+#include <core/SafeConvert.hpp>
 #include <core/StringUtils.hpp>
 
 #include <r/session/RConsoleActions.hpp>
+#include <r/session/REventLoop.hpp>
 
 using namespace rstudio::core ;
 
@@ -33,9 +37,33 @@ namespace rstudio {
 namespace session {
  
 namespace {
+
 ClientEventQueue* s_pClientEventQueue = NULL;
+
+// memory budget for the bulk output lane -- when a flood of output
+// events exceeds it we drop the oldest events rather than OOM'ing the
+// session (the client is shown a truncation marker)
+const std::size_t kMaxBulkEventBytes = 10 * 1024 * 1024;
+
+// display budget for console output -- when code prints output faster
+// than this the middle of each batch is elided (with an explicit marker)
+// so event storms don't choke the event service or the browser. the
+// full output is still recorded (up to its own capacity limit) by
+// r::session::consoleActions
+const std::size_t kMaxConsoleOutputBytesPerSecond = 512 * 1024;
+
+std::size_t drainEvents(std::vector<ClientEvent>* pLane,
+                        std::size_t maxEvents,
+                        std::vector<ClientEvent>* pEvents)
+{
+   std::size_t count = std::min(maxEvents, pLane->size());
+   pEvents->insert(pEvents->end(), pLane->begin(), pLane->begin() + count);
+   pLane->erase(pLane->begin(), pLane->begin() + count);
+   return count;
 }
 
+} // anonymous namespace
+
 void initializeClientEventQueue()
 {
    BOOST_ASSERT(s_pClientEventQueue == NULL);
@@ -50,10 +78,45 @@ ClientEventQueue& clientEventQueue()
 ClientEventQueue::ClientEventQueue()
    :  pMutex_(new boost::mutex()),
       pWaitForEventCondition_(new boost::condition()),
+      pendingConsoleOutputBytes_(0),
+      consoleOutputWindowStart_(boost::posix_time::not_a_date_time),
+      consoleOutputWindowBytes_(0),
+      bulkEventBytes_(0),
+      droppedBulkEvents_(0),
       lastEventAddTime_(boost::posix_time::not_a_date_time)
 {
 }
 
+ClientEventQueue::EventLane ClientEventQueue::laneForEvent(
+                                                const ClientEvent& event)
+{
+   using namespace client_events;
+
+   int type = event.type();
+   if (type == kConsoleWriteOutput ||
+       type == kConsoleWriteError ||
+       type == kConsoleWritePrompt ||
+       type == kConsoleWriteInput)
+   {
+      return LaneConsole;
+   }
+   else if (type == kBuildOutput ||
+            type == kCompilePdfOutputEvent ||
+            type == kHTMLPreviewOutputEvent ||
+            type == kRmdRenderOutput ||
+            type == kRmdRSConnectDeploymentOutput ||
+            type == kChunkOutput ||
+            type == kConsoleProcessOutput ||
+            type == kTestsOutput)
+   {
+      return LaneBulk;
+   }
+   else
+   {
+      return LaneInteractive;
+   }
+}
+
 bool ClientEventQueue::setActiveConsole(const std::string& console)
 {
    bool changed = false;
@@ -74,44 +137,73 @@ bool ClientEventQueue::setActiveConsole(const std::string& console)
 }
 
 void ClientEventQueue::add(const ClientEvent& event)
-{ 
+{
+   addEvent(ClientEvent(event));
+}
+
+void ClientEventQueue::add(ClientEvent&& event)
+{
+   addEvent(std::move(event));
+}
+
+void ClientEventQueue::addEvent(ClientEvent&& event)
+{
+   // note the type before the event is (potentially) moved below
+   int eventType = event.type();
+
    LOCK_MUTEX(*pMutex_)
    {
-      // console output is batched up for compactness/efficiency.
-      if (event.type() == client_events::kConsoleWriteOutput)
+      // console output is batched up for compactness/efficiency. stdout
+      // and stderr are batched as separate segments so their exact
+      // interleaving order is preserved
+      if ((event.type() == client_events::kConsoleWriteOutput ||
+           event.type() == client_events::kConsoleWriteError) &&
+          event.data().type() == json::StringType)
       {
-         if (event.data().type() == json::StringType)
-            pendingConsoleOutput_ += event.data().get_str();
-      }
-      else if (event.type() == client_events::kConsoleWriteError &&
-               event.data().type() == json::StringType)
-      {
-         flushPendingConsoleOutput();
-         enqueueClientOutputEvent(event.type(), event.data().get_str());
+         addPendingConsoleOutput(event.type(), event.data().get_str());
       }
       else
       {
-         // flush existing console output prior to adding an 
-         // action of another type
-         flushPendingConsoleOutput() ;
-         
-         // add event to queue
-         pendingEvents_.push_back(event) ;
+         // route the event to its lane (lanes are delivered in priority
+         // order so e.g. busy/idle changes aren't stuck behind output)
+         switch (laneForEvent(event))
+         {
+            case LaneConsole:
+               // flush batched console output first to preserve
+               // ordering within the console lane
+               flushPendingConsoleOutput() ;
+               consoleEvents_.push_back(std::move(event)) ;
+               break;
+            case LaneBulk:
+               addBulkEvent(std::move(event));
+               break;
+            default:
+               pendingEvents_.push_back(std::move(event)) ;
+               break;
+         }
       }
-      
+
       lastEventAddTime_ = boost::posix_time::microsec_clock::universal_time();
+      lastEventAddTimeByType_[eventType] = lastEventAddTime_;
    }
    END_LOCK_MUTEX
-   
+
    // notify listeners that an event has been added
    pWaitForEventCondition_->notify_all();
+
+   // wake the R event loop so the event is delivered immediately
+   r::session::event_loop::signalWakeup();
 }
    
 bool ClientEventQueue::hasEvents() 
 {
    LOCK_MUTEX(*pMutex_)
    {
-      return pendingEvents_.size() > 0 || pendingConsoleOutput_.length() > 0;
+      return pendingEvents_.size() > 0 ||
+             consoleEvents_.size() > 0 ||
+             bulkEvents_.size() > 0 ||
+             droppedBulkEvents_ > 0 ||
+             pendingConsoleOutput_.size() > 0;
    }
    END_LOCK_MUTEX
    
@@ -119,21 +211,44 @@ bool ClientEventQueue::hasEvents()
    return false ;
 }
   
-void ClientEventQueue::remove(std::vector<ClientEvent>* pEvents)
+void ClientEventQueue::remove(std::vector<ClientEvent>* pEvents,
+                              std::size_t maxEvents)
 {
    LOCK_MUTEX(*pMutex_)
    {
-      // flush any pending output
+      // flush any pending output (into the console lane)
       flushPendingConsoleOutput();
-      
-      // copy the events to the caller
-      pEvents->insert(pEvents->begin(), 
-                      pendingEvents_.begin(), 
-                      pendingEvents_.end());
-   
-      // clear pending events
-      pendingEvents_.clear();
-   } 
+
+      std::size_t remaining = (maxEvents > 0)
+                           ? maxEvents
+                           : std::numeric_limits<std::size_t>::max();
+
+      // drain the lanes in priority order
+      remaining -= drainEvents(&pendingEvents_, remaining, pEvents);
+      remaining -= drainEvents(&consoleEvents_, remaining, pEvents);
+
+      // note any bulk events lost to the lane's memory budget
+      if (droppedBulkEvents_ > 0 && remaining > 0)
+      {
+         json::Object output;
+         output[kConsoleText] =
+               "\n[" + safe_convert::numberToString(droppedBulkEvents_) +
+               " output events dropped to conserve memory]\n";
+         output[kConsoleId] = activeConsole_;
+         pEvents->push_back(ClientEvent(client_events::kConsoleWriteError,
+                                        output));
+         droppedBulkEvents_ = 0;
+         remaining--;
+      }
+
+      while (!bulkEvents_.empty() && remaining > 0)
+      {
+         pEvents->push_back(bulkEvents_.front().event);
+         bulkEventBytes_ -= bulkEvents_.front().size;
+         bulkEvents_.pop_front();
+         remaining--;
+      }
+   }
    END_LOCK_MUTEX
 }
    
@@ -142,12 +257,34 @@ void ClientEventQueue::clear()
    LOCK_MUTEX(*pMutex_)
    {
       pendingConsoleOutput_.clear();
+      pendingConsoleOutputBytes_ = 0;
       pendingEvents_.clear();
+      consoleEvents_.clear();
+      bulkEvents_.clear();
+      bulkEventBytes_ = 0;
+      droppedBulkEvents_ = 0;
    }
    END_LOCK_MUTEX
 }
-  
-   
+
+void ClientEventQueue::shrinkCapacity()
+{
+   LOCK_MUTEX(*pMutex_)
+   {
+      // clear() (and normal delivery) leave the vectors empty but keep
+      // the capacity they grew to during the last output flood; swap
+      // with empty temporaries to actually return it to the heap
+      if (pendingEvents_.empty() && pendingEvents_.capacity() > 0)
+         std::vector<ClientEvent>().swap(pendingEvents_);
+      if (consoleEvents_.empty() && consoleEvents_.capacity() > 0)
+         std::vector<ClientEvent>().swap(consoleEvents_);
+      if (pendingConsoleOutput_.empty() && pendingConsoleOutput_.capacity() > 0)
+         std::vector<PendingOutput>().swap(pendingConsoleOutput_);
+   }
+   END_LOCK_MUTEX
+}
+
+
 bool ClientEventQueue::waitForEvent(
                         const boost::posix_time::time_duration& waitDuration)
 {
@@ -182,33 +319,204 @@ bool ClientEventQueue::eventAddedSince(const boost::posix_time::ptime& time)
    // keep compiler happy
    return false;
 }
-   
+
+bool ClientEventQueue::eventOfTypeAddedSince(
+                                 const std::set<int>& types,
+                                 const boost::posix_time::ptime& time)
+{
+   LOCK_MUTEX(*pMutex_)
+   {
+      for (std::set<int>::const_iterator it = types.begin();
+           it != types.end();
+           ++it)
+      {
+         std::map<int, boost::posix_time::ptime>::const_iterator timeIt =
+                                          lastEventAddTimeByType_.find(*it);
+         if (timeIt != lastEventAddTimeByType_.end() && timeIt->second >= time)
+            return true;
+      }
+      return false;
+   }
+   END_LOCK_MUTEX
+
+   // keep compiler happy
+   return false;
+}
+
+
+void ClientEventQueue::addPendingConsoleOutput(int event,
+                                               const std::string& text)
+{
+   // NOTE: private helper so no lock required (mutex is not recursive)
+
+   // coalesce runs of writes to the same stream into a single segment
+   if (!pendingConsoleOutput_.empty() &&
+       pendingConsoleOutput_.back().event == event)
+   {
+      pendingConsoleOutput_.back().text += text;
+   }
+   else
+   {
+      pendingConsoleOutput_.push_back(PendingOutput(event, text));
+   }
+   pendingConsoleOutputBytes_ += text.length();
+}
+
+// drop the middle of the pending console output, keeping the head and
+// tail within the given byte budget and inserting an explicit record of
+// how much was elided. segments are cut at line boundaries when there is
+// one so the surviving head and tail read as whole lines.
+void ClientEventQueue::elidePendingConsoleOutput(std::size_t budget)
+{
+   // NOTE: private helper so no lock required (mutex is not recursive)
+
+   std::size_t headBudget = budget / 2;
+   std::size_t tailBudget = budget - headBudget;
+
+   std::vector<PendingOutput> head;
+   std::vector<PendingOutput> tail;
+   std::size_t keptBytes = 0;
+
+   // keep whole segments (plus a leading portion of the first one that
+   // doesn't fit) from the front
+   std::size_t i = 0;
+   for ( ; i < pendingConsoleOutput_.size() && headBudget > 0; i++)
+   {
+      PendingOutput& output = pendingConsoleOutput_[i];
+      if (output.text.length() <= headBudget)
+      {
+         headBudget -= output.text.length();
+         keptBytes += output.text.length();
+         head.push_back(output);
+      }
+      else
+      {
+         std::size_t cut = output.text.rfind('\n', headBudget);
+         cut = (cut == std::string::npos) ? headBudget : cut + 1;
+         if (cut > 0)
+         {
+            head.push_back(PendingOutput(output.event,
+                                         output.text.substr(0, cut)));
+            keptBytes += cut;
+         }
+         break;
+      }
+   }
+
+   // likewise from the back (stopping short of anything the head kept)
+   std::size_t j = pendingConsoleOutput_.size();
+   for ( ; j > i && tailBudget > 0; j--)
+   {
+      PendingOutput& output = pendingConsoleOutput_[j - 1];
+      if (output.text.length() <= tailBudget)
+      {
+         tailBudget -= output.text.length();
+         keptBytes += output.text.length();
+         tail.insert(tail.begin(), output);
+      }
+      else
+      {
+         std::size_t cut = output.text.find('\n',
+                                            output.text.length() - tailBudget);
+         cut = (cut == std::string::npos) ?
+                  output.text.length() - tailBudget :
+                  cut + 1;
+         if (cut < output.text.length())
+         {
+            tail.insert(tail.begin(),
+                        PendingOutput(output.event, output.text.substr(cut)));
+            keptBytes += output.text.length() - cut;
+         }
+         break;
+      }
+   }
+
+   // record the gap explicitly so the user knows output was suppressed
+   // (the full output is still available in the console history)
+   std::size_t elidedBytes = pendingConsoleOutputBytes_ - keptBytes;
+   head.push_back(PendingOutput(
+         client_events::kConsoleWriteError,
+         "\n[" + safe_convert::numberToString(elidedBytes) +
+         " bytes of console output not displayed]\n"));
+   head.insert(head.end(), tail.begin(), tail.end());
+
+   pendingConsoleOutput_.swap(head);
+   pendingConsoleOutputBytes_ = keptBytes;
+}
 
 void ClientEventQueue::flushPendingConsoleOutput()
 {
-   // NOTE: private helper so no lock required (mutex is not recursive) 
-   
-   if ( !pendingConsoleOutput_.empty() )
+   // NOTE: private helper so no lock required (mutex is not recursive)
+
+   if (pendingConsoleOutput_.empty())
+      return;
+
+   // reset the display budget window once a second has elapsed
+   using namespace boost::posix_time;
+   ptime now = microsec_clock::universal_time();
+   if (consoleOutputWindowStart_.is_not_a_date_time() ||
+       (now - consoleOutputWindowStart_) >= seconds(1))
    {
+      consoleOutputWindowStart_ = now;
+      consoleOutputWindowBytes_ = 0;
+   }
+
+   // when output arrives faster than anyone could read it, elide the
+   // middle of the batch rather than overwhelming the event service and
+   // the browser with the contents
+   std::size_t budget =
+         (consoleOutputWindowBytes_ >= kMaxConsoleOutputBytesPerSecond) ?
+            0 :
+            kMaxConsoleOutputBytesPerSecond - consoleOutputWindowBytes_;
+   if (pendingConsoleOutputBytes_ > budget)
+      elidePendingConsoleOutput(budget);
+   consoleOutputWindowBytes_ += pendingConsoleOutputBytes_;
+
+   for (std::size_t i = 0; i < pendingConsoleOutput_.size(); i++)
+   {
+      PendingOutput& output = pendingConsoleOutput_[i];
+
       // If there's more console output than the client can even show, then
       // truncate it to the amount that the client can show. Too much output
       // can overwhelm the client, causing it to become unresponsive.
       int limit = r::session::consoleActions().capacity() + 1;
-      string_utils::trimLeadingLines(limit, &pendingConsoleOutput_);
+      string_utils::trimLeadingLines(limit, &output.text);
 
-      enqueueClientOutputEvent(client_events::kConsoleWriteOutput, 
-            pendingConsoleOutput_);
-      pendingConsoleOutput_.clear() ;
+      // the accumulated text is dead after the flush, so it can be moved
+      // into the event payload rather than copied
+      enqueueClientOutputEvent(output.event, std::move(output.text));
    }
+   pendingConsoleOutput_.clear();
+   pendingConsoleOutputBytes_ = 0;
 }
 
 void ClientEventQueue::enqueueClientOutputEvent(
-      int event, const std::string& text)
+      int event, std::string&& text)
 {
    json::Object output;
-   output[kConsoleText] = text;
+   output[kConsoleText] = json::Value(std::move(text));
    output[kConsoleId]   = activeConsole_;
-   pendingEvents_.push_back(ClientEvent(event, output)); 
+   consoleEvents_.push_back(ClientEvent(event, std::move(output)));
+}
+
+void ClientEventQueue::addBulkEvent(ClientEvent&& event)
+{
+   // NOTE: private helper so no lock required (mutex is not recursive)
+
+   // approximate the event's footprint with its serialized size
+   std::size_t size = json::write(event.data()).length();
+
+   // enforce the lane's memory budget by dropping the oldest bulk
+   // events (the client is shown a truncation marker at delivery time)
+   while (!bulkEvents_.empty() && (bulkEventBytes_ + size) > kMaxBulkEventBytes)
+   {
+      bulkEventBytes_ -= bulkEvents_.front().size;
+      bulkEvents_.pop_front();
+      droppedBulkEvents_++;
+   }
+
+   bulkEvents_.push_back(BulkEvent(std::move(event), size));
+   bulkEventBytes_ += size;
 }
 
 } // namespace session
@@ -16,7 +16,11 @@
 #ifndef SESSION_SESSION_CLIENT_EVENT_QUEUE_HPP
 #define SESSION_SESSION_CLIENT_EVENT_QUEUE_HPP
 
+#include <deque>
+#include <map>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/function.hpp>
@@ -46,17 +50,26 @@ private:
 public:
    // COPYING: boost::noncopyable
      
-   // add an event
+   // add an event. the rvalue overload moves the event (and its payload
+   // tree) into the queue, so events built in place are never deep-copied
    void add(const ClientEvent& event);
+   void add(ClientEvent&& event);
    
-   // remove all available events
-   void remove(std::vector<ClientEvent>* pEvents);
+   // remove up to maxEvents available events (0 means no limit).
+   // events are returned in lane priority order -- interactive events
+   // first, then console output, then bulk output -- so the client
+   // sees busy/idle state changes even during output floods
+   void remove(std::vector<ClientEvent>* pEvents, std::size_t maxEvents = 0);
    
    // are there any events pending?
    bool hasEvents();
    
    // clear the event queue
    void clear();
+
+   // release buffer capacity retained from previous output floods
+   // (only empty lanes are touched, so no pending events are copied)
+   void shrinkCapacity();
    
    // wait for a new event 
    bool waitForEvent(const boost::posix_time::time_duration& waitDuration);
@@ -64,16 +77,61 @@ public:
    // has an event been added since the specified time
    bool eventAddedSince(const boost::posix_time::ptime& time);
 
+   // has an event of one of the specified types been added since the
+   // specified time (used e.g. to invalidate cached rpc responses)
+   bool eventOfTypeAddedSince(const std::set<int>& types,
+                              const boost::posix_time::ptime& time);
+
    // set the active console to be attached to console events; returns true if
    // the active console changed
    bool setActiveConsole(const std::string& console);
       
-private:   
+private:
+   // lanes for prioritized delivery. bulk output events (build, render,
+   // notebook chunk output, etc.) are subject to a memory budget and may
+   // be dropped (oldest first) during output floods
+   enum EventLane
+   {
+      LaneInteractive,
+      LaneConsole,
+      LaneBulk
+   };
+   static EventLane laneForEvent(const ClientEvent& event);
+
+   void addEvent(ClientEvent&& event);
+
+   void addPendingConsoleOutput(int event, const std::string& text);
+   void elidePendingConsoleOutput(std::size_t budget);
    void flushPendingConsoleOutput();
 
-   void enqueueClientOutputEvent(int event, const std::string& text);
- 
+   void enqueueClientOutputEvent(int event, std::string&& text);
+
+   void addBulkEvent(ClientEvent&& event);
+
 private:
+   struct BulkEvent
+   {
+      BulkEvent(ClientEvent&& event, std::size_t size)
+         : event(std::move(event)), size(size)
+      {
+      }
+
+      ClientEvent event;
+      std::size_t size;
+   };
+
+   struct PendingOutput
+   {
+      PendingOutput(int event, const std::string& text)
+         : event(event), text(text)
+      {
+      }
+
+      int event;
+      std::string text;
+   };
+
+
    // synchronization objects. heap based so they are never destructed
    // we don't want them destructed because in desktop mode we don't
    // explicitly stop the queue and this sometimes results in mutex
@@ -83,12 +141,26 @@ private:
    boost::condition* pWaitForEventCondition_ ;
 
    // instance data
-   std::string pendingConsoleOutput_ ;
+
+   // console output batched between flushes. stdout and stderr are kept
+   // as separate typed segments so batching preserves their exact
+   // interleaving order
+   std::vector<PendingOutput> pendingConsoleOutput_ ;
+   std::size_t pendingConsoleOutputBytes_;
+
+   // per-second display budget for console output (see
+   // flushPendingConsoleOutput)
+   boost::posix_time::ptime consoleOutputWindowStart_;
+   std::size_t consoleOutputWindowBytes_;
+
    std::string activeConsole_;
-   std::vector<ClientEvent> pendingEvents_ ; 
+   std::vector<ClientEvent> pendingEvents_ ;       // interactive lane
+   std::vector<ClientEvent> consoleEvents_ ;       // console lane
+   std::deque<BulkEvent> bulkEvents_ ;             // bulk output lane
+   std::size_t bulkEventBytes_;
+   std::size_t droppedBulkEvents_;
    boost::posix_time::ptime lastEventAddTime_;
-   
-
+   std::map<int, boost::posix_time::ptime> lastEventAddTimeByType_;
 };
 
 } // namespace session
@@ -14,13 +14,20 @@
  */
 
 #include <algorithm>
+#include <cstring>
+#include <map>
 
+#include <zlib.h>
+
+#include <boost/cstdint.hpp>
 #include <boost/function.hpp>
+#include <boost/algorithm/string/predicate.hpp>
 
 #include <core/BoostThread.hpp>
 #include <core/Log.hpp>
 #include <core/Error.hpp>
 #include <core/BoostErrors.hpp>
+#include <core/SafeConvert.hpp>
 #include <core/Thread.hpp>
 #include <core/system/System.hpp>
 #include <core/Macros.hpp>
@@ -31,6 +38,7 @@
 #include <session/SessionOptions.hpp>
 #include <session/SessionHttpConnectionListener.hpp>
 #include <session/SessionClientEventService.hpp>
+#include <session/SessionClientEventSocket.hpp>
 
 #include "SessionClientEventQueue.hpp"
 
@@ -43,6 +51,197 @@ namespace {
 
 const int kLastChanceWaitSeconds = 4;
 
+// maximum events to deliver per batch -- during output floods the
+// remainder is delivered in subsequent batches (the client re-requests
+// immediately when events are still pending) rather than as one giant
+// response
+const std::size_t kMaxEventsPerBatch = 250;
+
+// long-poll hold times. with a single-response connection the timeout
+// response is also the idle heartbeat, so every hold expiry costs a
+// full connection cycle. each poll that expires with no events doubles
+// the hold for the next one (an idle session on a stable link settles
+// at the maximum, cutting its connection setup rate by an order of
+// magnitude) and any delivered event resets it. the client can cap the
+// hold via an optional second get_events parameter and learns the next
+// hold from the next_hold_seconds response field so it can keep its own
+// request timeout above it
+const long kDefaultHoldSeconds = 50;
+const long kMaxHoldSeconds = 600;
+
+long nextHoldSeconds(int consecutiveIdlePolls, int clientMaxHoldSeconds)
+{
+   // a client that didn't negotiate a cap has a request timeout sized
+   // for the legacy hold -- growing past it would just make the client
+   // abort and re-poll, which is the churn we're trying to eliminate
+   if (clientMaxHoldSeconds <= 0)
+      return kDefaultHoldSeconds;
+
+   long holdSeconds = kDefaultHoldSeconds;
+   while (consecutiveIdlePolls-- > 0 && holdSeconds < kMaxHoldSeconds)
+      holdSeconds *= 2;
+   holdSeconds = std::min(holdSeconds, kMaxHoldSeconds);
+   return std::min(holdSeconds, (long)clientMaxHoldSeconds);
+}
+
+// WebSocket event channel (optional push alternative to the get_events
+// long-poll; see SessionClientEventSocket.hpp)
+ClientEventSocket s_eventSocket;
+
+// Binary event wire format. A client that understands it opts in by
+// sending this control message over the socket; until then (and for
+// clients that never send it) events go out as JSON text, so unknown
+// clients keep working unchanged. Once negotiated, each WebSocket
+// binary message is a raw-deflate compressed concatenation of frames,
+// one per event:
+//
+//   uint32le  frame length (bytes following this field)
+//   uint32le  event id
+//   uint16le  event type tag
+//   uint8     flags (see kFrameFlag constants)
+//   [uint8 nameLen + name bytes]   if kFrameFlagDefinesTypeTag
+//   payload bytes
+//
+// type tags are assigned per-connection on first use -- the defining
+// frame carries the type name, subsequent frames just the tag. when the
+// event data is a plain string (console output, build output, etc.) the
+// payload is its raw UTF-8 bytes rather than a JSON-quoted copy; for
+// everything else it's the JSON serialization of the data value. the
+// deflate context persists across messages (each is terminated with a
+// sync flush), so the repetitive payloads of an output flood compress
+// against earlier messages instead of starting cold every time
+const char * const kBinaryProtocolMessage = "binary";
+
+const boost::uint8_t kFrameFlagRawStringPayload = 0x01;
+const boost::uint8_t kFrameFlagDefinesTypeTag = 0x02;
+
+void appendUint16(boost::uint16_t value, std::string* pBuffer)
+{
+   char bytes[2] = { static_cast<char>(value & 0xFF),
+                     static_cast<char>((value >> 8) & 0xFF) };
+   pBuffer->append(bytes, 2);
+}
+
+void appendUint32(boost::uint32_t value, std::string* pBuffer)
+{
+   char bytes[4] = { static_cast<char>(value & 0xFF),
+                     static_cast<char>((value >> 8) & 0xFF),
+                     static_cast<char>((value >> 16) & 0xFF),
+                     static_cast<char>((value >> 24) & 0xFF) };
+   pBuffer->append(bytes, 4);
+}
+
+void appendEventFrame(const json::Object& event,
+                      std::map<std::string, boost::uint16_t>* pTypeTags,
+                      std::string* pFrames)
+{
+   int id = event.find("id")->second.get_int();
+   std::string type = event.find("type")->second.get_str();
+   const json::Value& data = event.find("data")->second;
+
+   boost::uint8_t flags = 0;
+
+   // the hot event types all carry a plain string -- send its UTF-8
+   // bytes directly
+   std::string payload;
+   if (data.type() == json::StringType)
+   {
+      payload = data.get_str();
+      flags |= kFrameFlagRawStringPayload;
+   }
+   else
+   {
+      payload = json::write(data);
+   }
+
+   // look up the type tag, defining it in-frame on first use
+   std::string definition;
+   boost::uint16_t tag;
+   std::map<std::string, boost::uint16_t>::const_iterator it =
+                                                   pTypeTags->find(type);
+   if (it != pTypeTags->end())
+   {
+      tag = it->second;
+   }
+   else
+   {
+      tag = static_cast<boost::uint16_t>(pTypeTags->size());
+      (*pTypeTags)[type] = tag;
+      flags |= kFrameFlagDefinesTypeTag;
+      definition.push_back(static_cast<char>(type.size()));
+      definition.append(type);
+   }
+
+   appendUint32(static_cast<boost::uint32_t>(
+                  4 + 2 + 1 + definition.size() + payload.size()),
+                pFrames);
+   appendUint32(static_cast<boost::uint32_t>(id), pFrames);
+   appendUint16(tag, pFrames);
+   pFrames->push_back(static_cast<char>(flags));
+   pFrames->append(definition);
+   pFrames->append(payload);
+}
+
+// raw-deflate compressor whose context survives across messages (the
+// client holds a matching raw inflate context for the connection)
+class EventStreamDeflater : boost::noncopyable
+{
+public:
+   EventStreamDeflater() : initialized_(false)
+   {
+   }
+
+   ~EventStreamDeflater()
+   {
+      if (initialized_)
+         ::deflateEnd(&stream_);
+   }
+
+   // discard accumulated compression state (on reconnect the client's
+   // inflate context starts fresh)
+   void reset()
+   {
+      if (initialized_)
+         ::deflateReset(&stream_);
+   }
+
+   bool deflate(const std::string& input, std::string* pOutput)
+   {
+      if (!initialized_)
+      {
+         std::memset(&stream_, 0, sizeof(stream_));
+
+         // negative window bits selects raw deflate (no zlib header)
+         if (::deflateInit2(&stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                            -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            return false;
+         initialized_ = true;
+      }
+
+      pOutput->clear();
+      stream_.next_in = reinterpret_cast<Bytef*>(
+                                    const_cast<char*>(input.data()));
+      stream_.avail_in = static_cast<uInt>(input.size());
+
+      char buffer[16384];
+      do
+      {
+         stream_.next_out = reinterpret_cast<Bytef*>(buffer);
+         stream_.avail_out = sizeof(buffer);
+         if (::deflate(&stream_, Z_SYNC_FLUSH) != Z_OK)
+            return false;
+         pOutput->append(buffer, sizeof(buffer) - stream_.avail_out);
+      }
+      while (stream_.avail_out == 0);
+
+      return true;
+   }
+
+private:
+   bool initialized_;
+   z_stream stream_;
+};
+
 bool hasEventIdLessThanOrEqualTo(const json::Value& event, int targetId)
 {
    const json::Object& eventJSON = event.get_obj();
@@ -74,21 +273,71 @@ Error ClientEventService::start(const std::string& clientId)
    try
    {
       using boost::bind;
-      boost::thread serviceThread(bind(&ClientEventService::run, this));       
+      boost::thread serviceThread(bind(&ClientEventService::run, this));
       serviceThread_ = MOVE_THREAD(serviceThread);
-      
-      return Success();
    }
    catch(const boost::thread_resource_error& e)
    {
-      return Error(boost::thread_error::ec_from_exception(e), ERROR_LOCATION);       
+      return Error(boost::thread_error::ec_from_exception(e), ERROR_LOCATION);
    }
+
+   // optionally start the WebSocket event channel. failure to start it
+   // isn't fatal -- the client just falls back to the get_events long-poll
+   if (session::options().webSocketEvents())
+   {
+      using boost::bind;
+
+      ClientEventSocketCallbacks callbacks;
+      callbacks.validateConnection = bind(
+            &ClientEventService::validateEventSocketConnection, this, _1);
+      callbacks.onClientConnected = bind(
+            &ClientEventService::onEventSocketConnected, this);
+      callbacks.onClientMessage = bind(
+            &ClientEventService::onEventSocketMessage, this, _1);
+
+      Error socketError = s_eventSocket.ensureServerRunning(callbacks);
+      if (socketError)
+      {
+         LOG_ERROR(socketError);
+      }
+      else
+      {
+         try
+         {
+            boost::thread socketThread(
+                     bind(&ClientEventService::runEventSocket, this));
+            eventSocketThread_ = MOVE_THREAD(socketThread);
+         }
+         catch(const boost::thread_resource_error& e)
+         {
+            LOG_ERROR(Error(boost::thread_error::ec_from_exception(e),
+                            ERROR_LOCATION));
+            s_eventSocket.stopServer();
+         }
+      }
+   }
+
+   return Success();
 }
    
 void ClientEventService::stop()
 {
    try
    {
+      if (eventSocketThread_.joinable())
+      {
+         eventSocketThread_.interrupt();
+
+         if (!eventSocketThread_.timed_join(
+               boost::posix_time::seconds(kLastChanceWaitSeconds + 1)))
+         {
+            LOG_WARNING_MESSAGE("event socket thread didn't stop on its own");
+         }
+
+         eventSocketThread_.detach();
+      }
+      s_eventSocket.stopServer();
+
       if (serviceThread_.joinable())
       {
          serviceThread_.interrupt();
@@ -125,6 +374,11 @@ void ClientEventService::setClientId(const std::string& clientId, bool clearEven
       clientEventQueue().clear();
 }
    
+int ClientEventService::eventSocketPort()
+{
+   return s_eventSocket.port();
+}
+
 std::string ClientEventService::clientId()
 {
    LOCK_MUTEX(mutex_)
@@ -183,6 +437,89 @@ void ClientEventService::setClientEventResult(
    END_LOCK_MUTEX
 }
 
+void ClientEventService::syncNextEventId(int lastClientEventIdSeen)
+{
+   LOCK_MUTEX(mutex_)
+   {
+      // sync next event id to the client (required so that when we resume
+      // from a suspend we provide client event ids in line with the
+      // client's expectations -- if we started with zero then the client
+      // would never see any events!)
+      nextEventId_ = std::max(nextEventId_, lastClientEventIdSeen + 1);
+   }
+   END_LOCK_MUTEX
+}
+
+void ClientEventService::collectPendingEvents(std::size_t maxEvents)
+{
+   // deque the events (batched)
+   std::vector<ClientEvent> events;
+   session::clientEventQueue().remove(&events, maxEvents);
+
+   // convert to json and add event ids
+   LOCK_MUTEX(mutex_)
+   {
+      for (std::vector<ClientEvent>::const_iterator
+           it = events.begin(); it != events.end(); ++it)
+      {
+         json::Object event ;
+         it->asJsonObject(nextEventId_++, &event);
+         clientEvents_.push_back(event);
+      }
+   }
+   END_LOCK_MUTEX
+}
+
+bool ClientEventService::validateEventSocketConnection(
+                                                const std::string& resource)
+{
+   // require the active client id as the connection resource (e.g.
+   // /events/<client-id>) so that another local user can't attach to
+   // the event stream
+   std::string id = clientId();
+   return !id.empty() && boost::algorithm::ends_with(resource, "/" + id);
+}
+
+void ClientEventService::onEventSocketConnected()
+{
+   LOCK_MUTEX(mutex_)
+   {
+      // replay events the client hasn't acknowledged yet
+      lastEventSocketIdSent_ = -1;
+
+      // every connection renegotiates the wire format; bumping the
+      // generation tells the sender thread to discard its compression
+      // context and type tag dictionary
+      binaryEventProtocol_ = false;
+      eventSocketGeneration_++;
+   }
+   END_LOCK_MUTEX
+}
+
+void ClientEventService::onEventSocketMessage(const std::string& message)
+{
+   // opt-in control message switching the connection to the compact
+   // binary wire format (see runEventSocket)
+   if (message == kBinaryProtocolMessage)
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         binaryEventProtocol_ = true;
+      }
+      END_LOCK_MUTEX
+      return;
+   }
+
+   // the client acknowledges delivery by sending the last event id it
+   // has seen over the socket
+   int lastClientEventIdSeen = safe_convert::stringTo<int>(message, -1);
+   if (lastClientEventIdSeen >= 0)
+   {
+      erasePreviouslyDeliveredEvents(lastClientEventIdSeen);
+      syncNextEventId(lastClientEventIdSeen);
+   }
+}
+
 
 void ClientEventService::run()
 {
@@ -190,10 +527,12 @@ void ClientEventService::run()
    {    
       // default time durations
       using namespace boost::posix_time;
-      time_duration maxRequestSec = seconds(50);
       time_duration batchDelay = milliseconds(20);
       time_duration maxTotalBatchDelay = seconds(2);
 
+      // adaptive hold state (single-threaded accept loop so plain locals)
+      int consecutiveIdlePolls = 0;
+
       // make much shorter for desktop mode
       if (options().programMode() == kSessionProgramModeDesktop)
       {
@@ -203,10 +542,7 @@ void ClientEventService::run()
       
       // get alias to client event queue
       ClientEventQueue& clientEventQueue = session::clientEventQueue();
-      
-      // initialize state
-      int nextEventId = 0;
-      
+
       // accept loop
       bool stopServer = false ;
       while (!stopServer || clientEventQueue.hasEvents())
@@ -274,20 +610,32 @@ void ClientEventService::run()
             ptrConnection->sendJsonRpcError(paramError);
             continue;
          }
-           
+
+         // get the client's hold time cap if it provided one (older
+         // clients just poll with the single parameter)
+         int clientMaxHoldSeconds = 0;
+         if (request.params.size() > 1)
+         {
+            Error error = json::readParam(request.params,
+                                          1,
+                                          &clientMaxHoldSeconds);
+            if (error)
+               clientMaxHoldSeconds = 0;
+         }
+
+
          // remove all events already seen by the client from our internal list
          erasePreviouslyDeliveredEvents(lastClientEventIdSeen);
 
-         // sync next event id to client (required so that when we resume
-         // from a suspend we provide client event ids in line with the 
-         // client's expectations -- if we started with zero then the client
-         // would never see any events!)
-         nextEventId = std::max(nextEventId, lastClientEventIdSeen + 1);
+         // sync next event id to client
+         syncNextEventId(lastClientEventIdSeen);
 
          // check for events (and wait a specified internal if there are none)
          try
          {
-            // wait for the specified maximum time
+            // wait for up to the negotiated hold time
+            time_duration maxRequestSec = seconds(
+                  nextHoldSeconds(consecutiveIdlePolls, clientMaxHoldSeconds));
             if (havePendingClientEvents() || clientEventQueue.hasEvents() ||
                 clientEventQueue.waitForEvent(maxRequestSec))
             {
@@ -320,18 +668,16 @@ void ClientEventService::run()
          // events on the next iteration of the accept loop
          if (request.clientId == clientId())
          {
-            // deque the events
-            std::vector<ClientEvent> events;
-            clientEventQueue.remove(&events);
-            
-            // convert to json and add event id
-            for (std::vector<ClientEvent>::const_iterator 
-                 it = events.begin(); it != events.end(); ++it)
-            {
-               json::Object event ;
-               it->asJsonObject(nextEventId++, &event);
-               addClientEvent(event);
-            }
+            // deque the events (batched) and assign them event ids
+            collectPendingEvents(kMaxEventsPerBatch);
+
+            // adapt the hold time: an empty (heartbeat) response means
+            // the session is idle, so back off toward the maximum hold;
+            // delivered events mean activity, so snap back to the default
+            if (havePendingClientEvents())
+               consecutiveIdlePolls = 0;
+            else
+               consecutiveIdlePolls++;
 
             // send them (pass false for kEventsPending b/c responses from the
             // event service shouldn't interact with automatic event service
@@ -339,6 +685,9 @@ void ClientEventService::run()
             json::JsonRpcResponse response;
             setClientEventResult(&response);
             response.setField(kEventsPending, "false");
+            response.setField("next_hold_seconds",
+                              (int)nextHoldSeconds(consecutiveIdlePolls,
+                                                   clientMaxHoldSeconds));
             ptrConnection->sendJsonRpcResponse(response);
          }
          else
@@ -350,6 +699,142 @@ void ClientEventService::run()
    }
    CATCH_UNEXPECTED_EXCEPTION
 }
-      
+
+void ClientEventService::runEventSocket()
+{
+   try
+   {
+      // get alias to client event queue
+      ClientEventQueue& clientEventQueue = session::clientEventQueue();
+
+      // per-connection binary protocol state (only this thread sends,
+      // so these live here; a generation mismatch means a new client
+      // connected and they must start over)
+      EventStreamDeflater deflater;
+      std::map<std::string, boost::uint16_t> typeTags;
+      int deflaterGeneration = 0;
+
+      while (true)
+      {
+         try
+         {
+            // wait for an event to arrive (the wait also serves as our
+            // interruption point while the channel is quiet)
+            bool haveEvents = clientEventQueue.waitForEvent(
+                                 boost::posix_time::milliseconds(250)) ||
+                              clientEventQueue.hasEvents() ||
+                              havePendingClientEvents();
+
+            if (boost::this_thread::interruption_requested())
+               throw boost::thread_interrupted();
+
+            if (!haveEvents)
+               continue;
+         }
+         catch(const boost::thread_interrupted&)
+         {
+            break;
+         }
+
+         // if no client is attached to the socket then leave the events
+         // queued -- the get_events long-poll will deliver them
+         if (!s_eventSocket.isConnected())
+            continue;
+
+         // deque the events (batched) and assign them event ids
+         collectPendingEvents(kMaxEventsPerBatch);
+
+         // collect events the socket hasn't delivered yet. events stay in
+         // clientEvents_ until acknowledged so they are replayed on
+         // reconnect (or picked up by the long-poll fallback)
+         json::Array events;
+         int maxEventId = -1;
+         bool binaryProtocol = false;
+         int socketGeneration = 0;
+         LOCK_MUTEX(mutex_)
+         {
+            binaryProtocol = binaryEventProtocol_;
+            socketGeneration = eventSocketGeneration_;
+
+            for (json::Array::const_iterator it = clientEvents_.begin();
+                 it != clientEvents_.end(); ++it)
+            {
+               int eventId = it->get_obj().find("id")->second.get_int();
+               if (eventId > lastEventSocketIdSent_)
+               {
+                  events.push_back(*it);
+                  maxEventId = std::max(maxEventId, eventId);
+               }
+            }
+         }
+         END_LOCK_MUTEX
+
+         if (events.empty())
+            continue;
+
+         // push them to the client; on failure (e.g. the client
+         // disconnected mid-send) the events remain queued for replay
+         Error error;
+         if (binaryProtocol)
+         {
+            // fresh connection: the client's inflate context and type
+            // tag dictionary both start empty
+            if (socketGeneration != deflaterGeneration)
+            {
+               deflater.reset();
+               typeTags.clear();
+               deflaterGeneration = socketGeneration;
+            }
+
+            // assign tags against a scratch copy of the dictionary and
+            // commit it only after a successful send -- if the send
+            // fails the replay must re-emit any in-frame definitions
+            std::map<std::string, boost::uint16_t> scratchTags = typeTags;
+            std::string frames;
+            for (json::Array::const_iterator it = events.begin();
+                 it != events.end(); ++it)
+            {
+               appendEventFrame(it->get_obj(), &scratchTags, &frames);
+            }
+
+            std::string compressed;
+            if (deflater.deflate(frames, &compressed))
+            {
+               error = s_eventSocket.sendBinary(compressed);
+               if (!error)
+                  typeTags.swap(scratchTags);
+            }
+            else
+            {
+               // the compressed stream can't be continued; drop back to
+               // JSON text for the remainder of this connection (text
+               // frames are always interpreted as JSON by the client)
+               LOCK_MUTEX(mutex_)
+               {
+                  binaryEventProtocol_ = false;
+               }
+               END_LOCK_MUTEX
+
+               error = s_eventSocket.send(json::write(events));
+            }
+         }
+         else
+         {
+            error = s_eventSocket.send(json::write(events));
+         }
+         if (error)
+            continue;
+
+         LOCK_MUTEX(mutex_)
+         {
+            lastEventSocketIdSent_ = std::max(lastEventSocketIdSent_,
+                                              maxEventId);
+         }
+         END_LOCK_MUTEX
+      }
+   }
+   CATCH_UNEXPECTED_EXCEPTION
+}
+
 } // namespace session
 } // namespace rstudio
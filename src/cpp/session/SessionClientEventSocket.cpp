@@ -0,0 +1,278 @@
+/*
+ * SessionClientEventSocket.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <session/SessionClientEventSocket.hpp>
+#include <session/SessionHttpConnectionListener.hpp>
+#include <session/SessionOptions.hpp>
+
+#include "http/SessionTcpIpHttpConnectionListener.hpp"
+
+#include <core/FilePath.hpp>
+
+namespace rstudio {
+namespace session {
+
+using namespace rstudio::core;
+
+ClientEventSocket::ClientEventSocket()
+   : port_(0),
+     serverRunning_(false),
+     connected_(false)
+{
+}
+
+ClientEventSocket::~ClientEventSocket()
+{
+   try
+   {
+      stopServer();
+   }
+   CATCH_UNEXPECTED_EXCEPTION
+}
+
+Error ClientEventSocket::ensureServerRunning(
+                              const ClientEventSocketCallbacks& callbacks)
+{
+   if (serverRunning_)
+      return Success();
+
+   callbacks_ = callbacks;
+
+   // pick a random port (same strategy as the terminal websocket)
+   long port = 3000 + (rand() % 5000);
+   unsigned portRetries = 0;
+
+   try
+   {
+      pwsServer_.reset(new eventServer());
+
+      pwsServer_->set_access_channels(websocketpp::log::alevel::none);
+      pwsServer_->init_asio();
+
+      pwsServer_->set_message_handler(
+               boost::bind(&ClientEventSocket::onMessage, this, &*pwsServer_, _1, _2));
+      pwsServer_->set_close_handler(
+               boost::bind(&ClientEventSocket::onClose, this, &*pwsServer_, _1));
+      pwsServer_->set_open_handler(
+               boost::bind(&ClientEventSocket::onOpen, this, &*pwsServer_, _1));
+
+      // try to bind to the given port
+      do
+      {
+         try
+         {
+            if (session::options().standalone())
+            {
+               // in standalone mode bind to the same address that the
+               // server bound to
+               TcpIpHttpConnectionListener& listener =
+                     static_cast<TcpIpHttpConnectionListener&>(httpConnectionListener());
+
+               boost::asio::ip::tcp::endpoint endpoint = listener.getLocalEndpoint();
+               pwsServer_->listen(endpoint.address(), static_cast<uint16_t>(port));
+            }
+            else
+            {
+#if !defined(_WIN32) && !defined(__APPLE__)
+               if (core::FilePath("/proc/net/if_inet6").exists())
+               {
+                  // listen will fail without ipv6 support on the machine so we
+                  // only use it for machines with a ipv6 stack
+                  pwsServer_->listen(boost::asio::ip::tcp::v6(), port);
+               }
+               else
+#endif
+               {
+                  // no ipv6 support, fall back to ipv4
+                  pwsServer_->listen(boost::asio::ip::tcp::v4(), static_cast<uint16_t>(port));
+               }
+            }
+
+            pwsServer_->start_accept();
+            break;
+         }
+         catch (websocketpp::exception const& e)
+         {
+            // fail if this isn't the code we're expecting
+            // (we're only trying to deal with address in use errors here)
+            if (e.code() != websocketpp::transport::asio::error::pass_through)
+            {
+               return systemError(boost::system::errc::invalid_argument,
+                                  e.what(), ERROR_LOCATION);
+            }
+
+            // try another random port
+            port = 3000 + (rand() % 5000);
+         }
+      }
+      while (++portRetries < 20);
+
+      // if we used up all our retries, abort now
+      if (portRetries == 20)
+      {
+         return systemError(boost::system::errc::not_supported,
+                            "Couldn't find an available port",
+                            ERROR_LOCATION);
+      }
+
+      // start server
+      core::thread::safeLaunchThread(
+               boost::bind(&ClientEventSocket::watchSocket, this),
+               &websocketThread_);
+
+      port_ = port;
+      serverRunning_ = true;
+   }
+   catch (websocketpp::exception const& e)
+   {
+      LOG_ERROR_MESSAGE(e.what());
+      return systemError(boost::system::errc::invalid_argument,
+                            e.what(), ERROR_LOCATION);
+   }
+   CATCH_UNEXPECTED_EXCEPTION
+
+   return Success();
+}
+
+void ClientEventSocket::stopServer()
+{
+   try
+   {
+      if (serverRunning_)
+      {
+         {
+            boost::unique_lock<boost::mutex> lock(mutex_);
+            connected_ = false;
+         }
+
+         pwsServer_->stop();
+         serverRunning_ = false;
+         port_ = 0;
+         websocketThread_.join();
+         pwsServer_.reset();
+      }
+   }
+   catch (websocketpp::exception const& e)
+   {
+      LOG_ERROR_MESSAGE(e.what());
+   }
+   CATCH_UNEXPECTED_EXCEPTION
+}
+
+bool ClientEventSocket::isConnected() const
+{
+   boost::unique_lock<boost::mutex> lock(mutex_);
+   return connected_;
+}
+
+Error ClientEventSocket::send(const std::string& message)
+{
+   return sendMessage(message, websocketpp::frame::opcode::text);
+}
+
+Error ClientEventSocket::sendBinary(const std::string& message)
+{
+   return sendMessage(message, websocketpp::frame::opcode::binary);
+}
+
+Error ClientEventSocket::sendMessage(const std::string& message,
+                                     websocketpp::frame::opcode::value opcode)
+{
+   websocketpp::connection_hdl hdl;
+   {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      if (!connected_)
+      {
+         return systemError(boost::system::errc::not_connected,
+                            ERROR_LOCATION);
+      }
+      hdl = hdl_;
+   }
+
+   websocketpp::lib::error_code ec;
+   pwsServer_->send(hdl, message, opcode, ec);
+   if (ec)
+   {
+      return systemError(boost::system::errc::bad_message,
+                         ec.message(), ERROR_LOCATION);
+   }
+   return Success();
+}
+
+int ClientEventSocket::port() const
+{
+   return port_;
+}
+
+void ClientEventSocket::watchSocket()
+{
+   pwsServer_->run();
+}
+
+void ClientEventSocket::onMessage(eventServer* s,
+                                  websocketpp::connection_hdl hdl,
+                                  eventMessage_ptr msg)
+{
+   if (callbacks_.onClientMessage)
+      callbacks_.onClientMessage(msg->get_payload());
+}
+
+void ClientEventSocket::onClose(eventServer* s, websocketpp::connection_hdl hdl)
+{
+   bool wasActive = false;
+   {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      // only mark disconnected if this is the active connection (a
+      // newer connection may have already displaced this one)
+      if (connected_ && !hdl.owner_before(hdl_) && !hdl_.owner_before(hdl))
+      {
+         connected_ = false;
+         wasActive = true;
+      }
+   }
+
+   if (wasActive && callbacks_.onClientDisconnected)
+      callbacks_.onClientDisconnected();
+}
+
+void ClientEventSocket::onOpen(eventServer* s, websocketpp::connection_hdl hdl)
+{
+   // validate the connection (e.g. require the active client id in
+   // the request resource); reject it outright on failure
+   if (callbacks_.validateConnection)
+   {
+      websocketpp::lib::error_code ec;
+      eventServer::connection_ptr con = s->get_con_from_hdl(hdl, ec);
+      if (ec.value() > 0 || !callbacks_.validateConnection(con->get_resource()))
+      {
+         websocketpp::lib::error_code closeEc;
+         s->close(hdl, websocketpp::close::status::policy_violation,
+                  "invalid client", closeEc);
+         return;
+      }
+   }
+
+   {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      hdl_ = hdl;
+      connected_ = true;
+   }
+
+   if (callbacks_.onClientConnected)
+      callbacks_.onClientConnected();
+}
+
+} // namespace session
+} // namespace rstudio
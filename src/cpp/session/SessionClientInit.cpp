@@ -46,6 +46,7 @@
 #include <r/session/RConsoleHistory.hpp>
 #include <r/ROptions.hpp>
 
+#include <core/Hash.hpp>
 #include <core/json/Json.hpp>
 #include <core/json/JsonRpc.hpp>
 #include <core/http/Request.hpp>
@@ -73,6 +74,146 @@ extern "C" const char *locale2charset(const char *);
 namespace rstudio {
 namespace session {
 namespace client_init {
+namespace {
+
+// cached copy of the session info fields which can't change for the
+// lifetime of the session, along with the ETag computed from them. the
+// client revalidates this section with If-None-Match on refresh so we
+// neither recompute nor resend it when it's already current
+json::Object s_invariantSessionInfo;
+std::string s_invariantETag;
+
+void buildInvariantSessionInfo(json::Object* pSessionInfo)
+{
+   // alias options
+   Options& options = session::options();
+
+   json::Object& sessionInfo = *pSessionInfo;
+   sessionInfo["mode"] = options.programMode();
+
+   sessionInfo["userIdentity"] = options.userIdentity();
+
+   // only send log_dir and scratch_dir if we are in desktop mode
+   if (options.programMode() == kSessionProgramModeDesktop)
+   {
+      sessionInfo["log_dir"] = options.userLogPath().absolutePath();
+      sessionInfo["scratch_dir"] = options.userScratchPath().absolutePath();
+   }
+
+   // temp dir
+   FilePath tempDir = rstudio::r::session::utils::tempDir();
+   Error error = tempDir.ensureDirectory();
+   if (error)
+      LOG_ERROR(error);
+   sessionInfo["temp_dir"] = tempDir.absolutePath();
+
+   // R_LIBS_USER
+   sessionInfo["r_libs_user"] = module_context::rLibsUser();
+
+   // user home path
+   sessionInfo["user_home_path"] = session::options().userHomePath().absolutePath();
+
+   // installed client version
+   sessionInfo["client_version"] = http_methods::clientVersion();
+
+   // docs url
+   sessionInfo["docsURL"] = session::options().docsURL();
+
+   sessionInfo["console_actions_limit"] =
+                        rstudio::r::session::consoleActions().capacity();
+
+   sessionInfo["rstudio_version"] = std::string(RSTUDIO_VERSION);
+
+   // default project dir
+   sessionInfo["default_project_dir"] = options.defaultProjectDir();
+
+   sessionInfo["system_encoding"] = std::string(::locale2charset(NULL));
+
+   sessionInfo["default_ssh_key_dir"] =module_context::createAliasedPath(
+                              modules::source_control::defaultSshKeyDir());
+
+   // send sumatra pdf exe path if we are on windows
+#ifdef _WIN32
+   sessionInfo["sumatra_pdf_exe_path"] =
+               options.sumatraPath().complete("SumatraPDF.exe").absolutePath();
+#endif
+
+   sessionInfo["presentation_commands"] = options.allowPresentationCommands();
+
+   sessionInfo["tutorial_api_available"] = false;
+   sessionInfo["tutorial_api_client_origin"] = json::Value();
+
+   sessionInfo["disable_packages"] = module_context::disablePackages();
+
+   sessionInfo["disable_check_for_updates"] =
+          !core::system::getenv("RSTUDIO_DISABLE_CHECK_FOR_UPDATES").empty();
+
+   sessionInfo["allow_vcs_exe_edit"] = options.allowVcsExecutableEdit();
+   sessionInfo["allow_cran_repos_edit"] = options.allowCRANReposEdit();
+   sessionInfo["allow_vcs"] = options.allowVcs();
+   sessionInfo["allow_pkg_install"] = options.allowPackageInstallation();
+   sessionInfo["allow_shell"] = options.allowShell();
+   sessionInfo["allow_terminal_websockets"] = options.allowTerminalWebsockets();
+   sessionInfo["allow_file_download"] = options.allowFileDownloads();
+   sessionInfo["allow_file_upload"] = options.allowFileUploads();
+   sessionInfo["allow_remove_public_folder"] = options.allowRemovePublicFolder();
+   sessionInfo["allow_full_ui"] = options.allowFullUI();
+   sessionInfo["websocket_ping_interval"] = options.webSocketPingInterval();
+   sessionInfo["websocket_connect_timeout"] = options.webSocketConnectTimeout();
+
+   // port of the WebSocket event channel (0 when disabled; the client
+   // then uses the get_events long-poll exclusively)
+   sessionInfo["event_socket_port"] = clientEventService().eventSocketPort();
+
+   // publishing may be disabled globally or just for external services, and
+   // via configuration options or environment variables
+   bool allowPublish = options.allowPublish() &&
+      core::system::getenv("RSTUDIO_DISABLE_PUBLISH").empty();
+   sessionInfo["allow_publish"] = allowPublish;
+
+   sessionInfo["allow_external_publish"] = options.allowRpubsPublish() &&
+      options.allowExternalPublish() &&
+      core::system::getenv("RSTUDIO_DISABLE_EXTERNAL_PUBLISH").empty() &&
+      allowPublish;
+
+   // allow opening shared projects if it's enabled, and if there's shared
+   // storage from which we can discover the shared projects
+   sessionInfo["allow_open_shared_projects"] =
+         core::system::getenv(kRStudioDisableProjectSharing).empty() &&
+         !options.getOverlayOption(kSessionSharedStoragePath).empty();
+
+   // send whether we should show the user identity
+   sessionInfo["show_identity"] =
+           (options.programMode() == kSessionProgramModeServer) &&
+           options.showUserIdentity();
+
+   // don't show help home until we figure out a sensible heuristic
+   // sessionInfo["show_help_home"] = options.showHelpHome();
+   sessionInfo["show_help_home"] = false;
+
+   sessionInfo["multi_session"] = options.multiSession();
+
+   json::Object rVersionsJson;
+   rVersionsJson["r_version"] = module_context::rVersion();
+   rVersionsJson["r_version_label"] = module_context::rVersionLabel();
+   rVersionsJson["r_home_dir"] = module_context::rHomeDir();
+   sessionInfo["r_versions_info"] = rVersionsJson;
+
+   sessionInfo["show_user_home_page"] = options.showUserHomePage();
+   sessionInfo["user_home_page_url"] = json::Value();
+
+   sessionInfo["session_id"] = module_context::activeSession().id();
+
+   sessionInfo["drivers_support_licensing"] = options.supportsDriversLicensing();
+
+   sessionInfo["quit_child_processes_on_exit"] = options.quitChildProcessesOnExit();
+
+   sessionInfo["git_commit_large_file_size"] = options.gitCommitLargeFileSize();
+
+   sessionInfo["default_rsconnect_server"] = options.defaultRSConnectServer();
+}
+
+} // anonymous namespace
 
 void handleClientInit(const boost::function<void()>& initFunction,
                       boost::shared_ptr<HttpConnection> ptrConnection)
@@ -105,36 +246,19 @@ void handleClientInit(const boost::function<void()>& initFunction,
       core::system::setenv("RSTUDIO_HTTP_REFERER", referer);
    }
 
-   // prepare session info 
-   json::Object sessionInfo ;
-   sessionInfo["clientId"] = clientId;
-   sessionInfo["mode"] = options.programMode();
-   
-   sessionInfo["userIdentity"] = options.userIdentity();
-
-   // only send log_dir and scratch_dir if we are in desktop mode
-   if (options.programMode() == kSessionProgramModeDesktop)
+   // build (and hash) the invariant section of the session info the
+   // first time through; subsequent refreshes reuse the cached copy
+   if (s_invariantETag.empty())
    {
-      sessionInfo["log_dir"] = options.userLogPath().absolutePath();
-      sessionInfo["scratch_dir"] = options.userScratchPath().absolutePath();
+      buildInvariantSessionInfo(&s_invariantSessionInfo);
+      s_invariantETag = hash::crc32HexHash(
+                                 json::write(s_invariantSessionInfo));
    }
 
-   // temp dir
-   FilePath tempDir = rstudio::r::session::utils::tempDir();
-   Error error = tempDir.ensureDirectory();
-   if (error)
-      LOG_ERROR(error);
-   sessionInfo["temp_dir"] = tempDir.absolutePath();
+   // prepare session info
+   json::Object sessionInfo ;
+   sessionInfo["clientId"] = clientId;
 
-   // R_LIBS_USER
-   sessionInfo["r_libs_user"] = module_context::rLibsUser();
-   
-   // user home path
-   sessionInfo["user_home_path"] = session::options().userHomePath().absolutePath();
-   
-   // installed client version
-   sessionInfo["client_version"] = http_methods::clientVersion();
-   
    // default prompt
    sessionInfo["prompt"] = rstudio::r::options::getOption<std::string>("prompt");
 
@@ -145,7 +269,7 @@ void handleClientInit(const boost::function<void()>& initFunction,
    
    // source documents
    json::Array jsonDocs;
-   error = modules::source::clientInitDocuments(&jsonDocs);
+   Error error = modules::source::clientInitDocuments(&jsonDocs);
    if (error)
       LOG_ERROR(error);
    sessionInfo["source_documents"] = jsonDocs;
@@ -154,13 +278,9 @@ void handleClientInit(const boost::function<void()>& initFunction,
    sessionInfo["hasAgreement"] = modules::agreement::hasAgreement();
    sessionInfo["pendingAgreement"] = modules::agreement::pendingAgreement();
 
-   // docs url
-   sessionInfo["docsURL"] = session::options().docsURL();
-
-   // get alias to console_actions and get limit
+   // get alias to console_actions
    rstudio::r::session::ConsoleActions& consoleActions = rstudio::r::session::consoleActions();
-   sessionInfo["console_actions_limit"] = consoleActions.capacity();
-   
+
    // get current console language
    sessionInfo["console_language"] = modules::reticulate::isReplActive() ? "Python" : "R";
 
@@ -185,8 +305,6 @@ void handleClientInit(const boost::function<void()>& initFunction,
 
    sessionInfo["markers_state"] = modules::markers::markersStateAsJson();
 
-   sessionInfo["rstudio_version"] = std::string(RSTUDIO_VERSION);
-
    sessionInfo["ui_prefs"] = userSettings().uiPrefs();
 
    sessionInfo["have_advanced_step_commands"] =
@@ -200,9 +318,6 @@ void handleClientInit(const boost::function<void()>& initFunction,
                                           dirs::getDefaultWorkingDirectory());
    sessionInfo["default_working_dir"] = defaultWorkingDir;
 
-   // default project dir
-   sessionInfo["default_project_dir"] = options.defaultProjectDir();
-
    // active project file
    if (projects::projectContext().hasProject())
    {
@@ -229,8 +344,6 @@ void handleClientInit(const boost::function<void()>& initFunction,
       sessionInfo["project_user_data_directory"] = json::Value();
    }
 
-   sessionInfo["system_encoding"] = std::string(::locale2charset(NULL));
-
    std::vector<std::string> vcsAvailable;
    if (modules::source_control::isGitInstalled())
       vcsAvailable.push_back(modules::git::kVcsId);
@@ -238,8 +351,6 @@ void handleClientInit(const boost::function<void()>& initFunction,
       vcsAvailable.push_back(modules::svn::kVcsId);
    sessionInfo["vcs_available"] = boost::algorithm::join(vcsAvailable, ",");
    sessionInfo["vcs"] = modules::source_control::activeVCSName();
-   sessionInfo["default_ssh_key_dir"] =module_context::createAliasedPath(
-                              modules::source_control::defaultSshKeyDir());
    sessionInfo["is_github_repo"] = modules::git::isGithubRepository();
 
    // contents of all lists
@@ -248,12 +359,6 @@ void handleClientInit(const boost::function<void()>& initFunction,
    sessionInfo["console_processes"] =
          console_process::processesAsJson();
 
-   // send sumatra pdf exe path if we are on windows
-#ifdef _WIN32
-   sessionInfo["sumatra_pdf_exe_path"] =
-               options.sumatraPath().complete("SumatraPDF.exe").absolutePath();
-#endif
-
    // are build tools enabled
    if (projects::projectContext().hasProject())
    {
@@ -292,10 +397,6 @@ void handleClientInit(const boost::function<void()>& initFunction,
    }
 
    sessionInfo["presentation_state"] = modules::presentation::presentationStateAsJson();
-   sessionInfo["presentation_commands"] = options.allowPresentationCommands();
-
-   sessionInfo["tutorial_api_available"] = false;
-   sessionInfo["tutorial_api_client_origin"] = json::Value();
 
    sessionInfo["build_state"] = modules::build::buildStateAsJson();
    sessionInfo["devtools_installed"] = module_context::isMinimumDevtoolsInstalled();
@@ -312,49 +413,9 @@ void handleClientInit(const boost::function<void()>& initFunction,
    sessionInfo["console_history_capacity"] =
                               rstudio::r::session::consoleHistory().capacity();
 
-   sessionInfo["disable_packages"] = module_context::disablePackages();
-
-   sessionInfo["disable_check_for_updates"] =
-          !core::system::getenv("RSTUDIO_DISABLE_CHECK_FOR_UPDATES").empty();
-
-   sessionInfo["allow_vcs_exe_edit"] = options.allowVcsExecutableEdit();
-   sessionInfo["allow_cran_repos_edit"] = options.allowCRANReposEdit();
-   sessionInfo["allow_vcs"] = options.allowVcs();
-   sessionInfo["allow_pkg_install"] = options.allowPackageInstallation();
-   sessionInfo["allow_shell"] = options.allowShell();
-   sessionInfo["allow_terminal_websockets"] = options.allowTerminalWebsockets();
-   sessionInfo["allow_file_download"] = options.allowFileDownloads();
-   sessionInfo["allow_file_upload"] = options.allowFileUploads();
-   sessionInfo["allow_remove_public_folder"] = options.allowRemovePublicFolder();
-   sessionInfo["allow_full_ui"] = options.allowFullUI();
-   sessionInfo["websocket_ping_interval"] = options.webSocketPingInterval();
-   sessionInfo["websocket_connect_timeout"] = options.webSocketConnectTimeout();
-
-   // publishing may be disabled globally or just for external services, and
-   // via configuration options or environment variables
-   bool allowPublish = options.allowPublish() &&
-      core::system::getenv("RSTUDIO_DISABLE_PUBLISH").empty();
-   sessionInfo["allow_publish"] = allowPublish;
-
-   sessionInfo["allow_external_publish"] = options.allowRpubsPublish() &&
-      options.allowExternalPublish() &&
-      core::system::getenv("RSTUDIO_DISABLE_EXTERNAL_PUBLISH").empty() &&
-      allowPublish;
-
-   // allow opening shared projects if it's enabled, and if there's shared
-   // storage from which we can discover the shared projects
-   sessionInfo["allow_open_shared_projects"] = 
-         core::system::getenv(kRStudioDisableProjectSharing).empty() &&
-         !options.getOverlayOption(kSessionSharedStoragePath).empty();
-
    sessionInfo["environment_state"] = modules::environment::environmentStateAsJson();
    sessionInfo["error_state"] = modules::errors::errorStateAsJson();
 
-   // send whether we should show the user identity
-   sessionInfo["show_identity"] =
-           (options.programMode() == kSessionProgramModeServer) &&
-           options.showUserIdentity();
-
    sessionInfo["packrat_available"] =
                      module_context::isRequiredPackratInstalled();
 
@@ -370,21 +431,6 @@ void handleClientInit(const boost::function<void()>& initFunction,
 
    sessionInfo["clang_available"] = modules::clang::isAvailable();
 
-   // don't show help home until we figure out a sensible heuristic
-   // sessionInfo["show_help_home"] = options.showHelpHome();
-   sessionInfo["show_help_home"] = false;
-
-   sessionInfo["multi_session"] = options.multiSession();
-
-   json::Object rVersionsJson;
-   rVersionsJson["r_version"] = module_context::rVersion();
-   rVersionsJson["r_version_label"] = module_context::rVersionLabel();
-   rVersionsJson["r_home_dir"] = module_context::rHomeDir();
-   sessionInfo["r_versions_info"] = rVersionsJson;
-
-   sessionInfo["show_user_home_page"] = options.showUserHomePage();
-   sessionInfo["user_home_page_url"] = json::Value();
-   
    sessionInfo["r_addins"] = modules::r_addins::addinRegistryAsJson();
    sessionInfo["package_provided_extensions"] = modules::ppe::indexer().getPayload();
 
@@ -393,24 +439,38 @@ void handleClientInit(const boost::function<void()>& initFunction,
    sessionInfo["connection_list"] = modules::connections::connectionsAsJson();
    sessionInfo["active_connections"] = modules::connections::activeConnectionsAsJson();
 
-   sessionInfo["session_id"] = module_context::activeSession().id();
-
-   sessionInfo["drivers_support_licensing"] = options.supportsDriversLicensing();
-
-   sessionInfo["quit_child_processes_on_exit"] = options.quitChildProcessesOnExit();
-   
-   sessionInfo["git_commit_large_file_size"] = options.gitCommitLargeFileSize();
-
-   sessionInfo["default_rsconnect_server"] = options.defaultRSConnectServer();
+   // merge in the invariant section, unless the client presented a current
+   // ETag for it (in which case it re-uses its cached copy and we neither
+   // serialize nor transfer those fields again)
+   if (ptrConnection->request().headerValue("If-None-Match") == s_invariantETag)
+   {
+      sessionInfo["client_init_cached"] = true;
+   }
+   else
+   {
+      for (json::Object::const_iterator it = s_invariantSessionInfo.begin();
+           it != s_invariantSessionInfo.end();
+           ++it)
+      {
+         sessionInfo[it->first] = it->second;
+      }
+   }
 
    module_context::events().onSessionInfo(&sessionInfo);
 
    // send response  (we always set kEventsPending to false so that the client
-   // won't poll for events until it is ready)
+   // won't poll for events until it is ready). note that we build the http
+   // response directly (rather than calling sendJsonRpcResponse) so we can
+   // attach the ETag the client uses to revalidate the invariant section
    json::JsonRpcResponse jsonRpcResponse ;
    jsonRpcResponse.setField(kEventsPending, "false");
    jsonRpcResponse.setResult(sessionInfo) ;
-   ptrConnection->sendJsonRpcResponse(jsonRpcResponse);
+   http::Response response;
+   if (ptrConnection->request().acceptsEncoding(http::kGzipEncoding))
+      response.setContentEncoding(http::kGzipEncoding);
+   json::setJsonRpcResponse(jsonRpcResponse, &response);
+   response.setHeader("ETag", s_invariantETag);
+   ptrConnection->sendResponse(response);
 
    // complete initialization of session
    init::ensureSessionInitialized();
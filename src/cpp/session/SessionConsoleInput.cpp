@@ -28,6 +28,8 @@
 #include "modules/environment/SessionEnvironment.hpp"
 #include "modules/overlay/SessionOverlay.hpp"
 
+#include <core/FlightRecorder.hpp>
+
 #include <session/SessionModuleContext.hpp>
 
 #include <r/session/RSession.hpp>
@@ -51,6 +53,14 @@ std::string s_lastPrompt;
 
 void setExecuting(bool executing)
 {
+   // note the transition in the flight recorder (R evaluation is the
+   // main occupant of this thread, so an eval with no matching end is
+   // the first thing to look for in a hang)
+   if (executing && !s_rProcessingInput)
+      flight_recorder::record("r eval begin");
+   else if (!executing && s_rProcessingInput)
+      flight_recorder::record("r eval end");
+
    s_rProcessingInput = executing;
    module_context::activeSession().setExecuting(executing);
 }
@@ -36,6 +36,39 @@ ConsoleProcessSocket s_terminalSocket;
 // Posix-only, use is gated via getTrackEnv() always being false on Win32.
 const std::string kEnvCommand = "/usr/bin/env";
 
+// how long after console process activity (start, input, or output) we
+// consider further output likely to arrive soon
+const int kOutputPendingWindowMs = 500;
+
+// tracks when console process output last became likely -- a process
+// started, received input, or produced output -- so the main loop can
+// poll the process supervisor at a tighter interval while something is
+// actually happening, and at the normal relaxed cadence otherwise
+boost::mutex s_activityMutex;
+boost::posix_time::ptime s_lastProcessActivity;
+
+void noteProcessActivity()
+{
+   LOCK_MUTEX(s_activityMutex)
+   {
+      s_lastProcessActivity =
+            boost::posix_time::microsec_clock::universal_time();
+   }
+   END_LOCK_MUTEX
+}
+
+void onDeferredInit(bool)
+{
+   // pre-start the terminal websocket server so the first terminal
+   // created doesn't pay its startup cost
+   if (ConsoleProcess::useWebsockets())
+   {
+      Error error = s_terminalSocket.ensureServerRunning();
+      if (error)
+         LOG_ERROR(error);
+   }
+}
+
 } // anonymous namespace
 
 // create process options for a terminal
@@ -274,8 +307,13 @@ Error ConsoleProcess::start()
                           options_, createProcessCallbacks());
    }
    if (!error)
+   {
       started_ = true;
 
+      // the first output (e.g. the shell prompt) follows shortly
+      noteProcessActivity();
+   }
+
    return error;
 }
 
@@ -290,6 +328,9 @@ void ConsoleProcess::enqueInputInternalLock(const Input& input)
 
 void ConsoleProcess::enqueInput(const Input& input)
 {
+   // input usually elicits output (an echo if nothing else)
+   noteProcessActivity();
+
    if (input.sequence == kIgnoreSequence)
    {
       inputQueue_.push_back(input);
@@ -519,6 +560,9 @@ std::string ConsoleProcess::getBuffer() const
 
 void ConsoleProcess::enqueOutputEvent(const std::string &output)
 {
+   // output tends to arrive in bursts; keep polling eagerly
+   noteProcessActivity();
+
    if (envCaptureCmd_.output(output))
       return;
 
@@ -998,8 +1042,28 @@ core::json::Array processesAsJson()
    return allProcessesAsJson();
 }
 
+bool likelyOutputPending()
+{
+   using namespace boost::posix_time;
+
+   LOCK_MUTEX(s_activityMutex)
+   {
+      if (s_lastProcessActivity.is_not_a_date_time())
+         return false;
+
+      return microsec_clock::universal_time() <=
+             s_lastProcessActivity + milliseconds(kOutputPendingWindowMs);
+   }
+   END_LOCK_MUTEX
+
+   // keep compiler happy
+   return false;
+}
+
 Error initialize()
 {
+   module_context::events().onDeferredInit.connect(onDeferredInit);
+
    return internalInitialize();
 }
 
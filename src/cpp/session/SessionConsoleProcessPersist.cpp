@@ -15,9 +15,13 @@
 
 #include <session/SessionConsoleProcessPersist.hpp>
 
+#include <algorithm>
+#include <map>
+
 #include <boost/foreach.hpp>
 
 #include <core/FileSerializer.hpp>
+#include <core/SafeConvert.hpp>
 
 #include <session/SessionModuleContext.hpp>
 #include <session/SessionOptions.hpp>
@@ -50,7 +54,10 @@ namespace console_persist {
 //                Added autoClose, zombie
 // 2017/06/16 - console05 -> console06
 //                Added trackEnv
-#define kConsoleDir "console06"
+// 2018/09/24 - console06 -> console07
+//                Buffer stored as an append-only chunk log instead of a
+//                single file
+#define kConsoleDir "console07"
 
 namespace {
 
@@ -95,17 +102,76 @@ const FilePath& getConsoleProcIndexPath()
    return s_consoleProcIndexPath;
 }
 
-Error getLogFilePath(const std::string& handle, FilePath* pFile)
+// The saved buffer for a terminal is stored as a series of append-only
+// chunk files, "<handle>.<n>". Output is only ever appended to the
+// newest chunk; when it fills up a new chunk is started, and the total
+// size is capped by deleting whole chunks from the front (so a busy
+// terminal never triggers a full-buffer rewrite). Reads start from the
+// newest chunk and work backwards, stopping once enough lines have been
+// gathered.
+const size_t kChunkSize = 64 * 1024;
+const int kMaxChunks = 16;
+
+struct ChunkedLog
 {
-   initialize();
-   Error error = getConsoleProcPath().ensureDirectory();
+   ChunkedLog() : scanned(false), firstChunk(0), lastChunk(-1),
+                  lastChunkBytes(0)
+   {
+   }
+
+   bool scanned;
+   int firstChunk;
+   int lastChunk;      // -1 means no chunks on disk
+   uintmax_t lastChunkBytes;
+};
+
+std::map<std::string, ChunkedLog> s_chunkedLogs;
+
+FilePath chunkFilePath(const std::string& handle, int chunk)
+{
+   return getConsoleProcPath().complete(
+            handle + "." + safe_convert::numberToString(chunk));
+}
+
+ChunkedLog& chunkedLog(const std::string& handle)
+{
+   ChunkedLog& log = s_chunkedLogs[handle];
+   if (log.scanned)
+      return log;
+
+   // discover this handle's chunks on disk
+   std::vector<FilePath> children;
+   Error error = getConsoleProcPath().children(&children);
    if (error)
+      LOG_ERROR(error);
+
+   BOOST_FOREACH(const FilePath& child, children)
    {
-      return error;
+      if (child.stem() != handle || child.extension().length() < 2)
+         continue;
+
+      // skip non-numeric extensions (e.g. the environment file)
+      int chunk = safe_convert::stringTo<int>(
+                           child.extension().substr(1), -1);
+      if (chunk < 0)
+         continue;
+
+      if (log.lastChunk == -1)
+      {
+         log.firstChunk = log.lastChunk = chunk;
+      }
+      else
+      {
+         log.firstChunk = std::min(log.firstChunk, chunk);
+         log.lastChunk = std::max(log.lastChunk, chunk);
+      }
    }
 
-   *pFile = getConsoleProcPath().complete(handle);
-   return Success();
+   if (log.lastChunk != -1)
+      log.lastChunkBytes = chunkFilePath(handle, log.lastChunk).size();
+
+   log.scanned = true;
+   return log;
 }
 
 Error getEnvFilePath(const std::string& handle, FilePath* pFile)
@@ -156,44 +222,42 @@ void saveConsoleProcesses(const std::string& metadata)
 
 std::string getSavedBuffer(const std::string& handle, int maxLines)
 {
-   std::string content;
-   FilePath log;
-
-   Error error = getLogFilePath(handle, &log);
-   if (error)
-   {
-      LOG_ERROR(error);
-      return content;
-   }
+   ChunkedLog& log = chunkedLog(handle);
 
-   if (!log.exists())
+   // read tail-first: start with the newest chunk and work backwards,
+   // stopping as soon as we have the lines the caller asked for (so
+   // reconnecting a terminal doesn't read the whole log)
+   std::string content;
+   for (int chunk = log.lastChunk; chunk >= log.firstChunk; chunk--)
    {
-      return "";
-   }
+      FilePath chunkFile = chunkFilePath(handle, chunk);
+      if (!chunkFile.exists())
+         continue;
 
-   error = core::readStringFromFile(log, &content);
-   if (error)
-   {
-      LOG_ERROR(error);
-      return content;
-   }
+      std::string chunkContent;
+      Error error = core::readStringFromFile(chunkFile, &chunkContent);
+      if (error)
+      {
+         LOG_ERROR(error);
+         continue;
+      }
 
-   if (maxLines < 1)
-      return content;
+      content.insert(0, chunkContent);
 
-   // Trim the buffer based on maxLines. Otherwise it can grow without
-   // bound until the terminal is closed or cleared.
-   std::string trimmedOutput = content;
-   if (string_utils::trimLeadingLines(maxLines, &trimmedOutput))
-   {
-      error = core::writeStringToFile(log, trimmedOutput);
-      if (error)
+      if (maxLines > 0 &&
+          string_utils::countNewlines(content) >=
+                                             static_cast<size_t>(maxLines))
       {
-          LOG_ERROR(error);
-          return content;
+         break;
       }
    }
-   return trimmedOutput;
+
+   // Trim the returned buffer based on maxLines (on-disk trimming is
+   // handled by dropping whole chunks as the log grows)
+   if (maxLines > 0)
+      string_utils::trimLeadingLines(maxLines, &content);
+
+   return content;
 }
 
 int getSavedBufferLineCount(const std::string& handle, int maxLines)
@@ -204,72 +268,98 @@ int getSavedBufferLineCount(const std::string& handle, int maxLines)
 
 void appendToOutputBuffer(const std::string& handle, const std::string& buffer)
 {
-   FilePath log;
-   Error error = getLogFilePath(handle, &log);
+   ChunkedLog& log = chunkedLog(handle);
+   if (log.lastChunk == -1)
+   {
+      log.firstChunk = log.lastChunk = 0;
+      log.lastChunkBytes = 0;
+   }
+
+   Error error = rstudio::core::appendToFile(
+                           chunkFilePath(handle, log.lastChunk), buffer);
    if (error)
    {
       LOG_ERROR(error);
       return;
    }
+   log.lastChunkBytes += buffer.length();
 
-   error = rstudio::core::appendToFile(log, buffer);
-   if (error)
+   // roll to a new chunk once the active one fills up
+   if (log.lastChunkBytes >= kChunkSize)
    {
-      LOG_ERROR(error);
+      log.lastChunk++;
+      log.lastChunkBytes = 0;
+
+      // enforce the total size cap by dropping whole chunks from the
+      // front of the log
+      while ((log.lastChunk - log.firstChunk + 1) > kMaxChunks)
+      {
+         error = chunkFilePath(handle, log.firstChunk).removeIfExists();
+         if (error)
+            LOG_ERROR(error);
+         log.firstChunk++;
+      }
    }
 }
 
 void deleteLogFile(const std::string &handle, bool lastLineOnly)
 {
-   FilePath log;
-   Error error = getLogFilePath(handle, &log);
-   if (error)
-   {
-      LOG_ERROR(error);
-      return;
-   }
-
-   if (!log.exists())
-      return;
+   ChunkedLog& log = chunkedLog(handle);
 
    if (!lastLineOnly)
    {
-      // blow away the file
-      error = log.removeIfExists();
-      if (error)
+      // blow away all of the chunks
+      for (int chunk = log.firstChunk; chunk <= log.lastChunk; chunk++)
       {
-         LOG_ERROR(error);
-         return;
+         Error error = chunkFilePath(handle, chunk).removeIfExists();
+         if (error)
+            LOG_ERROR(error);
       }
+      s_chunkedLogs.erase(handle);
+      return;
    }
-   else
+
+   // remove the last line: work backwards through the chunks until we
+   // find a completed line to truncate after (the last line can span
+   // chunk boundaries)
+   while (log.lastChunk >= log.firstChunk)
    {
-      // read the file, remove last line and rewrite buffer
+      FilePath chunkFile = chunkFilePath(handle, log.lastChunk);
       std::string content;
-      error = core::readStringFromFile(log, &content);
-      if (error)
+      if (chunkFile.exists())
       {
-         LOG_ERROR(error);
-         return;
+         Error error = core::readStringFromFile(chunkFile, &content);
+         if (error)
+         {
+            LOG_ERROR(error);
+            return;
+         }
       }
 
       size_t lastNewline = content.find_last_of('\n');
-
-      // no complete line in buffer, just blow it away
-      if (lastNewline == std::string::npos)
+      if (lastNewline != std::string::npos)
       {
-         deleteLogFile(handle, false);
+         // erase everything after the final newline
+         content.erase(++lastNewline);
+         Error error = core::writeStringToFile(chunkFile, content);
+         if (error)
+            LOG_ERROR(error);
+         log.lastChunkBytes = content.length();
          return;
       }
 
-      // erase everything after the final newline
-      content.erase(++lastNewline);
-      error = core::writeStringToFile(log, content);
+      // no complete line in this chunk; drop it and keep looking
+      Error error = chunkFile.removeIfExists();
       if (error)
       {
-          LOG_ERROR(error);
+         LOG_ERROR(error);
+         return;
       }
+      log.lastChunk--;
    }
+
+   // no complete line anywhere in the buffer; nothing left on disk
+   s_chunkedLogs.erase(handle);
 }
 
 void deleteOrphanedLogs(bool (*validHandle)(const std::string&))
@@ -298,6 +388,9 @@ void deleteOrphanedLogs(bool (*validHandle)(const std::string&))
          error = child.remove();
          if (error)
             LOG_ERROR(error);
+
+         // drop any cached chunk state for the handle
+         s_chunkedLogs.erase(child.stem());
       }
    }
 }
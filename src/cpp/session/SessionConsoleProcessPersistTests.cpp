@@ -170,6 +170,28 @@ TEST_CASE("ConsoleProcess Persistence")
       CHECK((loaded.compare(expect) == 0));
    }
 
+   SECTION("Write past the chunk size and read it back")
+   {
+      // enough output to span several chunk files
+      std::stringstream ss;
+      for (size_t i = 0; i < 10000; i++)
+      {
+         ss << "line number " << i << " of some terminal output\n";
+      }
+      std::string orig = ss.str();
+
+      // append in pty-read-sized pieces
+      const size_t kPiece = 1024;
+      for (size_t pos = 0; pos < orig.length(); pos += kPiece)
+      {
+         console_persist::appendToOutputBuffer(handle1,
+                                               orig.substr(pos, kPiece));
+      }
+
+      std::string loaded = console_persist::getSavedBuffer(handle1, 0);
+      CHECK((loaded.compare(orig) == 0));
+   }
+
    SECTION("Delete unknown log files")
    {
       std::string orig1("hello how are you?\nthat is good\nhave a nice day");
@@ -21,6 +21,7 @@
 
 #include <boost/make_shared.hpp>
 
+#include <core/DateTime.hpp>
 #include <core/FilePath.hpp>
 #include <core/json/Json.hpp>
 
@@ -37,12 +38,27 @@ namespace {
 // returned by rand; only an issue for unit tests, really
 bool s_didSeedRand = false;
 
+// window over which output is aggregated into a single frame; the first
+// chunk of output in an idle window goes out immediately (so keystroke
+// echo isn't delayed) and subsequent chunks are batched
+const int kBatchWindowMillis = 20;
+
+// per-second output budget per terminal; well beyond what the client can
+// render, so only runaway producers (e.g. cat of a huge file) hit it
+const size_t kMaxOutputBytesPerSecond = 512 * 1024;
+
+// marker emitted (once per second) in place of output dropped over the
+// budget; the full output remains in the terminal's saved buffer
+const char * const kOutputDroppedMarker =
+                     "\r\n*** output suppressed (rate limit exceeded) ***\r\n";
+
 } // anonymous namespace
 
 ConsoleProcessSocket::ConsoleProcessSocket()
    :
      port_(0),
      serverRunning_(false),
+     flushPending_(false),
      activeConnections_(0)
 {
 }
@@ -81,6 +97,10 @@ Error ConsoleProcessSocket::ensureServerRunning()
       pwsServer_->set_access_channels(websocketpp::log::alevel::none);
       pwsServer_->init_asio();
 
+      // timer used to flush batched terminal output
+      pFlushTimer_.reset(new boost::asio::deadline_timer(
+                                             pwsServer_->get_io_service()));
+
       pwsServer_->set_message_handler(
                boost::bind(&ConsoleProcessSocket::onMessage, this, &*pwsServer_, _1, _2));
       pwsServer_->set_http_handler(
@@ -178,11 +198,20 @@ void ConsoleProcessSocket::stopServer()
       {
          releaseAllConnections();
 
+         pFlushTimer_->cancel();
          pwsServer_->stop();
          serverRunning_ = false;
          port_ = 0;
          websocketThread_.join();
+         pFlushTimer_.reset();
          pwsServer_.reset();
+
+         LOCK_MUTEX(batchMutex_)
+         {
+            batches_.clear();
+            flushPending_ = false;
+         }
+         END_LOCK_MUTEX
       }
    }
    catch (websocketpp::exception const& e)
@@ -221,6 +250,14 @@ Error ConsoleProcessSocket::stopListening(const std::string& terminalHandle)
    }
 
    details = connections_.collect(terminalHandle);
+
+   // discard any output still batched for the connection
+   LOCK_MUTEX(batchMutex_)
+   {
+      batches_.erase(terminalHandle);
+   }
+   END_LOCK_MUTEX
+
    return Success();
 }
 
@@ -257,7 +294,105 @@ Error ConsoleProcessSocket::sendRawText(const std::string& terminalHandle,
 Error ConsoleProcessSocket::sendText(const std::string& terminalHandle,
                                      const std::string& message)
 {
-   return sendRawText(terminalHandle, ConsoleProcessSocketPacket::textPacket(message));
+   if (!serverRunning_)
+      return sendRawText(terminalHandle,
+                         ConsoleProcessSocketPacket::textPacket(message));
+
+   std::string sendNow;
+   LOCK_MUTEX(batchMutex_)
+   {
+      OutputBatch& batch = batches_[terminalHandle];
+
+      // reset the output budget at the top of each second
+      double nowMs = date_time::millisecondsSinceEpoch();
+      if ((nowMs - batch.windowStartMs) >= 1000.0)
+      {
+         batch.windowStartMs = nowMs;
+         batch.windowBytes = 0;
+         batch.droppedInWindow = false;
+      }
+
+      // enforce the per-second budget: drop output over the budget and
+      // mark the spot (the client can recover the full output from the
+      // terminal's saved buffer)
+      if ((batch.windowBytes + message.length()) > kMaxOutputBytesPerSecond)
+      {
+         if (!batch.droppedInWindow)
+         {
+            batch.pending.append(kOutputDroppedMarker);
+            batch.droppedInWindow = true;
+         }
+      }
+      else
+      {
+         batch.windowBytes += message.length();
+         batch.pending.append(message);
+      }
+
+      if (flushPending_)
+      {
+         // output goes out with the already-scheduled flush
+         return Success();
+      }
+
+      // nothing in flight: send this output immediately and open a
+      // batching window for whatever arrives behind it
+      sendNow.swap(batch.pending);
+      flushPending_ = true;
+      pFlushTimer_->expires_from_now(
+               boost::posix_time::milliseconds(kBatchWindowMillis));
+      pFlushTimer_->async_wait(boost::bind(
+               &ConsoleProcessSocket::flushBatchedOutput, this, _1));
+   }
+   END_LOCK_MUTEX
+
+   if (sendNow.empty())
+      return Success();
+
+   return sendRawText(terminalHandle,
+                      ConsoleProcessSocketPacket::textPacket(sendNow));
+}
+
+void ConsoleProcessSocket::flushBatchedOutput(
+                                       const boost::system::error_code& ec)
+{
+   if (ec == boost::asio::error::operation_aborted)
+      return;
+
+   // collect pending output under the lock, send it outside the lock
+   std::map<std::string, std::string> pending;
+   LOCK_MUTEX(batchMutex_)
+   {
+      for (std::map<std::string, OutputBatch>::iterator
+               it = batches_.begin(); it != batches_.end(); ++it)
+      {
+         if (!it->second.pending.empty())
+            pending[it->first].swap(it->second.pending);
+      }
+
+      if (!pending.empty())
+      {
+         // stay in batching mode while output is flowing -- this also
+         // keeps all sends on the timer thread so frames can't reorder
+         pFlushTimer_->expires_from_now(
+                  boost::posix_time::milliseconds(kBatchWindowMillis));
+         pFlushTimer_->async_wait(boost::bind(
+                  &ConsoleProcessSocket::flushBatchedOutput, this, _1));
+      }
+      else
+      {
+         flushPending_ = false;
+      }
+   }
+   END_LOCK_MUTEX
+
+   for (std::map<std::string, std::string>::const_iterator
+            it = pending.begin(); it != pending.end(); ++it)
+   {
+      // failure here just means the connection went away mid-batch
+      sendRawText(it->first,
+                  ConsoleProcessSocketPacket::textPacket(it->second));
+   }
 }
 
 Error ConsoleProcessSocket::sendPong(const std::string& terminalHandle)
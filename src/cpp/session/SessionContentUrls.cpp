@@ -105,6 +105,38 @@ Error contentFileInfo(const std::string& contentUrl,
    return Success();
 }
 
+// determine whether text content looks like valid UTF-8. only the leading
+// portion of the file is examined so that large exports aren't read into
+// memory just to pick a charset
+bool looksLikeUtf8(const FilePath& filePath)
+{
+   const std::streamsize kSniffBytes = 16 * 1024;
+
+   // read the leading bytes of the file
+   boost::shared_ptr<std::istream> pIfs;
+   Error error = filePath.open_r(&pIfs);
+   if (error)
+      return true;
+   std::vector<char> buffer(kSniffBytes);
+   pIfs->read(&buffer[0], kSniffBytes);
+   std::string contents(&buffer[0], static_cast<std::size_t>(pIfs->gcount()));
+
+   // if the content looks like valid UTF-8, assume it is; otherwise, assume
+   // it's the system encoding
+   bool truncated = contents.length() == static_cast<std::size_t>(kSniffBytes);
+   for (std::string::iterator pos = contents.begin(); pos != contents.end(); )
+   {
+      error = string_utils::utf8Advance(pos, 1, contents.end(), &pos);
+      if (error)
+      {
+         // tolerate a multi-byte sequence split by the end of the sniff
+         // window (a UTF-8 character is at most 4 bytes)
+         return truncated && std::distance(pos, contents.end()) < 4;
+      }
+   }
+
+   return true;
+}
 
 } // anonymous namespace
 
@@ -156,67 +188,65 @@ void handleContentRequest(const http::Request& request, http::Response* pRespons
       return;
    }
 
-   // set private cache forever headers
-   pResponse->setPrivateCacheForeverHeaders();
-
-   // read file
-   std::string contents;
-   error = core::readStringFromFile(contentFilePath, &contents);
-   if (error)
+   // ensure the content file exists
+   if (!contentFilePath.exists())
    {
-      pResponse->setError(error);
+      pResponse->setNotFoundError(request.uri());
       return;
    }
 
-   // Ensure we are over the Qt iframe (?) minimum of 513 bytes for our custom
-   // network reply handler to work correctly (for this case and apparently
-   // this case only if bytesAvailable is less than 512 then Qt never calls
-   // readData after the call to bytesAvailable). This is the behavior we used
-   // to see in Qt 4.X and for that case we had a special workaround (see
-   // https://github.com/rstudio/rstudio/blob/master/src/cpp/desktop/DesktopNetworkReply.cpp#L186-L195)
-   //
-   // Note that we can't just restore the workaround because the IDE didn't
-   // even come up with the workaround in place! (due to RPC calls that
-   // were less than 512 bytes). I'm not sure why this case and this case
-   // only presents problems -- it may be because it's a request in an
-   // iframe? (I tried to find other iframes where we might have less than
-   // 512 bytes -- e.g. Plots, Help but couldn't even construct a case
-   // where the payload was that small)
-   if (contents.length() <= 512)
+   // set private cache forever headers
+   pResponse->setPrivateCacheForeverHeaders();
+
+   // determine content type (with charset for text content)
+   std::string contentType = contentFilePath.mimeContentType();
+   if (boost::algorithm::starts_with(contentType, "text/"))
    {
-      std::string fill(512 - contents.length() + 1, ' ');
-      contents.append(fill);
+      contentType += std::string("; charset=") +
+                     (looksLikeUtf8(contentFilePath) ? "UTF-8"
+                                                     : ::locale2charset(NULL));
    }
 
-   // set contents
-   pResponse->setContentType(contentFilePath.mimeContentType());
-   pResponse->setBody(contents);
-
-   bool isUtf8 = true;
-   if (boost::algorithm::starts_with(contentFilePath.mimeContentType(), "text/"))
+   if (contentFilePath.size() <= 512)
    {
-      // If the content looks like valid UTF-8, assume it is. Otherwise, assume
-      // it's the system encoding.
+      // Ensure we are over the Qt iframe (?) minimum of 513 bytes for our
+      // custom network reply handler to work correctly (for this case and
+      // apparently this case only if bytesAvailable is less than 512 then Qt
+      // never calls readData after the call to bytesAvailable). This is the
+      // behavior we used to see in Qt 4.X and for that case we had a special
+      // workaround (see
+      // https://github.com/rstudio/rstudio/blob/master/src/cpp/desktop/DesktopNetworkReply.cpp#L186-L195)
+      //
+      // Note that we can't just restore the workaround because the IDE didn't
+      // even come up with the workaround in place! (due to RPC calls that
+      // were less than 512 bytes). I'm not sure why this case and this case
+      // only presents problems -- it may be because it's a request in an
+      // iframe? (I tried to find other iframes where we might have less than
+      // 512 bytes -- e.g. Plots, Help but couldn't even construct a case
+      // where the payload was that small)
       std::string contents;
       error = core::readStringFromFile(contentFilePath, &contents);
-      if (!error)
+      if (error)
       {
-         for (std::string::iterator pos = contents.begin(); pos != contents.end(); )
-         {
-            error = string_utils::utf8Advance(pos, 1, contents.end(), &pos);
-            if (error)
-            {
-               isUtf8 = false;
-               break;
-            }
-         }
+         pResponse->setError(error);
+         return;
       }
+      std::string fill(512 - contents.length() + 1, ' ');
+      contents.append(fill);
+      pResponse->setBody(contents);
+   }
+   else
+   {
+      // serve the file zero-copy from a memory mapping (with byte range
+      // support) rather than reading it fully into the response -- large
+      // exports shouldn't double their size in session memory before the
+      // first byte leaves
+      pResponse->setMemoryMappedFile(contentFilePath, request);
    }
 
-   // reset content-type with charset
-   pResponse->setContentType(contentFilePath.mimeContentType() +
-                             std::string("; charset=") +
-                             (isUtf8 ? "UTF-8" : ::locale2charset(NULL)));
+   // set content-type (after the body so the mapped path's mime-only
+   // content type is replaced with the charset-qualified one)
+   pResponse->setContentType(contentType);
 
    // set title header
    pResponse->setHeader("Title", title);
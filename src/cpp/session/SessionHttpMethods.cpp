@@ -35,6 +35,10 @@
 #include <core/json/Json.hpp>
 #include <core/json/JsonRpc.hpp>
 
+#include <core/FlightRecorder.hpp>
+#include <core/AllocationTracker.hpp>
+#include <core/PerformanceMetrics.hpp>
+
 #include <core/SocketRpc.hpp>
 #include <core/system/Crypto.hpp>
 
@@ -47,6 +51,7 @@
 #include <session/RVersionSettings.hpp>
 #include <session/SessionHttpConnection.hpp>
 #include <session/SessionHttpConnectionListener.hpp>
+#include <session/SessionConsoleProcess.hpp>
 #include <session/SessionModuleContext.hpp>
 #include <session/SessionOptions.hpp>
 #include <session/SessionPersistentState.hpp>
@@ -87,18 +92,41 @@ boost::posix_time::ptime timeoutTimeFromNow()
 
 void processEvents()
 {
+    // note the time spent inside the R event loop -- this measures how
+    // much of the main thread the event loop occupies and therefore how
+    // long queued connections have to wait for it
+    using namespace boost::posix_time;
+    ptime startTime = microsec_clock::universal_time();
+
     // execute safely since this can call arbitrary R code (and
     // (can also cause jump_to_top if an interrupt is pending)
     Error error = rstudio::r::exec::executeSafely(
                 rstudio::r::session::event_loop::processEvents);
     if (error)
         LOG_ERROR(error);
+
+    performance::recordDuration(
+                "rsession_r_event_loop_seconds",
+                microsec_clock::universal_time() - startTime);
+}
+
+void handleMetricsRequest(const core::http::Request&,
+                          core::http::Response* pResponse)
+{
+   pResponse->setNoCacheHeaders();
+   pResponse->setContentType("text/plain");
+   pResponse->setBody(performance::metricsAsText() +
+                      allocation::statsAsText());
 }
 
 bool parseAndValidateJsonRpcConnection(
          boost::shared_ptr<HttpConnection> ptrConnection,
          json::JsonRpcRequest* pJsonRpcRequest)
 {
+   // attribute the parsed json tree to the json rpc module when the
+   // allocation tracker is on
+   allocation::Scope allocationScope("json_rpc");
+
    // attempt to parse the request into a json-rpc request
    Error error = json::parseJsonRpcRequest(ptrConnection->request().body(),
                                            pJsonRpcRequest);
@@ -184,11 +212,10 @@ bool isTimedOut(const boost::posix_time::ptime& timeoutTime)
 {
    using namespace boost::posix_time;
 
-   // never time out in desktop mode
-   if (options().programMode() == kSessionProgramModeDesktop)
-      return false;
-
-   // check for an client disconnection based timeout
+   // check for an client disconnection based timeout. note that this check
+   // also applies in desktop mode: when the frontend exits in detach mode
+   // it leaves the session running with a disconnected timeout as the
+   // grace period within which it can reattach
    int disconnectedTimeoutMinutes = options().disconnectedTimeoutMinutes();
    if (disconnectedTimeoutMinutes > 0)
    {
@@ -204,6 +231,10 @@ bool isTimedOut(const boost::posix_time::ptime& timeoutTime)
       }
    }
 
+   // otherwise never time out in desktop mode
+   if (options().programMode() == kSessionProgramModeDesktop)
+      return false;
+
    // check for a foreground inactivity based timeout
    if (timeoutTime.is_not_a_date_time())
       return false;
@@ -249,9 +280,14 @@ void polledEventHandler()
    if (s_lastPerformed.is_not_a_date_time())
       s_lastPerformed = microsec_clock::universal_time();
 
-   // throttle to no more than once every 50ms
+   // throttle to no more than once every 50ms; while console process output
+   // is likely pending use a much tighter interval so terminal output reaches
+   // the client promptly
    static time_duration s_intervalMs = milliseconds(50);
-   if (microsec_clock::universal_time() <= (s_lastPerformed + s_intervalMs))
+   static time_duration s_activeIntervalMs = milliseconds(5);
+   time_duration intervalMs = console_process::likelyOutputPending() ?
+                                 s_activeIntervalMs : s_intervalMs;
+   if (microsec_clock::universal_time() <= (s_lastPerformed + intervalMs))
       return;
 
    // notify modules
@@ -315,6 +351,21 @@ bool registeredWaitForMethod(const std::string& method,
                         pRequest);
 }
 
+} // anonymous namespace
+
+namespace module_context
+{
+module_context::WaitForMethodFunction registerWaitForMethod(
+      const std::string& methodName)
+{
+   s_waitForMethodNames.push_back(methodName);
+   return boost::bind(registeredWaitForMethod, methodName, _2, _1);
+}
+
+} // namespace module_context
+
+namespace http_methods {
+
 bool verifyRequestSignature(const core::http::Request& request)
 {
    // only verify signatures if we are in standalone mode and
@@ -406,21 +457,6 @@ bool verifyRequestSignature(const core::http::Request& request)
    return true;
 }
 
-} // anonymous namespace
-
-namespace module_context
-{
-module_context::WaitForMethodFunction registerWaitForMethod(
-      const std::string& methodName)
-{
-   s_waitForMethodNames.push_back(methodName);
-   return boost::bind(registeredWaitForMethod, methodName, _2, _1);
-}
-
-} // namespace module_context
-
-namespace http_methods {
-
 // client version -- this is determined by the git revision hash. the client
 // and the server can diverge if a new version of the server was installed
 // underneath a previously rendered client. if versions diverge then a reload
@@ -507,10 +543,13 @@ bool waitForMethod(const std::string& method,
       if (main_process::haveActiveChildren())
          timeoutTime = timeoutTimeFromNow();
 
-      // look for a connection (waiting for the specified interval)
+      // look for a connection (waiting for the specified interval; use a
+      // shorter wait while console process output is likely pending so it
+      // isn't delayed by the full interval)
       boost::shared_ptr<HttpConnection> ptrConnection =
           httpConnectionListener().mainConnectionQueue().dequeConnection(
-                                            connectionQueueTimeout);
+             console_process::likelyOutputPending() ?
+                boost::posix_time::milliseconds(5) : connectionQueueTimeout);
 
 
       // perform background processing (true for isIdle)
@@ -775,6 +814,42 @@ void handleConnection(boost::shared_ptr<HttpConnection> ptrConnection,
                suspend::handleUSR1(0);
          }
 
+         // reload options (pushed by the server after a config change)
+         else if (jsonRpcRequest.method == kReloadOptions)
+         {
+            json::Object optionsJson;
+            Error error = json::readParams(jsonRpcRequest.params,
+                                           &optionsJson);
+            if (error)
+            {
+               ptrConnection->sendJsonRpcError(error);
+            }
+            else
+            {
+               // apply whatever we can in place and report the rest
+               // back as requiring a restart to take effect
+               json::Array appliedJson, restartRequiredJson;
+               BOOST_FOREACH(const json::Member& member, optionsJson)
+               {
+                  std::string value;
+                  if (json::isType<std::string>(member.second))
+                     value = member.second.get_str();
+                  if (options().applyReloadableOption(member.first, value))
+                     appliedJson.push_back(member.first);
+                  else
+                     restartRequiredJson.push_back(member.first);
+               }
+
+               json::Object resultJson;
+               resultJson["applied"] = appliedJson;
+               resultJson["restart_required"] = restartRequiredJson;
+
+               json::JsonRpcResponse response;
+               response.setResult(resultJson);
+               ptrConnection->sendJsonRpcResponse(response);
+            }
+         }
+
          // interrupt
          else if ( jsonRpcRequest.method == kInterrupt )
          {
@@ -789,12 +864,22 @@ void handleConnection(boost::shared_ptr<HttpConnection> ptrConnection,
                rstudio::r::exec::setInterruptsPending(true);
          }
 
-         // other rpc method, handle it
+         // other rpc method, handle it (recording dispatch time so the
+         // latency distribution per process is scrapeable via /metrics)
          else
          {
+            using namespace boost::posix_time;
+            ptime startTime = microsec_clock::universal_time();
+            flight_recorder::record("rpc begin", jsonRpcRequest.method);
+
             jsonRpcRequest.isBackgroundConnection =
                   (connectionType == BackgroundConnection);
             rpc::handleRpcRequest(jsonRpcRequest, ptrConnection, connectionType);
+
+            flight_recorder::record("rpc end", jsonRpcRequest.method);
+            performance::recordDuration(
+                  "rsession_rpc_duration_seconds",
+                  microsec_clock::universal_time() - startTime);
          }
       }
    }
@@ -844,6 +929,9 @@ void registerGwtHandlers()
          "/progress",
           boost::bind(text::handleTemplateRequest, progressPagePath, _1, _2));
 
+   // establish metrics handler
+   module_context::registerUriHandler("/metrics", handleMetricsRequest);
+
    // initialize gwt symbol maps
    gwt::initializeSymbolMaps(options.wwwSymbolMapsPath());
 
@@ -47,6 +47,7 @@ void waitForMethodInitFunction(const ClientEvent& initEvent);
 
 void handleConnection(boost::shared_ptr<HttpConnection> ptrConnection,
                       ConnectionType connectionType);
+bool verifyRequestSignature(const core::http::Request& request);
 core::WaitResult startHttpConnectionListenerWithTimeout();
 void registerGwtHandlers();
 std::string clientVersion();
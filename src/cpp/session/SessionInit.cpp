@@ -19,6 +19,8 @@
 
 #include <session/SessionModuleContext.hpp>
 
+#include "SessionStartupProfiler.hpp"
+
 using namespace rstudio::core;
 
 namespace rstudio {
@@ -45,7 +47,11 @@ void ensureSessionInitialized()
    // ensure the session is fully deserialized (deferred deserialization
    // is supported so that the workbench UI can load without having to wait
    // for the potentially very lengthy deserialization of the environment)
+   startup_profiler::advancePhase("restore session state");
    rstudio::r::session::ensureDeserialized();
+
+   // startup is now complete -- write the phase timing report
+   startup_profiler::completeStartup();
 }
 
 bool isSessionInitialized()
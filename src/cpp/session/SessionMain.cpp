@@ -44,6 +44,7 @@
 #include <core/FilePath.hpp>
 #include <core/FileLock.hpp>
 #include <core/Exec.hpp>
+#include <core/FlightRecorder.hpp>
 #include <core/Scope.hpp>
 #include <core/Settings.hpp>
 #include <core/Thread.hpp>
@@ -73,6 +74,7 @@
 #include <r/ROptions.hpp>
 #include <r/RFunctionHook.hpp>
 #include <r/RInterface.hpp>
+#include <r/RSourceManager.hpp>
 #include <r/session/RSession.hpp>
 #include <r/session/RSessionState.hpp>
 #include <r/session/RClientState.hpp>
@@ -106,6 +108,7 @@
 #include "SessionInit.hpp"
 #include "SessionMainProcess.hpp"
 #include "SessionRpc.hpp"
+#include "SessionStartupProfiler.hpp"
 #include "SessionSuspend.hpp"
 
 #include <session/SessionRUtil.hpp>
@@ -120,6 +123,7 @@
 #include "modules/SessionBreakpoints.hpp"
 #include "modules/SessionHTMLPreview.hpp"
 #include "modules/SessionCodeSearch.hpp"
+#include "modules/SessionCompletionUsage.hpp"
 #include "modules/SessionConsole.hpp"
 #include "modules/SessionCrypto.hpp"
 #include "modules/SessionErrors.hpp"
@@ -133,6 +137,8 @@
 #include "modules/SessionPath.hpp"
 #include "modules/SessionPackages.hpp"
 #include "modules/SessionPackrat.hpp"
+#include "modules/SessionAllocationTracker.hpp"
+#include "modules/SessionCpuProfiler.hpp"
 #include "modules/SessionProfiler.hpp"
 #include "modules/SessionRAddins.hpp"
 #include "modules/SessionRCompletions.hpp"
@@ -148,6 +154,7 @@
 #include "modules/SessionHistory.hpp"
 #include "modules/SessionLimits.hpp"
 #include "modules/SessionLists.hpp"
+#include "modules/SessionMemory.hpp"
 #include "modules/build/SessionBuild.hpp"
 #include "modules/clang/SessionClang.hpp"
 #include "modules/connections/SessionConnections.hpp"
@@ -310,12 +317,23 @@ Error suspendForRestart(const core::json::JsonRpcRequest& request,
 }
 
 
+// THREAD-SAFE: touches no state at all; registered on the worker pool
+// so clients can measure latency even while R is busy
 Error ping(const core::json::JsonRpcRequest& request,
            json::JsonRpcResponse* pResponse)
 {
    return Success();
 }
 
+// THREAD-SAFE: the flight recorder is lock-free; registered on the
+// worker pool so the trace can be retrieved even while R is hung
+Error dumpFlightRecorder(const core::json::JsonRpcRequest& request,
+                         json::JsonRpcResponse* pResponse)
+{
+   pResponse->setResult(core::flight_recorder::contents());
+   return Success();
+}
+
 Error startClientEventService()
 {
    return clientEventService().start(rsession::persistentState().activeClientId());
@@ -391,8 +409,12 @@ void exitEarly(int status)
    ::exit(status);
 }
       
-Error rInit(const rstudio::r::session::RInitInfo& rInitInfo) 
+Error rInit(const rstudio::r::session::RInitInfo& rInitInfo)
 {
+   // R itself is up -- the remaining startup work is module and rpc
+   // initialization (individual steps below are timed as sub-phases)
+   startup_profiler::advancePhase("initialize modules");
+
    // save state we need to reference later
    suspend::setSessionResumed(rInitInfo.resumed);
    
@@ -404,128 +426,165 @@ Error rInit(const rstudio::r::session::RInitInfo& rInitInfo)
    module_context::registerWaitForMethod(kHandleUnsavedChangesCompleted);
    module_context::registerWaitForMethod(kRStudioAPIShowDialogMethod);
 
-   // execute core initialization functions
+   // execute core initialization functions. tasks run on the calling
+   // (R) thread in declaration order -- exactly as the previous
+   // ExecBlock did -- except for the curated set at the bottom which
+   // runs on a small pool (see addConcurrent below)
    using boost::bind;
    using namespace rstudio::core::system;
    using namespace rsession::module_context;
-   ExecBlock initialize ;
+   ParallelExecBlock initialize;
+   initialize.setTaskObserver(startup_profiler::recordInitStep);
    initialize.addFunctions()
-   
+
       // client event service
-      (startClientEventService)
-      
+      ("startClientEventService", startClientEventService)
+
       // rpc methods
-      (rpc::initialize)
+      ("rpc", rpc::initialize)
+
+      // startup profiler rpc
+      ("startup_profiler", startup_profiler::initialize)
 
       // json-rpc listeners
-      (bind(registerRpcMethod, kConsoleInput, bufferConsoleInput))
-      (bind(registerRpcMethod, "suspend_for_restart", suspendForRestart))
-      (bind(registerRpcMethod, "ping", ping))
+      ("console_input rpc", bind(registerRpcMethod, kConsoleInput, bufferConsoleInput))
+      ("suspend_for_restart rpc", bind(registerRpcMethod, "suspend_for_restart", suspendForRestart))
+      ("ping rpc", bind(registerThreadsafeRpcMethod, "ping", ping))
+      ("dump_flight_recorder rpc", bind(registerThreadsafeRpcMethod, "dump_flight_recorder",
+            dumpFlightRecorder))
 
       // signal handlers
-      (registerSignalHandlers)
+      ("registerSignalHandlers", registerSignalHandlers)
 
       // main module context
-      (module_context::initialize)
+      ("module_context", module_context::initialize)
 
       // projects (early project init required -- module inits below
       // can then depend on e.g. computed defaultEncoding)
-      (projects::initialize)
+      ("projects", projects::initialize)
 
       // source database
-      (source_database::initialize)
+      ("source_database", source_database::initialize)
 
       // content urls
-      (content_urls::initialize)
+      ("content_urls", content_urls::initialize)
 
       // overlay R
-      (bind(sourceModuleRFile, "SessionOverlay.R"))
+      ("source SessionOverlay.R",
+            bind(sourceModuleRFile, "SessionOverlay.R"))
    
       // addins
-      (addins::initialize)
+      ("addins", addins::initialize)
 
       // console processes
-      (console_process::initialize)
+      ("console_process", console_process::initialize)
          
       // r utils
-      (r_utils::initialize)
+      ("r_utils", r_utils::initialize)
 
       // modules with c++ implementations
-      (modules::spelling::initialize)
-      (modules::lists::initialize)
-      (modules::path::initialize)
-      (modules::limits::initialize)
-      (modules::ppe::initialize)
-      (modules::ask_pass::initialize)
-      (modules::agreement::initialize)
-      (modules::console::initialize)
+      ("modules::spelling", modules::spelling::initialize)
+      ("modules::lists", modules::lists::initialize)
+      ("modules::path", modules::path::initialize)
+      ("modules::limits", modules::limits::initialize)
+      ("modules::memory", modules::memory::initialize)
+      ("modules::ppe", modules::ppe::initialize)
+      ("modules::ask_pass", modules::ask_pass::initialize)
+      ("modules::console", modules::console::initialize)
 #ifdef RSTUDIO_SERVER
-      (modules::crypto::initialize)
+      ("modules::crypto", modules::crypto::initialize)
 #endif
-      (modules::code_search::initialize)
-      (modules::clang::initialize)
-      (modules::connections::initialize)
-      (modules::files::initialize)
-      (modules::find::initialize)
-      (modules::environment::initialize)
-      (modules::dependencies::initialize)
-      (modules::dirty::initialize)
-      (modules::workbench::initialize)
-      (modules::data::initialize)
-      (modules::help::initialize)
-      (modules::presentation::initialize)
-      (modules::plots::initialize)
-      (modules::packages::initialize)
-      (modules::profiler::initialize)
-      (modules::viewer::initialize)
-      (modules::rmarkdown::initialize)
-      (modules::rmarkdown::notebook::initialize)
-      (modules::rmarkdown::templates::initialize)
-      (modules::rpubs::initialize)
-      (modules::shiny::initialize)
-      (modules::source::initialize)
-      (modules::source_control::initialize)
-      (modules::authoring::initialize)
-      (modules::html_preview::initialize)
-      (modules::history::initialize)
-      (modules::build::initialize)
-      (modules::overlay::initialize)
-      (modules::breakpoints::initialize)
-      (modules::errors::initialize)
-      (modules::updates::initialize)
-      (modules::about::initialize)
-      (modules::shiny_viewer::initialize)
-      (modules::rsconnect::initialize)
-      (modules::packrat::initialize)
-      (modules::rhooks::initialize)
-      (modules::r_packages::initialize)
-      (modules::diagnostics::initialize)
-      (modules::markers::initialize)
-      (modules::snippets::initialize)
-      (modules::user_commands::initialize)
-      (modules::r_addins::initialize)
-      (modules::projects::templates::initialize)
-      (modules::mathjax::initialize)
-      (modules::rstudioapi::initialize)
-      (modules::libpaths::initialize)
-      (modules::explorer::initialize)
-      (modules::ask_secret::initialize)
-      (modules::reticulate::initialize)
-      (modules::tests::initialize)
+      ("modules::code_search", modules::code_search::initialize)
+      ("modules::completion_usage", modules::completion_usage::initialize)
+      ("modules::clang", modules::clang::initialize)
+      ("modules::connections", modules::connections::initialize)
+      ("modules::files", modules::files::initialize)
+      ("modules::find", modules::find::initialize)
+      ("modules::environment", modules::environment::initialize)
+      ("modules::dependencies", modules::dependencies::initialize)
+      ("modules::dirty", modules::dirty::initialize)
+      ("modules::workbench", modules::workbench::initialize)
+      ("modules::data", modules::data::initialize)
+      ("modules::help", modules::help::initialize)
+      // presentation is activated lazily on first use (unless persisted
+      // presentation state needs to be restored at startup)
+      ("modules::presentation", modules::presentation::initializeLazy)
+      ("modules::plots", modules::plots::initialize)
+      ("modules::packages", modules::packages::initialize)
+      ("modules::profiler", modules::profiler::initialize)
+      ("modules::cpu_profiler", modules::cpu_profiler::initialize)
+      ("modules::allocation_tracker", modules::allocation_tracker::initialize)
+      ("modules::viewer", modules::viewer::initialize)
+      ("modules::rmarkdown", modules::rmarkdown::initialize)
+      ("modules::rmarkdown::notebook", modules::rmarkdown::notebook::initialize)
+      ("modules::rmarkdown::templates", modules::rmarkdown::templates::initialize)
+      // rpubs is activated lazily on first use
+      ("modules::rpubs", modules::rpubs::initializeLazy)
+      ("modules::shiny", modules::shiny::initialize)
+      ("modules::source", modules::source::initialize)
+      ("modules::source_control", modules::source_control::initialize)
+      ("modules::authoring", modules::authoring::initialize)
+      ("modules::html_preview", modules::html_preview::initialize)
+      ("modules::history", modules::history::initialize)
+      ("modules::build", modules::build::initialize)
+      ("modules::overlay", modules::overlay::initialize)
+      ("modules::breakpoints", modules::breakpoints::initialize)
+      ("modules::errors", modules::errors::initialize)
+      ("modules::shiny_viewer", modules::shiny_viewer::initialize)
+      ("modules::rsconnect", modules::rsconnect::initialize)
+      ("modules::packrat", modules::packrat::initialize)
+      ("modules::rhooks", modules::rhooks::initialize)
+      ("modules::r_packages", modules::r_packages::initialize)
+      ("modules::diagnostics", modules::diagnostics::initialize)
+      ("modules::markers", modules::markers::initialize)
+      ("modules::user_commands", modules::user_commands::initialize)
+      ("modules::r_addins", modules::r_addins::initialize)
+      ("modules::projects::templates", modules::projects::templates::initialize)
+      ("modules::rstudioapi", modules::rstudioapi::initialize)
+      ("modules::libpaths", modules::libpaths::initialize)
+      ("modules::explorer", modules::explorer::initialize)
+      ("modules::ask_secret", modules::ask_secret::initialize)
+      ("modules::reticulate", modules::reticulate::initialize)
+      ("modules::tests", modules::tests::initialize)
 
       // workers
-      (workers::web_request::initialize)
+      ("workers::web_request", workers::web_request::initialize)
 
       // R code
-      (bind(sourceModuleRFile, "SessionCodeTools.R"))
-      (bind(sourceModuleRFile, "SessionCompletionHooks.R"))
-      (bind(sourceModuleRFile, "SessionPatches.R"))
+      ("source SessionCodeTools.R",
+            bind(sourceModuleRFile, "SessionCodeTools.R"))
+      ("source SessionCompletionHooks.R",
+            bind(sourceModuleRFile, "SessionCompletionHooks.R"))
+      ("source SessionPatches.R",
+            bind(sourceModuleRFile, "SessionPatches.R"))
    
       // unsupported functions
-      (bind(rstudio::r::function_hook::registerUnsupported, "bug.report", "utils"))
-      (bind(rstudio::r::function_hook::registerUnsupported, "help.request", "utils"))
+      ("unsupported function hooks",
+            bind(rstudio::r::function_hook::registerUnsupported, "bug.report", "utils"))
+      ("unsupported function hooks (help.request)",
+            bind(rstudio::r::function_hook::registerUnsupported, "help.request", "utils"))
    ;
 
+   // modules whose initialization only registers rpc methods and uri
+   // handlers (and touches no R state) run off the R thread while the
+   // sequence above continues -- registration is mutex guarded (see
+   // SessionRpc.cpp and SessionUriHandlers.cpp)
+   initialize.addConcurrent("modules::agreement",
+                            modules::agreement::initialize,
+                            ParallelExecBlock::dependsOn("module_context"));
+   initialize.addConcurrent("modules::updates",
+                            modules::updates::initialize,
+                            ParallelExecBlock::dependsOn("module_context"));
+   initialize.addConcurrent("modules::about",
+                            modules::about::initialize,
+                            ParallelExecBlock::dependsOn("module_context"));
+   initialize.addConcurrent("modules::snippets",
+                            modules::snippets::initialize,
+                            ParallelExecBlock::dependsOn("module_context"));
+   initialize.addConcurrent("modules::mathjax",
+                            modules::mathjax::initialize,
+                            ParallelExecBlock::dependsOn("module_context"));
+
    Error error = initialize.execute();
    if (error)
       return error;
@@ -561,6 +620,10 @@ Error rInit(const rstudio::r::session::RInitInfo& rInitInfo)
       exitEarly(result);
    }
    
+   // remaining init work runs until the client connects and the
+   // deferred session restore completes (see ensureSessionInitialized)
+   startup_profiler::advancePhase("register R rpc methods and begin session");
+
    // register all of the json rpc methods implemented in R
    json::JsonRpcMethods rMethods ;
    error = rstudio::r::json::getRpcMethods(&rMethods);
@@ -658,10 +721,84 @@ void rSessionInitHook(bool newSession)
    module_context::enqueClientEvent(event);
 }
 
+// deferred cleanup: shutdown moves doomed files aside (a cheap rename)
+// rather than removing them synchronously, and the next session start
+// sweeps the moved-aside files at idle. this keeps quit fast even when
+// session data is large or lives on a slow network volume
+FilePath deferredCleanupPath()
+{
+   return rsession::options().userScratchPath().complete("deferred-cleanup");
+}
+
+// move a path aside for removal by the next session; falls back to
+// synchronous removal when the rename isn't possible (e.g. the deferred
+// cleanup directory is on a different file system)
+Error deferredRemove(const FilePath& targetPath)
+{
+   if (!targetPath.exists())
+      return Success();
+
+   FilePath cleanupRoot = deferredCleanupPath();
+   Error error = cleanupRoot.ensureDirectory();
+   if (!error)
+   {
+      FilePath movedPath = cleanupRoot.complete(
+                                 core::system::generateUuid(false));
+      error = targetPath.move(movedPath, FilePath::MoveDirect);
+      if (!error)
+         return Success();
+   }
+
+   // a copy/delete fallback would be slower than removal, so just remove
+   return targetPath.removeIfExists();
+}
+
+void sweepDeferredCleanup()
+{
+   FilePath cleanupRoot = deferredCleanupPath();
+   if (!cleanupRoot.exists())
+      return;
+
+   std::vector<FilePath> children;
+   Error error = cleanupRoot.children(&children);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   BOOST_FOREACH(const FilePath& child, children)
+   {
+      error = child.remove();
+      if (error)
+         LOG_ERROR(error);
+   }
+}
+
 void rDeferredInit(bool newSession)
 {
    module_context::events().onDeferredInit(newSession);
-   
+
+   // sweep files moved aside by a previous session's shutdown (this is
+   // the deferred half of that shutdown, so run it at idle)
+   module_context::scheduleDelayedWork(
+                        "deferred cleanup sweep",
+                        boost::posix_time::seconds(30),
+                        sweepDeferredCleanup,
+                        true);
+
+   // if the session was restored progressively then materialize the
+   // remaining global objects during idle time (objects the user
+   // touches are loaded on demand, independent of this worker)
+   if (rstudio::r::session::hasPendingGlobalObjects())
+   {
+      module_context::scheduleIncrementalWork(
+               "restore global environment",
+               boost::posix_time::milliseconds(100),
+               rstudio::r::session::forceNextPendingGlobalObject,
+               true);
+   }
+
    // schedule execution of the session init hook
    module_context::scheduleDelayedWork(
                         boost::posix_time::seconds(1),
@@ -1080,16 +1217,32 @@ void rCleanup(bool terminatedNormally)
       if (terminatedNormally)
          rsession::persistentState().setAbend(false);
 
+      // on abnormal termination dump the flight recorder trace so there
+      // is something to diagnose with after the fact
+      if (!terminatedNormally && !module_context::activeSession().empty())
+      {
+         Error error = core::writeStringToFile(
+               module_context::activeSession().scratchPath().complete(
+                                                "flight-recorder-dump"),
+               core::flight_recorder::contents());
+         if (error)
+            LOG_ERROR(error);
+      }
+
       // set active session flag indicating we are no longer running
       module_context::activeSession().endSession();
 
       // fire shutdown event to modules
       module_context::events().onShutdown(terminatedNormally);
 
-      // destroy session if requested
+      // destroy session if requested. the session data is moved aside
+      // and removed by the next session at idle -- recursive removal
+      // can take seconds on slow or network volumes and quit shouldn't
+      // wait on it
       if (s_destroySession)
       {
-         Error error = module_context::activeSession().destroy();
+         Error error = deferredRemove(
+                              module_context::activeSession().scratchPath());
          if (error)
             LOG_ERROR(error);
 
@@ -1101,10 +1254,14 @@ void rCleanup(bool terminatedNormally)
       FileLock::cleanUp();
 
       // cause graceful exit of clientEventService (ensures delivery
-      // of any pending events prior to process termination). wait a
-      // very brief interval first to allow the quit or other termination
-      // related events to get into the queue
-      boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+      // of any pending events prior to process termination). wait until
+      // the quit or other termination related events have been picked
+      // up off the queue (but never longer than the 100ms we always
+      // used to wait), plus a brief grace period for the event service
+      // to write them out
+      for (int i = 0; i < 9 && rsession::clientEventQueue().hasEvents(); i++)
+         boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+      boost::this_thread::sleep(boost::posix_time::milliseconds(10));
 
       // only stop the http services if we are in server mode. in desktop
       // mode we had issues with both OSX crashing and with Windows taking
@@ -1558,6 +1715,9 @@ int main (int argc, char * const argv[])
 #endif
       s_printCharsetWarning = !ensureUtf8Charset();
       
+      // begin startup phase timing
+      startup_profiler::advancePhase("read program options");
+
       // read program options
       std::ostringstream osWarnings;
       Options& options = rsession::options();
@@ -1585,8 +1745,11 @@ int main (int argc, char * const argv[])
                                                 options.programIdentity()));
       }
 
-      // initialize file lock config
+      // initialize file lock config and renew lock leases from a
+      // background thread (so held locks never go stale and lock
+      // operations don't require per-operation filesystem round trips)
       FileLock::initialize();
+      FileLock::refreshPeriodically();
 
       // convenience flags for server and desktop mode
       bool desktopMode = options.programMode() == kSessionProgramModeDesktop;
@@ -1609,6 +1772,7 @@ int main (int argc, char * const argv[])
       }
 
       // initialize overlay
+      startup_profiler::advancePhase("initialize overlay");
       error = rsession::overlay::initialize();
       if (error)
          return sessionExitFailure(error, ERROR_LOCATION);
@@ -1679,10 +1843,23 @@ int main (int argc, char * const argv[])
       // has access to the queue
       rsession::initializeClientEventQueue();
 
-      // detect parent termination
-      if (desktopMode)
+      // detect parent termination (but not when the frontend launched us
+      // in detach mode -- in that case we deliberately outlive it so the
+      // next instance of the frontend can reattach to us)
+      if (desktopMode && core::system::getenv("RS_DETACH_SESSION").empty())
          core::thread::safeLaunchThread(detectParentTermination);
 
+      // start http connection listener as early as possible so clients
+      // can connect (and have their requests queued) while the rest of
+      // startup -- user settings, project context, and R itself --
+      // proceeds; this lets the desktop frontend overlap its own
+      // initialization with ours rather than polling for the port
+      startup_profiler::advancePhase("start http listener");
+      error = waitWithTimeout(
+            http_methods::startHttpConnectionListenerWithTimeout, 0, 100, 1);
+      if (error)
+         return sessionExitFailure(error, ERROR_LOCATION);
+
       // set the rpostback absolute path
       FilePath rpostback = options.rpostbackPath()
                            .parent().parent()
@@ -1740,6 +1917,7 @@ int main (int argc, char * const argv[])
       }
 
       // initialize user settings
+      startup_profiler::advancePhase("initialize settings and project");
       error = userSettings().initialize();
       if (error)
          return sessionExitFailure(error, ERROR_LOCATION) ;
@@ -1759,14 +1937,9 @@ int main (int argc, char * const argv[])
       if (error)
          return sessionExitFailure(error, ERROR_LOCATION);
          
-      // start http connection listener
-      error = waitWithTimeout(
-            http_methods::startHttpConnectionListenerWithTimeout, 0, 100, 1);
-      if (error)
-         return sessionExitFailure(error, ERROR_LOCATION);
-
       // run optional preflight script -- needs to be after the http listeners
       // so the proxy server sees that we have startup up
+      startup_profiler::advancePhase("preflight and user directories");
       error = runPreflightScript();
       if (error)
          return sessionExitFailure(error, ERROR_LOCATION);
@@ -1799,6 +1972,13 @@ int main (int argc, char * const argv[])
       userSettings().syncConsoleColorEnv();
 
       // r options
+      startup_profiler::advancePhase("initialize R");
+
+      // cache parsed/byte-compiled module R sources across this user's
+      // sessions (see SourceManager::setCompiledCacheDir)
+      rstudio::r::sourceManager().setCompiledCacheDir(
+         module_context::userScratchPath().complete("compiled-r-source"));
+
       rstudio::r::session::ROptions rOptions ;
       rOptions.userHomePath = options.userHomePath();
       rOptions.userScratchPath = userScratchPath;
@@ -15,6 +15,7 @@
 
 #include "SessionModuleContextInternal.hpp"
 
+#include <deque>
 #include <vector>
 
 #include <boost/assert.hpp>
@@ -69,6 +70,8 @@
 #include <session/http/SessionRequest.hpp>
 
 #include "SessionClientEventQueue.hpp"
+#include "SessionRpc.hpp"
+#include "SessionUriHandlers.hpp"
 
 #include <session/projects/SessionProjects.hpp>
 
@@ -371,6 +374,9 @@ SEXP rs_packageLoaded(SEXP pkgnameSEXP)
 {
    std::string pkgname = r::sexp::safeAsString(pkgnameSEXP);
 
+   // function bindings may have changed -- drop cached lookups
+   r::exec::invalidatePreparedCalls();
+
    // fire server event
    events().onPackageLoaded(pkgname);
 
@@ -386,6 +392,10 @@ SEXP rs_packageLoaded(SEXP pkgnameSEXP)
 SEXP rs_packageUnloaded(SEXP pkgnameSEXP)
 {
    std::string pkgname = r::sexp::safeAsString(pkgnameSEXP);
+
+   // function bindings may have changed -- drop cached lookups
+   r::exec::invalidatePreparedCalls();
+
    ClientEvent packageUnloadedEvent(
             client_events::kPackageUnloaded,
             json::Value(pkgname));
@@ -687,81 +697,326 @@ void onResumed(const Settings& persistentState)
 
 namespace {
 
-typedef std::vector<boost::shared_ptr<ScheduledCommand> >
-                                                      ScheduledCommands;
+// a scheduled command plus per-task execution-time accounting (surfaced
+// via rs_scheduledCommandDiagnostics so expensive tasks can be found)
+struct ScheduledCommandRecord
+{
+   ScheduledCommandRecord() : executions(0), totalMs(0), maxMs(0) {}
+
+   std::string name;
+   boost::shared_ptr<ScheduledCommand> pCommand;
+   int executions;
+   double totalMs;
+   double maxMs;
+
+   bool finished() const { return pCommand->finished(); }
+};
+
+typedef std::vector<ScheduledCommandRecord> ScheduledCommands;
 ScheduledCommands s_scheduledCommands;
 ScheduledCommands s_idleScheduledCommands;
 
-void addScheduledCommand(boost::shared_ptr<ScheduledCommand> pCommand,
+void addScheduledCommand(const std::string& name,
+                         boost::shared_ptr<ScheduledCommand> pCommand,
                          bool idleOnly)
 {
+   ScheduledCommandRecord record;
+   record.name = !name.empty() ? name : std::string("(unnamed)");
+   record.pCommand = pCommand;
    if (idleOnly)
-      s_idleScheduledCommands.push_back(pCommand);
+      s_idleScheduledCommands.push_back(record);
    else
-      s_scheduledCommands.push_back(pCommand);
+      s_scheduledCommands.push_back(record);
 }
 
 void executeScheduledCommands(ScheduledCommands* pCommands)
 {
-   // make a copy of scheduled commands before executing them
-   // (this is because a scheduled command could result in
-   // R code executing which in turn could cause the list of
-   // scheduled commands to be mutated and these iterators
-   // invalidated)
-   ScheduledCommands commands = *pCommands;
+   // NOTE: index access rather than iterators because a scheduled
+   // command could result in R code executing which in turn could
+   // cause additional commands to be scheduled (invalidating
+   // iterators); commands are only removed below, after execution
+   std::size_t count = pCommands->size();
+   for (std::size_t i = 0; i < count; i++)
+   {
+      double startMs = date_time::millisecondsSinceEpoch();
+      (*pCommands)[i].pCommand->execute();
 
-   // execute all commands
-   std::for_each(commands.begin(),
-                 commands.end(),
-                 boost::bind(&ScheduledCommand::execute, _1));
+      // only attribute passes where the command actually ran (execute
+      // is a cheap no-op while a periodic command's period is elapsing)
+      if ((*pCommands)[i].pCommand->executedLast())
+      {
+         double elapsedMs = date_time::millisecondsSinceEpoch() - startMs;
+         ScheduledCommandRecord& record = (*pCommands)[i];
+         record.executions++;
+         record.totalMs += elapsedMs;
+         record.maxMs = std::max(record.maxMs, elapsedMs);
+      }
+   }
 
    // remove any commands which are finished
    pCommands->erase(
                  std::remove_if(
                     pCommands->begin(),
                     pCommands->end(),
-                    boost::bind(&ScheduledCommand::finished, _1)),
+                    boost::bind(&ScheduledCommandRecord::finished, _1)),
                  pCommands->end());
 }
 
+void scheduledCommandsAsJson(const ScheduledCommands& commands,
+                             const std::string& commandClass,
+                             core::json::Array* pCommandsJson)
+{
+   BOOST_FOREACH(const ScheduledCommandRecord& record, commands)
+   {
+      core::json::Object commandJson;
+      commandJson["name"] = record.name;
+      commandJson["class"] = commandClass;
+      commandJson["executions"] = record.executions;
+      commandJson["total_ms"] = record.totalMs;
+      commandJson["max_ms"] = record.maxMs;
+      pCommandsJson->push_back(commandJson);
+   }
+}
+
+SEXP rs_scheduledCommandDiagnostics()
+{
+   core::json::Array commandsJson;
+   scheduledCommandsAsJson(s_scheduledCommands, "normal", &commandsJson);
+   scheduledCommandsAsJson(s_idleScheduledCommands, "idle", &commandsJson);
+
+   r::sexp::Protect rProtect;
+   return r::sexp::create(commandsJson, &rProtect);
+}
+
+// budgeted change detection: registered handlers run within a fixed
+// time budget per detection pass, and handlers that don't fit run later
+// when the session is idle
+
+struct ChangeDetectionHandler
+{
+   ChangeDetectionHandler()
+      : onlyWhenFlagged(false),
+        flagged(false),
+        pending(false),
+        pendingSource(ChangeSourceREPL)
+   {
+   }
+
+   std::string name;
+   boost::function<void(ChangeSource)> handler;
+   bool onlyWhenFlagged;
+   bool flagged;
+   bool pending;
+   ChangeSource pendingSource;
+};
+
+std::vector<ChangeDetectionHandler> s_changeDetectionHandlers;
+
+// milliseconds of change detection we're willing to pay per pass (i.e.
+// per console prompt) -- the remainder is deferred to idle time so
+// prompt latency stays flat as modules accumulate
+const double kChangeDetectionBudgetMs = 25;
+
+// passes start where the previous one left off so deferral doesn't
+// starve handlers late in the registration order
+std::size_t s_changeDetectionIndex = 0;
+
+// guard against recursive passes (handlers can execute R, which can in
+// turn fire change detection)
+bool s_runningChangeDetection = false;
+
+void runPendingChangeDetection()
+{
+   std::size_t count = s_changeDetectionHandlers.size();
+   if (count == 0 || s_runningChangeDetection)
+      return;
+
+   s_runningChangeDetection = true;
+   double startMs = date_time::millisecondsSinceEpoch();
+   for (std::size_t i = 0; i < count; i++)
+   {
+      // stop when the budget is exhausted (the first handler always
+      // runs so every pass makes progress); whatever remains pending
+      // runs on the next pass or at idle
+      if (i > 0 &&
+          (date_time::millisecondsSinceEpoch() - startMs) >
+                                             kChangeDetectionBudgetMs)
+      {
+         break;
+      }
+
+      // NOTE: index access rather than iterators/references across the
+      // handler call because handlers can register additional handlers
+      std::size_t index = s_changeDetectionIndex;
+      s_changeDetectionIndex = (s_changeDetectionIndex + 1) % count;
+      if (!s_changeDetectionHandlers[index].pending)
+         continue;
+
+      s_changeDetectionHandlers[index].pending = false;
+      s_changeDetectionHandlers[index].flagged = false;
+      ChangeSource source = s_changeDetectionHandlers[index].pendingSource;
+      s_changeDetectionHandlers[index].handler(source);
+   }
+   s_runningChangeDetection = false;
+}
+
+// background prefetching: modules register predictors which observe
+// rpc traffic and queue prefetch tasks for the actions the user is
+// likely to take next. tasks run one per idle pass (so they never
+// compete with user-visible work) on the main thread (so they may call
+// into R), and the queue is bounded -- when the user gets ahead of the
+// prefetcher, the oldest predictions are simply dropped
+
+struct PrefetchTask
+{
+   // COPYING: via compiler (copyable members)
+
+   std::string name;
+   boost::function<void()> execute;
+};
+
+// main thread only (predictors run during rpc dispatch and tasks run
+// during idle background processing)
+std::vector<boost::function<void(const core::json::JsonRpcRequest&)> >
+                                                      s_rpcPrefetchers;
+std::deque<PrefetchTask> s_prefetchTasks;
+const std::size_t kMaxPrefetchTasks = 10;
+
+void executeNextPrefetchTask()
+{
+   if (s_prefetchTasks.empty())
+      return;
+
+   PrefetchTask task = s_prefetchTasks.front();
+   s_prefetchTasks.pop_front();
+   task.execute();
+}
+
+void dispatchChangeDetection(ChangeSource source)
+{
+   // mark eligible handlers as having work to do, then run as many as
+   // fit within the budget
+   BOOST_FOREACH(ChangeDetectionHandler& handler, s_changeDetectionHandlers)
+   {
+      if (!handler.onlyWhenFlagged || handler.flagged)
+      {
+         handler.pending = true;
+         handler.pendingSource = source;
+      }
+   }
+
+   runPendingChangeDetection();
+}
 
 } // anonymous namespace
 
 void scheduleIncrementalWork(
+         const std::string& name,
          const boost::posix_time::time_duration& incrementalDuration,
          const boost::function<bool()>& execute,
          bool idleOnly)
 {
-   addScheduledCommand(boost::shared_ptr<ScheduledCommand>(
+   addScheduledCommand(name,
+                       boost::shared_ptr<ScheduledCommand>(
                            new IncrementalCommand(incrementalDuration,
                                                   execute)),
                          idleOnly);
 }
 
 void scheduleIncrementalWork(
+         const boost::posix_time::time_duration& incrementalDuration,
+         const boost::function<bool()>& execute,
+         bool idleOnly)
+{
+   scheduleIncrementalWork(std::string(),
+                           incrementalDuration,
+                           execute,
+                           idleOnly);
+}
+
+void scheduleIncrementalWork(
+         const std::string& name,
          const boost::posix_time::time_duration& initialDuration,
          const boost::posix_time::time_duration& incrementalDuration,
          const boost::function<bool()>& execute,
          bool idleOnly)
 {
-   addScheduledCommand(boost::shared_ptr<ScheduledCommand>(
+   addScheduledCommand(name,
+                       boost::shared_ptr<ScheduledCommand>(
                            new IncrementalCommand(initialDuration,
                                                   incrementalDuration,
                                                   execute)),
                            idleOnly);
 }
 
+void scheduleIncrementalWork(
+         const boost::posix_time::time_duration& initialDuration,
+         const boost::posix_time::time_duration& incrementalDuration,
+         const boost::function<bool()>& execute,
+         bool idleOnly)
+{
+   scheduleIncrementalWork(std::string(),
+                           initialDuration,
+                           incrementalDuration,
+                           execute,
+                           idleOnly);
+}
 
-void schedulePeriodicWork(const boost::posix_time::time_duration& period,
+void schedulePeriodicWork(const std::string& name,
+                          const boost::posix_time::time_duration& period,
                           const boost::function<bool()> &execute,
                           bool idleOnly,
                           bool immediate)
 {
-   addScheduledCommand(boost::shared_ptr<ScheduledCommand>(
+   addScheduledCommand(name,
+                       boost::shared_ptr<ScheduledCommand>(
                            new PeriodicCommand(period, execute, immediate)),
                        idleOnly);
 }
 
+void schedulePeriodicWork(const boost::posix_time::time_duration& period,
+                          const boost::function<bool()> &execute,
+                          bool idleOnly,
+                          bool immediate)
+{
+   schedulePeriodicWork(std::string(), period, execute, idleOnly, immediate);
+}
+
+void registerRpcPrefetcher(
+   const boost::function<void(const core::json::JsonRpcRequest&)>& predictor)
+{
+   s_rpcPrefetchers.push_back(predictor);
+}
+
+void schedulePrefetch(const std::string& name,
+                      const boost::function<void()>& execute)
+{
+   // coalesce with an identically named task already queued
+   BOOST_FOREACH(const PrefetchTask& task, s_prefetchTasks)
+   {
+      if (task.name == name)
+         return;
+   }
+
+   // bound the queue by dropping the oldest prediction
+   if (s_prefetchTasks.size() >= kMaxPrefetchTasks)
+      s_prefetchTasks.pop_front();
+
+   PrefetchTask task;
+   task.name = name;
+   task.execute = execute;
+   s_prefetchTasks.push_back(task);
+}
+
+void notifyRpcMethodInvoked(const core::json::JsonRpcRequest& request)
+{
+   // NOTE: index access rather than iterators because a predictor could
+   // conceivably register further predictors
+   std::size_t count = s_rpcPrefetchers.size();
+   for (std::size_t i = 0; i < count; i++)
+      s_rpcPrefetchers[i](request);
+}
+
 
 namespace {
 
@@ -826,18 +1081,48 @@ void performIdleOnlyAsyncRpcMethod(
 
 } // anonymous namespeace
 
-void scheduleDelayedWork(const boost::posix_time::time_duration& period,
+void scheduleDelayedWork(const std::string& name,
+                         const boost::posix_time::time_duration& period,
                          const boost::function<void()> &execute,
                          bool idleOnly)
 {
    boost::shared_ptr<bool> pExecuted(new bool(false));
 
-   schedulePeriodicWork(period,
+   schedulePeriodicWork(name,
+                        period,
                         boost::bind(performDelayedWork, execute, pExecuted),
                         idleOnly,
                         false);
 }
 
+void scheduleDelayedWork(const boost::posix_time::time_duration& period,
+                         const boost::function<void()> &execute,
+                         bool idleOnly)
+{
+   scheduleDelayedWork(std::string(), period, execute, idleOnly);
+}
+
+
+void registerChangeDetection(
+         const std::string& name,
+         const boost::function<void(ChangeSource)>& handler,
+         bool onlyWhenFlagged)
+{
+   ChangeDetectionHandler changeDetection;
+   changeDetection.name = name;
+   changeDetection.handler = handler;
+   changeDetection.onlyWhenFlagged = onlyWhenFlagged;
+   s_changeDetectionHandlers.push_back(changeDetection);
+}
+
+void flagChangeDetection(const std::string& name)
+{
+   BOOST_FOREACH(ChangeDetectionHandler& handler, s_changeDetectionHandlers)
+   {
+      if (handler.name == name)
+         handler.flagged = true;
+   }
+}
 
 void onBackgroundProcessing(bool isIdle)
 {
@@ -854,6 +1139,14 @@ void onBackgroundProcessing(bool isIdle)
    executeScheduledCommands(&s_scheduledCommands);
    if (isIdle)
       executeScheduledCommands(&s_idleScheduledCommands);
+
+   // run change detection deferred from a budgeted pass
+   if (isIdle)
+      runPendingChangeDetection();
+
+   // run at most one queued prefetch task per idle pass
+   if (isIdle)
+      executeNextPrefetchTask();
 }
 
 
@@ -866,6 +1159,123 @@ Error registerIdleOnlyAsyncRpcMethod(
                                                 _1, _2, function));
 }
 
+namespace {
+
+// a lazily activated module (see registerLazyModule). accessed from the
+// main thread only (both rpc methods and uri handlers are serviced there)
+struct LazyModule
+{
+   LazyModule() : activated(false) {}
+
+   std::string name;
+   boost::function<Error()> initFunction;
+   bool activated;
+};
+
+Error activateLazyModule(boost::shared_ptr<LazyModule> pModule)
+{
+   if (pModule->activated)
+      return Success();
+
+   // mark activated before running initialization so a failed
+   // activation isn't retried on every access
+   pModule->activated = true;
+
+   using namespace boost::posix_time;
+   ptime startTime = microsec_clock::universal_time();
+   Error error = pModule->initFunction();
+   boost::int64_t elapsedMs =
+      (microsec_clock::universal_time() - startTime).total_milliseconds();
+
+   LOG_DEBUG_MESSAGE("activated lazy module '" + pModule->name + "' in " +
+                     safe_convert::numberToString(elapsedMs) + "ms");
+
+   return error;
+}
+
+void lazyModuleRpcStub(boost::shared_ptr<LazyModule> pModule,
+                       const std::string& method,
+                       const json::JsonRpcRequest& request,
+                       const json::JsonRpcFunctionContinuation& continuation)
+{
+   Error error = activateLazyModule(pModule);
+
+   // if activation didn't replace the stub then the module advertised a
+   // method its initialization doesn't register
+   if (!error && rpc::isLazyRpcStub(method))
+   {
+      error = Error(json::errc::MethodNotFound, ERROR_LOCATION);
+      error.addProperty("method", method);
+   }
+
+   if (error)
+   {
+      json::JsonRpcResponse response;
+      continuation(error, &response);
+      return;
+   }
+
+   // re-dispatch to the handler registered by initialization
+   rpc::invokeRpcMethod(method, request, continuation);
+}
+
+void lazyModuleUriStub(boost::shared_ptr<LazyModule> pModule,
+                       const std::string& prefix,
+                       const core::http::Request& request,
+                       const core::http::UriHandlerFunctionContinuation& cont)
+{
+   Error error = activateLazyModule(pModule);
+
+   if (!error && uri_handlers::isLazyUriStub(prefix))
+   {
+      core::http::Response response;
+      response.setNotFoundError(request.uri());
+      cont(&response);
+      return;
+   }
+
+   if (error)
+   {
+      LOG_ERROR(error);
+      core::http::Response response;
+      response.setError(error);
+      cont(&response);
+      return;
+   }
+
+   // re-dispatch to the handler registered by initialization
+   uri_handlers::handlers().handlerFor(request.uri())(request, cont);
+}
+
+} // anonymous namespace
+
+Error registerLazyModule(
+                     const std::string& moduleName,
+                     const boost::function<Error()>& initFunction,
+                     const std::vector<std::string>& rpcMethods,
+                     const std::vector<std::string>& uriPrefixes)
+{
+   boost::shared_ptr<LazyModule> pModule(new LazyModule());
+   pModule->name = moduleName;
+   pModule->initFunction = initFunction;
+
+   BOOST_FOREACH(const std::string& method, rpcMethods)
+   {
+      rpc::registerLazyRpcStub(method,
+                               boost::bind(lazyModuleRpcStub,
+                                           pModule, method, _1, _2));
+   }
+
+   BOOST_FOREACH(const std::string& prefix, uriPrefixes)
+   {
+      uri_handlers::registerLazyUriStub(prefix,
+                                        boost::bind(lazyModuleUriStub,
+                                                    pModule, prefix, _1, _2));
+   }
+
+   return Success();
+}
+
 core::string_utils::LineEnding lineEndings(const core::FilePath& srcFile)
 {
    // potential special case for Makevars
@@ -1009,12 +1419,27 @@ FilePath safeCurrentPath()
    
 FilePath tempFile(const std::string& prefix, const std::string& extension)
 {
-   return r::session::utils::tempFile(prefix, extension);
+   // generate the name in-process within the (cached) R temp directory.
+   // this used to delegate to R's tempfile(), which cost an R round trip
+   // for every temp file -- visible in syscall profiles for features that
+   // create temp files in a loop. allocating out of the R temp directory
+   // also gives us bulk cleanup for free: R removes the entire directory
+   // at session exit, so callers which leak a file (or are interrupted
+   // before their RemoveOnExitScope runs) don't strand it
+   std::string filename = prefix +
+                          core::system::generateUuid(false) +
+                          "." + extension;
+   return tempDir().complete(filename);
 }
 
 FilePath tempDir()
 {
-   return r::session::utils::tempDir();
+   // the R temp directory is fixed for the lifetime of the session, so
+   // resolve it through R only once
+   static FilePath s_tempDir;
+   if (s_tempDir.empty())
+      s_tempDir = r::session::utils::tempDir();
+   return s_tempDir;
 }
 
 
@@ -1213,6 +1638,23 @@ std::vector<FilePath> getLibPaths()
    return libPaths;
 }
 
+std::string libraryStateHash(const std::vector<FilePath>& libPaths)
+{
+   // hash the library paths and their last write times; R updates a
+   // library directory's mtime whenever a package is installed into or
+   // removed from it, so this captures the installed package state
+   // without stat'ing every package
+   std::ostringstream ostr;
+   for (std::size_t i = 0; i < libPaths.size(); i++)
+   {
+      ostr << libPaths[i].absolutePath() << ":";
+      if (libPaths[i].exists())
+         ostr << libPaths[i].lastWriteTime();
+      ostr << ";";
+   }
+   return hash::crc32HexHash(ostr.str());
+}
+
 bool disablePackages()
 {
    return !core::system::getenv("RSTUDIO_DISABLE_PACKAGES").empty();
@@ -1727,6 +2169,11 @@ void enqueClientEvent(const ClientEvent& event)
    session::clientEventQueue().add(event);
 }
 
+void enqueClientEvent(ClientEvent&& event)
+{
+   session::clientEventQueue().add(std::move(event));
+}
+
 bool isDirectoryMonitored(const FilePath& directory)
 {
    return session::projects::projectContext().isMonitoringDirectory(directory) ||
@@ -2601,6 +3048,11 @@ Error initialize()
    
    RS_REGISTER_CALL_METHOD(rs_resolveAliasedPath, 1);
 
+   RS_REGISTER_CALL_METHOD(rs_scheduledCommandDiagnostics, 0);
+
+   // dispatch budgeted change detection from the main detection signal
+   events().onDetectChanges.connect(dispatchChangeDetection);
+
    // initialize monitored scratch dir
    initializeMonitoredUserScratchDir();
 
@@ -235,7 +235,10 @@ core::ProgramStatus Options::read(int argc, char * const argv[], std::ostream& o
        "WebSocket keep-alive ping interval (seconds)")
       (kWebSocketConnectTimeout,
        value<int>(&webSocketConnectTimeout_)->default_value(3),
-       "WebSocket initial connection timeout (seconds)");
+       "WebSocket initial connection timeout (seconds)")
+      (kWebSocketEvents,
+       value<bool>(&webSocketEvents_)->default_value(false),
+       "push client events over a WebSocket channel");
 
    // allow options
    options_description allow("allow");
@@ -337,7 +340,10 @@ core::ProgramStatus Options::read(int argc, char * const argv[], std::ostream& o
        "limit on time of top level computations")
       ("limit-xfs-disk-quota",
        value<bool>(&limitXfsDiskQuota_)->default_value(false),
-       "limit xfs disk quota");
+       "limit xfs disk quota")
+      ("memory-target-mb",
+       value<int>(&memoryTargetMb_)->default_value(0),
+       "resident memory target for idle trimming (0 for no target)");
    
    // external options
    options_description external("external");
@@ -685,6 +691,38 @@ core::ProgramStatus Options::read(int argc, char * const argv[], std::ostream& o
    return status;
 }
 
+bool Options::applyReloadableOption(const std::string& name,
+                                    const std::string& value)
+{
+   // options which are consulted each time they are needed can simply be
+   // swapped in place; anything baked into the process environment or
+   // read once at startup requires a restart to take effect
+   int* pIntOption = nullptr;
+   if (name == kTimeoutSessionOption)
+      pIntOption = &timeoutMinutes_;
+   else if (name == kDisconnectedTimeoutSessionOption)
+      pIntOption = &disconnectedTimeoutMinutes_;
+   else if (name == "limit-file-upload-size-mb")
+      pIntOption = &limitFileUploadSizeMb_;
+   else if (name == "limit-cpu-time-minutes")
+      pIntOption = &limitCpuTimeMinutes_;
+   else if (name == "memory-target-mb")
+      pIntOption = &memoryTargetMb_;
+   else if (name == kWebSocketPingInterval)
+      pIntOption = &webSocketPingSeconds_;
+   else if (name == kWebSocketConnectTimeout)
+      pIntOption = &webSocketConnectTimeout_;
+   else
+      return false;
+
+   boost::optional<int> intValue = safe_convert::stringTo<int>(value);
+   if (!intValue)
+      return false;
+
+   *pIntOption = *intValue;
+   return true;
+}
+
 bool Options::getBoolOverlayOption(const std::string& name)
 {
    std::string optionValue = getOverlayOption(name);
@@ -59,7 +59,18 @@ Error PersistentState::initialize()
    // session settings
    scratchPath = module_context::sessionScratchPath();
    statePath = scratchPath.complete("session-persistent-state");
-   return sessionSettings_.initialize(statePath);
+   error = sessionSettings_.initialize(statePath);
+   if (error)
+      return error;
+
+   // state is written on many UI interactions so coalesce bursts of
+   // changes into single writes (scratch paths are commonly on network
+   // file systems where scattered small synchronous writes are slow).
+   // settings which must be durable immediately flush explicitly below
+   settings_.enableDelayedWrites();
+   sessionSettings_.enableDelayedWrites();
+
+   return Success();
 }
 
 std::string PersistentState::activeClientId()
@@ -84,6 +95,7 @@ std::string PersistentState::newActiveClientId()
    {
       std::string newId = core::system::generateUuid();
       sessionSettings_.set(kActiveClientId, newId);
+      sessionSettings_.flush();
       return newId;
    }
    else
@@ -110,7 +122,10 @@ void PersistentState::setAbend(bool abend)
 { 
    if (serverMode_)
    {
+      // must hit disk right away -- the whole point of the abend flag is
+      // to survive a crash which may occur before a delayed write lands
       sessionSettings_.set(kAbend, abend);
+      sessionSettings_.flush();
    }
 }
 
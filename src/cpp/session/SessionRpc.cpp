@@ -13,16 +13,33 @@
  *
  */
 
+#include <cstdio>
+#include <set>
 #include <string>
 
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
 #include "SessionRpc.hpp"
 #include "SessionHttpMethods.hpp"
 #include "SessionClientEventQueue.hpp"
 
+#include <boost/algorithm/string/predicate.hpp>
+
 #include <core/json/Json.hpp>
 #include <core/json/JsonRpc.hpp>
 #include <core/Exec.hpp>
+#include <core/Hash.hpp>
 #include <core/Log.hpp>
+#include <core/PerformanceMetrics.hpp>
+#include <core/SafeConvert.hpp>
+#include <core/Thread.hpp>
+
+#include <core/http/Response.hpp>
+
+#include <session/SessionClientEventService.hpp>
+#include <session/SessionHttpConnectionQueue.hpp>
 
 #include <r/RExec.hpp>
 #include <r/RSexp.hpp>
@@ -36,11 +53,295 @@ namespace rstudio {
 namespace session {
 namespace {
 
-// json rpc methods
+// json rpc methods. registration is guarded by a mutex since module
+// initialization may register methods from parallel init tasks (see
+// ParallelExecBlock usage in SessionMain.cpp); lookups are unguarded
+// because they only occur after initialization is complete
 core::json::JsonRpcAsyncMethods* s_pJsonRpcMethods = NULL;
-   
+boost::mutex s_jsonRpcMethodsMutex;
+
+// methods currently occupied by lazy module stubs (guarded by
+// s_jsonRpcMethodsMutex). registration over a stub replaces it (normal
+// registration of a duplicate name is a no-op)
+std::set<std::string> s_lazyRpcStubs;
+
+// callers hold s_jsonRpcMethodsMutex
+void removeLazyRpcStub(const std::string& name)
+{
+   std::set<std::string>::iterator it = s_lazyRpcStubs.find(name);
+   if (it != s_lazyRpcStubs.end())
+   {
+      s_lazyRpcStubs.erase(it);
+      s_pJsonRpcMethods->erase(name);
+   }
+}
+
+// rpc methods registered as thread-safe -- these are dispatched on a
+// worker pool rather than the R event loop so they stay responsive
+// while R is busy. guarded by a mutex since the map is consulted from
+// the listener thread and worker threads while modules are still
+// registering methods
+core::json::JsonRpcMethods* s_pThreadsafeRpcMethods = NULL;
+boost::mutex s_threadsafeRpcMutex;
+
+// connection queue serviced by the worker pool (started lazily on
+// first registration of a thread-safe method)
+HttpConnectionQueue* s_pThreadsafeRpcQueue = NULL;
+bool s_threadsafeRpcWorkersRunning = false;
+const int kNumThreadsafeRpcWorkers = 2;
+
+// per-method execution budgets. allocation hooks aren't practical here
+// (handlers run arbitrary R code and share one heap with R itself), so
+// budgets are enforced by observation: wall time and resident set
+// growth are sampled around handler execution, overruns are logged and
+// counted per method, the response is flagged so the client can warn,
+// and the counters are exposed through get_rpc_budget_stats
+const int kDefaultRpcTimeBudgetMillis = 10000;
+const int kDefaultRpcMemoryBudgetMb = 256;
+
+struct RpcBudget
+{
+   RpcBudget()
+      : timeMillis(kDefaultRpcTimeBudgetMillis),
+        memoryMb(kDefaultRpcMemoryBudgetMb)
+   {
+   }
+   int timeMillis;
+   int memoryMb;
+};
+
+struct RpcBudgetStats
+{
+   RpcBudgetStats()
+      : invocations(0), timeOverruns(0), memoryOverruns(0),
+        maxElapsedMillis(0)
+   {
+   }
+   int invocations;
+   int timeOverruns;
+   int memoryOverruns;
+   int maxElapsedMillis;
+};
+
+// guarded by a mutex since the threadsafe rpc workers record here too
+boost::mutex s_budgetMutex;
+std::map<std::string, RpcBudget>* s_pRpcBudgets = NULL;
+std::map<std::string, RpcBudgetStats>* s_pRpcBudgetStats = NULL;
+
+// opt-in response cache for read-only rpc methods. an entry holds the
+// result of the last invocation along with an ETag over its serialized
+// form; a repeat request with identical parameters is served without
+// re-invoking the handler, and a client which presents the ETag in an
+// If-None-Match header gets a 304 with no body at all. entries are
+// dropped as soon as a client event of one of the method's declared
+// invalidation types is enqueued. cacheable handlers must be read-only
+// and must communicate exclusively through their result (custom
+// response fields aren't replayed on cache hits)
+struct RpcCacheEntry
+{
+   RpcCacheEntry()
+   {
+   }
+
+   // COPYING: via compiler (copyable members)
+
+   json::Array params;
+   json::Object kwparams;
+   json::Value result;
+   std::string eTag;
+   boost::posix_time::ptime storedTime;
+   std::set<int> invalidationEvents;
+};
+
+// guarded by a mutex since registration may occur from parallel init
+// tasks (lookups and stores only occur on the main thread, but take
+// the mutex anyway for simplicity)
+boost::mutex s_rpcCacheMutex;
+std::map<std::string, std::set<int> >* s_pRpcInvalidationEvents = NULL;
+std::map<std::string, RpcCacheEntry>* s_pRpcResponseCache = NULL;
+
+// look for a valid cached response for this request; returns false (and
+// drops stale entries) when the cache can't serve it
+bool lookupCachedRpcResponse(const json::JsonRpcRequest& request,
+                             json::Value* pResult,
+                             std::string* pETag)
+{
+   LOCK_MUTEX(s_rpcCacheMutex)
+   {
+      if (s_pRpcResponseCache == NULL)
+         return false;
+
+      std::map<std::string, RpcCacheEntry>::iterator it =
+                                 s_pRpcResponseCache->find(request.method);
+      if (it == s_pRpcResponseCache->end())
+         return false;
+
+      // parameters must match exactly
+      RpcCacheEntry& entry = it->second;
+      if (entry.params != request.params || entry.kwparams != request.kwparams)
+         return false;
+
+      // invalidate if any of the method's invalidation events has been
+      // enqueued since the entry was stored
+      if (clientEventQueue().eventOfTypeAddedSince(entry.invalidationEvents,
+                                                  entry.storedTime))
+      {
+         s_pRpcResponseCache->erase(it);
+         return false;
+      }
+
+      *pResult = entry.result;
+      *pETag = entry.eTag;
+      return true;
+   }
+   END_LOCK_MUTEX
+
+   // keep compiler happy
+   return false;
+}
+
+// store the response for a cacheable method; returns the entry's ETag
+// (empty for methods which aren't cacheable or responses which aren't)
+std::string storeCachedRpcResponse(const json::JsonRpcRequest& request,
+                                   json::JsonRpcResponse& response)
+{
+   // error responses and responses with deferred work aren't cacheable
+   if (response.error().type() != json::NullType ||
+       response.hasAfterResponse())
+   {
+      return std::string();
+   }
+
+   LOCK_MUTEX(s_rpcCacheMutex)
+   {
+      // only methods which declared cacheability participate
+      std::map<std::string, std::set<int> >::const_iterator it =
+                              s_pRpcInvalidationEvents->find(request.method);
+      if (it == s_pRpcInvalidationEvents->end())
+         return std::string();
+
+      RpcCacheEntry entry;
+      entry.params = request.params;
+      entry.kwparams = request.kwparams;
+      entry.result = response.result();
+      entry.eTag = "\"" + hash::fastHexHash(json::write(entry.result)) + "\"";
+      entry.storedTime = boost::posix_time::microsec_clock::universal_time();
+      entry.invalidationEvents = it->second;
+      (*s_pRpcResponseCache)[request.method] = entry;
+      return entry.eTag;
+   }
+   END_LOCK_MUTEX
+
+   // keep compiler happy
+   return std::string();
+}
+
+// current resident set in kb; returns 0 where unavailable (in which
+// case memory budgets simply aren't enforced)
+long residentMemoryKb()
+{
+#ifdef __linux__
+   FILE* fp = ::fopen("/proc/self/statm", "r");
+   if (fp == NULL)
+      return 0;
+
+   long size = 0, resident = 0;
+   int fields = ::fscanf(fp, "%ld %ld", &size, &resident);
+   ::fclose(fp);
+   if (fields != 2)
+      return 0;
+
+   return resident * (::sysconf(_SC_PAGESIZE) / 1024);
+#else
+   return 0;
+#endif
+}
+
+// record an execution against the method's budget; returns true if the
+// budget was exceeded
+bool recordRpcExecution(const std::string& method,
+                        const boost::posix_time::ptime& startTime,
+                        long startMemoryKb)
+{
+   using namespace boost::posix_time;
+   time_duration elapsed = microsec_clock::universal_time() - startTime;
+   performance::recordDuration("rpc_handler", elapsed);
+
+   long elapsedMillis = elapsed.total_milliseconds();
+   long memoryDeltaKb = 0;
+   if (startMemoryKb > 0)
+   {
+      long endMemoryKb = residentMemoryKb();
+      if (endMemoryKb > startMemoryKb)
+         memoryDeltaKb = endMemoryKb - startMemoryKb;
+   }
+
+   RpcBudget budget;
+   bool timeOverrun = false;
+   bool memoryOverrun = false;
+   LOCK_MUTEX(s_budgetMutex)
+   {
+      std::map<std::string, RpcBudget>::const_iterator it =
+                                             s_pRpcBudgets->find(method);
+      if (it != s_pRpcBudgets->end())
+         budget = it->second;
+
+      timeOverrun = elapsedMillis > budget.timeMillis;
+      memoryOverrun = memoryDeltaKb > static_cast<long>(budget.memoryMb) * 1024;
+
+      RpcBudgetStats& stats = (*s_pRpcBudgetStats)[method];
+      stats.invocations++;
+      if (timeOverrun)
+         stats.timeOverruns++;
+      if (memoryOverrun)
+         stats.memoryOverruns++;
+      if (elapsedMillis > stats.maxElapsedMillis)
+         stats.maxElapsedMillis = static_cast<int>(elapsedMillis);
+   }
+   END_LOCK_MUTEX
+
+   if (timeOverrun || memoryOverrun)
+   {
+      LOG_WARNING_MESSAGE("RPC method '" + method + "' exceeded its " +
+            std::string(timeOverrun ? "time" : "memory") + " budget (" +
+            safe_convert::numberToString(elapsedMillis) + "ms elapsed, " +
+            safe_convert::numberToString(memoryDeltaKb) + "kb allocated)");
+   }
+
+   return timeOverrun || memoryOverrun;
+}
+
+// counters surface: per-method invocation and overrun counts
+Error handleGetRpcBudgetStats(const json::JsonRpcRequest& request,
+                              json::JsonRpcResponse* pResponse)
+{
+   json::Array statsJson;
+   LOCK_MUTEX(s_budgetMutex)
+   {
+      for (std::map<std::string, RpcBudgetStats>::const_iterator
+               it = s_pRpcBudgetStats->begin();
+           it != s_pRpcBudgetStats->end();
+           ++it)
+      {
+         json::Object methodJson;
+         methodJson["method"] = it->first;
+         methodJson["invocations"] = it->second.invocations;
+         methodJson["time_overruns"] = it->second.timeOverruns;
+         methodJson["memory_overruns"] = it->second.memoryOverruns;
+         methodJson["max_elapsed_millis"] = it->second.maxElapsedMillis;
+         statsJson.push_back(std::move(methodJson));
+      }
+   }
+   END_LOCK_MUTEX
+
+   pResponse->setResult(std::move(statsJson));
+   return Success();
+}
+
 void endHandleRpcRequestDirect(boost::shared_ptr<HttpConnection> ptrConnection,
+                         const json::JsonRpcRequest& request,
                          boost::posix_time::ptime executeStartTime,
+                         long startMemoryKb,
                          const core::Error& executeError,
                          json::JsonRpcResponse* pJsonRpcResponse)
 {
@@ -51,6 +352,12 @@ void endHandleRpcRequestDirect(boost::shared_ptr<HttpConnection> ptrConnection,
    }
    else
    {
+      // record the execution against the method's budget (before change
+      // detection, which runs R code on behalf of other modules) and
+      // flag the response when it was exceeded
+      if (recordRpcExecution(request.method, executeStartTime, startMemoryKb))
+         pJsonRpcResponse->setField("budget_exceeded", true);
+
       // allow modules to detect changes after rpc calls
       if (!pJsonRpcResponse->suppressDetectChanges())
       {
@@ -66,8 +373,21 @@ void endHandleRpcRequestDirect(boost::shared_ptr<HttpConnection> ptrConnection,
          pJsonRpcResponse->setField(kEventsPending, "false");
       }
 
-      // send the response
-      ptrConnection->sendJsonRpcResponse(*pJsonRpcResponse);
+      // cacheable methods: store the response and send it with its ETag
+      // so the client can revalidate later requests
+      std::string eTag = storeCachedRpcResponse(request, *pJsonRpcResponse);
+      if (!eTag.empty())
+      {
+         http::Response httpResponse;
+         json::setJsonRpcResponse(*pJsonRpcResponse, &httpResponse);
+         httpResponse.setHeader("ETag", eTag);
+         ptrConnection->sendResponse(httpResponse);
+      }
+      else
+      {
+         // send the response
+         ptrConnection->sendJsonRpcResponse(*pJsonRpcResponse);
+      }
 
       // run after response if we have one (then detect changes again)
       if (pJsonRpcResponse->hasAfterResponse())
@@ -110,6 +430,110 @@ void saveJsonResponse(const core::Error& error, core::json::JsonRpcResponse *pSr
    *pDest = *pSrc;
 }
 
+void handleThreadsafeRpcRequest(boost::shared_ptr<HttpConnection> ptrConnection)
+{
+   // verify the request signature just as the foreground thread would
+   if (!http_methods::verifyRequestSignature(ptrConnection->request()))
+   {
+      core::http::Response response;
+      response.setError(http::status::Unauthorized,
+                        "Invalid message signature");
+      ptrConnection->sendResponse(response);
+      return;
+   }
+
+   // parse the request
+   json::JsonRpcRequest request;
+   Error error = json::parseJsonRpcRequest(ptrConnection->request().body(),
+                                           &request);
+   if (error)
+   {
+      ptrConnection->sendJsonRpcError(error);
+      return;
+   }
+
+   // validate the client id (against the event service's mutex-guarded
+   // copy so we don't touch persistent state from this thread)
+   if (request.clientId != clientEventService().clientId())
+   {
+      Error error(json::errc::InvalidClientId, ERROR_LOCATION);
+      ptrConnection->sendJsonRpcError(error);
+      return;
+   }
+
+   // look up the handler
+   bool found = false;
+   json::JsonRpcFunction handlerFunction;
+   LOCK_MUTEX(s_threadsafeRpcMutex)
+   {
+      json::JsonRpcMethods::const_iterator it =
+                        s_pThreadsafeRpcMethods->find(request.method);
+      if (it != s_pThreadsafeRpcMethods->end())
+      {
+         handlerFunction = it->second;
+         found = true;
+      }
+   }
+   END_LOCK_MUTEX
+
+   if (!found)
+   {
+      Error error = Error(json::errc::MethodNotFound, ERROR_LOCATION);
+      error.addProperty("method", request.method);
+      ptrConnection->sendJsonRpcError(error);
+      return;
+   }
+
+   // record the time just prior to execution of the method
+   // (so we can determine if any events were added during execution)
+   using namespace boost::posix_time;
+   ptime executeStartTime = microsec_clock::universal_time();
+   long startMemoryKb = residentMemoryKb();
+
+   // execute the handler
+   json::JsonRpcResponse response;
+   error = handlerFunction(request, &response);
+   if (error)
+   {
+      ptrConnection->sendJsonRpcError(error);
+      return;
+   }
+
+   // record the execution against the method's budget and flag the
+   // response when it was exceeded
+   if (recordRpcExecution(request.method, executeStartTime, startMemoryKb))
+      response.setField("budget_exceeded", true);
+
+   // thread-safe handlers can't run code on the main thread so
+   // deferred "after response" work isn't supported here
+   BOOST_ASSERT(!response.hasAfterResponse());
+
+   // are there (or will there likely be) events pending?
+   // (if not then notify the client)
+   if (!clientEventQueue().eventAddedSince(executeStartTime))
+      response.setField(kEventsPending, "false");
+
+   // send the response. note that we don't fire onDetectChanges here --
+   // change detection runs R code so thread-safe methods forgo it
+   ptrConnection->sendJsonRpcResponse(response);
+}
+
+void threadsafeRpcWorker()
+{
+   try
+   {
+      for (;;)
+      {
+         boost::shared_ptr<HttpConnection> ptrConnection =
+               s_pThreadsafeRpcQueue->dequeConnection(
+                                 boost::posix_time::milliseconds(500));
+         if (ptrConnection)
+            handleThreadsafeRpcRequest(ptrConnection);
+      }
+   }
+   CATCH_UNEXPECTED_EXCEPTION
+}
+
 // invoke an HTTP RPC directly from R.
 SEXP rs_invokeRpc(SEXP name, SEXP args)
 {
@@ -143,12 +567,12 @@ SEXP rs_invokeRpc(SEXP name, SEXP args)
    if (rpcArgs.type() == json::ObjectType)
    {
       // named pair parameters
-      request.kwparams = rpcArgs.get_obj();
+      request.kwparams = std::move(rpcArgs.get_obj());
    }
    else if (rpcArgs.type() == json::ArrayType)
    {
       // object parameters
-      request.params = rpcArgs.get_array();
+      request.params = std::move(rpcArgs.get_array());
    }
 
    // invoke handler and record response
@@ -197,38 +621,207 @@ namespace module_context {
 Error registerAsyncRpcMethod(const std::string& name,
                              const core::json::JsonRpcAsyncFunction& function)
 {
-   s_pJsonRpcMethods->insert(
-         std::make_pair(name, std::make_pair(false, function)));
+   LOCK_MUTEX(s_jsonRpcMethodsMutex)
+   {
+      removeLazyRpcStub(name);
+      s_pJsonRpcMethods->insert(
+            std::make_pair(name, std::make_pair(false, function)));
+   }
+   END_LOCK_MUTEX
    return Success();
 }
 
 Error registerRpcMethod(const std::string& name,
                         const core::json::JsonRpcFunction& function)
 {
-   s_pJsonRpcMethods->insert(
-         std::make_pair(name,
-                        std::make_pair(true, json::adaptToAsync(function))));
+   LOCK_MUTEX(s_jsonRpcMethodsMutex)
+   {
+      removeLazyRpcStub(name);
+      s_pJsonRpcMethods->insert(
+            std::make_pair(name,
+                           std::make_pair(true, json::adaptToAsync(function))));
+   }
+   END_LOCK_MUTEX
    return Success();
 }
 
 void registerRpcMethod(const core::json::JsonRpcAsyncMethod& method)
 {
-   s_pJsonRpcMethods->insert(method);
+   LOCK_MUTEX(s_jsonRpcMethodsMutex)
+   {
+      removeLazyRpcStub(method.first);
+      s_pJsonRpcMethods->insert(method);
+   }
+   END_LOCK_MUTEX
+}
+
+Error registerCacheableRpcMethod(const std::string& name,
+                                 const core::json::JsonRpcFunction& function,
+                                 const std::set<int>& invalidationEvents)
+{
+   LOCK_MUTEX(s_rpcCacheMutex)
+   {
+      (*s_pRpcInvalidationEvents)[name] = invalidationEvents;
+   }
+   END_LOCK_MUTEX
+
+   return registerRpcMethod(name, function);
+}
+
+Error registerThreadsafeRpcMethod(const std::string& name,
+                                  const core::json::JsonRpcFunction& function)
+{
+   // also register on the normal rpc path so the method still works
+   // when invoked from there (e.g. via rs_invokeRpc)
+   Error error = registerRpcMethod(name, function);
+   if (error)
+      return error;
+
+   LOCK_MUTEX(s_threadsafeRpcMutex)
+   {
+      (*s_pThreadsafeRpcMethods)[name] = function;
+   }
+   END_LOCK_MUTEX
+
+   // spin up the worker pool on first registration (registration always
+   // occurs on the main thread so no lock is required for the flag)
+   if (!s_threadsafeRpcWorkersRunning)
+   {
+      for (int i = 0; i < kNumThreadsafeRpcWorkers; i++)
+         core::thread::safeLaunchThread(threadsafeRpcWorker);
+      s_threadsafeRpcWorkersRunning = true;
+   }
+
+   return Success();
 }
 
 } // namespace module_context
 
 namespace rpc {
 
+void registerLazyRpcStub(const std::string& name,
+                         const core::json::JsonRpcAsyncFunction& stub)
+{
+   LOCK_MUTEX(s_jsonRpcMethodsMutex)
+   {
+      // register as a direct-return method -- lazy modules register
+      // their real methods via registerRpcMethod, which is also direct
+      (*s_pJsonRpcMethods)[name] = std::make_pair(true, stub);
+      s_lazyRpcStubs.insert(name);
+   }
+   END_LOCK_MUTEX
+}
+
+bool isLazyRpcStub(const std::string& name)
+{
+   LOCK_MUTEX(s_jsonRpcMethodsMutex)
+   {
+      return s_lazyRpcStubs.count(name) > 0;
+   }
+   END_LOCK_MUTEX
+
+   // keep compiler happy
+   return false;
+}
+
+bool invokeRpcMethod(const std::string& name,
+                     const core::json::JsonRpcRequest& request,
+                     const core::json::JsonRpcFunctionContinuation& continuation)
+{
+   json::JsonRpcAsyncMethods::const_iterator it =
+                                          s_pJsonRpcMethods->find(name);
+   if (it == s_pJsonRpcMethods->end())
+      return false;
+
+   it->second.second(request, continuation);
+   return true;
+}
+
+void setMethodBudget(const std::string& method, int timeMillis, int memoryMb)
+{
+   LOCK_MUTEX(s_budgetMutex)
+   {
+      RpcBudget& budget = (*s_pRpcBudgets)[method];
+      if (timeMillis > 0)
+         budget.timeMillis = timeMillis;
+      if (memoryMb > 0)
+         budget.memoryMb = memoryMb;
+   }
+   END_LOCK_MUTEX
+}
+
+bool checkForThreadsafeRpc(boost::shared_ptr<HttpConnection> ptrConnection)
+{
+   // the listener can start delivering connections before we've been
+   // initialized
+   if (s_pThreadsafeRpcMethods == NULL)
+      return false;
+
+   // only rpc requests are candidates
+   std::string uri = ptrConnection->request().uri();
+   if (!boost::algorithm::starts_with(uri, "/rpc/"))
+      return false;
+
+   // look up the method by the final uri component
+   std::string method = uri.substr(uri.rfind('/') + 1);
+   LOCK_MUTEX(s_threadsafeRpcMutex)
+   {
+      if (s_pThreadsafeRpcMethods->find(method) ==
+          s_pThreadsafeRpcMethods->end())
+      {
+         return false;
+      }
+   }
+   END_LOCK_MUTEX
+
+   // hand the connection to the worker pool
+   s_pThreadsafeRpcQueue->enqueConnection(ptrConnection);
+   return true;
+}
+
 void handleRpcRequest(const core::json::JsonRpcRequest& request,
                       boost::shared_ptr<HttpConnection> ptrConnection,
                       http_methods::ConnectionType connectionType)
 {
    // record the time just prior to execution of the event
    // (so we can determine if any events were added during execution)
-   using namespace boost::posix_time; 
+   using namespace boost::posix_time;
    ptime executeStartTime = microsec_clock::universal_time();
-   
+   long startMemoryKb = residentMemoryKb();
+
+   // feed prefetch predictors (see registerRpcPrefetcher)
+   module_context::notifyRpcMethodInvoked(request);
+
+   // cacheable methods: serve repeat requests from the response cache
+   // without re-invoking the handler
+   json::Value cachedResult;
+   std::string cachedETag;
+   if (lookupCachedRpcResponse(request, &cachedResult, &cachedETag))
+   {
+      // if the client already holds this exact response (it presented a
+      // matching ETag) then skip the transfer entirely
+      if (ptrConnection->request().headerValue("If-None-Match") == cachedETag)
+      {
+         http::Response httpResponse;
+         httpResponse.setStatusCode(http::status::NotModified);
+         httpResponse.setHeader("ETag", cachedETag);
+         ptrConnection->sendResponse(httpResponse);
+         return;
+      }
+
+      // replay the cached result (no handler ran so change detection
+      // is skipped)
+      json::JsonRpcResponse response;
+      response.setResult(cachedResult);
+      if (!clientEventQueue().eventAddedSince(executeStartTime))
+         response.setField(kEventsPending, "false");
+      http::Response httpResponse;
+      json::setJsonRpcResponse(response, &httpResponse);
+      httpResponse.setHeader("ETag", cachedETag);
+      ptrConnection->sendResponse(httpResponse);
+      return;
+   }
+
    // execute the method
    auto it = s_pJsonRpcMethods->find(request.method);
    if (it != s_pJsonRpcMethods->end())
@@ -242,7 +835,9 @@ void handleRpcRequest(const core::json::JsonRpcRequest& request,
          handlerFunction(request,
                          boost::bind(endHandleRpcRequestDirect,
                                      ptrConnection,
+                                     request,
                                      executeStartTime,
+                                     startMemoryKb,
                                      _1,
                                      _2));
       }
@@ -271,7 +866,9 @@ void handleRpcRequest(const core::json::JsonRpcRequest& request,
       // application states
       LOG_ERROR(executeError);
 
-      endHandleRpcRequestDirect(ptrConnection, executeStartTime, executeError, NULL);
+      endHandleRpcRequestDirect(ptrConnection, request,
+                                executeStartTime, startMemoryKb,
+                                executeError, NULL);
    }
 }
 
@@ -284,6 +881,22 @@ Error initialize()
    // the OS to clean up memory itself after the process is gone)
    s_pJsonRpcMethods = new core::json::JsonRpcAsyncMethods;
 
+   // same rationale for the thread-safe method map and its queue
+   s_pThreadsafeRpcQueue = new HttpConnectionQueue();
+   s_pThreadsafeRpcMethods = new core::json::JsonRpcMethods;
+
+   // budget configuration and counters (same rationale again)
+   s_pRpcBudgets = new std::map<std::string, RpcBudget>;
+   s_pRpcBudgetStats = new std::map<std::string, RpcBudgetStats>;
+
+   // response cache for cacheable methods (same rationale again)
+   s_pRpcInvalidationEvents = new std::map<std::string, std::set<int> >;
+   s_pRpcResponseCache = new std::map<std::string, RpcCacheEntry>;
+
+   // counters surface for the budget overruns recorded above
+   (*s_pJsonRpcMethods)["get_rpc_budget_stats"] =
+         std::make_pair(true, json::adaptToAsync(handleGetRpcBudgetStats));
+
    r::routines::registerCallMethod(
             "rs_invokeRpc",
             (DL_FUNC) rs_invokeRpc,
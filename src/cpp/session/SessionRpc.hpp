@@ -31,6 +31,32 @@ void handleRpcRequest(const core::json::JsonRpcRequest& request,
                       boost::shared_ptr<HttpConnection> ptrConnection,
                       http_methods::ConnectionType connectionType);
 
+// check whether the connection carries a request for an rpc method
+// registered as thread-safe; if so it is handed to the rpc worker pool
+// (which takes ownership of the connection) and true is returned
+bool checkForThreadsafeRpc(boost::shared_ptr<HttpConnection> ptrConnection);
+
+// override the default execution budget for a method (pass 0 to leave
+// either limit at its default). overruns are logged, counted, and
+// reported via the get_rpc_budget_stats method
+void setMethodBudget(const std::string& method, int timeMillis, int memoryMb);
+
+// support for lazily activated modules (module_context::registerLazyModule).
+// a lazy stub occupies a method's slot until the module's real
+// initialization replaces it; unlike normal registration (where the
+// first registration of a name wins) registering over a lazy stub
+// replaces it
+void registerLazyRpcStub(const std::string& name,
+                         const core::json::JsonRpcAsyncFunction& stub);
+bool isLazyRpcStub(const std::string& name);
+
+// invoke a registered method directly (used by lazy stubs to
+// re-dispatch the triggering request after activation); returns false
+// if the method is not registered
+bool invokeRpcMethod(const std::string& name,
+                     const core::json::JsonRpcRequest& request,
+                     const core::json::JsonRpcFunctionContinuation& continuation);
+
 core::Error initialize();
 
 } // namespace rpc
@@ -15,6 +15,7 @@
 
 #include <session/SessionSourceDatabase.hpp>
 
+#include <cstring>
 #include <string>
 #include <vector>
 #include <algorithm>
@@ -24,6 +25,7 @@
 #include <boost/regex.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
+#include <core/AllocationTracker.hpp>
 #include <core/Log.hpp>
 #include <core/Exec.hpp>
 #include <core/Error.hpp>
@@ -33,8 +35,13 @@
 #include <core/FileUtils.hpp>
 #include <core/RegexUtils.hpp>
 #include <core/DateTime.hpp>
+#include <core/StringUtils.hpp>
+#include <core/Thread.hpp>
+
+#include <core/json/JsonRpc.hpp>
 
 #include <core/system/System.hpp>
+#include <core/system/MemoryMappedFile.hpp>
 
 #include <core/http/Util.hpp>
 
@@ -49,6 +56,7 @@
 #include "SessionSourceDatabaseSupervisor.hpp"
 
 #define kContentsSuffix "-contents"
+#define kContentsJournalSuffix "-contents-journal"
 
 // NOTE: if a file is deleted then its properties database entry is not
 // deleted. this has two implications:
@@ -244,6 +252,309 @@ Error attemptContentsMigration(json::Object& propertiesJson,
    return writeStringToFile(contentsPath, contents);
 }
 
+// minimum journal size before compaction kicks in (below this a full
+// snapshot rewrite is cheap anyway)
+const boost::uintmax_t kJournalMinCompactionBytes = 64 * 1024;
+
+Error appendToContentsJournal(const FilePath& journalPath,
+                              const std::string& records)
+{
+   boost::shared_ptr<std::ostream> pOfs;
+   Error error = journalPath.open_w(&pOfs, false);
+   if (error)
+      return error;
+
+   try
+   {
+      pOfs->write(records.data(), records.size());
+      if (pOfs->fail())
+         return systemError(boost::system::errc::io_error, ERROR_LOCATION);
+      return Success();
+   }
+   catch(const std::exception& e)
+   {
+      Error error = systemError(boost::system::errc::io_error,
+                                ERROR_LOCATION);
+      error.addProperty("what", e.what());
+      error.addProperty("path", journalPath.absolutePath());
+      return error;
+   }
+}
+
+void logContentsJournalWarning(const FilePath& journalPath,
+                               const std::string& reason)
+{
+   LOG_WARNING_MESSAGE("Ignoring remainder of source document journal (" +
+                       journalPath.absolutePath() + "): " + reason);
+}
+
+// replay journaled content deltas on top of a contents snapshot. the
+// journal is mapped rather than read since record payloads are applied
+// directly from the mapping. malformed or truncated records (e.g. from
+// an interrupted append) end the replay at the last good record -- that
+// just means a slightly staler autosave. *pReplayedFully is set to false
+// when any journal bytes were skipped (so callers know the file can't be
+// appended to safely)
+Error applyContentsJournal(const FilePath& journalPath,
+                           std::string* pContents,
+                           bool* pReplayedFully)
+{
+   *pReplayedFully = true;
+
+   core::system::MemoryMappedFile mappedFile;
+   Error error = mappedFile.open(journalPath);
+   if (error)
+      return error;
+
+   const char* pCursor = static_cast<const char*>(mappedFile.data());
+   const char* pEnd = pCursor + mappedFile.size();
+   while (pCursor != NULL && pCursor < pEnd)
+   {
+      // locate the header line
+      const char* pEol = static_cast<const char*>(
+                              std::memchr(pCursor, '\n', pEnd - pCursor));
+      if (pEol == NULL)
+         break; // partial record
+
+      // parse it
+      json::Value headerValue;
+      if (!json::parse(std::string(pCursor, pEol), &headerValue) ||
+          !json::isType<json::Object>(headerValue))
+      {
+         logContentsJournalWarning(journalPath, "malformed record header");
+         break;
+      }
+
+      int offset = 0, remove = 0, insert = 0;
+      std::string hash;
+      error = json::readObject(headerValue.get_obj(),
+                               "offset", &offset,
+                               "remove", &remove,
+                               "insert", &insert,
+                               "hash", &hash);
+      if (error || offset < 0 || remove < 0 || insert < 0)
+      {
+         logContentsJournalWarning(journalPath, "invalid record header");
+         break;
+      }
+
+      // validate the record against the journal and the contents
+      const char* pData = pEol + 1;
+      if ((pEnd - pData) < insert)
+         break; // truncated record
+      if (static_cast<std::size_t>(offset) + remove > pContents->size())
+      {
+         logContentsJournalWarning(journalPath, "record out of range");
+         break;
+      }
+
+      // apply the splice, then verify the hash recorded for the
+      // resulting contents (it won't match if the journal doesn't
+      // belong to this snapshot)
+      std::string previousContents = *pContents;
+      pContents->replace(offset, remove, pData, insert);
+      if (hash::fastHash(*pContents) != hash)
+      {
+         *pContents = previousContents;
+         logContentsJournalWarning(journalPath, "contents hash mismatch");
+         break;
+      }
+
+      // move past the record (and its trailing newline)
+      pCursor = pData + insert;
+      if (pCursor < pEnd && *pCursor == '\n')
+         pCursor++;
+   }
+
+   *pReplayedFully = (pCursor == pEnd);
+   return Success();
+}
+
+// write-behind persistence: the autosave RPC only performs the cheap
+// journal append synchronously (so edits are always recoverable after
+// abnormal termination); the properties rewrite and any journal
+// compaction are debounced onto a background thread so NFS latency for
+// full-file writes never gates the typing path
+
+// how long a document must be quiet before its pending write goes out
+const long kWriteBehindDelayMs = 500;
+
+struct PendingWrite
+{
+   PendingWrite() : compactContents(false) {}
+   std::string properties;
+   bool compactContents;
+   boost::posix_time::ptime lastUpdate;
+};
+
+// pending writes by document id, guarded by s_writeBehindMutex
+std::map<std::string, PendingWrite> s_pendingWrites;
+boost::mutex s_writeBehindMutex;
+boost::condition s_writeBehindCondition;
+bool s_writeBehindThreadRunning = false;
+
+// serializes disk access between the foreground journal appends and the
+// background compaction/properties writes (a compaction must not race
+// with an append -- it reads the journal, rewrites the snapshot, and
+// removes the journal as one unit)
+boost::mutex s_diskWriteMutex;
+
+// perform the disk writes for a single document. runs on the write-behind
+// thread (and on the main thread when draining at quit/suspend)
+void performPendingWrite(const std::string& id, const PendingWrite& write)
+{
+   LOCK_MUTEX(s_diskWriteMutex)
+   {
+      FilePath filePath = source_database::path().complete(id);
+
+      // the document may have been removed while the write was pending
+      if (!filePath.exists())
+         return;
+
+      if (write.compactContents)
+      {
+         // compact the journal into the snapshot: write a fresh snapshot
+         // with the journal replayed, then drop the journal. written in
+         // that order because a crash in between leaves a journal that
+         // doesn't belong to the new snapshot, which the replay detects
+         // and ignores
+         FilePath contentsPath(filePath.absolutePath() + kContentsSuffix);
+         FilePath journalPath(filePath.absolutePath() +
+                              kContentsJournalSuffix);
+         if (contentsPath.exists() && journalPath.exists())
+         {
+            std::string contents;
+            Error error = readStringFromFile(contentsPath,
+                                             &contents,
+                                             options().sourceLineEnding());
+            bool replayedFully = false;
+            if (!error)
+               error = applyContentsJournal(journalPath,
+                                            &contents,
+                                            &replayedFully);
+            if (!error && replayedFully)
+            {
+               error = writeStringToFile(contentsPath, contents);
+               if (!error)
+                  error = journalPath.removeIfExists();
+            }
+            if (error)
+               LOG_ERROR(error);
+         }
+      }
+
+      // write the properties
+      Error error = writeStringToFile(filePath, write.properties);
+      if (error)
+         LOG_ERROR(error);
+   }
+   END_LOCK_MUTEX
+}
+
+void writeBehindThread()
+{
+   try
+   {
+      while (true)
+      {
+         std::string id;
+         PendingWrite write;
+
+         {
+            boost::unique_lock<boost::mutex> lock(s_writeBehindMutex);
+
+            if (s_pendingWrites.empty())
+            {
+               s_writeBehindCondition.wait(lock);
+               continue;
+            }
+
+            // find the write which has been pending the longest
+            std::map<std::string, PendingWrite>::iterator oldest =
+                                                      s_pendingWrites.begin();
+            for (std::map<std::string, PendingWrite>::iterator
+                    it = s_pendingWrites.begin();
+                    it != s_pendingWrites.end();
+                    ++it)
+            {
+               if (it->second.lastUpdate < oldest->second.lastUpdate)
+                  oldest = it;
+            }
+
+            // debounce: let the document settle before writing it out
+            boost::posix_time::ptime eligibleAt =
+                  oldest->second.lastUpdate +
+                  boost::posix_time::milliseconds(kWriteBehindDelayMs);
+            if (boost::get_system_time() < eligibleAt)
+            {
+               s_writeBehindCondition.timed_wait(lock, eligibleAt);
+               continue;
+            }
+
+            id = oldest->first;
+            write = oldest->second;
+            s_pendingWrites.erase(oldest);
+         }
+
+         performPendingWrite(id, write);
+      }
+   }
+   CATCH_UNEXPECTED_EXCEPTION
+}
+
+// schedule (or re-schedule) a write-behind of a document's properties,
+// optionally with a journal compaction
+void scheduleWriteBehind(const std::string& id,
+                         const std::string& properties,
+                         bool compactContents)
+{
+   LOCK_MUTEX(s_writeBehindMutex)
+   {
+      // lazily launch the writer thread on first use
+      if (!s_writeBehindThreadRunning)
+      {
+         core::thread::safeLaunchThread(writeBehindThread);
+         s_writeBehindThreadRunning = true;
+      }
+
+      PendingWrite& write = s_pendingWrites[id];
+      write.properties = properties;
+      write.compactContents = write.compactContents || compactContents;
+      write.lastUpdate = boost::get_system_time();
+   }
+   END_LOCK_MUTEX
+
+   s_writeBehindCondition.notify_all();
+}
+
+// discard any write-behind scheduled for a document (called when the
+// document is removed so a deferred write can't resurrect it)
+void discardWriteBehind(const std::string& id)
+{
+   LOCK_MUTEX(s_writeBehindMutex)
+   {
+      s_pendingWrites.erase(id);
+   }
+   END_LOCK_MUTEX
+}
+
+// synchronously write out everything still pending (session quit/suspend)
+void flushWriteBehind()
+{
+   std::map<std::string, PendingWrite> pending;
+   LOCK_MUTEX(s_writeBehindMutex)
+   {
+      pending.swap(s_pendingWrites);
+   }
+   END_LOCK_MUTEX
+
+   for (std::map<std::string, PendingWrite>::const_iterator
+           it = pending.begin(); it != pending.end(); ++it)
+   {
+      performPendingWrite(it->first, it->second);
+   }
+}
+
 bool isIntendedAsReadOnly(const std::string& contents,
                           std::vector<std::string>* pAlternatives)
 {
@@ -294,6 +605,7 @@ bool isIntendedAsReadOnly(const std::string& contents,
 }  // anonymous namespace
 
 SourceDocument::SourceDocument(const std::string& type)
+   : canJournalContents_(false)
 {
    FilePath srcDBPath = source_database::path();
    FilePath docPath = file_utils::uniqueFilePath(srcDBPath);
@@ -333,9 +645,95 @@ bool SourceDocument::isUntitled() const
 // set contents from string
 void SourceDocument::setContents(const std::string& contents)
 {
+   // find the minimal splice against the old contents (only worth the
+   // scan when a delta can actually be journaled)
+   bool journal = canJournalContents_ && contents_ != contents;
+   std::size_t prefix = 0, remove = 0;
+   std::string insert;
+   if (journal)
+   {
+      // trim the common prefix and suffix to find the minimal replacement
+      std::size_t maxPrefix = std::min(contents_.size(), contents.size());
+      while (prefix < maxPrefix && contents_[prefix] == contents[prefix])
+         prefix++;
+
+      std::size_t suffix = 0;
+      std::size_t maxSuffix = maxPrefix - prefix;
+      while (suffix < maxSuffix &&
+             contents_[contents_.size() - suffix - 1] ==
+                contents[contents.size() - suffix - 1])
+         suffix++;
+
+      remove = contents_.size() - prefix - suffix;
+      insert = contents.substr(prefix, contents.size() - prefix - suffix);
+   }
+
    contents_ = contents;
-   hash_ = hash::crc32Hash(contents_);
+   hash_ = hash::fastHash(contents_);
    lastContentUpdate_ = static_cast<std::time_t>(date_time::millisecondsSinceEpoch());
+
+   if (journal)
+      recordContentsEdit(prefix, remove, insert);
+}
+
+// splice a range edit into the contents in place
+bool SourceDocument::applyContentsEdit(std::size_t offset,
+                                       std::size_t length,
+                                       const std::string& replacement)
+{
+   // clamp to the current contents
+   if (offset > contents_.size())
+      offset = contents_.size();
+   length = std::min(length, contents_.size() - offset);
+
+   // a no-op edit shouldn't touch the hash or the journal
+   if (length == replacement.size() &&
+       contents_.compare(offset, length, replacement) == 0)
+   {
+      return false;
+   }
+
+   // splice in place -- the text outside the edited range is moved at
+   // most once and never copied wholesale
+   contents_.replace(offset, length, replacement);
+   hash_ = hash::fastHash(contents_);
+   lastContentUpdate_ = static_cast<std::time_t>(date_time::millisecondsSinceEpoch());
+
+   recordContentsEdit(offset, length, replacement);
+   return true;
+}
+
+void SourceDocument::markContentsPersisted(const FilePath& propertiesFilePath)
+{
+   pendingContentsJournal_.clear();
+   persistedContentsPath_ = propertiesFilePath.absolutePath();
+   canJournalContents_ = true;
+}
+
+// record a splice (applied to contents_ and hash_ already) in the
+// contents journal
+void SourceDocument::recordContentsEdit(std::size_t offset,
+                                        std::size_t remove,
+                                        const std::string& insert)
+{
+   // deltas are only useful when we know the pre-edit contents matched
+   // what was last persisted
+   if (!canJournalContents_)
+      return;
+
+   // the header line describes the splice; the hash of the resulting
+   // contents lets the load path detect a journal that doesn't belong
+   // to the snapshot it follows
+   json::Object header;
+   header["offset"] = static_cast<boost::int64_t>(offset);
+   header["remove"] = static_cast<boost::int64_t>(remove);
+   header["insert"] = static_cast<boost::int64_t>(insert.size());
+   header["hash"] = hash_;
+
+   std::ostringstream ostr;
+   json::write(header, ostr);
+   ostr << "\n" << insert << "\n";
+   pendingContentsJournal_ += ostr.str();
 }
 
 // set contents from file
@@ -379,7 +777,7 @@ Error SourceDocument::contentsMatchDisk(bool *pMatches)
          return error;
 
       *pMatches = contents_.length() == contents.length() && 
-                  hash_ == hash::crc32Hash(contents);
+                  hash_ == hash::fastHash(contents);
    }
 
    return Success();
@@ -519,6 +917,13 @@ Error SourceDocument::readFromJson(json::Object* pDocJson)
       sourceWindow_ = !sourceWindow.is_null() ? sourceWindow.get_str() :
                                                 std::string();
 
+      // loading from json establishes a new contents baseline of unknown
+      // relationship to persistent storage (callers that load from the
+      // source database itself call markContentsPersisted)
+      pendingContentsJournal_.clear();
+      persistedContentsPath_.clear();
+      canJournalContents_ = false;
+
       return Success();
    }
    catch(const std::exception& e)
@@ -564,7 +969,7 @@ SEXP SourceDocument::toRObject(r::sexp::Protect* pProtect, bool includeContents)
    return r::sexp::create(object, pProtect);
 }
 
-Error SourceDocument::writeToFile(const FilePath& filePath, bool writeContents) const
+Error SourceDocument::writeToFile(const FilePath& filePath, bool writeContents)
 {
    // NOTE: in a previous implementation, the document properties and
    // document contents were encoded together in the same file -- we
@@ -572,25 +977,92 @@ Error SourceDocument::writeToFile(const FilePath& filePath, bool writeContents)
    // compatibility), and write the contents to '<id>-contents'. this
    // allows newer versions of RStudio to remain backwards-compatible
    // with older formats for the source database
-   
+
    // write contents to file
    if (writeContents)
    {
-      FilePath contentsPath(filePath.absolutePath() + kContentsSuffix);
-      Error error = writeStringToFile(contentsPath, contents_);
+      Error error = writeContentsToFile(filePath);
       if (error)
          return error;
    }
-   
+
+   // write properties to file
+   return writeStringToFile(filePath, propertiesAsString());
+}
+
+Error SourceDocument::writeContentsToFile(const FilePath& filePath,
+                                          bool* pCompactionPending)
+{
+   if (pCompactionPending != NULL)
+      *pCompactionPending = false;
+
+   FilePath contentsPath(filePath.absolutePath() + kContentsSuffix);
+   FilePath journalPath(filePath.absolutePath() + kContentsJournalSuffix);
+
+   // determine the journal size we'd end up with if we appended
+   boost::uintmax_t journalBytes = pendingContentsJournal_.size();
+   if (journalPath.exists())
+      journalBytes += journalPath.size();
+
+   // deltas can only be appended when the snapshot at this location
+   // is the one our recorded deltas are relative to (the supervisor
+   // also writes documents into other session directories)
+   bool canAppend = canJournalContents_ &&
+                    persistedContentsPath_ == filePath.absolutePath() &&
+                    contentsPath.exists();
+
+   // past this size replaying the journal costs more than rewriting
+   // the snapshot
+   bool wantCompaction = journalBytes > std::max<boost::uintmax_t>(
+                                                kJournalMinCompactionBytes,
+                                                contents_.size() / 2);
+
+   if (canAppend && pendingContentsJournal_.empty())
+   {
+      // contents haven't changed since they were last persisted
+   }
+   else if (canAppend && (!wantCompaction || pCompactionPending != NULL))
+   {
+      // append the deltas recorded since the last write -- the cost
+      // is proportional to the edits made, not the document size
+      Error error = appendToContentsJournal(journalPath,
+                                            pendingContentsJournal_);
+      if (error)
+         return error;
+
+      // when the caller can compact asynchronously we always append
+      // (it's still the cheapest durable write) and just report that
+      // the snapshot should be rewritten off the critical path
+      if (wantCompaction && pCompactionPending != NULL)
+         *pCompactionPending = true;
+   }
+   else
+   {
+      // compact: drop the journal, then write a fresh snapshot (in
+      // that order so an interruption in between can't leave a
+      // journal that doesn't belong to its snapshot)
+      Error error = journalPath.removeIfExists();
+      if (error)
+         return error;
+
+      error = writeStringToFile(contentsPath, contents_);
+      if (error)
+         return error;
+   }
+
+   markContentsPersisted(filePath);
+   return Success();
+}
+
+std::string SourceDocument::propertiesAsString() const
+{
    // get document properties as json
    json::Object jsonProperties;
    writeToJson(&jsonProperties, false);
-   
-   // write properties to file
+
    std::ostringstream oss;
    json::writeFormatted(jsonProperties, oss);
-   Error error = writeStringToFile(filePath, oss.str());
-   return error;
+   return oss.str();
 }
 
 void SourceDocument::editProperty(const json::Object::value_type& property)
@@ -639,10 +1111,15 @@ Error get(const std::string& id, boost::shared_ptr<SourceDocument> pDoc)
    
 Error get(const std::string& id, bool includeContents, boost::shared_ptr<SourceDocument> pDoc)
 {
+   // attribute loaded documents to the source database module when the
+   // allocation tracker is on
+   core::allocation::Scope allocationScope("source_database");
+
    FilePath propertiesPath = source_database::path().complete(id);
    
    // attempt to read file contents from sidecar file if available
    std::string contents;
+   bool contentsSynced = false;
    if (includeContents)
    {
       FilePath contentsPath(propertiesPath.absolutePath() + kContentsSuffix);
@@ -653,9 +1130,30 @@ Error get(const std::string& id, bool includeContents, boost::shared_ptr<SourceD
                                           options().sourceLineEnding());
          if (error)
             LOG_ERROR(error);
+         else
+            contentsSynced = true;
+      }
+
+      // replay any journaled deltas recorded on top of the snapshot
+      FilePath journalPath(propertiesPath.absolutePath() +
+                           kContentsJournalSuffix);
+      if (contentsSynced && journalPath.exists())
+      {
+         bool replayedFully = false;
+         Error error = applyContentsJournal(journalPath,
+                                            &contents,
+                                            &replayedFully);
+         if (error)
+            LOG_ERROR(error);
+
+         // if any journal bytes couldn't be applied then the in-memory
+         // contents no longer correspond to the files on disk, so don't
+         // allow further appends (the next write will compact instead)
+         if (error || !replayedFully)
+            contentsSynced = false;
       }
    }
-   
+
    if (propertiesPath.exists())
    {
       // read the contents of the file
@@ -688,8 +1186,17 @@ Error get(const std::string& id, bool includeContents, boost::shared_ptr<SourceD
       
       if (!jsonDoc.count("contents"))
          jsonDoc["contents"] = std::string();
-      
-      return pDoc->readFromJson(&jsonDoc);
+
+      error = pDoc->readFromJson(&jsonDoc);
+      if (error)
+         return error;
+
+      // the document now holds exactly what's persisted, so subsequent
+      // edits can be journaled as deltas
+      if (includeContents && contentsSynced)
+         pDoc->markContentsPersisted(propertiesPath);
+
+      return Success();
    }
    else
    {
@@ -713,7 +1220,8 @@ bool isSourceDocument(const FilePath& filePath)
        filename == "lock_file" ||
        filename == "suspend_file" ||
        filename == "restart_file" ||
-       boost::algorithm::ends_with(filename, kContentsSuffix))
+       boost::algorithm::ends_with(filename, kContentsSuffix) ||
+       boost::algorithm::ends_with(filename, kContentsJournalSuffix))
    {
       return false;
    }
@@ -790,19 +1298,27 @@ bool isSafeSourceDocument(const FilePath& docDbPath,
 
 
 Error list(std::vector<boost::shared_ptr<SourceDocument> >* pDocs)
+{
+   return list(pDocs, true);
+}
+
+Error list(std::vector<boost::shared_ptr<SourceDocument> >* pDocs,
+           bool includeContents)
 {
    std::vector<FilePath> files ;
    Error error = source_database::path().children(&files);
    if (error)
       return error ;
-   
+
    BOOST_FOREACH( FilePath& filePath, files )
    {
       if (isSourceDocument(filePath))
       {
          // get the source doc
          boost::shared_ptr<SourceDocument> pDoc(new SourceDocument()) ;
-         Error error = source_database::get(filePath.filename(), pDoc);
+         Error error = source_database::get(filePath.filename(),
+                                            includeContents,
+                                            pDoc);
          if (!error)
          {
             // safety filter
@@ -836,17 +1352,45 @@ Error list(std::vector<FilePath>* pPaths)
 }
    
 Error put(boost::shared_ptr<SourceDocument> pDoc, bool writeContents)
-{   
-   // write to file
+{
    FilePath filePath = source_database::path().complete(pDoc->id());
-   Error error = pDoc->writeToFile(filePath, writeContents);
-   if (error)
-      return error ;
+   if (!filePath.exists())
+   {
+      // brand new documents are written through so they are immediately
+      // visible to readers (this isn't the typing path)
+      Error error = pDoc->writeToFile(filePath, writeContents);
+      if (error)
+         return error ;
+   }
+   else
+   {
+      // write the contents now -- with the journal in play this is
+      // normally a small sequential append, and doing it synchronously
+      // keeps edits recoverable from the moment the RPC returns
+      bool compactionPending = false;
+      if (writeContents)
+      {
+         LOCK_MUTEX(s_diskWriteMutex)
+         {
+            Error error = pDoc->writeContentsToFile(filePath,
+                                                    &compactionPending);
+            if (error)
+               return error;
+         }
+         END_LOCK_MUTEX
+      }
+
+      // debounce the properties rewrite (and any journal compaction)
+      // onto the write-behind thread so the RPC isn't gated on them
+      scheduleWriteBehind(pDoc->id(),
+                          pDoc->propertiesAsString(),
+                          compactionPending);
+   }
 
    // write properties to durable storage (if there is a path)
    if (!pDoc->path().empty())
    {
-      error = putProperties(pDoc->path(), pDoc->properties());
+      Error error = putProperties(pDoc->path(), pDoc->properties());
       if (error)
          LOG_ERROR(error);
    }
@@ -856,11 +1400,31 @@ Error put(boost::shared_ptr<SourceDocument> pDoc, bool writeContents)
    
 Error remove(const std::string& id)
 {
-   return source_database::path().complete(id).removeIfExists();
+   // drop any deferred write so it can't resurrect the document
+   discardWriteBehind(id);
+
+   FilePath propertiesPath = source_database::path().complete(id);
+
+   // remove any contents journal (a stale journal must never outlive
+   // its document)
+   FilePath journalPath(propertiesPath.absolutePath() +
+                        kContentsJournalSuffix);
+   Error error = journalPath.removeIfExists();
+   if (error)
+      LOG_ERROR(error);
+
+   return propertiesPath.removeIfExists();
 }
    
 Error removeAll()
 {
+   // drop all deferred writes
+   LOCK_MUTEX(s_writeBehindMutex)
+   {
+      s_pendingWrites.clear();
+   }
+   END_LOCK_MUTEX
+
    std::vector<FilePath> files ;
    Error error = source_database::path().children(&files);
    if (error)
@@ -958,6 +1522,10 @@ namespace {
 
 void onQuit()
 {
+   // complete any deferred writes before the supervisor snapshots and
+   // detaches from the source database
+   flushWriteBehind();
+
    Error error = supervisor::saveMostRecentDocuments();
    if (error)
       LOG_ERROR(error);
@@ -969,6 +1537,9 @@ void onQuit()
 
 void onSuspend(const r::session::RSuspendOptions& options, core::Settings*)
 {
+   // complete any deferred writes before the database is suspended
+   flushWriteBehind();
+
    supervisor::suspendSourceDatabase(options.status);
 }
 
@@ -0,0 +1,215 @@
+/*
+ * SessionStartupProfiler.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionStartupProfiler.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <core/Error.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/Log.hpp>
+#include <core/SafeConvert.hpp>
+#include <core/Thread.hpp>
+#include <core/json/JsonRpc.hpp>
+
+#include <session/SessionModuleContext.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace session {
+namespace startup_profiler {
+
+namespace {
+
+const char * const kProfileFile = "startup-profile.json";
+
+struct PhaseRecord
+{
+   PhaseRecord() : microseconds(0), subPhase(false) {}
+
+   std::string name;
+   boost::int64_t microseconds;
+   bool subPhase;
+};
+
+// phases are recorded from the main thread during startup; the mutex
+// guards against the rpc reading the list while a late phase lands
+boost::mutex s_phasesMutex;
+std::vector<PhaseRecord> s_phases;
+boost::posix_time::ptime s_startupTime;
+boost::posix_time::ptime s_phaseTime;
+std::string s_currentPhase;
+boost::int64_t s_totalMicroseconds = 0;
+bool s_complete = false;
+
+boost::int64_t elapsedMicroseconds(const boost::posix_time::ptime& since)
+{
+   using namespace boost::posix_time;
+   return (microsec_clock::universal_time() - since).total_microseconds();
+}
+
+// close the currently open top-level phase (callers hold s_phasesMutex)
+void closeCurrentPhase()
+{
+   if (s_currentPhase.empty())
+      return;
+
+   PhaseRecord record;
+   record.name = s_currentPhase;
+   record.microseconds = elapsedMicroseconds(s_phaseTime);
+   s_phases.push_back(record);
+   s_currentPhase.clear();
+}
+
+std::string formatMillis(boost::int64_t microseconds)
+{
+   return safe_convert::numberToString(microseconds / 1000) + "ms";
+}
+
+json::Object profileAsJson()
+{
+   json::Object profileJson;
+
+   LOCK_MUTEX(s_phasesMutex)
+   {
+      profileJson["complete"] = s_complete;
+      profileJson["total_ms"] = static_cast<double>(
+                                       s_totalMicroseconds / 1000.0);
+
+      json::Array phasesJson;
+      for (std::size_t i = 0; i < s_phases.size(); i++)
+      {
+         json::Object phaseJson;
+         phaseJson["name"] = s_phases[i].name;
+         phaseJson["duration_ms"] = static_cast<double>(
+                                       s_phases[i].microseconds / 1000.0);
+         phaseJson["sub_phase"] = s_phases[i].subPhase;
+         phasesJson.push_back(phaseJson);
+      }
+      profileJson["phases"] = phasesJson;
+   }
+   END_LOCK_MUTEX
+
+   return profileJson;
+}
+
+bool phaseDurationGreater(const PhaseRecord& lhs, const PhaseRecord& rhs)
+{
+   return lhs.microseconds > rhs.microseconds;
+}
+
+Error getStartupProfile(const json::JsonRpcRequest& /*request*/,
+                        json::JsonRpcResponse* pResponse)
+{
+   pResponse->setResult(profileAsJson());
+   return Success();
+}
+
+} // anonymous namespace
+
+void advancePhase(const std::string& name)
+{
+   using namespace boost::posix_time;
+
+   LOCK_MUTEX(s_phasesMutex)
+   {
+      ptime now = microsec_clock::universal_time();
+      if (s_startupTime.is_not_a_date_time())
+         s_startupTime = now;
+
+      closeCurrentPhase();
+      s_currentPhase = name;
+      s_phaseTime = now;
+   }
+   END_LOCK_MUTEX
+}
+
+void recordInitStep(const std::string& name, boost::int64_t microseconds)
+{
+   PhaseRecord record;
+   record.name = name;
+   record.microseconds = microseconds;
+   record.subPhase = true;
+
+   LOCK_MUTEX(s_phasesMutex)
+   {
+      s_phases.push_back(record);
+   }
+   END_LOCK_MUTEX
+}
+
+void completeStartup()
+{
+   LOCK_MUTEX(s_phasesMutex)
+   {
+      if (s_complete)
+         return;
+
+      closeCurrentPhase();
+      if (!s_startupTime.is_not_a_date_time())
+         s_totalMicroseconds = elapsedMicroseconds(s_startupTime);
+      s_complete = true;
+   }
+   END_LOCK_MUTEX
+
+   // write the structured report to the scratch path (best effort --
+   // per-deployment tooling reads it from there)
+   FilePath profilePath = module_context::userScratchPath().complete(
+                                                            kProfileFile);
+   Error error = writeStringToFile(profilePath,
+                                   json::writeFormatted(profileAsJson()));
+   if (error)
+      LOG_ERROR(error);
+
+   // log the total along with the top offenders so slow deployments
+   // show up in the logs without anyone asking for the report
+   std::vector<PhaseRecord> slowest;
+   LOCK_MUTEX(s_phasesMutex)
+   {
+      slowest = s_phases;
+   }
+   END_LOCK_MUTEX
+   std::sort(slowest.begin(), slowest.end(), phaseDurationGreater);
+
+   std::string message = "session startup completed in " +
+                         formatMillis(s_totalMicroseconds);
+   if (!slowest.empty())
+   {
+      message += " (slowest phases:";
+      for (std::size_t i = 0; i < slowest.size() && i < 3; i++)
+      {
+         message += " " + slowest[i].name + " " +
+                    formatMillis(slowest[i].microseconds);
+         if (i + 1 < slowest.size() && i + 1 < 3)
+            message += ",";
+      }
+      message += ")";
+   }
+   LOG_INFO_MESSAGE(message);
+}
+
+Error initialize()
+{
+   return module_context::registerRpcMethod("get_startup_profile",
+                                            getStartupProfile);
+}
+
+} // namespace startup_profiler
+} // namespace session
+} // namespace rstudio
@@ -0,0 +1,60 @@
+/*
+ * SessionStartupProfiler.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SESSION_STARTUP_PROFILER_HPP
+#define SESSION_STARTUP_PROFILER_HPP
+
+#include <string>
+
+#include <boost/cstdint.hpp>
+
+namespace rstudio {
+namespace core {
+   class Error;
+}
+}
+
+namespace rstudio {
+namespace session {
+namespace startup_profiler {
+
+// built-in timing of rsession startup. main() and rInit mark the coarse
+// sequential phases with advancePhase (each call closes the previous
+// phase and opens the next, mirroring PerformanceTimer::advance); the
+// individual init steps inside rInit's ParallelExecBlock report through
+// recordInitStep (installed as the block's task observer) and are
+// recorded as sub-phases of whatever phase is open. once the session is
+// fully initialized completeStartup writes a structured report to the
+// scratch path (startup-profile.json), logs the total with the slowest
+// phases, and the full breakdown remains available through the
+// get_startup_profile rpc
+
+// close the current top-level phase (if any) and begin a new one
+void advancePhase(const std::string& name);
+
+// record an init step as a sub-phase (matches
+// core::ParallelExecBlock::TaskObserver; may be called from pool threads)
+void recordInitStep(const std::string& name, boost::int64_t microseconds);
+
+// startup is complete: close the open phase, write the report, and log
+void completeStartup();
+
+core::Error initialize();
+
+} // namespace startup_profiler
+} // namespace session
+} // namespace rstudio
+
+#endif // SESSION_STARTUP_PROFILER_HPP
@@ -19,6 +19,8 @@
 #include "SessionSuspend.hpp"
 #include "SessionConsoleInput.hpp"
 
+#include <core/FlightRecorder.hpp>
+
 #include <session/SessionConstants.hpp>
 #include <session/SessionOptions.hpp>
 
@@ -71,12 +73,19 @@ void setSuspendedFromTimeout(bool suspended)
    
 bool suspendSession(bool force, int status)
 {
+   // note the attempt in the flight recorder (a successful suspend does
+   // not return, so a matching end entry means the suspend failed)
+   core::flight_recorder::record("suspend begin",
+                                 force ? "forced" : "normal");
+
    // need to make sure the global environment is loaded before we
    // attemmpt to save it!
    r::session::ensureDeserialized();
 
    // perform the suspend (does not return if successful)
-   return r::session::suspend(force, status);
+   bool suspended = r::session::suspend(force, status);
+   core::flight_recorder::record("suspend end");
+   return suspended;
 }
 
 void suspendIfRequested(const boost::function<bool()>& allowSuspend)
@@ -15,20 +15,81 @@
 
 #include "SessionUriHandlers.hpp"
 
+#include <set>
+
+#include <core/Thread.hpp>
+
 #include <session/SessionConstants.hpp>
 
 using namespace rstudio::core;
 
 namespace rstudio {
-namespace session { 
+namespace session {
 namespace uri_handlers {
 
+namespace {
+
+// registration is guarded by a mutex since module initialization may
+// register handlers from parallel init tasks (see ParallelExecBlock
+// usage in SessionMain.cpp); lookups are unguarded because they only
+// occur after initialization is complete
+boost::mutex s_handlersMutex;
+
+// prefixes currently occupied by lazy module stubs (guarded by
+// s_handlersMutex). registration over a stub replaces it (normal
+// registration of a duplicate prefix is a no-op)
+std::set<std::string> s_lazyUriStubs;
+
+void addHandler(const http::UriHandler& handler)
+{
+   LOCK_MUTEX(s_handlersMutex)
+   {
+      std::set<std::string>::iterator it =
+                                 s_lazyUriStubs.find(handler.prefix());
+      if (it != s_lazyUriStubs.end())
+      {
+         s_lazyUriStubs.erase(it);
+         uri_handlers::handlers().replace(handler);
+      }
+      else
+      {
+         uri_handlers::handlers().add(handler);
+      }
+   }
+   END_LOCK_MUTEX
+}
+
+} // anonymous namespace
+
 http::UriHandlers& handlers()
 {
    static http::UriHandlers instance;
    return instance;
 }
 
+void registerLazyUriStub(const std::string& prefix,
+                         const http::UriAsyncHandlerFunction& stub)
+{
+   LOCK_MUTEX(s_handlersMutex)
+   {
+      uri_handlers::handlers().add(http::UriHandler(prefix, stub));
+      s_lazyUriStubs.insert(prefix);
+   }
+   END_LOCK_MUTEX
+}
+
+bool isLazyUriStub(const std::string& prefix)
+{
+   LOCK_MUTEX(s_handlersMutex)
+   {
+      return s_lazyUriStubs.count(prefix) > 0;
+   }
+   END_LOCK_MUTEX
+
+   // keep compiler happy
+   return false;
+}
+
 } // namespace uri_handlers
 
 namespace module_context {
@@ -38,7 +99,7 @@ Error registerAsyncUriHandler(
                          const http::UriAsyncHandlerFunction& handlerFunction)
 {
 
-   uri_handlers::handlers().add(http::UriHandler(name, handlerFunction));
+   uri_handlers::addHandler(http::UriHandler(name, handlerFunction));
    return Success();
 }
 
@@ -46,7 +107,7 @@ Error registerUriHandler(const std::string& name,
                          const http::UriHandlerFunction& handlerFunction)
 {
 
-   uri_handlers::handlers().add(http::UriHandler(name, handlerFunction));
+   uri_handlers::addHandler(http::UriHandler(name, handlerFunction));
    return Success();
 }
 
@@ -55,7 +116,7 @@ Error registerAsyncLocalUriHandler(
                          const std::string& name,
                          const http::UriAsyncHandlerFunction& handlerFunction)
 {
-   uri_handlers::handlers().add(http::UriHandler(kLocalUriLocationPrefix + name,
+   uri_handlers::addHandler(http::UriHandler(kLocalUriLocationPrefix + name,
                                       handlerFunction));
    return Success();
 }
@@ -63,7 +124,7 @@ Error registerAsyncLocalUriHandler(
 Error registerLocalUriHandler(const std::string& name,
                               const http::UriHandlerFunction& handlerFunction)
 {
-   uri_handlers::handlers().add(http::UriHandler(kLocalUriLocationPrefix + name,
+   uri_handlers::addHandler(http::UriHandler(kLocalUriLocationPrefix + name,
                                       handlerFunction));
    return Success();
 }
@@ -13,14 +13,25 @@
  *
  */
 
+#include <string>
+
 #include <core/http/UriHandler.hpp>
 
 namespace rstudio {
-namespace session { 
+namespace session {
 namespace uri_handlers {
 
 core::http::UriHandlers& handlers();
 
+// support for lazily activated modules (module_context::registerLazyModule).
+// a lazy stub occupies a uri prefix until the module's real
+// initialization replaces it; unlike normal registration (where the
+// first registration of a prefix wins) registering over a lazy stub
+// replaces it
+void registerLazyUriStub(const std::string& prefix,
+                         const core::http::UriAsyncHandlerFunction& stub);
+bool isLazyUriStub(const std::string& prefix);
+
 } // namespace uri_handlers
 } // namespace session
 } // namespace rstudio
@@ -236,6 +236,11 @@ Error UserSettings::initialize()
    if (error)
       return error;
 
+   // user settings are written in bursts (e.g. when the client syncs
+   // ui prefs) so coalesce them into debounced background writes --
+   // this avoids serializing on round trips to NFS home directories
+   settings_.enableDelayedWrites();
+
    // register routines for reading/writing UI prefs from R code
    RS_REGISTER_CALL_METHOD(rs_readUiPref, 1);
    RS_REGISTER_CALL_METHOD(rs_writeUiPref, 2);
@@ -18,6 +18,7 @@
 
 
 #include <boost/array.hpp>
+#include <boost/algorithm/string/predicate.hpp>
 
 #include <boost/utility.hpp>
 #include <boost/asio/io_service.hpp>
@@ -59,6 +60,8 @@ public:
                       const Handler& handler)
       : socket_(ioService), handler_(handler)
    {
+      // stream large upload bodies to disk rather than buffering them
+      requestParser_.setBodyConsumerFactory(connection::requestBodyConsumer);
    }
 
    virtual ~HttpConnectionImpl()
@@ -80,12 +83,29 @@ public:
 
    virtual void sendResponse(const core::http::Response &response)
    {
+      // honor persistent connections when the client asked for one and
+      // the response length is known (otherwise connection close is what
+      // delimits the response body). this allows the server's session
+      // proxy to reuse its connections rather than reconnecting for
+      // every request
+      bool keepAlive = !request_.isHttp10() &&
+                       !boost::algorithm::iequals(
+                           request_.headerValue("Connection"), "close") &&
+                       !response.headerValue("Content-Length").empty();
+
       try
       {
          // write the response
-         boost::asio::write(socket_,
-                            response.toBuffers(
-                                  core::http::Header::connectionClose()));
+         if (keepAlive)
+         {
+            boost::asio::write(socket_, response.toBuffers());
+         }
+         else
+         {
+            boost::asio::write(socket_,
+                               response.toBuffers(
+                                     core::http::Header::connectionClose()));
+         }
       }
       catch(const boost::system::system_error& e)
       {
@@ -96,10 +116,27 @@ public:
          // log the error if it wasn't connection terminated
          if (!core::http::isConnectionTerminatedError(error))
             LOG_ERROR(error);
+
+         keepAlive = false;
       }
       CATCH_UNEXPECTED_EXCEPTION
 
-      // always close connection
+      if (keepAlive)
+      {
+         // re-arm for the next request on this connection (keeps this
+         // object alive via the async read's shared_from_this reference)
+         try
+         {
+            request_.reset();
+            requestParser_.reset();
+            requestId_.clear();
+            readSome();
+            return;
+         }
+         CATCH_UNEXPECTED_EXCEPTION
+      }
+
+      // close connection
       try
       {
          close();
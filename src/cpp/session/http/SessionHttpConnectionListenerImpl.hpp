@@ -271,6 +271,12 @@ private:
       if (connection::checkForSuspend(ptrHttpConnection))
          return;
 
+      // check for an rpc method registered as thread-safe -- these never
+      // touch R so they are dispatched on a worker pool rather than
+      // queued behind the R event loop
+      if (connection::checkForThreadsafeRpc(ptrHttpConnection))
+         return;
+
       // place the connection on the correct queue
       if (connection::isGetEvents(ptrHttpConnection))
          eventsConnectionQueue_.enqueConnection(ptrHttpConnection);
@@ -17,10 +17,13 @@
 
 #include <core/Log.hpp>
 #include <core/Error.hpp>
+#include <core/PerformanceMetrics.hpp>
 #include <core/Thread.hpp>
 
 #include <core/http/Request.hpp>
 
+#include <r/session/REventLoop.hpp>
+
 using namespace rstudio::core ;
 
 namespace rstudio {
@@ -31,12 +34,17 @@ void HttpConnectionQueue::enqueConnection(
 {
    LOCK_MUTEX(*pMutex_)
    {
-      // enque
-      queue_.push(ptrConnection);
+      // enque (note the arrival time so dwell time can be measured)
+      queue_.push(QueuedConnection(
+                     boost::posix_time::microsec_clock::universal_time(),
+                     ptrConnection));
    }
    END_LOCK_MUTEX
 
    pWaitCondition_->notify_all();
+
+   // wake the R event loop so the connection is picked up immediately
+   r::session::event_loop::signalWakeup();
 }
 
 
@@ -47,15 +55,22 @@ boost::shared_ptr<HttpConnection> HttpConnectionQueue::doDequeConnection()
       if (!queue_.empty())
       {
          // remove it
-         boost::shared_ptr<HttpConnection> next = queue_.front();
+         QueuedConnection next = queue_.front();
          queue_.pop();
 
          // note last connection time
          lastConnectionTime_ =
                      boost::posix_time::second_clock::universal_time();
 
+         // record how long the connection sat in the queue waiting for
+         // the main thread to get to it
+         core::performance::recordDuration(
+               "rsession_connection_queue_dwell_seconds",
+               boost::posix_time::microsec_clock::universal_time() -
+                  next.first);
+
          // return it
-         return next;
+         return next.second;
       }
       else
       {
@@ -97,7 +112,7 @@ std::string HttpConnectionQueue::peekNextConnectionUri()
    LOCK_MUTEX(*pMutex_)
    {
       if (!queue_.empty())
-         return queue_.front()->request().uri();
+         return queue_.front().second->request().uri();
       else
          return std::string();
    }
@@ -16,6 +16,11 @@
 
 #include "SessionHttpConnectionUtils.hpp"
 
+#include "../SessionRpc.hpp"
+
+#include <ostream>
+
+#include <boost/bind.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 
 #include <core/FilePath.hpp>
@@ -31,6 +36,7 @@
 
 #include <core/r_util/RSessionContext.hpp>
 
+#include <session/SessionConstants.hpp>
 #include <session/SessionMain.hpp>
 #include <session/SessionOptions.hpp>
 #include <session/projects/ProjectsSettings.hpp>
@@ -77,6 +83,72 @@ std::string rstudioRequestIdFromRequest(const core::http::Request& request)
    return request.headerValue("X-RS-RID");
 }
 
+namespace {
+
+// bodies at or above this size are streamed to disk rather than
+// accumulated in Request::body()
+const std::size_t kStreamUploadThreshold = 2 * 1024 * 1024;
+
+void writeBodyChunk(boost::shared_ptr<std::ostream> pStream,
+                    const char* pData,
+                    std::size_t length)
+{
+   try
+   {
+      pStream->write(pData, length);
+   }
+   catch(const std::exception& e)
+   {
+      LOG_ERROR_MESSAGE("Error streaming upload body: " +
+                        std::string(e.what()));
+   }
+}
+
+} // anonymous namespace
+
+core::http::RequestParser::BodyConsumer requestBodyConsumer(
+                                             core::http::Request* pRequest)
+{
+   using namespace rstudio::core;
+
+   // never trust a client-supplied copy of the streaming header
+   pRequest->removeHeader(kStreamedUploadFileHeader);
+
+   // only stream large multipart file upload bodies
+   if (!boost::algorithm::ends_with(pRequest->uri(), "/upload"))
+      return http::RequestParser::BodyConsumer();
+   if (!boost::algorithm::istarts_with(pRequest->contentType(),
+                                       "multipart/form-data"))
+      return http::RequestParser::BodyConsumer();
+   if (pRequest->contentLength() < kStreamUploadThreshold)
+      return http::RequestParser::BodyConsumer();
+
+   // stream the body to a temp file (fall back to buffering on error)
+   FilePath bodyFilePath;
+   Error error = FilePath::tempFilePath(&bodyFilePath);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return http::RequestParser::BodyConsumer();
+   }
+
+   boost::shared_ptr<std::ostream> pStream;
+   error = bodyFilePath.open_w(&pStream);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return http::RequestParser::BodyConsumer();
+   }
+
+   // record the location of the streamed body for the upload handler
+   pRequest->setHeader(kStreamedUploadFileHeader,
+                       bodyFilePath.absolutePath());
+
+   // NOTE: the stream is flushed and closed when the request parser
+   // releases the consumer (after the final body byte is delivered)
+   return boost::bind(writeBodyChunk, pStream, _1, _2);
+}
+
 
 bool isMethod(boost::shared_ptr<HttpConnection> ptrConnection,
                      const std::string& method)
@@ -212,6 +284,11 @@ bool checkForSuspend(boost::shared_ptr<HttpConnection> ptrConnection)
 }
 #endif
 
+bool checkForThreadsafeRpc(boost::shared_ptr<HttpConnection> ptrConnection)
+{
+   return rpc::checkForThreadsafeRpc(ptrConnection);
+}
+
 bool authenticate(boost::shared_ptr<HttpConnection> ptrConnection,
                   const std::string& secret)
 {
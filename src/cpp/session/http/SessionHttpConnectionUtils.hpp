@@ -22,6 +22,8 @@
 
 #include <boost/function.hpp>
 
+#include <core/http/RequestParser.hpp>
+
 namespace rstudio {
 namespace core {
 namespace http {
@@ -36,6 +38,13 @@ namespace connection {
 
 std::string rstudioRequestIdFromRequest(const core::http::Request& request);
 
+// body consumer factory for the request parser: streams large multipart
+// upload bodies to a temp file (recorded in kStreamedUploadFileHeader)
+// rather than buffering them in memory; returns an empty consumer (i.e.
+// default buffering) for all other requests
+core::http::RequestParser::BodyConsumer requestBodyConsumer(
+                                             core::http::Request* pRequest);
+
 bool isMethod(boost::shared_ptr<HttpConnection> ptrConnection,
               const std::string& method);
 
@@ -50,6 +59,11 @@ bool checkForAbort(boost::shared_ptr<HttpConnection> ptrConnection,
 
 bool checkForSuspend(boost::shared_ptr<HttpConnection> ptrConnection);
 
+// check for an rpc method registered as thread-safe; if the request is
+// for one then it is handed to the rpc worker pool (which takes
+// ownership of the connection) and true is returned
+bool checkForThreadsafeRpc(boost::shared_ptr<HttpConnection> ptrConnection);
+
 bool authenticate(boost::shared_ptr<HttpConnection> ptrConnection,
                   const std::string& secret);
 
@@ -47,6 +47,17 @@ inline AsyncRProcessOptions operator | (AsyncRProcessOptions lhs,
             static_cast<int>(lhs) | static_cast<int>(rhs));
 }
 
+// a pre-warmed idle R worker that async jobs can claim (see
+// SessionAsyncRProcess.cpp)
+class PooledRWorker;
+
+// pre-warm an idle R worker for upcoming async jobs with the given
+// profile, optionally running the given R code (e.g. package preloads)
+// before the worker begins waiting for a job. workers are recycled when
+// the package library changes beneath them.
+void warmAsyncRProcess(AsyncRProcessOptions rOptions,
+                       const std::string& preload = std::string());
+
 class AsyncRProcess :
       boost::noncopyable,
       public boost::enable_shared_from_this<AsyncRProcess>
@@ -58,21 +69,24 @@ public:
    void start(const char* rCommand,
               const core::FilePath& workingDir,
               AsyncRProcessOptions rOptions,
-              std::vector<core::FilePath> rSourceFiles = 
+              std::vector<core::FilePath> rSourceFiles =
                  std::vector<core::FilePath>(),
               const std::string &input = std::string())
    {
-      start(rCommand, core::system::Options(), workingDir, rOptions, 
+      start(rCommand, core::system::Options(), workingDir, rOptions,
             rSourceFiles, input);
    }
 
+   // 'preload' identifies the warm-worker profile the job can run on
+   // (see warmAsyncRProcess); it is not applied to cold-started processes
    void start(const char* rCommand,
               core::system::Options environment,
               const core::FilePath& workingDir,
               AsyncRProcessOptions rOptions,
-              std::vector<core::FilePath> rSourceFiles = 
+              std::vector<core::FilePath> rSourceFiles =
                  std::vector<core::FilePath>(),
-              const std::string& input = std::string());
+              const std::string& input = std::string(),
+              const std::string& preload = std::string());
 
    bool isRunning();
    void terminate();
@@ -88,6 +102,9 @@ protected:
    virtual void onCompleted(int exitStatus) = 0;
 
 private:
+   // pooled workers forward process callbacks to the job they're running
+   friend class PooledRWorker;
+
    void onProcessCompleted(int exitStatus);
    bool isRunning_;
    bool terminationRequested_;
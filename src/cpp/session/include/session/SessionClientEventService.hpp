@@ -41,7 +41,11 @@ ClientEventService& clientEventService();
 class ClientEventService : boost::noncopyable
 {
 private:
-   ClientEventService() {}
+   ClientEventService()
+      : nextEventId_(0), lastEventSocketIdSent_(-1),
+        binaryEventProtocol_(false), eventSocketGeneration_(0)
+   {
+   }
    friend ClientEventService& clientEventService();
 
 public:
@@ -49,26 +53,47 @@ public:
 
    core::Error start(const std::string& clientId);
    void stop();
-   
+
    void setClientId(const std::string& clientId, bool clearEvents);
 
    std::string clientId();
 
+   // port of the WebSocket event channel (0 if not enabled/running)
+   int eventSocketPort();
+
 private:
    void run();
+   void runEventSocket();
 
    void erasePreviouslyDeliveredEvents(int lastClientEventIdSeen);
    bool havePendingClientEvents();
    void addClientEvent(const core::json::Object& eventObject);
    void setClientEventResult(core::json::JsonRpcResponse* pResponse);
 
-  
+   void syncNextEventId(int lastClientEventIdSeen);
+   void collectPendingEvents(std::size_t maxEvents);
+
+   // WebSocket event channel callbacks
+   bool validateEventSocketConnection(const std::string& resource);
+   void onEventSocketConnected();
+   void onEventSocketMessage(const std::string& message);
+
 private:
    boost::mutex mutex_ ;
    boost::thread serviceThread_ ;
+   boost::thread eventSocketThread_ ;
 
    std::string clientId_ ;
    core::json::Array clientEvents_ ;
+   int nextEventId_ ;
+   int lastEventSocketIdSent_ ;
+
+   // WebSocket wire format state (guarded by mutex_). the binary
+   // protocol is renegotiated on every connection; the generation
+   // counter tells the sender thread when to discard its per-connection
+   // compression/dictionary state
+   bool binaryEventProtocol_ ;
+   int eventSocketGeneration_ ;
 };
    
   
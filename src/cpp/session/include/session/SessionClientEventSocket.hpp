@@ -0,0 +1,117 @@
+/*
+ * SessionClientEventSocket.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+#ifndef SESSION_CLIENT_EVENT_SOCKET_HPP
+#define SESSION_CLIENT_EVENT_SOCKET_HPP
+
+#include <string>
+
+#ifdef _WIN32
+# include <winsock2.h>
+#endif
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <core/Error.hpp>
+#include <core/Thread.hpp>
+
+#include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/server.hpp>
+#include <websocketpp/frame.hpp>
+
+namespace rstudio {
+namespace session {
+
+// Overview: ClientEventSocket manages a websocket over which client
+// events are pushed to the client, replacing the get_events long-poll
+// when enabled (the long-poll continues to work as a fallback since
+// events remain queued until acknowledged). Modeled on the terminal
+// websocket (ConsoleProcessSocket) and reachable through the server
+// proxy's localhost pass-through, just like terminal connections.
+//
+// IMPORTANT: Callbacks are dispatched on a background thread.
+
+struct ClientEventSocketCallbacks
+{
+   // invoked to validate a new connection given its request resource;
+   // return false to reject (used to require the active client id)
+   boost::function<bool (const std::string& resource)> validateConnection;
+
+   // invoked when the client connection opens
+   boost::function<void ()> onClientConnected;
+
+   // invoked when a message (an event acknowledgement) arrives
+   boost::function<void (const std::string& message)> onClientMessage;
+
+   // invoked when the client connection closes
+   boost::function<void ()> onClientDisconnected;
+};
+
+typedef websocketpp::server<websocketpp::config::asio> eventServer;
+typedef eventServer::message_ptr eventMessage_ptr;
+
+class ClientEventSocket : boost::noncopyable
+{
+public:
+   ClientEventSocket();
+   ~ClientEventSocket();
+
+   // start the websocket servicing thread
+   core::Error ensureServerRunning(const ClientEventSocketCallbacks& callbacks);
+
+   // stop the websocket servicing thread
+   void stopServer();
+
+   // is a client currently connected?
+   bool isConnected() const;
+
+   // send a text message to the connected client
+   core::Error send(const std::string& message);
+
+   // send a binary message to the connected client
+   core::Error sendBinary(const std::string& message);
+
+   // network port for websocket listener; 0 means no port
+   int port() const;
+
+private:
+   void watchSocket();
+
+   core::Error sendMessage(const std::string& message,
+                           websocketpp::frame::opcode::value opcode);
+
+   void onMessage(eventServer* s, websocketpp::connection_hdl hdl,
+                  eventMessage_ptr msg);
+   void onClose(eventServer* s, websocketpp::connection_hdl hdl);
+   void onOpen(eventServer* s, websocketpp::connection_hdl hdl);
+
+private:
+   int port_;
+   boost::thread websocketThread_;
+   bool serverRunning_;
+   boost::shared_ptr<eventServer> pwsServer_;
+   ClientEventSocketCallbacks callbacks_;
+
+   // connection state (guarded by mutex_; there is at most one active
+   // connection -- a newer connection displaces an older one)
+   mutable boost::mutex mutex_;
+   websocketpp::connection_hdl hdl_;
+   bool connected_;
+};
+
+} // namespace session
+} // namespace rstudio
+
+#endif // SESSION_CLIENT_EVENT_SOCKET_HPP
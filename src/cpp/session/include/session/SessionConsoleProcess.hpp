@@ -282,6 +282,12 @@ private:
 };
 
 core::json::Array processesAsJson();
+
+// is console process output likely to arrive soon (i.e. a process recently
+// started, received input, or produced output)? used to tighten the main
+// loop's background processing cadence while terminals are active
+bool likelyOutputPending();
+
 core::Error initialize();
 
 } // namespace console_process
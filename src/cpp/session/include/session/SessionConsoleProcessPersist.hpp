@@ -39,12 +39,12 @@ std::string loadConsoleProcessMetadata();
 void saveConsoleProcesses(const std::string& metadata);
 
 // Get the saved buffer for the given ConsoleProcess. If maxLines > 0,
-// trims the saved buffer to the given number of lines and persists it,
-// then returns the trimmed buffer.
+// reads (at most) the given number of lines from the tail of the
+// saved buffer.
 std::string getSavedBuffer(const std::string& handle, int maxLines);
 
-// Return number of lines in the saved buffer for given ConsoleProcess;
-// buffer will be trimmed to max number of lines and rewritten.
+// Return number of lines in the saved buffer for given ConsoleProcess
+// (up to maxLines if maxLines > 0).
 int getSavedBufferLineCount(const std::string& handle, int maxLines);
 
 // Add to the saved buffer for the given ConsoleProcess
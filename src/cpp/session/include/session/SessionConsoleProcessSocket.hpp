@@ -15,6 +15,7 @@
 #ifndef SESSION_CONSOLE_PROCESS_SOCKET_HPP
 #define SESSION_CONSOLE_PROCESS_SOCKET_HPP
 
+#include <map>
 #include <string>
 
 #ifdef _WIN32
@@ -101,7 +102,9 @@ public:
    core::Error sendRawText(const std::string& terminalHandle,
                            const std::string& message);
 
-   // send text packet to client
+   // send text packet to client; output is batched into larger frames
+   // within a short window (and rate limited) so fast-printing child
+   // processes don't swamp the client with tiny frames
    core::Error sendText(const std::string& terminalHandle,
                         const std::string& message);
 
@@ -126,6 +129,21 @@ private:
 
    void onServerTimeout(boost::system::error_code ec);
 
+   void flushBatchedOutput(const boost::system::error_code& ec);
+
+   // terminal output pending delivery for a connection
+   struct OutputBatch
+   {
+      OutputBatch() : windowStartMs(0), windowBytes(0), droppedInWindow(false)
+      {
+      }
+
+      std::string pending;
+      double windowStartMs;
+      size_t windowBytes;
+      bool droppedInWindow;
+   };
+
 private:
    core::thread::ThreadsafeMap<std::string, ConsoleProcessSocketConnectionDetails> connections_;
 
@@ -134,6 +152,11 @@ private:
    bool serverRunning_;
    boost::shared_ptr<terminalServer> pwsServer_;
 
+   boost::mutex batchMutex_;
+   std::map<std::string, OutputBatch> batches_;
+   bool flushPending_;
+   boost::scoped_ptr<boost::asio::deadline_timer> pFlushTimer_;
+
    int activeConnections_;
 };
 
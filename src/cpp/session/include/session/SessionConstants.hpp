@@ -66,6 +66,7 @@
 
 #define kWebSocketPingInterval            "websocket-ping-seconds"
 #define kWebSocketConnectTimeout          "websocket-connect-timeout"
+#define kWebSocketEvents                  "websocket-events"
 
 // NOTE: literal versions of these are depended upon by the desktop/rsinverse
 // project so they should be updated there as well if they are changed
@@ -90,6 +91,11 @@
 
 #define kRStudioNoTransformRedirect "X-RStudio-NoTransformRedirect"
 
+// header used to convey the temp file which a large request body was
+// streamed to (set by the session's http connection during parsing,
+// never accepted from clients)
+#define kStreamedUploadFileHeader "X-Streamed-Upload-File"
+
 #define kServerSettingsDir "/etc/rstudio"
 
 // json rpc methods we handle (the rest are delegated to the HttpServer)
@@ -102,6 +108,7 @@ const char * const kAdminNotificationAcknowledged = "admin_notification_acknowle
 const char * const kHandleUnsavedChangesCompleted = "handle_unsaved_changes_completed";
 const char * const kQuitSession = "quit_session" ;   
 const char * const kSuspendSession = "suspend_session";
+const char * const kReloadOptions = "reload_options";
 const char * const kInterrupt = "interrupt";
 const char * const kConsoleInput = "console_input";
 const char * const kRStudioAPIShowDialogMethod = "rstudio_api_show_dialog";
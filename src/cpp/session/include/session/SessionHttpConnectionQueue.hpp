@@ -17,6 +17,7 @@
 #define SESSION_HTTP_CONNECTION_QUEUE_HPP
 
 #include <queue>
+#include <utility>
 
 #include <boost/shared_ptr.hpp>
 
@@ -68,9 +69,12 @@ private:
    boost::mutex* pMutex_ ;
    boost::condition* pWaitCondition_ ;
 
-   // instance data
+   // instance data (connections are queued along with their arrival
+   // time so dwell time in the queue can be measured on deque)
+   typedef std::pair<boost::posix_time::ptime,
+                     boost::shared_ptr<HttpConnection> > QueuedConnection;
    boost::posix_time::ptime lastConnectionTime_;
-   std::queue<boost::shared_ptr<HttpConnection> > queue_;
+   std::queue<QueuedConnection> queue_;
 };
 
 } // namespace session
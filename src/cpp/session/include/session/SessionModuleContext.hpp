@@ -17,6 +17,7 @@
 #ifndef SESSION_MODULE_CONTEXT_HPP
 #define SESSION_MODULE_CONTEXT_HPP
 
+#include <set>
 #include <string>
 
 #include <boost/utility.hpp>
@@ -132,6 +133,10 @@ std::string rLocalHelpPort();
 // get current libpaths
 std::vector<core::FilePath> getLibPaths();
 
+// hash of the library state (the library paths and their last write
+// times); used to key caches derived from the set of installed packages
+std::string libraryStateHash(const std::vector<core::FilePath>& libPaths);
+
 // is the packages pane disabled
 bool disablePackages();
 
@@ -226,6 +231,45 @@ core::Error registerRpcMethod(const std::string& name,
 
 void registerRpcMethod(const core::json::JsonRpcAsyncMethod& method);
 
+// register a read-only rpc method whose responses are cached at the
+// dispatch layer: a repeat request with identical parameters is served
+// without re-invoking the handler (with an ETag so clients can
+// revalidate and skip the transfer entirely), until a client event of
+// one of the specified types is enqueued. handlers registered this way
+// must be free of side effects and must communicate exclusively
+// through their result
+core::Error registerCacheableRpcMethod(
+                              const std::string& name,
+                              const core::json::JsonRpcFunction& function,
+                              const std::set<int>& invalidationEvents);
+
+// register an rpc method that is dispatched on a worker pool running
+// concurrently with R, so it remains responsive while R is busy.
+// handlers registered this way must be fully thread-safe: they can be
+// invoked at any time (including while R code is executing and while
+// other rpc methods run), must never call into R, and must only touch
+// state that is itself thread-safe. change detection (onDetectChanges)
+// is not run for these methods
+core::Error registerThreadsafeRpcMethod(
+                              const std::string& name,
+                              const core::json::JsonRpcFunction& function);
+
+// register a lazily activated module. rather than fully initializing at
+// startup, stubs are registered for the module's rpc methods and uri
+// prefixes; the first access to any of them runs initFunction (which
+// performs the module's normal initialization, replacing the stubs) and
+// then re-dispatches the triggering request to the real handler.
+// activation occurs on the main thread, so initFunction may call into R.
+// lazy modules must register their methods with registerRpcMethod (not
+// the async/threadsafe variants) and must not require initialization
+// side effects (events, R routines used by other modules, persisted
+// state restoration) before first access
+core::Error registerLazyModule(
+                     const std::string& moduleName,
+                     const boost::function<core::Error()>& initFunction,
+                     const std::vector<std::string>& rpcMethods,
+                     const std::vector<std::string>& uriPrefixes);
+
 core::Error executeAsync(const core::json::JsonRpcFunction& function,
                          const core::json::JsonRpcRequest& request,
                          core::json::JsonRpcResponse* pResponse);
@@ -385,7 +429,9 @@ void scheduleIncrementalWork(
 // schedule work to done every time the specified period elapses.
 // if the execute function returns true then the worker will be called
 // again after the specified period. pass idleOnly = true to restrict
-// periodic work to idle time.
+// periodic work to idle time. periodic wakeups are aligned to shared
+// ticks so independently scheduled tasks with similar periods execute
+// in the same pass.
 void schedulePeriodicWork(const boost::posix_time::time_duration& period,
                           const boost::function<bool()> &execute,
                           bool idleOnly = true,
@@ -397,6 +443,65 @@ void scheduleDelayedWork(const boost::posix_time::time_duration& period,
                          const boost::function<void()> &execute,
                          bool idleOnly = true);
 
+// variations of the scheduling functions above which tag the work with
+// a name; per-task execution counts and timings are tracked under the
+// name and surfaced by .rs.scheduledCommandDiagnostics() so expensive
+// tasks can be identified
+void scheduleIncrementalWork(
+         const std::string& name,
+         const boost::posix_time::time_duration& incrementalDuration,
+         const boost::function<bool()>& execute,
+         bool idleOnly = true);
+
+void scheduleIncrementalWork(
+         const std::string& name,
+         const boost::posix_time::time_duration& initialDuration,
+         const boost::posix_time::time_duration& incrementalDuration,
+         const boost::function<bool()>& execute,
+         bool idleOnly = true);
+
+void schedulePeriodicWork(const std::string& name,
+                          const boost::posix_time::time_duration& period,
+                          const boost::function<bool()> &execute,
+                          bool idleOnly = true,
+                          bool immediate = true);
+
+void scheduleDelayedWork(const std::string& name,
+                         const boost::posix_time::time_duration& period,
+                         const boost::function<void()> &execute,
+                         bool idleOnly = true);
+
+// background prefetching for predictable user actions. modules register
+// a predictor which observes rpc traffic; when a request makes a
+// follow-on action likely, the predictor queues a prefetch task via
+// schedulePrefetch (tasks are named so repeat predictions coalesce).
+// tasks execute one per idle pass on the main thread (so they may call
+// into R) and the queue is bounded -- stale predictions are dropped
+// rather than allowed to pile up behind the user
+void registerRpcPrefetcher(
+   const boost::function<void(const core::json::JsonRpcRequest&)>& predictor);
+
+void schedulePrefetch(const std::string& name,
+                      const boost::function<void()>& execute);
+
+// called by the rpc dispatch layer to feed prefetch predictors
+void notifyRpcMethodInvoked(const core::json::JsonRpcRequest& request);
+
+// budgeted change detection. modules register a named handler rather
+// than connecting to events().onDetectChanges directly: each detection
+// pass (e.g. a console prompt) runs handlers within a fixed time budget
+// and defers whatever doesn't fit to idle time, so prompt latency stays
+// flat as modules accumulate. handlers registered with onlyWhenFlagged
+// run only after flagChangeDetection has been called for them (from a
+// file monitor callback, an R hook, etc.)
+void registerChangeDetection(
+         const std::string& name,
+         const boost::function<void(ChangeSource)>& handler,
+         bool onlyWhenFlagged = false);
+
+// mark a change detection handler as having work for its next pass
+void flagChangeDetection(const std::string& name);
+
 
 core::string_utils::LineEnding lineEndings(const core::FilePath& filePath);
 
@@ -416,8 +521,10 @@ core::Error sourceModuleRFileWithResult(const std::string& rSourceFile,
                                         const core::FilePath& workingDir,
                                         core::system::ProcessResult* pResult);
    
-// enque client events (note R methods can do this via .rs.enqueClientEvent)
+// enque client events (note R methods can do this via .rs.enqueClientEvent).
+// the rvalue overload hands the event's payload to the queue without a copy
 void enqueClientEvent(const ClientEvent& event);
+void enqueClientEvent(ClientEvent&& event);
 
 // check whether a directory is currently being monitored by one of our subsystems
 bool isDirectoryMonitored(const core::FilePath& directory);
@@ -59,6 +59,13 @@ private:
 public:
    // read options  
    core::ProgramStatus read(int argc, char * const argv[], std::ostream& osWarnings);
+
+   // apply a changed config value in place when the option is one that
+   // can be reloaded without a session restart; returns false when the
+   // option requires a restart to take effect
+   bool applyReloadableOption(const std::string& name,
+                              const std::string& value);
+
    virtual ~Options() {}
    
    bool runTests() const
@@ -239,6 +246,9 @@ public:
    int limitFileUploadSizeMb() const { return limitFileUploadSizeMb_; }
    int limitCpuTimeMinutes() const { return limitCpuTimeMinutes_; }
 
+   // resident memory target for idle trimming (0 means no target)
+   int memoryTargetMb() const { return memoryTargetMb_; }
+
    int limitRpcClientUid() const { return limitRpcClientUid_; }
 
    bool limitXfsDiskQuota() const { return limitXfsDiskQuota_; }
@@ -520,6 +530,11 @@ public:
       return webSocketConnectTimeout_;
    }
 
+   bool webSocketEvents() const
+   {
+      return webSocketEvents_;
+   }
+
    std::string getOverlayOption(const std::string& name)
    {
       return overlayOptions_[name];
@@ -613,6 +628,7 @@ private:
    bool verifySignatures_;
    int webSocketPingSeconds_;
    int webSocketConnectTimeout_;
+   bool webSocketEvents_;
 
    // r
    std::string coreRSourcePath_;
@@ -634,6 +650,7 @@ private:
    int limitCpuTimeMinutes_;
    int limitRpcClientUid_;
    bool limitXfsDiskQuota_;
+   int memoryTargetMb_;
    
    // external
    std::string rpostbackPath_;
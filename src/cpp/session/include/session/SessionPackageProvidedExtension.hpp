@@ -68,33 +68,33 @@ private:
    std::string resourcePath_;
 };
 
+class PackageScan;
+
 class Indexer : boost::noncopyable
 {
 public:
    explicit Indexer();
    virtual ~Indexer() {}
-   
+
 public:
    void addWorker(boost::shared_ptr<Worker> pWorker);
    void removeWorker(boost::shared_ptr<Worker> pWorker);
-   
+
 public:
    void start();
    bool running() { return running_; }
    core::json::Object getPayload() { return payload_; }
-   
+
 private:
    void beginIndexing();
    bool work();
    void endIndexing();
-   
+
 private:
    std::vector<boost::shared_ptr<Worker> > workers_;
-   std::vector<core::FilePath> pkgDirs_;
+   boost::shared_ptr<PackageScan> pScan_;
    core::json::Object payload_;
-   
-   std::size_t index_;
-   std::size_t n_;
+
    bool running_;
 };
 
@@ -70,6 +70,20 @@ public:
    // set contents from string
    void setContents(const std::string& contents);
 
+   // splice a range edit (offset/length in bytes) into the contents in
+   // place; cheaper than setContents for the differential-save path since
+   // the text outside the edited range is never copied or compared.
+   // returns true if the edit changed the contents
+   bool applyContentsEdit(std::size_t offset,
+                          std::size_t length,
+                          const std::string& replacement);
+
+   // note that the document's current contents exactly match those
+   // persisted for the given properties file path -- subsequent edits
+   // can then be persisted as appends to the contents journal rather
+   // than full rewrites
+   void markContentsPersisted(const core::FilePath& propertiesFilePath);
+
    // set contents from file
    core::Error setPathAndContents(const std::string& path,
                                   bool allowSubstChars = true);
@@ -144,13 +158,27 @@ public:
    core::Error readFromJson(core::json::Object* pDocJson);
    void writeToJson(core::json::Object* pDocJson, bool includeContents = true) const;
 
-   core::Error writeToFile(const core::FilePath& filePath, bool writeContents = true) const;
+   core::Error writeToFile(const core::FilePath& filePath, bool writeContents = true);
+
+   // write just the document contents, preferring cheap journal appends.
+   // when pCompactionPending is supplied, a journal past the compaction
+   // threshold is still appended to and *pCompactionPending is set so the
+   // caller can rewrite the snapshot off the critical path
+   core::Error writeContentsToFile(const core::FilePath& filePath,
+                                   bool* pCompactionPending = NULL);
+
+   // document properties serialized exactly as they are persisted
+   std::string propertiesAsString() const;
 
    SEXP toRObject(r::sexp::Protect* pProtect, bool includeContents = true) const;
 
 private:
    void editProperty(const core::json::Object::value_type& property);
 
+   void recordContentsEdit(std::size_t offset,
+                           std::size_t remove,
+                           const std::string& insert);
+
 private:
    std::string id_;
    std::string path_;
@@ -168,6 +196,12 @@ private:
    std::string collabServer_;
    std::string sourceWindow_;
    core::json::Object properties_;
+
+   // journaled contents persistence: deltas recorded since the contents
+   // were last known to match persistent storage (see writeToFile)
+   std::string pendingContentsJournal_;
+   std::string persistedContentsPath_;
+   bool canJournalContents_;
    
 public:
    
@@ -192,6 +226,8 @@ core::Error get(const std::string& id, bool includeContents, boost::shared_ptr<S
 core::Error getDurableProperties(const std::string& path,
                                  core::json::Object* pProperties);
 core::Error list(std::vector<boost::shared_ptr<SourceDocument> >* pDocs);
+core::Error list(std::vector<boost::shared_ptr<SourceDocument> >* pDocs,
+                 bool includeContents);
 core::Error list(std::vector<core::FilePath>* pPaths);
 core::Error put(boost::shared_ptr<SourceDocument> pDoc, bool writeContents = true);
 core::Error remove(const std::string& id);
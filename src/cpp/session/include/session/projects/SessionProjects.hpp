@@ -111,12 +111,20 @@ public:
    core::FilePath oldScratchPath() const;
 
    const core::r_util::RProjectConfig& config() const { return config_; }
-   void setConfig(const core::r_util::RProjectConfig& config)
+
+   // set the config, computing the delta from the current config --
+   // dependent state (encoding, build target, package info) is only
+   // recomputed for the scopes that actually changed, and subscribers
+   // to onConfigChanged are notified of the delta. returns the delta
+   core::r_util::RProjectConfigDiff setConfig(
+                              const core::r_util::RProjectConfig& config);
+
+   // subscribe to scoped config change notifications (fired by
+   // setConfig whenever the config differs from the previous one)
+   boost::signal<void(const core::r_util::RProjectConfigDiff&)>&
+                                                         onConfigChanged()
    {
-      config_ = config;
-      updateDefaultEncoding();
-      updateBuildTargetPath();
-      updatePackageInfo();
+      return onConfigChanged_;
    }
 
    core::Error readVcsOptions(RProjectVcsOptions* pOptions) const;
@@ -224,6 +232,8 @@ private:
    boost::signal<void(const std::vector<core::system::FileChangeEvent>&)>
                                                             onFilesChanged_;
    boost::signal<void()> onMonitoringDisabled_;
+   boost::signal<void(const core::r_util::RProjectConfigDiff&)>
+                                                         onConfigChanged_;
 };
 
 ProjectContext& projectContext();
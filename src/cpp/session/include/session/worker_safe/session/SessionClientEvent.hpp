@@ -200,7 +200,24 @@ public:
    {
       init(type, data);
    }
-   
+
+   // move overloads so payloads can be built in place and handed off
+   // without deep-copying the tree into the event
+   ClientEvent(int type, core::json::Value&& data)
+   {
+      init(type, std::move(data));
+   }
+
+   ClientEvent(int type, core::json::Object&& data)
+   {
+      init(type, core::json::Value(std::move(data)));
+   }
+
+   ClientEvent(int type, core::json::Array&& data)
+   {
+      init(type, core::json::Value(std::move(data)));
+   }
+
    ClientEvent(int type, const char* data)
    {
       init(type, core::json::Value(std::string(data)));
@@ -230,7 +247,8 @@ public:
      
 private:
    void init(int type, const core::json::Value& data);
-  
+   void init(int type, core::json::Value&& data);
+
 private:
    int type_ ;
    core::json::Value data_ ;
@@ -0,0 +1,120 @@
+/*
+ * SessionAllocationTracker.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+// diagnostics rpcs for the core allocation tracker (see
+// core/AllocationTracker.hpp): start_allocation_tracking begins sampled
+// attribution of heap allocations by module, stop_allocation_tracking
+// ends it, and get_allocation_stats returns the live per-module
+// breakdown -- so support can attribute rsession resident-size growth
+// on a canary box without restarting the session. the same breakdown is
+// also appended to the /metrics endpoint while tracking is on
+
+#include "SessionAllocationTracker.hpp"
+
+#include <boost/bind.hpp>
+
+#include <core/AllocationTracker.hpp>
+#include <core/Error.hpp>
+#include <core/Exec.hpp>
+#include <core/json/JsonRpc.hpp>
+
+#include <session/SessionModuleContext.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace allocation_tracker {
+
+namespace {
+
+json::Object statsAsJson()
+{
+   std::vector<allocation::ModuleStats> moduleStats = allocation::stats();
+
+   json::Array modulesJson;
+   for (std::size_t i = 0; i < moduleStats.size(); i++)
+   {
+      const allocation::ModuleStats& stats = moduleStats[i];
+
+      json::Object moduleJson;
+      moduleJson["module"] = stats.module;
+      moduleJson["live_allocations"] = static_cast<double>(
+                                          stats.liveAllocations);
+      moduleJson["live_bytes"] = static_cast<double>(stats.liveBytes);
+      moduleJson["total_allocations"] = static_cast<double>(
+                                          stats.totalAllocations);
+      moduleJson["total_bytes"] = static_cast<double>(stats.totalBytes);
+      modulesJson.push_back(moduleJson);
+   }
+
+   json::Object resultJson;
+   resultJson["enabled"] = allocation::isEnabled();
+   resultJson["modules"] = modulesJson;
+   return resultJson;
+}
+
+Error startAllocationTracking(const json::JsonRpcRequest& request,
+                              json::JsonRpcResponse* pResponse)
+{
+   int sampleRate = 64;
+   Error error = json::readParams(request.params, &sampleRate);
+   if (error)
+      return error;
+
+   if (!allocation::enable(sampleRate))
+      return systemError(boost::system::errc::not_supported, ERROR_LOCATION);
+
+   return Success();
+}
+
+Error stopAllocationTracking(const json::JsonRpcRequest& /*request*/,
+                             json::JsonRpcResponse* pResponse)
+{
+   allocation::disable();
+
+   // return the final breakdown along with the stop
+   pResponse->setResult(statsAsJson());
+   return Success();
+}
+
+Error getAllocationStats(const json::JsonRpcRequest& /*request*/,
+                         json::JsonRpcResponse* pResponse)
+{
+   pResponse->setResult(statsAsJson());
+   return Success();
+}
+
+} // anonymous namespace
+
+Error initialize()
+{
+   using boost::bind;
+   using namespace module_context;
+   ExecBlock initBlock;
+   initBlock.addFunctions()
+      (bind(registerRpcMethod, "start_allocation_tracking",
+            startAllocationTracking))
+      (bind(registerRpcMethod, "stop_allocation_tracking",
+            stopAllocationTracking))
+      (bind(registerRpcMethod, "get_allocation_stats", getAllocationStats));
+   return initBlock.execute();
+}
+
+} // namespace allocation_tracker
+} // namespace modules
+} // namespace session
+} // namespace rstudio
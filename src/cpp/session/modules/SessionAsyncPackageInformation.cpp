@@ -23,9 +23,17 @@
 #include <sstream>
 
 #include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/FileUtils.hpp>
+#include <core/Hash.hpp>
 #include <core/json/Json.hpp>
 #include <core/json/JsonRpc.hpp>
 #include <core/Error.hpp>
+#include <core/SafeConvert.hpp>
+
+#ifndef _WIN32
+#include <core/system/FileMode.hpp>
+#endif
 
 #include <boost/format.hpp>
 #include <boost/algorithm/string.hpp>
@@ -139,7 +147,224 @@ bool fillFunctionInfo(const json::Object& functionObjectJson,
    }
    
    return true;
-   
+
+}
+
+bool fillPackageInformation(const json::Object& pkgJson,
+                            core::r_util::PackageInformation* pPkgInfo)
+{
+   json::Array exportsJson;
+   json::Array typesJson;
+   json::Object functionInfoJson;
+   json::Array datasetsJson;
+
+   Error error = json::readObject(pkgJson,
+                                  "package", &(pPkgInfo->package),
+                                  "exports", &exportsJson,
+                                  "types", &typesJson,
+                                  "function_info", &functionInfoJson,
+                                  "datasets", &datasetsJson);
+
+   if (error)
+   {
+      LOG_ERROR(error);
+      return false;
+   }
+
+   if (!json::fillVectorString(exportsJson, &(pPkgInfo->exports)))
+      LOG_ERROR_MESSAGE("Failed to read JSON 'objects' array to vector");
+
+   if (!json::fillVectorInt(typesJson, &(pPkgInfo->types)))
+      LOG_ERROR_MESSAGE("Failed to read JSON 'types' array to vector");
+
+   if (!fillFunctionInfo(functionInfoJson, pPkgInfo->package, &(pPkgInfo->functionInfo)))
+      LOG_ERROR_MESSAGE("Failed to read JSON 'functions' object to map");
+
+   if (!json::fillVectorString(datasetsJson, &(pPkgInfo->datasets)))
+      LOG_ERROR_MESSAGE("Failed to read JSON 'data' array to vector");
+
+   return true;
+}
+
+// On-disk cache of extracted package information. A package installation
+// is immutable for a given (location, last write time), so each indexed
+// package version is written exactly once -- into a box-wide sticky
+// world-writable directory where every session on the machine can read
+// it. 60 sessions then extract a shared library once rather than 60
+// times, and sessions started after the first pay no extraction cost at
+// all. When the shared directory can't be provisioned (and on Windows,
+// which has no sticky directories) we fall back to a per-user cache.
+#ifndef _WIN32
+const char * const kSharedCompletionCacheDir = "/tmp/rstudio-pkg-index";
+#endif
+
+FilePath completionCacheDir()
+{
+#ifndef _WIN32
+   FilePath sharedDir(kSharedCompletionCacheDir);
+   Error error = sharedDir.ensureDirectory();
+   if (!error)
+   {
+      error = core::system::changeFileMode(
+                  sharedDir,
+                  core::system::EveryoneReadWriteExecuteMode,
+                  true /* set sticky bit */);
+      if (!error)
+         return sharedDir;
+   }
+   LOG_ERROR(error);
+#endif
+
+   return module_context::userScratchPath().childPath("completion_cache");
+}
+
+// one immutable file per package version: the name carries a hash of
+// the installation path and its mtime, so distinct versions (and the
+// same package installed in different libraries) coexist rather than
+// clobbering one another
+std::string completionCacheFileName(const std::string& pkgName,
+                                    const std::string& path,
+                                    const std::string& mtime)
+{
+   return pkgName + "-" + hash::crc32HexHash(path + ":" + mtime) + ".json";
+}
+
+void writeCachedPackageInformation(const json::Object& pkgJson)
+{
+   std::string pkgName;
+   std::string path;
+   Error error = json::readObject(pkgJson,
+                                  "package", &pkgName,
+                                  "path", &path);
+
+   // older versions of the extraction code don't report the package
+   // location -- without it there's nothing to key the cache on
+   if (error || pkgName.empty() || path.empty())
+      return;
+
+   FilePath pkgPath(path);
+   if (!pkgPath.exists())
+      return;
+
+   FilePath cacheDir = completionCacheDir();
+   error = cacheDir.ensureDirectory();
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   std::string mtime = safe_convert::numberToString(pkgPath.lastWriteTime());
+   FilePath cachePath = cacheDir.childPath(
+            completionCacheFileName(pkgName, path, mtime));
+
+   // entries are immutable: if another session already wrote this
+   // package version there is nothing to do
+   if (cachePath.exists())
+      return;
+
+   json::Object cacheJson = pkgJson;
+   cacheJson["cache_mtime"] = mtime;
+
+   // write to a unique temp file and move it into place so that readers
+   // in other sessions never observe a partially written entry
+   FilePath tempPath = file_utils::uniqueFilePath(cacheDir, pkgName + "-");
+   error = writeStringToFile(tempPath, json::write(cacheJson));
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+#ifndef _WIN32
+   // make the entry readable by every session on the box
+   error = core::system::changeFileMode(
+            tempPath, core::system::UserReadWriteGroupEveryoneReadMode);
+   if (error)
+      LOG_ERROR(error);
+#endif
+
+   error = tempPath.move(cachePath);
+   if (error)
+      LOG_ERROR(error);
+}
+
+// attempt to satisfy one cache entry; the entry is only valid while the
+// package installation it was extracted from remains untouched
+bool loadCachedPackageInformation(const std::string& pkgName,
+                                  const FilePath& cachePath)
+{
+   std::string contents;
+   Error error = readStringFromFile(cachePath, &contents);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return false;
+   }
+
+   json::Value value;
+   if (!json::parse(contents, &value) || !json::isType<json::Object>(value))
+      return false;
+
+   const json::Object& cacheJson = value.get_obj();
+
+   std::string path;
+   std::string mtime;
+   error = json::readObject(cacheJson,
+                            "path", &path,
+                            "cache_mtime", &mtime);
+   if (error)
+      return false;
+
+   FilePath pkgPath(path);
+   if (!pkgPath.exists() ||
+       safe_convert::numberToString(pkgPath.lastWriteTime()) != mtime)
+   {
+      return false;
+   }
+
+   core::r_util::PackageInformation pkgInfo;
+   if (!fillPackageInformation(cacheJson, &pkgInfo))
+      return false;
+
+   if (pkgInfo.package != pkgName)
+      return false;
+
+   DEBUG("Loaded cached entry for package: '" << pkgName << "'");
+   core::r_util::RSourceIndex::addPackageInformation(pkgName, pkgInfo);
+   return true;
+}
+
+bool loadCachedPackageInformation(const std::string& pkgName)
+{
+   // candidate entries share the package name prefix but carry a version
+   // hash we can't compute without asking R, so probe each one (almost
+   // always just a single file) and validate against the installation
+   std::vector<FilePath> children;
+   Error error = completionCacheDir().children(&children);
+   if (error)
+   {
+      if (!core::isPathNotFoundError(error))
+         LOG_ERROR(error);
+      return false;
+   }
+
+   std::string prefix = pkgName + "-";
+   for (std::vector<FilePath>::const_iterator it = children.begin();
+        it != children.end();
+        ++it)
+   {
+      if (it->extensionLowerCase() != ".json" ||
+          !boost::algorithm::starts_with(it->filename(), prefix))
+      {
+         continue;
+      }
+
+      if (loadCachedPackageInformation(pkgName, *it))
+         return true;
+   }
+
+   return false;
 }
 
 } // anonymous namespace
@@ -178,11 +403,6 @@ void AsyncPackageInformationProcess::onCompleted(int exitStatus)
    // }
    for (std::size_t i = 0; i < n; ++i)
    {
-      json::Array exportsJson;
-      json::Array typesJson;
-      json::Object functionInfoJson;
-      json::Array datasetsJson;
-      
       core::r_util::PackageInformation pkgInfo;
 
       if (splat[i].empty())
@@ -212,36 +432,17 @@ void AsyncPackageInformationProcess::onCompleted(int exitStatus)
       // something else if e.g. we got malformed output on load of a package
       if (!json::isType<json::Object>(value))
          continue;
-      
-      Error error = json::readObject(value.get_obj(),
-                                     "package", &pkgInfo.package,
-                                     "exports", &exportsJson,
-                                     "types", &typesJson,
-                                     "function_info", &functionInfoJson,
-                                     "datasets", &datasetsJson);
 
-      if (error)
-      {
-         LOG_ERROR(error);
+      if (!fillPackageInformation(value.get_obj(), &pkgInfo))
          continue;
-      }
 
       DEBUG("Adding entry for package: '" << pkgInfo.package << "'");
 
-      if (!json::fillVectorString(exportsJson, &(pkgInfo.exports)))
-         LOG_ERROR_MESSAGE("Failed to read JSON 'objects' array to vector");
-
-      if (!json::fillVectorInt(typesJson, &(pkgInfo.types)))
-         LOG_ERROR_MESSAGE("Failed to read JSON 'types' array to vector");
-
-      if (!fillFunctionInfo(functionInfoJson, pkgInfo.package, &(pkgInfo.functionInfo)))
-         LOG_ERROR_MESSAGE("Failed to read JSON 'functions' object to map");
-      
-      if (!json::fillVectorString(datasetsJson, &(pkgInfo.datasets)))
-         LOG_ERROR_MESSAGE("Failed to read JSON 'data' array to vector");
-      
       // Update the index
       core::r_util::RSourceIndex::addPackageInformation(pkgInfo.package, pkgInfo);
+
+      // Persist the entry so later sessions needn't extract it again
+      writeCachedPackageInformation(value.get_obj());
    }
 
 }
@@ -259,7 +460,19 @@ void AsyncPackageInformationProcess::update()
    
    s_pkgsToUpdate_ =
       RSourceIndex::getAllUnindexedPackages();
-   
+
+   // satisfy what we can from the on-disk completion cache -- packages
+   // whose installations are unchanged don't need a fresh extraction
+   std::vector<std::string> uncached;
+   for (std::vector<std::string>::const_iterator it = s_pkgsToUpdate_.begin();
+        it != s_pkgsToUpdate_.end();
+        ++it)
+   {
+      if (!loadCachedPackageInformation(*it))
+         uncached.push_back(*it);
+   }
+   s_pkgsToUpdate_.swap(uncached);
+
    // alias for readability
    const std::vector<std::string>& pkgs = s_pkgsToUpdate_;
    
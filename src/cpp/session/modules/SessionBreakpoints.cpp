@@ -596,6 +596,16 @@ Error removeAllBreakpoints(const json::JsonRpcRequest&,
    return Success();
 }
 
+void onPackageLoaded(const std::string&)
+{
+   // loading a package changes the search path and can introduce new copies
+   // of functions, so cached function environment resolutions are no longer
+   // trustworthy
+   Error error = r::exec::RFunction(".rs.invalidateFunctionEnvCache").call();
+   if (error)
+      LOG_ERROR(error);
+}
+
 } // anonymous namespace
 
 bool haveSrcrefAttribute()
@@ -623,6 +633,8 @@ Error initialize()
    using boost::bind;
    using namespace module_context;
 
+   events().onPackageLoaded.connect(onPackageLoaded);
+
    ExecBlock initBlock ;
    initBlock.addFunctions()
       (bind(registerRpcMethod, "get_function_state", getFunctionState))
@@ -18,24 +18,35 @@
 
 #include "SessionCodeSearch.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <sstream>
 #include <vector>
 #include <set>
 
 #include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
 #include <boost/regex.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/split.hpp>
 
+#include <core/AllocationTracker.hpp>
 #include <core/Error.hpp>
 #include <core/Exec.hpp>
 #include <core/FilePath.hpp>
 #include <core/FileSerializer.hpp>
+#include <core/Hash.hpp>
 #include <core/SafeConvert.hpp>
+#include <core/StringUtils.hpp>
+#include <core/Thread.hpp>
 #include <core/collection/Tree.hpp>
+#include <core/http/Util.hpp>
+#include <core/system/MemoryMappedFile.hpp>
 
 #include <core/r_util/RSourceIndex.hpp>
 
@@ -46,6 +57,7 @@
 #include <r/RExec.hpp>
 #include <r/RRoutines.hpp>
 
+#include <session/SessionOptions.hpp>
 #include <session/SessionUserSettings.hpp>
 #include <session/SessionModuleContext.hpp>
 #include <session/SessionAsyncRProcess.hpp>
@@ -69,19 +81,44 @@ namespace code_search {
 
 namespace {
 
-bool isWithinIgnoredDirectory(const FilePath& filePath)
+// project state consulted when screening out ignored directories. captured
+// eagerly (on the main thread) so that background indexing threads never
+// read session state which might be mutated while they run
+struct IgnoredDirectoryContext
+{
+   IgnoredDirectoryContext() : hasProject(false), isPackageProject(false) {}
+   bool hasProject;
+   bool isPackageProject;
+   FilePath projectDir;
+   std::string websiteDir;
+};
+
+IgnoredDirectoryContext ignoredDirectoryContext()
 {
    using namespace projects;
-   
+   IgnoredDirectoryContext context;
+   context.hasProject = projectContext().hasProject();
+   if (context.hasProject)
+   {
+      context.isPackageProject = projectContext().isPackageProject();
+      context.projectDir = projectContext().directory();
+      context.websiteDir = module_context::websiteOutputDir();
+   }
+   return context;
+}
+
+bool isWithinIgnoredDirectory(const FilePath& filePath,
+                              const IgnoredDirectoryContext& context)
+{
    // we only index (and ignore) directories within the current project
-   if (!projectContext().hasProject())
+   if (!context.hasProject)
       return false;
-   
-   FilePath projDir = projectContext().directory();
+
+   const FilePath& projDir = context.projectDir;
    FilePath parentPath = filePath.parent();
-   std::string websiteDir = module_context::websiteOutputDir();
-   bool isPackageProject = projectContext().isPackageProject();
-   
+   const std::string& websiteDir = context.websiteDir;
+   bool isPackageProject = context.isPackageProject;
+
    // allow plain files living within the 'revdep' folder
    if (isPackageProject &&
        parentPath.filename() == "revdep" &&
@@ -121,7 +158,27 @@ bool isWithinIgnoredDirectory(const FilePath& filePath)
       if (isPackageProject && parentName == "revdep")
          return true;
    }
-   
+
+   return false;
+}
+
+bool isWithinIgnoredDirectory(const FilePath& filePath)
+{
+   return isWithinIgnoredDirectory(filePath, ignoredDirectoryContext());
+}
+
+bool isIndexableSourceFile(const FileInfo& fileInfo)
+{
+   FilePath filePath(fileInfo.absolutePath());
+   if (!filePath.isDirectory() && filePath.exists())
+   {
+      std::string lowerExtension = filePath.extensionLowerCase();
+      return
+            lowerExtension == ".r" ||
+            lowerExtension == ".s" ||
+            lowerExtension == ".q";
+   }
+
    return false;
 }
 
@@ -359,93 +416,1167 @@ public:
             }
          }
 
-         if (it == end)
-         {
-            DEBUG("- Adding another child to parent");
-            parent = append_child(parent, entry);
-         }
-         else
+         if (it == end)
+         {
+            DEBUG("- Adding another child to parent");
+            parent = append_child(parent, entry);
+         }
+         else
+         {
+            // We update the entry (because its associated index may
+            // have changed)
+            *it = entry;
+         }
+      }
+
+      // If we just inserted a folder, we append an empty child
+      // to the node. This is done to optimize lookup time.
+      if (entry.fileInfo.isDirectory())
+      {
+         DEBUG("Inserted empty directory; adding dummy child to folder node");
+         parent = append_child(parent, dummyEntry_);
+      }
+      DEBUG("");
+
+      DEBUG("Tree is now:");
+      print_tree(*this);
+      DEBUG("");
+   }
+
+public:
+
+   iterator find_leaf(const Entry& entry)
+   {
+      leaf_iterator it = begin_leaf();
+      for (; is_valid(it); ++it)
+         if (isSamePath(*it, entry))
+            return it;
+      return this->end();
+   }
+
+   iterator find_branch(const Entry& entry)
+   {
+      iterator parent = begin();
+      iterator result = end();
+      do_find_branch(entry, parent, &result);
+      return result;
+   }
+   
+private:
+
+   void do_find_branch(const Entry& entry,
+                       iterator parent,
+                       iterator* pResult)
+   {
+      sibling_iterator it = parent.begin();
+      sibling_iterator end = parent.end();
+      for (; it != end; ++it)
+      {
+         DEBUG("- Current branch: '" << (*it).fileInfo.absolutePath() << "'");
+         if (isSamePath(*it, entry))
+         {
+            *pResult = it;
+            return;
+         }
+
+         if (number_of_children(it) > 0)
+         {
+            DEBUG("-- Searching children of branch");
+            do_find_branch(entry, it, pResult);
+         }
+      }
+   }
+
+public:
+
+   iterator find(const Entry& entry)
+   {
+      if (entry.fileInfo.isDirectory())
+         return find_branch(entry);
+      else
+         return find_leaf(entry);
+   }
+
+private:
+
+   Entry dummyEntry_;
+   
+};
+
+// number of background indexing threads (tokenization is cpu bound so
+// there's little upside to going past a few cores)
+const int kMaxIndexThreads = 4;
+
+// maximum number of completed indexes merged into the live index per
+// pass of the main thread merge step
+const int kMaxMergePerPass = 200;
+
+int indexThreadCount()
+{
+   int threads = boost::thread::hardware_concurrency();
+   if (threads < 1)
+      threads = 1;
+   else if (threads > kMaxIndexThreads)
+      threads = kMaxIndexThreads;
+   return threads;
+}
+
+// a unit of work for the background indexing pool -- carries the file to
+// index in and the completed source index (NULL for non-indexable files,
+// which still get entries in the tree for file name search) back out
+struct IndexWork
+{
+   IndexWork()
+   {
+   }
+
+   explicit IndexWork(const FileInfo& fileInfo)
+      : fileInfo(fileInfo)
+   {
+   }
+
+   FileInfo fileInfo;
+   boost::shared_ptr<r_util::RSourceIndex> pIndex;
+
+   // hash of the (scrubbed) file contents backing pIndex -- carried so
+   // the merge step can persist it to the on-disk index cache
+   std::string contentHash;
+};
+
+// persistent copy of the project source index, stored in the project
+// scratch path. written whenever a full-project indexing pass completes
+// and consulted by the next full-project pass so that only files whose
+// mtime or content hash actually changed get re-tokenized
+const char * const kIndexCacheFile = "code-search-index";
+
+// bump whenever the record format (or anything serialized into it,
+// e.g. the RSourceItem fields) changes -- caches with another tag are
+// silently discarded and rebuilt
+const char * const kIndexCacheFormat = "code-search-index-v2";
+
+struct CachedSourceIndex
+{
+   CachedSourceIndex() : lastWriteTime(0) {}
+   std::string context;
+   std::string contentHash;
+   std::time_t lastWriteTime;
+   std::vector<std::string> inferredPkgs;
+   std::vector<r_util::RSourceItem> items;
+   r_util::RSourceIndex::ReferenceMap references;
+};
+
+typedef std::map<std::string, boost::shared_ptr<CachedSourceIndex> >
+                                                         SourceIndexCache;
+
+FilePath indexCacheFilePath()
+{
+   return projects::projectContext().scratchPath().childPath(kIndexCacheFile);
+}
+
+// split a line into tab delimited fields (preserving empty fields, which
+// the url encoding of the string fields otherwise never produces)
+void splitFields(const char* pBegin,
+                 const char* pEnd,
+                 std::vector<std::string>* pFields)
+{
+   pFields->clear();
+   const char* pFieldBegin = pBegin;
+   for (const char* p = pBegin; p != pEnd; p++)
+   {
+      if (*p == '\t')
+      {
+         pFields->push_back(std::string(pFieldBegin, p));
+         pFieldBegin = p + 1;
+      }
+   }
+   pFields->push_back(std::string(pFieldBegin, pEnd));
+}
+
+boost::shared_ptr<SourceIndexCache> loadIndexCache()
+{
+   boost::shared_ptr<SourceIndexCache> pCache(new SourceIndexCache());
+   if (!projects::projectContext().hasProject())
+      return pCache;
+
+   FilePath cachePath = indexCacheFilePath();
+   if (!cachePath.exists())
+      return pCache;
+
+   // map the cache file rather than reading it into memory
+   core::system::MemoryMappedFile mappedFile;
+   Error error = mappedFile.open(cachePath);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return pCache;
+   }
+
+   const char* pData = static_cast<const char*>(mappedFile.data());
+   const char* pDataEnd = pData + mappedFile.size();
+
+   bool validatedFormat = false;
+   boost::shared_ptr<CachedSourceIndex> pCurrent;
+   std::vector<std::string> fields;
+   const char* pLine = pData;
+   while (pLine < pDataEnd)
+   {
+      const char* pLineEnd = static_cast<const char*>(
+               ::memchr(pLine, '\n', pDataEnd - pLine));
+      if (pLineEnd == NULL)
+         pLineEnd = pDataEnd;
+
+      // the first line carries the format tag -- quietly discard caches
+      // written by another version (they'll simply be rebuilt)
+      if (!validatedFormat)
+      {
+         if (std::string(pLine, pLineEnd) != kIndexCacheFormat)
+            return boost::shared_ptr<SourceIndexCache>(new SourceIndexCache());
+         validatedFormat = true;
+         pLine = pLineEnd + 1;
+         continue;
+      }
+
+      splitFields(pLine, pLineEnd, &fields);
+      bool valid = true;
+      if (fields[0] == "F" && fields.size() == 4)
+      {
+         pCurrent.reset(new CachedSourceIndex());
+         pCurrent->context = http::util::urlDecode(fields[1]);
+         pCurrent->contentHash = fields[2];
+         pCurrent->lastWriteTime = safe_convert::stringTo<long>(fields[3], 0);
+         (*pCache)[pCurrent->context] = pCurrent;
+      }
+      else if (fields[0] == "P" && fields.size() == 2 && pCurrent)
+      {
+         pCurrent->inferredPkgs.push_back(http::util::urlDecode(fields[1]));
+      }
+      else if (fields[0] == "I" && fields.size() >= 6 &&
+               (fields.size() - 6) % 2 == 0 && pCurrent)
+      {
+         int type = safe_convert::stringTo<int>(fields[1],
+                                                r_util::RSourceItem::None);
+         int braceLevel = safe_convert::stringTo<int>(fields[2], 0);
+         std::size_t line = safe_convert::stringTo<std::size_t>(fields[3], 0);
+         std::size_t column = safe_convert::stringTo<std::size_t>(fields[4], 0);
+         std::string name = http::util::urlDecode(fields[5]);
+
+         std::vector<r_util::RS4MethodParam> signature;
+         for (std::size_t i = 6; i < fields.size(); i += 2)
+         {
+            signature.push_back(r_util::RS4MethodParam(
+                     http::util::urlDecode(fields[i]),
+                     http::util::urlDecode(fields[i+1])));
+         }
+
+         pCurrent->items.push_back(r_util::RSourceItem(
+                  type, name, signature, braceLevel, line, column));
+      }
+      else if (fields[0] == "R" && fields.size() >= 4 &&
+               (fields.size() - 2) % 2 == 0 && pCurrent)
+      {
+         std::string name = http::util::urlDecode(fields[1]);
+         std::vector<r_util::RSourceIndex::ReferencePosition>& positions =
+                                                pCurrent->references[name];
+         for (std::size_t i = 2; i < fields.size(); i += 2)
+         {
+            positions.push_back(r_util::RSourceIndex::ReferencePosition(
+                  safe_convert::stringTo<std::size_t>(fields[i], 0),
+                  safe_convert::stringTo<std::size_t>(fields[i+1], 0)));
+         }
+      }
+      else
+      {
+         valid = false;
+      }
+
+      // a malformed record invalidates the whole cache (every file it
+      // covered just gets re-indexed)
+      if (!valid)
+         return boost::shared_ptr<SourceIndexCache>(new SourceIndexCache());
+
+      pLine = pLineEnd + 1;
+   }
+
+   return pCache;
+}
+
+// rebuild a source index from its cached entries (skipping tokenization
+// entirely). inferred packages are recorded locally only -- global
+// registration happens on the main thread during the merge step
+boost::shared_ptr<r_util::RSourceIndex> indexFromCache(
+                                          const CachedSourceIndex& cached)
+{
+   boost::shared_ptr<r_util::RSourceIndex> pIndex(
+            new r_util::RSourceIndex(cached.context, std::string()));
+
+   BOOST_FOREACH(const r_util::RSourceItem& item, cached.items)
+   {
+      pIndex->addSourceItem(item);
+   }
+
+   BOOST_FOREACH(const std::string& pkg, cached.inferredPkgs)
+   {
+      pIndex->addInferredPackageLocal(pkg);
+   }
+
+   BOOST_FOREACH(const r_util::RSourceIndex::ReferenceMap::value_type& ref,
+                 cached.references)
+   {
+      BOOST_FOREACH(const r_util::RSourceIndex::ReferencePosition& pos,
+                    ref.second)
+      {
+         pIndex->addReference(ref.first, pos.first, pos.second);
+      }
+   }
+
+   return pIndex;
+}
+
+// one full-project indexing pass fanned out to a pool of background
+// threads. the threads read and tokenize source files (embarrassingly
+// parallel per-file) and hand completed entries back to the main thread
+// via resultQueue_; only the main thread ever touches the live index
+class IndexBatch : public boost::enable_shared_from_this<IndexBatch>,
+                   boost::noncopyable
+{
+public:
+   static boost::shared_ptr<IndexBatch> create()
+   {
+      return boost::shared_ptr<IndexBatch>(new IndexBatch());
+   }
+
+private:
+   // private: use create (threads bind to a shared_ptr so the batch must
+   // always live on the heap). note that construction captures session
+   // state and so must occur on the main thread
+   IndexBatch()
+      : ignoreContext_(ignoredDirectoryContext()),
+        lineEnding_(session::options().sourceLineEnding()),
+        cache_(loadIndexCache()),
+        fileQueue_(true),
+        resultQueue_(true),
+        stopped_(false),
+        activeWorkers_(0)
+   {
+   }
+
+public:
+   void start(const std::vector<FileInfo>& files)
+   {
+      // load up the work queue before launching any threads (the
+      // workers exit as soon as the queue runs dry)
+      BOOST_FOREACH(const FileInfo& fileInfo, files)
+      {
+         fileQueue_.enque(fileInfo);
+      }
+
+      int threads = indexThreadCount();
+      LOCK_MUTEX(mutex_)
+      {
+         activeWorkers_ = threads;
+      }
+      END_LOCK_MUTEX
+
+      for (int i = 0; i < threads; i++)
+      {
+         core::thread::safeLaunchThread(
+                  boost::bind(&IndexBatch::workerMain, shared_from_this()));
+      }
+   }
+
+   void stop()
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         stopped_ = true;
+      }
+      END_LOCK_MUTEX
+   }
+
+   bool finished()
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         // no worker can enque another result once activeWorkers_ has
+         // dropped to zero, so checking the queue afterwards is safe
+         return activeWorkers_ == 0 && resultQueue_.isEmpty();
+      }
+      END_LOCK_MUTEX
+
+      // keep compiler happy
+      return true;
+   }
+
+   bool dequeResult(IndexWork* pWork)
+   {
+      return resultQueue_.deque(pWork);
+   }
+
+private:
+   bool stopped()
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         return stopped_;
+      }
+      END_LOCK_MUTEX
+
+      // keep compiler happy
+      return true;
+   }
+
+   void workerMain()
+   {
+      try
+      {
+         FileInfo fileInfo;
+         while (!stopped() && fileQueue_.deque(&fileInfo))
+            indexFile(fileInfo);
+      }
+      CATCH_UNEXPECTED_EXCEPTION
+
+      LOCK_MUTEX(mutex_)
+      {
+         activeWorkers_--;
+      }
+      END_LOCK_MUTEX
+   }
+
+   void indexFile(const FileInfo& fileInfo)
+   {
+      // screen files living within ignored directories
+      FilePath filePath(fileInfo.absolutePath());
+      if (isWithinIgnoredDirectory(filePath, ignoreContext_))
+         return;
+
+      // tokenize indexable source files. we read the raw contents
+      // rather than calling readAndDecodeFile because iconv is provided
+      // by R and only callable from the main thread -- batches are only
+      // created for projects with a utf-8 (or unspecified) default
+      // encoding, so scrubbing invalid sequences is all that's required
+      IndexWork work(fileInfo);
+      if (isIndexableSourceFile(fileInfo))
+      {
+         std::string context = module_context::createAliasedPath(filePath);
+
+         // an unchanged mtime means we can reuse the persisted index
+         // without even reading the file
+         SourceIndexCache::const_iterator cacheIt = cache_->find(context);
+         if (cacheIt != cache_->end() &&
+             cacheIt->second->lastWriteTime == fileInfo.lastWriteTime())
+         {
+            work.pIndex = indexFromCache(*(cacheIt->second));
+            work.contentHash = cacheIt->second->contentHash;
+            resultQueue_.enque(work);
+            return;
+         }
+
+         std::string code;
+         Error error = readStringFromFile(filePath, &code, lineEnding_);
+         if (error)
+         {
+            // log if not path not found error (this can happen if the
+            // file was removed after entering the indexing queue)
+            if (!core::isPathNotFoundError(error))
+            {
+               error.addProperty("src-file", filePath.absolutePath());
+               LOG_ERROR(error);
+            }
+            return;
+         }
+
+         stripBOM(&code);
+         error = string_utils::utf8Clean(code.begin(), code.end(), '?');
+         if (error)
+            LOG_ERROR(error);
+
+         // the mtime changed but the contents may not have (e.g. touch,
+         // fresh checkout) -- still reuse the persisted index if the
+         // content hash matches
+         work.contentHash = hash::crc32HexHash(code);
+         if (cacheIt != cache_->end() &&
+             cacheIt->second->contentHash == work.contentHash)
+         {
+            work.pIndex = indexFromCache(*(cacheIt->second));
+            resultQueue_.enque(work);
+            return;
+         }
+
+         work.pIndex.reset(new r_util::RSourceIndex(context, code));
+      }
+
+      // hand the completed work back to the main thread for merging
+      resultQueue_.enque(work);
+   }
+
+private:
+   IgnoredDirectoryContext ignoreContext_;
+   core::string_utils::LineEnding lineEnding_;
+   boost::shared_ptr<SourceIndexCache> cache_;
+   core::thread::ThreadsafeQueue<FileInfo> fileQueue_;
+   core::thread::ThreadsafeQueue<IndexWork> resultQueue_;
+   boost::mutex mutex_;
+   bool stopped_;
+   int activeWorkers_;
+};
+
+// persist the results of a completed full-project indexing pass. string
+// fields are url encoded so that records stay one line of tab delimited
+// fields no matter what characters appear in paths or symbol names
+void writeIndexCache(const std::vector<IndexWork>& work)
+{
+   if (!projects::projectContext().hasProject())
+      return;
+
+   std::ostringstream ostr;
+   ostr << kIndexCacheFormat << "\n";
+   BOOST_FOREACH(const IndexWork& indexWork, work)
+   {
+      boost::shared_ptr<r_util::RSourceIndex> pIndex = indexWork.pIndex;
+      ostr << "F\t" << http::util::urlEncode(pIndex->context()) << "\t"
+           << indexWork.contentHash << "\t"
+           << indexWork.fileInfo.lastWriteTime() << "\n";
+
+      BOOST_FOREACH(const std::string& pkg, pIndex->getInferredPackages())
+      {
+         ostr << "P\t" << http::util::urlEncode(pkg) << "\n";
+      }
+
+      BOOST_FOREACH(const r_util::RSourceItem& item, pIndex->items())
+      {
+         ostr << "I\t" << item.type() << "\t" << item.braceLevel() << "\t"
+              << item.line() << "\t" << item.column() << "\t"
+              << http::util::urlEncode(item.name());
+
+         BOOST_FOREACH(const r_util::RS4MethodParam& param, item.signature())
+         {
+            ostr << "\t" << http::util::urlEncode(param.name())
+                 << "\t" << http::util::urlEncode(param.type());
+         }
+
+         ostr << "\n";
+      }
+
+      BOOST_FOREACH(const r_util::RSourceIndex::ReferenceMap::value_type& ref,
+                    pIndex->references())
+      {
+         ostr << "R\t" << http::util::urlEncode(ref.first);
+
+         BOOST_FOREACH(const r_util::RSourceIndex::ReferencePosition& pos,
+                       ref.second)
+         {
+            ostr << "\t" << pos.first << "\t" << pos.second;
+         }
+
+         ostr << "\n";
+      }
+   }
+
+   Error error = writeStringToFile(indexCacheFilePath(), ostr.str());
+   if (error)
+      LOG_ERROR(error);
+}
+
+// federated multi-project search. every project that completes a
+// full indexing pass deposits a compact federation index -- its defined
+// symbols plus a bloom filter over their names -- in a per-user
+// directory. other sessions answer cross-project symbol queries by
+// consulting the filters and parsing definitions only from projects
+// that (probably) define the symbol, so 5-10 sibling projects cost a
+// handful of 8KB filter reads rather than a search of each one
+
+const char * const kFederationDirName = "code-search-federation";
+const char * const kFederationFormat = "code-search-federation-v1";
+
+// 64k bits (8KB) with 4 hashes keeps the false positive rate around 1%
+// for the few thousand symbols a typical project defines
+const std::size_t kBloomFilterBits = 65536;
+const int kBloomFilterHashes = 4;
+
+class SymbolBloomFilter
+{
+public:
+   SymbolBloomFilter()
+      : bits_(kBloomFilterBits / 8, 0)
+   {
+   }
+
+   // COPYING: via compiler
+
+   void add(const std::string& name)
+   {
+      boost::uint32_t h1, h2;
+      hashPair(name, &h1, &h2);
+      for (int i = 0; i < kBloomFilterHashes; i++)
+      {
+         std::size_t bit = (h1 + i * h2) % kBloomFilterBits;
+         bits_[bit / 8] |= (1 << (bit % 8));
+      }
+   }
+
+   bool mayContain(const std::string& name) const
+   {
+      boost::uint32_t h1, h2;
+      hashPair(name, &h1, &h2);
+      for (int i = 0; i < kBloomFilterHashes; i++)
+      {
+         std::size_t bit = (h1 + i * h2) % kBloomFilterBits;
+         if ((bits_[bit / 8] & (1 << (bit % 8))) == 0)
+            return false;
+      }
+      return true;
+   }
+
+   std::string toHex() const
+   {
+      static const char hexDigits[] = "0123456789abcdef";
+      std::string hex;
+      hex.reserve(bits_.size() * 2);
+      BOOST_FOREACH(unsigned char byte, bits_)
+      {
+         hex.push_back(hexDigits[byte >> 4]);
+         hex.push_back(hexDigits[byte & 0xF]);
+      }
+      return hex;
+   }
+
+   bool fromHex(const std::string& hex)
+   {
+      if (hex.size() != bits_.size() * 2)
+         return false;
+
+      for (std::size_t i = 0; i < bits_.size(); i++)
+      {
+         int hi = hexValue(hex[2*i]);
+         int lo = hexValue(hex[2*i + 1]);
+         if (hi < 0 || lo < 0)
+            return false;
+         bits_[i] = static_cast<unsigned char>((hi << 4) | lo);
+      }
+      return true;
+   }
+
+private:
+   // FNV-1a and DJB2, combined per hash by double hashing. the filter is
+   // persisted and read back by other sessions, so the hashes must be
+   // stable across processes and machines (ruling out e.g. fastHash)
+   static void hashPair(const std::string& name,
+                        boost::uint32_t* pH1,
+                        boost::uint32_t* pH2)
+   {
+      boost::uint32_t fnv = 2166136261u;
+      boost::uint32_t djb = 5381u;
+      for (std::size_t i = 0; i < name.size(); i++)
+      {
+         unsigned char ch = static_cast<unsigned char>(name[i]);
+         fnv = (fnv ^ ch) * 16777619u;
+         djb = ((djb << 5) + djb) + ch;
+      }
+      *pH1 = fnv;
+      *pH2 = djb | 1; // keep the double-hashing stride odd
+   }
+
+   static int hexValue(char ch)
+   {
+      if (ch >= '0' && ch <= '9')
+         return ch - '0';
+      else if (ch >= 'a' && ch <= 'f')
+         return ch - 'a' + 10;
+      else
+         return -1;
+   }
+
+private:
+   std::vector<unsigned char> bits_;
+};
+
+FilePath federationIndexDir()
+{
+   return module_context::userScratchPath().complete(kFederationDirName);
+}
+
+// deposit this project's definitions (and a bloom filter over their
+// names) where sessions opened on sibling projects can find them
+void writeFederationIndex(const std::vector<IndexWork>& work)
+{
+   if (!projects::projectContext().hasProject())
+      return;
+
+   std::string projectDir =
+         projects::projectContext().directory().absolutePath();
+
+   SymbolBloomFilter bloom;
+   std::ostringstream defs;
+   BOOST_FOREACH(const IndexWork& indexWork, work)
+   {
+      boost::shared_ptr<r_util::RSourceIndex> pIndex = indexWork.pIndex;
+      BOOST_FOREACH(const r_util::RSourceItem& item, pIndex->items())
+      {
+         bloom.add(item.name());
+         defs << "D\t" << http::util::urlEncode(item.name()) << "\t"
+              << item.type() << "\t"
+              << http::util::urlEncode(pIndex->context()) << "\t"
+              << item.line() << "\t" << item.column() << "\n";
+      }
+   }
+
+   std::ostringstream ostr;
+   ostr << kFederationFormat << "\n";
+   ostr << http::util::urlEncode(projectDir) << "\n";
+   ostr << "B\t" << bloom.toHex() << "\n";
+   ostr << defs.str();
+
+   FilePath indexDir = federationIndexDir();
+   Error error = indexDir.ensureDirectory();
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   // file named by a stable hash of the project path, so each project
+   // owns exactly one slot no matter how often it re-indexes
+   error = writeStringToFile(
+            indexDir.complete(hash::crc32HexHash(projectDir)),
+            ostr.str());
+   if (error)
+      LOG_ERROR(error);
+}
+
+// a definition found in another project's federation index
+struct FederatedSymbol
+{
+   FederatedSymbol() : type(0), line(0), column(0) {}
+
+   std::string name;
+   int type;
+   std::string project;
+   std::string context;
+   int line;
+   int column;
+};
+
+bool federatedSymbolLessThan(const FederatedSymbol& lhs,
+                             const FederatedSymbol& rhs)
+{
+   if (lhs.project != rhs.project)
+      return lhs.project < rhs.project;
+   if (lhs.context != rhs.context)
+      return lhs.context < rhs.context;
+   return lhs.line < rhs.line;
+}
+
+// scan one federation index for exact matches on a symbol name. returns
+// before parsing any definition records when the bloom filter rules the
+// symbol out (the common case across a set of sibling projects)
+void searchFederationIndex(const FilePath& indexFile,
+                           const std::string& term,
+                           std::vector<FederatedSymbol>* pSymbols)
+{
+   core::system::MemoryMappedFile mappedFile;
+   Error error = mappedFile.open(indexFile);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   const char* pData = static_cast<const char*>(mappedFile.data());
+   const char* pDataEnd = pData + mappedFile.size();
+
+   std::string project;
+   int lineNumber = 0;
+   std::vector<std::string> fields;
+   const char* pLine = pData;
+   while (pLine < pDataEnd)
+   {
+      const char* pLineEnd = static_cast<const char*>(
+               ::memchr(pLine, '\n', pDataEnd - pLine));
+      if (pLineEnd == NULL)
+         pLineEnd = pDataEnd;
+
+      if (lineNumber == 0)
+      {
+         // format tag -- quietly ignore indexes written by another
+         // version (their owning session will rewrite them)
+         if (std::string(pLine, pLineEnd) != kFederationFormat)
+            return;
+      }
+      else if (lineNumber == 1)
+      {
+         project = http::util::urlDecode(std::string(pLine, pLineEnd));
+
+         // skip our own deposit (the live project index answers for us)
+         if (projects::projectContext().hasProject() &&
+             project == projects::projectContext().directory()
+                                                         .absolutePath())
+         {
+            return;
+         }
+
+         // evict indexes for projects that no longer exist
+         if (!FilePath(project).exists())
+         {
+            error = indexFile.removeIfExists();
+            if (error)
+               LOG_ERROR(error);
+            return;
+         }
+      }
+      else
+      {
+         splitFields(pLine, pLineEnd, &fields);
+         if (fields[0] == "B" && fields.size() == 2)
+         {
+            // this is the skip: a negative filter means the symbol is
+            // definitely not defined here
+            SymbolBloomFilter bloom;
+            if (bloom.fromHex(fields[1]) && !bloom.mayContain(term))
+               return;
+         }
+         else if (fields[0] == "D" && fields.size() == 6)
+         {
+            std::string name = http::util::urlDecode(fields[1]);
+            if (name == term)
+            {
+               FederatedSymbol symbol;
+               symbol.name = name;
+               symbol.type = safe_convert::stringTo<int>(
+                        fields[2], r_util::RSourceItem::None);
+               symbol.project = project;
+               symbol.context = http::util::urlDecode(fields[3]);
+               symbol.line = safe_convert::stringTo<int>(fields[4], 1);
+               symbol.column = safe_convert::stringTo<int>(fields[5], 1);
+               pSymbols->push_back(symbol);
+            }
+         }
+      }
+
+      lineNumber++;
+      pLine = pLineEnd + 1;
+   }
+}
+
+// orders a full-project work list so that open documents come first,
+// then other files within the directories of open documents, then the
+// remainder newest first (recently modified files are the most likely
+// navigation targets)
+class IndexPriorityOrder
+{
+public:
+   IndexPriorityOrder()
+   {
+      BOOST_FOREACH(const RSourceIndexes::FilePathMap::value_type& doc,
+                    rSourceIndex().filePathMap())
+      {
+         openFiles_.insert(doc.first);
+         openDirs_.insert(FilePath(doc.first).parent().absolutePath());
+      }
+   }
+
+   bool operator()(const FileInfo& a, const FileInfo& b) const
+   {
+      int rankA = rank(a);
+      int rankB = rank(b);
+      if (rankA != rankB)
+         return rankA < rankB;
+
+      return a.lastWriteTime() > b.lastWriteTime();
+   }
+
+private:
+   int rank(const FileInfo& fileInfo) const
+   {
+      if (openFiles_.count(fileInfo.absolutePath()) > 0)
+         return 0;
+
+      std::string dir = fileInfo.isDirectory() ?
+               fileInfo.absolutePath() :
+               FilePath(fileInfo.absolutePath()).parent().absolutePath();
+      if (openDirs_.count(dir) > 0)
+         return 1;
+
+      return 2;
+   }
+
+private:
+   std::set<std::string> openFiles_;
+   std::set<std::string> openDirs_;
+};
+
+// Fuzzy file-name index over the monitored project files. The file
+// lookups previously walked the whole entry tree per keystroke; here we
+// keep a flat record per file with a character occurrence bitmask so
+// that names which can't possibly match the query are rejected with a
+// single AND, matches are ranked (prefix, then substring, then
+// subsequence, shorter names first), and the candidate set from the
+// previous query is re-used when the user extends their query
+class FileNameIndex : boost::noncopyable
+{
+public:
+   FileNameIndex()
+      : removed_(0), lastSourceOnly_(false), lastValid_(false)
+   {
+   }
+
+   void update(const FileInfo& fileInfo, bool isSource)
+   {
+      if (fileInfo.isDirectory())
+         return;
+
+      std::string path = fileInfo.absolutePath();
+      PathMap::iterator it = byPath_.find(path);
+      if (it != byPath_.end())
+      {
+         // refresh in place (e.g. a modify event, or a re-add of a
+         // previously removed file)
+         NameRecord& record = entries_[it->second];
+         if (record.removed)
          {
-            // We update the entry (because its associated index may
-            // have changed)
-            *it = entry;
+            record.removed = false;
+            removed_--;
          }
+         record.isSource = isSource;
+         lastValid_ = false;
+         return;
       }
 
-      // If we just inserted a folder, we append an empty child
-      // to the node. This is done to optimize lookup time.
-      if (entry.fileInfo.isDirectory())
+      NameRecord record;
+      record.path = path;
+      record.name = FilePath(path).filename();
+      record.nameLower = string_utils::toLower(record.name);
+      record.mask = characterMask(record.nameLower);
+      record.isSource = isSource;
+      record.removed = false;
+      byPath_[path] = entries_.size();
+      entries_.push_back(record);
+
+      lastValid_ = false;
+   }
+
+   void remove(const FileInfo& fileInfo)
+   {
+      PathMap::iterator it = byPath_.find(fileInfo.absolutePath());
+      if (it == byPath_.end())
+         return;
+
+      NameRecord& record = entries_[it->second];
+      if (!record.removed)
       {
-         DEBUG("Inserted empty directory; adding dummy child to folder node");
-         parent = append_child(parent, dummyEntry_);
+         record.removed = true;
+         removed_++;
       }
-      DEBUG("");
+      lastValid_ = false;
 
-      DEBUG("Tree is now:");
-      print_tree(*this);
-      DEBUG("");
+      // reclaim space once tombstones dominate
+      if (removed_ > 1000 && removed_ * 2 > entries_.size())
+         compact();
    }
 
-public:
-
-   iterator find_leaf(const Entry& entry)
+   void clear()
    {
-      leaf_iterator it = begin_leaf();
-      for (; is_valid(it); ++it)
-         if (isSamePath(*it, entry))
-            return it;
-      return this->end();
+      entries_.clear();
+      byPath_.clear();
+      removed_ = 0;
+      lastValid_ = false;
    }
 
-   iterator find_branch(const Entry& entry)
-   {
-      iterator parent = begin();
-      iterator result = end();
-      do_find_branch(entry, parent, &result);
-      return result;
+   template <typename T>
+   bool search(const std::string& term,
+               std::size_t maxResults,
+               bool sourceFilesOnly,
+               T* pNames,
+               T* pPaths,
+               bool* pMoreAvailable)
+   {
+      // we allow the user to submit queries of the form <query>:<row><col>
+      std::string::size_type queryEnd = term.find(":");
+      if (queryEnd == std::string::npos)
+         queryEnd = term.length();
+      std::string query = string_utils::toLower(term.substr(0, queryEnd));
+      if (query.empty())
+         return false;
+
+      unsigned queryMask = characterMask(query);
+
+      // if the new query extends the previous one then only the previous
+      // candidates can possibly match it
+      bool incremental = lastValid_ &&
+                         sourceFilesOnly == lastSourceOnly_ &&
+                         boost::algorithm::starts_with(query, lastQuery_);
+
+      // scored as ((rank, name length), entry index) so that the default
+      // pair ordering sorts best matches first
+      typedef std::pair<std::pair<int,std::size_t>,std::size_t> ScoredMatch;
+      std::vector<ScoredMatch> matches;
+      std::vector<std::size_t> candidates;
+      std::size_t total = incremental ? lastCandidates_.size()
+                                      : entries_.size();
+      for (std::size_t i = 0; i < total; i++)
+      {
+         std::size_t index = incremental ? lastCandidates_[i] : i;
+         const NameRecord& record = entries_[index];
+
+         if (record.removed)
+            continue;
+
+         if (sourceFilesOnly && !record.isSource)
+            continue;
+
+         // reject names missing any queried character outright
+         if ((record.mask & queryMask) != queryMask)
+            continue;
+
+         if (!string_utils::isSubsequence(record.nameLower, query))
+            continue;
+
+         candidates.push_back(index);
+
+         int rank;
+         std::string::size_type pos = record.nameLower.find(query);
+         if (pos == 0)
+            rank = 0;
+         else if (pos != std::string::npos)
+            rank = 1;
+         else
+            rank = 2;
+
+         matches.push_back(ScoredMatch(
+               std::make_pair(rank, record.nameLower.length()), index));
+      }
+
+      // remember the candidate set for the next (extended) query
+      lastQuery_ = query;
+      lastSourceOnly_ = sourceFilesOnly;
+      lastCandidates_.swap(candidates);
+      lastValid_ = true;
+
+      // take the top ranked results
+      *pMoreAvailable = matches.size() > maxResults;
+      std::size_t numResults = std::min(matches.size(), maxResults);
+      std::partial_sort(matches.begin(),
+                        matches.begin() + numResults,
+                        matches.end());
+      for (std::size_t i = 0; i < numResults; i++)
+      {
+         const NameRecord& record = entries_[matches[i].second];
+         pNames->push_back(record.name);
+         pPaths->push_back(module_context::createAliasedPath(
+                                                   FilePath(record.path)));
+      }
+
+      return true;
    }
-   
+
 private:
 
-   void do_find_branch(const Entry& entry,
-                       iterator parent,
-                       iterator* pResult)
+   // occurrence bitmask over the characters of a (lowercased) name --
+   // letters get a bit each and other character classes share bits, so
+   // this is purely a (conservative) pre-filter
+   static unsigned characterMask(const std::string& name)
    {
-      sibling_iterator it = parent.begin();
-      sibling_iterator end = parent.end();
-      for (; it != end; ++it)
+      unsigned mask = 0;
+      for (std::size_t i = 0; i < name.length(); i++)
       {
-         DEBUG("- Current branch: '" << (*it).fileInfo.absolutePath() << "'");
-         if (isSamePath(*it, entry))
-         {
-            *pResult = it;
-            return;
-         }
-
-         if (number_of_children(it) > 0)
-         {
-            DEBUG("-- Searching children of branch");
-            do_find_branch(entry, it, pResult);
-         }
+         char ch = name[i];
+         if (ch >= 'a' && ch <= 'z')
+            mask |= 1u << (ch - 'a');
+         else if (ch >= '0' && ch <= '9')
+            mask |= 1u << 26;
+         else if (ch == '.')
+            mask |= 1u << 27;
+         else if (ch == '_' || ch == '-')
+            mask |= 1u << 28;
+         else
+            mask |= 1u << 29;
       }
+      return mask;
    }
 
-public:
-
-   iterator find(const Entry& entry)
+   void compact()
    {
-      if (entry.fileInfo.isDirectory())
-         return find_branch(entry);
-      else
-         return find_leaf(entry);
+      std::vector<NameRecord> entries;
+      entries.reserve(entries_.size() - removed_);
+      byPath_.clear();
+      for (std::size_t i = 0; i < entries_.size(); i++)
+      {
+         if (entries_[i].removed)
+            continue;
+
+         byPath_[entries_[i].path] = entries.size();
+         entries.push_back(entries_[i]);
+      }
+      entries_.swap(entries);
+      removed_ = 0;
+      lastValid_ = false;
    }
 
 private:
+   struct NameRecord
+   {
+      std::string path;
+      std::string name;
+      std::string nameLower;
+      unsigned mask;
+      bool isSource;
+      bool removed;
+   };
 
-   Entry dummyEntry_;
-   
+   std::vector<NameRecord> entries_;
+   typedef std::map<std::string,std::size_t> PathMap;
+   PathMap byPath_;
+   std::size_t removed_;
+
+   // candidate set from the previous query (so extending a query only
+   // rescans its previous matches)
+   std::string lastQuery_;
+   bool lastSourceOnly_;
+   std::vector<std::size_t> lastCandidates_;
+   bool lastValid_;
+};
+
+// a single recorded use site of a symbol
+struct SymbolReference
+{
+   SymbolReference(const std::string& context, int line, int column)
+      : context(context), line(line), column(column)
+   {
+   }
+
+   std::string context;
+   int line;
+   int column;
 };
 
+// copy the use sites recorded for a symbol out of an index, stopping
+// (and reporting more available) once maxResults is reached
+void appendReferences(const r_util::RSourceIndex& index,
+                      const std::string& name,
+                      std::size_t maxResults,
+                      std::vector<SymbolReference>* pRefs,
+                      bool* pMoreAvailable)
+{
+   r_util::RSourceIndex::ReferenceMap::const_iterator it =
+                                          index.references().find(name);
+   if (it == index.references().end())
+      return;
+
+   BOOST_FOREACH(const r_util::RSourceIndex::ReferencePosition& pos,
+                 it->second)
+   {
+      if (pRefs->size() >= maxResults)
+      {
+         *pMoreAvailable = true;
+         return;
+      }
+
+      pRefs->push_back(SymbolReference(
+               index.context(),
+               safe_convert::numberTo<std::size_t, int>(pos.first, 1),
+               safe_convert::numberTo<std::size_t, int>(pos.second, 1)));
+   }
+}
+
 class SourceFileIndex : boost::noncopyable
 {
 public:
@@ -475,6 +1606,43 @@ public:
 
    template <typename ForwardIterator>
    void enqueFiles(ForwardIterator begin, ForwardIterator end)
+   {
+      // for projects with a non utf-8 default encoding we can't decode
+      // file contents off the main thread (iconv is provided by R), so
+      // fall back to incremental indexing on the main thread
+      std::string encoding = projects::projectContext().defaultEncoding();
+      if (!encoding.empty() && !boost::algorithm::iequals(encoding, "UTF-8"))
+      {
+         enqueFilesIncremental(begin, end);
+         return;
+      }
+
+      // supersede any batch already in flight (its merge step bails as
+      // soon as it notices it is no longer current)
+      if (pBatch_)
+         pBatch_->stop();
+
+      // build the work list, ordered so that open documents and files
+      // in the directories of open documents are indexed first and the
+      // remainder is indexed newest first
+      std::vector<FileInfo> files(begin, end);
+      std::stable_sort(files.begin(), files.end(), IndexPriorityOrder());
+
+      // fan the work out to the background indexing pool
+      cacheWork_.clear();
+      pBatch_ = IndexBatch::create();
+      pBatch_->start(files);
+
+      // merge completed indexes into the live index on the main thread
+      module_context::schedulePeriodicWork(
+               "code-search-index-merge",
+               boost::posix_time::milliseconds(50),
+               boost::bind(&SourceFileIndex::mergeBatchResults, this, pBatch_),
+               false /* allow merging even when non-idle */);
+   }
+
+   template <typename ForwardIterator>
+   void enqueFilesIncremental(ForwardIterator begin, ForwardIterator end)
    {
       // add all files to the indexing queue
       using namespace rstudio::core::system;
@@ -492,6 +1660,7 @@ public:
          indexing_ = true;
 
          module_context::scheduleIncrementalWork(
+                           "code-search-index",
                            boost::posix_time::milliseconds(200),
                            boost::posix_time::milliseconds(20),
                            boost::bind(&SourceFileIndex::dequeAndIndex, this),
@@ -513,6 +1682,7 @@ public:
          indexing_ = true;
 
          module_context::scheduleIncrementalWork(
+                           "code-search-index",
                            boost::posix_time::milliseconds(20),
                            boost::bind(&SourceFileIndex::dequeAndIndex, this),
                            false /* allow indexing even when non-idle */);
@@ -588,7 +1758,40 @@ public:
          }
       }
    }
-   
+
+   // find all recorded use sites of a symbol (answered entirely from the
+   // reverse-reference index -- no files are rescanned)
+   void findReferences(const std::string& name,
+                       const std::set<std::string>& excludeContexts,
+                       std::size_t maxResults,
+                       std::vector<SymbolReference>* pRefs,
+                       bool* pMoreAvailable)
+   {
+      BOOST_FOREACH(const Entry& entry, *pEntries_)
+      {
+         // skip if it has no index
+         if (!entry.hasIndex())
+            continue;
+
+         // bail if this is an excluded context
+         if (excludeContexts.find(entry.pIndex->context()) !=
+             excludeContexts.end())
+         {
+            continue;
+         }
+
+         appendReferences(*entry.pIndex,
+                          name,
+                          maxResults,
+                          pRefs,
+                          pMoreAvailable);
+
+         // return if we are past maxResults
+         if (*pMoreAvailable)
+            return;
+      }
+   }
+
    template <typename T>
    void searchFiles(const std::string& term,
                     std::size_t maxResults,
@@ -604,7 +1807,23 @@ public:
 
       // create wildcard pattern if the search has a '*'
       boost::regex pattern = regex_utils::regexIfWildcardPattern(term);
-      
+
+      // plain fuzzy queries scoped to the whole project are served from
+      // the flat file-name index (with ranking) rather than by walking
+      // the entry tree
+      if (pattern.empty() &&
+          !prefixOnly &&
+          parentPath == projects::projectContext().directory() &&
+          fileNames_.search(term,
+                            maxResults,
+                            sourceFilesOnly,
+                            pNames,
+                            pPaths,
+                            pMoreAvailable))
+      {
+         return;
+      }
+
       // get the start and end iterators -- default to all leaves
       EntryTree::leaf_iterator it = pEntries_->begin_leaf();
       
@@ -793,13 +2012,72 @@ public:
    
    void clear()
    {
+      if (pBatch_)
+      {
+         pBatch_->stop();
+         pBatch_.reset();
+      }
+      cacheWork_.clear();
       indexing_ = false;
       indexingQueue_ = std::queue<core::system::FileChangeEvent>();
       pEntries_->clear();
+      fileNames_.clear();
    }
 
 private:
 
+   bool mergeBatchResults(boost::shared_ptr<IndexBatch> pBatch)
+   {
+      // bail if this batch has been superseded (by a clear or by a
+      // newer full enque)
+      if (pBatch != pBatch_)
+      {
+         pBatch->stop();
+         return false;
+      }
+
+      // merge a bounded number of entries per pass so that we never
+      // occupy the main thread for long
+      IndexWork work;
+      int merged = 0;
+      while (merged < kMaxMergePerPass && pBatch->dequeResult(&work))
+      {
+         // register inferred packages now that we're on the main thread
+         // (the global set is not synchronized so workers can't do it)
+         if (work.pIndex)
+         {
+            work.pIndex->registerInferredPackages();
+
+            // retain for persisting to the on-disk cache at completion
+            cacheWork_.push_back(work);
+         }
+
+         pEntries_->insertEntry(Entry(work.fileInfo, work.pIndex));
+         fileNames_.update(work.fileInfo, isSourceFile(work.fileInfo));
+         merged++;
+      }
+
+      // kick off a package information update for newly indexed files
+      if (merged > 0)
+         r_packages::AsyncPackageInformationProcess::update();
+
+      // continue until the workers have drained the file queue and we
+      // have drained the result queue
+      if (pBatch->finished())
+      {
+         // the pass covered the whole project, so snapshot it to disk
+         // for the next session (and publish our definitions for
+         // federated cross-project search)
+         writeIndexCache(cacheWork_);
+         writeFederationIndex(cacheWork_);
+         cacheWork_.clear();
+         pBatch_.reset();
+         return false;
+      }
+
+      return true;
+   }
+
    bool dequeAndIndex()
    {
       using namespace rstudio::core::system;
@@ -839,6 +2117,10 @@ private:
 
    void updateIndexEntry(const FileInfo& fileInfo)
    {
+      // attribute index entries to the code search module when the
+      // allocation tracker is on
+      core::allocation::Scope allocationScope("code_search_index");
+
       // index the source if necessary
       boost::shared_ptr<r_util::RSourceIndex> pIndex;
 
@@ -872,11 +2154,13 @@ private:
          // add index entry
          std::string context = module_context::createAliasedPath(filePath);
          pIndex.reset(new r_util::RSourceIndex(context, code));
+         pIndex->registerInferredPackages();
       }
 
       // attempt to add the entry
       Entry entry(fileInfo, pIndex);
       pEntries_->insertEntry(entry);
+      fileNames_.update(fileInfo, isSourceFile(fileInfo));
 
       // kick off an update
       r_packages::AsyncPackageInformationProcess::update();
@@ -884,6 +2168,8 @@ private:
 
    void removeIndexEntry(const FileInfo& fileInfo)
    {
+      fileNames_.remove(fileInfo);
+
       // create a fake entry with a null source index to pass to find
       Entry entry(fileInfo, boost::shared_ptr<r_util::RSourceIndex>());
 
@@ -933,22 +2219,6 @@ private:
                filePath.hasTextMimeType());
    }
 
-   static bool isIndexableSourceFile(const FileInfo& fileInfo)
-   {
-      FilePath filePath(fileInfo.absolutePath());
-      if (!filePath.isDirectory() && filePath.exists())
-      {
-         std::string lowerExtension = filePath.extensionLowerCase();
-         return
-               lowerExtension == ".r" ||
-               lowerExtension == ".s" ||
-               lowerExtension == ".q";
-      }
-
-      return false;
-
-   }
-   
 public:
    
    boost::shared_ptr<EntryTree> entries() const { return pEntries_; }
@@ -957,9 +2227,17 @@ private:
    // index entries
    boost::shared_ptr<EntryTree> pEntries_;
 
+   // flat file-name index used for fuzzy file lookup
+   FileNameIndex fileNames_;
+
    // indexing queue
    bool indexing_;
    std::queue<core::system::FileChangeEvent> indexingQueue_;
+
+   // in-flight full-project indexing batch, plus the completed work
+   // retained for persisting to the on-disk index cache
+   boost::shared_ptr<IndexBatch> pBatch_;
+   std::vector<IndexWork> cacheWork_;
 };
 
 } // anonymous namespace
@@ -991,7 +2269,8 @@ void RSourceIndexes::update(const boost::shared_ptr<SourceDocument>& pDoc)
    
    boost::shared_ptr<r_util::RSourceIndex> pIndex(
        new r_util::RSourceIndex(pDoc->path(), code));
-   
+   pIndex->registerInferredPackages();
+
    // add implicitly available packages
    FilePath filePath = module_context::resolveAliasedPath(pDoc->path());
    std::set<std::string> implicitlyAvailable =
@@ -1679,6 +2958,127 @@ Error searchCode(const json::JsonRpcRequest& request,
    return Success();
 }
 
+// cap on the reference sites returned over the wire for one query
+// (a very common symbol can have far more; the client learns there
+// were more via more_available)
+const std::size_t kMaxReferenceResults = 1000;
+
+Error findReferences(const json::JsonRpcRequest& request,
+                     json::JsonRpcResponse* pResponse)
+{
+   // get params
+   std::string term;
+   Error error = json::readParams(request.params, &term);
+   if (error)
+      return error;
+
+   std::vector<SymbolReference> refs;
+   bool moreAvailable = false;
+
+   // consult the open document indexes first (they are re-built on every
+   // edit, so their reference lists reflect unsaved changes) and exclude
+   // those contexts from the project index scan below
+   std::set<std::string> srcDBContexts;
+   std::vector<boost::shared_ptr<r_util::RSourceIndex> > indexes =
+                                                   rSourceIndex().indexes();
+   BOOST_FOREACH(boost::shared_ptr<r_util::RSourceIndex>& pIndex, indexes)
+   {
+      // apply the filter
+      if (!sourceDatabaseFilter(*pIndex))
+         continue;
+
+      srcDBContexts.insert(pIndex->context());
+      appendReferences(*pIndex,
+                       term,
+                       kMaxReferenceResults,
+                       &refs,
+                       &moreAvailable);
+      if (moreAvailable)
+         break;
+   }
+
+   // now the project-wide reverse-reference index
+   if (!moreAvailable)
+   {
+      s_projectIndex.findReferences(term,
+                                    srcDBContexts,
+                                    kMaxReferenceResults,
+                                    &refs,
+                                    &moreAvailable);
+   }
+
+   // return rpc array list (wire efficiency)
+   json::Array contexts, lines, columns;
+   BOOST_FOREACH(const SymbolReference& ref, refs)
+   {
+      contexts.push_back(ref.context);
+      lines.push_back(ref.line);
+      columns.push_back(ref.column);
+   }
+
+   json::Object result;
+   result["context"] = contexts;
+   result["line"] = lines;
+   result["column"] = columns;
+   result["more_available"] = moreAvailable;
+   pResponse->setResult(result);
+
+   return Success();
+}
+
+Error searchAllProjects(const json::JsonRpcRequest& request,
+                        json::JsonRpcResponse* pResponse)
+{
+   // get params
+   std::string term;
+   Error error = json::readParams(request.params, &term);
+   if (error)
+      return error;
+
+   // consult every deposited federation index; projects whose bloom
+   // filter rules the symbol out cost one 8KB filter read
+   std::vector<FederatedSymbol> symbols;
+   FilePath indexDir = federationIndexDir();
+   if (indexDir.exists())
+   {
+      std::vector<FilePath> indexFiles;
+      error = indexDir.children(&indexFiles);
+      if (error)
+         return error;
+
+      BOOST_FOREACH(const FilePath& indexFile, indexFiles)
+      {
+         searchFederationIndex(indexFile, term, &symbols);
+      }
+   }
+
+   // merge into a stable order (by project, then file, then line)
+   std::sort(symbols.begin(), symbols.end(), federatedSymbolLessThan);
+
+   // return rpc array list (wire efficiency)
+   json::Array names, types, projectDirs, contexts, lines, columns;
+   BOOST_FOREACH(const FederatedSymbol& symbol, symbols)
+   {
+      names.push_back(symbol.name);
+      types.push_back(symbol.type);
+      projectDirs.push_back(symbol.project);
+      contexts.push_back(symbol.context);
+      lines.push_back(symbol.line);
+      columns.push_back(symbol.column);
+   }
+
+   json::Object result;
+   result["name"] = names;
+   result["type"] = types;
+   result["project"] = projectDirs;
+   result["context"] = contexts;
+   result["line"] = lines;
+   result["column"] = columns;
+   pResponse->setResult(result);
+
+   return Success();
+}
+
 
 bool namespaceIsPackage(const std::string& namespaceName,
                         std::string* pPackage)
@@ -2500,6 +3900,8 @@ Error initialize()
    ExecBlock initBlock ;
    initBlock.addFunctions()
       (bind(registerRpcMethod, "search_code", searchCode))
+      (bind(registerRpcMethod, "find_references", findReferences))
+      (bind(registerRpcMethod, "search_all_projects", searchAllProjects))
       (bind(registerRpcMethod, "get_function_definition", getFunctionDefinition))
       (bind(registerRpcMethod, "get_search_path_function_definition", getSearchPathFunctionDefinition))
       (bind(registerRpcMethod, "get_method_definition", getMethodDefinition))
@@ -0,0 +1,228 @@
+/*
+ * SessionCompletionUsage.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionCompletionUsage.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <core/Error.hpp>
+#include <core/Exec.hpp>
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/SafeConvert.hpp>
+
+#include <core/json/JsonRpc.hpp>
+
+#include <r/RRoutines.hpp>
+#include <r/RSexp.hpp>
+
+#include <session/SessionModuleContext.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace completion_usage {
+
+namespace {
+
+// cap on the number of symbols we persist (the least used symbols are
+// dropped first)
+const std::size_t kMaxPersistedSymbols = 2000;
+
+// symbol -> acceptance count
+typedef boost::unordered_map<std::string,int> UsageMap;
+UsageMap s_usage;
+
+// whether we have unsaved changes
+bool s_dirty = false;
+
+FilePath usageFilePath()
+{
+   return module_context::scopedScratchPath().complete("completion-usage");
+}
+
+void loadUsage()
+{
+   FilePath usagePath = usageFilePath();
+   if (!usagePath.exists())
+      return;
+
+   std::vector<std::string> lines;
+   Error error = core::readStringVectorFromFile(usagePath, &lines);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   BOOST_FOREACH(const std::string& line, lines)
+   {
+      // lines are of the form <count>\t<symbol>
+      std::string::size_type tabPos = line.find('\t');
+      if (tabPos == std::string::npos)
+         continue;
+
+      int count = safe_convert::stringTo<int>(line.substr(0, tabPos), 0);
+      std::string symbol = line.substr(tabPos + 1);
+      if (count > 0 && !symbol.empty())
+         s_usage[symbol] = count;
+   }
+}
+
+bool usageGreater(const std::pair<std::string,int>& lhs,
+                  const std::pair<std::string,int>& rhs)
+{
+   return lhs.second > rhs.second;
+}
+
+void saveUsage()
+{
+   if (!s_dirty)
+      return;
+
+   // persist the most used symbols (bounding the size of the store)
+   std::vector<std::pair<std::string,int> > usage(s_usage.begin(),
+                                                  s_usage.end());
+   if (usage.size() > kMaxPersistedSymbols)
+   {
+      std::partial_sort(usage.begin(),
+                        usage.begin() + kMaxPersistedSymbols,
+                        usage.end(),
+                        usageGreater);
+      usage.resize(kMaxPersistedSymbols);
+   }
+
+   std::vector<std::string> lines;
+   lines.reserve(usage.size());
+   for (std::size_t i = 0; i < usage.size(); i++)
+   {
+      lines.push_back(safe_convert::numberToString(usage[i].second) +
+                      "\t" +
+                      usage[i].first);
+   }
+
+   Error error = core::writeStringVectorToFile(usageFilePath(), lines);
+   if (error)
+      LOG_ERROR(error);
+   else
+      s_dirty = false;
+}
+
+void onSuspend(core::Settings*)
+{
+   saveUsage();
+}
+
+void onResume(const core::Settings&)
+{
+}
+
+void onShutdown(bool)
+{
+   saveUsage();
+}
+
+Error recordCompletionUsage(const json::JsonRpcRequest& request,
+                            json::JsonRpcResponse* pResponse)
+{
+   std::string symbol;
+   Error error = json::readParams(request.params, &symbol);
+   if (error)
+      return error;
+
+   recordUsage(symbol);
+
+   return Success();
+}
+
+SEXP rs_recordCompletionUsage(SEXP symbolSEXP)
+{
+   recordUsage(r::sexp::safeAsString(symbolSEXP));
+   return R_NilValue;
+}
+
+SEXP rs_getCompletionUsage(SEXP symbolsSEXP)
+{
+   std::vector<std::string> symbols;
+   if (!r::sexp::fillVectorString(symbolsSEXP, &symbols))
+      return R_NilValue;
+
+   std::vector<int> counts;
+   counts.reserve(symbols.size());
+   for (std::size_t i = 0; i < symbols.size(); i++)
+      counts.push_back(usageCount(symbols[i]));
+
+   r::sexp::Protect protect;
+   return r::sexp::create(counts, &protect);
+}
+
+} // anonymous namespace
+
+void recordUsage(const std::string& symbol)
+{
+   if (symbol.empty())
+      return;
+
+   s_usage[symbol]++;
+   s_dirty = true;
+}
+
+int usageCount(const std::string& symbol)
+{
+   UsageMap::const_iterator it = s_usage.find(symbol);
+   return (it != s_usage.end()) ? it->second : 0;
+}
+
+Error initialize()
+{
+   using boost::bind;
+   using namespace module_context;
+
+   // restore the persisted store
+   loadUsage();
+
+   // persist on suspend and shutdown
+   addSuspendHandler(SuspendHandler(bind(onSuspend, _2), onResume));
+   events().onShutdown.connect(onShutdown);
+
+   // register call methods
+   r::routines::registerCallMethod(
+            "rs_recordCompletionUsage",
+            (DL_FUNC) rs_recordCompletionUsage,
+            1);
+
+   r::routines::registerCallMethod(
+            "rs_getCompletionUsage",
+            (DL_FUNC) rs_getCompletionUsage,
+            1);
+
+   ExecBlock initBlock;
+   initBlock.addFunctions()
+      (bind(registerRpcMethod, "record_completion_usage", recordCompletionUsage));
+
+   return initBlock.execute();
+}
+
+} // namespace completion_usage
+} // namespace modules
+} // namespace session
+} // namespace rstudio
@@ -0,0 +1,46 @@
+/*
+ * SessionCompletionUsage.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SESSION_COMPLETION_USAGE_HPP
+#define SESSION_COMPLETION_USAGE_HPP
+
+#include <string>
+
+namespace rstudio {
+namespace core {
+   class Error;
+}
+}
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace completion_usage {
+
+// record that the user accepted a completion for the given symbol
+void recordUsage(const std::string& symbol);
+
+// number of times the user has accepted a completion for the given
+// symbol (O(1) -- suitable for consulting during completion ranking)
+int usageCount(const std::string& symbol);
+
+core::Error initialize();
+
+} // namespace completion_usage
+} // namespace modules
+} // namespace session
+} // namespace rstudio
+
+#endif // SESSION_COMPLETION_USAGE_HPP
@@ -174,7 +174,7 @@ Error initialize()
    using boost::bind;
    using namespace module_context;
    events().onClientInit.connect(bind(onClientInit));
-   events().onDetectChanges.connect(bind(onDetectChanges, _1));
+   registerChangeDetection("console", bind(onDetectChanges, _1));
 
    rmarkdown::notebook::events().onChunkExecCompleted.connect(
          bind(onChunkExecCompleted));
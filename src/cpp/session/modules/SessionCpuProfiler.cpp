@@ -0,0 +1,329 @@
+/*
+ * SessionCpuProfiler.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+// Sampled CPU self-profiler for the rsession process. a SIGPROF-driven
+// sampler captures the native stack (via backtrace) and the R context
+// stack (by walking the raw RCNTXT chain, the same approach R's own
+// Rprof takes) into preallocated buffers, and a pair of diagnostics
+// RPCs (start_cpu_profile / stop_cpu_profile) control it and render the
+// aggregated samples as flame-graph-friendly JSON -- so support can
+// diagnose a slow session without shell access to the box.
+
+#include "SessionCpuProfiler.hpp"
+
+#include <cstring>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/time.h>
+#include <execinfo.h>
+#include <dlfcn.h>
+#endif
+
+#include <map>
+#include <vector>
+
+#include <boost/bind.hpp>
+
+#include <core/Error.hpp>
+#include <core/Exec.hpp>
+#include <core/Log.hpp>
+#include <core/json/JsonRpc.hpp>
+
+#define R_INTERNAL_FUNCTIONS
+#include <r/RInternal.hpp>
+#include <r/RInterface.hpp>
+#include <r/RCntxtUtils.hpp>
+
+#include <session/SessionModuleContext.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace cpu_profiler {
+
+namespace {
+
+#ifndef _WIN32
+
+// sampling parameters. storage is preallocated at start (the signal
+// handler can't allocate) so the sample count is bounded -- at the
+// default 10ms interval kMaxSamples covers six minutes of profiling
+const int kDefaultIntervalMillis = 10;
+const int kMaxNativeFrames = 32;
+const int kMaxRStackBytes = 512;
+const int kMaxSamples = 36000;
+
+struct Sample
+{
+   int numNativeFrames;
+   void* nativeFrames[kMaxNativeFrames];
+
+   // ';' delimited R function names, innermost first
+   char rStack[kMaxRStackBytes];
+};
+
+// profiler state. s_profilerActive gates the handler; samples are only
+// read back after the itimer has been stopped and the handler disarmed
+volatile sig_atomic_t s_profilerActive = 0;
+volatile sig_atomic_t s_sampleCount = 0;
+Sample* s_samples = NULL;
+int s_intervalMillis = kDefaultIntervalMillis;
+r::context::RCntxtVersion s_cntxtVersion = r::context::RVersionUnknown;
+struct sigaction s_oldSigAction;
+
+// append a frame name to the sample's R stack buffer
+// (async-signal-safe: bounded copies into preallocated storage)
+void appendRFrame(char* buffer, std::size_t size, const char* name)
+{
+   std::size_t pos = ::strlen(buffer);
+   std::size_t len = ::strlen(name);
+   if (pos + len + 2 > size)
+      return;
+   if (pos > 0)
+      buffer[pos++] = ';';
+   ::memcpy(buffer + pos, name, len);
+   buffer[pos + len] = '\0';
+}
+
+// walk the raw RCNTXT chain recording function names, innermost first.
+// this mirrors what R's Rprof handler does: plain reads of the context
+// structs and symbol printnames, no allocation. the struct layout is
+// version dependent so the walker is templated on it (see RIntCntxt)
+template <typename T>
+void captureRStack(void* rawCntxt, char* buffer, std::size_t size)
+{
+   for (const T* pCntxt = static_cast<const T*>(rawCntxt);
+        pCntxt != NULL;
+        pCntxt = pCntxt->nextcontext)
+   {
+      if (!(pCntxt->callflag & (CTXT_FUNCTION | CTXT_BUILTIN)))
+         continue;
+
+      SEXP call = pCntxt->call;
+      if (call == NULL || TYPEOF(call) != LANGSXP)
+         continue;
+
+      SEXP fun = CAR(call);
+      if (fun != NULL && TYPEOF(fun) == SYMSXP)
+         appendRFrame(buffer, size, CHAR(PRINTNAME(fun)));
+      else
+         appendRFrame(buffer, size, "<anonymous>");
+   }
+}
+
+void profilerSignalHandler(int)
+{
+   if (!s_profilerActive)
+      return;
+
+   int index = s_sampleCount;
+   if (index >= kMaxSamples)
+      return;
+
+   Sample& sample = s_samples[index];
+   sample.numNativeFrames = ::backtrace(sample.nativeFrames,
+                                        kMaxNativeFrames);
+
+   sample.rStack[0] = '\0';
+   void* rawCntxt = r::getGlobalContext();
+   if (rawCntxt != NULL)
+   {
+      if (s_cntxtVersion == r::context::RVersion34)
+         captureRStack<RCNTXT_34>(rawCntxt, sample.rStack, kMaxRStackBytes);
+      else if (s_cntxtVersion == r::context::RVersion33)
+         captureRStack<RCNTXT_33>(rawCntxt, sample.rStack, kMaxRStackBytes);
+      else
+         captureRStack<RCNTXT_32>(rawCntxt, sample.rStack, kMaxRStackBytes);
+   }
+
+   // publish the sample (the handler is the only writer)
+   s_sampleCount = index + 1;
+}
+
+std::string nativeFrameName(void* address)
+{
+   Dl_info info;
+   if (::dladdr(address, &info) != 0 && info.dli_sname != NULL)
+      return std::string(info.dli_sname);
+
+   char buffer[32];
+   ::snprintf(buffer, sizeof(buffer), "%p", address);
+   return std::string(buffer);
+}
+
+Error startCpuProfile(const json::JsonRpcRequest& request,
+                      json::JsonRpcResponse* pResponse)
+{
+   int intervalMillis = kDefaultIntervalMillis;
+   Error error = json::readParams(request.params, &intervalMillis);
+   if (error)
+      return error;
+   if (intervalMillis < 1)
+      intervalMillis = kDefaultIntervalMillis;
+
+   if (s_profilerActive)
+      return systemError(boost::system::errc::device_or_resource_busy,
+                         ERROR_LOCATION);
+
+   // latch the context layout version now (determining it calls into R
+   // so it can't be done inside the signal handler)
+   s_cntxtVersion = r::context::contextVersion();
+
+   // allocate sample storage
+   if (s_samples == NULL)
+      s_samples = new Sample[kMaxSamples];
+   s_sampleCount = 0;
+   s_intervalMillis = intervalMillis;
+
+   // install the handler
+   struct sigaction sa;
+   ::memset(&sa, 0, sizeof(sa));
+   sa.sa_handler = profilerSignalHandler;
+   ::sigemptyset(&sa.sa_mask);
+   sa.sa_flags = SA_RESTART;
+   if (::sigaction(SIGPROF, &sa, &s_oldSigAction) != 0)
+      return systemError(errno, ERROR_LOCATION);
+
+   s_profilerActive = 1;
+
+   // start the profiling timer (fires on cpu time consumed, so an idle
+   // session produces no samples)
+   struct itimerval timer;
+   timer.it_interval.tv_sec = intervalMillis / 1000;
+   timer.it_interval.tv_usec = (intervalMillis % 1000) * 1000;
+   timer.it_value = timer.it_interval;
+   if (::setitimer(ITIMER_PROF, &timer, NULL) != 0)
+   {
+      s_profilerActive = 0;
+      ::sigaction(SIGPROF, &s_oldSigAction, NULL);
+      return systemError(errno, ERROR_LOCATION);
+   }
+
+   return Success();
+}
+
+Error stopCpuProfile(const json::JsonRpcRequest& /*request*/,
+                     json::JsonRpcResponse* pResponse)
+{
+   if (!s_profilerActive)
+      return systemError(boost::system::errc::operation_not_permitted,
+                         ERROR_LOCATION);
+
+   // stop the timer then disarm and restore the handler
+   struct itimerval timer;
+   ::memset(&timer, 0, sizeof(timer));
+   ::setitimer(ITIMER_PROF, &timer, NULL);
+   s_profilerActive = 0;
+   ::sigaction(SIGPROF, &s_oldSigAction, NULL);
+
+   // aggregate identical stacks; each key is the full combined stack,
+   // root first, R frames then native frames (the flame graph reads
+   // bottom-up)
+   int sampleCount = s_sampleCount;
+   std::map<std::vector<std::string>, int> stackCounts;
+   for (int i = 0; i < sampleCount; i++)
+   {
+      const Sample& sample = s_samples[i];
+      std::vector<std::string> frames;
+
+      // R frames were recorded innermost first -- reverse to root first
+      std::vector<std::string> rFrames;
+      const char* pName = sample.rStack;
+      while (*pName != '\0')
+      {
+         const char* pEnd = ::strchr(pName, ';');
+         if (pEnd == NULL)
+            pEnd = pName + ::strlen(pName);
+         rFrames.push_back(std::string(pName, pEnd));
+         pName = (*pEnd == ';') ? pEnd + 1 : pEnd;
+      }
+      frames.insert(frames.end(), rFrames.rbegin(), rFrames.rend());
+
+      // native frames from backtrace are innermost first as well; skip
+      // the first two (the signal handler and trampoline)
+      for (int j = sample.numNativeFrames - 1; j >= 2; j--)
+         frames.push_back(nativeFrameName(sample.nativeFrames[j]));
+
+      stackCounts[frames]++;
+   }
+
+   // render flame-graph-friendly json
+   json::Array stacksJson;
+   for (std::map<std::vector<std::string>, int>::const_iterator
+            it = stackCounts.begin(); it != stackCounts.end(); ++it)
+   {
+      json::Array framesJson;
+      for (std::size_t i = 0; i < it->first.size(); i++)
+         framesJson.push_back(it->first[i]);
+
+      json::Object stackJson;
+      stackJson["frames"] = framesJson;
+      stackJson["count"] = it->second;
+      stacksJson.push_back(stackJson);
+   }
+
+   json::Object resultJson;
+   resultJson["interval_millis"] = s_intervalMillis;
+   resultJson["sample_count"] = sampleCount;
+   resultJson["max_samples_reached"] = (sampleCount >= kMaxSamples);
+   resultJson["stacks"] = stacksJson;
+   pResponse->setResult(resultJson);
+
+   // release sample storage (profiles are an exceptional activity, no
+   // sense holding tens of megabytes between them)
+   delete [] s_samples;
+   s_samples = NULL;
+
+   return Success();
+}
+
+#else // _WIN32
+
+// no itimer/SIGPROF on windows -- the rpcs report not-supported
+
+Error startCpuProfile(const json::JsonRpcRequest& /*request*/,
+                      json::JsonRpcResponse* /*pResponse*/)
+{
+   return systemError(boost::system::errc::not_supported, ERROR_LOCATION);
+}
+
+Error stopCpuProfile(const json::JsonRpcRequest& /*request*/,
+                     json::JsonRpcResponse* /*pResponse*/)
+{
+   return systemError(boost::system::errc::not_supported, ERROR_LOCATION);
+}
+
+#endif
+
+} // anonymous namespace
+
+Error initialize()
+{
+   using boost::bind;
+   using namespace module_context;
+   ExecBlock initBlock;
+   initBlock.addFunctions()
+      (bind(registerRpcMethod, "start_cpu_profile", startCpuProfile))
+      (bind(registerRpcMethod, "stop_cpu_profile", stopCpuProfile));
+   return initBlock.execute();
+}
+
+} // namespace cpu_profiler
+} // namespace modules
+} // namespace session
+} // namespace rstudio
@@ -632,6 +632,62 @@ void setFileLocalParseOptions(const std::wstring& rCode,
    applyOptions(options, pOptions);
 }
 
+// cached parse state for open documents -- used so that subsequent lint
+// requests for a document need only re-parse the changed portion, and
+// so that requests for unchanged documents (e.g. on focus changes) can
+// be served without re-running the lint pipeline at all
+struct LintCacheEntry
+{
+   LintCacheEntry() : hasFinishedLint(false) {}
+
+   std::wstring code;
+   ParseResults results;
+   std::string signature;
+
+   // the complete set of lint produced for 'code', including lint
+   // appended by whole-document passes after parsing
+   LintItems finishedLint;
+   bool hasFinishedLint;
+};
+
+typedef std::map<std::string, LintCacheEntry> LintCache;
+
+LintCache& lintCache()
+{
+   static LintCache instance;
+   return instance;
+}
+
+// cached results are only reusable if the parse options they were
+// generated with still apply
+std::string parseOptionsSignature(const ParseOptions& options)
+{
+   std::string signature;
+   signature.push_back(options.lintRFunctions() ? '1' : '0');
+   signature.push_back(options.checkArgumentsToRFunctionCalls() ? '1' : '0');
+   signature.push_back(options.warnIfNoSuchVariableInScope() ? '1' : '0');
+   signature.push_back(options.warnIfVariableIsDefinedButNotUsed() ? '1' : '0');
+   signature.push_back(options.recordStyleLint() ? '1' : '0');
+
+   BOOST_FOREACH(const std::string& global, options.globals())
+   {
+      signature.push_back(';');
+      signature.append(global);
+   }
+
+   return signature;
+}
+
+void onDocRemoved(const std::string& id, const std::string& path)
+{
+   lintCache().erase(id);
+}
+
+void onDocsRemoved()
+{
+   lintCache().clear();
+}
+
 } // end anonymous namespace
 
 ParseResults parse(const std::wstring& rCode,
@@ -661,9 +717,45 @@ ParseResults parse(const std::wstring& rCode,
    setFileLocalParseOptions(rCode, &options, &noLint);
    if (noLint)
       return ParseResults();
-   
-   results = rparser::parse(origin, rCode, options);
-   
+
+   // if we have cached results for this document (and the parse options
+   // haven't changed in the interim), re-parse only the changed portion
+   // of the document
+   std::string signature = parseOptionsSignature(options);
+   LintCache::iterator it = documentId.empty()
+         ? lintCache().end()
+         : lintCache().find(documentId);
+
+   if (it != lintCache().end() && it->second.signature == signature)
+   {
+      // if the document contents are unchanged, serve the finished lint
+      // directly from the cache
+      if (it->second.hasFinishedLint && it->second.code == rCode)
+      {
+         ParseResults finished = it->second.results;
+         finished.lint() = it->second.finishedLint;
+         return finished;
+      }
+
+      results = rparser::parseIncremental(
+               origin, rCode, it->second.code, it->second.results, options);
+   }
+   else
+   {
+      results = rparser::parse(origin, rCode, options);
+   }
+
+   // cache the results for the next lint request on this document
+   // (before any whole-document passes append their own lint)
+   if (!documentId.empty())
+   {
+      LintCacheEntry& entry = lintCache()[documentId];
+      entry.code = rCode;
+      entry.results = results;
+      entry.signature = signature;
+      entry.hasFinishedLint = false;
+   }
+
    ParseNode* pRoot = results.parseTree();
    if (!pRoot)
    {
@@ -683,10 +775,19 @@ ParseResults parse(const std::wstring& rCode,
    
    if (options.warnIfNoSuchVariableInScope())
       checkNoDefinitionInScope(origin, documentId, results);
-   
+
    if (options.warnIfVariableIsDefinedButNotUsed())
       checkDefinedButNotUsed(results);
-   
+
+   // cache the finished lint so that requests for this exact document
+   // state can be served without re-running the whole-document passes
+   if (!documentId.empty())
+   {
+      LintCacheEntry& entry = lintCache()[documentId];
+      entry.finishedLint = results.lint();
+      entry.hasFinishedLint = true;
+   }
+
    return results;
 }
 
@@ -1030,7 +1131,10 @@ core::Error initialize()
    using namespace module_context;
    
    events().afterSessionInitHook.connect(afterSessionInitHook);
-   
+
+   source_database::events().onDocRemoved.connect(onDocRemoved);
+   source_database::events().onRemoveAll.connect(onDocsRemoved);
+
    session::projects::FileMonitorCallbacks cb;
    cb.onFilesChanged = onFilesChanged;
    projects::projectContext().subscribeToFileMonitor("Diagnostics", cb);
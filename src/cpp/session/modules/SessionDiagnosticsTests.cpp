@@ -275,7 +275,45 @@ context("Diagnostics")
       
       EXPECT_NO_LINT("function() { i <- 1; function() { data[i] } }");
    }
-   
+
+   test_that("an incremental reparse matches a full parse")
+   {
+      std::wstring previousCode = string_utils::utf8ToWide(
+               "x <- 1\n"
+               "y <- x + 2\n"
+               "print(y)\n");
+
+      std::wstring code = string_utils::utf8ToWide(
+               "x <- 1\n"
+               "y <- x + 10\n"
+               "z <- y\n"
+               "print(z)\n");
+
+      ParseResults previousResults =
+            parse(FilePath(), previousCode, s_parseOptions);
+
+      ParseResults incrementalResults = parseIncremental(
+               FilePath(), code, previousCode, previousResults, s_parseOptions);
+
+      ParseResults fullResults = parse(FilePath(), code, s_parseOptions);
+
+      const std::vector<LintItem>& incrementalLint =
+            incrementalResults.lint().get();
+
+      const std::vector<LintItem>& fullLint = fullResults.lint().get();
+
+      expect_true(incrementalLint.size() == fullLint.size());
+      for (std::size_t i = 0, n = fullLint.size(); i < n; ++i)
+      {
+         expect_true(incrementalLint[i].startRow == fullLint[i].startRow);
+         expect_true(incrementalLint[i].startColumn == fullLint[i].startColumn);
+         expect_true(incrementalLint[i].message == fullLint[i].message);
+      }
+
+      expect_true(incrementalResults.parseTree()->getDefinedSymbols().size() ==
+                  fullResults.parseTree()->getDefinedSymbols().size());
+   }
+
    lintRStudioRFiles();
 }
 
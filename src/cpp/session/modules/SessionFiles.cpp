@@ -18,6 +18,7 @@
 
 #include <csignal>
 
+#include <map>
 #include <vector>
 #include <iostream>
 #include <fstream>
@@ -26,6 +27,9 @@
 
 #include <boost/foreach.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/classification.hpp>
 
 #include <core/Error.hpp>
 #include <core/Log.hpp>
@@ -33,13 +37,17 @@
 #include <core/FilePath.hpp>
 #include <core/FileInfo.hpp>
 #include <core/FileUtils.hpp>
+#include <core/SafeConvert.hpp>
 #include <core/Settings.hpp>
+#include <core/StringUtils.hpp>
 #include <core/Exec.hpp>
 #include <core/DateTime.hpp>
+#include <core/ZipWriter.hpp>
 
 #include <core/http/Util.hpp>
 #include <core/http/Request.hpp>
 #include <core/http/Response.hpp>
+#include <core/http/MultipartStreamParser.hpp>
 
 #include <core/json/Json.hpp>
 
@@ -48,6 +56,7 @@
 #include <core/system/RecycleBin.hpp>
 #ifndef _WIN32
 #include <core/system/FileMode.hpp>
+#include <core/system/MemoryMappedFile.hpp>
 #endif
 
 #include <r/RSexp.hpp>
@@ -56,7 +65,9 @@
 #include <r/RErrorCategory.hpp>
 
 #include <session/SessionClientEvent.hpp>
+#include <session/SessionConstants.hpp>
 #include <session/SessionModuleContext.hpp>
+#include <session/SessionWorkerContext.hpp>
 #include <session/SessionOptions.hpp>
 #include <session/SessionSourceDatabase.hpp>
 
@@ -64,6 +75,7 @@
 
 #include "SessionFilesQuotas.hpp"
 #include "SessionFilesListingMonitor.hpp"
+#include "SessionVCS.hpp"
 
 using namespace rstudio::core ;
 
@@ -232,7 +244,7 @@ Error listFiles(const json::JsonRpcRequest& request, json::JsonRpcResponse* pRes
          return error;
    }
 
-   result["files"] = jsonFiles;
+   result["files"] = std::move(jsonFiles);
 
    bool browseable = true;
 
@@ -245,7 +257,217 @@ Error listFiles(const json::JsonRpcRequest& request, json::JsonRpcResponse* pRes
 
    result["is_parent_browseable"] = browseable;
 
-   pResponse->setResult(result);
+   pResponse->setResult(std::move(result));
+   return Success();
+}
+
+// ordering for paged listings: primary key per the requested sort
+// column with the (unique) path as tie-breaker, so the ordering is
+// strict and a cursor taken from the last row of a page is monotone
+// even while the directory is being modified
+class FileSortOrder
+{
+public:
+   FileSortOrder(const std::string& sortBy, bool ascending)
+      : sortBy_(sortBy), ascending_(ascending)
+   {
+   }
+
+   bool operator()(const core::FileInfo& a, const core::FileInfo& b) const
+   {
+      return less(numberKey(a), textKey(a), a.absolutePath(),
+                  numberKey(b), textKey(b), b.absolutePath());
+   }
+
+   // does the given entry fall after the cursor position?
+   bool afterCursor(const std::string& cursorKey,
+                    const std::string& cursorPath,
+                    const core::FileInfo& fileInfo) const
+   {
+      long long cursorNumber = 0;
+      std::string cursorText;
+      if (sortBy_ == "name")
+         cursorText = cursorKey;
+      else
+         cursorNumber = safe_convert::stringTo<long long>(cursorKey, 0);
+
+      return less(cursorNumber, cursorText, cursorPath,
+                  numberKey(fileInfo), textKey(fileInfo),
+                  fileInfo.absolutePath());
+   }
+
+   // serializable form of the entry's sort key
+   std::string keyOf(const core::FileInfo& fileInfo) const
+   {
+      if (sortBy_ == "name")
+         return textKey(fileInfo);
+      else
+         return safe_convert::numberToString(numberKey(fileInfo));
+   }
+
+private:
+   long long numberKey(const core::FileInfo& fileInfo) const
+   {
+      if (sortBy_ == "size")
+         return fileInfo.size();
+      else if (sortBy_ == "modified")
+         return fileInfo.lastWriteTime();
+      else
+         return 0;
+   }
+
+   std::string textKey(const core::FileInfo& fileInfo) const
+   {
+      if (sortBy_ == "name")
+         return string_utils::toLower(fileInfo.absolutePath());
+      else
+         return std::string();
+   }
+
+   bool less(long long number1, const std::string& text1,
+             const std::string& path1,
+             long long number2, const std::string& text2,
+             const std::string& path2) const
+   {
+      if (number1 != number2)
+         return ascending_ ? (number1 < number2) : (number2 < number1);
+      if (text1 != text2)
+         return ascending_ ? (text1 < text2) : (text2 < text1);
+
+      // tie-break on the path (always ascending -- uniqueness is what
+      // matters here, not direction)
+      return path1 < path2;
+   }
+
+   std::string sortBy_;
+   bool ascending_;
+};
+
+// IN: String path, String sortBy ("name" | "size" | "modified"),
+//     Bool ascending, Number pageSize, Object|Null cursor, Bool monitor
+// OUT: Object with files (the requested page), total_count, more,
+//      cursor (pass back to fetch the next page) and
+//      is_parent_browseable
+Error listFilesPaged(const json::JsonRpcRequest& request,
+                     json::JsonRpcResponse* pResponse)
+{
+   // get args
+   std::string path, sortBy;
+   bool ascending, monitor;
+   int pageSize;
+   json::Value cursorValue;
+   Error error = json::readParams(request.params,
+                                  &path,
+                                  &sortBy,
+                                  &ascending,
+                                  &pageSize,
+                                  &cursorValue,
+                                  &monitor);
+   if (error)
+      return error;
+   FilePath targetPath = module_context::resolveAliasedPath(path) ;
+
+   // keep page sizes sane
+   if (pageSize < 1)
+      pageSize = 1;
+   else if (pageSize > 5000)
+      pageSize = 5000;
+
+   // extract the cursor (if any)
+   std::string cursorKey, cursorPath;
+   bool haveCursor = false;
+   if (cursorValue.type() == json::ObjectType)
+   {
+      error = json::readObject(cursorValue.get_obj(),
+                               "key", &cursorKey,
+                               "path", &cursorPath);
+      if (error)
+         return error;
+      haveCursor = true;
+   }
+
+   // if this includes a request for monitoring then start it without
+   // building a full json listing (changes stream to the client as
+   // file-changed deltas, so no relist is required)
+   if (monitor)
+   {
+      s_filesListingMonitor.stop();
+      if (!session::projects::projectContext().isMonitoringDirectory(targetPath))
+      {
+         error = s_filesListingMonitor.start(targetPath);
+         if (error)
+            return error;
+      }
+   }
+
+   // enumerate and screen to end-user visible entries
+   std::vector<FileInfo> allEntries;
+   error = FilesListingMonitor::enumerateFiles(targetPath, &allEntries);
+   if (error)
+      return error;
+   std::vector<FileInfo> entries;
+   BOOST_FOREACH(const FileInfo& fileInfo, allEntries)
+   {
+      if (module_context::fileListingFilter(fileInfo))
+         entries.push_back(fileInfo);
+   }
+
+   // server-side sort
+   FileSortOrder sortOrder(sortBy, ascending);
+   std::sort(entries.begin(), entries.end(), sortOrder);
+
+   // produce json for the requested page only (in particular, source
+   // control decoration is applied just to the rows actually returned)
+   using namespace source_control;
+   boost::shared_ptr<FileDecorationContext> pCtx =
+                  source_control::fileDecorationContext(targetPath);
+
+   json::Array jsonFiles;
+   std::size_t index = 0;
+   for (; index < entries.size(); index++)
+   {
+      const FileInfo& fileInfo = entries[index];
+      if (haveCursor && !sortOrder.afterCursor(cursorKey, cursorPath, fileInfo))
+         continue;
+      if (jsonFiles.size() >= static_cast<std::size_t>(pageSize))
+         break;
+
+      json::Object fileObject = module_context::createFileSystemItem(fileInfo);
+      pCtx->decorateFile(FilePath(fileInfo.absolutePath()), &fileObject);
+      jsonFiles.push_back(std::move(fileObject));
+   }
+
+   json::Object result;
+   result["files"] = std::move(jsonFiles);
+   result["total_count"] = static_cast<int>(entries.size());
+
+   bool more = index < entries.size();
+   result["more"] = more;
+   if (more && index > 0)
+   {
+      const FileInfo& lastEntry = entries[index - 1];
+      json::Object cursor;
+      cursor["key"] = sortOrder.keyOf(lastEntry);
+      cursor["path"] = lastEntry.absolutePath();
+      result["cursor"] = cursor;
+   }
+   else
+   {
+      result["cursor"] = json::Value();
+   }
+
+   bool browseable = true;
+
+#ifndef _WIN32
+   // on *nix systems, see if browsing above this path is possible
+   error = core::system::isFileReadable(targetPath.parent(), &browseable);
+   if (error && !core::isPathNotFoundError(error))
+      LOG_ERROR(error);
+#endif
+
+   result["is_parent_browseable"] = browseable;
+
+   pResponse->setResult(std::move(result));
    return Success();
 }
 
@@ -284,7 +506,7 @@ core::Error deleteFile(const FilePath& filePath)
       if (error)
       {
          LOG_ERROR(error);
-         return filePath.remove();
+         return file_utils::removeParallel(filePath);
       }
       else
       {
@@ -293,7 +515,7 @@ core::Error deleteFile(const FilePath& filePath)
    }
    else
    {
-      return filePath.remove();
+      return file_utils::removeParallel(filePath);
    }
 }
 
@@ -369,7 +591,8 @@ Error copyFile(const core::json::JsonRpcRequest& request,
    Error copyError ;
    if (sourceFilePath.isDirectory())
    {
-      copyError = file_utils::copyDirectory(sourceFilePath, targetFilePath);
+      copyError = file_utils::copyDirectoryParallel(sourceFilePath,
+                                                    targetFilePath);
    }
    else
    {
@@ -644,13 +867,250 @@ bool validateUploadedFile(const http::File& file, http::Response* pResponse)
    }
 }
    
-void handleFileUploadRequest(const http::Request& request, 
-                             http::Response* pResponse) 
+// multipart handler for upload bodies which were streamed to disk: the
+// "file" part is written directly to its destination temp file (with the
+// upload size limit enforced incrementally) and only the small form
+// fields are accumulated in memory
+class StreamedUploadHandler : public http::MultipartHandler
+{
+public:
+   StreamedUploadHandler()
+      : byteLimit_(0), fileBytes_(0), fileTooLarge_(false), isFilePart_(false)
+   {
+      size_t mbLimit = session::options().limitFileUploadSizeMb();
+      if (mbLimit > 0)
+         byteLimit_ = mbLimit * 1024 * 1024;
+   }
+
+   void onPartBegin(const std::string& name, const std::string& filename)
+   {
+      isFilePart_ = (name == "file");
+      if (isFilePart_)
+      {
+         filename_ = filename;
+         bool isZip = boost::algorithm::iends_with(filename, ".zip");
+         tempFilePath_ = module_context::tempFile("upload",
+                                                  isZip ? "zip" : "bin");
+         Error error = tempFilePath_.open_w(&pFileStream_);
+         if (error)
+         {
+            LOG_ERROR(error);
+            writeError_ = error;
+         }
+      }
+      else
+      {
+         fieldName_ = name;
+         fieldValue_.clear();
+      }
+   }
+
+   void onPartData(const char* pData, std::size_t length)
+   {
+      if (isFilePart_)
+      {
+         fileBytes_ += length;
+         if (byteLimit_ > 0 && fileBytes_ > byteLimit_)
+         {
+            fileTooLarge_ = true;
+            return;
+         }
+
+         if (pFileStream_)
+            pFileStream_->write(pData, length);
+      }
+      else
+      {
+         fieldValue_.append(pData, length);
+      }
+   }
+
+   void onPartEnd()
+   {
+      if (isFilePart_)
+         pFileStream_.reset();
+      else
+         fields_[fieldName_] = fieldValue_;
+   }
+
+   const std::string& filename() const { return filename_; }
+   const FilePath& tempFilePath() const { return tempFilePath_; }
+   const Error& writeError() const { return writeError_; }
+   bool fileTooLarge() const { return fileTooLarge_; }
+
+   std::string fieldValue(const std::string& name) const
+   {
+      std::map<std::string, std::string>::const_iterator it =
+                                                         fields_.find(name);
+      return it != fields_.end() ? it->second : std::string();
+   }
+
+private:
+   size_t byteLimit_;
+   size_t fileBytes_;
+   bool fileTooLarge_;
+   bool isFilePart_;
+   std::string filename_;
+   FilePath tempFilePath_;
+   boost::shared_ptr<std::ostream> pFileStream_;
+   Error writeError_;
+   std::string fieldName_;
+   std::string fieldValue_;
+   std::map<std::string, std::string> fields_;
+};
+
+void removeUploadTempFile(const FilePath& tempFilePath)
+{
+   Error error = tempFilePath.removeIfExists();
+   if (error)
+      LOG_ERROR(error);
+}
+
+std::string multipartBoundary(const std::string& contentType)
+{
+   std::string::size_type pos = contentType.find("boundary=");
+   if (pos == std::string::npos)
+      return std::string();
+
+   std::string boundary = contentType.substr(pos + 9);
+
+   // strip any trailing parameters and surrounding quotes
+   std::string::size_type end = boundary.find(';');
+   if (end != std::string::npos)
+      boundary = boundary.substr(0, end);
+   boost::algorithm::trim(boundary);
+   boost::algorithm::trim_if(boundary, boost::algorithm::is_any_of("\""));
+
+   return boundary;
+}
+
+void handleStreamedFileUploadRequest(const http::Request& request,
+                                     http::Response* pResponse)
+{
+   // raw body file written during request parsing (always removed before
+   // we return)
+   FilePath bodyFilePath(request.headerValue(kStreamedUploadFileHeader));
+
+   // parse the body incrementally (bounded memory regardless of the
+   // size of the uploaded file)
+   StreamedUploadHandler uploadHandler;
+   std::string boundary = multipartBoundary(request.contentType());
+   bool parseOk = !boundary.empty();
+   if (parseOk)
+   {
+      http::MultipartStreamParser parser(boundary, &uploadHandler);
+
+      boost::shared_ptr<std::istream> pBodyStream;
+      Error error = bodyFilePath.open_r(&pBodyStream);
+      if (error)
+      {
+         LOG_ERROR(error);
+         json::setJsonRpcError(error, pResponse);
+         Error removeError = bodyFilePath.removeIfExists();
+         if (removeError)
+            LOG_ERROR(removeError);
+         return;
+      }
+
+      char buffer[16384];
+      while (parseOk && pBodyStream->good())
+      {
+         pBodyStream->read(buffer, sizeof(buffer));
+         std::streamsize bytesRead = pBodyStream->gcount();
+         if (bytesRead <= 0)
+            break;
+         parseOk = parser.parse(buffer, bytesRead);
+      }
+      parseOk = parseOk && parser.complete();
+   }
+
+   // done with the raw body
+   Error removeError = bodyFilePath.removeIfExists();
+   if (removeError)
+      LOG_ERROR(removeError);
+
+   // get fields
+   std::string filename = uploadHandler.filename();
+   std::string targetDirectory = uploadHandler.fieldValue("targetDirectory");
+
+   // validate the request
+   if (!parseOk || filename.empty() || targetDirectory.empty())
+   {
+      json::setJsonRpcError(json::errc::ParamInvalid, pResponse);
+      removeUploadTempFile(uploadHandler.tempFilePath());
+      return;
+   }
+
+   // enforce the upload size limit (checked incrementally during parsing)
+   if (uploadHandler.fileTooLarge())
+   {
+      Error fileTooLargeError = systemError(boost::system::errc::file_too_large,
+                                            ERROR_LOCATION);
+      json::setJsonRpcError(fileTooLargeError, pResponse);
+      removeUploadTempFile(uploadHandler.tempFilePath());
+      return;
+   }
+
+   // surface any error writing the temp file
+   if (uploadHandler.writeError())
+   {
+      json::setJsonRpcError(uploadHandler.writeError(), pResponse);
+      removeUploadTempFile(uploadHandler.tempFilePath());
+      return;
+   }
+
+   // form destination path
+   FilePath destDir = module_context::resolveAliasedPath(targetDirectory);
+   FilePath destPath = destDir.childPath(filename);
+
+   // detect any potential overwrites
+   json::Array overwritesJson;
+   if (destPath.extensionLowerCase() == ".zip")
+   {
+      Error error = detectZipFileOverwrites(uploadHandler.tempFilePath(),
+                                            destDir,
+                                            &overwritesJson);
+      if (error)
+      {
+         LOG_ERROR(error);
+         json::setJsonRpcError(error, pResponse);
+         removeUploadTempFile(uploadHandler.tempFilePath());
+         return;
+      }
+   }
+   else
+   {
+      if (destPath.exists())
+         overwritesJson.push_back(module_context::createFileSystemItem(destPath));
+   }
+
+   // set the upload information as the result
+   json::Object uploadTokenJson;
+   uploadTokenJson[kUploadFilename] = filename;
+   uploadTokenJson[kUploadedTempFile] =
+                              uploadHandler.tempFilePath().absolutePath();
+   uploadTokenJson[kUploadTargetDirectory] = destDir.absolutePath();
+   json::Object uploadJson;
+   uploadJson["token"] = uploadTokenJson;
+   uploadJson["overwrites"] = overwritesJson;
+   json::setJsonRpcResult(uploadJson, pResponse);
+}
+
+void handleFileUploadRequest(const http::Request& request,
+                             http::Response* pResponse)
 {
    // response content type must always be text/html to be handled
    // properly by the browser/gwt on the client side
    pResponse->setContentType("text/html");
-   
+
+   // large bodies are streamed to disk during request parsing rather
+   // than buffered in memory -- handle those incrementally
+   if (!request.headerValue(kStreamedUploadFileHeader).empty())
+   {
+      handleStreamedFileUploadRequest(request, pResponse);
+      return;
+   }
+
    // get fields
    const http::File& file = request.uploadedFile("file");
    std::string targetDirectory = request.formFieldValue("targetDirectory");
@@ -715,10 +1175,9 @@ void handleFileUploadRequest(const http::Request& request,
    json::setJsonRpcResult(uploadJson, pResponse);   
 }
    
-void setAttachmentResponse(const http::Request& request,
-                           const std::string& filename,
-                           const FilePath& attachmentPath,
-                           http::Response* pResponse)
+void setAttachmentHeaders(const http::Request& request,
+                          const std::string& filename,
+                          http::Response* pResponse)
 {
    if (request.headerValue("User-Agent").find("MSIE") == std::string::npos)
    {
@@ -738,7 +1197,41 @@ void setAttachmentResponse(const http::Request& request,
                         "attachment; filename*=UTF-8''"
                         + http::util::urlEncode(filename, false));
    pResponse->setHeader("Content-Type", "application/octet-stream");
-   pResponse->setBody(attachmentPath);
+}
+
+void setAttachmentResponse(const http::Request& request,
+                           const std::string& filename,
+                           const FilePath& attachmentPath,
+                           http::Response* pResponse)
+{
+   setAttachmentHeaders(request, filename, pResponse);
+
+#ifndef _WIN32
+   // serve the file zero-copy: map it and attach the mapping as a
+   // scatter-gather buffer (downloads can be large and this avoids
+   // buffering the body in memory). fall back to reading the file into
+   // an owned buffer if the mapping fails
+   boost::shared_ptr<core::system::MemoryMappedFile> pMappedFile(
+                                    new core::system::MemoryMappedFile());
+   Error error = pMappedFile->open(attachmentPath);
+   if (!error && pMappedFile->size() > 0)
+   {
+      pResponse->addBodyBuffer(pMappedFile->data(),
+                               pMappedFile->size(),
+                               pMappedFile);
+      return;
+   }
+#endif
+
+   boost::shared_ptr<std::string> pContents(new std::string());
+   Error readError = core::readStringFromFile(attachmentPath,
+                                              pContents.get());
+   if (readError)
+   {
+      pResponse->setError(readError);
+      return;
+   }
+   pResponse->addBodyBuffer(pContents);
 }
    
 void handleMultipleFileExportRequest(const http::Request& request, 
@@ -789,21 +1282,22 @@ void handleMultipleFileExportRequest(const http::Request& request,
       files.push_back(file);
    }
    
-   // create the zip file
-   FilePath tempZipFilePath = module_context::tempFile("export", "zip");
-   Error error = r::exec::RFunction(".rs.createZipFile",
-                                    tempZipFilePath.absolutePath(),
-                                    parentPath.absolutePath(),
-                                    files).call();
+   // write the archive with the native zip writer: entries are deflated
+   // in process and go straight into the response, so no temp file (or
+   // free disk proportional to the archive) is required
+   std::ostringstream zipStream;
+   Error error = zip::writeArchive(parentPath, files, &zipStream);
    if (error)
    {
       LOG_ERROR(error);
       pResponse->setError(error);
       return;
    }
-   
+
    // return attachment
-   setAttachmentResponse(request, name, tempZipFilePath, pResponse);
+   setAttachmentHeaders(request, name, pResponse);
+   boost::shared_ptr<std::string> pArchive(new std::string(zipStream.str()));
+   pResponse->addBodyBuffer(pArchive);
 }
    
 void handleFileExportRequest(const http::Request& request, 
@@ -917,6 +1411,63 @@ SEXP rs_readLines(SEXP filePathSEXP)
    return r::sexp::create(splat, &protect);
 }
 
+// prefetch support: listing a directory in the Files pane means the
+// user is likely about to open one of its files. at idle, read the most
+// recently modified regular files in the directory and discard the
+// contents -- on network file systems this pulls them into the client
+// cache so the subsequent open happens at local speed
+const std::size_t kMaxPrefetchFiles = 5;
+const uintmax_t kMaxPrefetchFileSize = 1024 * 1024;
+
+bool moreRecentlyModified(const FilePath& lhs, const FilePath& rhs)
+{
+   return lhs.lastWriteTime() > rhs.lastWriteTime();
+}
+
+void prefetchDirectoryContents(const FilePath& directory)
+{
+   std::vector<FilePath> children;
+   Error error = directory.children(&children);
+   if (error)
+      return;
+
+   // the most recently modified files are the most likely to be opened
+   std::sort(children.begin(), children.end(), moreRecentlyModified);
+
+   std::size_t prefetched = 0;
+   BOOST_FOREACH(const FilePath& child, children)
+   {
+      if (child.isDirectory() || child.size() > kMaxPrefetchFileSize)
+         continue;
+
+      std::string contents;
+      if (core::readStringFromFile(child, &contents))
+         continue;
+
+      if (++prefetched >= kMaxPrefetchFiles)
+         break;
+   }
+}
+
+void predictFilesPanePrefetch(const json::JsonRpcRequest& request)
+{
+   if (request.method != "list_files")
+      return;
+
+   std::string path;
+   bool monitor;
+   if (json::readParams(request.params, &path, &monitor))
+      return;
+
+   FilePath targetPath = module_context::resolveAliasedPath(path);
+   if (!targetPath.isDirectory())
+      return;
+
+   module_context::schedulePrefetch(
+            "files-pane-" + targetPath.absolutePath(),
+            boost::bind(prefetchDirectoryContents, targetPath));
+}
+
 } // anonymous namespace
 
 bool isMonitoringDirectory(const FilePath& directory)
@@ -1003,7 +1554,7 @@ Error readJSON(const core::json::JsonRpcRequest& request,
       return error;
    }
    
-   pResponse->setResult(valueJson);
+   pResponse->setResult(std::move(valueJson));
    return Success();
 }
 
@@ -1020,18 +1571,29 @@ Error initialize()
    RS_REGISTER_CALL_METHOD(rs_readLines, 1);
    RS_REGISTER_CALL_METHOD(rs_pathInfo, 1);
 
+   // prefetch likely file opens behind directory listings
+   registerRpcPrefetcher(predictFilesPanePrefetch);
+
    // install handlers
    using boost::bind;
    ExecBlock initBlock ;
    initBlock.addFunctions()
-      (bind(registerRpcMethod, "stat", stat))
-      (bind(registerRpcMethod, "is_text_file", isTextFile))
+      // stat and text file detection run on worker threads (they only
+      // touch the filesystem, never R) so a slow NFS mount doesn't
+      // block the R thread. get_file_contents must stay on the R thread
+      // since decoding goes through R's iconv
+      (bind(worker_context::registerWorkerRpcMethod, "stat", stat))
+      (bind(worker_context::registerWorkerRpcMethod, "is_text_file", isTextFile))
       (bind(registerRpcMethod, "get_file_contents", getFileContents))
       (bind(registerRpcMethod, "list_files", listFiles))
+      (bind(registerRpcMethod, "list_files_paged", listFilesPaged))
       (bind(registerRpcMethod, "create_folder", createFolder))
-      (bind(registerRpcMethod, "delete_files", deleteFiles))
-      (bind(registerRpcMethod, "copy_file", copyFile))
-      (bind(registerRpcMethod, "move_files", moveFiles))
+      // copy/move/delete also run on worker threads -- they only touch
+      // the filesystem, and a large or slow (network) tree shouldn't
+      // hold the R thread for its duration
+      (bind(worker_context::registerWorkerRpcMethod, "delete_files", deleteFiles))
+      (bind(worker_context::registerWorkerRpcMethod, "copy_file", copyFile))
+      (bind(worker_context::registerWorkerRpcMethod, "move_files", moveFiles))
       (bind(registerRpcMethod, "rename_file", renameFile))
       (bind(registerUriHandler, "/files", handleFilesRequest))
       (bind(registerUriHandler, "/upload", handleFileUploadRequest))
@@ -24,23 +24,40 @@
 #include <core/Log.hpp>
 #include <core/FileInfo.hpp>
 #include <core/FilePath.hpp>
+#include <core/StringUtils.hpp>
 
 #include <core/json/JsonRpc.hpp>
 
 #include <core/system/FileMonitor.hpp>
+#include <core/system/FileScanner.hpp>
 #include <core/system/FileChangeEvent.hpp>
 
 #include <session/SessionModuleContext.hpp>
 
 #include "SessionVCS.hpp"
+#include "SessionFilesQuotas.hpp"
 
 using namespace rstudio::core ;
 
 namespace rstudio {
 namespace session {
-namespace modules { 
+namespace modules {
 namespace files {
 
+namespace {
+
+void onMonitoredFilesChanged(
+                  const FilePath& vcsStatusRoot,
+                  const std::vector<core::system::FileChangeEvent>& events)
+{
+   // fold the observed deltas into the cached quota figure before
+   // streaming the changes to the client
+   quotas::adjustQuotaForFileChanges(events);
+   module_context::enqueFileChangedEvents(vcsStatusRoot, events);
+}
+
+} // anonymous namespace
+
 Error FilesListingMonitor::start(const FilePath& filePath, json::Array* pJsonFiles)
 {
    // always stop existing
@@ -61,19 +78,53 @@ Error FilesListingMonitor::start(const FilePath& filePath, json::Array* pJsonFil
                   core::toFileInfo);
 
    // kickoff new monitor
+   startMonitoring(filePath, prevFiles);
+
+   return Success();
+}
+
+Error FilesListingMonitor::start(const FilePath& filePath)
+{
+   // always stop existing
+   stop();
+
+   // enumerate the directory (no json listing -- the paged listing api
+   // builds json only for the page actually requested; subsequent
+   // changes stream to the client as FileChangeEvent deltas)
+   std::vector<FileInfo> entries;
+   Error error = enumerateFiles(filePath, &entries);
+   if (error)
+      return error;
+
+   // normalize paths via FilePath so that symlinks are traversed the
+   // same way as in the listing comparison baseline (see comment on
+   // normalizeFileScannerPath below)
+   std::vector<FileInfo> prevFiles;
+   BOOST_FOREACH(const FileInfo& fileInfo, entries)
+   {
+      prevFiles.push_back(FileInfo(FilePath(fileInfo.absolutePath())));
+   }
+
+   // kickoff new monitor
+   startMonitoring(filePath, prevFiles);
+
+   return Success();
+}
+
+void FilesListingMonitor::startMonitoring(const FilePath& filePath,
+                                          const std::vector<FileInfo>& prevFiles)
+{
    core::system::file_monitor::Callbacks cb;
    cb.onRegistered = boost::bind(&FilesListingMonitor::onRegistered,
                                     this, _1, filePath, prevFiles, _2);
    cb.onRegistrationError =  boost::bind(core::log::logError, _1, ERROR_LOCATION);
-   cb.onFilesChanged = boost::bind(module_context::enqueFileChangedEvents, filePath, _1);
+   cb.onFilesChanged = boost::bind(onMonitoredFilesChanged, filePath, _1);
    cb.onMonitoringError = boost::bind(core::log::logError, _1, ERROR_LOCATION);
    cb.onUnregistered = boost::bind(&FilesListingMonitor::onUnregistered, this, _1);
    core::system::file_monitor::registerMonitor(filePath,
                                                false,
                                                module_context::fileListingFilter,
                                                cb);
-
-   return Success();
 }
 
 void FilesListingMonitor::stop()
@@ -169,13 +220,31 @@ void FilesListingMonitor::onUnregistered(core::system::file_monitor::Handle hand
    }
 }
 
+namespace {
+
+bool compareFileInfoNoCase(const core::FileInfo& a, const core::FileInfo& b)
+{
+   return string_utils::toLower(a.absolutePath()) <
+          string_utils::toLower(b.absolutePath());
+}
+
+} // anonymous namespace
+
+Error FilesListingMonitor::enumerateFiles(const FilePath& rootPath,
+                                          std::vector<FileInfo>* pEntries)
+{
+   // enumerate the files -- this stats each entry exactly once and
+   // caches the attributes in the FileInfo
+   return core::system::readDirectory(rootPath, pEntries);
+}
+
 Error FilesListingMonitor::listFiles(const FilePath& rootPath,
                                      std::vector<FilePath>* pFiles,
                                      json::Array* pJsonFiles)
 {
-   // enumerate the files
    pFiles->clear();
-   core::Error error = rootPath.children(pFiles) ;
+   std::vector<core::FileInfo> entries;
+   core::Error error = enumerateFiles(rootPath, &entries);
    if (error)
       return error;
 
@@ -184,16 +253,20 @@ Error FilesListingMonitor::listFiles(const FilePath& rootPath,
                   source_control::fileDecorationContext(rootPath);
 
    // sort the files by name
-   std::sort(pFiles->begin(), pFiles->end(), core::compareAbsolutePathNoCase);
+   std::sort(entries.begin(), entries.end(), compareFileInfoNoCase);
 
    // produce json listing
-   BOOST_FOREACH( core::FilePath& filePath, *pFiles)
+   BOOST_FOREACH(const core::FileInfo& fileInfo, entries)
    {
-      // files which may have been deleted after the listing or which
-      // are not end-user visible
-      if (filePath.exists() && module_context::fileListingFilter(core::FileInfo(filePath)))
+      // return the path to our caller
+      FilePath filePath(fileInfo.absolutePath());
+      pFiles->push_back(filePath);
+
+      // screen files which are not end-user visible
+      if (module_context::fileListingFilter(fileInfo))
       {
-         core::json::Object fileObject = module_context::createFileSystemItem(filePath);
+         core::json::Object fileObject =
+                           module_context::createFileSystemItem(fileInfo);
          pCtx->decorateFile(filePath, &fileObject);
          pJsonFiles->push_back(fileObject) ;
       }
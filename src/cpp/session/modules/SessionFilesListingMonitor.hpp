@@ -53,6 +53,10 @@ public:
    // kickoff monitoring
    core::Error start(const core::FilePath& filePath, core::json::Array* pJsonFiles);
 
+   // kickoff monitoring without producing a json listing (used by the
+   // paged listing api, which builds json for the requested page only)
+   core::Error start(const core::FilePath& filePath);
+
    void stop();
 
    // what path are we currently monitoring?
@@ -67,6 +71,10 @@ public:
       return listFiles(rootPath, &files, pJsonFiles);
    }
 
+   // enumerate directory entries (with attributes) without building json
+   static core::Error enumerateFiles(const core::FilePath& rootPath,
+                                     std::vector<core::FileInfo>* pEntries);
+
 private:
    // stateful handlers for registration and unregistration
    void onRegistered(core::system::file_monitor::Handle handle,
@@ -76,6 +84,10 @@ private:
 
    void onUnregistered(core::system::file_monitor::Handle handle);
 
+   // common monitor registration
+   void startMonitoring(const core::FilePath& filePath,
+                        const std::vector<core::FileInfo>& prevFiles);
+
    // helpers
    static core::Error listFiles(const core::FilePath& rootPath,
                                 std::vector<core::FilePath>* pFiles,
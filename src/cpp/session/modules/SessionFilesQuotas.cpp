@@ -15,6 +15,7 @@
 
 #include "SessionFilesQuotas.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #include <boost/tokenizer.hpp>
@@ -25,6 +26,9 @@
 #include <core/Error.hpp>
 #include <core/BoostErrors.hpp>
 #include <core/Log.hpp>
+#include <core/Thread.hpp>
+
+#include <core/system/FileChangeEvent.hpp>
 
 #include <core/system/Process.hpp>
 
@@ -43,8 +47,14 @@ namespace quotas {
 namespace {
 
 // does the system have quotas?
-bool s_systemHasQuotas = false;   
-   
+bool s_systemHasQuotas = false;
+
+// incremental quota accounting: xfs_quota reseeds the aggregate at most
+// once per reconcile interval; in between we serve a cached figure
+// adjusted by the deltas observed from file-monitor change events, so
+// routine file operations don't each spawn an xfs_quota process
+const int kQuotaReconcileSeconds = 60;
+
 struct QuotaInfo
 {
    typedef long long size_type;
@@ -86,6 +96,49 @@ void quotaInfoToJson(const QuotaInfo& quotaInfo,
    quotaInfoJson["limit"] = limit;
 }
    
+// cached quota state (worker threads both update and consult it)
+boost::mutex s_quotaMutex;
+QuotaInfo s_cachedQuotaInfo;
+QuotaInfo::size_type s_pendingUsageDelta = 0;
+boost::posix_time::ptime s_lastReconcileTime(
+                                    boost::posix_time::not_a_date_time);
+
+void enqueQuotaEvent(const QuotaInfo& quotaInfo)
+{
+   json::Object quotaInfoJson;
+   quotaInfoToJson(quotaInfo, &quotaInfoJson);
+   ClientEvent event(client_events::kQuotaStatus, quotaInfoJson);
+   module_context::enqueClientEvent(event);
+}
+
+// serve quota status from the cache when it is still fresh; returns
+// false when a reconciliation run is due
+bool enqueCachedQuotaStatus()
+{
+   QuotaInfo info;
+   LOCK_MUTEX(s_quotaMutex)
+   {
+      using namespace boost::posix_time;
+      if (s_lastReconcileTime.is_not_a_date_time())
+         return false;
+      if (microsec_clock::universal_time() - s_lastReconcileTime >
+          seconds(kQuotaReconcileSeconds))
+      {
+         return false;
+      }
+
+      info = s_cachedQuotaInfo;
+      info.used = std::max(static_cast<QuotaInfo::size_type>(0),
+                           info.used + s_pendingUsageDelta);
+   }
+   END_LOCK_MUTEX
+
+   if (info.hasQuota)
+      enqueQuotaEvent(info);
+
+   return true;
+}
+
 QuotaInfo::size_type quotaBytes(const std::string& quotaKb)
 {
    QuotaInfo::size_type kb = boost::lexical_cast<QuotaInfo::size_type>(quotaKb);
@@ -182,14 +235,19 @@ void checkQuotaThread()
          return;
       }
       
-      // send event only if there are quotas established
-      if (quotaInfo.hasQuota)
+      // reseed the cache (and drop deltas the reconciliation subsumes)
+      LOCK_MUTEX(s_quotaMutex)
       {
-         json::Object quotaInfoJson;
-         quotaInfoToJson(quotaInfo, &quotaInfoJson);
-         ClientEvent event(client_events::kQuotaStatus, quotaInfoJson);
-         module_context::enqueClientEvent(event);
+         s_cachedQuotaInfo = quotaInfo;
+         s_pendingUsageDelta = 0;
+         s_lastReconcileTime =
+               boost::posix_time::microsec_clock::universal_time();
       }
+      END_LOCK_MUTEX
+
+      // send event only if there are quotas established
+      if (quotaInfo.hasQuota)
+         enqueQuotaEvent(quotaInfo);
    }
    CATCH_UNEXPECTED_EXCEPTION
 }
@@ -215,10 +273,46 @@ Error initialize()
 }
    
 
+void adjustQuotaForFileChanges(
+      const std::vector<core::system::FileChangeEvent>& events)
+{
+   if (!s_systemHasQuotas)
+      return;
+
+   // adds and removes carry the affected file's size; modifications
+   // don't tell us the previous size so they are left to the periodic
+   // reconciliation (as is everything outside the monitored directory)
+   QuotaInfo::size_type delta = 0;
+   for (std::size_t i = 0; i < events.size(); i++)
+   {
+      const core::system::FileChangeEvent& event = events[i];
+      if (event.fileInfo().isDirectory())
+         continue;
+      else if (event.type() == core::system::FileChangeEvent::FileAdded)
+         delta += event.fileInfo().size();
+      else if (event.type() == core::system::FileChangeEvent::FileRemoved)
+         delta -= event.fileInfo().size();
+   }
+
+   if (delta != 0)
+   {
+      LOCK_MUTEX(s_quotaMutex)
+      {
+         s_pendingUsageDelta += delta;
+      }
+      END_LOCK_MUTEX
+   }
+}
+
 void checkQuotaStatus()
 {
    if (s_systemHasQuotas)
    {
+      // answer from the cache while it is fresh -- only reconcile with
+      // xfs_quota when the cached figure has had time to drift
+      if (enqueCachedQuotaStatus())
+         return;
+
       try
       {
          // block all signals for launch of background thread (will cause it
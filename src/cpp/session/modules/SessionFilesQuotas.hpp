@@ -16,22 +16,33 @@
 #ifndef SESSION_SESSION_FILES_QUOTAS_HPP
 #define SESSION_SESSION_FILES_QUOTAS_HPP
 
+#include <vector>
+
 namespace rstudio {
 namespace core {
    class Error;
+   namespace system {
+      class FileChangeEvent;
+   }
 }
 }
- 
+
 namespace rstudio {
 namespace session {
-namespace modules {      
+namespace modules {
 namespace files {
 namespace quotas {
 
 core::Error initialize();
 
 void checkQuotaStatus();
-   
+
+// apply the usage deltas implied by file-monitor change events to the
+// cached quota figure (adds and removes only -- actual usage is
+// reconciled periodically by checkQuotaStatus)
+void adjustQuotaForFileChanges(
+      const std::vector<core::system::FileChangeEvent>& events);
+
 } // namespace quotas
 } // namespace files
 } // namepace handlers
@@ -16,16 +16,20 @@
 #include "SessionFind.hpp"
 
 #include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <vector>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/bind.hpp>
 #include <boost/enable_shared_from_this.hpp>
 
 #include <core/Exec.hpp>
+#include <core/RegexUtils.hpp>
 #include <core/StringUtils.hpp>
-#include <core/system/Environment.hpp>
-#include <core/system/Process.hpp>
-#include <core/system/ShellUtils.hpp>
+#include <core/Thread.hpp>
+#include <core/system/MemoryMappedFile.hpp>
+#include <core/system/System.hpp>
 
 #include <r/RUtil.hpp>
 
@@ -37,7 +41,7 @@ using namespace rstudio::core;
 
 namespace rstudio {
 namespace session {
-namespace modules {   
+namespace modules {
 namespace find {
 
 namespace {
@@ -193,20 +197,79 @@ FindInFilesState& findResults()
    return *s_pFindResults;
 }
 
-class GrepOperation : public boost::enable_shared_from_this<GrepOperation>
+// upper bound on search worker threads (scanning is largely memory
+// bandwidth bound so more threads than this don't help)
+const std::size_t kMaxFindThreads = 8;
+
+// maximum number of raw line bytes captured per match (the client only
+// displays ~300 characters)
+const std::size_t kMaxLineBytes = 2048;
+
+// bytes scanned between cancellation checks within a single file
+const std::size_t kCancelCheckBytes = 256 * 1024;
+
+std::size_t findThreadCount()
+{
+   std::size_t threads = boost::thread::hardware_concurrency();
+   if (threads == 0)
+      threads = 2;
+   return std::min(threads, kMaxFindThreads);
+}
+
+bool charEqualsIgnoreCase(char lhs, char rhs)
+{
+   return std::tolower(static_cast<unsigned char>(lhs)) ==
+          std::tolower(static_cast<unsigned char>(rhs));
+}
+
+// a single match produced by a search worker. line contents are raw
+// bytes in the source file's encoding -- decoding runs through R's
+// iconv and therefore must occur on the main thread
+struct FindMatch
+{
+   FindMatch() : lineNum(0) {}
+   std::string file;
+   int lineNum;
+   std::string line;
+   std::vector<std::size_t> matchOn;    // byte offsets within line
+   std::vector<std::size_t> matchOff;
+};
+
+// in-process parallel search. an enumeration thread walks the directory
+// tree pushing candidate files onto a shared queue; worker threads pull
+// from the queue (which load balances the same way work stealing would),
+// memory map each file, apply a cheap literal prefilter, and then run
+// the regex line by line. matches stream back to the main thread via a
+// second queue and are dispatched to the client incrementally
+class FindOperation : public boost::enable_shared_from_this<FindOperation>,
+                      boost::noncopyable
 {
 public:
-   static boost::shared_ptr<GrepOperation> create(const std::string& encoding,
-                                                  const FilePath& tempFile)
+   static boost::shared_ptr<FindOperation> create(
+                           const boost::regex& pattern,
+                           const std::string& prefilter,
+                           bool ignoreCase,
+                           const std::vector<boost::regex>& includePatterns)
    {
-      return boost::shared_ptr<GrepOperation>(new GrepOperation(encoding,
-                                                                tempFile));
+      return boost::shared_ptr<FindOperation>(new FindOperation(
+                           pattern, prefilter, ignoreCase, includePatterns));
    }
 
 private:
-   GrepOperation(const std::string& encoding,
-                 const FilePath& tempFile)
-      : firstDecodeError_(true), encoding_(encoding), tempFile_(tempFile)
+   FindOperation(const boost::regex& pattern,
+                 const std::string& prefilter,
+                 bool ignoreCase,
+                 const std::vector<boost::regex>& includePatterns)
+      : pattern_(pattern),
+        prefilter_(prefilter),
+        ignoreCase_(ignoreCase),
+        includePatterns_(includePatterns),
+        fileQueue_(true),
+        matchQueue_(true),
+        stopped_(false),
+        enumerationDone_(false),
+        activeWorkers_(0),
+        totalMatches_(0)
    {
       handle_ = core::system::generateUuid(false);
    }
@@ -217,215 +280,535 @@ public:
       return handle_;
    }
 
-   core::system::ProcessCallbacks createProcessCallbacks()
+   void start(const FilePath& rootPath)
+   {
+      // launch the enumeration thread and the workers. each thread holds
+      // a shared_ptr to the operation so it remains alive until the last
+      // thread has exited
+      std::size_t nThreads = findThreadCount();
+      LOCK_MUTEX(mutex_)
+      {
+         activeWorkers_ = nThreads;
+      }
+      END_LOCK_MUTEX
+
+      core::thread::safeLaunchThread(boost::bind(&FindOperation::enumerate,
+                                                 shared_from_this(),
+                                                 rootPath));
+      for (std::size_t i = 0; i < nThreads; i++)
+      {
+         core::thread::safeLaunchThread(boost::bind(&FindOperation::workerMain,
+                                                    shared_from_this()));
+      }
+   }
+
+   // request cancellation (workers notice between files and while
+   // scanning large files)
+   void stop()
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         stopped_ = true;
+      }
+      END_LOCK_MUTEX
+   }
+
+   bool finished()
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         return activeWorkers_ == 0;
+      }
+      END_LOCK_MUTEX
+
+      // keep compiler happy
+      return true;
+   }
+
+   // drain pending matches (main thread)
+   void dequeMatches(std::vector<FindMatch>* pMatches)
    {
-      core::system::ProcessCallbacks callbacks;
-      callbacks.onContinue = boost::bind(&GrepOperation::onContinue,
-                                         shared_from_this(),
-                                         _1);
-      callbacks.onStdout = boost::bind(&GrepOperation::onStdout,
-                                       shared_from_this(),
-                                       _1, _2);
-      callbacks.onStderr = boost::bind(&GrepOperation::onStderr,
-                                       shared_from_this(),
-                                       _1, _2);
-      callbacks.onExit = boost::bind(&GrepOperation::onExit,
-                                     shared_from_this(),
-                                     _1);
-      return callbacks;
+      FindMatch match;
+      while (matchQueue_.deque(&match))
+         pMatches->push_back(match);
    }
 
 private:
-   bool onContinue(const core::system::ProcessOperations& ops) const
+   bool stopped()
    {
-      return findResults().isRunning() && findResults().handle() == handle();
+      LOCK_MUTEX(mutex_)
+      {
+         return stopped_;
+      }
+      END_LOCK_MUTEX
+
+      // keep compiler happy
+      return true;
    }
 
-   std::string decode(const std::string& encoded)
+   bool enumerationDone()
    {
-      if (encoded.empty())
-         return encoded;
+      LOCK_MUTEX(mutex_)
+      {
+         return enumerationDone_;
+      }
+      END_LOCK_MUTEX
 
-      std::string decoded;
-      Error error = r::util::iconvstr(encoded, encoding_, "UTF-8", true,
-                                      &decoded);
+      // keep compiler happy
+      return true;
+   }
 
-      // Log error, but only once per grep operation
-      if (error && firstDecodeError_)
+   bool includeFile(const std::string& filename)
+   {
+      if (includePatterns_.empty())
+         return true;
+
+      BOOST_FOREACH(const boost::regex& pattern, includePatterns_)
       {
-         firstDecodeError_ = false;
-         LOG_ERROR(error);
+         boost::smatch match;
+         if (regex_utils::match(filename, match, pattern))
+            return true;
       }
+      return false;
+   }
 
-      return decoded;
+   void enumerate(FilePath rootPath)
+   {
+      try
+      {
+         // iterative traversal (keeps stack depth constant on deep trees)
+         std::vector<FilePath> folders;
+         folders.push_back(rootPath);
+         while (!folders.empty() && !stopped())
+         {
+            FilePath folder = folders.back();
+            folders.pop_back();
+
+            std::vector<FilePath> children;
+            Error error = folder.children(&children);
+            if (error)
+               continue;
+
+            BOOST_FOREACH(const FilePath& child, children)
+            {
+               if (child.isDirectory())
+               {
+                  // prune directories we'd filter from the results anyway
+                  // and don't follow symlinked directories (cycles)
+                  std::string name = child.filename();
+                  if (name == ".git" || name == ".svn" || name == ".Rproj.user")
+                     continue;
+                  if (child.isSymlink())
+                     continue;
+                  folders.push_back(child);
+               }
+               else if (includeFile(child.filename()))
+               {
+                  fileQueue_.enque(child.absolutePath());
+               }
+            }
+         }
+      }
+      CATCH_UNEXPECTED_EXCEPTION
+
+      LOCK_MUTEX(mutex_)
+      {
+         enumerationDone_ = true;
+      }
+      END_LOCK_MUTEX
    }
 
-   void processContents(std::string* pContent,
-                        json::Array* pMatchOn,
-                        json::Array* pMatchOff)
+   void workerMain()
    {
-      // initialize some state
-      std::string decodedLine;
-      std::size_t nUtf8CharactersProcessed = 0;
-      
-      const char* inputPos = pContent->c_str();
-      const char* end = inputPos + pContent->size();
-      
-      boost::cmatch match;
-      while (regex_utils::search(inputPos, match, boost::regex("\x1B\\[(\\d\\d)?m(\x1B\\[K)?")))
+      try
       {
-         // decode the current match, and append it
-         std::string matchedString(inputPos, inputPos + match.position());
-         std::string decoded = decode(matchedString);
-         
-         // append and update
-         decodedLine.append(decoded);
-         inputPos += match.position() + match.length();
-         
-         // count the number of UTF-8 characters processed
-         std::size_t charSize;
-         Error error = string_utils::utf8Distance(decoded.begin(),
-                                                  decoded.end(),
-                                                  &charSize);
-         if (error)
-            charSize = decoded.size();
-         nUtf8CharactersProcessed += charSize;
+         std::string path;
+         for (;;)
+         {
+            if (stopped())
+               break;
 
-         // update the match state
-         if (match[1] == "01")
-            pMatchOn->push_back(static_cast<int>(nUtf8CharactersProcessed));
-         else
-            pMatchOff->push_back(static_cast<int>(nUtf8CharactersProcessed));
+            if (fileQueue_.deque(&path))
+            {
+               scanFile(FilePath(path));
+               continue;
+            }
+
+            // queue is empty: if enumeration already finished then no
+            // more work is coming; otherwise wait for more files
+            if (enumerationDone())
+               break;
+
+            fileQueue_.wait(boost::posix_time::milliseconds(100));
+         }
       }
-      
-      if (inputPos != end)
-         decodedLine.append(decode(std::string(inputPos, end)));
+      CATCH_UNEXPECTED_EXCEPTION
 
-      if (decodedLine.size() > 300)
+      LOCK_MUTEX(mutex_)
       {
-         decodedLine = decodedLine.erase(300);
-         decodedLine.append("...");
+         activeWorkers_--;
       }
+      END_LOCK_MUTEX
+   }
 
-      *pContent = decodedLine;
+   bool containsPrefilter(const char* pBegin, const char* pEnd)
+   {
+      if (ignoreCase_)
+      {
+         return std::search(pBegin, pEnd,
+                            prefilter_.begin(), prefilter_.end(),
+                            charEqualsIgnoreCase) != pEnd;
+      }
+      else
+      {
+         return std::search(pBegin, pEnd,
+                            prefilter_.begin(), prefilter_.end()) != pEnd;
+      }
    }
 
-   void onStdout(const core::system::ProcessOperations& ops, const std::string& data)
+   void matchLine(const char* pLine,
+                  const char* pLineEnd,
+                  const std::string& file,
+                  int lineNum,
+                  std::vector<FindMatch>* pMatches)
    {
-      json::Array files;
-      json::Array lineNums;
-      json::Array contents;
-      json::Array matchOns;
-      json::Array matchOffs;
+      boost::cmatch match;
+      if (!regex_utils::search(pLine, pLineEnd, match, pattern_))
+         return;
 
-      int recordsToProcess = MAX_COUNT + 1 - findResults().resultCount();
-      if (recordsToProcess < 0)
-         recordsToProcess = 0;
+      FindMatch result;
+      result.file = file;
+      result.lineNum = lineNum;
 
-      std::string websiteOutputDir = module_context::websiteOutputDir();
-      if (!websiteOutputDir.empty())
-         websiteOutputDir = "/" + websiteOutputDir + "/";
+      // collect every match on the line (mirrors grep --color)
+      const char* pPos = pLine;
+      boost::match_flag_type flags = boost::match_default;
+      for (;;)
+      {
+         std::size_t on = (pPos - pLine) + match.position();
+         std::size_t off = on + match.length();
+         result.matchOn.push_back(on);
+         result.matchOff.push_back(off);
+
+         // guard against zero-length matches
+         std::size_t advance = std::max<std::size_t>(
+                                    match.position() + match.length(), 1);
+         pPos += advance;
+         flags = boost::match_not_bol | boost::match_prev_avail;
+         if (pPos >= pLineEnd)
+            break;
+         if (!regex_utils::search(pPos, pLineEnd, match, pattern_, flags))
+            break;
+      }
 
-      stdOutBuf_.append(data);
-      size_t nextLineStart = 0;
-      size_t pos = -1;
-      while (recordsToProcess &&
-             std::string::npos != (pos = stdOutBuf_.find('\n', pos + 1)))
+      // bound the raw bytes we capture (the client displays a truncated
+      // line anyway); drop ranges which fall beyond the captured bytes
+      std::size_t lineLen = std::min<std::size_t>(pLineEnd - pLine,
+                                                  kMaxLineBytes);
+      result.line.assign(pLine, pLine + lineLen);
+      while (!result.matchOn.empty() && result.matchOn.back() >= lineLen)
       {
-         std::string line = stdOutBuf_.substr(nextLineStart, pos - nextLineStart);
-         nextLineStart = pos + 1;
+         result.matchOn.pop_back();
+         result.matchOff.pop_back();
+      }
+      if (!result.matchOff.empty() && result.matchOff.back() > lineLen)
+         result.matchOff.back() = lineLen;
 
-         boost::smatch match;
-         if (regex_utils::match(line, match, boost::regex("^((?:[a-zA-Z]:)?[^:]+):(\\d+):(.*)")))
-         {
-            std::string file = module_context::createAliasedPath(
-                  FilePath(string_utils::systemToUtf8(match[1])));
+      pMatches->push_back(result);
+   }
 
-            if (file.find("/.Rproj.user/") != std::string::npos)
-               continue;
-            if (file.find("/.git/") != std::string::npos)
-               continue;
-            if (file.find("/.svn/") != std::string::npos)
-               continue;
-            if (file.find("/packrat/lib/") != std::string::npos)
-               continue;
-            if (file.find("/packrat/src/") != std::string::npos)
-               continue;
-            if (file.find("/.Rhistory") != std::string::npos)
-               continue;
+   void scanFile(const FilePath& filePath)
+   {
+      // map the file (skip silently on error -- files can vanish or be
+      // unreadable mid-search, just as they could under grep)
+      core::system::MemoryMappedFile mappedFile;
+      Error error = mappedFile.open(filePath);
+      if (error)
+         return;
 
-            if (!websiteOutputDir.empty() &&
-                file.find(websiteOutputDir) != std::string::npos)
-               continue;
+      const char* pData = static_cast<const char*>(mappedFile.data());
+      std::size_t size = mappedFile.size();
+      if (pData == NULL || size == 0)
+         return;
+
+      // exclude binary files (same as grep --binary-files=without-match)
+      std::size_t probeSize = std::min<std::size_t>(size, 8192);
+      if (std::memchr(pData, '\0', probeSize) != NULL)
+         return;
 
-            int lineNum = safe_convert::stringTo<int>(std::string(match[2]), -1);
-            std::string lineContents = match[3];
-            boost::algorithm::trim(lineContents);
-            json::Array matchOn, matchOff;
-            processContents(&lineContents, &matchOn, &matchOff);
+      const char* pEnd = pData + size;
 
-            files.push_back(file);
-            lineNums.push_back(lineNum);
-            contents.push_back(lineContents);
-            matchOns.push_back(matchOn);
-            matchOffs.push_back(matchOff);
+      // cheap literal scan before the regex runs line by line
+      if (!prefilter_.empty() && !containsPrefilter(pData, pEnd))
+         return;
+
+      std::string file = filePath.absolutePath();
+      std::vector<FindMatch> matches;
+      int lineNum = 0;
+      std::size_t sinceCancelCheck = 0;
+      const char* pLine = pData;
+      while (pLine < pEnd)
+      {
+         const char* pNewline = static_cast<const char*>(
+                     std::memchr(pLine, '\n', pEnd - pLine));
+         const char* pLineEnd = (pNewline != NULL) ? pNewline : pEnd;
+         lineNum++;
 
-            recordsToProcess--;
+         matchLine(pLine, pLineEnd, file, lineNum, &matches);
+
+         sinceCancelCheck += (pLineEnd - pLine) + 1;
+         if (sinceCancelCheck >= kCancelCheckBytes)
+         {
+            sinceCancelCheck = 0;
+            if (stopped())
+               return;
          }
+
+         pLine = pLineEnd + 1;
       }
 
-      if (nextLineStart)
+      if (matches.empty())
+         return;
+
+      // publish the matches; once we're comfortably past the result
+      // cap stop all workers (the main thread enforces the exact cap)
+      BOOST_FOREACH(const FindMatch& match, matches)
       {
-         stdOutBuf_.erase(0, nextLineStart);
+         matchQueue_.enque(match);
       }
 
-      if (files.size() > 0)
+      LOCK_MUTEX(mutex_)
       {
-         json::Object result;
-         result["handle"] = handle();
-         json::Object results;
-         results["file"] = files;
-         results["line"] = lineNums;
-         results["lineValue"] = contents;
-         results["matchOn"] = matchOns;
-         results["matchOff"] = matchOffs;
-         result["results"] = results;
-
-         findResults().addResult(handle(),
-                                 files,
-                                 lineNums,
-                                 contents,
-                                 matchOns,
-                                 matchOffs);
-
-         module_context::enqueClientEvent(
-                  ClientEvent(client_events::kFindResult, result));
+         totalMatches_ += matches.size();
+         if (totalMatches_ > MAX_COUNT)
+            stopped_ = true;
+      }
+      END_LOCK_MUTEX
+   }
+
+   std::string handle_;
+   boost::regex pattern_;
+   std::string prefilter_;
+   bool ignoreCase_;
+   std::vector<boost::regex> includePatterns_;
+   core::thread::ThreadsafeQueue<std::string> fileQueue_;
+   core::thread::ThreadsafeQueue<FindMatch> matchQueue_;
+   boost::mutex mutex_;
+   bool stopped_;
+   bool enumerationDone_;
+   std::size_t activeWorkers_;
+   std::size_t totalMatches_;
+};
+
+// currently active find operation (if any)
+boost::shared_ptr<FindOperation> s_pCurrentFind;
+
+// log decode errors only once per find operation
+bool s_firstDecodeError = true;
+
+std::string decode(const std::string& encoded, const std::string& encoding)
+{
+   if (encoded.empty())
+      return encoded;
+
+   std::string decoded;
+   Error error = r::util::iconvstr(encoded, encoding, "UTF-8", true,
+                                   &decoded);
+   if (error && s_firstDecodeError)
+   {
+      s_firstDecodeError = false;
+      LOG_ERROR(error);
+   }
+
+   return decoded;
+}
+
+// decode a raw match into UTF-8 and convert its byte ranges into the
+// UTF-8 character offsets the client expects
+void processMatch(const FindMatch& match,
+                  const std::string& encoding,
+                  std::string* pContent,
+                  json::Array* pMatchOn,
+                  json::Array* pMatchOff)
+{
+   const std::string& line = match.line;
+
+   // results were historically trimmed before processing; do the same,
+   // adjusting the match ranges for the characters removed
+   std::size_t begin = line.find_first_not_of(" \t\r\n");
+   std::size_t end = 0;
+   if (begin == std::string::npos)
+      begin = line.size();
+   else
+      end = line.find_last_not_of(" \t\r\n") + 1;
+
+   std::string decodedLine;
+   std::size_t nUtf8CharactersProcessed = 0;
+   std::size_t pos = begin;
+
+   for (std::size_t i = 0; i < match.matchOn.size(); i++)
+   {
+      std::size_t on = std::max(match.matchOn[i], begin);
+      std::size_t off = std::min(match.matchOff[i], end);
+      if (on >= end)
+         break;
+      if (off <= on)
+         continue;
+
+      // decode up to the match, then the match itself, recording the
+      // cumulative UTF-8 character offsets at each boundary
+      std::size_t boundaries[] = { on, off };
+      for (std::size_t b = 0; b < 2; b++)
+      {
+         std::string decoded = decode(line.substr(pos, boundaries[b] - pos),
+                                      encoding);
+         decodedLine.append(decoded);
+         pos = boundaries[b];
+
+         std::size_t charSize;
+         Error error = string_utils::utf8Distance(decoded.begin(),
+                                                  decoded.end(),
+                                                  &charSize);
+         if (error)
+            charSize = decoded.size();
+         nUtf8CharactersProcessed += charSize;
+
+         if (b == 0)
+            pMatchOn->push_back(static_cast<int>(nUtf8CharactersProcessed));
+         else
+            pMatchOff->push_back(static_cast<int>(nUtf8CharactersProcessed));
       }
+   }
+
+   if (pos < end)
+      decodedLine.append(decode(line.substr(pos, end - pos), encoding));
 
-      if (recordsToProcess <= 0)
-         findResults().onFindEnd(handle());
+   if (decodedLine.size() > 300)
+   {
+      decodedLine = decodedLine.erase(300);
+      decodedLine.append("...");
    }
 
-   void onStderr(const core::system::ProcessOperations& ops, const std::string& data)
+   *pContent = decodedLine;
+}
+
+// periodic main-thread dispatch of worker results to the client
+bool dispatchFindResults(boost::shared_ptr<FindOperation> pFind,
+                         std::string encoding)
+{
+   // a newer find superseded this one
+   if (pFind != s_pCurrentFind)
    {
-      LOG_ERROR_MESSAGE("grep: " + data);
+      pFind->stop();
+      return false;
    }
 
-   void onExit(int exitCode)
+   // stop requested from the client?
+   if (!findResults().isRunning() || findResults().handle() != pFind->handle())
+      pFind->stop();
+
+   // note: check for completion before draining the queue -- anything
+   // enqueued after the check is picked up on the next pass
+   bool finished = pFind->finished();
+
+   std::vector<FindMatch> matches;
+   pFind->dequeMatches(&matches);
+
+   int recordsToProcess = MAX_COUNT + 1 - findResults().resultCount();
+   if (recordsToProcess < 0)
+      recordsToProcess = 0;
+
+   std::string websiteOutputDir = module_context::websiteOutputDir();
+   if (!websiteOutputDir.empty())
+      websiteOutputDir = "/" + websiteOutputDir + "/";
+
+   json::Array files;
+   json::Array lineNums;
+   json::Array contents;
+   json::Array matchOns;
+   json::Array matchOffs;
+
+   BOOST_FOREACH(const FindMatch& match, matches)
    {
-      findResults().onFindEnd(handle());
+      if (!recordsToProcess)
+         break;
+
+      std::string file = module_context::createAliasedPath(
+                                                FilePath(match.file));
+
+      if (file.find("/.Rproj.user/") != std::string::npos)
+         continue;
+      if (file.find("/.git/") != std::string::npos)
+         continue;
+      if (file.find("/.svn/") != std::string::npos)
+         continue;
+      if (file.find("/packrat/lib/") != std::string::npos)
+         continue;
+      if (file.find("/packrat/src/") != std::string::npos)
+         continue;
+      if (file.find("/.Rhistory") != std::string::npos)
+         continue;
+
+      if (!websiteOutputDir.empty() &&
+          file.find(websiteOutputDir) != std::string::npos)
+         continue;
+
+      std::string lineContents;
+      json::Array matchOn, matchOff;
+      processMatch(match, encoding, &lineContents, &matchOn, &matchOff);
+
+      files.push_back(file);
+      lineNums.push_back(match.lineNum);
+      contents.push_back(lineContents);
+      matchOns.push_back(matchOn);
+      matchOffs.push_back(matchOff);
+
+      recordsToProcess--;
+   }
+
+   if (files.size() > 0)
+   {
+      json::Object result;
+      result["handle"] = pFind->handle();
+      json::Object results;
+      results["file"] = files;
+      results["line"] = lineNums;
+      results["lineValue"] = contents;
+      results["matchOn"] = matchOns;
+      results["matchOff"] = matchOffs;
+      result["results"] = results;
+
+      findResults().addResult(pFind->handle(),
+                              files,
+                              lineNums,
+                              contents,
+                              matchOns,
+                              matchOffs);
+
       module_context::enqueClientEvent(
-            ClientEvent(client_events::kFindOperationEnded, handle()));
-      if (!tempFile_.empty())
-         tempFile_.removeIfExists();
+               ClientEvent(client_events::kFindResult, result));
    }
 
-   bool firstDecodeError_;
-   std::string encoding_;
-   FilePath tempFile_;
-   std::string stdOutBuf_;
-   std::string handle_;
-};
+   if (recordsToProcess <= 0)
+   {
+      findResults().onFindEnd(pFind->handle());
+      pFind->stop();
+   }
+
+   // once the workers have wound down (and their final matches were
+   // drained above) notify the client that the operation ended
+   if (finished)
+   {
+      findResults().onFindEnd(pFind->handle());
+      module_context::enqueClientEvent(
+            ClientEvent(client_events::kFindOperationEnded,
+                        pFind->handle()));
+      s_pCurrentFind.reset();
+      return false;
+   }
+
+   return true;
+}
 
 } // namespace
 
@@ -446,26 +829,8 @@ core::Error beginFind(const json::JsonRpcRequest& request,
    if (error)
       return error;
 
-   core::system::ProcessOptions options;
-
-   core::system::Options childEnv;
-   core::system::environment(&childEnv);
-   core::system::setenv(&childEnv, "GREP_COLOR", "01");
-   core::system::setenv(&childEnv, "GREP_COLORS", "ne:fn=:ln=:se=:mt=01");
-#ifdef _WIN32
-   FilePath gnuGrepPath = session::options().gnugrepPath();
-   core::system::addToPath(
-            &childEnv,
-            string_utils::utf8ToSystem(gnuGrepPath.absolutePath()));
-#endif
-   options.environment = childEnv;
-
-   // Put the grep pattern in a file
-   FilePath tempFile = module_context::tempFile("rs_grep", "txt");
-   boost::shared_ptr<std::ostream> pStream;
-   error = tempFile.open_w(&pStream);
-   if (error)
-      return error;
+   // the engine operates on raw bytes in the project encoding (as grep
+   // did), so encode the search string accordingly
    std::string encoding = projects::projectContext().hasProject() ?
                           projects::projectContext().defaultEncoding() :
                           userSettings().defaultEncoding();
@@ -481,60 +846,66 @@ core::Error beginFind(const json::JsonRpcRequest& request,
       encodedString = searchString;
    }
 
-   *pStream << encodedString << std::endl;
-   pStream.reset(); // release file handle
-
-   boost::shared_ptr<GrepOperation> ptrGrepOp = GrepOperation::create(encoding,
-                                                                      tempFile);
-   core::system::ProcessCallbacks callbacks =
-                                       ptrGrepOp->createProcessCallbacks();
-
-#ifdef _WIN32
-   shell_utils::ShellCommand cmd(gnuGrepPath.complete("grep"));
-#else
-   shell_utils::ShellCommand cmd("grep");
-#endif
-   cmd << "-rHn" << "--binary-files=without-match" << "--color=always";
-#ifndef _WIN32
-   cmd << "--devices=skip";
-#endif
-
+   // compile the pattern (grep syntax for regular expressions, literal
+   // match otherwise)
+   boost::regex::flag_type flags = asRegex ? boost::regex::grep :
+                                             boost::regex::literal;
    if (ignoreCase)
-      cmd << "-i";
+      flags |= boost::regex::icase;
+   boost::regex pattern;
+   try
+   {
+      pattern.assign(encodedString, flags);
+   }
+   catch(const boost::regex_error&)
+   {
+      return systemError(boost::system::errc::invalid_argument,
+                         ERROR_LOCATION);
+   }
 
-   // Use -f to pass pattern via file, so we don't have to worry about
-   // escaping double quotes, etc.
-   cmd << "-f";
-   cmd << tempFile;
-   if (!asRegex)
-      cmd << "-F";
+   // literal text used to cheaply prefilter file contents before the
+   // regex runs line by line (short literals match too often to be
+   // worth the extra scan)
+   std::string prefilter = asRegex ? regex_utils::requiredLiteral(encodedString) :
+                                     encodedString;
+   if (asRegex && prefilter.size() < 3)
+      prefilter.clear();
 
+   // file patterns (equivalent of grep --include globs)
+   std::vector<boost::regex> includePatterns;
    BOOST_FOREACH(json::Value filePattern, filePatterns)
    {
-      cmd << "--include=" + filePattern.get_str();
+      includePatterns.push_back(
+            regex_utils::wildcardPatternToRegex(filePattern.get_str()));
    }
 
-   cmd << shell_utils::EscapeFilesOnly << "--" << shell_utils::EscapeAll;
-   
-   // Filepaths received from the client will be UTF-8 encoded;
-   // convert to system encoding here.
+   // Filepaths received from the client will be UTF-8 encoded
    FilePath dirPath = module_context::resolveAliasedPath(directory);
-   cmd << string_utils::utf8ToSystem(dirPath.absolutePath());
 
-   // Clear existing results
+   // stop any operation still in flight, then clear existing results
+   if (s_pCurrentFind)
+      s_pCurrentFind->stop();
    findResults().clear();
+   s_firstDecodeError = true;
 
-   error = module_context::processSupervisor().runCommand(cmd,
-                                                          options,
-                                                          callbacks);
-   if (error)
-      return error;
+   boost::shared_ptr<FindOperation> pFind = FindOperation::create(
+            pattern, prefilter, ignoreCase, includePatterns);
+   s_pCurrentFind = pFind;
+   pFind->start(dirPath);
 
-   findResults().onFindBegin(ptrGrepOp->handle(),
+   findResults().onFindBegin(pFind->handle(),
                              searchString,
                              directory,
                              asRegex);
-   pResponse->setResult(ptrGrepOp->handle());
+
+   // stream results back incrementally as the workers produce them
+   module_context::schedulePeriodicWork(
+            "find-in-files",
+            boost::posix_time::milliseconds(100),
+            boost::bind(dispatchFindResults, pFind, encoding),
+            false);
+
+   pResponse->setResult(pFind->handle());
 
    return Success();
 }
@@ -549,6 +920,9 @@ core::Error stopFind(const json::JsonRpcRequest& request,
 
    findResults().onFindEnd(handle);
 
+   if (s_pCurrentFind && s_pCurrentFind->handle() == handle)
+      s_pCurrentFind->stop();
+
    return Success();
 }
 
@@ -37,6 +37,7 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/optional.hpp>
 #include <boost/regex.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <core/Algorithm.hpp>
 #include <core/BoostLamda.hpp>
@@ -46,6 +47,7 @@
 #include <core/system/System.hpp>
 #include <core/system/Process.hpp>
 #include <core/system/Environment.hpp>
+#include <core/Diff.hpp>
 #include <core/Exec.hpp>
 #include <core/FileSerializer.hpp>
 #include <core/GitGraph.hpp>
@@ -58,6 +60,7 @@
 
 #include <session/SessionUserSettings.hpp>
 #include <session/SessionModuleContext.hpp>
+#include <session/SessionWorkerContext.hpp>
 #include <session/projects/SessionProjects.hpp>
 #include <session/SessionConsoleProcess.hpp>
 
@@ -366,6 +369,60 @@ class Git : public boost::noncopyable
 private:
    FilePath root_;
 
+   // cached repository-level status (see status() for the invalidation
+   // rules which keep it honest)
+   bool statusCacheValid_;
+   StatusResult cachedStatusResult_;
+   std::time_t cachedIndexMtime_;
+   std::time_t cachedHeadMtime_;
+
+   // cursor over the history graph: carries the rev-list position and the
+   // graph lane state forward between log() calls so that paging through
+   // history doesn't replay the whole walk from the tip for every page
+   struct GraphCursor
+   {
+      GraphCursor() : position(0) {}
+      std::string rev;
+      std::string tip;
+      int position;
+      boost::shared_ptr<gitgraph::GitGraph> pGraph;
+   };
+   GraphCursor graphCursor_;
+
+   // cached raw sides of the most recently diffed file, so the diff can
+   // be recomputed in process when the same file is re-requested with
+   // different context or whitespace options (see diffFile)
+   struct DiffSides
+   {
+      DiffSides()
+         : valid(false), mode(PatchModeWorking), fileSize(0),
+           fileMtime(0), indexMtime(0), logsMtime(0)
+      {
+      }
+
+      // COPYING: via compiler (copyable members)
+
+      bool valid;
+      std::string path;
+      PatchMode mode;
+      std::string header;       // git's own file header lines
+      std::string fromContent;
+      std::string toContent;
+      uintmax_t fileSize;
+      std::time_t fileMtime;
+      std::time_t indexMtime;
+      std::time_t logsMtime;
+   };
+   DiffSides diffSides_;
+
+   std::time_t gitMetadataMtime(const char* name) const
+   {
+      FilePath metaPath = root_.childPath(".git").childPath(name);
+      if (!metaPath.exists())
+         return 0;
+      return metaPath.lastWriteTime();
+   }
+
 protected:
    core::Error runGit(const ShellArgs& args,
                       std::string* pStdOut=NULL,
@@ -374,6 +431,9 @@ protected:
    {
       using namespace rstudio::core::system;
 
+      // any git command can change the state summarized by status()
+      statusCacheValid_ = false;
+
       ProcessResult result;
       Error error = gitExec(args, root_, &result);
       if (error)
@@ -460,11 +520,15 @@ protected:
 
 public:
 
-   Git() : root_(FilePath())
+   Git()
+      : root_(FilePath()), statusCacheValid_(false),
+        cachedIndexMtime_(0), cachedHeadMtime_(0)
    {
    }
 
-   Git(const FilePath& root) : root_(root)
+   Git(const FilePath& root)
+      : root_(root), statusCacheValid_(false),
+        cachedIndexMtime_(0), cachedHeadMtime_(0)
    {
    }
 
@@ -485,9 +549,28 @@ public:
    {
       using namespace boost;
 
+      // serve repository-level status from the cache when we can prove
+      // it's current: working tree edits are reported by the project file
+      // monitor (which invalidates the cache) and anything staged or
+      // committed moves the index/HEAD modification times probed here.
+      // this turns the prompt-time status checks from a subprocess fork
+      // plus working tree scan into a couple of stats.
+      bool rootStatus = (dir == root_);
+      std::time_t indexMtime = gitMetadataMtime("index");
+      std::time_t headMtime = gitMetadataMtime("HEAD");
+      if (rootStatus &&
+          statusCacheValid_ &&
+          projects::projectContext().hasFileMonitor() &&
+          indexMtime == cachedIndexMtime_ &&
+          headMtime == cachedHeadMtime_)
+      {
+         *pStatusResult = cachedStatusResult_;
+         return Success();
+      }
+
       // objects to be populated from git's output
       std::vector<FileWithStatus> files;
-      
+
       // build shell arguments
       ShellArgs arguments = gitArgs();
       
@@ -532,9 +615,24 @@ public:
 
       *pStatusResult = StatusResult(files);
 
+      // cache repository-level results (re-probe the metadata mtimes
+      // since running status itself can refresh the index)
+      if (rootStatus)
+      {
+         cachedStatusResult_ = *pStatusResult;
+         cachedIndexMtime_ = gitMetadataMtime("index");
+         cachedHeadMtime_ = gitMetadataMtime("HEAD");
+         statusCacheValid_ = true;
+      }
+
       return Success();
    }
 
+   void invalidateStatusCache()
+   {
+      statusCacheValid_ = false;
+   }
+
    core::Error add(const std::vector<FilePath>& filePaths)
    {
       return runGit(gitArgs() << "add" << "--" << filePaths);
@@ -1023,6 +1121,157 @@ public:
    }
    
 
+   // gathers the stamps which tell us whether cached diff sides for a
+   // file are still current; returns false when the stamps aren't
+   // available (e.g. inside submodules, where .git is a file)
+   bool diffStamps(const FilePath& filePath,
+                   uintmax_t* pFileSize,
+                   std::time_t* pFileMtime,
+                   std::time_t* pIndexMtime,
+                   std::time_t* pLogsMtime)
+   {
+      *pIndexMtime = gitMetadataMtime("index");
+      *pLogsMtime = gitMetadataMtime("logs/HEAD");
+      if (*pIndexMtime == 0 || *pLogsMtime == 0)
+         return false;
+
+      if (filePath.exists())
+      {
+         *pFileSize = filePath.size();
+         *pFileMtime = filePath.lastWriteTime();
+      }
+      else
+      {
+         *pFileSize = 0;
+         *pFileMtime = 0;
+      }
+
+      return true;
+   }
+
+   bool canReuseDiffSides(const FilePath& filePath, PatchMode mode)
+   {
+      if (!diffSides_.valid ||
+          diffSides_.path != filePath.absolutePath() ||
+          diffSides_.mode != mode)
+      {
+         return false;
+      }
+
+      uintmax_t fileSize;
+      std::time_t fileMtime, indexMtime, logsMtime;
+      if (!diffStamps(filePath, &fileSize, &fileMtime, &indexMtime,
+                      &logsMtime))
+         return false;
+
+      return fileSize == diffSides_.fileSize &&
+             fileMtime == diffSides_.fileMtime &&
+             indexMtime == diffSides_.indexMtime &&
+             logsMtime == diffSides_.logsMtime;
+   }
+
+   // strips the (optional) function context which follows the second @@
+   // of each hunk header, so that git's hunks can be compared against
+   // natively generated ones
+   static std::string stripHunkContext(const std::string& hunks)
+   {
+      std::istringstream istr(hunks);
+      std::ostringstream ostr;
+      std::string line;
+      while (std::getline(istr, line))
+      {
+         if (line.compare(0, 4, "@@ -") == 0)
+         {
+            std::string::size_type pos = line.find("@@", 4);
+            if (pos != std::string::npos)
+               line.erase(pos + 2);
+         }
+         ostr << line << "\n";
+      }
+      return ostr.str();
+   }
+
+   void captureDiffSides(const FilePath& filePath,
+                         PatchMode mode,
+                         int contextLines,
+                         bool ignoreWhitespace,
+                         const std::string& output)
+   {
+      diffSides_.valid = false;
+
+      // only a reasonably sized plain text diff of a single blob pair
+      // can be recomputed in process
+      std::size_t hunkPos = output.find("\n@@ -");
+      if (hunkPos == std::string::npos ||
+          output.size() > source_control::WARN_SIZE)
+         return;
+      std::string header = output.substr(0, hunkPos + 1);
+      if (header.find("\nrename ") != std::string::npos ||
+          header.find("\ncopy ") != std::string::npos)
+         return;
+
+      // stamp the state the sides will correspond to (before reading
+      // them, so a concurrent change invalidates rather than poisons the
+      // cache)
+      uintmax_t fileSize;
+      std::time_t fileMtime, indexMtime, logsMtime;
+      if (!diffStamps(filePath, &fileSize, &fileMtime, &indexMtime,
+                      &logsMtime))
+         return;
+
+      if (!filePath.isWithin(root_))
+         return;
+      std::string relative = filePath.relativePath(root_);
+
+      // read both sides of the diff
+      std::string fromContent, toContent;
+      int exitCode = EXIT_SUCCESS;
+      Error error;
+      if (mode == PatchModeStage)
+      {
+         error = runGit(gitArgs() << "show" << "HEAD:" + relative,
+                        &fromContent, NULL, &exitCode);
+         if (error || exitCode != EXIT_SUCCESS)
+            return;
+         error = runGit(gitArgs() << "show" << ":" + relative,
+                        &toContent, NULL, &exitCode);
+      }
+      else
+      {
+         error = runGit(gitArgs() << "show" << ":" + relative,
+                        &fromContent, NULL, &exitCode);
+         if (error || exitCode != EXIT_SUCCESS)
+            return;
+         error = core::readStringFromFile(filePath, &toContent);
+      }
+      if (error || exitCode != EXIT_SUCCESS)
+         return;
+
+      // only trust the sides if we reproduce git's hunks from them; this
+      // bails out when git applied content filters we don't model (e.g.
+      // CRLF conversion), or when our matcher makes different -- though
+      // equally valid -- hunk choices for ambiguous content
+      diff::DiffOptions options;
+      options.contextLines = contextLines;
+      options.ignoreWhitespace = ignoreWhitespace;
+      std::string native = diff::unifiedDiff(fromContent, toContent,
+                                             options);
+      if (stripHunkContext(native) !=
+          stripHunkContext(output.substr(hunkPos + 1)))
+         return;
+
+      diffSides_.path = filePath.absolutePath();
+      diffSides_.mode = mode;
+      diffSides_.header = header;
+      diffSides_.fromContent = fromContent;
+      diffSides_.toContent = toContent;
+      diffSides_.fileSize = fileSize;
+      diffSides_.fileMtime = fileMtime;
+      diffSides_.indexMtime = indexMtime;
+      diffSides_.logsMtime = logsMtime;
+      diffSides_.valid = true;
+   }
+
    core::Error doDiffFile(const FilePath& filePath,
                           const FilePath* pCompareTo,
                           PatchMode mode,
@@ -1050,6 +1299,23 @@ public:
                         bool ignoreWhitespace,
                         std::string* pOutput)
    {
+      // serve from the cached sides when nothing relevant has changed
+      // since they were captured; this keeps re-requests of the same
+      // diff (e.g. with more context while reviewing a large file) from
+      // paying for a subprocess round trip each time
+      if (canReuseDiffSides(filePath, mode))
+      {
+         diff::DiffOptions options;
+         options.contextLines = contextLines;
+         options.ignoreWhitespace = ignoreWhitespace;
+         std::string hunks = diff::unifiedDiff(diffSides_.fromContent,
+                                               diffSides_.toContent,
+                                               options);
+         *pOutput = hunks.empty() ? std::string() :
+                                    diffSides_.header + hunks;
+         return Success();
+      }
+
       Error error = doDiffFile(filePath, NULL, mode, contextLines, ignoreWhitespace, pOutput);
       if (error)
          return error;
@@ -1073,6 +1339,11 @@ public:
                return error;
          }
       }
+      else
+      {
+         captureDiffSides(filePath, mode, contextLines, ignoreWhitespace,
+                          *pOutput);
+      }
 
       return Success();
    }
@@ -1193,6 +1464,7 @@ public:
 
       ShellArgs revListArgs = gitArgs() << "rev-list" << "--date-order" << "--parents";
       int revListSkip = skip;
+      int revListMaxCount = -1;
 
       if (!fileFilter.empty())
       {
@@ -1212,10 +1484,8 @@ public:
          if (maxentries >= 0)
          {
             args << "--max-count=" + safe_convert::numberToString(maxentries);
+            revListMaxCount = (revListSkip < 0 ? 0 : revListSkip) + maxentries;
             maxentries = -1;
-
-            revListArgs << "--max-count=" + safe_convert::numberToString(
-                  (skip < 0 ? 0 : skip) + maxentries);
          }
       }
 
@@ -1243,6 +1513,40 @@ public:
       std::vector<std::string> graphLines;
       if (searchText.empty() && fileFilter.empty())
       {
+         // resolve the tip so we can tell whether the graph cursor left
+         // behind by the previous page is still describing this history
+         std::string cursorRev = rev.empty() ? "HEAD" : rev;
+         std::string tip;
+         error = runGit(gitArgs() << "rev-parse" << cursorRev, &tip);
+         if (error)
+            return error;
+         boost::algorithm::trim(tip);
+
+         // when this request continues the page sequence we've already
+         // walked, resume the rev-list walk and the graph lane state where
+         // the last page stopped instead of replaying from the tip; any
+         // other request (first page, out-of-order skip, history rewritten)
+         // starts a fresh walk
+         bool resume = graphCursor_.pGraph &&
+                       graphCursor_.rev == cursorRev &&
+                       graphCursor_.tip == tip &&
+                       revListSkip > 0 &&
+                       graphCursor_.position == revListSkip;
+         if (!resume)
+         {
+            graphCursor_ = GraphCursor();
+            graphCursor_.pGraph.reset(new gitgraph::GitGraph());
+            graphCursor_.rev = cursorRev;
+            graphCursor_.tip = tip;
+         }
+
+         if (graphCursor_.position > 0)
+            revListArgs << "--skip=" +
+                  safe_convert::numberToString(graphCursor_.position);
+         if (revListMaxCount >= 0)
+            revListArgs << "--max-count=" + safe_convert::numberToString(
+                  revListMaxCount - graphCursor_.position);
+
          std::vector<std::string> revOutLines;
          std::string revOutput;
          error = runGit(revListArgs, &revOutput);
@@ -1251,7 +1555,8 @@ public:
          revOutLines = split(revOutput);
          revOutput.clear();
 
-         gitgraph::GitGraph graph;
+         gitgraph::GitGraph& graph = *graphCursor_.pGraph;
+         int startPosition = graphCursor_.position;
          for (size_t i = 0; i < revOutLines.size(); i++)
          {
             typedef std::vector<std::string> find_vector_type;
@@ -1265,8 +1570,12 @@ public:
             parents.erase(parents.begin());
 
             gitgraph::Line line = graph.addCommit(commit, parents);
-            if (revListSkip <= 0 || static_cast<int>(i) >= revListSkip)
+            graphCursor_.position++;
+            if (revListSkip <= 0 ||
+                startPosition + static_cast<int>(i) >= revListSkip)
+            {
                graphLines.push_back(line.string());
+            }
          }
       }
 
@@ -1450,6 +1759,20 @@ public:
 
 Git s_git_;
 
+// working tree changes observed by the project file monitor invalidate
+// the cached status (git metadata changes are caught by the mtime probes
+// in Git::status)
+void onWorkingTreeFilesChanged(
+                  const std::vector<core::system::FileChangeEvent>& changes)
+{
+   s_git_.invalidateStatusCache();
+}
+
+void onFileMonitorDisabled()
+{
+   s_git_.invalidateStatusCache();
+}
+
 FilePath resolveAliasedPath(const std::string& path)
 {
    if (boost::algorithm::starts_with(path, "~/"))
@@ -3039,6 +3362,19 @@ bool isGitInstalled()
    if (!userSettings().vcsEnabled())
       return false;
 
+   // memoize the probe (it forks `git --version` and is asked both at
+   // module init and again when building the client init payload);
+   // re-probe only if the configured executable changes
+   static bool s_haveResult = false;
+   static bool s_installed = false;
+   static std::string s_probedExePath;
+   if (s_haveResult && s_probedExePath == s_gitExePath)
+      return s_installed;
+
+   s_probedExePath = s_gitExePath;
+   s_haveResult = true;
+   s_installed = false;
+
    // special handling for mavericks for case where there is /usr/bin/git
    // but it's the fake on installed by osx
    if ((s_gitExePath.empty() || s_gitExePath == "/usr/bin/git") &&
@@ -3055,7 +3391,8 @@ bool isGitInstalled()
                                           &result);
    if (error)
       return false;
-   return result.exitStatus == EXIT_SUCCESS;
+   s_installed = (result.exitStatus == EXIT_SUCCESS);
+   return s_installed;
 }
 
 bool isGitEnabled()
@@ -3235,6 +3572,26 @@ bool isGithubRepository()
 }
 
 
+namespace {
+
+void primeStatusCache()
+{
+   // warm the repository-level status cache so the first consumer (the
+   // VCS pane, prompt-time decoration) gets a cache hit instead of
+   // paying for the initial working tree scan, then nudge the client so
+   // it renders from the warm cache
+   StatusResult statusResult;
+   Error error = git::status(s_git_.root(), &statusResult);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+   enqueueRefreshEvent();
+}
+
+} // anonymous namespace
+
 core::Error initializeGit(const core::FilePath& workingDir)
 {
    s_git_.setRoot(detectGitDir(workingDir));
@@ -3245,6 +3602,13 @@ core::Error initializeGit(const core::FilePath& workingDir)
       Error error = augmentGitIgnore(gitIgnore);
       if (error)
          LOG_ERROR(error);
+
+      // prime the status cache in the background rather than leaving
+      // the initial scan on the first interactive request
+      module_context::scheduleDelayedWork(
+               "prime git status",
+               boost::posix_time::seconds(1),
+               primeStatusCache);
    }
 
    return Success();
@@ -3272,6 +3636,16 @@ core::Error initialize()
 
    module_context::events().onShutdown.connect(onShutdown);
 
+   // subscribe to the project file monitor so working tree changes
+   // invalidate the cached status
+   if (projects::projectContext().hasProject())
+   {
+      session::projects::FileMonitorCallbacks cb;
+      cb.onFilesChanged = onWorkingTreeFilesChanged;
+      cb.onMonitoringDisabled = onFileMonitorDisabled;
+      projects::projectContext().subscribeToFileMonitor("", cb);
+   }
+
    initGitBin();
 
    bool interceptAskPass;
@@ -3341,8 +3715,11 @@ core::Error initialize()
       (bind(registerRpcMethod, "git_pull_rebase", vcsPullRebase))
       (bind(registerRpcMethod, "git_diff_file", vcsDiffFile))
       (bind(registerRpcMethod, "git_apply_patch", vcsApplyPatch))
-      (bind(registerRpcMethod, "git_history_count", vcsHistoryCount))
-      (bind(registerRpcMethod, "git_history", vcsHistory))
+      // history methods run on worker threads (they only exec git and
+      // parse its output, never touching R) so browsing history doesn't
+      // block the R thread on slow repositories or network filesystems
+      (bind(worker_context::registerWorkerRpcMethod, "git_history_count", vcsHistoryCount))
+      (bind(worker_context::registerWorkerRpcMethod, "git_history", vcsHistory))
       (bind(registerRpcMethod, "git_show", vcsShow))
       (bind(registerRpcMethod, "git_show_file", vcsShowFile))
       (bind(registerRpcMethod, "git_export_file", vcsExportFile))
@@ -17,6 +17,7 @@
 #include "SessionHTMLPreview.hpp"
 
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
 #include <boost/format.hpp>
 #include <boost/enable_shared_from_this.hpp>
 
@@ -31,6 +32,7 @@
 #include <core/Error.hpp>
 #include <core/Exec.hpp>
 #include <core/FileSerializer.hpp>
+#include <core/Hash.hpp>
 #include <core/HtmlUtils.hpp>
 #include <core/http/Util.hpp>
 #include <core/PerformanceTimer.hpp>
@@ -93,6 +95,54 @@ void enqueHTMLPreviewSucceeded(const std::string& title,
    module_context::enqueClientEvent(event);
 }
 
+// cache of rendered HTML per markdown segment (keyed by target file and
+// segment content hash) so preview refreshes only re-render the segments
+// whose content actually changed
+std::map<std::string, std::map<std::string, std::string> > s_segmentHtmlCache;
+
+// render markdown to HTML, re-using previously rendered HTML for segments
+// whose content (and visible reference definitions) are unchanged since
+// the last preview of this file
+Error renderMarkdownIncremental(const std::string& targetPath,
+                                const std::string& markdown,
+                                std::string* pHTMLOutput)
+{
+   std::vector<std::string> segments;
+   std::string refDefs;
+   markdown::splitMarkdownSegments(markdown, &segments, &refDefs);
+
+   std::map<std::string, std::string>& cache = s_segmentHtmlCache[targetPath];
+   std::map<std::string, std::string> renderedCache;
+   std::string html;
+   BOOST_FOREACH(const std::string& segment, segments)
+   {
+      std::string key = hash::crc32HexHash(segment + refDefs);
+      std::map<std::string, std::string>::const_iterator it = cache.find(key);
+      std::string segmentHtml;
+      if (it != cache.end())
+      {
+         segmentHtml = it->second;
+      }
+      else
+      {
+         Error error = markdown::markdownToHTML(segment + "\n" + refDefs,
+                                                markdown::Extensions(),
+                                                markdown::HTMLOptions(),
+                                                &segmentHtml);
+         if (error)
+            return error;
+      }
+      renderedCache[key] = segmentHtml;
+      html.append(segmentHtml);
+   }
+
+   // retain only the segments used by this render (drops stale entries)
+   cache.swap(renderedCache);
+
+   *pHTMLOutput = html;
+   return Success();
+}
+
 class HTMLPreview : public async_r::AsyncRProcess
 {
 public:
@@ -370,12 +420,12 @@ private:
             // highlighting, base64 encoding, etc.)
             isInternalMarkdown_ = true;
 
-            // run markdownToHTML
+            // run markdownToHTML, re-rendering only the top-level
+            // segments whose content changed since the last preview
             std::string htmlContent;
-            Error error = markdown::markdownToHTML(
+            Error error = renderMarkdownIncremental(
+                                            targetFile_.absolutePath(),
                                             content,
-                                            markdown::Extensions(),
-                                            markdown::HTMLOptions(),
                                             &htmlContent);
             if (error)
             {
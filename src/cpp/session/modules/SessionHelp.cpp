@@ -16,7 +16,9 @@
 #include "SessionHelp.hpp"
 
 #include <algorithm>
+#include <set>
 
+#include <boost/bind.hpp>
 #include <boost/regex.hpp>
 #include <boost/function.hpp>
 #include <boost/format.hpp>
@@ -33,6 +35,10 @@
 #include <core/http/Response.hpp>
 #include <core/http/URL.hpp>
 #include <core/FileSerializer.hpp>
+#include <core/Hash.hpp>
+#include <core/Thread.hpp>
+#include <core/system/System.hpp>
+#include <core/system/MemoryMappedFile.hpp>
 #include <core/system/Process.hpp>
 #include <core/system/ShellUtils.hpp>
 #include <core/r_util/RPackageInfo.hpp>
@@ -48,6 +54,7 @@
 #include <r/session/RSessionUtils.hpp>
 
 #include <session/SessionModuleContext.hpp>
+#include <session/projects/SessionProjectSharing.hpp>
 
 #include "presentation/SlideRequestHandler.hpp"
 
@@ -321,10 +328,11 @@ void setDynamicContentResponse(const std::string& content,
    
 
 template <typename Filter>
-void handleHttpdResult(SEXP httpdSEXP, 
-                       const http::Request& request, 
+void handleHttpdResult(SEXP httpdSEXP,
+                       const http::Request& request,
                        const Filter& htmlFilter,
-                       http::Response* pResponse)
+                       http::Response* pResponse,
+                       std::string* pRenderedHtml = NULL)
 {
    // NOTE: this function is a port of process_request in Rhttpd.c
    // (that function is coupled to sending its results via the R http daemon, 
@@ -437,7 +445,12 @@ void handleHttpdResult(SEXP httpdSEXP,
             // set body (apply filter to html)
             if (pResponse->contentType() == kTextHtml)
             {
-               setDynamicContentResponse(content, 
+               // hand the unfiltered render back to the caller (used to
+               // populate the shared help render cache)
+               if (pRenderedHtml)
+                  *pRenderedHtml = content;
+
+               setDynamicContentResponse(content,
                                          request, 
                                          htmlFilter, 
                                          pResponse);
@@ -683,9 +696,10 @@ void handleRdPreviewRequest(const http::Request& request,
 template <typename Filter>
 void handleHttpdRequest(const std::string& location,
                         const HandlerSource& handlerSource,
-                        const http::Request& request, 
+                        const http::Request& request,
                         const Filter& filter,
-                        http::Response* pResponse)
+                        http::Response* pResponse,
+                        std::string* pRenderedHtml = NULL)
 {
    // get the requested path
    std::string path = http::util::pathAfterPrefix(request, location);
@@ -772,7 +786,7 @@ void handleHttpdRequest(const std::string& location,
    // content returned from httpd
    else if (TYPEOF(httpdSEXP) == VECSXP && LENGTH(httpdSEXP) > 0)
    {
-      handleHttpdResult(httpdSEXP, request, filter, pResponse);
+      handleHttpdResult(httpdSEXP, request, filter, pResponse, pRenderedHtml);
    }
    
    // unexpected SEXP type returned from httpd
@@ -899,16 +913,122 @@ void handlePythonHelpRequest(const http::Request& request,
    
 }
 
+// Shared help render cache ----
+//
+// the R help server renders Rd to HTML on every page view, and every
+// session on the machine repeats that render for the same installed
+// packages. we keep the rendered HTML in a content-addressed cache --
+// shared across all sessions when server shared storage is configured,
+// per-user otherwise -- so each page pays the Rd render cost only once
+// per package install
+
+FilePath helpRenderCachePath()
+{
+   std::string sharedStoragePath = session::options().getOverlayOption(
+                                                   kSessionSharedStoragePath);
+   if (!sharedStoragePath.empty())
+      return FilePath(sharedStoragePath).complete("help-render-cache");
+   else
+      return module_context::userScratchPath().complete("help-render-cache");
+}
+
+// resolve the cache file for a help request -- returns an empty path for
+// requests we don't cache (only package Rd pages rendered by the R help
+// server, i.e. /library/<pkg>/html/<topic>.html, are cached)
+FilePath helpRenderCacheFile(const http::Request& request)
+{
+   std::string path = http::util::pathAfterPrefix(request, kHelpLocation);
+
+   boost::regex rdPageRegex(
+            "/library/([A-Za-z0-9._]+)/html/([A-Za-z0-9._\\-]+)\\.html");
+   boost::smatch match;
+   if (!regex_utils::match(path, match, rdPageRegex))
+      return FilePath();
+   std::string pkgName = match[1];
+   std::string topic = match[2];
+
+   // locate the installed package (the rendered page depends on its bits)
+   FilePath pkgPath;
+   std::vector<FilePath> libPaths = module_context::getLibPaths();
+   for (std::size_t i = 0; i < libPaths.size(); i++)
+   {
+      FilePath candidatePath = libPaths[i].childPath(pkgName);
+      if (candidatePath.childPath("DESCRIPTION").exists())
+      {
+         pkgPath = candidatePath;
+         break;
+      }
+   }
+   if (pkgPath.empty())
+      return FilePath();
+
+   // content-address the page: everything the rendered HTML depends on
+   // (the page identity, the R version, and the installed package bits
+   // as proxied by the DESCRIPTION write time) feeds the hash, so a
+   // package re-install or R upgrade naturally misses the old entries
+   std::ostringstream ostr;
+   ostr << module_context::rVersion() << ";"
+        << pkgPath.absolutePath() << ";"
+        << pkgPath.childPath("DESCRIPTION").lastWriteTime() << ";"
+        << path << "?" << request.queryString();
+   return helpRenderCachePath().complete(
+            pkgName + "-" + topic + "-" +
+            core::hash::crc32HexHash(ostr.str()) + ".html");
+}
+
+void updateHelpRenderCache(const FilePath& cacheFile,
+                           const std::string& renderedHtml)
+{
+   // write to a temp file in the cache directory then move it into
+   // place, so concurrent sessions never observe a partial render
+   Error error = cacheFile.parent().ensureDirectory();
+   if (!error)
+   {
+      FilePath tempFile(cacheFile.absolutePath() + "." +
+            safe_convert::numberToString(core::system::currentProcessId()) +
+            ".tmp");
+      error = core::writeStringToFile(tempFile, renderedHtml);
+      if (!error)
+         error = tempFile.move(cacheFile);
+   }
+   if (error)
+      LOG_ERROR(error);
+}
+
 // the ShowHelp event will result in the Help pane requesting the specified
 // help url. we handle this request directly by calling the R httpd function
 // to dynamically form the correct http response
 void handleHelpRequest(const http::Request& request, http::Response* pResponse)
 {
+   // check the shared render cache first -- serving the stored HTML
+   // (with the usual help filter applied) skips the Rd render in R
+   FilePath cacheFile = helpRenderCacheFile(request);
+   if (!cacheFile.empty() && cacheFile.exists())
+   {
+      std::string content;
+      Error error = core::readStringFromFile(cacheFile, &content);
+      if (!error)
+      {
+         pResponse->setContentType("text/html");
+         setDynamicContentResponse(content,
+                                   request,
+                                   HelpContentsFilter(request),
+                                   pResponse);
+         return;
+      }
+      LOG_ERROR(error);
+   }
+
+   std::string renderedHtml;
    handleHttpdRequest(kHelpLocation,
                       boost::bind(r::sexp::findFunction, "httpd", "tools"),
                       request,
                       HelpContentsFilter(request),
-                      pResponse);
+                      pResponse,
+                      cacheFile.empty() ? NULL : &renderedHtml);
+
+   if (!cacheFile.empty() && !renderedHtml.empty())
+      updateHelpRenderCache(cacheFile, renderedHtml);
 }
 
 SEXP rs_previewRd(SEXP rdFileSEXP)
@@ -931,6 +1051,256 @@ SEXP rs_showPythonHelp(SEXP codeSEXP)
    return R_NilValue;
 }
 
+// Native help topic index ----
+//
+// utils:::matchAvailableTopics walks the Rd indexes of every installed
+// package through R, which makes the first help topic search of a
+// session take seconds on network libraries. we maintain a compact
+// on-disk index of help topics (the alias tables from each package's
+// help/AnIndex file), memory map it, and serve topic lookups from the
+// mapped pages directly; the index is rebuilt on a background thread
+// whenever the library state (lib paths + their mtimes) changes
+
+const char * const kHelpTopicIndexFormat = "help-topic-index-v1";
+
+// memory mapped index plus a table of (pointer, length) entries
+// referencing the sorted topics within the mapped pages
+boost::shared_ptr<core::system::MemoryMappedFile> s_pTopicIndexFile;
+std::vector<std::pair<const char*, std::size_t> > s_topicIndex;
+
+// background build state
+boost::mutex s_topicIndexMutex;
+bool s_topicIndexBuildRunning = false;
+bool s_topicIndexBuildComplete = false;
+
+FilePath helpTopicIndexPath()
+{
+   return module_context::userScratchPath().complete("help-topic-index");
+}
+
+bool loadTopicIndex(const std::string& expectedHash)
+{
+   s_topicIndex.clear();
+   s_pTopicIndexFile.reset();
+
+   FilePath indexPath = helpTopicIndexPath();
+   if (!indexPath.exists())
+      return false;
+
+   boost::shared_ptr<core::system::MemoryMappedFile> pMapped(
+                                       new core::system::MemoryMappedFile());
+   Error error = pMapped->open(indexPath);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return false;
+   }
+
+   const char* pData = static_cast<const char*>(pMapped->data());
+   const char* pEnd = pData + pMapped->size();
+
+   // walk the lines: format, library state, then one topic per line
+   std::vector<std::pair<const char*, std::size_t> > index;
+   const char* pLine = pData;
+   int lineNumber = 0;
+   while (pLine < pEnd)
+   {
+      const char* pNewline = std::find(pLine, pEnd, '\n');
+      std::size_t length = pNewline - pLine;
+
+      if (lineNumber == 0)
+      {
+         if (std::string(pLine, length) != kHelpTopicIndexFormat)
+            return false;
+      }
+      else if (lineNumber == 1)
+      {
+         // stale index (the library state has changed)
+         if (std::string(pLine, length) != expectedHash)
+            return false;
+      }
+      else if (length > 0)
+      {
+         index.push_back(std::make_pair(pLine, length));
+      }
+
+      lineNumber++;
+      pLine = pNewline + 1;
+   }
+
+   s_pTopicIndexFile = pMapped;
+   s_topicIndex.swap(index);
+   return true;
+}
+
+// executed on a background thread (does not touch the R runtime)
+void buildTopicIndex(std::vector<FilePath> libPaths,
+                     std::string libraryHash,
+                     FilePath indexPath)
+{
+   try
+   {
+      // collect unique topics from each package's help/AnIndex file
+      // (the tab separated alias -> Rd file table maintained by R)
+      std::set<std::string> topics;
+      for (std::size_t i = 0; i < libPaths.size(); i++)
+      {
+         std::vector<FilePath> pkgPaths;
+         Error error = libPaths[i].children(&pkgPaths);
+         if (error)
+            continue;
+
+         for (std::size_t j = 0; j < pkgPaths.size(); j++)
+         {
+            FilePath anIndexPath = pkgPaths[j].childPath("help/AnIndex");
+            if (!anIndexPath.exists())
+               continue;
+
+            std::vector<std::string> lines;
+            error = core::readStringVectorFromFile(anIndexPath, &lines);
+            if (error)
+            {
+               LOG_ERROR(error);
+               continue;
+            }
+
+            for (std::size_t k = 0; k < lines.size(); k++)
+            {
+               std::string::size_type tabPos = lines[k].find('\t');
+               if (tabPos != std::string::npos && tabPos > 0)
+                  topics.insert(lines[k].substr(0, tabPos));
+            }
+         }
+      }
+
+      // write to a temporary file and move it into place (note that
+      // std::set iterates in the byte-wise order the prefix search
+      // relies on)
+      std::ostringstream ostr;
+      ostr << kHelpTopicIndexFormat << "\n" << libraryHash << "\n";
+      for (std::set<std::string>::const_iterator it = topics.begin();
+           it != topics.end();
+           ++it)
+      {
+         ostr << *it << "\n";
+      }
+
+      FilePath tempPath(indexPath.absolutePath() + ".tmp");
+      Error error = core::writeStringToFile(tempPath, ostr.str());
+      if (!error)
+         error = tempPath.move(indexPath);
+      if (error)
+         LOG_ERROR(error);
+   }
+   CATCH_UNEXPECTED_EXCEPTION
+
+   LOCK_MUTEX(s_topicIndexMutex)
+   {
+      s_topicIndexBuildComplete = true;
+   }
+   END_LOCK_MUTEX
+}
+
+bool checkTopicIndexBuild(std::string libraryHash)
+{
+   bool complete = false;
+   LOCK_MUTEX(s_topicIndexMutex)
+   {
+      complete = s_topicIndexBuildComplete;
+   }
+   END_LOCK_MUTEX
+
+   // keep polling until the background build finishes
+   if (!complete)
+      return true;
+
+   s_topicIndexBuildRunning = false;
+   LOCK_MUTEX(s_topicIndexMutex)
+   {
+      s_topicIndexBuildComplete = false;
+   }
+   END_LOCK_MUTEX
+
+   loadTopicIndex(libraryHash);
+   return false;
+}
+
+void updateTopicIndex()
+{
+   if (s_topicIndexBuildRunning)
+      return;
+
+   std::vector<FilePath> libPaths = module_context::getLibPaths();
+   std::string libraryHash = module_context::libraryStateHash(libPaths);
+
+   // if the on-disk index matches the current library state then
+   // just (re)load it
+   if (loadTopicIndex(libraryHash))
+      return;
+
+   // rebuild in the background and load the result once it completes
+   s_topicIndexBuildRunning = true;
+   core::thread::safeLaunchThread(boost::bind(buildTopicIndex,
+                                              libPaths,
+                                              libraryHash,
+                                              helpTopicIndexPath()));
+
+   module_context::schedulePeriodicWork(
+            "help-topic-index",
+            boost::posix_time::milliseconds(500),
+            boost::bind(checkTopicIndexBuild, libraryHash),
+            true,    // idle only
+            false);  // not immediate
+}
+
+void onDeferredInitHelpTopics(bool)
+{
+   updateTopicIndex();
+}
+
+struct TopicPrefixCompare
+{
+   bool operator()(const std::pair<const char*, std::size_t>& entry,
+                   const std::string& prefix) const
+   {
+      return std::lexicographical_compare(entry.first,
+                                          entry.first + entry.second,
+                                          prefix.begin(),
+                                          prefix.end());
+   }
+};
+
+SEXP rs_suggestHelpTopics(SEXP prefixSEXP)
+{
+   // fall back to R when the native index isn't available
+   if (s_topicIndex.empty())
+      return R_NilValue;
+
+   std::string prefix = r::sexp::safeAsString(prefixSEXP);
+
+   // binary search to the first topic with this prefix, then collect
+   // the range of topics sharing it
+   std::vector<std::string> topics;
+   std::vector<std::pair<const char*, std::size_t> >::const_iterator it =
+         std::lower_bound(s_topicIndex.begin(),
+                          s_topicIndex.end(),
+                          prefix,
+                          TopicPrefixCompare());
+   for (; it != s_topicIndex.end(); ++it)
+   {
+      if (it->second < prefix.length() ||
+          !std::equal(prefix.begin(), prefix.end(), it->first))
+      {
+         break;
+      }
+
+      topics.push_back(std::string(it->first, it->second));
+   }
+
+   r::sexp::Protect protect;
+   return r::sexp::create(topics, &protect);
+}
+
 } // anonymous namespace
    
 Error initialize()
@@ -940,6 +1310,10 @@ Error initialize()
 
    RS_REGISTER_CALL_METHOD(rs_previewRd, 1);
    RS_REGISTER_CALL_METHOD(rs_showPythonHelp, 1);
+   RS_REGISTER_CALL_METHOD(rs_suggestHelpTopics, 1);
+
+   // build/load the native help topic index once startup has quiesced
+   module_context::events().onDeferredInit.connect(onDeferredInitHelpTopics);
 
    using boost::bind;
    using core::http::UriHandler;
@@ -78,11 +78,8 @@ Error setJsonResultFromHistory(int startIndex,
                                int endIndex,
                                json::JsonRpcResponse* pResponse)
 {
-   // get all entries
-   const std::vector<HistoryEntry>& allEntries = historyArchive().entries();
-
    // validate indexes
-   int historySize = allEntries.size();
+   int historySize = historyArchive().entryCount();
    if ( (startIndex < 0)               ||
         (startIndex > historySize)     ||
         (endIndex < 0)                 ||
@@ -90,12 +87,14 @@ Error setJsonResultFromHistory(int startIndex,
    {
       return Error(json::errc::ParamInvalid, ERROR_LOCATION);
    }
-   
-   // return the entries
+
+   // return the entries (only the requested window is materialized)
    std::vector<HistoryEntry> entries;
-   std::copy(allEntries.begin() + startIndex,
-             allEntries.begin() + endIndex,
-             std::back_inserter(entries));
+   Error error = historyArchive().entriesForRange(startIndex,
+                                                  endIndex,
+                                                  &entries);
+   if (error)
+      return error;
    json::Object entriesJson;
    historyEntriesAsJson(entries, &entriesJson);
    pResponse->setResult(entriesJson);
@@ -104,7 +103,7 @@ Error setJsonResultFromHistory(int startIndex,
    
 bool matches(const HistoryEntry& entry,
              const std::vector<std::string>& searchTerms)
-{   
+{
    // look for each search term in the input
    for (std::vector<std::string>::const_iterator it = searchTerms.begin();
         it != searchTerms.end();
@@ -113,11 +112,71 @@ bool matches(const HistoryEntry& entry,
       if (!boost::algorithm::contains(entry.command, *it))
          return false;
    }
-   
+
    // had all of the search terms, return true
    return true;
 }
 
+// incremental archive search: entries are visited newest-to-oldest and
+// only matches accumulate, so the full archive is never materialized
+class ArchiveSearcher : boost::noncopyable
+{
+public:
+   ArchiveSearcher(const std::vector<std::string>& searchTerms,
+                   int maxEntries)
+      : searchTerms_(searchTerms), maxEntries_(maxEntries)
+   {
+   }
+
+   bool operator()(const HistoryEntry& entry)
+   {
+      if (matches(entry, searchTerms_))
+         entries_.push_back(entry);
+      return entries_.size() < static_cast<std::size_t>(maxEntries_);
+   }
+
+   const std::vector<HistoryEntry>& entries() const { return entries_; }
+
+private:
+   std::vector<std::string> searchTerms_;
+   int maxEntries_;
+   std::vector<HistoryEntry> entries_;
+};
+
+// as above, but matching on a command prefix (optionally unique)
+class ArchivePrefixSearcher : boost::noncopyable
+{
+public:
+   ArchivePrefixSearcher(const std::string& prefix,
+                         int maxEntries,
+                         bool uniqueOnly)
+      : prefix_(prefix), maxEntries_(maxEntries), uniqueOnly_(uniqueOnly)
+   {
+   }
+
+   bool operator()(const HistoryEntry& entry)
+   {
+      if (boost::algorithm::starts_with(entry.command, prefix_))
+      {
+         if (!uniqueOnly_ || (matchedCommands_.count(entry.command) == 0))
+         {
+            entries_.push_back(entry);
+            matchedCommands_.insert(entry.command);
+         }
+      }
+      return entries_.size() < static_cast<std::size_t>(maxEntries_);
+   }
+
+   const std::vector<HistoryEntry>& entries() const { return entries_; }
+
+private:
+   std::string prefix_;
+   int maxEntries_;
+   bool uniqueOnly_;
+   std::set<std::string> matchedCommands_;
+   std::vector<HistoryEntry> entries_;
+};
+
 
 void historyRangeAsJson(int startIndex,
                         int endIndex,
@@ -247,7 +306,7 @@ Error getHistoryArchiveItems(const json::JsonRpcRequest& request,
       return error;
    
    // truncate indexes if necessary
-   int historySize = historyArchive().entries().size();
+   int historySize = historyArchive().entryCount();
    startIndex = std::min(startIndex, historySize);
    endIndex = std::min(endIndex, historySize);
    
@@ -318,29 +377,14 @@ Error searchHistoryArchive(const json::JsonRpcRequest& request,
    boost::tokenizer<boost::char_separator<char> > tok(query, sep);
    std::copy(tok.begin(), tok.end(), std::back_inserter(searchTerms));
    
-   // examine the items in the history for matches
-   const std::vector<HistoryEntry>& allEntries = historyArchive().entries();
-   std::vector<HistoryEntry> matchingEntries;
-   for (std::vector<HistoryEntry>::const_reverse_iterator 
-            it = allEntries.rbegin();
-            it != allEntries.rend();
-            ++it)
-   {
-      // check limit
-      if (matchingEntries.size() >= static_cast<std::size_t>(maxEntries))
-         break;
-
-      // look for match
-      if (matches(*it, searchTerms))
-      {
-         // add entry
-         matchingEntries.push_back(*it);
-      }
-   }
+   // examine the items in the history for matches (newest first,
+   // stopping as soon as we have maxEntries of them)
+   ArchiveSearcher searcher(searchTerms, maxEntries);
+   historyArchive().scanReverse(boost::ref(searcher));
 
    // return json
    json::Object entriesJson;
-   historyEntriesAsJson(matchingEntries, &entriesJson);
+   historyEntriesAsJson(searcher.entries(), &entriesJson);
    pResponse->setResult(entriesJson);
    return Success();
 }
@@ -360,33 +404,14 @@ Error searchHistoryArchiveByPrefix(const json::JsonRpcRequest& request,
    // trim the prefix
    boost::algorithm::trim(prefix);
    
-   // examine the items in the history for matches
-   const std::vector<HistoryEntry>& allEntries = historyArchive().entries();
-   std::set<std::string> matchedCommands;
-   std::vector<HistoryEntry> matchingEntries;
-   for (std::vector<HistoryEntry>::const_reverse_iterator 
-        it = allEntries.rbegin();
-        it != allEntries.rend();
-        ++it)
-   {
-      // check limit
-      if (matchingEntries.size() >= static_cast<std::size_t>(maxEntries))
-         break;
-      
-      // look for match 
-      if (boost::algorithm::starts_with(it->command, prefix))
-      {
-         if (!uniqueOnly || (matchedCommands.count(it->command) == 0))
-         {
-            matchingEntries.push_back(*it);
-            matchedCommands.insert(it->command);
-         }
-      }
-   }
-   
+   // examine the items in the history for matches (newest first,
+   // stopping as soon as we have maxEntries of them)
+   ArchivePrefixSearcher searcher(prefix, maxEntries, uniqueOnly);
+   historyArchive().scanReverse(boost::ref(searcher));
+
    // return json
    json::Object entriesJson;
-   historyEntriesAsJson(matchingEntries, &entriesJson);
+   historyEntriesAsJson(searcher.entries(), &entriesJson);
    pResponse->setResult(entriesJson);
    return Success();
 }
@@ -15,13 +15,20 @@
 
 #include "SessionHistoryArchive.hpp"
 
+#include <cstring>
+
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include <core/Error.hpp>
 #include <core/Log.hpp>
 #include <core/FilePath.hpp>
 #include <core/DateTime.hpp>
 #include <core/FileSerializer.hpp>
+#include <core/SafeConvert.hpp>
+
+#include <core/system/MemoryMappedFile.hpp>
 
 #include <r/session/RConsoleHistory.hpp>
 
@@ -31,11 +38,15 @@
 #define kHistoryDatabase "history_database"
 #define kHistoryMaxBytes (750*1024)  // rotate/remove every 750K
 
+// record the offset of every Nth entry (both in memory and in the
+// persisted index sidecar)
+#define kHistoryIndexInterval 1000
+
 using namespace rstudio::core;
 
 namespace rstudio {
 namespace session {
-namespace modules { 
+namespace modules {
 namespace history {
 
 namespace {
@@ -50,19 +61,12 @@ FilePath historyDatabaseRotatedFilePath()
    return module_context::userScratchPath().complete(kHistoryDatabase ".1");
 }
 
-void rotateHistoryDatabase()
+// sidecar index over the main history database (offset/timestamp
+// checkpoints, one line per kHistoryIndexInterval entries). rebuilt
+// from scratch whenever it doesn't agree with the database
+FilePath historyIndexFilePath()
 {
-   FilePath historyDB = historyDatabaseFilePath();
-   if (historyDB.exists() && (historyDB.size() > kHistoryMaxBytes))
-   {
-      // first remove the rotated file if it exists (ignore errors because
-      // there's nothing we can do with them at this level)
-      FilePath rotatedHistoryDB = historyDatabaseRotatedFilePath();
-      rotatedHistoryDB.removeIfExists();
-
-      // now rotate the file
-      historyDB.move(rotatedHistoryDB);
-   }
+   return module_context::userScratchPath().complete(kHistoryDatabase ".index");
 }
 
 void writeEntry(double timestamp, const std::string& command, std::ostream* pOS)
@@ -91,32 +95,27 @@ void attemptRhistoryMigration()
       LOG_ERROR(error);
 }
 
-// simple reader for parsing lines of history file
-ReadCollectionAction readHistoryEntry(const std::string& line,
-                                      HistoryEntry* pEntry,
-                                      int* pNextIndex)
+// entries are lines of the form <timestamp>:<command>; lines without
+// a ':' are ignored (same rule the previous line-by-line reader used)
+const char* entryColon(const char* pLine, const char* pLineEnd)
 {
-   // if the line doesn't have a ':' then ignore it
-   if (line.find(':') == std::string::npos)
-      return ReadCollectionIgnoreLine;
+   return static_cast<const char*>(std::memchr(pLine, ':', pLineEnd - pLine));
+}
 
-   pEntry->index = (*pNextIndex)++;
-   std::istringstream istr(line);
-   istr >> pEntry->timestamp ;
-   istr.ignore(1, ':');
-   std::getline(istr, pEntry->command);
+double entryTimestamp(const char* pLine, const char* pColon)
+{
+   return safe_convert::stringTo<double>(std::string(pLine, pColon), 0);
+}
 
-   // if we had a read failure log it and return ignore state
-   if (!istr.fail())
-   {
-      return ReadCollectionAddLine;
-   }
-   else
-   {
-      LOG_ERROR_MESSAGE("unexpected io error reading history line: " +
-                        line);
-      return ReadCollectionIgnoreLine;
-   }
+void parseEntry(const char* pLine,
+                const char* pLineEnd,
+                int index,
+                HistoryEntry* pEntry)
+{
+   const char* pColon = entryColon(pLine, pLineEnd);
+   pEntry->index = index;
+   pEntry->timestamp = entryTimestamp(pLine, pColon);
+   pEntry->command.assign(pColon + 1, pLineEnd);
 }
 
 } // anonymous namespace
@@ -127,17 +126,43 @@ HistoryArchive& historyArchive()
    return instance;
 }
 
+void HistoryArchive::FileIndex::reset()
+{
+   pFile.reset();
+   checkpointOffsets.clear();
+   checkpointTimes.clear();
+   entryCount = 0;
+   scannedTo = 0;
+   persistedCheckpoints = 0;
+   lastWriteTime = -1;
+   fileSize = 0;
+}
+
 Error HistoryArchive::add(const std::string& command)
 {
-   // reset the cache (since this write will invalidate the current one,
-   // no sense in keeping our cache around in memory)
-   entries_.clear();
-   entryCacheLastWriteTime_ = -1;
+   // rotate if necessary -- this invalidates both mappings as well as
+   // the persisted index (which describes the pre-rotation main file)
+   FilePath historyDB = historyDatabaseFilePath();
+   if (historyDB.exists() && (historyDB.size() > kHistoryMaxBytes))
+   {
+      // first remove the rotated file if it exists (ignore errors because
+      // there's nothing we can do with them at this level)
+      FilePath rotatedHistoryDB = historyDatabaseRotatedFilePath();
+      rotatedHistoryDB.removeIfExists();
+
+      // now rotate the file
+      historyDB.move(rotatedHistoryDB);
 
-   // rotate if necessary
-   rotateHistoryDatabase();
+      Error error = historyIndexFilePath().removeIfExists();
+      if (error)
+         LOG_ERROR(error);
 
-   // write the entry to the file
+      main_.reset();
+      rotated_.reset();
+   }
+
+   // write the entry to the file (the in-memory index picks up the
+   // appended bytes incrementally on next access)
    std::ostringstream ostrEntry ;
    double currentTime = core::date_time::millisecondsSinceEpoch();
    writeEntry(currentTime, command, &ostrEntry);
@@ -145,62 +170,321 @@ Error HistoryArchive::add(const std::string& command)
    return appendToFile(historyDatabaseFilePath(), ostrEntry.str());
 }
 
-const std::vector<HistoryEntry>& HistoryArchive::entries() const
+void HistoryArchive::ensureIndexed() const
 {
-   // calculate path to history db
-   FilePath historyDBPath = historyDatabaseFilePath();
+   Error error = indexFile(historyDatabaseRotatedFilePath(), false, &rotated_);
+   if (error)
+      LOG_ERROR(error);
+   error = indexFile(historyDatabaseFilePath(), true, &main_);
+   if (error)
+      LOG_ERROR(error);
+}
 
-   // if the file doesn't exist then clear the collection
-   if (!historyDBPath.exists())
+Error HistoryArchive::indexFile(const FilePath& filePath,
+                                bool isMainFile,
+                                FileIndex* pIndex) const
+{
+   // no file, no index
+   if (!filePath.exists())
+   {
+      pIndex->reset();
+      return Success();
+   }
+
+   // up to date?
+   std::time_t lastWriteTime = filePath.lastWriteTime();
+   long long fileSize = filePath.size();
+   if (pIndex->pFile &&
+       fileSize == pIndex->fileSize &&
+       lastWriteTime == pIndex->lastWriteTime)
+   {
+      return Success();
+   }
+
+   // (re)map the file -- the previous mapping (if any) has a stale length
+   boost::shared_ptr<core::system::MemoryMappedFile> pFile(
+                                    new core::system::MemoryMappedFile());
+   Error error = pFile->open(filePath);
+   if (error)
    {
-      entries_.clear();
+      pIndex->reset();
+      return error;
    }
 
-   // otherwise check for divergent lastWriteTime and read the file
-   // if our internal list isn't up to date
-   else if (historyDBPath.lastWriteTime() != entryCacheLastWriteTime_)
+   // the file is append-only, so if it only grew we keep the existing
+   // checkpoints and just scan the appended tail. verify that what we
+   // previously scanned still ends on a line boundary; anything else
+   // (truncation, rewrite) triggers a full rescan
+   const char* pData = static_cast<const char*>(pFile->data());
+   bool incremental = pIndex->pFile &&
+                      pIndex->scannedTo > 0 &&
+                      pIndex->scannedTo <= pFile->size() &&
+                      pData != NULL &&
+                      pData[pIndex->scannedTo - 1] == '\n';
+
+   pIndex->pFile = pFile;
+   pIndex->fileSize = fileSize;
+   pIndex->lastWriteTime = lastWriteTime;
+
+   if (!incremental)
    {
-      entries_.clear();
+      pIndex->checkpointOffsets.clear();
+      pIndex->checkpointTimes.clear();
+      pIndex->entryCount = 0;
+      pIndex->scannedTo = 0;
+      pIndex->persistedCheckpoints = 0;
+
+      // seed from the persisted index so startup scans only the tail
+      if (isMainFile)
+         loadPersistedIndex(pIndex);
+   }
+
+   scanFrom(pIndex, isMainFile);
+
+   return Success();
+}
+
+void HistoryArchive::loadPersistedIndex(FileIndex* pIndex) const
+{
+   FilePath indexPath = historyIndexFilePath();
+   if (!indexPath.exists())
+      return;
 
-      // establish a next index counter
-      int nextIndex = 0;
+   std::string contents;
+   Error error = readStringFromFile(indexPath, &contents);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
 
-      // first read from rotated file if it exists
-      FilePath rotatedHistoryDBPath = historyDatabaseRotatedFilePath();
-      if (rotatedHistoryDBPath.exists())
+   const char* pData = static_cast<const char*>(pIndex->pFile->data());
+   std::size_t size = pIndex->pFile->size();
+
+   // parse checkpoint lines of the form <entryIndex> <offset> <timestamp>,
+   // validating each against the mapped database; any disagreement means
+   // the index is stale so we discard it entirely and rebuild
+   std::vector<std::size_t> offsets;
+   std::vector<double> times;
+   std::istringstream istr(contents);
+   std::string line;
+   bool valid = true;
+   while (std::getline(istr, line))
+   {
+      if (line.empty())
+         continue;
+
+      std::istringstream lineStream(line);
+      long long entryIndex = -1, offset = -1;
+      double timestamp = 0;
+      lineStream >> entryIndex >> offset >> timestamp;
+      if (lineStream.fail() ||
+          entryIndex != static_cast<long long>(offsets.size()) *
+                        kHistoryIndexInterval ||
+          offset < 0 ||
+          offset >= static_cast<long long>(size) ||
+          (offset > 0 && pData[offset - 1] != '\n'))
       {
-         Error error = readCollectionFromFile<std::vector<HistoryEntry> >(
-                           rotatedHistoryDBPath,
-                           &entries_,
-                           boost::bind(readHistoryEntry, _1, _2, &nextIndex));
-         if (error)
-            LOG_ERROR(error);
+         valid = false;
+         break;
       }
 
+      offsets.push_back(static_cast<std::size_t>(offset));
+      times.push_back(timestamp);
+   }
 
-      // now read from main history db
-      std::vector<HistoryEntry> entries;
-      Error error = readCollectionFromFile<std::vector<HistoryEntry> >(
-                           historyDBPath,
-                           &entries,
-                           boost::bind(readHistoryEntry, _1, _2, &nextIndex));
+   if (!valid || offsets.empty())
+   {
+      error = indexPath.removeIfExists();
       if (error)
-      {
          LOG_ERROR(error);
+      return;
+   }
+
+   pIndex->checkpointOffsets = offsets;
+   pIndex->checkpointTimes = times;
+   pIndex->persistedCheckpoints = offsets.size();
+
+   // the entry at the last checkpoint hasn't been counted yet -- the
+   // tail scan (re)starts exactly there
+   pIndex->entryCount = (offsets.size() - 1) * kHistoryIndexInterval;
+   pIndex->scannedTo = offsets.back();
+}
+
+void HistoryArchive::scanFrom(FileIndex* pIndex, bool isMainFile) const
+{
+   const char* pData = static_cast<const char*>(pIndex->pFile->data());
+   std::size_t size = pIndex->pFile->size();
+   if (pData == NULL)
+      return;
+
+   std::size_t pos = pIndex->scannedTo;
+   while (pos < size)
+   {
+      const char* pLine = pData + pos;
+      const char* pNewline = static_cast<const char*>(
+                        std::memchr(pLine, '\n', size - pos));
+      const char* pLineEnd = (pNewline != NULL) ? pNewline : pData + size;
+
+      const char* pColon = entryColon(pLine, pLineEnd);
+      if (pColon != NULL)
+      {
+         // record a checkpoint at every interval boundary (unless we
+         // already have one, e.g. seeded from the persisted index)
+         if (pIndex->entryCount % kHistoryIndexInterval == 0 &&
+             pIndex->checkpointOffsets.size() ==
+               static_cast<std::size_t>(pIndex->entryCount /
+                                        kHistoryIndexInterval))
+         {
+            double timestamp = entryTimestamp(pLine, pColon);
+            pIndex->checkpointOffsets.push_back(pos);
+            pIndex->checkpointTimes.push_back(timestamp);
+         }
+         pIndex->entryCount++;
       }
+
+      pos = (pLineEnd - pData) + 1;
+   }
+   pIndex->scannedTo = size;
+
+   // persist any checkpoints the sidecar index doesn't have yet
+   if (isMainFile &&
+       pIndex->checkpointOffsets.size() > pIndex->persistedCheckpoints)
+   {
+      std::ostringstream ostr;
+      for (std::size_t i = pIndex->persistedCheckpoints;
+           i < pIndex->checkpointOffsets.size();
+           i++)
+      {
+         ostr << (i * kHistoryIndexInterval) << " "
+              << pIndex->checkpointOffsets[i] << " "
+              << std::fixed << std::setprecision(0)
+              << pIndex->checkpointTimes[i] << std::endl;
+      }
+      Error error = appendToFile(historyIndexFilePath(), ostr.str());
+      if (error)
+         LOG_ERROR(error);
       else
+         pIndex->persistedCheckpoints = pIndex->checkpointOffsets.size();
+   }
+}
+
+int HistoryArchive::entryCount() const
+{
+   ensureIndexed();
+   return rotated_.entryCount + main_.entryCount;
+}
+
+void HistoryArchive::collectRange(const FileIndex& index,
+                                  int globalBase,
+                                  int globalStart,
+                                  int globalEnd,
+                                  std::vector<HistoryEntry>* pEntries) const
+{
+   int localStart = std::max(globalStart - globalBase, 0);
+   int localEnd = std::min(globalEnd - globalBase, index.entryCount);
+   if (localStart >= localEnd || !index.pFile)
+      return;
+
+   const char* pData = static_cast<const char*>(index.pFile->data());
+   std::size_t size = index.pFile->size();
+
+   // seek to the checkpoint preceding the range, then walk forward
+   std::size_t checkpoint = localStart / kHistoryIndexInterval;
+   std::size_t pos = index.checkpointOffsets[checkpoint];
+   int current = checkpoint * kHistoryIndexInterval;
+   while (pos < size && current < localEnd)
+   {
+      const char* pLine = pData + pos;
+      const char* pNewline = static_cast<const char*>(
+                        std::memchr(pLine, '\n', size - pos));
+      const char* pLineEnd = (pNewline != NULL) ? pNewline : pData + size;
+
+      if (entryColon(pLine, pLineEnd) != NULL)
       {
-         std::copy(entries.begin(),
-                   entries.end(),
-                   std::back_inserter(entries_));
+         if (current >= localStart)
+         {
+            HistoryEntry entry;
+            parseEntry(pLine, pLineEnd, globalBase + current, &entry);
+            pEntries->push_back(entry);
+         }
+         current++;
+      }
+
+      pos = (pLineEnd - pData) + 1;
+   }
+}
+
+Error HistoryArchive::entriesForRange(int startIndex,
+                                      int endIndex,
+                                      std::vector<HistoryEntry>* pEntries) const
+{
+   ensureIndexed();
+
+   collectRange(rotated_, 0, startIndex, endIndex, pEntries);
+   collectRange(main_, rotated_.entryCount, startIndex, endIndex, pEntries);
+
+   return Success();
+}
 
-         entryCacheLastWriteTime_ = historyDBPath.lastWriteTime();
+bool HistoryArchive::visitFileReverse(const FileIndex& index,
+                                      int globalBase,
+                                      const EntryVisitor& visitor) const
+{
+   if (!index.pFile || index.entryCount == 0)
+      return true;
+
+   const char* pData = static_cast<const char*>(index.pFile->data());
+   std::size_t size = index.pFile->size();
+
+   // walk checkpoint blocks from the last to the first; within a block
+   // collect entry line extents forward (at most one interval of them)
+   // and then visit them in reverse
+   for (std::size_t block = index.checkpointOffsets.size(); block > 0; block--)
+   {
+      int blockFirst = (block - 1) * kHistoryIndexInterval;
+      int blockLast = std::min<int>(blockFirst + kHistoryIndexInterval,
+                                    index.entryCount);
+
+      std::vector<std::pair<std::size_t, std::size_t> > lines;
+      lines.reserve(blockLast - blockFirst);
+      std::size_t pos = index.checkpointOffsets[block - 1];
+      while (pos < size &&
+             lines.size() < static_cast<std::size_t>(blockLast - blockFirst))
+      {
+         const char* pLine = pData + pos;
+         const char* pNewline = static_cast<const char*>(
+                           std::memchr(pLine, '\n', size - pos));
+         const char* pLineEnd = (pNewline != NULL) ? pNewline : pData + size;
+
+         if (entryColon(pLine, pLineEnd) != NULL)
+            lines.push_back(std::make_pair(pos, pLineEnd - pData));
+
+         pos = (pLineEnd - pData) + 1;
       }
 
+      for (std::size_t i = lines.size(); i > 0; i--)
+      {
+         HistoryEntry entry;
+         parseEntry(pData + lines[i-1].first,
+                    pData + lines[i-1].second,
+                    globalBase + blockFirst + (i - 1),
+                    &entry);
+         if (!visitor(entry))
+            return false;
+      }
    }
 
-   // return entries
-   return entries_;
+   return true;
+}
+
+void HistoryArchive::scanReverse(const EntryVisitor& visitor) const
+{
+   ensureIndexed();
+
+   // newest entries live in the main file
+   if (visitFileReverse(main_, rotated_.entryCount, visitor))
+      visitFileReverse(rotated_, 0, visitor);
 }
 
 void HistoryArchive::migrateRhistoryIfNecessary()
@@ -217,4 +501,3 @@ void HistoryArchive::migrateRhistoryIfNecessary()
 } // namespace modules
 } // namespace session
 } // namespace rstudio
-
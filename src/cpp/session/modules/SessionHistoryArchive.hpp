@@ -16,23 +16,30 @@
 #ifndef SESSION_HISTORY_ARCHIVE_HPP
 #define SESSION_HISTORY_ARCHIVE_HPP
 
+#include <ctime>
+
 #include <string>
 #include <vector>
 
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/utility.hpp>
 
 namespace rstudio {
 namespace core {
    class Error;
    class FilePath;
+   namespace system {
+      class MemoryMappedFile;
+   }
 }
 }
- 
+
 namespace rstudio {
 namespace session {
-namespace modules { 
+namespace modules {
 namespace history {
-   
+
 struct HistoryEntry
 {
    HistoryEntry() : index(0), timestamp(0) {}
@@ -51,7 +58,7 @@ HistoryArchive& historyArchive();
 class HistoryArchive : boost::noncopyable
 {
 private:
-   HistoryArchive() : entryCacheLastWriteTime_(-1) {}
+   HistoryArchive() {}
    friend HistoryArchive& historyArchive();
 
 public:
@@ -59,13 +66,63 @@ public:
 
 public:
    core::Error add(const std::string& command);
-   const std::vector<HistoryEntry>& entries() const;
+
+   // total number of entries in the archive
+   int entryCount() const;
+
+   // windowed access to entries in the range [startIndex, endIndex)
+   core::Error entriesForRange(int startIndex,
+                               int endIndex,
+                               std::vector<HistoryEntry>* pEntries) const;
+
+   // visit entries newest-to-oldest, materializing one entry at a time;
+   // return false from the visitor to stop the scan
+   typedef boost::function<bool(const HistoryEntry&)> EntryVisitor;
+   void scanReverse(const EntryVisitor& visitor) const;
 
 private:
-   mutable time_t entryCacheLastWriteTime_;
-   mutable std::vector<HistoryEntry> entries_;
+   // offset index over a memory mapped archive file. the index records
+   // the byte offset (and timestamp) of every kHistoryIndexInterval-th
+   // entry so that random access never parses more than one interval
+   // of entries
+   struct FileIndex
+   {
+      FileIndex() : entryCount(0), scannedTo(0), persistedCheckpoints(0),
+                    lastWriteTime(-1), fileSize(0) {}
+      void reset();
+
+      boost::shared_ptr<core::system::MemoryMappedFile> pFile;
+      std::vector<std::size_t> checkpointOffsets;
+      std::vector<double> checkpointTimes;
+      int entryCount;
+      std::size_t scannedTo;
+      std::size_t persistedCheckpoints;
+      std::time_t lastWriteTime;
+      long long fileSize;
+   };
+
+   void ensureIndexed() const;
+   core::Error indexFile(const core::FilePath& filePath,
+                         bool isMainFile,
+                         FileIndex* pIndex) const;
+   void loadPersistedIndex(FileIndex* pIndex) const;
+   void scanFrom(FileIndex* pIndex, bool isMainFile) const;
+   void collectRange(const FileIndex& index,
+                     int globalBase,
+                     int globalStart,
+                     int globalEnd,
+                     std::vector<HistoryEntry>* pEntries) const;
+   bool visitFileReverse(const FileIndex& index,
+                         int globalBase,
+                         const EntryVisitor& visitor) const;
+
+private:
+   // indexes for the rotated and current archive files (mutable since
+   // they are lazily built/refreshed from const accessors)
+   mutable FileIndex rotated_;
+   mutable FileIndex main_;
 };
-                       
+
 } // namespace history
 } // namespace modules
 } // namespace session
@@ -17,9 +17,12 @@
 #include "SessionLists.hpp"
 
 #include <map>
+#include <set>
 
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <boost/unordered_set.hpp>
 #include <boost/utility.hpp>
 #include <boost/circular_buffer.hpp>
 
@@ -107,6 +110,175 @@ Error writeList(const std::string& name, const T& list)
    return writeCollectionToFile<T>(listPath(name), list, stringifyString);
 }
 
+// mutations are applied to an in-memory image of each list (with a hash
+// index for O(1) dedupe) and logged as single-record appends to a
+// side-car ops journal; the full list file is only rewritten by a
+// debounced flush (compaction). the previous read-modify-rewrite of the
+// whole list on every insert was a measurable source of file-open
+// latency on NFS home directories
+
+const char* const kOpsSuffix = ".ops";
+const long kFlushDelayMs = 3000;
+
+// journaled operations (first byte of each ops record). every insert
+// implies removal of any existing entry with the same value, so a
+// single record captures an MRU touch
+const char kOpPrepend = 'P';
+const char kOpAppend = 'A';
+const char kOpRemove = 'R';
+
+struct CachedList
+{
+   std::list<std::string> items;
+   boost::unordered_set<std::string> index;
+};
+
+std::map<std::string, CachedList> s_cachedLists;
+std::set<std::string> s_dirtyLists;
+bool s_flushScheduled = false;
+
+FilePath opsPath(const std::string& name)
+{
+   return listPath(name + kOpsSuffix);
+}
+
+void applyOp(char op,
+             const std::string& value,
+             std::size_t maxSize,
+             CachedList* pList)
+{
+   // remove any existing entry with this value (the index makes the
+   // common no-duplicate case a single hash probe)
+   if (pList->index.find(value) != pList->index.end())
+   {
+      pList->items.remove(value);
+      pList->index.erase(value);
+   }
+
+   if (op == kOpRemove)
+      return;
+
+   // enforce size constraints (ring semantics: inserts displace the
+   // entry at the opposite end)
+   while (pList->items.size() >= maxSize && !pList->items.empty())
+   {
+      if (op == kOpPrepend)
+      {
+         pList->index.erase(pList->items.back());
+         pList->items.pop_back();
+      }
+      else
+      {
+         pList->index.erase(pList->items.front());
+         pList->items.pop_front();
+      }
+   }
+
+   if (op == kOpPrepend)
+      pList->items.push_front(value);
+   else
+      pList->items.push_back(value);
+   pList->index.insert(value);
+}
+
+// load a list into the cache: the compacted list file plus a replay of
+// any ops journaled since it was last written
+Error loadList(const std::string& name, CachedList* pList)
+{
+   pList->items.clear();
+   pList->index.clear();
+
+   Error error = readList(name, &pList->items);
+   if (error)
+      return error;
+
+   BOOST_FOREACH(const std::string& item, pList->items)
+   {
+      pList->index.insert(item);
+   }
+
+   FilePath opsFilePath = opsPath(name);
+   if (opsFilePath.exists())
+   {
+      std::string ops;
+      error = core::readStringFromFile(opsFilePath, &ops);
+      if (error)
+         return error;
+
+      std::size_t maxSize = listSize(name.c_str());
+      std::istringstream istr(ops);
+      std::string line;
+      while (std::getline(istr, line))
+      {
+         if (line.size() >= 2 && line[1] == '\t')
+            applyOp(line[0], line.substr(2), maxSize, pList);
+      }
+   }
+
+   return Success();
+}
+
+CachedList& cachedList(const std::string& name)
+{
+   std::map<std::string, CachedList>::iterator pos = s_cachedLists.find(name);
+   if (pos != s_cachedLists.end())
+      return pos->second;
+
+   CachedList& list = s_cachedLists[name];
+   Error error = loadList(name, &list);
+   if (error)
+      LOG_ERROR(error);
+   return list;
+}
+
+// append a single op record to the list's journal -- this is the only
+// disk write on the insert path
+Error journalOp(const std::string& name, char op, const std::string& value)
+{
+   return core::appendToFile(opsPath(name),
+                             std::string(1, op) + "\t" + value + "\n");
+}
+
+// compact dirty lists: rewrite the list file from the in-memory image
+// and retire the ops journal
+void flushLists()
+{
+   s_flushScheduled = false;
+
+   BOOST_FOREACH(const std::string& name, s_dirtyLists)
+   {
+      Error error = writeList(name, s_cachedLists[name].items);
+      if (error)
+      {
+         LOG_ERROR(error);
+         continue;
+      }
+
+      error = opsPath(name).removeIfExists();
+      if (error)
+         LOG_ERROR(error);
+   }
+   s_dirtyLists.clear();
+}
+
+void markListDirty(const std::string& name)
+{
+   s_dirtyLists.insert(name);
+   if (!s_flushScheduled)
+   {
+      s_flushScheduled = true;
+      module_context::scheduleDelayedWork(
+               "flush mru lists",
+               boost::posix_time::milliseconds(kFlushDelayMs),
+               flushLists);
+   }
+}
+
+void onShutdown(bool)
+{
+   flushLists();
+}
+
 
 json::Array listToJson(const std::list<std::string>& list)
 {
@@ -132,18 +304,21 @@ void onListsFileChanged(const core::system::FileChangeEvent& fileChange)
    FilePath filePath(fileChange.fileInfo().absolutePath());
    std::string name = filePath.filename();
 
-   // read it
-   std::list<std::string> list;
-   Error error = readList(name, &list);
-   if (error)
+   // ignore ops journals and anything else that isn't a registered list
+   if (boost::algorithm::ends_with(name, kOpsSuffix) ||
+       s_lists.find(name) == s_lists.end())
    {
-      LOG_ERROR(error);
       return;
    }
 
+   // reload the list (another session may have changed it; anything we
+   // have journaled but not yet flushed is replayed on top)
+   s_cachedLists.erase(name);
+   CachedList& list = cachedList(name);
+
    json::Object eventJson;
    eventJson["name"] = name;
-   eventJson["list"] = listToJson(list);
+   eventJson["list"] = listToJson(list.items);
 
    ClientEvent event(client_events::kListChanged, eventJson);
    module_context::enqueClientEvent(event);
@@ -167,28 +342,15 @@ Error getListName(const json::JsonRpcRequest& request, std::string* pName)
 }
 
 
-Error getListNameAndContents(const json::JsonRpcRequest& request,
-                             std::string* pName,
-                             std::list<std::string>* pList)
-{
-   Error error = getListName(request, pName);
-   if (error)
-      return error;
-
-   return readList(*pName, pList);
-}
-
-
 Error listGet(const json::JsonRpcRequest& request,
               json::JsonRpcResponse* pResponse)
 {
    std::string name;
-   std::list<std::string> list;
-   Error error = getListNameAndContents(request, &name, &list);
+   Error error = getListName(request, &name);
    if (error)
       return error;
 
-   pResponse->setResult(listToJson(list));
+   pResponse->setResult(listToJson(cachedList(name).items));
 
    return Success();
 }
@@ -202,7 +364,11 @@ Error listSetContents(const json::JsonRpcRequest& request,
    if (error)
       return error;
 
-   std::list<std::string> list;
+   // rebuild the in-memory image (wholesale replacement is rare, so
+   // just write the compacted file synchronously)
+   CachedList& list = cachedList(name);
+   list.items.clear();
+   list.index.clear();
    BOOST_FOREACH(const json::Value& val, jsonList)
    {
       if (!json::isType<std::string>(val))
@@ -211,10 +377,15 @@ Error listSetContents(const json::JsonRpcRequest& request,
          continue;
       }
 
-      list.push_back(val.get_str());
+      list.items.push_back(val.get_str());
+      list.index.insert(val.get_str());
    }
 
-   return writeList(name, list);
+   s_dirtyLists.erase(name);
+   error = writeList(name, list.items);
+   if (error)
+      return error;
+   return opsPath(name).removeIfExists();
 }
 
 Error listInsertItem(bool prepend,
@@ -223,36 +394,24 @@ Error listInsertItem(bool prepend,
 {
    // get params and other context
    std::string name, value;
-   std::list<std::string> list;
-   std::size_t maxSize;
-   Error error = getListNameAndContents(request, &name, &list);
+   Error error = getListName(request, &name);
    if (error)
       return error;
    error = json::readParam(request.params, 1, &value);
    if (error)
       return error;
-   maxSize = listSize(name.c_str());
 
-   // remove any existing item with this value
-   list.remove(value);
-
-   // enforce size constraints
-   while (list.size() >= maxSize)
-   {
-      if (prepend)
-         list.pop_back();
-      else
-         list.pop_front();
-   }
+   // apply to the in-memory image and journal a single op record (the
+   // compacted list file is rewritten by the debounced flush)
+   char op = prepend ? kOpPrepend : kOpAppend;
+   applyOp(op, value, listSize(name.c_str()), &cachedList(name));
 
-   // do the insert
-   if (prepend)
-      list.push_front(value);
-   else
-      list.push_back(value);
+   error = journalOp(name, op, value);
+   if (error)
+      return error;
 
-   // update the list
-   return writeList(name, list);
+   markListDirty(name);
+   return Success();
 }
 
 
@@ -273,22 +432,31 @@ Error listAppendItem(const json::JsonRpcRequest& request,
 Error listRemoveItem(const json::JsonRpcRequest& request,
                      json::JsonRpcResponse* pResponse)
 {
-   // get list name and contents
+   // get list name
    std::string name;
-   std::list<std::string> list;
-   Error error = getListNameAndContents(request, &name, &list);
+   Error error = getListName(request, &name);
    if (error)
       return error;
 
    // get value to remove
    std::string value;
    error = json::readParam(request.params, 1, &value);
+   if (error)
+      return error;
+
+   // remove it (no-op if it isn't present)
+   CachedList& list = cachedList(name);
+   if (list.index.find(value) == list.index.end())
+      return Success();
 
-   // remove it
-   list.remove(value);
+   applyOp(kOpRemove, value, listSize(name.c_str()), &list);
 
-   // update the list
-   return writeList(name, list);
+   error = journalOp(name, kOpRemove, value);
+   if (error)
+      return error;
+
+   markListDirty(name);
+   return Success();
 }
 
 Error listClear(const json::JsonRpcRequest& request,
@@ -300,8 +468,17 @@ Error listClear(const json::JsonRpcRequest& request,
    if (error)
       return error;
 
-   // write empty list
-   return writeList(name, std::list<std::string>());
+   // reset the in-memory image and write the empty list through
+   // synchronously (clears are rare)
+   CachedList& list = cachedList(name);
+   list.items.clear();
+   list.index.clear();
+
+   s_dirtyLists.erase(name);
+   error = writeList(name, list.items);
+   if (error)
+      return error;
+   return opsPath(name).removeIfExists();
 }
 
 } // anonymous namespace
@@ -312,12 +489,7 @@ json::Object allListsAsJson()
    json::Object allListsJson;
    for (Lists::const_iterator it = s_lists.begin(); it != s_lists.end(); ++it)
    {
-      std::list<std::string> list;
-      Error error = readList(it->first, &list);
-      if (error)
-         LOG_ERROR(error);
-
-      allListsJson[it->first] = listToJson(list);
+      allListsJson[it->first] = listToJson(cachedList(it->first).items);
    }
 
    return allListsJson;
@@ -338,6 +510,9 @@ Error initialize()
                                                       kListsPath,
                                                       onListsFileChanged);
 
+   // compact any journaled-but-unflushed mutations at shutdown
+   module_context::events().onShutdown.connect(onShutdown);
+
    using boost::bind;
    using namespace module_context;
    ExecBlock initBlock ;
@@ -0,0 +1,166 @@
+/*
+ * SessionMemory.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionMemory.hpp"
+
+#ifdef __linux__
+# include <malloc.h>
+# include <unistd.h>
+#endif
+
+#include <sstream>
+
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <core/Error.hpp>
+#include <core/FilePath.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/PerformanceMetrics.hpp>
+
+#include <session/SessionOptions.hpp>
+#include <session/SessionModuleContext.hpp>
+
+#include "SessionClientEventQueue.hpp"
+#include "clang/RSourceIndex.hpp"
+#include "clang/SessionClang.hpp"
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace memory {
+
+namespace {
+
+// a long-running session accumulates heap fragmentation: after large
+// operations complete the allocator holds freed pages rather than
+// returning them, so resident size stays at its high-water mark. this
+// module waits for the session to go idle and then releases what it
+// can -- pooled buffers, cold caches when over the configured memory
+// target, and finally the allocator's free pages
+
+// idle time before a trim is attempted, and the minimum interval
+// between trims while the session stays idle
+const int kIdleTrimSeconds = 60;
+const int kTrimIntervalSeconds = 300;
+
+boost::posix_time::ptime s_lastActivityTime;
+boost::posix_time::ptime s_lastTrimTime;
+
+// current resident set size in bytes (0 if it can't be determined --
+// resident size isn't cheaply readable on all platforms)
+boost::int64_t currentRssBytes()
+{
+#ifdef __linux__
+   std::string statm;
+   Error error = readStringFromFile(FilePath("/proc/self/statm"), &statm);
+   if (error)
+      return 0;
+
+   // second field is resident pages
+   boost::int64_t sizePages = 0, residentPages = 0;
+   std::istringstream istr(statm);
+   istr >> sizePages >> residentPages;
+   if (istr.fail())
+      return 0;
+
+   return residentPages * ::sysconf(_SC_PAGESIZE);
+#else
+   return 0;
+#endif
+}
+
+void performTrim()
+{
+   boost::int64_t rssBefore = currentRssBytes();
+
+   // when we're over the configured memory target, drop cold caches
+   // before releasing heap pages. indexed translation units are by far
+   // the largest discardable allocation and are reprimed on demand
+   // (the cost is a background recompile on the next completion or
+   // diagnostics request)
+   int targetMb = session::options().memoryTargetMb();
+   if (targetMb > 0 &&
+       rssBefore > (boost::int64_t)targetMb * 1024 * 1024 &&
+       clang::isAvailable())
+   {
+      clang::rSourceIndex().removeAllTranslationUnits();
+   }
+
+   // release the event buffer capacity retained from output floods
+   clientEventQueue().shrinkCapacity();
+
+#if defined(__linux__) && defined(__GLIBC__)
+   // return the allocator's free pages to the OS
+   ::malloc_trim(0);
+#endif
+
+   performance::incrementCounter("rsession_memory_trims_total");
+
+   boost::int64_t rssAfter = currentRssBytes();
+   if (rssAfter > 0 && rssAfter < rssBefore)
+   {
+      performance::incrementCounterBy(
+               "rsession_memory_trim_reclaimed_bytes_total",
+               static_cast<boost::uint64_t>(rssBefore - rssAfter));
+   }
+}
+
+void onBackgroundProcessing(bool isIdle)
+{
+   using namespace boost::posix_time;
+   ptime now = microsec_clock::universal_time();
+
+   if (!isIdle)
+   {
+      s_lastActivityTime = now;
+      return;
+   }
+
+   // wait for the session to settle before trimming (trimming right
+   // after activity would just be undone by the next operation)
+   if ((now - s_lastActivityTime) < seconds(kIdleTrimSeconds))
+      return;
+
+   // rate limit trims while the session stays idle
+   if (!s_lastTrimTime.is_not_a_date_time() &&
+       (now - s_lastTrimTime) < seconds(kTrimIntervalSeconds))
+   {
+      return;
+   }
+
+   s_lastTrimTime = now;
+   performTrim();
+}
+
+} // anonymous namespace
+
+Error initialize()
+{
+   s_lastActivityTime = boost::posix_time::microsec_clock::universal_time();
+
+   module_context::events().onBackgroundProcessing.connect(
+                                       boost::bind(onBackgroundProcessing, _1));
+
+   return Success();
+}
+
+} // namespace memory
+} // namespace modules
+} // namespace session
+} // namespace rstudio
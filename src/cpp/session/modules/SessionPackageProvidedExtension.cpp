@@ -15,13 +15,22 @@
 
 #include <session/SessionPackageProvidedExtension.hpp>
 
+#include <algorithm>
+#include <set>
+#include <sstream>
+
 #include <boost/regex.hpp>
+#include <boost/bind.hpp>
+#include <boost/enable_shared_from_this.hpp>
 #include <boost/foreach.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 #include <core/Algorithm.hpp>
 #include <core/Exec.hpp>
 #include <core/FileSerializer.hpp>
+#include <core/SafeConvert.hpp>
+#include <core/Thread.hpp>
+#include <core/http/Util.hpp>
 #include <core/text/DcfParser.hpp>
 
 #include <session/SessionModuleContext.hpp>
@@ -72,7 +81,307 @@ Error parseDcfResourceFile(
    return Success();
 }
 
-Indexer::Indexer() : index_(0), n_(0), running_(false) {}
+namespace {
+
+const char * const kScanCacheFile = "ppe-index-cache";
+const char * const kScanCacheFormat = "ppe-index-cache-v1";
+
+const int kMaxScanThreads = 4;
+const int kMaxMergePerPass = 200;
+
+int scanThreadCount()
+{
+   int count = static_cast<int>(boost::thread::hardware_concurrency());
+   if (count < 1)
+      count = 1;
+   else if (count > kMaxScanThreads)
+      count = kMaxScanThreads;
+   return count;
+}
+
+// cached scan state for a single package directory: the directory's
+// last write time, and which of the queried resource files existed
+// within it
+struct ScanCacheEntry
+{
+   std::string mtime;
+   std::vector<std::string> resources;
+};
+
+typedef std::map<std::string, ScanCacheEntry> ScanCache;
+
+FilePath scanCachePath()
+{
+   return module_context::userScratchPath().childPath(kScanCacheFile);
+}
+
+std::string encodeResourceLine(const std::vector<std::string>& resourcePaths)
+{
+   std::ostringstream oss;
+   oss << "R";
+   BOOST_FOREACH(const std::string& resourcePath, resourcePaths)
+      oss << "\t" << http::util::urlEncode(resourcePath);
+   return oss.str();
+}
+
+bool loadScanCache(const std::vector<std::string>& resourcePaths,
+                   ScanCache* pCache)
+{
+   FilePath cachePath = scanCachePath();
+   if (!cachePath.exists())
+      return false;
+
+   std::string contents;
+   Error error = readStringFromFile(cachePath, &contents);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return false;
+   }
+
+   std::vector<std::string> lines;
+   boost::algorithm::split(lines, contents, boost::algorithm::is_any_of("\n"));
+
+   if (lines.size() < 2 || lines[0] != kScanCacheFormat)
+      return false;
+
+   // the cache is only usable if it was generated against the same set
+   // of resource files the current workers query
+   if (lines[1] != encodeResourceLine(resourcePaths))
+      return false;
+
+   for (std::size_t i = 2, n = lines.size(); i < n; ++i)
+   {
+      if (lines[i].empty())
+         continue;
+
+      std::vector<std::string> fields;
+      boost::algorithm::split(fields, lines[i], boost::algorithm::is_any_of("\t"));
+
+      if (fields.size() < 3 || fields[0] != "P")
+      {
+         // malformed record: discard the whole cache rather than
+         // trusting any of it
+         pCache->clear();
+         return false;
+      }
+
+      ScanCacheEntry entry;
+      entry.mtime = fields[2];
+      for (std::size_t j = 3; j < fields.size(); ++j)
+         entry.resources.push_back(http::util::urlDecode(fields[j]));
+
+      (*pCache)[http::util::urlDecode(fields[1])] = entry;
+   }
+
+   return true;
+}
+
+} // end anonymous namespace
+
+// scans package directories for worker resource files on background
+// threads. checking for resource files costs a stat per worker per
+// package, which dominates indexing time on networked library paths;
+// results from previous sessions are reused (keyed on each package
+// directory's last write time) so warm starts avoid most of the stats.
+class PackageScan : public boost::enable_shared_from_this<PackageScan>,
+                    boost::noncopyable
+{
+public:
+
+   struct Result
+   {
+      core::FilePath pkgPath;
+      std::string mtime;
+      std::vector<std::string> resources;
+   };
+
+   static boost::shared_ptr<PackageScan> create(
+         const std::vector<core::FilePath>& pkgDirs,
+         const std::vector<std::string>& resourcePaths)
+   {
+      return boost::shared_ptr<PackageScan>(
+               new PackageScan(pkgDirs, resourcePaths));
+   }
+
+   void start()
+   {
+      BOOST_FOREACH(const core::FilePath& pkgDir, pkgDirs_)
+         pkgQueue_.enque(pkgDir);
+
+      int numThreads = scanThreadCount();
+
+      LOCK_MUTEX(mutex_)
+      {
+         activeWorkers_ = numThreads;
+      }
+      END_LOCK_MUTEX
+
+      for (int i = 0; i < numThreads; ++i)
+      {
+         core::thread::safeLaunchThread(
+                  boost::bind(&PackageScan::workerMain, shared_from_this()));
+      }
+   }
+
+   void stop()
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         stopped_ = true;
+      }
+      END_LOCK_MUTEX
+   }
+
+   // merge pending scan results on the main thread, handing each
+   // discovered resource file to the registered workers. returns true
+   // once the scan is complete and all results have been merged.
+   bool mergeResults(const std::vector<boost::shared_ptr<Worker> >& workers)
+   {
+      int merged = 0;
+      Result result;
+      while (merged < kMaxMergePerPass && resultQueue_.deque(&result))
+      {
+         ++merged;
+
+         std::string pkgName = result.pkgPath.filename();
+         BOOST_FOREACH(boost::shared_ptr<Worker> pWorker, workers)
+         {
+            if (!core::algorithm::contains(result.resources,
+                                           pWorker->resourcePath()))
+            {
+               continue;
+            }
+
+            try
+            {
+               pWorker->onWork(
+                        pkgName,
+                        result.pkgPath.childPath(pWorker->resourcePath()));
+            }
+            CATCH_UNEXPECTED_EXCEPTION
+         }
+
+         results_.push_back(result);
+      }
+
+      return finished();
+   }
+
+   void writeCache()
+   {
+      std::ostringstream oss;
+      oss << kScanCacheFormat << "\n";
+      oss << encodeResourceLine(resourcePaths_) << "\n";
+
+      BOOST_FOREACH(const Result& result, results_)
+      {
+         oss << "P\t" << http::util::urlEncode(result.pkgPath.absolutePath())
+             << "\t" << result.mtime;
+         BOOST_FOREACH(const std::string& resource, result.resources)
+            oss << "\t" << http::util::urlEncode(resource);
+         oss << "\n";
+      }
+
+      Error error = writeStringToFile(scanCachePath(), oss.str());
+      if (error)
+         LOG_ERROR(error);
+   }
+
+private:
+
+   PackageScan(const std::vector<core::FilePath>& pkgDirs,
+               const std::vector<std::string>& resourcePaths)
+      : pkgDirs_(pkgDirs),
+        resourcePaths_(resourcePaths),
+        pkgQueue_(true),
+        resultQueue_(true),
+        stopped_(false),
+        activeWorkers_(0)
+   {
+      loadScanCache(resourcePaths_, &cache_);
+   }
+
+   bool stopped()
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         return stopped_;
+      }
+      END_LOCK_MUTEX
+
+      // keep compiler happy
+      return true;
+   }
+
+   bool finished()
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         return activeWorkers_ == 0 && resultQueue_.isEmpty();
+      }
+      END_LOCK_MUTEX
+
+      // keep compiler happy
+      return false;
+   }
+
+   void workerMain()
+   {
+      try
+      {
+         core::FilePath pkgPath;
+         while (!stopped() && pkgQueue_.deque(&pkgPath))
+            scanPackage(pkgPath);
+      }
+      CATCH_UNEXPECTED_EXCEPTION
+
+      LOCK_MUTEX(mutex_)
+      {
+         --activeWorkers_;
+      }
+      END_LOCK_MUTEX
+   }
+
+   void scanPackage(const core::FilePath& pkgPath)
+   {
+      Result result;
+      result.pkgPath = pkgPath;
+      result.mtime = safe_convert::numberToString(pkgPath.lastWriteTime());
+
+      // an unchanged package directory can reuse the resource listing
+      // recorded by a previous session
+      ScanCache::const_iterator it = cache_.find(pkgPath.absolutePath());
+      if (it != cache_.end() && it->second.mtime == result.mtime)
+      {
+         result.resources = it->second.resources;
+      }
+      else
+      {
+         BOOST_FOREACH(const std::string& resourcePath, resourcePaths_)
+         {
+            if (pkgPath.childPath(resourcePath).exists())
+               result.resources.push_back(resourcePath);
+         }
+      }
+
+      resultQueue_.enque(result);
+   }
+
+   std::vector<core::FilePath> pkgDirs_;
+   std::vector<std::string> resourcePaths_;
+   ScanCache cache_;
+   std::vector<Result> results_;
+
+   core::thread::ThreadsafeQueue<core::FilePath> pkgQueue_;
+   core::thread::ThreadsafeQueue<Result> resultQueue_;
+
+   boost::mutex mutex_;
+   bool stopped_;
+   int activeWorkers_;
+};
+
+Indexer::Indexer() : running_(false) {}
 
 void Indexer::addWorker(boost::shared_ptr<Worker> pWorker)
 {
@@ -91,49 +400,32 @@ void Indexer::start()
 
    running_ = true;
    beginIndexing();
-   module_context::scheduleIncrementalWork(
-            boost::posix_time::milliseconds(300),
-            boost::posix_time::milliseconds(20),
+   module_context::schedulePeriodicWork(
+            "package-provided-extensions",
+            boost::posix_time::milliseconds(50),
             boost::bind(&Indexer::work, this),
-            true);
+            true,
+            false);
 }
 
 bool Indexer::work()
 {
-   // check whether we've run out of work items
-   if (index_ == n_)
-   {
-      endIndexing();
-      return false;
-   }
+   // merge any completed scan results into the registered workers
+   if (!pScan_->mergeResults(workers_))
+      return true;
 
-   std::size_t index = index_++;
+   // scanning complete: persist the results for the next session
+   pScan_->writeCache();
+   pScan_.reset();
 
-   // invoke workers with package name + path
-   FilePath pkgPath = pkgDirs_[index];
-   std::string pkgName = pkgPath.filename();
-   BOOST_FOREACH(boost::shared_ptr<Worker> pWorker, workers_)
-   {
-      FilePath resourcePath = pkgPath.childPath(pWorker->resourcePath());
-      if (!resourcePath.exists())
-         continue;
-      
-      try
-      {
-         pWorker->onWork(pkgName, resourcePath);
-      }
-      CATCH_UNEXPECTED_EXCEPTION
-   }
-   return true;
+   endIndexing();
+   return false;
 }
 
 void Indexer::beginIndexing()
 {
-   // reset indexer state
-   pkgDirs_.clear();
-   index_ = 0;
-
    // discover packages available on the current library paths
+   std::vector<core::FilePath> pkgDirs;
    std::vector<core::FilePath> libPaths = module_context::getLibPaths();
    BOOST_FOREACH(const core::FilePath& libPath, libPaths)
    {
@@ -145,13 +437,17 @@ void Indexer::beginIndexing()
       if (error)
          LOG_ERROR(error);
 
-      pkgDirs_.insert(
-               pkgDirs_.end(),
+      pkgDirs.insert(
+               pkgDirs.end(),
                pkgPaths.begin(),
                pkgPaths.end());
    }
-   n_ = pkgDirs_.size();
-   
+
+   // collect the resource files the registered workers query
+   std::set<std::string> resourcePaths;
+   BOOST_FOREACH(boost::shared_ptr<Worker> pWorker, workers_)
+      resourcePaths.insert(pWorker->resourcePath());
+
    BOOST_FOREACH(boost::shared_ptr<Worker> pWorker, workers_)
    {
       try
@@ -160,6 +456,13 @@ void Indexer::beginIndexing()
       }
       CATCH_UNEXPECTED_EXCEPTION
    }
+
+   // scan the package directories on background threads
+   pScan_ = PackageScan::create(
+            pkgDirs,
+            std::vector<std::string>(resourcePaths.begin(),
+                                     resourcePaths.end()));
+   pScan_->start();
 }
 
 void Indexer::endIndexing()
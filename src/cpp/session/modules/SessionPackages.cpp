@@ -27,6 +27,7 @@
 #include <core/Error.hpp>
 #include <core/Exec.hpp>
 #include <core/http/URL.hpp>
+#include <core/http/DnsCache.hpp>
 #include <core/http/TcpIpBlockingClient.hpp>
 
 #include <r/RSexp.hpp>
@@ -465,8 +466,9 @@ void rs_packageLibraryMutated()
 void detectLibPathsChanges()
 {
    static std::vector<std::string> s_lastLibPaths;
+   static r::exec::PreparedFunction s_libPathsFunction("base:::.libPaths");
    std::vector<std::string> libPaths;
-   Error error = r::exec::RFunction("base:::.libPaths").call(&libPaths);
+   Error error = r::exec::RFunction(s_libPathsFunction).call(&libPaths);
    if (!error)
    {
       if (s_lastLibPaths.empty())
@@ -517,10 +519,17 @@ void onDeferredInit(bool newSession)
 
    // monitor libPaths for changes
    detectLibPathsChanges();
-   module_context::events().onDetectChanges.connect(onDetectChanges);
+   module_context::registerChangeDetection("packages", onDetectChanges);
 
    // ensure we have a secure connection to CRAN
    module_context::reconcileSecureDownloadConfiguration();
+
+   // pre-warm the DNS cache for the configured CRAN mirror so the first
+   // package operation doesn't also wait on the resolver
+   http::URL cranURL(module_context::CRANReposURL());
+   if (cranURL.isValid())
+      http::DnsCache::instance().prewarm(cranURL.hostname(),
+                                         cranURL.portStr());
 }
 
 Error getPackageState(const json::JsonRpcRequest& ,
@@ -588,11 +597,22 @@ Error initialize()
    
    using boost::bind;
    using namespace module_context;
+
+   // package state queries are read-only and repeated by the UI on
+   // every pane refresh, so serve them from the rpc response cache
+   // until package state actually changes
+   std::set<int> pkgStateInvalidationEvents;
+   pkgStateInvalidationEvents.insert(client_events::kPackageStateChanged);
+   pkgStateInvalidationEvents.insert(client_events::kPackageStatusChanged);
+   pkgStateInvalidationEvents.insert(client_events::kPackageLoaded);
+   pkgStateInvalidationEvents.insert(client_events::kPackageUnloaded);
+
    ExecBlock initBlock ;
    initBlock.addFunctions()
       (bind(sourceModuleRFile, "SessionPackages.R"))
       (bind(registerRpcMethod, "available_packages", availablePackages))
-      (bind(registerRpcMethod, "get_package_state", getPackageState))
+      (bind(registerCacheableRpcMethod, "get_package_state", getPackageState,
+            pkgStateInvalidationEvents))
       (bind(r::exec::executeString, ".rs.packages.initialize()"));
    return initBlock.execute();
 }
@@ -217,18 +217,46 @@ std::string updateHash(PackratHashType hashType, PackratHashState hashState,
    return newHash;
 }
 
-// adds content from the given file to the given file if it's a 
+// cached DESCRIPTION file content used for library hashing, validated by
+// size and last write time; spares re-reading hundreds of files (often
+// over NFS) on every idle-time state check
+struct DescFileRecord
+{
+   DescFileRecord() : lastWriteTime(0), size(0) {}
+   std::time_t lastWriteTime;
+   uintmax_t size;
+   std::string content;
+};
+std::map<std::string, DescFileRecord> s_descFileCache;
+
+// adds content from the given file to the given file if it's a
 // DESCRIPTION file (used to summarize library content for hashing)
-bool addDescContent(int level, const FilePath& path, std::string* pDescContent)
+bool addDescContent(int level, const FilePath& path, std::string* pDescContent,
+                    std::set<std::string>* pSeenPaths)
 {
-   std::string newDescContent;
-   if (path.filename() == "DESCRIPTION") 
+   if (path.filename() == "DESCRIPTION")
    {
-      Error error = readStringFromFile(path, &newDescContent);
+      std::string absPath = path.absolutePath();
+      pSeenPaths->insert(absPath);
+
+      // re-read the content only when the file has changed
+      DescFileRecord& record = s_descFileCache[absPath];
+      std::time_t lastWriteTime = path.lastWriteTime();
+      uintmax_t size = path.size();
+      if (record.content.empty() ||
+          record.lastWriteTime != lastWriteTime ||
+          record.size != size)
+      {
+         record.content.clear();
+         readStringFromFile(path, &record.content);
+         record.lastWriteTime = lastWriteTime;
+         record.size = size;
+      }
+
       // include the path of the file; on Windows the DESCRIPTION file moves
       // inside the library post-installation
-      pDescContent->append(path.absolutePath());
-      pDescContent->append(newDescContent);
+      pDescContent->append(absPath);
+      pDescContent->append(record.content);
    }
    return true;
 }
@@ -237,14 +265,26 @@ bool addDescContent(int level, const FilePath& path, std::string* pDescContent)
 // private library
 std::string computeLibraryHash()
 {
-   FilePath libraryPath = 
+   FilePath libraryPath =
       projects::projectContext().directory().complete(kPackratLibPath);
 
    // find all DESCRIPTION files in the library and concatenate them to form
-   // a hashable state
+   // a hashable state (content comes from the cache for unchanged files)
    std::string descFileContent;
+   std::set<std::string> seenPaths;
    libraryPath.childrenRecursive(
-         boost::bind(addDescContent, _1, _2, &descFileContent));
+         boost::bind(addDescContent, _1, _2, &descFileContent, &seenPaths));
+
+   // drop cache entries for packages removed from the library
+   for (std::map<std::string, DescFileRecord>::iterator
+           it = s_descFileCache.begin();
+        it != s_descFileCache.end(); )
+   {
+      if (seenPaths.count(it->first) == 0)
+         s_descFileCache.erase(it++);
+      else
+         ++it;
+   }
 
    if (descFileContent.empty())
       return "";
@@ -858,7 +898,7 @@ void afterSessionInitHook(bool newSession)
       if (error)
          LOG_ERROR(error);
 
-      module_context::events().onDetectChanges.connect(onDetectChanges);
+      module_context::registerChangeDetection("packrat", onDetectChanges);
 
       // check whether there are pending actions and if there are then
       // ensure that the packages pane is activated. we do this on a
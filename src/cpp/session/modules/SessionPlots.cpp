@@ -881,7 +881,7 @@ Error initialize()
    // subscribe to events
    using boost::bind;
    module_context::events().onClientInit.connect(bind(onClientInit));
-   module_context::events().onDetectChanges.connect(bind(onDetectChanges, _1));
+   module_context::registerChangeDetection("plots", bind(onDetectChanges, _1));
    module_context::events().onBeforeExecute.connect(bind(onBeforeExecute));
    module_context::events().onBackgroundProcessing.connect(onBackgroundProcessing);
 
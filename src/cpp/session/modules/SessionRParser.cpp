@@ -1397,6 +1397,13 @@ private:
 
 void doParse(RTokenCursor&, ParseStatus&);
 
+namespace {
+
+bool computeChunkBoundaries(const RTokens& rTokens,
+                            std::vector<ChunkBoundary>* pBoundaries);
+
+} // anonymous namespace
+
 ParseResults parse(const FilePath& filePath,
                    const std::wstring& rCode,
                    const ParseOptions& parseOptions)
@@ -1404,7 +1411,7 @@ ParseResults parse(const FilePath& filePath,
    if (rCode.empty() || rCode.find_first_not_of(L" \r\n\t\v") == std::string::npos)
       return ParseResults();
    
-   RTokens rTokens(rCode, RTokens::StripComments);
+   RTokens rTokens(&rCode, RTokens::StripComments);
    if (rTokens.empty())
       return ParseResults();
    
@@ -1420,8 +1427,17 @@ ParseResults parse(const FilePath& filePath,
    }
    
    status.addLintIfBracketStackNotEmpty();
-   
-   return ParseResults(status.root(), status.lint(), parseOptions.globals());
+
+   ParseResults results(status.root(), status.lint(), parseOptions.globals());
+
+   // record the top-level chunking with the results (the tokens are
+   // already in hand, so this costs only a scan) -- it spares a later
+   // incremental re-parse from re-tokenizing this version of the code
+   std::vector<ChunkBoundary> boundaries;
+   if (computeChunkBoundaries(rTokens, &boundaries))
+      results.setChunkBoundaries(boundaries);
+
+   return results;
 }
 
 ParseResults parse(const std::string& rCode,
@@ -1457,6 +1473,341 @@ ParseResults parse(const FilePath &filePath, const ParseOptions &parseOptions)
             string_utils::utf8ToWide(contents),
             parseOptions);
 }
+
+namespace {
+
+bool isControlFlowKeyword(const RToken& rToken)
+{
+   return rToken.contentEquals(L"if") ||
+          rToken.contentEquals(L"for") ||
+          rToken.contentEquals(L"while") ||
+          rToken.contentEquals(L"function") ||
+          rToken.contentEquals(L"else") ||
+          rToken.contentEquals(L"repeat");
+}
+
+// does the token at 'index' close the parenthesized portion of a
+// control flow construct, e.g. the '(x)' in 'if (x) ...'? if so, the
+// following expression continues that construct, and so cannot begin
+// a new top-level chunk
+bool closesControlFlowParens(const RTokens& rTokens, std::size_t index)
+{
+   int depth = 0;
+   for (std::size_t i = index + 1; i != 0; --i)
+   {
+      const RToken& rToken = rTokens.at(i - 1);
+      if (rToken.isType(RToken::RPAREN))
+      {
+         ++depth;
+      }
+      else if (rToken.isType(RToken::LPAREN))
+      {
+         if (--depth > 0)
+            continue;
+
+         // found the matching '(' -- check the token preceding it
+         for (std::size_t j = i - 1; j != 0; --j)
+         {
+            const RToken& prevToken = rTokens.at(j - 1);
+            if (prevToken.isType(RToken::WHITESPACE) ||
+                prevToken.isType(RToken::COMMENT))
+            {
+               continue;
+            }
+
+            return prevToken.contentEquals(L"if") ||
+                   prevToken.contentEquals(L"for") ||
+                   prevToken.contentEquals(L"while") ||
+                   prevToken.contentEquals(L"function");
+         }
+
+         return false;
+      }
+   }
+
+   return false;
+}
+
+// compute the offsets at which new top-level expressions begin. returns
+// false if the code contains tokenization errors or unbalanced closing
+// brackets, as the chunking is then unreliable. (whitespace and comment
+// tokens are skipped, so stripped and unstripped token streams for the
+// same code chunk identically.)
+bool computeChunkBoundaries(const RTokens& rTokens,
+                            std::vector<ChunkBoundary>* pBoundaries)
+{
+   // the first chunk implicitly begins at the start of the document
+   pBoundaries->push_back(ChunkBoundary(0, 0));
+
+   int depth = 0;
+   std::size_t prevSignificant = static_cast<std::size_t>(-1);
+
+   for (std::size_t i = 0, n = rTokens.size(); i < n; ++i)
+   {
+      const RToken& rToken = rTokens.at(i);
+
+      if (rToken.isType(RToken::ERR))
+         return false;
+
+      if (rToken.isType(RToken::WHITESPACE) ||
+          rToken.isType(RToken::COMMENT))
+      {
+         continue;
+      }
+
+      if (rToken.isType(RToken::RPAREN) ||
+          rToken.isType(RToken::RBRACKET) ||
+          rToken.isType(RToken::RDBRACKET) ||
+          rToken.isType(RToken::RBRACE))
+      {
+         if (--depth < 0)
+            return false;
+
+         prevSignificant = i;
+         continue;
+      }
+
+      // a new top-level expression can begin only at column 0, outside
+      // of any brackets
+      if (depth == 0 && rToken.column() == 0 && rToken.offset() != 0)
+      {
+         bool continuation = false;
+
+         // an operator cannot begin a new expression -- treat it as
+         // continuing the previous chunk to be safe
+         if (rToken.isType(RToken::OPER) ||
+             rToken.isType(RToken::UOPER) ||
+             rToken.isType(RToken::COMMA) ||
+             rToken.isType(RToken::SEMI))
+         {
+            continuation = true;
+         }
+
+         if (!continuation && prevSignificant != static_cast<std::size_t>(-1))
+         {
+            const RToken& prevToken = rTokens.at(prevSignificant);
+
+            // a trailing operator or comma leaves the previous
+            // expression incomplete
+            if (prevToken.isType(RToken::OPER) ||
+                prevToken.isType(RToken::UOPER) ||
+                prevToken.isType(RToken::COMMA))
+            {
+               continuation = true;
+            }
+
+            // so does a control flow keyword, or the closing paren of
+            // a control flow condition (e.g. 'if (x)\nfoo()')
+            else if (prevToken.isType(RToken::ID) &&
+                     isControlFlowKeyword(prevToken))
+            {
+               continuation = true;
+            }
+            else if (prevToken.isType(RToken::RPAREN) &&
+                     closesControlFlowParens(rTokens, prevSignificant))
+            {
+               continuation = true;
+            }
+         }
+
+         if (!continuation)
+            pBoundaries->push_back(ChunkBoundary(rToken.offset(), rToken.row()));
+      }
+
+      if (rToken.isType(RToken::LPAREN) ||
+          rToken.isType(RToken::LBRACKET) ||
+          rToken.isType(RToken::LDBRACKET) ||
+          rToken.isType(RToken::LBRACE))
+      {
+         ++depth;
+      }
+
+      prevSignificant = i;
+   }
+
+   return true;
+}
+
+bool computeChunkBoundaries(const std::wstring& rCode,
+                            std::vector<ChunkBoundary>* pBoundaries)
+{
+   RTokens rTokens(&rCode);
+   return computeChunkBoundaries(rTokens, pBoundaries);
+}
+
+} // anonymous namespace
+
+ParseResults parseIncremental(const FilePath& filePath,
+                              const std::wstring& rCode,
+                              const std::wstring& previousCode,
+                              const ParseResults& previousResults,
+                              const ParseOptions& parseOptions)
+{
+   // no change: reuse the previous results wholesale
+   if (rCode == previousCode)
+      return previousResults;
+
+   // compute the top-level chunking of the new document; if it's
+   // unreliable, fall back to a full parse
+   std::vector<ChunkBoundary> chunks;
+   if (!computeChunkBoundaries(rCode, &chunks))
+      return parse(filePath, rCode, parseOptions);
+
+   // the chunking of the previous version was recorded with its parse
+   // results, so normally the old code needn't be re-tokenized at all
+   std::vector<ChunkBoundary> previousChunks;
+   if (previousResults.hasChunkBoundaries())
+   {
+      previousChunks = previousResults.chunkBoundaries();
+   }
+   else if (!computeChunkBoundaries(previousCode, &previousChunks))
+   {
+      return parse(filePath, rCode, parseOptions);
+   }
+
+   std::map<std::size_t, std::size_t> previousBoundaries;
+   BOOST_FOREACH(const ChunkBoundary& boundary, previousChunks)
+      previousBoundaries[boundary.offset] = boundary.row;
+
+   // compute the extent of the change
+   std::size_t minSize = std::min(rCode.size(), previousCode.size());
+
+   std::size_t prefixLength = 0;
+   while (prefixLength < minSize &&
+          rCode[prefixLength] == previousCode[prefixLength])
+   {
+      ++prefixLength;
+   }
+
+   std::size_t suffixLength = 0;
+   while (suffixLength < minSize - prefixLength &&
+          rCode[rCode.size() - suffixLength - 1] ==
+             previousCode[previousCode.size() - suffixLength - 1])
+   {
+      ++suffixLength;
+   }
+
+   // re-parse from the start of the last chunk preceding the change
+   // which is a chunk boundary in both versions of the document (the
+   // documents agree byte-for-byte up to 'prefixLength', so offsets
+   // within the prefix are directly comparable)
+   ChunkBoundary reparseStart(0, 0);
+   BOOST_FOREACH(const ChunkBoundary& boundary, chunks)
+   {
+      if (boundary.offset > prefixLength)
+         break;
+
+      if (previousBoundaries.count(boundary.offset))
+         reparseStart = boundary;
+   }
+
+   // find the first chunk boundary at or after the end of the change
+   // which aligns with a chunk boundary in the previous document
+   std::ptrdiff_t sizeDelta =
+         static_cast<std::ptrdiff_t>(rCode.size()) -
+         static_cast<std::ptrdiff_t>(previousCode.size());
+
+   std::size_t changeEnd = rCode.size() - suffixLength;
+
+   bool haveSuffix = false;
+   std::size_t suffixOffset = rCode.size();
+   std::size_t suffixRow = 0;
+   std::size_t previousSuffixRow = static_cast<std::size_t>(-1);
+   int rowDelta = 0;
+
+   BOOST_FOREACH(const ChunkBoundary& boundary, chunks)
+   {
+      if (boundary.offset < changeEnd || boundary.offset < reparseStart.offset)
+         continue;
+
+      std::ptrdiff_t previousOffset =
+            static_cast<std::ptrdiff_t>(boundary.offset) - sizeDelta;
+
+      if (previousOffset < static_cast<std::ptrdiff_t>(reparseStart.offset))
+         continue;
+
+      std::map<std::size_t, std::size_t>::const_iterator it =
+            previousBoundaries.find(static_cast<std::size_t>(previousOffset));
+
+      if (it != previousBoundaries.end())
+      {
+         haveSuffix = true;
+         suffixOffset = boundary.offset;
+         suffixRow = boundary.row;
+         previousSuffixRow = it->second;
+         rowDelta = static_cast<int>(suffixRow) -
+                    static_cast<int>(previousSuffixRow);
+         break;
+      }
+   }
+
+   // if nothing is reusable, just perform a full parse
+   if (!haveSuffix && reparseStart.offset == 0)
+      return parse(filePath, rCode, parseOptions);
+
+   // parse the changed region
+   std::wstring fragment =
+         rCode.substr(reparseStart.offset, suffixOffset - reparseStart.offset);
+
+   ParseResults fragmentResults = parse(filePath, fragment, parseOptions);
+
+   // splice the reusable nodes from the previous parse tree around the
+   // freshly parsed ones
+   boost::shared_ptr<ParseNode> pRoot = ParseNode::createRootNode();
+
+   previousResults.parseTree()->spliceInto(
+            reparseStart.row, previousSuffixRow, rowDelta, pRoot.get());
+
+   if (fragmentResults.parseTree() != NULL)
+   {
+      fragmentResults.parseTree()->shiftRows(
+               static_cast<int>(reparseStart.row));
+
+      fragmentResults.parseTree()->spliceInto(
+               static_cast<std::size_t>(-1),
+               static_cast<std::size_t>(-1),
+               0,
+               pRoot.get());
+   }
+
+   pRoot->finalizeSplice();
+
+   // splice the lint the same way, preserving document order (chunks
+   // begin at column 0, so only rows need shifting)
+   LintItems lint;
+   BOOST_FOREACH(const LintItem& item, previousResults.lint().get())
+   {
+      if (item.endRow < static_cast<int>(reparseStart.row))
+         lint.push_back(item);
+   }
+
+   BOOST_FOREACH(const LintItem& item, fragmentResults.lint().get())
+   {
+      LintItem shifted = item;
+      shifted.startRow += static_cast<int>(reparseStart.row);
+      shifted.endRow += static_cast<int>(reparseStart.row);
+      lint.push_back(shifted);
+   }
+
+   if (haveSuffix)
+   {
+      BOOST_FOREACH(const LintItem& item, previousResults.lint().get())
+      {
+         if (item.startRow >= static_cast<int>(previousSuffixRow))
+         {
+            LintItem shifted = item;
+            shifted.startRow += rowDelta;
+            shifted.endRow += rowDelta;
+            lint.push_back(shifted);
+         }
+      }
+   }
+
+   ParseResults results(pRoot, lint, parseOptions.globals());
+   results.setChunkBoundaries(chunks);
+   return results;
+}
+
 namespace {
 
 bool closesArgumentList(const RTokenCursor& cursor,
@@ -24,6 +24,7 @@
 // #define RSTUDIO_DEBUG_LABEL "parser"
 // #define RSTUDIO_ENABLE_DEBUG_MACROS
 
+#include <algorithm>
 #include <vector>
 #include <map>
 #include <set>
@@ -950,9 +951,145 @@ public:
             symbols.begin(),
             symbols.end());
    }
-   
+
+   // Incremental reparsing support ----
+   //
+   // When only a portion of a document has changed, we re-parse just the
+   // top-level expressions overlapping the change, and then splice the
+   // unchanged nodes from the previous parse tree around the fresh ones.
+   // See 'rparser::parseIncremental()'.
+
+   // shift all positions recorded within this node (and its children)
+   // by the given number of rows
+   void shiftRows(int rowDelta)
+   {
+      position_.row += rowDelta;
+      shiftSymbolRows(&definedSymbols_, rowDelta);
+      shiftSymbolRows(&referencedSymbols_, rowDelta);
+      shiftSymbolRows(&nseReferencedSymbols_, rowDelta);
+      BOOST_FOREACH(const boost::shared_ptr<ParseNode>& pChild, children_)
+         pChild->shiftRows(rowDelta);
+   }
+
+   // move this (root) node's children and top-level symbols into
+   // 'pTarget'. entries located before 'beforeRow' move as-is; entries
+   // at or after 'fromRow' are shifted by 'rowDelta' first; entries
+   // between the two rows are dropped (the corresponding region of the
+   // document is re-parsed separately). note that this consumes the
+   // spliced node -- its children are re-parented into the target.
+   void spliceInto(std::size_t beforeRow,
+                   std::size_t fromRow,
+                   int rowDelta,
+                   ParseNode* pTarget)
+   {
+      BOOST_FOREACH(boost::shared_ptr<ParseNode>& pChild, children_)
+      {
+         std::size_t row = pChild->position_.row;
+         if (row >= beforeRow && row < fromRow)
+            continue;
+
+         if (row >= fromRow)
+            pChild->shiftRows(rowDelta);
+
+         pChild->pParent_ = pTarget;
+         pTarget->children_.push_back(pChild);
+      }
+      children_.clear();
+
+      spliceSymbols(&definedSymbols_, beforeRow, fromRow, rowDelta,
+                    &pTarget->definedSymbols_);
+      spliceSymbols(&referencedSymbols_, beforeRow, fromRow, rowDelta,
+                    &pTarget->referencedSymbols_);
+      spliceSymbols(&nseReferencedSymbols_, beforeRow, fromRow, rowDelta,
+                    &pTarget->nseReferencedSymbols_);
+
+      // package symbols carry no position information, so we simply
+      // merge them wholesale
+      mergePackageSymbols(internalSymbols_, &pTarget->internalSymbols_);
+      mergePackageSymbols(exportedSymbols_, &pTarget->exportedSymbols_);
+   }
+
+   // restore ordering invariants (children and symbol positions sorted
+   // by position) following a sequence of 'spliceInto()' calls
+   void finalizeSplice()
+   {
+      std::sort(children_.begin(), children_.end(), comparePositions);
+      sortSymbolPositions(&definedSymbols_);
+      sortSymbolPositions(&referencedSymbols_);
+      sortSymbolPositions(&nseReferencedSymbols_);
+   }
+
+private:
+
+   static void shiftSymbolRows(SymbolPositions* pSymbols, int rowDelta)
+   {
+      for (SymbolPositions::iterator it = pSymbols->begin();
+           it != pSymbols->end();
+           ++it)
+      {
+         BOOST_FOREACH(Position& position, it->second)
+            position.row += rowDelta;
+      }
+   }
+
+   static void spliceSymbols(SymbolPositions* pSymbols,
+                             std::size_t beforeRow,
+                             std::size_t fromRow,
+                             int rowDelta,
+                             SymbolPositions* pTarget)
+   {
+      for (SymbolPositions::const_iterator it = pSymbols->begin();
+           it != pSymbols->end();
+           ++it)
+      {
+         Positions spliced;
+         BOOST_FOREACH(const Position& position, it->second)
+         {
+            if (position.row < beforeRow)
+               spliced.push_back(position);
+            else if (position.row >= fromRow)
+               spliced.push_back(Position(position.row + rowDelta,
+                                          position.column));
+         }
+
+         if (!spliced.empty())
+         {
+            Positions& target = (*pTarget)[it->first];
+            target.insert(target.end(), spliced.begin(), spliced.end());
+         }
+      }
+      pSymbols->clear();
+   }
+
+   static void mergePackageSymbols(const PackageSymbols& symbols,
+                                   PackageSymbols* pTarget)
+   {
+      for (PackageSymbols::const_iterator it = symbols.begin();
+           it != symbols.end();
+           ++it)
+      {
+         (*pTarget)[it->first].insert(it->second.begin(), it->second.end());
+      }
+   }
+
+   static bool comparePositions(const boost::shared_ptr<ParseNode>& pLhs,
+                                const boost::shared_ptr<ParseNode>& pRhs)
+   {
+      return pLhs->position_ < pRhs->position_;
+   }
+
+   static void sortSymbolPositions(SymbolPositions* pSymbols)
+   {
+      for (SymbolPositions::iterator it = pSymbols->begin();
+           it != pSymbols->end();
+           ++it)
+      {
+         std::sort(it->second.begin(), it->second.end());
+      }
+   }
+
 public:
-   
+
    const std::string& name() const { return name_; }
    const Position& position() const { return position_; }
    
@@ -1406,25 +1543,43 @@ private:
    FilePath filePath_;
 };
 
+// the offset and row of a token beginning a new top-level expression
+// (a 'chunk'). recorded with parse results so that a later incremental
+// re-parse can align the old and new versions of a document without
+// re-tokenizing the old one (see 'rparser::parseIncremental()').
+struct ChunkBoundary
+{
+   ChunkBoundary(std::size_t offset, std::size_t row)
+      : offset(offset), row(row)
+   {
+   }
+
+   std::size_t offset;
+   std::size_t row;
+};
+
 class ParseResults {
-   
+
 public:
-   
+
    ParseResults()
-      : parseTree_(ParseNode::createRootNode())
+      : parseTree_(ParseNode::createRootNode()),
+        hasChunkBoundaries_(false)
    {}
-   
+
    ParseResults(boost::shared_ptr<ParseNode> parseTree,
                 const LintItems& lint)
       : parseTree_(parseTree),
-        lint_(lint)
+        lint_(lint),
+        hasChunkBoundaries_(false)
    {}
    ParseResults(boost::shared_ptr<ParseNode> parseTree,
                 const LintItems& lint,
                 const std::set<std::string>& globals)
       : parseTree_(parseTree),
         lint_(lint),
-        globals_(globals)
+        globals_(globals),
+        hasChunkBoundaries_(false)
    {}
    
    // copy ctor: copyable members
@@ -1439,12 +1594,27 @@ public:
    
    const std::set<std::string>& globals() const { return globals_; }
    std::set<std::string>& globals() { return globals_; }
-   
+
+   bool hasChunkBoundaries() const { return hasChunkBoundaries_; }
+
+   const std::vector<ChunkBoundary>& chunkBoundaries() const
+   {
+      return chunkBoundaries_;
+   }
+
+   void setChunkBoundaries(const std::vector<ChunkBoundary>& boundaries)
+   {
+      chunkBoundaries_ = boundaries;
+      hasChunkBoundaries_ = true;
+   }
+
 private:
-   
+
    boost::shared_ptr<ParseNode> parseTree_;
    LintItems lint_;
    std::set<std::string> globals_;
+   std::vector<ChunkBoundary> chunkBoundaries_;
+   bool hasChunkBoundaries_;
 };
 
 // Primary method ----
@@ -1452,6 +1622,19 @@ ParseResults parse(const core::FilePath& filePath,
                    const std::wstring& rCode,
                    const ParseOptions& parseOptions = ParseOptions());
 
+// Incremental variant of the above: re-parses only the top-level
+// expressions overlapping the change between 'previousCode' and 'rCode',
+// splicing the unchanged nodes and lint from 'previousResults' around
+// the freshly parsed ones. The previous results are consumed (their
+// nodes are re-parented into the new parse tree), so callers should
+// discard them in favor of the returned results. Falls back to a full
+// parse when the change cannot be isolated.
+ParseResults parseIncremental(const core::FilePath& filePath,
+                              const std::wstring& rCode,
+                              const std::wstring& previousCode,
+                              const ParseResults& previousResults,
+                              const ParseOptions& parseOptions = ParseOptions());
+
 // Useful aliases ----
 ParseResults parse(const core::FilePath& filePath,
                    const ParseOptions& parseOptions = ParseOptions());
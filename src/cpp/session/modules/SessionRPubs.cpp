@@ -432,8 +432,23 @@ Error initialize()
    ;
    return initBlock.execute();
 }
-   
-   
+
+Error initializeLazy()
+{
+   // initialization only registers rpc methods, so it can be deferred
+   // until one of them is first invoked
+   std::vector<std::string> methods;
+   methods.push_back("rpubs_is_published");
+   methods.push_back("rpubs_upload");
+   methods.push_back("terminate_rpubs_upload");
+
+   return module_context::registerLazyModule("rpubs",
+                                             initialize,
+                                             methods,
+                                             std::vector<std::string>());
+}
+
+
 } // namespace rpubs
 } // namespace modules
 
@@ -31,7 +31,11 @@ namespace modules {
 namespace rpubs {
 
 core::Error initialize();
-   
+
+// register the module's rpc methods as lazy stubs (full initialization
+// occurs on first use)
+core::Error initializeLazy();
+
 } // namespace rpubs
 } // namepace handlers
 } // namespace session
@@ -119,8 +119,10 @@ SEXP rs_fromJSON(SEXP objectSEXP)
    json::Value jsonValue;
    if (!json::parse(contents, &jsonValue))
       return R_NilValue;
-   
-   r::sexp::Protect protect;
+
+   // payloads can be arbitrarily large, so guard the conversion with an
+   // arena rather than one protection stack slot per element
+   r::sexp::ProtectArena protect;
    return r::sexp::create(jsonValue, &protect);
 }
 
@@ -80,6 +80,25 @@ bool s_isSvnSshRepository = false;
 /** GLOBAL STATE **/
 FilePath s_workingDir;
 
+// cached working copy status -- svn status over a remote working copy can
+// take long enough to block the console prompt, so status requests are
+// served from this cache and a background svn invocation refreshes it
+// (see startBackgroundStatusRefresh below)
+bool s_statusCacheValid = false;
+bool s_statusRefreshRunning = false;
+bool s_statusRefreshPending = false;
+std::vector<source_control::FileWithStatus> s_cachedStatusFiles;
+
+void invalidateStatusCache()
+{
+   s_statusCacheValid = false;
+
+   // if a refresh is in flight its result no longer reflects the working
+   // copy; have it run again when it completes
+   if (s_statusRefreshRunning)
+      s_statusRefreshPending = true;
+}
+
 FilePath resolveAliasedPath(const std::string& path)
 {
    if (boost::algorithm::starts_with(path, "~/"))
@@ -191,6 +210,9 @@ Error runSvn(const ShellArgs& args,
              bool redirectStdErrToStdOut,
              core::system::ProcessResult* pResult)
 {
+   // any svn command can change the state summarized by status
+   invalidateStatusCache();
+
    core::system::ProcessOptions options = procOptions();
    if (!workingDir.empty())
       options.workingDir = workingDir;
@@ -273,6 +295,9 @@ core::Error createConsoleProc(const ShellArgs& args,
    // create the process
    *ppCP = ConsoleProcess::create(command, options, pCPI);
 
+   // any svn command run in the console can change working copy status
+   (*ppCP)->onExit().connect(boost::bind(&invalidateStatusCache));
+
    if (enqueueRefreshOnExit)
       (*ppCP)->onExit().connect(boost::bind(&enqueueRefreshEvent));
 
@@ -428,6 +453,19 @@ Error parseXml(const std::string strData,
 
 bool isSvnInstalled()
 {
+   // memoize the probe (it forks `svn help` and is asked both at module
+   // init and again when building the client init payload); re-probe
+   // only if the configured executable changes
+   static bool s_haveResult = false;
+   static bool s_installed = false;
+   static std::string s_probedExePath;
+   if (s_haveResult && s_probedExePath == s_svnExePath)
+      return s_installed;
+
+   s_probedExePath = s_svnExePath;
+   s_haveResult = true;
+   s_installed = false;
+
    // special check on osx mavericks to make sure we don't run the fake svn
    if (module_context::isOSXMavericks() &&
        !module_context::hasOSXMavericksDeveloperTools() &&
@@ -445,7 +483,8 @@ bool isSvnInstalled()
       return false;
    }
 
-   return exitCode == EXIT_SUCCESS;
+   s_installed = (exitCode == EXIT_SUCCESS);
+   return s_installed;
 }
 
 struct SvnInfo
@@ -845,36 +884,15 @@ Error statusToJson(const core::FilePath &path,
    return Success();
 }
 
-Error status(const FilePath& filePath,
-             std::vector<source_control::FileWithStatus>* pFiles)
+Error parseStatusXml(const std::string& stdOut,
+                     std::vector<source_control::FileWithStatus>* pFiles)
 {
    using namespace source_control;
 
-   ShellArgs args;
-   args << "status" << globalArgs() << "--xml" << "--ignore-externals";
-   if (!filePath.empty())
-      args << "--" << filePath;
-
-   std::string stdOut, stdErr;
-   int exitCode;
-   Error error = runSvn(
-         args,
-         &stdOut,
-         &stdErr,
-         &exitCode);
-   if (error)
-      return error;
-
-   if (exitCode != EXIT_SUCCESS)
-   {
-      LOG_ERROR_MESSAGE(stdErr);
-      return Success();
-   }
-
    std::vector<char> xmlData;
    using namespace rapidxml;
    xml_document<> doc;
-   error = parseXml(stdOut, &xmlData, &doc);
+   Error error = parseXml(stdOut, &xmlData, &doc);
    if (error)
       return error;
 
@@ -948,6 +966,98 @@ Error status(const FilePath& filePath,
    return Success();
 }
 
+Error status(const FilePath& filePath,
+             std::vector<source_control::FileWithStatus>* pFiles)
+{
+   ShellArgs args;
+   args << "status" << globalArgs() << "--xml" << "--ignore-externals";
+   if (!filePath.empty())
+      args << "--" << filePath;
+
+   std::string stdOut, stdErr;
+   int exitCode;
+   Error error = runSvn(
+         args,
+         &stdOut,
+         &stdErr,
+         &exitCode);
+   if (error)
+      return error;
+
+   if (exitCode != EXIT_SUCCESS)
+   {
+      LOG_ERROR_MESSAGE(stdErr);
+      return Success();
+   }
+
+   return parseStatusXml(stdOut, pFiles);
+}
+
+void startBackgroundStatusRefresh();
+
+void onBackgroundStatusCompleted(const core::system::ProcessResult& result)
+{
+   s_statusRefreshRunning = false;
+
+   bool wasPending = s_statusRefreshPending;
+   s_statusRefreshPending = false;
+
+   if (result.exitStatus != EXIT_SUCCESS)
+   {
+      LOG_ERROR_MESSAGE(result.stdErr);
+   }
+   else if (!wasPending)
+   {
+      std::vector<source_control::FileWithStatus> files;
+      Error error = parseStatusXml(result.stdOut, &files);
+      if (error)
+      {
+         LOG_ERROR(error);
+         return;
+      }
+
+      s_cachedStatusFiles = files;
+      s_statusCacheValid = true;
+
+      // tell the client fresh status is available (it will pick it up
+      // from the cache without blocking)
+      enqueueRefreshEvent();
+   }
+
+   // the working copy changed while we were running; go again
+   if (wasPending)
+      startBackgroundStatusRefresh();
+}
+
+void startBackgroundStatusRefresh()
+{
+   if (s_statusRefreshRunning || s_workingDir.empty())
+      return;
+   s_statusRefreshRunning = true;
+
+   // run status directly through the process supervisor rather than
+   // runSvn so collecting it never blocks (and never invalidates the
+   // cache it is about to fill)
+   ShellArgs args;
+   args << "status" << globalArgs() << "--xml" << "--ignore-externals";
+
+   module_context::processSupervisor().runCommand(
+            svn() << args.args(),
+            procOptions(),
+            &onBackgroundStatusCompleted);
+}
+
+// serve repository status from the cache, kicking off a background
+// refresh when it's stale; callers get the last known status immediately
+// and a refresh event is enqueued once current results are in
+void cachedStatus(std::vector<source_control::FileWithStatus>* pFiles)
+{
+   if (!s_statusCacheValid)
+      startBackgroundStatusRefresh();
+
+   *pFiles = s_cachedStatusFiles;
+}
+
 Error status(const FilePath& filePath,
              json::Array* pResults)
 {
@@ -970,10 +1080,18 @@ Error status(const FilePath& filePath,
 Error svnStatus(const json::JsonRpcRequest& request,
                 json::JsonRpcResponse* pResponse)
 {
+   std::vector<source_control::FileWithStatus> files;
+   cachedStatus(&files);
+
    json::Array results;
-   Error error = status(FilePath(), &results);
-   if (error)
-      return error;
+   BOOST_FOREACH(const source_control::FileWithStatus& file, files)
+   {
+      json::Object fileObj;
+      Error error = statusToJson(file.path, file.status, &fileObj);
+      if (error)
+         return error;
+      results.push_back(fileObj);
+   }
 
    pResponse->setResult(results);
 
@@ -1772,10 +1890,10 @@ SvnFileDecorationContext::SvnFileDecorationContext(
 {
    using namespace source_control;
 
+   // the cached status covers the whole working copy, which includes
+   // whatever directory we're decorating
    std::vector<FileWithStatus> results;
-   Error error = status(rootDir, &results);
-   if (error)
-      return;
+   cachedStatus(&results);
 
    vcsResult_ = StatusResult(results);
 }
@@ -1891,6 +2009,24 @@ Error initialize()
    return Success();
 }
 
+namespace {
+
+void onWorkingCopyFilesChanged(
+                  const std::vector<core::system::FileChangeEvent>& events)
+{
+   // refresh in the background so up-to-date status arrives via a
+   // client event rather than being collected while the client waits
+   invalidateStatusCache();
+   startBackgroundStatusRefresh();
+}
+
+void onFileMonitorDisabled()
+{
+   invalidateStatusCache();
+}
+
+} // anonymous namespace
+
 Error initializeSvn(const core::FilePath& workingDir)
 {
    s_workingDir = workingDir;
@@ -1904,6 +2040,15 @@ Error initializeSvn(const core::FilePath& workingDir)
 
    userSettings().onChanged.connect(onUserSettingsChanged);
 
+   // keep the status cache fresh as the working copy changes on disk
+   if (projects::projectContext().hasProject())
+   {
+      session::projects::FileMonitorCallbacks cb;
+      cb.onFilesChanged = onWorkingCopyFilesChanged;
+      cb.onMonitoringDisabled = onFileMonitorDisabled;
+      projects::projectContext().subscribeToFileMonitor("", cb);
+   }
+
    return Success();
 }
 
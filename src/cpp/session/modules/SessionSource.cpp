@@ -18,6 +18,7 @@
 
 #include <string>
 #include <map>
+#include <deque>
 
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
@@ -286,38 +287,18 @@ Error openDocument(const json::JsonRpcRequest& request,
    return Success();
 } 
 
-Error saveDocumentCore(const std::string& contents,
-                       const json::Value& jsonPath,
-                       const json::Value& jsonType,
-                       const json::Value& jsonEncoding,
-                       const json::Value& jsonFoldSpec,
-                       const json::Value& jsonChunkOutput,
-                       boost::shared_ptr<SourceDocument> pDoc)
+Error applyDocumentMetadata(const json::Value& jsonType,
+                            const json::Value& jsonEncoding,
+                            const json::Value& jsonFoldSpec,
+                            const json::Value& jsonChunkOutput,
+                            boost::shared_ptr<SourceDocument> pDoc)
 {
-   // check whether we have a path and if we do get/resolve its value
-   std::string oldPath, path;
-   FilePath fullDocPath;
-   bool hasPath = json::isType<std::string>(jsonPath);
-   if (hasPath)
-   {
-      oldPath = pDoc->path();
-      path = jsonPath.get_str();
-      fullDocPath = module_context::resolveAliasedPath(path);
-   }
-
-   // update dirty state: dirty if there was no path AND the new contents
-   // are different from the old contents (and was thus a content autosave
-   // as distinct from a fold-spec or scroll-position/selection autosave)
-   pDoc->setDirty(!hasPath && (contents != pDoc->contents()));
-   
    bool hasType = json::isType<std::string>(jsonType);
    if (hasType)
    {
       pDoc->setType(jsonType.get_str());
    }
-   
-   Error error;
-   
+
    bool hasEncoding = json::isType<std::string>(jsonEncoding);
    if (hasEncoding)
    {
@@ -336,12 +317,47 @@ Error saveDocumentCore(const std::string& contents,
    bool hasChunkOutput = json::isType<json::Array>(jsonChunkOutput);
    if (hasChunkOutput && pDoc->isRMarkdownDocument())
    {
-      error = rmarkdown::notebook::setChunkDefs(pDoc, 
+      Error error = rmarkdown::notebook::setChunkDefs(pDoc,
             jsonChunkOutput.get_array());
       if (error)
          LOG_ERROR(error);
    }
 
+   return Success();
+}
+
+Error saveDocumentCore(const std::string& contents,
+                       const json::Value& jsonPath,
+                       const json::Value& jsonType,
+                       const json::Value& jsonEncoding,
+                       const json::Value& jsonFoldSpec,
+                       const json::Value& jsonChunkOutput,
+                       boost::shared_ptr<SourceDocument> pDoc)
+{
+   // check whether we have a path and if we do get/resolve its value
+   std::string oldPath, path;
+   FilePath fullDocPath;
+   bool hasPath = json::isType<std::string>(jsonPath);
+   if (hasPath)
+   {
+      oldPath = pDoc->path();
+      path = jsonPath.get_str();
+      fullDocPath = module_context::resolveAliasedPath(path);
+   }
+
+   // update dirty state: dirty if there was no path AND the new contents
+   // are different from the old contents (and was thus a content autosave
+   // as distinct from a fold-spec or scroll-position/selection autosave)
+   pDoc->setDirty(!hasPath && (contents != pDoc->contents()));
+
+   Error error = applyDocumentMetadata(jsonType,
+                                       jsonEncoding,
+                                       jsonFoldSpec,
+                                       jsonChunkOutput,
+                                       pDoc);
+   if (error)
+      return error;
+
    // handle document (varies depending upon whether we have a path)
    if (hasPath)
    {
@@ -502,39 +518,68 @@ Error saveDocumentDiff(const json::JsonRpcRequest& request,
    // Don't even attempt anything if we're not working off the same original
    if (pDoc->hash() == hash)
    {
-      std::string contents(pDoc->contents());
-
       // Offset and length are specified in characters, but contents
       // is in UTF8 bytes. Convert before using.
-      std::string::iterator rangeBegin = contents.begin();
-      error = utf8Advance(rangeBegin, offset, contents.end(), &rangeBegin);
+      const std::string& docContents = pDoc->contents();
+      std::string::const_iterator rangeBegin = docContents.begin();
+      error = utf8Advance(rangeBegin, offset, docContents.end(), &rangeBegin);
       if (error)
          return Success(); // UTF8 decoding failed. Abort differential save.
 
-      std::string::iterator rangeEnd = rangeBegin;
-      error = utf8Advance(rangeEnd, length, contents.end(), &rangeEnd);
+      std::string::const_iterator rangeEnd = rangeBegin;
+      error = utf8Advance(rangeEnd, length, docContents.end(), &rangeEnd);
       if (error)
          return Success(); // UTF8 decoding failed. Abort differential save.
 
-      contents.erase(rangeBegin, rangeEnd);
-      contents.insert(rangeBegin, replacement.begin(), replacement.end());
-      
-      // track if we're updating the document contents
-      bool hasChanges = contents != pDoc->contents();
-      error = saveDocumentCore(contents, jsonPath, jsonType, jsonEncoding,
-                               jsonFoldSpec, jsonChunkOutput, pDoc);
-      if (error)
-         return error;
-      
-      // write to the source database (don't worry about writing document
-      // contents if those have not changed)
-      error = sourceDatabasePutWithUpdatedContents(pDoc, hasChanges);
-      if (error)
-         return error;
+      std::size_t byteOffset = rangeBegin - docContents.begin();
+      std::size_t byteLength = rangeEnd - rangeBegin;
+
+      if (hasPath)
+      {
+         // saving to a file: materialize the edited contents and run the
+         // full save (encode, write to disk, re-read)
+         std::string contents(docContents);
+         contents.replace(byteOffset, byteLength, replacement);
+
+         // track if we're updating the document contents
+         bool hasChanges = contents != pDoc->contents();
+         error = saveDocumentCore(contents, jsonPath, jsonType, jsonEncoding,
+                                  jsonFoldSpec, jsonChunkOutput, pDoc);
+         if (error)
+            return error;
+
+         // write to the source database (don't worry about writing document
+         // contents if those have not changed)
+         error = sourceDatabasePutWithUpdatedContents(pDoc, hasChanges);
+         if (error)
+            return error;
+      }
+      else
+      {
+         // autosave: splice the replacement into the stored contents in
+         // place rather than materializing and comparing the full text
+         // (note that applyContentsEdit invalidates the iterators above)
+         bool hasChanges = pDoc->applyContentsEdit(byteOffset,
+                                                   byteLength,
+                                                   replacement);
+
+         // dirty if this was a content autosave (as distinct from a
+         // fold-spec or scroll-position/selection autosave)
+         pDoc->setDirty(hasChanges);
+
+         error = applyDocumentMetadata(jsonType, jsonEncoding, jsonFoldSpec,
+                                       jsonChunkOutput, pDoc);
+         if (error)
+            return error;
+
+         error = sourceDatabasePutWithUpdatedContents(pDoc, hasChanges);
+         if (error)
+            return error;
+      }
 
       pResponse->setResult(pDoc->hash());
    }
-   
+
    return Success();
 }
 
@@ -1243,21 +1288,59 @@ SEXP rs_requestDocumentSave(SEXP idsSEXP)
 
 } // anonymous namespace
 
+// incremental worker which replays doc updated events for documents
+// whose contents were deferred during client_init (source indexing and
+// other listeners need the full contents, but reading them can occur
+// during idle time rather than on the startup path)
+bool warmDeferredDocs(boost::shared_ptr<std::deque<std::string> > pIds)
+{
+   if (pIds->empty())
+      return false;
+
+   std::string id = pIds->front();
+   pIds->pop_front();
+
+   boost::shared_ptr<SourceDocument> pDoc(new SourceDocument());
+   Error error = source_database::get(id, pDoc);
+   if (error)
+      LOG_ERROR(error);
+   else
+      source_database::events().onDocUpdated(pDoc);
+
+   return !pIds->empty();
+}
+
 Error clientInitDocuments(core::json::Array* pJsonDocs)
 {
    source_database::events().onRemoveAll();
 
-   // get the docs and sort them by relative order
+   // get the docs (contents deferred) and sort them by relative order
    std::vector<boost::shared_ptr<SourceDocument> > docs ;
-   Error error = source_database::list(&docs);
+   Error error = source_database::list(&docs, false);
    if (error)
       return error ;
    std::sort(docs.begin(), docs.end(), sortByRelativeOrder);
 
    // populate the array
    pJsonDocs->clear();
+   boost::shared_ptr<std::deque<std::string> > pDeferredIds(
+                                                new std::deque<std::string>());
    BOOST_FOREACH( boost::shared_ptr<SourceDocument>& pDoc, docs )
    {
+      // contents are deferred for clean file-backed documents -- the
+      // client fetches them on demand with get_source_document, so
+      // startup doesn't pay for reading every open document. dirty and
+      // never-saved documents are sent inline (the source database is
+      // the only place their contents exist, and updateDirty below
+      // needs the contents to compare against disk)
+      bool deferContents = !pDoc->path().empty() && !pDoc->dirty();
+      if (!deferContents)
+      {
+         error = source_database::get(pDoc->id(), pDoc);
+         if (error)
+            LOG_ERROR(error);
+      }
+
       // Force dirty state to be checked.
       // Client and server dirty state can get out of sync because
       // undo/redo on the client side can make dirty documents
@@ -1268,16 +1351,32 @@ Error clientInitDocuments(core::json::Array* pJsonDocs)
       // on disk, and only do it when listing documents. However
       // it does mean that reloading the client may cause a dirty
       // document to become clean (if the contents are identical
-      // to what's on disk).
+      // to what's on disk). (note: this is a no-op for documents with
+      // deferred contents, which are clean by construction)
       error = pDoc->updateDirty();
       if (error)
          LOG_ERROR(error);
 
       json::Object jsonDoc ;
       writeDocToJson(pDoc, &jsonDoc);
+      if (deferContents)
+         jsonDoc["lazy_contents"] = true;
       pJsonDocs->push_back(jsonDoc);
 
-      source_database::events().onDocUpdated(pDoc);
+      if (deferContents)
+         pDeferredIds->push_back(pDoc->id());
+      else
+         source_database::events().onDocUpdated(pDoc);
+   }
+
+   // replay doc updated events for deferred documents during idle time
+   if (!pDeferredIds->empty())
+   {
+      module_context::scheduleIncrementalWork(
+               "warm deferred source docs",
+               boost::posix_time::milliseconds(100),
+               boost::bind(warmDeferredDocs, pDeferredIds),
+               true);
    }
 
    return Success();
@@ -15,10 +15,15 @@
 
 #include "SessionSpelling.hpp"
 
+#include <cctype>
+#include <map>
+
+#include <boost/foreach.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include <core/Error.hpp>
 #include <core/Exec.hpp>
+#include <core/Log.hpp>
 
 #include <core/spelling/HunspellSpellingEngine.hpp>
 
@@ -29,6 +34,7 @@
 
 #include <session/SessionUserSettings.hpp>
 #include <session/SessionModuleContext.hpp>
+#include <session/SessionSourceDatabase.hpp>
 
 using namespace rstudio::core;
 
@@ -76,9 +82,15 @@ FilePath userDictionariesDir()
 }
 
 
+void invalidateDocumentCheckState();
+
 void syncSpellingEngineDictionaries()
 {
    s_pSpellingEngine->useDictionary(userSettings().spellingLanguage());
+
+   // incremental results checked against the previous dictionaries are
+   // no longer meaningful
+   invalidateDocumentCheckState();
 }
 
 
@@ -97,6 +109,257 @@ FilePath allLanguagesDir()
 }
 
 
+// --- incremental document checking -----------------------------------
+//
+// the check_spelling rpc checks a flat batch of words, which forces the
+// client to re-submit an entire document's words on every pass. for
+// spell-check-as-you-type the session instead keeps per-document state:
+// the contents last checked and the misspelled ranges found in them.
+// source database updates locate the edited span by prefix/suffix
+// comparison (the database delivers whole contents, not deltas), shift
+// the ranges around it and re-check only the words it touches, so the
+// check_spelling_document rpc just reads out the current interval set
+
+struct DocumentCheckState
+{
+   // COPYING: via compiler (copyable members)
+
+   typedef std::map<std::size_t, std::size_t> RangeMap;
+
+   std::string contents;
+
+   // misspelled ranges as begin -> end byte offsets (non-overlapping,
+   // each covering exactly one word)
+   RangeMap misspelled;
+};
+
+typedef std::map<std::string, boost::shared_ptr<DocumentCheckState> >
+                                                         DocCheckStates;
+DocCheckStates s_docCheckStates;
+
+// word character test over utf-8 bytes: letters plus any non-ascii
+// byte. hunspell's word characters are dictionary specific, but
+// letters are common to all of them and misclassified punctuation
+// merely yields a token the engine reports as correct
+bool isWordByte(unsigned char ch)
+{
+   return ::isalpha(ch) != 0 || ch >= 0x80;
+}
+
+bool isWordChar(const std::string& contents, std::size_t pos)
+{
+   unsigned char ch = contents[pos];
+   if (isWordByte(ch))
+      return true;
+
+   // apostrophes join a word when flanked by word bytes (don't, isn't)
+   return ch == '\'' &&
+          pos > 0 && isWordByte(contents[pos-1]) &&
+          pos + 1 < contents.size() && isWordByte(contents[pos+1]);
+}
+
+void expandToWordBoundaries(const std::string& contents,
+                            std::size_t* pBegin,
+                            std::size_t* pEnd)
+{
+   while (*pBegin > 0 && isWordChar(contents, *pBegin - 1))
+      (*pBegin)--;
+   while (*pEnd < contents.size() && isWordChar(contents, *pEnd))
+      (*pEnd)++;
+}
+
+// re-check the words within [begin, end) and merge the results into
+// the document's interval set
+void checkDocumentRange(boost::shared_ptr<DocumentCheckState> pState,
+                        std::size_t begin,
+                        std::size_t end)
+{
+   const std::string& contents = pState->contents;
+   end = std::min(end, contents.size());
+   begin = std::min(begin, end);
+   expandToWordBoundaries(contents, &begin, &end);
+
+   // drop previous results within the range
+   std::map<std::size_t, std::size_t>::iterator it =
+                                 pState->misspelled.lower_bound(begin);
+   while (it != pState->misspelled.end() && it->first < end)
+      pState->misspelled.erase(it++);
+
+   // tokenize the range
+   std::vector<std::string> words;
+   std::vector<std::size_t> wordBegins;
+   std::size_t pos = begin;
+   while (pos < end)
+   {
+      if (!isWordChar(contents, pos))
+      {
+         pos++;
+         continue;
+      }
+
+      std::size_t wordBegin = pos;
+      while (pos < end && isWordChar(contents, pos))
+         pos++;
+      words.push_back(contents.substr(wordBegin, pos - wordBegin));
+      wordBegins.push_back(wordBegin);
+   }
+
+   if (words.empty())
+      return;
+
+   // check the words with a single engine call. as with the batch rpc,
+   // engine errors are never put in front of the user -- unchecked
+   // words read as correct
+   std::vector<bool> correct;
+   Error error = s_pSpellingEngine->checkSpelling(words, &correct);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   for (std::size_t i = 0; i < correct.size() && i < words.size(); i++)
+   {
+      if (!correct[i])
+         pState->misspelled[wordBegins[i]] = wordBegins[i] + words[i].size();
+   }
+}
+
+void onDocUpdated(boost::shared_ptr<source_database::SourceDocument> pDoc)
+{
+   // only documents the client has asked us to check are tracked
+   DocCheckStates::iterator it = s_docCheckStates.find(pDoc->id());
+   if (it == s_docCheckStates.end())
+      return;
+
+   boost::shared_ptr<DocumentCheckState> pState = it->second;
+   const std::string& oldContents = pState->contents;
+   const std::string& newContents = pDoc->contents();
+
+   // locate the edited span by prefix/suffix comparison
+   std::size_t maxPrefix = std::min(oldContents.size(), newContents.size());
+   std::size_t prefix = 0;
+   while (prefix < maxPrefix && oldContents[prefix] == newContents[prefix])
+      prefix++;
+
+   if (prefix == oldContents.size() && prefix == newContents.size())
+      return; // identical contents
+
+   std::size_t suffix = 0;
+   std::size_t maxSuffix = maxPrefix - prefix;
+   while (suffix < maxSuffix &&
+          oldContents[oldContents.size() - suffix - 1] ==
+             newContents[newContents.size() - suffix - 1])
+   {
+      suffix++;
+   }
+
+   std::size_t oldEditEnd = oldContents.size() - suffix;
+   std::size_t newEditEnd = newContents.size() - suffix;
+
+   // keep results before the edit, shift results after it by the size
+   // delta, and drop results overlapping it (the re-check below puts
+   // back whatever is still misspelled)
+   DocumentCheckState::RangeMap shifted;
+   BOOST_FOREACH(const DocumentCheckState::RangeMap::value_type& range,
+                 pState->misspelled)
+   {
+      if (range.second <= prefix)
+      {
+         shifted.insert(range);
+      }
+      else if (range.first >= oldEditEnd)
+      {
+         shifted[range.first - oldEditEnd + newEditEnd] =
+                                 range.second - oldEditEnd + newEditEnd;
+      }
+   }
+   pState->misspelled.swap(shifted);
+
+   pState->contents = newContents;
+   checkDocumentRange(pState, prefix, newEditEnd);
+}
+
+void onDocRemoved(const std::string& id, const std::string&)
+{
+   s_docCheckStates.erase(id);
+}
+
+void onDocRemoveAll()
+{
+   s_docCheckStates.clear();
+}
+
+// called on language and custom dictionary changes (see
+// syncSpellingEngineDictionaries)
+void invalidateDocumentCheckState()
+{
+   s_docCheckStates.clear();
+}
+
+Error checkSpellingDocument(const json::JsonRpcRequest& request,
+                            json::JsonRpcResponse* pResponse)
+{
+   std::string docId;
+   Error error = json::readParams(request.params, &docId);
+   if (error)
+      return error;
+
+   boost::shared_ptr<DocumentCheckState> pState;
+   DocCheckStates::iterator it = s_docCheckStates.find(docId);
+   if (it != s_docCheckStates.end())
+   {
+      pState = it->second;
+   }
+   else
+   {
+      // first check of this document: seed state from the source
+      // database and check the full contents (subsequent edits are
+      // checked incrementally as they arrive)
+      boost::shared_ptr<source_database::SourceDocument> pDoc(
+                                 new source_database::SourceDocument());
+      error = source_database::get(docId, pDoc);
+      if (error)
+         return error;
+
+      pState.reset(new DocumentCheckState());
+      pState->contents = pDoc->contents();
+      s_docCheckStates[docId] = pState;
+      checkDocumentRange(pState, 0, pState->contents.size());
+   }
+
+   // report misspelled ranges as [start, end) character offsets -- a
+   // single pass converts from the byte offsets kept internally
+   json::Array rangesJson;
+   const std::string& contents = pState->contents;
+   std::size_t bytePos = 0;
+   std::size_t charPos = 0;
+   BOOST_FOREACH(const DocumentCheckState::RangeMap::value_type& range,
+                 pState->misspelled)
+   {
+      for (; bytePos < range.first; bytePos++)
+      {
+         if ((contents[bytePos] & 0xC0) != 0x80)
+            charPos++;
+      }
+      std::size_t beginChar = charPos;
+      for (; bytePos < range.second; bytePos++)
+      {
+         if ((contents[bytePos] & 0xC0) != 0x80)
+            charPos++;
+      }
+
+      json::Array rangeJson;
+      rangeJson.push_back(static_cast<int>(beginChar));
+      rangeJson.push_back(static_cast<int>(charPos));
+      rangesJson.push_back(rangeJson);
+   }
+
+   pResponse->setResult(rangesJson);
+
+   return Success();
+}
+
 Error checkSpelling(const json::JsonRpcRequest& request,
                     json::JsonRpcResponse* pResponse)
 {
@@ -105,7 +368,9 @@ Error checkSpelling(const json::JsonRpcRequest& request,
    if (error)
       return error;
 
-   json::Array misspelledIndexes;
+   // extract the batch of words (preserving the caller's indexes)
+   std::vector<std::string> wordBatch;
+   std::vector<std::size_t> wordIndexes;
    for (std::size_t i=0; i<words.size(); i++)
    {
       if (!json::isType<std::string>(words[i]))
@@ -114,20 +379,23 @@ Error checkSpelling(const json::JsonRpcRequest& request,
          continue;
       }
 
-      std::string word = words[i].get_str();
-      bool isCorrect = true;
-      error = s_pSpellingEngine->checkSpelling(word, &isCorrect);
-      if (error)
-      {
-         // if we can't check a word, ignore it; some combinations of platform, non-ASCII
-         // characters, and locale are known to fail in iconv, and we don't want to put those
-         // failures in front of the user (we just won't be able to spell check those words)
-         LOG_ERROR(error);
-      }
-      else if (!isCorrect) 
-      {
-         misspelledIndexes.push_back(static_cast<int>(i));
-      }
+      wordBatch.push_back(words[i].get_str());
+      wordIndexes.push_back(i);
+   }
+
+   // check the entire batch with a single engine call (words which can't
+   // be checked are reported as correct so we never put e.g. iconv
+   // failures in front of the user)
+   std::vector<bool> correct;
+   error = s_pSpellingEngine->checkSpelling(wordBatch, &correct);
+   if (error)
+      return error;
+
+   json::Array misspelledIndexes;
+   for (std::size_t i=0; i<correct.size(); i++)
+   {
+      if (!correct[i])
+         misspelledIndexes.push_back(static_cast<int>(wordIndexes[i]));
    }
 
    pResponse->setResult(misspelledIndexes);
@@ -316,12 +584,19 @@ Error initialize()
    // connect to user settings changed
    userSettings().onChanged.connect(onUserSettingsChanged);
 
+   // connect to source database events so incremental document
+   // checking state tracks edits
+   source_database::events().onDocUpdated.connect(onDocUpdated);
+   source_database::events().onDocRemoved.connect(onDocRemoved);
+   source_database::events().onRemoveAll.connect(onDocRemoveAll);
+
    // register rpc methods
    using boost::bind;
    using namespace module_context;
    ExecBlock initBlock ;
    initBlock.addFunctions()
       (bind(registerRpcMethod, "check_spelling", checkSpelling))
+      (bind(registerRpcMethod, "check_spelling_document", checkSpellingDocument))
       (bind(registerRpcMethod, "suggestion_list", suggestionList))
       (bind(registerRpcMethod, "get_word_chars", getWordChars))
       (bind(registerRpcMethod, "add_custom_dictionary", addCustomDictionary))
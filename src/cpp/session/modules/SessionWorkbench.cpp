@@ -181,9 +181,30 @@ Error setClientState(const json::JsonRpcRequest& request,
 }
    
      
+// debounce for graphics resizes: an interactive pane drag sends a
+// stream of metrics updates and each new graphics size triggers a full
+// display list replay, so defer application of the graphics size until
+// it has been stable for a quiet period (the client stretches the
+// previously rendered raster to fit in the meantime). non-graphics
+// metrics (e.g. console width) still apply immediately
+bool s_haveClientMetrics = false;
+int s_graphicsSizeGeneration = 0;
+r::session::RClientMetrics s_appliedMetrics;   // currently in effect
+r::session::RClientMetrics s_requestedMetrics; // latest from the client
+
+void applyDeferredGraphicsSize(int generation)
+{
+   // a newer size arrived while we were waiting -- let its timer win
+   if (generation != s_graphicsSizeGeneration)
+      return;
+
+   s_appliedMetrics = s_requestedMetrics;
+   r::session::setClientMetrics(s_appliedMetrics);
+}
+
 // IN: WorkbenchMetrics object
 // OUT: Void
-Error setWorkbenchMetrics(const json::JsonRpcRequest& request, 
+Error setWorkbenchMetrics(const json::JsonRpcRequest& request,
                           json::JsonRpcResponse* pResponse)
 {
    // extract fields
@@ -196,10 +217,41 @@ Error setWorkbenchMetrics(const json::JsonRpcRequest& request,
                                  "devicePixelRatio", &(metrics.devicePixelRatio));
    if (error)
       return error;
-   
-   // set the metrics
-   r::session::setClientMetrics(metrics);
-   
+
+   // debounce graphics size changes (but apply the first metrics we
+   // see directly so startup sizing isn't delayed)
+   s_requestedMetrics = metrics;
+   if (s_haveClientMetrics &&
+       (metrics.graphicsWidth != s_appliedMetrics.graphicsWidth ||
+        metrics.graphicsHeight != s_appliedMetrics.graphicsHeight ||
+        metrics.devicePixelRatio != s_appliedMetrics.devicePixelRatio))
+   {
+      // replay the display list only once the size has been stable
+      // for the quiet period
+      int generation = ++s_graphicsSizeGeneration;
+      module_context::scheduleDelayedWork(
+               boost::posix_time::milliseconds(200),
+               boost::bind(applyDeferredGraphicsSize, generation),
+               false);
+
+      // apply the non-graphics metrics immediately (at the graphics
+      // size currently in effect)
+      metrics.graphicsWidth = s_appliedMetrics.graphicsWidth;
+      metrics.graphicsHeight = s_appliedMetrics.graphicsHeight;
+      metrics.devicePixelRatio = s_appliedMetrics.devicePixelRatio;
+      s_appliedMetrics = metrics;
+      r::session::setClientMetrics(metrics);
+   }
+   else
+   {
+      // matches the size in effect (or first update) -- apply directly
+      // and cancel any in-flight deferred resize
+      s_haveClientMetrics = true;
+      s_graphicsSizeGeneration++;
+      s_appliedMetrics = metrics;
+      r::session::setClientMetrics(metrics);
+   }
+
    return Success();
 }
 
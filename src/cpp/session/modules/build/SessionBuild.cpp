@@ -15,15 +15,19 @@
 
 #include "SessionBuild.hpp"
 
+#include <ctime>
+#include <set>
 #include <vector>
 
 #include <boost/utility.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/format.hpp>
 #include <boost/scope_exit.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/join.hpp>
+#include <boost/algorithm/string/trim.hpp>
 
 #include <core/Exec.hpp>
 #include <core/FileSerializer.hpp>
@@ -31,6 +35,12 @@
 #include <core/system/Process.hpp>
 #include <core/system/Environment.hpp>
 #include <core/system/ShellUtils.hpp>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <core/system/FileMode.hpp>
+#include <core/system/PosixSystem.hpp>
+#endif
 #include <core/r_util/RPackageInfo.hpp>
 
 
@@ -60,6 +70,155 @@ namespace session {
 
 namespace {
 
+// flow control for build output delivery: writes are batched and flushed
+// once a full event's byte budget accumulates or on a short cadence, so
+// verbose compilers don't flood the client event queue
+const std::size_t kBuildOutputFlushBytes = 16 * 1024;
+const long kBuildOutputFlushMs = 100;
+
+// how often to run the error parser over newly arrived output so errors
+// and warnings surface while the build is still running
+const long kBuildErrorParseMs = 1000;
+
+// trailing lines of already-parsed output carried into the next
+// incremental parse so diagnostics which span lines (gcc 'from' prefixes,
+// R parse errors) can match across chunk boundaries
+const std::size_t kErrorParseContextLines = 8;
+
+// time of the last successful package install in this session; lets the
+// next Install & Restart skip work when only R sources have changed
+std::time_t s_lastPackageInstallTime = 0;
+
+// time of the last successful R CMD check in this session; lets the next
+// check skip the manual and vignette phases when their inputs are unchanged
+std::time_t s_lastPackageCheckTime = 0;
+
+#ifndef _WIN32
+
+// Build job orchestration. R CMD INSTALL inherits whatever MAKEFLAGS the
+// session happens to have (usually nothing), so on shared build servers
+// compiles either leave cores idle or stampede when every user exports a
+// large -j by hand. Each package build instead claims a slot in a shared
+// registry -- a sticky world-writable directory of per-process files, the
+// same scheme used for the session stream directory -- and sizes its make
+// job count from the cores the load average says are idle, split across
+// the sessions currently building.
+const char * const kBuildJobsRegistry = "/tmp/rstudio-build-jobs";
+
+FilePath buildJobsRegistryDir()
+{
+   FilePath registryDir(kBuildJobsRegistry);
+   if (!registryDir.exists())
+   {
+      Error error = registryDir.ensureDirectory();
+      if (error)
+      {
+         LOG_ERROR(error);
+         return FilePath();
+      }
+
+      error = core::system::changeFileMode(
+                               registryDir,
+                               core::system::EveryoneReadWriteExecuteMode,
+                               true);
+      if (error)
+      {
+         LOG_ERROR(error);
+         return FilePath();
+      }
+   }
+   return registryDir;
+}
+
+FilePath buildJobsClaimPath(const FilePath& registryDir)
+{
+   return registryDir.childPath(safe_convert::numberToString(::getpid()));
+}
+
+// count the other sessions with builds in flight (reaping any claims left
+// behind by processes which no longer exist)
+int countOtherBuilders(const FilePath& registryDir)
+{
+   std::vector<FilePath> children;
+   Error error = registryDir.children(&children);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return 0;
+   }
+
+   int builders = 0;
+   BOOST_FOREACH(const FilePath& child, children)
+   {
+      pid_t pid = safe_convert::stringTo<pid_t>(child.filename(), -1);
+      if (pid == -1 || pid == ::getpid())
+         continue;
+
+      if (core::system::isProcessRunning(pid))
+      {
+         builders++;
+      }
+      else
+      {
+         // stale claim; removal is best effort (the file may belong to
+         // another user)
+         child.removeIfExists();
+      }
+   }
+   return builders;
+}
+
+// claim a build slot and return the make job count this build should use
+// (0 means leave MAKEFLAGS alone)
+int claimBuildJobs()
+{
+   FilePath registryDir = buildJobsRegistryDir();
+   if (registryDir.empty())
+      return 0;
+
+   // register before sampling so two builds started within the same
+   // load-average window don't both claim all of the idle cores
+   Error error = core::writeStringToFile(buildJobsClaimPath(registryDir),
+                                         std::string());
+   if (error)
+      LOG_ERROR(error);
+
+   core::system::SysInfo sysInfo;
+   error = core::system::systemInformation(&sysInfo);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return 0;
+   }
+
+   int cores = static_cast<int>(sysInfo.cores);
+   if (cores <= 1)
+      return 0;
+
+   // cores the load average says are free, split among the sessions
+   // currently building (the registry covers builds too recent to have
+   // moved the average yet)
+   int idleCores = cores - static_cast<int>(sysInfo.load1 + 0.5);
+   int jobs = idleCores / (1 + countOtherBuilders(registryDir));
+
+   // always make some progress, never exceed the box
+   if (jobs < 1)
+      jobs = 1;
+   else if (jobs > cores)
+      jobs = cores;
+   return jobs;
+}
+
+void releaseBuildJobs()
+{
+   Error error =
+         buildJobsClaimPath(FilePath(kBuildJobsRegistry)).removeIfExists();
+   if (error)
+      LOG_ERROR(error);
+}
+
+#endif
+
 std::string preflightPackageBuildErrorMessage(
       const std::string& message,
       const FilePath& buildDirectory)
@@ -83,6 +242,20 @@ std::string quoteString(const std::string& str)
    return "'" + str + "'";
 }
 
+// return (up to) the last 'lines' lines of the given text
+std::string lastLines(const std::string& text, std::size_t lines)
+{
+   std::string::size_type pos = std::string::npos;
+   for (std::size_t i = 0; i < lines; i++)
+   {
+      pos = text.find_last_of('\n', pos == std::string::npos ?
+                                       std::string::npos : pos - 1);
+      if (pos == std::string::npos || pos == 0)
+         return text;
+   }
+   return text.substr(pos + 1);
+}
+
 std::string packageArgsVector(std::string args)
 {
    // spilt the string
@@ -249,7 +422,10 @@ public:
 private:
    Build()
       : isRunning_(false), terminationRequested_(false), restartR_(false),
-        usedDevtools_(false), openErrorList_(true)
+        usedDevtools_(false), openErrorList_(true), pendingOutputBytes_(0),
+        droppingWarningBlock_(false), duplicateWarningCount_(0),
+        parsedOutputSize_(0), enquedErrorCount_(0), isInstallBuild_(false),
+        installStartTime_(0), isCheckBuild_(false), checkStartTime_(0)
    {
    }
 
@@ -614,11 +790,148 @@ private:
       }
    }
 
+   static bool checkChangedPath(const FilePath& packagePath,
+                                bool* pOnlyRChanged,
+                                bool* pAnyChanged,
+                                int level,
+                                const FilePath& path)
+   {
+      // ignore hidden files and folders (e.g. .git, .Rproj.user)
+      std::string relative = path.relativePath(packagePath);
+      if (boost::algorithm::starts_with(relative, ".") ||
+          boost::algorithm::contains(relative, "/."))
+      {
+         return true;
+      }
+
+      if (path.lastWriteTime() <= s_lastPackageInstallTime)
+         return true;
+
+      // directory modification times change when files are added or
+      // removed, so deletions are picked up here as well
+      *pAnyChanged = true;
+      if (relative != "R" && !boost::algorithm::starts_with(relative, "R/"))
+      {
+         *pOnlyRChanged = false;
+         return false; // no need to keep looking
+      }
+
+      return true;
+   }
+
+   bool onlyRSourcesChanged(const FilePath& packagePath)
+   {
+      // requires a successful install earlier in this session
+      if (s_lastPackageInstallTime == 0)
+         return false;
+
+      bool onlyRChanged = true, anyChanged = false;
+      Error error = packagePath.childrenRecursive(
+                           boost::bind(&Build::checkChangedPath,
+                                       packagePath,
+                                       &onlyRChanged, &anyChanged,
+                                       _1, _2));
+      if (error)
+      {
+         LOG_ERROR(error);
+         return false;
+      }
+
+      // require at least one changed R source -- an untouched tree gets
+      // the full install the user asked for
+      return onlyRChanged && anyChanged;
+   }
+
+   static bool checkCheckInputChanged(const FilePath& packagePath,
+                                      bool* pManualChanged,
+                                      bool* pVignettesChanged,
+                                      int level,
+                                      const FilePath& path)
+   {
+      // ignore hidden files and folders (e.g. .git, .Rproj.user)
+      std::string relative = path.relativePath(packagePath);
+      if (boost::algorithm::starts_with(relative, ".") ||
+          boost::algorithm::contains(relative, "/."))
+      {
+         return true;
+      }
+
+      if (path.lastWriteTime() <= s_lastPackageCheckTime)
+         return true;
+
+      // package metadata feeds both the manual and the vignette index
+      if (relative == "DESCRIPTION" || relative == "NAMESPACE")
+      {
+         *pManualChanged = true;
+         *pVignettesChanged = true;
+      }
+      else if (relative == "man" ||
+               boost::algorithm::starts_with(relative, "man/"))
+      {
+         *pManualChanged = true;
+      }
+      else if (relative == "vignettes" ||
+               boost::algorithm::starts_with(relative, "vignettes/") ||
+               relative == "inst/doc" ||
+               boost::algorithm::starts_with(relative, "inst/doc/"))
+      {
+         *pVignettesChanged = true;
+      }
+
+      // no need to keep looking once both phases are dirty
+      return !(*pManualChanged && *pVignettesChanged);
+   }
+
+   void reusableCheckPhases(const FilePath& packagePath,
+                            bool* pReuseManual,
+                            bool* pReuseVignettes)
+   {
+      *pReuseManual = false;
+      *pReuseVignettes = false;
+
+      // requires a successful check earlier in this session (note that this
+      // runs after auto-roxygenize, so regenerated Rd files count as changes)
+      if (s_lastPackageCheckTime == 0)
+         return;
+
+      bool manualChanged = false, vignettesChanged = false;
+      Error error = packagePath.childrenRecursive(
+                           boost::bind(&Build::checkCheckInputChanged,
+                                       packagePath,
+                                       &manualChanged, &vignettesChanged,
+                                       _1, _2));
+      if (error)
+      {
+         LOG_ERROR(error);
+         return;
+      }
+
+      // only report a phase as reused if the package actually has it
+      *pReuseManual = !manualChanged &&
+                      packagePath.childPath("man").exists();
+      *pReuseVignettes = !vignettesChanged &&
+                         packagePath.childPath("vignettes").exists();
+   }
+
+   void enqueReusedCheckPhases(bool reuseManual, bool reuseVignettes)
+   {
+      if (reuseManual)
+      {
+         enqueBuildOutput(module_context::kCompileOutputNormal,
+            "* reusing manual from last check (man/ unchanged)\n");
+      }
+      if (reuseVignettes)
+      {
+         enqueBuildOutput(module_context::kCompileOutputNormal,
+            "* reusing vignettes from last check (vignettes/ unchanged)\n");
+      }
+   }
+
    void buildPackage(const std::string& type,
                      const FilePath& packagePath,
                      const core::system::ProcessOptions& options,
                      const core::system::ProcessCallbacks& cb)
-   {      
+   {
 
       // if this action is going to INSTALL the package then on
       // windows we need to unload the library first
@@ -663,10 +976,24 @@ private:
       std::string libPaths = module_context::libPathsString();
       if (!libPaths.empty())
          core::system::setenv(&childEnv, "R_LIBS", libPaths);
-      
+
       // record the library paths used when this build was kicked off
       libPaths_ = module_context::getLibPaths();
 
+#ifndef _WIN32
+      // coordinate compile parallelism with the other builds on this
+      // machine (an explicit MAKEFLAGS in the environment always wins)
+      if (core::system::getenv(childEnv, "MAKEFLAGS").empty())
+      {
+         int jobs = claimBuildJobs();
+         if (jobs > 0)
+         {
+            core::system::setenv(&childEnv, "MAKEFLAGS",
+                                 "-j" + safe_convert::numberToString(jobs));
+         }
+      }
+#endif
+
       // prevent spurious cygwin warnings on windows
 #ifdef _WIN32
       core::system::setenv(&childEnv, "CYGWIN", "nodosfilewarning");
@@ -703,6 +1030,20 @@ private:
          // restart R after build is completed
          restartR_ = true;
 
+         // note when this install started (committed to
+         // s_lastPackageInstallTime only if it succeeds)
+         isInstallBuild_ = true;
+         installStartTime_ = std::time(NULL);
+
+         // consume the force-rebuild flag just once
+         bool forcePackageRebuild = collectForcePackageRebuild();
+
+         // when only R sources have changed since the last successful
+         // install we can skip the steps which dominate install time
+         bool incremental = !forcePackageRebuild &&
+                            (type == kBuildAndReload) &&
+                            onlyRSourcesChanged(packagePath);
+
          // build command
          module_context::RCommand rCmd(rBinDir);
          rCmd << "INSTALL";
@@ -711,12 +1052,21 @@ private:
          std::string extraArgs = projectConfig().packageInstallArgs;
 
          // add --preclean if this is a rebuild all
-         if (collectForcePackageRebuild() || (type == kRebuildAll))
+         if (forcePackageRebuild || (type == kRebuildAll))
          {
             if (!boost::algorithm::contains(extraArgs, "--preclean"))
                rCmd << "--preclean";
          }
 
+         // incremental install: just re-install the package's R code
+         // (the test load still runs, so errors surface as usual)
+         if (incremental)
+         {
+            rCmd << "--no-libs" << "--no-docs" << "--no-data" << "--no-demo"
+                 << "--no-exec" << "--no-inst" << "--no-multiarch"
+                 << "--no-lock";
+         }
+
          // remove --with-keep.source if this is R < 2.14
          if (!r::util::hasRequiredVersion("2.14"))
          {
@@ -758,6 +1108,11 @@ private:
 
       else if (type == kCheckPackage)
       {
+         // note when this check started (committed to
+         // s_lastPackageCheckTime only if it succeeds)
+         isCheckBuild_ = true;
+         checkStartTime_ = std::time(NULL);
+
          if (useDevtools())
             devtoolsCheckPackage(packagePath, pkgOptions, cb);
          else
@@ -846,6 +1201,11 @@ private:
    {
       // first build then check
 
+      // see which phases can be reused from the last successful check
+      bool reuseManual = false, reuseVignettes = false;
+      reusableCheckPhases(packagePath, &reuseManual, &reuseVignettes);
+      enqueReusedCheckPhases(reuseManual, reuseVignettes);
+
       // compose the build command
       module_context::RCommand rCmd(rBinDir);
       rCmd << "build";
@@ -853,12 +1213,16 @@ private:
       // add extra args if provided
       rCmd << projectConfig().packageBuildArgs;
 
-      // add --no-manual and --no-build-vignettes if they are in the check options
+      // add --no-manual and --no-build-vignettes if they are in the check
+      // options or covered by a previous check
       std::string checkArgs = projectConfig().packageCheckArgs;
-      if (checkArgs.find("--no-manual") != std::string::npos)
+      if (checkArgs.find("--no-manual") != std::string::npos || reuseManual)
          rCmd << "--no-manual";
-      if (checkArgs.find("--no-build-vignettes") != std::string::npos)
+      if (checkArgs.find("--no-build-vignettes") != std::string::npos ||
+          reuseVignettes)
+      {
          rCmd << "--no-build-vignettes";
+      }
 
       // add filename as a FilePath so it is escaped
       rCmd << FilePath(packagePath.filename());
@@ -872,6 +1236,15 @@ private:
       std::string extraArgs = projectConfig().packageCheckArgs;
       rCheckCmd << extraArgs;
 
+      // skip reusable phases (unless the user's own args already do)
+      if (reuseManual && extraArgs.find("--no-manual") == std::string::npos)
+         rCheckCmd << "--no-manual";
+      if (reuseVignettes &&
+          extraArgs.find("--no-vignettes") == std::string::npos)
+      {
+         rCheckCmd << "--no-vignettes";
+      }
+
       // add filename as a FilePath so it is escaped
       rCheckCmd << FilePath(pkgInfo_.sourcePackageFilename());
 
@@ -964,6 +1337,11 @@ private:
                              const core::system::ProcessOptions& pkgOptions,
                              const core::system::ProcessCallbacks& cb)
    {
+      // see which phases can be reused from the last successful check
+      bool reuseManual = false, reuseVignettes = false;
+      reusableCheckPhases(packagePath, &reuseManual, &reuseVignettes);
+      enqueReusedCheckPhases(reuseManual, reuseVignettes);
+
       // build the call to check
       std::ostringstream ostr;
       ostr << "devtools::check(";
@@ -977,27 +1355,34 @@ private:
       if (!userSettings().cleanupAfterRCmdCheck())
          args.push_back("cleanup = FALSE");
 
-      // optional extra check args
-      if (!projectConfig().packageCheckArgs.empty())
+      // optional extra check args (plus skips for reusable phases)
+      std::string checkArgs = projectConfig().packageCheckArgs;
+      if (reuseManual && checkArgs.find("--no-manual") == std::string::npos)
+         checkArgs.append(" --no-manual");
+      if (reuseVignettes &&
+          checkArgs.find("--no-vignettes") == std::string::npos)
       {
-         args.push_back("args = " +
-                        packageArgsVector(projectConfig().packageCheckArgs));
+         checkArgs.append(" --no-vignettes");
       }
+      boost::algorithm::trim(checkArgs);
+      if (!checkArgs.empty())
+         args.push_back("args = " + packageArgsVector(checkArgs));
 
       // optional extra build args
-      if (!projectConfig().packageBuildArgs.empty())
-      {
-         // propagate check vignette args
-         // add --no-manual and --no-build-vignettes if they are specified
-         std::string buildArgs = projectConfig().packageBuildArgs;
-         std::string checkArgs = projectConfig().packageCheckArgs;
-         if (checkArgs.find("--no-manual") != std::string::npos)
-            buildArgs.append(" --no-manual");
-         if (checkArgs.find("--no-build-vignettes") != std::string::npos)
-            buildArgs.append(" --no-build-vignettes");
+      std::string buildArgs = projectConfig().packageBuildArgs;
 
-         args.push_back("build_args = " + packageArgsVector(buildArgs));
+      // propagate check vignette args
+      // add --no-manual and --no-build-vignettes if they are specified
+      if (checkArgs.find("--no-manual") != std::string::npos)
+         buildArgs.append(" --no-manual");
+      if (checkArgs.find("--no-build-vignettes") != std::string::npos ||
+          reuseVignettes)
+      {
+         buildArgs.append(" --no-build-vignettes");
       }
+      boost::algorithm::trim(buildArgs);
+      if (!buildArgs.empty())
+         args.push_back("build_args = " + packageArgsVector(buildArgs));
 
       // add the args
       ostr << boost::algorithm::join(args, ", ");
@@ -1488,9 +1873,98 @@ public:
 private:
    bool onContinue()
    {
+      using namespace boost::posix_time;
+      ptime now = microsec_clock::universal_time();
+
+      // flush batched output on a short cadence so the build pane tracks
+      // the build even when no single write fills the byte budget
+      if (!pendingOutput_.empty() &&
+          (lastOutputFlush_.is_not_a_date_time() ||
+           (now - lastOutputFlush_).total_milliseconds() >=
+              kBuildOutputFlushMs))
+      {
+         flushBuildOutput(false);
+      }
+
+      // run the error parser over output which arrived since the last
+      // pass so errors and warnings appear while the build is still running
+      if (errorParser_ &&
+          output_.size() != parsedOutputSize_ &&
+          (lastErrorParse_.is_not_a_date_time() ||
+           (now - lastErrorParse_).total_milliseconds() >= kBuildErrorParseMs))
+      {
+         lastErrorParse_ = now;
+         parseNewOutput();
+      }
+
       return !terminationRequested_;
    }
 
+   bool isKnownMarker(const module_context::SourceMarker& marker)
+   {
+      BOOST_FOREACH(const module_context::SourceMarker& known,
+                    streamedErrors_)
+      {
+         if (known.type == marker.type &&
+             known.line == marker.line &&
+             known.column == marker.column &&
+             known.path == marker.path &&
+             known.message.text() == marker.message.text())
+         {
+            return true;
+         }
+      }
+      return false;
+   }
+
+   // incrementally parse diagnostics out of newly arrived output; unlike
+   // the final end-of-build parse this never rescans the whole transcript,
+   // so the cost of a pass tracks the output rate rather than the length
+   // of the build
+   void parseNewOutput()
+   {
+      // gather the output which arrived since the last pass
+      std::string newOutput;
+      for (std::size_t i = parsedOutputSize_; i < output_.size(); i++)
+         newOutput.append(output_[i].output);
+      parsedOutputSize_ = output_.size();
+
+      // parse only complete lines; anything after the final newline is
+      // held back until the rest of the line arrives
+      std::string parseText = errorParseContext_ + newOutput;
+      std::string::size_type lastNewline = parseText.find_last_of('\n');
+      if (lastNewline == std::string::npos)
+      {
+         errorParseContext_ = parseText;
+         return;
+      }
+      std::string completeLines = parseText.substr(0, lastNewline + 1);
+
+      std::vector<module_context::SourceMarker> errors =
+                                               errorParser_(completeLines);
+
+      // carry trailing context (plus the partial final line) forward
+      errorParseContext_ =
+            lastLines(completeLines, kErrorParseContextLines) +
+            parseText.substr(lastNewline + 1);
+
+      // markers found in the carried-over context were already recorded
+      BOOST_FOREACH(const module_context::SourceMarker& marker, errors)
+      {
+         if (!isKnownMarker(marker))
+            streamedErrors_.push_back(marker);
+      }
+
+      if (streamedErrors_.size() != enquedErrorCount_)
+      {
+         enquedErrorCount_ = streamedErrors_.size();
+         errorsJson_ = module_context::sourceMarkersAsJson(streamedErrors_);
+
+         // don't raise the error list while the build is running
+         enqueBuildErrors(errorsJson_, false);
+      }
+   }
+
    void outputWithFilter(const std::string& output)
    {
       // split into lines
@@ -1536,6 +2010,16 @@ private:
    {
       using namespace module_context;
 
+      // deliver any batched output (including partial trailing lines) and
+      // note how many duplicate warnings were folded along the way
+      flushBuildOutput(true);
+      if (duplicateWarningCount_ > 0)
+      {
+         boost::format fmt("(%1% duplicate warning lines not shown)\n");
+         enqueBuildOutput(kCompileOutputNormal,
+                          boost::str(fmt % duplicateWarningCount_));
+      }
+
       // call the error parser if one has been specified
       if (errorParser_)
       {
@@ -1543,7 +2027,7 @@ private:
          if (!errors.empty())
          {
             errorsJson_ = sourceMarkersAsJson(errors);
-            enqueBuildErrors(errorsJson_);
+            enqueBuildErrors(errorsJson_, openErrorList_);
          }
       }
 
@@ -1576,6 +2060,11 @@ private:
          // never restart R after a failed build
          restartR_ = false;
 
+         // after a failed install don't trust the installed package state
+         // for incremental installs
+         if (isInstallBuild_)
+            s_lastPackageInstallTime = 0;
+
          // take other actions
          if (failureFunction_)
             failureFunction_();
@@ -1585,23 +2074,120 @@ private:
          if (!successMessage_.empty())
             enqueBuildOutput(kCompileOutputNormal, successMessage_ + "\n");
 
+         // note the successful install so the next one can be
+         // incremental if only R sources change
+         if (isInstallBuild_)
+            s_lastPackageInstallTime = installStartTime_;
+
+         // note the successful check so the next one can skip phases whose
+         // inputs are unchanged (a failed check leaves the previous time in
+         // place; phases whose inputs changed since then re-run regardless)
+         if (isCheckBuild_)
+            s_lastPackageCheckTime = checkStartTime_;
+
          if (successFunction_)
             successFunction_();
       }
 
+#ifndef _WIN32
+      // release our build slot so other sessions can use the cores
+      releaseBuildJobs();
+#endif
+
       enqueBuildCompleted();
    }
 
    void enqueBuildOutput(int type, const std::string& output)
    {
-      module_context::CompileOutput compileOutput(type, output);
+      // always record the full output (it feeds the error parsers and
+      // build tab restoration)
+      output_.push_back(module_context::CompileOutput(type, output));
 
-      output_.push_back(compileOutput);
+      // batch output for delivery rather than firing an event per write;
+      // duplicate compiler warnings are folded out of the error stream
+      if (type == module_context::kCompileOutputError)
+         addPendingErrorOutput(output);
+      else
+         addPendingOutput(type, output);
 
-      ClientEvent event(client_events::kBuildOutput,
-                        compileOutputAsJson(compileOutput));
+      // flush right away for commands (they mark phase transitions) and
+      // once a full event's byte budget has accumulated
+      if (type == module_context::kCompileOutputCommand ||
+          pendingOutputBytes_ >= kBuildOutputFlushBytes)
+      {
+         flushBuildOutput(false);
+      }
+   }
 
-      module_context::enqueClientEvent(event);
+   void addPendingOutput(int type, const std::string& output)
+   {
+      if (output.empty())
+         return;
+
+      // coalesce with the previous segment when the type matches
+      if (!pendingOutput_.empty() && pendingOutput_.back().type == type)
+         pendingOutput_.back().output.append(output);
+      else
+         pendingOutput_.push_back(module_context::CompileOutput(type,
+                                                                output));
+      pendingOutputBytes_ += output.length();
+   }
+
+   void addPendingErrorOutput(const std::string& output)
+   {
+      // error output is folded line-by-line, so buffer partial lines
+      // until their newline arrives
+      errorLineBuffer_.append(output);
+      std::size_t pos;
+      while ((pos = errorLineBuffer_.find('\n')) != std::string::npos)
+      {
+         std::string line = errorLineBuffer_.substr(0, pos + 1);
+         errorLineBuffer_.erase(0, pos + 1);
+
+         if (line.find("warning:") != std::string::npos)
+         {
+            // drop warning lines we've already shown (common when the
+            // same header warns in many translation units)
+            if (!seenWarnings_.insert(line).second)
+            {
+               duplicateWarningCount_++;
+               droppingWarningBlock_ = true;
+               continue;
+            }
+            droppingWarningBlock_ = false;
+         }
+         else if (droppingWarningBlock_)
+         {
+            // indented lines following a dropped warning are its code
+            // excerpt/context -- drop those as well
+            if (line[0] == ' ' || line[0] == '\t')
+               continue;
+            droppingWarningBlock_ = false;
+         }
+
+         addPendingOutput(module_context::kCompileOutputError, line);
+      }
+   }
+
+   void flushBuildOutput(bool flushPartialLines)
+   {
+      if (flushPartialLines && !errorLineBuffer_.empty())
+      {
+         addPendingOutput(module_context::kCompileOutputError,
+                          errorLineBuffer_);
+         errorLineBuffer_.clear();
+      }
+
+      BOOST_FOREACH(const module_context::CompileOutput& compileOutput,
+                    pendingOutput_)
+      {
+         ClientEvent event(client_events::kBuildOutput,
+                           compileOutputAsJson(compileOutput));
+         module_context::enqueClientEvent(event);
+      }
+      pendingOutput_.clear();
+      pendingOutputBytes_ = 0;
+      lastOutputFlush_ = boost::posix_time::microsec_clock::universal_time();
    }
 
    void enqueCommandString(const std::string& cmd)
@@ -1610,12 +2196,12 @@ private:
                        "==> " + cmd + "\n\n");
    }
 
-   void enqueBuildErrors(const json::Array& errors)
+   void enqueBuildErrors(const json::Array& errors, bool openErrorList)
    {
       json::Object jsonData;
       jsonData["base_dir"] = errorsBaseDir_;
       jsonData["errors"] = errors;
-      jsonData["open_error_list"] = openErrorList_;
+      jsonData["open_error_list"] = openErrorList;
 
       ClientEvent event(client_events::kBuildErrors, jsonData);
       module_context::enqueClientEvent(event);
@@ -1678,6 +2264,9 @@ private:
                           buildToolsWarning_ + "\n\n");
       }
 
+      // make sure no batched output is left behind
+      flushBuildOutput(true);
+
       // enque event
       std::string afterRestartCommand;
       if (restartR_)
@@ -1736,6 +2325,22 @@ private:
    bool isRunning_;
    bool terminationRequested_;
    std::vector<module_context::CompileOutput> output_;
+
+   // output batched for delivery, plus the duplicate-warning folding and
+   // incremental error parsing state (see enqueBuildOutput/onContinue)
+   std::vector<module_context::CompileOutput> pendingOutput_;
+   std::size_t pendingOutputBytes_;
+   std::string errorLineBuffer_;
+   std::set<std::string> seenWarnings_;
+   bool droppingWarningBlock_;
+   std::size_t duplicateWarningCount_;
+   boost::posix_time::ptime lastOutputFlush_;
+   boost::posix_time::ptime lastErrorParse_;
+   std::size_t parsedOutputSize_;
+   std::size_t enquedErrorCount_;
+   std::string errorParseContext_;
+   std::vector<module_context::SourceMarker> streamedErrors_;
+
    CompileErrorParser errorParser_;
    std::string errorsBaseDir_;
    json::Array errorsJson_;
@@ -1750,6 +2355,10 @@ private:
    bool restartR_;
    bool usedDevtools_;
    bool openErrorList_;
+   bool isInstallBuild_;
+   std::time_t installStartTime_;
+   bool isCheckBuild_;
+   std::time_t checkStartTime_;
 };
 
 boost::shared_ptr<Build> s_pBuild;
@@ -32,6 +32,8 @@
 #include "RSourceIndex.hpp"
 #include "Diagnostics.hpp"
 
+#include "../SessionCompletionUsage.hpp"
+
 using namespace rstudio::core ;
 using namespace rstudio::core::libclang;
 
@@ -439,6 +441,30 @@ Error getHeaderCompletions(std::string line,
 }
 
 
+// order completions by the user's acceptance history (most used first)
+// while preserving clang's ordering among equally used symbols
+struct CompletionUsageOrder
+{
+   bool operator()(const json::Value& lhs, const json::Value& rhs) const
+   {
+      return usage(lhs) > usage(rhs);
+   }
+
+private:
+   static int usage(const json::Value& completionJson)
+   {
+      if (!json::isType<json::Object>(completionJson))
+         return 0;
+
+      const json::Object& objectJson = completionJson.get_obj();
+      json::Object::const_iterator it = objectJson.find("typed_text");
+      if (it == objectJson.end() || !json::isType<std::string>(it->second))
+         return 0;
+
+      return completion_usage::usageCount(it->second.get_str());
+   }
+};
+
 } // anonymous namespace
 
 
@@ -516,6 +542,11 @@ Error getCppCompletions(const core::json::JsonRpcRequest& request,
 
             lastTypedText = typedText;
          }
+
+         // float the user's most accepted symbols to the top
+         std::stable_sort(completionsJson.begin(),
+                          completionsJson.end(),
+                          CompletionUsageOrder());
       }
 
       json::Object resultJson;
@@ -150,16 +150,20 @@ std::string extractStdArg(const std::vector<std::string>& args)
 
 std::string buildFileHash(const FilePath& filePath)
 {
-   if (filePath.exists())
-   {
-      std::ostringstream ostr;
-      ostr << filePath.lastWriteTime();
-      return ostr.str();
-   }
-   else
+   if (!filePath.exists())
+      return std::string();
+
+   // hash the content of the file (rather than e.g. its modification
+   // time, which changes spuriously on checkout even when the derived
+   // compilation args would be identical)
+   std::string contents;
+   Error error = core::readStringFromFile(filePath, &contents);
+   if (error)
    {
+      LOG_ERROR(error);
       return std::string();
    }
+   return core::hash::crc32HexHash(contents);
 }
 
 std::string packageBuildFileHash()
@@ -173,6 +177,11 @@ std::string packageBuildFileHash()
       ostr << buildFileHash(srcPath.childPath("Makevars"));
       ostr << buildFileHash(srcPath.childPath("Makevars.win"));
    }
+
+   // the R and Rcpp versions also influence the derived args
+   ostr << module_context::rVersion();
+   ostr << module_context::packageVersion("Rcpp");
+
    return ostr.str();
 }
 
@@ -263,7 +272,8 @@ std::vector<std::string> includesForLinkingTo(const std::string& linkingTo)
 
 
 RCompilationDatabase::RCompilationDatabase()
-   : usePrecompiledHeaders_(true), restoredCompilationConfig_(false)
+   : usePrecompiledHeaders_(true), restoredCompilationConfig_(false),
+     updatingCompilationConfig_(false)
 {
 }
 
@@ -281,6 +291,11 @@ void RCompilationDatabase::updateForCurrentPackage()
    if (buildFileHash == packageBuildFileHash_)
       return;
 
+   // if a background refresh is already in flight then continue serving
+   // the current (stale but close) args until it completes
+   if (updatingCompilationConfig_)
+      return;
+
    // start with base args
    std::vector<std::string> args = baseCompilationArgs(true);
 
@@ -318,38 +333,184 @@ void RCompilationDatabase::updateForCurrentPackage()
       env.push_back(std::make_pair("USE_CXX11", "1"));
    }
 
-   // Run R CMD SHLIB
+   // Run R CMD SHLIB. if we already have a restored config then its args
+   // are very likely still close enough to work with, so serve them
+   // immediately and refresh in the background; when we have nothing at
+   // all we derive synchronously so diagnostics can work right away
    FilePath srcDir = pkgPath.childPath("src");
-   std::vector<std::string> compileArgs = compileArgsForPackage(env, srcDir);
-   if (!compileArgs.empty())
+   if (!packageCompilationConfig_.empty())
+   {
+      startRefreshForCurrentPackage(env,
+                                    args,
+                                    pkgInfo.linkingTo(),
+                                    srcDir,
+                                    buildFileHash);
+   }
+   else
+   {
+      std::vector<std::string> compileArgs = compileArgsForPackage(env,
+                                                                   srcDir);
+      setPackageCompilationConfig(args,
+                                  compileArgs,
+                                  pkgInfo.linkingTo(),
+                                  srcDir,
+                                  buildFileHash);
+   }
+}
+
+void RCompilationDatabase::setPackageCompilationConfig(
+                                 std::vector<std::string> args,
+                                 const std::vector<std::string>& compileArgs,
+                                 const std::string& linkingTo,
+                                 const core::FilePath& srcDir,
+                                 const std::string& buildFileHash)
+{
+   if (compileArgs.empty())
+      return;
+
+   // do path substitutions
+   BOOST_FOREACH(std::string arg, compileArgs)
    {
       // do path substitutions
-      BOOST_FOREACH(std::string arg, compileArgs)
+      boost::algorithm::replace_first(
+               arg,
+               "-I..",
+               "-I" + srcDir.parent().absolutePath());
+      boost::algorithm::replace_first(
+               arg,
+               "-I.",
+               "-I" + srcDir.absolutePath());
+
+      args.push_back(arg);
+   }
+
+   // set the args and build file hash (to avoid recomputation)
+   packageCompilationConfig_.args = args;
+   packageCompilationConfig_.PCH = packagePCH(linkingTo);
+   packageCompilationConfig_.isCpp = packageIsCpp(linkingTo, srcDir);
+   packageBuildFileHash_ = buildFileHash;
+
+   // save them to disk
+   savePackageCompilationConfig();
+}
+
+void RCompilationDatabase::startRefreshForCurrentPackage(
+                                 const core::system::Options& env,
+                                 const std::vector<std::string>& args,
+                                 const std::string& linkingTo,
+                                 const core::FilePath& srcDir,
+                                 const std::string& buildFileHash)
+{
+   // create a temp dir to call R CMD SHLIB within (perform the same
+   // setup as compileArgsForPackage)
+   FilePath tempDir = module_context::tempFile(kCompilationDbPrefix, "dir");
+   Error error = tempDir.ensureDirectory();
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   // copy Makevars to tempdir if it exists
+   FilePath makevarsPath = srcDir.childPath("Makevars");
+   if (makevarsPath.exists())
+   {
+      error = makevarsPath.copy(tempDir.childPath("Makevars"));
+      if (error)
       {
-         // do path substitutions
-         boost::algorithm::replace_first(
-                  arg,
-                  "-I..",
-                  "-I" + srcDir.parent().absolutePath());
-         boost::algorithm::replace_first(
-                  arg,
-                  "-I.",
-                  "-I" + srcDir.absolutePath());
-
-         args.push_back(arg);
+         LOG_ERROR(error);
+         return;
       }
+   }
 
-      // set the args and build file hash (to avoid recomputation)
-      packageCompilationConfig_.args = args;
-      packageCompilationConfig_.PCH = packagePCH(pkgInfo.linkingTo());
-      packageCompilationConfig_.isCpp = packageIsCpp(pkgInfo.linkingTo(),
-                                                     srcDir);
-      packageBuildFileHash_ = buildFileHash;
+   FilePath makevarsWinPath = srcDir.childPath("Makevars.win");
+   if (makevarsWinPath.exists())
+   {
+      error = makevarsWinPath.copy(tempDir.childPath("Makevars.win"));
+      if (error)
+      {
+         LOG_ERROR(error);
+         return;
+      }
+   }
 
-      // save them to disk
-      savePackageCompilationConfig();
+   // write a stub source file to compile
+   FilePath tempSrcFile = tempDir.childPath(
+          kCompilationDbPrefix + core::system::generateUuid() + ".cpp");
+   error = core::writeStringToFile(tempSrcFile, "void foo() {}\n");
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
    }
 
+   // get R bin directory
+   FilePath rBinDir;
+   error = module_context::rBinDir(&rBinDir);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   // build the dry-run command
+   module_context::RCommand rCmd(rBinDir);
+   rCmd << "SHLIB";
+   rCmd << "--dry-run";
+   rCmd << tempSrcFile.filename();
+
+   core::system::ProcessOptions options;
+   options.workingDir = tempDir;
+   options.environment = env;
+
+   // run it in the background -- until it completes we continue to serve
+   // the previously derived args
+   updatingCompilationConfig_ = true;
+   error = module_context::processSupervisor().runCommand(
+            rCmd.shellCommand(),
+            options,
+            boost::bind(&RCompilationDatabase::onRefreshForCurrentPackage,
+                        this,
+                        tempDir,
+                        args,
+                        linkingTo,
+                        srcDir,
+                        buildFileHash,
+                        _1));
+   if (error)
+   {
+      LOG_ERROR(error);
+      updatingCompilationConfig_ = false;
+   }
+}
+
+void RCompilationDatabase::onRefreshForCurrentPackage(
+                                 const core::FilePath& tempDir,
+                                 const std::vector<std::string>& args,
+                                 const std::string& linkingTo,
+                                 const core::FilePath& srcDir,
+                                 const std::string& buildFileHash,
+                                 const core::system::ProcessResult& result)
+{
+   updatingCompilationConfig_ = false;
+
+   // remove the tempDir
+   Error error = tempDir.remove();
+   if (error)
+      LOG_ERROR(error);
+
+   // process the results of R CMD SHLIB
+   if (result.exitStatus != EXIT_SUCCESS)
+   {
+      LOG_ERROR_MESSAGE("Error performing R CMD SHLIB: " + result.stdErr);
+      return;
+   }
+
+   setPackageCompilationConfig(args,
+                               parseCompilationResults(result.stdOut),
+                               linkingTo,
+                               srcDir,
+                               buildFileHash);
 }
 
 std::vector<std::string> RCompilationDatabase::compileArgsForPackage(
@@ -666,6 +827,10 @@ std::vector<std::string> RCompilationDatabase::projectTranslationUnits() const
       options.filter =
             boost::bind(translationUnitFilter, _1, srcDirPath, includePath);
 
+      // scan subtrees in parallel (package trees can be large and are
+      // often on network filesystems; the filter is thread-safe)
+      options.concurrentScanners = 4;
+
       // scan the files
       tree<FileInfo> files;
       Error error = scanFiles(FileInfo(pkgPath), options, &files);
@@ -67,6 +67,29 @@ private:
                                      const core::system::Options& env,
                                      const core::FilePath& pkgPath);
 
+   void setPackageCompilationConfig(
+                                 std::vector<std::string> args,
+                                 const std::vector<std::string>& compileArgs,
+                                 const std::string& linkingTo,
+                                 const core::FilePath& srcDir,
+                                 const std::string& buildFileHash);
+
+   // refresh the package compilation config in the background (we continue
+   // to serve the previously derived args while the refresh is running)
+   void startRefreshForCurrentPackage(
+                                 const core::system::Options& env,
+                                 const std::vector<std::string>& args,
+                                 const std::string& linkingTo,
+                                 const core::FilePath& srcDir,
+                                 const std::string& buildFileHash);
+   void onRefreshForCurrentPackage(
+                                 const core::FilePath& tempDir,
+                                 const std::vector<std::string>& args,
+                                 const std::string& linkingTo,
+                                 const core::FilePath& srcDir,
+                                 const std::string& buildFileHash,
+                                 const core::system::ProcessResult& result);
+
 
    void savePackageCompilationConfig();
    void restorePackageCompilationConfig();
@@ -113,6 +136,7 @@ private:
    CompilationConfig packageCompilationConfig_;
    bool usePrecompiledHeaders_;
    bool restoredCompilationConfig_;
+   bool updatingCompilationConfig_;
 };
 
 core::libclang::CompilationDatabase rCompilationDatabase();
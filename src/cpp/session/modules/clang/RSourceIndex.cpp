@@ -21,6 +21,8 @@
 #include <core/FileInfo.hpp>
 #include <core/FilePath.hpp>
 
+#include <r/ROptions.hpp>
+
 #include <session/SessionUserSettings.hpp>
 
 #include <core/libclang/LibClang.hpp>
@@ -37,12 +39,19 @@ namespace clang {
 
 namespace {
 
+// default cap on aggregate libclang translation unit memory
+const int kDefaultMemoryLimitMb = 1024;
+
 class RSourceIndex : public SourceIndex
 {
 public:
    RSourceIndex()
       : SourceIndex(rCompilationDatabase(), userSettings().clangVerbose())
    {
+      setMemoryLimitMb(r::options::getOption<int>(
+                          "rstudio.libclangMemoryLimitMb",
+                          kDefaultMemoryLimitMb,
+                          false));
    }
 };
 
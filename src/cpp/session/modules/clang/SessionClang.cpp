@@ -110,9 +110,13 @@ void onSourceDocUpdated(boost::shared_ptr<source_database::SourceDocument> pDoc)
    if (!SourceIndex::isSourceFile(filename))
       return;
 
-   // update unsaved files
+   // update unsaved files -- share the document's contents buffer
+   // directly (the aliasing shared_ptr keeps the document alive for as
+   // long as libclang can reference the buffer) rather than copying the
+   // full text on every keystroke
+   boost::shared_ptr<const std::string> pContents(pDoc, &pDoc->contents());
    rSourceIndex().unsavedFiles().update(filename,
-                                        pDoc->contents(),
+                                        pContents,
                                         pDoc->dirty());
 
    // dirty files indicate active user editing, prime if necessary
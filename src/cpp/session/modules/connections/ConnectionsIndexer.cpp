@@ -206,6 +206,44 @@ void updateConnectionsRegistry(boost::shared_ptr<ConnectionsRegistry> pRegistry)
    s_pCurrentConnectionsRegistry = pRegistry;
 }
 
+// Catalog cache
+// -------------
+//
+// Discovering connection types means scanning every installed package for
+// an extension file, which makes the first Connections pane open of a
+// session sluggish on large libraries. We persist the discovered catalog
+// to disk keyed by the library state hash; when a session starts against
+// an unchanged library the catalog is served from the cache immediately
+// while the package indexer re-discovers it in the background (and
+// rewrites the cache when it completes).
+
+const char * const kConnectionsCatalogFormat = "connections-catalog-v1";
+
+FilePath connectionsCatalogCachePath()
+{
+   return module_context::userScratchPath().complete("connections-catalog");
+}
+
+void saveConnectionsCatalogCache(const json::Object& registryJson)
+{
+   // the cache holds the format line, the library state hash the catalog
+   // was discovered against, and the catalog itself as JSON
+   std::ostringstream ostr;
+   ostr << kConnectionsCatalogFormat << "\n"
+        << module_context::libraryStateHash(module_context::getLibPaths())
+        << "\n"
+        << json::write(registryJson);
+
+   // write to a temporary file and move it into place
+   FilePath cachePath = connectionsCatalogCachePath();
+   FilePath tempPath(cachePath.absolutePath() + ".tmp");
+   Error error = core::writeStringToFile(tempPath, ostr.str());
+   if (!error)
+      error = tempPath.move(cachePath);
+   if (error)
+      LOG_ERROR(error);
+}
+
 class ConnectionsWorker : public ppe::Worker
 {
    void onIndexingStarted()
@@ -247,6 +285,10 @@ class ConnectionsWorker : public ppe::Worker
       // provide registry as json
       (*pPayload)["connections_registry"] = registryJson;
 
+      // persist the discovered catalog so the next session can serve it
+      // without waiting for indexing
+      saveConnectionsCatalogCache(registryJson);
+
       // reset
       continuations_.clear();
       pRegistry_.reset();
@@ -279,6 +321,70 @@ core::json::Value connectionsRegistryAsJson()
    return connectionsRegistry().toJson();
 }
 
+void loadConnectionsCatalogCache()
+{
+   FilePath cachePath = connectionsCatalogCachePath();
+   if (!cachePath.exists())
+      return;
+
+   std::string contents;
+   Error error = core::readStringFromFile(cachePath, &contents);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   // validate the format line
+   std::string::size_type formatEnd = contents.find('\n');
+   if (formatEnd == std::string::npos ||
+       contents.substr(0, formatEnd) != kConnectionsCatalogFormat)
+      return;
+
+   // a stale hash means the library changed since the catalog was
+   // discovered; wait for the indexer rather than show stale types
+   std::string::size_type hashEnd = contents.find('\n', formatEnd + 1);
+   if (hashEnd == std::string::npos)
+      return;
+   std::string hash = contents.substr(formatEnd + 1, hashEnd - formatEnd - 1);
+   if (hash != module_context::libraryStateHash(module_context::getLibPaths()))
+      return;
+
+   json::Value catalogValue;
+   if (!json::parse(contents.substr(hashEnd + 1), &catalogValue) ||
+       !json::isType<json::Object>(catalogValue))
+      return;
+
+   boost::shared_ptr<ConnectionsRegistry> pRegistry =
+         boost::make_shared<ConnectionsRegistry>();
+   const json::Object& catalogJson = catalogValue.get_obj();
+   for (json::Object::const_iterator it = catalogJson.begin();
+        it != catalogJson.end();
+        ++it)
+   {
+      if (!json::isType<json::Object>(it->second))
+         continue;
+
+      std::string name, package, shinyapp, help, icon;
+      error = json::readObject(it->second.get_obj(),
+                               "name", &name,
+                               "package", &package,
+                               "shinyapp", &shinyapp,
+                               "help", &help,
+                               "icon", &icon);
+      if (error)
+      {
+         LOG_ERROR(error);
+         continue;
+      }
+
+      pRegistry->add(package,
+                     ConnectionsIndexEntry(name, package, shinyapp, help, icon));
+   }
+
+   updateConnectionsRegistry(pRegistry);
+}
+
 void registerConnectionsRegistryEntry(std::string packageName, std::string extensionPath)
 {
    FilePath extensionFilePath(extensionPath);
@@ -24,6 +24,7 @@ namespace modules {
 namespace connections {
 
 core::json::Value connectionsRegistryAsJson();
+void loadConnectionsCatalogCache();
 void registerConnectionsWorker();
 void registerConnectionsRegistryEntry(std::string packageName, std::string extensionPath);
                        
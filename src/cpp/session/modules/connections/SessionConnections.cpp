@@ -498,6 +498,11 @@ void onInstalledPackagesChanged()
 
 void onDeferredInit(bool newSession)
 {
+   // populate the connections catalog from the on-disk cache (if it's
+   // still valid for the current library) so the pane can open without
+   // waiting for package indexing
+   loadConnectionsCatalogCache();
+
    if (!newSession && connectionsEnabled())
    {
       activeConnections().broadcastToClient();
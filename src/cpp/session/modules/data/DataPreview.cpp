@@ -0,0 +1,544 @@
+/*
+ * DataPreview.cpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "DataPreview.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <core/Error.hpp>
+#include <core/Exec.hpp>
+#include <core/FilePath.hpp>
+#include <core/SafeConvert.hpp>
+#include <core/json/JsonRpc.hpp>
+#include <core/system/MemoryMappedFile.hpp>
+#include <core/text/DelimitedReader.hpp>
+
+#include <session/SessionModuleContext.hpp>
+
+// bounds on the work performed for a preview: we parse at most
+// kMaxPreviewRows rows into the grid, sample at most kTypeSampleRows
+// additional rows for type inference, and scan at most kMaxScanBytes of
+// the file (in parallel chunks) for encoding validation and row count
+// estimation -- so the cost of a preview is fixed regardless of the size
+// of the input file
+#define kDefaultPreviewRows   50
+#define kMaxPreviewRows       1000
+#define kTypeSampleRows       500
+#define kScanChunkBytes       (8 * 1024 * 1024)
+#define kMaxScanBytes         (64 * 1024 * 1024)
+#define kDelimiterProbeBytes  (1024 * 1024)
+#define kDelimiterProbeLines  100
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace data {
+namespace preview {
+
+namespace {
+
+// per-chunk statistics produced by the parallel scan
+struct ChunkStats
+{
+   ChunkStats() : newlines(0), validUtf8(true), ascii(true) {}
+   std::size_t newlines;
+   bool validUtf8;
+   bool ascii;
+};
+
+// scan one chunk of the mapped file: count newlines and check that the
+// bytes form ASCII or well-formed UTF-8. multi-byte sequences split
+// across chunk boundaries are tolerated (leading continuation bytes are
+// skipped and a sequence truncated by the end of the chunk is accepted)
+Error scanChunk(const char* pData, std::size_t size, ChunkStats* pStats)
+{
+   const unsigned char* p = reinterpret_cast<const unsigned char*>(pData);
+   const unsigned char* end = p + size;
+
+   // skip continuation bytes belonging to the previous chunk
+   while (p != end && (*p & 0xC0) == 0x80)
+      ++p;
+
+   while (p != end)
+   {
+      unsigned char c = *p;
+      if (c == '\n')
+      {
+         pStats->newlines++;
+         ++p;
+      }
+      else if (c < 0x80)
+      {
+         ++p;
+      }
+      else
+      {
+         pStats->ascii = false;
+
+         // determine the expected number of continuation bytes
+         std::size_t continuations;
+         if ((c & 0xE0) == 0xC0)
+            continuations = 1;
+         else if ((c & 0xF0) == 0xE0)
+            continuations = 2;
+         else if ((c & 0xF8) == 0xF0)
+            continuations = 3;
+         else
+         {
+            pStats->validUtf8 = false;
+            ++p;
+            continue;
+         }
+
+         ++p;
+         while (continuations > 0 && p != end && (*p & 0xC0) == 0x80)
+         {
+            ++p;
+            continuations--;
+         }
+
+         // an incomplete sequence is malformed unless it was cut off by
+         // the end of the chunk
+         if (continuations > 0 && p != end)
+            pStats->validUtf8 = false;
+      }
+   }
+
+   return Success();
+}
+
+bool isBlankRecord(const std::vector<std::string>& fields)
+{
+   return fields.size() == 1 && fields[0].empty();
+}
+
+// pick the candidate delimiter which splits the first lines of the file
+// into the most consistent field counts
+char detectDelimiter(const char* pData, std::size_t size)
+{
+   static const char kCandidates[] = { ',', '\t', ';', '|' };
+
+   std::size_t probeSize = std::min(
+            size, static_cast<std::size_t>(kDelimiterProbeBytes));
+
+   char best = ',';
+   double bestScore = 0.0;
+   for (std::size_t c = 0; c < sizeof(kCandidates); c++)
+   {
+      char candidate = kCandidates[c];
+
+      // compute the field count of each probed line
+      std::map<std::size_t, int> counts;
+      std::size_t pos = 0;
+      int lines = 0;
+      std::vector<std::string> fields;
+      while (lines < kDelimiterProbeLines &&
+             text::parseDelimitedRecord(pData, probeSize, &pos, candidate, &fields))
+      {
+         if (isBlankRecord(fields))
+            continue;
+         counts[fields.size()]++;
+         lines++;
+      }
+
+      if (lines == 0)
+         continue;
+
+      // find the modal field count
+      std::size_t modalFields = 0;
+      int modalLines = 0;
+      for (std::map<std::size_t, int>::const_iterator it = counts.begin();
+           it != counts.end();
+           ++it)
+      {
+         if (it->second > modalLines)
+         {
+            modalLines = it->second;
+            modalFields = it->first;
+         }
+      }
+
+      // a delimiter which never splits a line tells us nothing
+      if (modalFields < 2)
+         continue;
+
+      // score by the fraction of lines agreeing with the modal count;
+      // ties go to the earlier (more common) candidate
+      double score = static_cast<double>(modalLines) / lines;
+      if (score > bestScore)
+      {
+         bestScore = score;
+         best = candidate;
+      }
+   }
+
+   return best;
+}
+
+// column types inferred from sampled values, ordered so that merging two
+// observations can only widen the type
+enum ColumnType
+{
+   TypeUnknown   = 0,
+   TypeLogical   = 1,
+   TypeInteger   = 2,
+   TypeDouble    = 3,
+   TypeDate      = 4,
+   TypeCharacter = 5
+};
+
+ColumnType classifyValue(const std::string& value)
+{
+   if (value.empty() || value == "NA")
+      return TypeUnknown;
+
+   if (value == "TRUE" || value == "FALSE" || value == "T" || value == "F" ||
+       value == "true" || value == "false")
+      return TypeLogical;
+
+   // date (ISO format)
+   if (value.size() == 10 && value[4] == '-' && value[7] == '-')
+   {
+      bool date = true;
+      for (std::size_t i = 0; i < value.size(); i++)
+      {
+         if (i == 4 || i == 7)
+            continue;
+         if (value[i] < '0' || value[i] > '9')
+         {
+            date = false;
+            break;
+         }
+      }
+      if (date)
+         return TypeDate;
+   }
+
+   // numeric: integer if strtol consumes the whole value, numeric if
+   // strtod does
+   const char* pBegin = value.c_str();
+   char* pEnd = NULL;
+   errno = 0;
+   ::strtol(pBegin, &pEnd, 10);
+   if (errno == 0 && pEnd == pBegin + value.size())
+      return TypeInteger;
+   errno = 0;
+   ::strtod(pBegin, &pEnd);
+   if (errno == 0 && pEnd == pBegin + value.size())
+      return TypeDouble;
+
+   return TypeCharacter;
+}
+
+ColumnType mergeColumnType(ColumnType a, ColumnType b)
+{
+   if (a == TypeUnknown)
+      return b;
+   if (b == TypeUnknown || a == b)
+      return a;
+
+   // integers widen to doubles; any other disagreement is character
+   if ((a == TypeInteger && b == TypeDouble) ||
+       (a == TypeDouble && b == TypeInteger))
+      return TypeDouble;
+
+   return TypeCharacter;
+}
+
+const char* columnTypeName(ColumnType type)
+{
+   switch (type)
+   {
+      case TypeLogical:
+         return "logical";
+      case TypeInteger:
+         return "integer";
+      case TypeDouble:
+         return "numeric";
+      case TypeDate:
+         return "date";
+      case TypeUnknown:
+      case TypeCharacter:
+      default:
+         return "character";
+   }
+}
+
+// vote the values of a record into the per-column type accumulator
+void voteColumnTypes(const std::vector<std::string>& fields,
+                     std::vector<ColumnType>* pTypes)
+{
+   std::size_t n = std::min(fields.size(), pTypes->size());
+   for (std::size_t i = 0; i < n; i++)
+      (*pTypes)[i] = mergeColumnType((*pTypes)[i], classifyValue(fields[i]));
+}
+
+Error previewDataImportNative(const json::JsonRpcRequest& request,
+                              json::JsonRpcResponse* pResponse)
+{
+   std::string path, delimiter;
+   int maxRows;
+   Error error = json::readParams(request.params, &path, &delimiter, &maxRows);
+   if (error)
+      return error;
+
+   json::Object result;
+   error = previewDelimitedFile(module_context::resolveAliasedPath(path),
+                                delimiter,
+                                maxRows,
+                                &result);
+   if (error)
+      return error;
+
+   pResponse->setResult(result);
+   return Success();
+}
+
+} // anonymous namespace
+
+
+Error previewDelimitedFile(const FilePath& filePath,
+                           const std::string& delimiter,
+                           int maxRows,
+                           json::Object* pResult)
+{
+   // map the file (no reads or copies proportional to file size occur
+   // anywhere below)
+   system::MemoryMappedFile mappedFile;
+   Error error = mappedFile.open(filePath);
+   if (error)
+      return error;
+
+   const char* pData = static_cast<const char*>(mappedFile.data());
+   std::size_t size = mappedFile.size();
+
+   // reject encodings the native parser doesn't speak so the caller can
+   // fall back to the R-based preview
+   if (size >= 2)
+   {
+      unsigned char b0 = static_cast<unsigned char>(pData[0]);
+      unsigned char b1 = static_cast<unsigned char>(pData[1]);
+      if ((b0 == 0xFF && b1 == 0xFE) || (b0 == 0xFE && b1 == 0xFF))
+      {
+         return systemError(boost::system::errc::not_supported,
+                            "UTF-16 encoded input",
+                            ERROR_LOCATION);
+      }
+   }
+
+   // skip a UTF-8 byte order mark if present
+   bool hasBom = size >= 3 && ::memcmp(pData, "\xEF\xBB\xBF", 3) == 0;
+   if (hasBom)
+   {
+      pData += 3;
+      size -= 3;
+   }
+
+   if (size == 0)
+   {
+      (*pResult)["columns"] = json::Array();
+      (*pResult)["data"] = json::Array();
+      (*pResult)["delimiter"] = delimiter.empty() ? "," : delimiter;
+      (*pResult)["encoding"] = "ASCII";
+      (*pResult)["has_header"] = false;
+      (*pResult)["preview_rows"] = 0;
+      (*pResult)["total_rows_estimate"] = 0.0;
+      (*pResult)["complete"] = true;
+      return Success();
+   }
+
+   // scan the file in parallel chunks for encoding validation and row
+   // count estimation; each chunk writes into its own slot of the stats
+   // vector so no synchronization is required
+   std::size_t scanBytes = std::min(
+            size, static_cast<std::size_t>(kMaxScanBytes));
+   std::size_t numChunks =
+         (scanBytes + kScanChunkBytes - 1) / kScanChunkBytes;
+   std::vector<ChunkStats> chunkStats(numChunks);
+   ParallelExecBlock scanBlock;
+   for (std::size_t i = 0; i < numChunks; i++)
+   {
+      std::size_t offset = i * static_cast<std::size_t>(kScanChunkBytes);
+      std::size_t length = std::min(
+               static_cast<std::size_t>(kScanChunkBytes), scanBytes - offset);
+      scanBlock.addConcurrent(
+               "chunk " + safe_convert::numberToString(i),
+               boost::bind(scanChunk, pData + offset, length, &chunkStats[i]));
+   }
+   error = scanBlock.execute();
+   if (error)
+      return error;
+
+   std::size_t newlines = 0;
+   bool ascii = !hasBom;
+   bool validUtf8 = true;
+   BOOST_FOREACH(const ChunkStats& stats, chunkStats)
+   {
+      newlines += stats.newlines;
+      ascii = ascii && stats.ascii;
+      validUtf8 = validUtf8 && stats.validUtf8;
+   }
+   std::string encoding = ascii ? "ASCII" :
+                          validUtf8 ? "UTF-8" :
+                                      "ISO-8859-1";
+
+   // estimate the number of rows, extrapolating when we scanned only a
+   // prefix of the file
+   double totalRows = static_cast<double>(newlines);
+   if (scanBytes < size)
+      totalRows = totalRows * (static_cast<double>(size) / scanBytes);
+
+   // detect the delimiter if the caller didn't supply one
+   char delim = delimiter.empty() ? detectDelimiter(pData, size)
+                                  : delimiter[0];
+
+   if (maxRows < 1)
+      maxRows = kDefaultPreviewRows;
+   maxRows = std::min(maxRows, static_cast<int>(kMaxPreviewRows));
+
+   // read the first record; treat it as a header row when none of its
+   // values look like data (all non-empty and non-numeric)
+   std::size_t pos = 0;
+   std::vector<std::string> firstRecord;
+   while (text::parseDelimitedRecord(pData, size, &pos, delim, &firstRecord) &&
+          isBlankRecord(firstRecord))
+   {
+   }
+
+   bool hasHeader = !firstRecord.empty();
+   BOOST_FOREACH(const std::string& field, firstRecord)
+   {
+      ColumnType type = classifyValue(field);
+      if (type != TypeCharacter && type != TypeDate)
+      {
+         hasHeader = false;
+         break;
+      }
+   }
+
+   std::size_t numColumns = firstRecord.size();
+   std::vector<std::string> names(numColumns);
+   for (std::size_t i = 0; i < numColumns; i++)
+   {
+      names[i] = hasHeader ? firstRecord[i]
+                           : "V" + safe_convert::numberToString(i + 1);
+   }
+
+   // parse the preview rows, voting each value into the column types
+   std::vector<ColumnType> types(numColumns, TypeUnknown);
+   json::Array data;
+   if (!hasHeader && !isBlankRecord(firstRecord))
+   {
+      voteColumnTypes(firstRecord, &types);
+      json::Array row;
+      BOOST_FOREACH(const std::string& field, firstRecord)
+         row.push_back(field);
+      data.push_back(row);
+   }
+
+   std::vector<std::string> fields;
+   while (data.size() < static_cast<std::size_t>(maxRows) &&
+          text::parseDelimitedRecord(pData, size, &pos, delim, &fields))
+   {
+      if (isBlankRecord(fields))
+         continue;
+
+      voteColumnTypes(fields, &types);
+
+      json::Array row;
+      for (std::size_t i = 0; i < numColumns; i++)
+         row.push_back(i < fields.size() ? fields[i] : std::string());
+      data.push_back(row);
+   }
+
+   bool complete = pos >= size;
+
+   // sample rows spread through the remainder of the file so inferred
+   // types reflect the whole file, not just its first rows. a sampled
+   // offset can land inside a quoted field; records parsed there come
+   // out with the wrong field count and are simply ignored
+   if (!complete && numColumns > 0)
+   {
+      std::size_t stride = (size - pos) / (kTypeSampleRows + 1);
+      if (stride > 0)
+      {
+         for (int i = 1; i <= kTypeSampleRows; i++)
+         {
+            std::size_t samplePos = pos + (stride * i);
+            if (samplePos >= size)
+               break;
+
+            // advance to the start of the next line
+            while (samplePos < size && pData[samplePos] != '\n')
+               samplePos++;
+            samplePos++;
+
+            if (!text::parseDelimitedRecord(pData, size, &samplePos, delim, &fields))
+               continue;
+            if (fields.size() == numColumns)
+               voteColumnTypes(fields, &types);
+         }
+      }
+   }
+
+   json::Array columns;
+   for (std::size_t i = 0; i < numColumns; i++)
+   {
+      json::Object column;
+      column["name"] = names[i];
+      column["type"] = columnTypeName(types[i]);
+      columns.push_back(column);
+   }
+
+   if (hasHeader && totalRows > 0)
+      totalRows -= 1;
+
+   (*pResult)["columns"] = columns;
+   (*pResult)["data"] = data;
+   (*pResult)["delimiter"] = std::string(1, delim);
+   (*pResult)["encoding"] = encoding;
+   (*pResult)["has_header"] = hasHeader;
+   (*pResult)["preview_rows"] = static_cast<int>(data.size());
+   (*pResult)["total_rows_estimate"] = totalRows;
+   (*pResult)["complete"] = complete;
+
+   return Success();
+}
+
+Error initialize()
+{
+   using boost::bind;
+   using namespace session::module_context;
+   ExecBlock initBlock;
+   initBlock.addFunctions()
+      (bind(registerRpcMethod, "preview_data_import_native",
+            previewDataImportNative));
+   return initBlock.execute();
+}
+
+} // namespace preview
+} // namespace data
+} // namespace modules
+} // namespace session
+} // namespace rstudio
@@ -0,0 +1,54 @@
+/*
+ * DataPreview.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SESSION_DATA_PREVIEW_HPP
+#define SESSION_DATA_PREVIEW_HPP
+
+#include <string>
+
+#include <core/json/Json.hpp>
+
+namespace rstudio {
+namespace core {
+   class Error;
+   class FilePath;
+}
+}
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace data {
+namespace preview {
+
+// native (no R) preview of a delimited text file: memory maps the input,
+// detects encoding and delimiter, parses the first rows for the preview
+// grid, and infers column types from rows sampled throughout the file.
+// returns an error for files the native engine can't handle (e.g. UTF-16
+// encoded input) so callers can fall back to the R-based preview
+core::Error previewDelimitedFile(const core::FilePath& filePath,
+                                 const std::string& delimiter,
+                                 int maxRows,
+                                 core::json::Object* pResult);
+
+core::Error initialize();
+
+} // namespace preview
+} // namespace data
+} // namespace modules
+} // namespace session
+} // namespace rstudio
+
+#endif // SESSION_DATA_PREVIEW_HPP
@@ -15,11 +15,16 @@
 
 #include "DataViewer.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <limits>
 #include <string>
 #include <vector>
 #include <sstream>
 
 #include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
 #include <boost/algorithm/string/predicate.hpp>
@@ -126,7 +131,14 @@ namespace {
  *    This allows us to efficiently perform operations on very large datasets
  *    once they've been winnowed down to smaller objects using searches and
  *    filters.
- */    
+ *
+ * NATIVE:
+ *    Once the user sorts or filters, we additionally snapshot the viewed
+ *    columns into typed C++ arrays (see 'Native columnar engine' below);
+ *    subsequent grid requests for that object are served entirely from the
+ *    snapshot, so the working copy machinery only comes into play for frames
+ *    whose column types the native engine can't represent.
+ */
 
 // indicates whether one filter string is a subset of another; e.g. if a column
 // is filtered for "abc" and then "abcd", the new state is a subset of the
@@ -224,6 +236,667 @@ int safeDim(SEXP data, DimType dimType)
    return 0;
 }
 
+/*
+ * Native columnar engine
+ * ----------------------
+ *
+ * Sorting and filtering through .rs.applyTransform copies the frame and
+ * occupies the R interpreter for the duration, so every page of a large
+ * sorted frame competes with the console for the R thread. Once the user
+ * starts transforming a frame we snapshot the viewed columns into typed C++
+ * arrays and serve subsequent page/sort/filter/search requests directly from
+ * the snapshot, without touching R. Frames containing column types we can't
+ * snapshot (e.g. list columns) fall back to the R path above.
+ *
+ * Columns are materialized into the snapshot lazily: creating the snapshot
+ * only records the frame's shape, and an individual column's cells are
+ * copied out of the cached SEXP the first time the column is sorted on,
+ * filtered, or displayed. Very wide frames (tens of thousands of columns)
+ * therefore pay only for the columns actually scrolled into view.
+ */
+
+struct NativeColumn
+{
+   enum Type
+   {
+      COL_NUMERIC,
+      COL_INTEGER,
+      COL_BOOLEAN,
+      COL_FACTOR,
+      COL_CHARACTER
+   };
+
+   NativeColumn() : type(COL_NUMERIC), materialized(false),
+                    sortedValueCount(0) {}
+
+   Type type;
+
+   // whether the column's cells have been copied out of the source SEXP
+   // yet (see materializeColumn)
+   bool materialized;
+
+   // cell storage -- 'values' holds numbers, logicals, and factor codes;
+   // 'text' holds character cells; 'missing' flags NA cells
+   std::vector<double> values;
+   std::vector<std::string> text;
+   std::vector<std::string> levels;
+   std::vector<bool> missing;
+
+   // lazily built ascending permutation of the rows by this column (empty
+   // until the column is first sorted on)
+   std::vector<int> ascendingOrder;
+
+   // number of leading entries in ascendingOrder which hold comparable
+   // values; the remainder are NA/NaN and stay last in either direction,
+   // as R's order() places them
+   int sortedValueCount;
+};
+
+struct NativeFrame
+{
+   NativeFrame() : nrow(0), hasRowNames(false) {}
+
+   int nrow;
+   std::vector<NativeColumn> columns;
+
+   // character row names (empty when the frame uses automatic row numbers,
+   // which we emit as row index + 1)
+   bool hasRowNames;
+   std::vector<std::string> rowNames;
+};
+
+// formats a (non-missing) cell for display; mirrors .rs.formatDataColumn,
+// which formats numeric values to 7 significant digits and renders
+// everything else via as.character
+std::string nativeCellText(const NativeColumn& column, int row)
+{
+   char buffer[64];
+   switch (column.type)
+   {
+      case NativeColumn::COL_CHARACTER:
+         return column.text[row];
+      case NativeColumn::COL_FACTOR:
+      {
+         int code = static_cast<int>(column.values[row]);
+         if (code >= 1 && code <= static_cast<int>(column.levels.size()))
+            return column.levels[code - 1];
+         return std::string();
+      }
+      case NativeColumn::COL_BOOLEAN:
+         return column.values[row] != 0 ? "TRUE" : "FALSE";
+      case NativeColumn::COL_INTEGER:
+         ::snprintf(buffer, sizeof(buffer), "%.0f", column.values[row]);
+         return std::string(buffer);
+      case NativeColumn::COL_NUMERIC:
+      default:
+      {
+         double value = column.values[row];
+         if (value != value)
+            return "NaN";
+         else if (value > std::numeric_limits<double>::max())
+            return "Inf";
+         else if (value < -std::numeric_limits<double>::max())
+            return "-Inf";
+         ::snprintf(buffer, sizeof(buffer), "%.7g", value);
+         return std::string(buffer);
+      }
+   }
+}
+
+// case-insensitive substring test (mirrors the fixed, ignore.case grepl
+// used by .rs.applyTransform); the term must already be lowercased
+bool containsCaseInsensitive(const std::string& text,
+                             const std::string& lowerTerm)
+{
+   if (lowerTerm.empty())
+      return true;
+   if (text.length() < lowerTerm.length())
+      return false;
+   for (size_t i = 0; i + lowerTerm.length() <= text.length(); i++)
+   {
+      size_t match = 0;
+      while (match < lowerTerm.length() &&
+             ::tolower(static_cast<unsigned char>(text[i + match])) ==
+                static_cast<unsigned char>(lowerTerm[match]))
+         match++;
+      if (match == lowerTerm.length())
+         return true;
+   }
+   return false;
+}
+
+// compares two rows by a single column when building the ascending
+// permutation; NA/NaN rows are excluded beforehand so the comparison
+// never sees them. character columns compare case-insensitively as an
+// approximation of the locale collation used by R's order()
+struct NativeColumnLess
+{
+   explicit NativeColumnLess(const NativeColumn& column) : column_(column) {}
+
+   bool operator()(int lhs, int rhs) const
+   {
+      if (column_.type == NativeColumn::COL_CHARACTER)
+      {
+         const std::string& lhsText = column_.text[lhs];
+         const std::string& rhsText = column_.text[rhs];
+         size_t len = std::min(lhsText.length(), rhsText.length());
+         for (size_t i = 0; i < len; i++)
+         {
+            int lhsCh = ::tolower(static_cast<unsigned char>(lhsText[i]));
+            int rhsCh = ::tolower(static_cast<unsigned char>(rhsText[i]));
+            if (lhsCh != rhsCh)
+               return lhsCh < rhsCh;
+         }
+         return lhsText.length() < rhsText.length();
+      }
+      return column_.values[lhs] < column_.values[rhs];
+   }
+
+   const NativeColumn& column_;
+};
+
+// indicates whether a cell sorts to the end of its column regardless of
+// direction (as R's order() does for NA and NaN)
+bool sortsLast(const NativeColumn& column, int row)
+{
+   if (column.missing[row])
+      return true;
+   if (column.type == NativeColumn::COL_NUMERIC)
+   {
+      double value = column.values[row];
+      if (value != value)
+         return true;
+   }
+   return false;
+}
+
+// returns the ascending permutation for a column, building it on first use
+const std::vector<int>& ascendingOrder(NativeColumn* pColumn, int nrow)
+{
+   if (pColumn->ascendingOrder.empty() && nrow > 0)
+   {
+      std::vector<int> order;
+      std::vector<int> last;
+      order.reserve(nrow);
+      for (int i = 0; i < nrow; i++)
+      {
+         if (sortsLast(*pColumn, i))
+            last.push_back(i);
+         else
+            order.push_back(i);
+      }
+
+      // stable sort matches the tie behavior of R's order()
+      std::stable_sort(order.begin(), order.end(),
+                       NativeColumnLess(*pColumn));
+
+      pColumn->sortedValueCount = static_cast<int>(order.size());
+      order.insert(order.end(), last.begin(), last.end());
+      pColumn->ascendingOrder.swap(order);
+   }
+   return pColumn->ascendingOrder;
+}
+
+// maps a position in the display order to a row in the frame
+int displayRow(const std::vector<int>* pOrder, bool descending,
+               int sortedCount, int index)
+{
+   if (pOrder == NULL)
+      return index;
+   if (!descending || index >= sortedCount)
+      return (*pOrder)[index];
+   return (*pOrder)[sortedCount - 1 - index];
+}
+
+// a parsed column filter (see .rs.applyTransform for the R equivalent of
+// each filter type)
+struct NativeFilter
+{
+   enum Type
+   {
+      FILTER_NONE,
+      FILTER_FACTOR,
+      FILTER_CHARACTER,
+      FILTER_NUMERIC_RANGE,
+      FILTER_NUMERIC_VALUE,
+      FILTER_BOOLEAN
+   };
+
+   NativeFilter() :
+      type(FILTER_NONE),
+      value(0),
+      minValue(0),
+      maxValue(0),
+      boolValue(false)
+   {
+   }
+
+   Type type;
+   double value;
+   double minValue;
+   double maxValue;
+   bool boolValue;
+   std::string lowerTerm;
+};
+
+NativeFilter parseNativeFilter(const std::string& filter)
+{
+   NativeFilter parsed;
+
+   // filters have the form "type|value"; unparseable filters match all
+   // rows (as the R path does when handed a filter it can't interpret)
+   size_t pipe = filter.find(kFilterSeparator);
+   if (pipe == std::string::npos)
+      return parsed;
+   std::string filterType(filter.substr(0, pipe));
+   std::string filterValue(filter.substr(pipe + 1));
+
+   if (filterType == "numeric")
+   {
+      size_t sep = filterValue.find('_');
+      if (sep != std::string::npos)
+      {
+         parsed.type = NativeFilter::FILTER_NUMERIC_RANGE;
+         parsed.minValue = safe_convert::stringTo<double>(
+               filterValue.substr(0, sep), 0);
+         parsed.maxValue = safe_convert::stringTo<double>(
+               filterValue.substr(sep + 1), 0);
+      }
+      else
+      {
+         parsed.type = NativeFilter::FILTER_NUMERIC_VALUE;
+         parsed.value = safe_convert::stringTo<double>(filterValue, 0);
+      }
+   }
+   else if (filterType == "factor")
+   {
+      parsed.type = NativeFilter::FILTER_FACTOR;
+      parsed.value = safe_convert::stringTo<double>(filterValue, 0);
+   }
+   else if (filterType == "boolean")
+   {
+      parsed.type = NativeFilter::FILTER_BOOLEAN;
+      parsed.boolValue = (filterValue == "TRUE");
+   }
+   else if (filterType == "character")
+   {
+      parsed.type = NativeFilter::FILTER_CHARACTER;
+      parsed.lowerTerm = string_utils::toLower(filterValue);
+   }
+   return parsed;
+}
+
+bool cellMatchesFilter(const NativeColumn& column, int row,
+                       const NativeFilter& filter)
+{
+   switch (filter.type)
+   {
+      case NativeFilter::FILTER_NONE:
+         return true;
+      case NativeFilter::FILTER_FACTOR:
+         // matches the factor's level code (as.numeric on a factor)
+         return !column.missing[row] && column.values[row] == filter.value;
+      case NativeFilter::FILTER_BOOLEAN:
+         return !column.missing[row] &&
+                (column.values[row] != 0) == filter.boolValue;
+      case NativeFilter::FILTER_NUMERIC_RANGE:
+      case NativeFilter::FILTER_NUMERIC_VALUE:
+      {
+         if (column.missing[row])
+            return false;
+         double value = column.values[row];
+         // the R filter applies is.finite, which excludes NaN and Inf
+         if (value != value ||
+             value > std::numeric_limits<double>::max() ||
+             value < -std::numeric_limits<double>::max())
+            return false;
+         if (filter.type == NativeFilter::FILTER_NUMERIC_RANGE)
+            return value >= filter.minValue && value <= filter.maxValue;
+         return value == filter.value;
+      }
+      case NativeFilter::FILTER_CHARACTER:
+      default:
+         // case-insensitive substring match on the cell's display text
+         // (also used for factors with more than MAX_FACTORS levels)
+         return !column.missing[row] &&
+                containsCaseInsensitive(nativeCellText(column, row),
+                                        filter.lowerTerm);
+   }
+}
+
+bool rowMatches(const NativeFrame& frame, int row,
+                const std::vector<NativeFilter>& filters,
+                const std::string& lowerSearch)
+{
+   for (unsigned i = 0; i < filters.size(); i++)
+   {
+      if (!cellMatchesFilter(frame.columns[i], row, filters[i]))
+         return false;
+   }
+
+   // a global search matches if any column's text contains the term
+   if (!lowerSearch.empty())
+   {
+      for (unsigned i = 0; i < frame.columns.size(); i++)
+      {
+         const NativeColumn& column = frame.columns[i];
+         if (!column.missing[row] &&
+             containsCaseInsensitive(nativeCellText(column, row),
+                                     lowerSearch))
+            return true;
+      }
+      return false;
+   }
+
+   return true;
+}
+
+// copies a single column's cells out of its SEXP into the snapshot; returns
+// false for column types we can't represent
+bool materializeColumn(SEXP columnSEXP, int nrow, NativeColumn* pColumn)
+{
+   NativeColumn& column = *pColumn;
+   column.missing.resize(nrow, false);
+
+   switch (TYPEOF(columnSEXP))
+   {
+      case REALSXP:
+      {
+         column.type = NativeColumn::COL_NUMERIC;
+         column.values.resize(nrow);
+         double* pValues = REAL(columnSEXP);
+         for (int i = 0; i < nrow; i++)
+         {
+            column.values[i] = pValues[i];
+            if (ISNA(pValues[i]))
+               column.missing[i] = true;
+         }
+         break;
+      }
+      case INTSXP:
+      {
+         SEXP levelsSEXP = Rf_getAttrib(columnSEXP, R_LevelsSymbol);
+         bool isFactor = TYPEOF(levelsSEXP) == STRSXP;
+         column.type = isFactor ? NativeColumn::COL_FACTOR :
+                                  NativeColumn::COL_INTEGER;
+         if (isFactor)
+         {
+            int numLevels = Rf_length(levelsSEXP);
+            column.levels.reserve(numLevels);
+            for (int i = 0; i < numLevels; i++)
+               column.levels.push_back(
+                     Rf_translateCharUTF8(STRING_ELT(levelsSEXP, i)));
+         }
+         column.values.resize(nrow);
+         int* pValues = INTEGER(columnSEXP);
+         for (int i = 0; i < nrow; i++)
+         {
+            if (pValues[i] == NA_INTEGER)
+               column.missing[i] = true;
+            else
+               column.values[i] = pValues[i];
+         }
+         break;
+      }
+      case LGLSXP:
+      {
+         column.type = NativeColumn::COL_BOOLEAN;
+         column.values.resize(nrow);
+         int* pValues = LOGICAL(columnSEXP);
+         for (int i = 0; i < nrow; i++)
+         {
+            if (pValues[i] == NA_LOGICAL)
+               column.missing[i] = true;
+            else
+               column.values[i] = pValues[i];
+         }
+         break;
+      }
+      case STRSXP:
+      {
+         column.type = NativeColumn::COL_CHARACTER;
+         column.text.reserve(nrow);
+         for (int i = 0; i < nrow; i++)
+         {
+            SEXP cellSEXP = STRING_ELT(columnSEXP, i);
+            if (cellSEXP == NA_STRING)
+            {
+               column.missing[i] = true;
+               column.text.push_back(std::string());
+            }
+            else
+            {
+               column.text.push_back(Rf_translateCharUTF8(cellSEXP));
+            }
+         }
+         break;
+      }
+      default:
+         return false;
+   }
+
+   column.materialized = true;
+   return true;
+}
+
+// materializes a column on first use; returns false when the column can't
+// be materialized (the caller then abandons the snapshot)
+bool ensureColumnMaterialized(NativeFrame* pFrame, SEXP dataSEXP, int col)
+{
+   NativeColumn& column = pFrame->columns[col];
+   if (column.materialized)
+      return true;
+
+   if (TYPEOF(dataSEXP) != VECSXP || Rf_length(dataSEXP) <= col)
+      return false;
+
+   SEXP columnSEXP = VECTOR_ELT(dataSEXP, col);
+   if (columnSEXP == NULL || Rf_length(columnSEXP) != pFrame->nrow)
+      return false;
+
+   try
+   {
+      return materializeColumn(columnSEXP, pFrame->nrow, &column);
+   }
+   catch (std::bad_alloc&)
+   {
+      return false;
+   }
+}
+
+// snapshots the shape of a data frame (dimensions, row names, and column
+// placeholders -- cells are materialized per column on demand); returns an
+// empty pointer when the frame contains columns we can't represent (the
+// caller then falls back to transforming through R)
+boost::shared_ptr<NativeFrame> snapshotFrame(SEXP dataSEXP, int nrow,
+                                             int ncol)
+{
+   if (TYPEOF(dataSEXP) != VECSXP || Rf_length(dataSEXP) < ncol)
+      return boost::shared_ptr<NativeFrame>();
+
+   boost::shared_ptr<NativeFrame> pFrame;
+   try
+   {
+      pFrame.reset(new NativeFrame());
+      pFrame->nrow = nrow;
+
+      // capture explicit row names (compact row names denote automatic row
+      // numbering, which we can synthesize on demand)
+      SEXP rowNamesSEXP = Rf_getAttrib(dataSEXP, R_RowNamesSymbol);
+      if (TYPEOF(rowNamesSEXP) == STRSXP && Rf_length(rowNamesSEXP) == nrow)
+      {
+         pFrame->hasRowNames = true;
+         pFrame->rowNames.reserve(nrow);
+         for (int i = 0; i < nrow; i++)
+         {
+            SEXP nameSEXP = STRING_ELT(rowNamesSEXP, i);
+            pFrame->rowNames.push_back(
+                  nameSEXP == NA_STRING ?
+                     std::string() :
+                     std::string(Rf_translateCharUTF8(nameSEXP)));
+         }
+      }
+
+      // verify every column has a representable type before committing to
+      // the snapshot, but don't copy any cells yet
+      pFrame->columns.resize(ncol);
+      for (int col = 0; col < ncol; col++)
+      {
+         SEXP columnSEXP = VECTOR_ELT(dataSEXP, col);
+         if (columnSEXP == NULL || Rf_length(columnSEXP) != nrow)
+            return boost::shared_ptr<NativeFrame>();
+
+         switch (TYPEOF(columnSEXP))
+         {
+            case REALSXP:
+            case INTSXP:
+            case LGLSXP:
+            case STRSXP:
+               break;
+            default:
+               // list columns and other exotic types keep the R path
+               return boost::shared_ptr<NativeFrame>();
+         }
+      }
+   }
+   catch (std::bad_alloc&)
+   {
+      // not enough memory to snapshot the frame; fall back to the R path
+      return boost::shared_ptr<NativeFrame>();
+   }
+
+   return pFrame;
+}
+
+// serves a DataTables page request entirely from a native snapshot (the
+// counterpart of the R-based transform path in getData below); columns are
+// materialized from dataSEXP as they're needed. returns an empty string if
+// a column can't be materialized (the caller then abandons the snapshot)
+std::string getDataNative(NativeFrame& frame, SEXP dataSEXP,
+                          int draw, int start, int length,
+                          int ordercol, const std::string& orderdir,
+                          const std::string& search,
+                          const std::vector<std::string>& filters,
+                          int colOffset, int colCount)
+{
+   int nrow = frame.nrow;
+   int ncol = static_cast<int>(frame.columns.size());
+   length = std::max(length, 0);
+
+   // resolve the requested column window (a count of 0 means all columns)
+   colOffset = std::min(std::max(colOffset, 0), ncol);
+   if (colCount <= 0)
+      colCount = ncol;
+   colCount = std::min(colCount, ncol - colOffset);
+
+   // parse the column filters
+   bool hasFilter = false;
+   std::vector<NativeFilter> parsedFilters(
+         std::min(filters.size(), frame.columns.size()));
+   for (unsigned i = 0; i < parsedFilters.size(); i++)
+   {
+      if (filters[i].empty())
+         continue;
+      parsedFilters[i] = parseNativeFilter(filters[i]);
+      if (parsedFilters[i].type != NativeFilter::FILTER_NONE)
+         hasFilter = true;
+   }
+   std::string lowerSearch = string_utils::toLower(search);
+
+   // materialize the columns this request touches: the window served to
+   // the client, any filtered columns, and (for a global search, which
+   // scans every cell) the full frame
+   for (int col = colOffset; col < colOffset + colCount; col++)
+      if (!ensureColumnMaterialized(&frame, dataSEXP, col))
+         return std::string();
+   for (unsigned i = 0; i < parsedFilters.size(); i++)
+      if (parsedFilters[i].type != NativeFilter::FILTER_NONE &&
+          !ensureColumnMaterialized(&frame, dataSEXP, i))
+         return std::string();
+   if (!lowerSearch.empty())
+      for (int col = 0; col < ncol; col++)
+         if (!ensureColumnMaterialized(&frame, dataSEXP, col))
+            return std::string();
+   if (ordercol > 0 && ordercol <= ncol &&
+       !ensureColumnMaterialized(&frame, dataSEXP, ordercol - 1))
+      return std::string();
+
+   // resolve the display order (ordercol is 1-based; 0 means unsorted)
+   const std::vector<int>* pOrder = NULL;
+   bool descending = false;
+   int sortedCount = 0;
+   if (ordercol > 0 && ordercol <= ncol)
+   {
+      NativeColumn& column = frame.columns[ordercol - 1];
+      pOrder = &ascendingOrder(&column, nrow);
+      sortedCount = column.sortedValueCount;
+      descending = (orderdir == "desc");
+   }
+
+   // collect the rows in the requested window; when filtering we scan
+   // every row so the client can size its scrollbar correctly
+   std::vector<int> window;
+   int matched = 0;
+   if (!hasFilter && lowerSearch.empty())
+   {
+      matched = nrow;
+      for (int i = start;
+           i < nrow && static_cast<int>(window.size()) < length;
+           i++)
+      {
+         window.push_back(displayRow(pOrder, descending, sortedCount, i));
+      }
+   }
+   else
+   {
+      for (int i = 0; i < nrow; i++)
+      {
+         int row = displayRow(pOrder, descending, sortedCount, i);
+         if (!rowMatches(frame, row, parsedFilters, lowerSearch))
+            continue;
+         if (matched >= start && static_cast<int>(window.size()) < length)
+            window.push_back(row);
+         matched++;
+      }
+   }
+
+   // stream the result grid directly to JSON text (as getData does)
+   std::string output;
+   output.append("{\"draw\":");
+   output.append(safe_convert::numberToString(draw));
+   output.append(",\"recordsTotal\":");
+   output.append(safe_convert::numberToString(nrow));
+   output.append(",\"recordsFiltered\":");
+   output.append(safe_convert::numberToString(matched));
+   output.append(",\"data\":[");
+   for (unsigned i = 0; i < window.size(); i++)
+   {
+      int row = window[i];
+      if (i > 0)
+         output.push_back(',');
+      output.push_back('[');
+
+      if (frame.hasRowNames && !frame.rowNames[row].empty())
+         r::json::writeJsonString(frame.rowNames[row], &output);
+      else
+         output.append(safe_convert::numberToString(row + 1));
+
+      for (int col = colOffset; col < colOffset + colCount; col++)
+      {
+         output.push_back(',');
+         const NativeColumn& column = frame.columns[col];
+         if (column.missing[row])
+            output.append(safe_convert::numberToString(SPECIAL_CELL_NA));
+         else
+            r::json::writeJsonString(nativeCellText(column, row), &output);
+      }
+      output.push_back(']');
+   }
+   output.append("]}");
+
+   return output;
+}
+
 // CachedFrame represents an object that's currently active in a data viewer
 // window.
 struct CachedFrame
@@ -231,6 +904,7 @@ struct CachedFrame
    CachedFrame(const std::string& env, const std::string& obj, SEXP sexp):
       envName(env),
       objName(obj),
+      nativeUnsupported(false),
       observedSEXP(sexp)
    {
       if (sexp == NULL)
@@ -250,7 +924,7 @@ struct CachedFrame
       ncol = safeDim(sexp, DIM_COLS);
    };
 
-   CachedFrame() {};
+   CachedFrame(): nativeUnsupported(false) {};
 
    // The location of the frame (if we know it)
    std::string envName;
@@ -287,6 +961,12 @@ struct CachedFrame
    int workingOrderCol;
    std::string workingOrderDir;
 
+   // Native columnar snapshot of the frame (created lazily when the frame
+   // is first sorted or filtered); frames the native engine can't represent
+   // are flagged so we don't retry the snapshot on every request
+   boost::shared_ptr<NativeFrame> nativeFrame;
+   bool nativeUnsupported;
+
    // NB: There's no protection on this SEXP and it may be a stale pointer!
    // Used only to test for changes.
    SEXP observedSEXP;
@@ -434,27 +1114,64 @@ void handleGridResReq(const http::Request& request,
    pResponse->setCacheableFile(gridResource, request);
 }
 
-json::Value getCols(SEXP dataSEXP)
+std::string getCols(SEXP dataSEXP, const http::Fields& fields)
 {
+   // the column window to describe; old clients don't send these fields,
+   // and a count of 0 describes every column at once
+   int colOffset = http::util::fieldValue<int>(fields, "column_offset", 0);
+   int colCount = http::util::fieldValue<int>(fields, "column_count", 0);
+
    SEXP colsSEXP = R_NilValue;
    r::sexp::Protect protect;
-   json::Value result;
-   Error error = r::exec::RFunction(".rs.describeCols", dataSEXP, MAX_FACTORS)
+   Error error = r::exec::RFunction(".rs.describeCols", dataSEXP, MAX_FACTORS,
+         std::max(colOffset, 0), std::max(colCount, 0))
       .call(&colsSEXP, &protect);
-   if (error || colsSEXP == R_NilValue) 
+
+   // stream the column definitions directly to JSON text
+   std::string output;
+   if (!error && colsSEXP != R_NilValue)
+      error = r::json::writeJsonFromObject(colsSEXP, &output);
+
+   if (error || colsSEXP == R_NilValue)
    {
       json::Object err;
-      if (error) 
+      if (error)
          err["error"] = error.summary();
       else
          err["error"] = "Failed to retrieve column definitions for data.";
-      result = err;
+      output = json::write(err);
    }
-   else 
+   return output;
+}
+
+// returns the names of every column in the frame (plus the column count)
+// without materializing any cells; the client uses this as a lightweight
+// index when searching for a column by name in a wide frame, then requests
+// the window of column definitions containing the match
+std::string getColNames(SEXP dataSEXP)
+{
+   std::vector<std::string> names;
+   Error error = r::sexp::getNames(dataSEXP, &names);
+   if (error)
+   {
+      json::Object err;
+      err["error"] = error.summary();
+      return json::write(err);
+   }
+
+   // stream the name index directly to JSON text
+   std::string output;
+   output.append("{\"total_columns\":");
+   output.append(safe_convert::numberToString(names.size()));
+   output.append(",\"names\":[");
+   for (unsigned i = 0; i < names.size(); i++)
    {
-      r::json::jsonValueFromList(colsSEXP, &result);
+      if (i > 0)
+         output.push_back(',');
+      r::json::writeJsonString(names[i], &output);
    }
-   return result;
+   output.append("]}");
+   return output;
 }
 
 // given an object from which to return data, and a description of the data to
@@ -467,10 +1184,13 @@ json::Value getCols(SEXP dataSEXP)
 // NB: may throw exceptions! these are expected to be handled by the handlers
 // in getGridData, where they will be marshaled to JSON and displayed on the
 // client.
-json::Value getData(SEXP dataSEXP, const http::Fields& fields)
+std::string getData(SEXP dataSEXP, const http::Fields& fields)
 {
    Error error;
-   r::sexp::Protect protect;
+
+   // a page request protects a formatted copy of every column, so guard
+   // them with an arena rather than individual protection stack slots
+   r::sexp::ProtectArena protect;
 
    // read draw parameters from DataTables
    int draw = http::util::fieldValue<int>(fields, "draw", 0);
@@ -485,6 +1205,11 @@ json::Value getData(SEXP dataSEXP, const http::Fields& fields)
    std::string cacheKey = http::util::urlDecode(
          http::util::fieldValue<std::string>(fields, "cache_key", ""));
 
+   // the column window to serve; old clients don't send these fields, and
+   // a count of 0 means all columns
+   int colOffset = http::util::fieldValue<int>(fields, "column_offset", 0);
+   int colCount = http::util::fieldValue<int>(fields, "column_count", 0);
+
    int nrow = safeDim(dataSEXP, DIM_ROWS);
    int ncol = safeDim(dataSEXP, DIM_COLS);
    int filteredNRow = 0;
@@ -509,8 +1234,37 @@ json::Value getData(SEXP dataSEXP, const http::Fields& fields)
    bool hasTransform = false;
 
    // check to see if we have an ordered/filtered view we can build from
-   std::map<std::string, CachedFrame>::iterator cachedFrame = 
+   std::map<std::string, CachedFrame>::iterator cachedFrame =
       s_cachedFrames.find(cacheKey);
+
+   // once the user starts sorting or filtering, snapshot the frame into
+   // native columnar storage and serve this (and every subsequent) request
+   // from it without touching R
+   if (cachedFrame != s_cachedFrames.end())
+   {
+      CachedFrame& frame = cachedFrame->second;
+      if (needsTransform && !frame.nativeFrame && !frame.nativeUnsupported)
+      {
+         frame.nativeFrame = snapshotFrame(dataSEXP, nrow, ncol);
+         if (!frame.nativeFrame)
+            frame.nativeUnsupported = true;
+      }
+      if (frame.nativeFrame)
+      {
+         std::string result = getDataNative(*frame.nativeFrame, dataSEXP,
+                                            draw, start, length,
+                                            ordercol, orderdir, search,
+                                            filters, colOffset, colCount);
+         if (!result.empty())
+            return result;
+
+         // a column couldn't be materialized (e.g. the frame changed shape
+         // underneath us); abandon the snapshot and use the R path
+         frame.nativeFrame.reset();
+         frame.nativeUnsupported = true;
+      }
+   }
+
    if (needsTransform)
    {
       if (cachedFrame != s_cachedFrames.end())
@@ -589,10 +1343,19 @@ json::Value getData(SEXP dataSEXP, const http::Fields& fields)
    // DataTables uses 0-based indexing, but R uses 1-based indexing
    start ++;
 
-   // extract the portion of the column vector requested by the client
-   SEXP formattedDataSEXP = Rf_allocVector(VECSXP, ncol);
+   // resolve the requested column window (a count of 0 means all columns);
+   // only the columns inside the window are formatted and returned
+   colOffset = std::min(std::max(colOffset, 0), ncol);
+   if (colCount <= 0)
+      colCount = ncol;
+   colCount = std::min(colCount, ncol - colOffset);
+
+   // extract the portion of the column vectors requested by the client
+   SEXP formattedDataSEXP = Rf_allocVector(VECSXP, colCount);
    protect.add(formattedDataSEXP);
-   for (unsigned i = 0; i < static_cast<unsigned>(ncol); i++)
+   for (unsigned i = static_cast<unsigned>(colOffset);
+        i < static_cast<unsigned>(colOffset + colCount);
+        i++)
    {
       SEXP columnSEXP = VECTOR_ELT(dataSEXP, i);
       if (columnSEXP == NULL || TYPEOF(columnSEXP) == NILSXP || 
@@ -609,7 +1372,7 @@ json::Value getData(SEXP dataSEXP, const http::Fields& fields)
       error = formatFx.call(&formattedColumnSEXP, &protect);
       if (error)
          throw r::exec::RErrorException(error.summary());
-      SET_VECTOR_ELT(formattedDataSEXP, i, formattedColumnSEXP);
+      SET_VECTOR_ELT(formattedDataSEXP, i - colOffset, formattedColumnSEXP);
     }
 
    // format the row names 
@@ -617,11 +1380,22 @@ json::Value getData(SEXP dataSEXP, const http::Fields& fields)
    r::exec::RFunction(".rs.formatRowNames", dataSEXP, start, length)
       .call(&rownamesSEXP, &protect);
    
-   // create the result grid as JSON
-   json::Array data;
+   // stream the result grid directly to JSON text (avoids materializing
+   // an intermediate json::Value tree for large grids)
+   std::string output;
+   output.append("{\"draw\":");
+   output.append(safe_convert::numberToString(draw));
+   output.append(",\"recordsTotal\":");
+   output.append(safe_convert::numberToString(nrow));
+   output.append(",\"recordsFiltered\":");
+   output.append(safe_convert::numberToString(filteredNRow));
+   output.append(",\"data\":[");
    for (int row = 0; row < length; row++)
    {
-      json::Array rowData;
+      if (row > 0)
+         output.push_back(',');
+      output.push_back('[');
+
       if (rownamesSEXP != NULL &&
           TYPEOF(rownamesSEXP) != NILSXP &&
           !Rf_isNull(rownamesSEXP) )
@@ -631,22 +1405,23 @@ json::Value getData(SEXP dataSEXP, const http::Fields& fields)
              nameSEXP != NA_STRING &&
              r::sexp::length(nameSEXP) > 0)
          {
-            rowData.push_back(Rf_translateCharUTF8(nameSEXP));
+            r::json::writeJsonString(Rf_translateCharUTF8(nameSEXP), &output);
          }
          else
          {
-            rowData.push_back(row + start);
+            output.append(safe_convert::numberToString(row + start));
          }
       }
       else
       {
-         rowData.push_back(row + start);
+         output.append(safe_convert::numberToString(row + start));
       }
 
       for (int col = 0; col<Rf_length(formattedDataSEXP); col++)
       {
+         output.push_back(',');
          SEXP columnSEXP = VECTOR_ELT(formattedDataSEXP, col);
-         if (columnSEXP != NULL && 
+         if (columnSEXP != NULL &&
              TYPEOF(columnSEXP) != NILSXP &&
              !Rf_isNull(columnSEXP))
          {
@@ -655,37 +1430,35 @@ json::Value getData(SEXP dataSEXP, const http::Fields& fields)
                 stringSEXP != NA_STRING &&
                 r::sexp::length(stringSEXP) > 0)
             {
-               rowData.push_back(Rf_translateCharUTF8(stringSEXP));
+               r::json::writeJsonString(Rf_translateCharUTF8(stringSEXP),
+                                        &output);
             }
-            else if (stringSEXP == NA_STRING) 
+            else if (stringSEXP == NA_STRING)
             {
-               rowData.push_back(SPECIAL_CELL_NA);
+               output.append(
+                     safe_convert::numberToString(SPECIAL_CELL_NA));
             }
             else
             {
-               rowData.push_back("");
+               output.append("\"\"");
             }
          }
          else
          {
-            rowData.push_back("");
+            output.append("\"\"");
          }
       }
-      data.push_back(rowData);
+      output.push_back(']');
    }
+   output.append("]}");
 
-   json::Object result;
-   result["draw"] = draw;
-   result["recordsTotal"] = nrow;
-   result["recordsFiltered"] = filteredNRow;
-   result["data"] = data;
-   return result;
+   return output;
 }
 
 Error getGridData(const http::Request& request,
                   http::Response* pResponse)
 {
-   json::Value result;
+   std::string output;
    http::status::Code status = http::status::Ok;
 
    try
@@ -735,7 +1508,7 @@ Error getGridData(const http::Request& request,
          json::Object err;
          err["error"] = "The object no longer exists.";
          status = http::status::NotFound;
-         result = err;
+         output = json::write(err);
       }
       else 
       {
@@ -748,11 +1521,15 @@ Error getGridData(const http::Request& request,
       
          if (show == "cols")
          {
-            result = getCols(dataSEXP);
+            output = getCols(dataSEXP, fields);
+         }
+         else if (show == "colnames")
+         {
+            output = getColNames(dataSEXP);
          }
          else if (show == "data")
          {
-            result = getData(dataSEXP, fields);
+            output = getData(dataSEXP, fields);
          }
       }
 
@@ -763,14 +1540,11 @@ Error getGridData(const http::Request& request,
       // error handling code) expects
       json::Object err;
       err["error"] = e.message();
-      result = err;
+      output = json::write(err);
       status = http::status::InternalServerError;
    }
    CATCH_UNEXPECTED_EXCEPTION
 
-   std::ostringstream ostr;
-   json::write(result, ostr);
-
    // There are some unprintable ASCII control characters that are written
    // verbatim by json::write, but that won't parse in most Javascript JSON
    // parsing implementations, even if contained in a string literal. Scan the
@@ -779,8 +1553,7 @@ Error getGridData(const http::Request& request,
    // unprintable and (b) some characters are invalid *even if escaped* e.g.
    // \v, there's little to be gained here in trying to marshal them to the
    // viewer.
-   std::string output = ostr.str();
-   for (size_t i = 0; i < output.size(); i++) 
+   for (size_t i = 0; i < output.size(); i++)
    {
       char c = output[i];
       // These ranges for control character values come from empirical testing
@@ -1006,7 +1779,7 @@ Error initialize()
    source_database::events().onDocPendingRemove.connect(onDocPendingRemove);
 
    module_context::events().onShutdown.connect(onShutdown);
-   module_context::events().onDetectChanges.connect(onDetectChanges);
+   module_context::registerChangeDetection("data-viewer", onDetectChanges);
    module_context::events().onClientInit.connect(onClientInit);
    module_context::events().onDeferredInit.connect(onDeferredInit);
    addSuspendHandler(SuspendHandler(onSuspend, onResume));
@@ -15,9 +15,14 @@
 
 #include "SessionData.hpp"
 
+#include <boost/foreach.hpp>
+
 #include <core/Exec.hpp>
- 
+#include <core/text/DelimitedReader.hpp>
+
 #include <r/RExec.hpp>
+#include <r/RRoutines.hpp>
+#include <r/RSexp.hpp>
 #include <r/RErrorCategory.hpp>
 #include <r/RJson.hpp>
 #include <r/RSourceManager.hpp>
@@ -26,6 +31,7 @@
 #include <session/SessionModuleContext.hpp>
 #include <session/SessionAsyncRProcess.hpp>
 
+#include "DataPreview.hpp"
 #include "DataViewer.hpp"
 
 using namespace rstudio::core ;
@@ -231,13 +237,100 @@ Error abortPreviewDataImportAsync(const json::JsonRpcRequest& request,
    return Success();
 }
 
+// read a delimited file with the native parallel reader and return a
+// named list of typed column vectors plus the row count; the R wrapper
+// (.rs.readDelimitedNative) assembles the data frame. returns NULL on
+// error so callers can fall back to an R-based reader
+SEXP rs_readDelimitedData(SEXP pathSEXP, SEXP delimiterSEXP, SEXP headerSEXP)
+{
+   std::string path = r::sexp::safeAsString(pathSEXP);
+   std::string delimiter = r::sexp::safeAsString(delimiterSEXP);
+
+   text::DelimitedReadOptions options;
+   if (!delimiter.empty())
+      options.delimiter = delimiter[0];
+   options.header = r::sexp::asLogical(headerSEXP);
+
+   std::vector<text::DelimitedColumn> columns;
+   std::size_t numRows = 0;
+   Error error = text::readDelimitedFile(
+            module_context::resolveAliasedPath(path),
+            options,
+            &columns,
+            &numRows);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return R_NilValue;
+   }
+
+   r::sexp::Protect rProtect;
+   r::sexp::ListBuilder columnsBuilder(&rProtect);
+   BOOST_FOREACH(const text::DelimitedColumn& column, columns)
+   {
+      switch (column.type)
+      {
+         case text::DelimitedColumnLogical:
+         {
+            SEXP columnSEXP = Rf_allocVector(LGLSXP, column.intData.size());
+            rProtect.add(columnSEXP);
+            for (std::size_t i = 0; i < column.intData.size(); i++)
+            {
+               LOGICAL(columnSEXP)[i] =
+                     column.intData[i] == kDelimitedNAInteger
+                        ? NA_LOGICAL
+                        : column.intData[i];
+            }
+            columnsBuilder.add(column.name, columnSEXP);
+            break;
+         }
+         case text::DelimitedColumnInteger:
+         {
+            // kDelimitedNAInteger matches NA_INTEGER so missing values
+            // pass through unmodified
+            columnsBuilder.add(column.name,
+                               r::sexp::create(column.intData, &rProtect));
+            break;
+         }
+         case text::DelimitedColumnDouble:
+         {
+            SEXP columnSEXP = r::sexp::create(column.doubleData, &rProtect);
+            double* pValues = REAL(columnSEXP);
+            for (std::size_t i = 0; i < column.doubleData.size(); i++)
+            {
+               if (ISNAN(pValues[i]))
+                  pValues[i] = NA_REAL;
+            }
+            columnsBuilder.add(column.name, columnSEXP);
+            break;
+         }
+         case text::DelimitedColumnCharacter:
+         default:
+         {
+            columnsBuilder.add(column.name,
+                               r::sexp::create(column.textData, &rProtect));
+            break;
+         }
+      }
+   }
+
+   r::sexp::ListBuilder resultBuilder(&rProtect);
+   resultBuilder.add("columns", columnsBuilder);
+   resultBuilder.add("rows", static_cast<double>(numRows));
+   return r::sexp::create(resultBuilder, &rProtect);
+}
+
 Error initialize()
 {
    using boost::bind;
    using namespace session::module_context;
+
+   RS_REGISTER_CALL_METHOD(rs_readDelimitedData, 3);
+
    ExecBlock initBlock;
    initBlock.addFunctions()
       (data::viewer::initialize)
+      (data::preview::initialize)
       (bind(sourceModuleRFile, "SessionDataImport.R"))
       (bind(sourceModuleRFile, "SessionDataImportV2.R"))
       (bind(registerAsyncRpcMethod, "preview_data_import_async", getPreviewDataImportAsync))
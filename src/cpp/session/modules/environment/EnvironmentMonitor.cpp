@@ -30,43 +30,18 @@ namespace modules {
 namespace environment {
 namespace {
 
-bool compareVarName(const r::sexp::Variable& var1,
-                    const r::sexp::Variable& var2)
-{
-   return var1.first < var2.first;
-}
-
 void enqueRefreshEvent()
 {
    ClientEvent refreshEvent(client_events::kEnvironmentRefresh);
    module_context::enqueClientEvent(refreshEvent);
 }
 
-// if the given variable is an unevaluated promise, add it to the given
-// list of variables
-void addUnevaledPromise(std::vector<r::sexp::Variable>* pEnv,
-                        const r::sexp::Variable& var)
+// converts a binding fingerprint to a named variable (this is the only
+// point at which a binding's name is translated, so we pay for it only on
+// bindings which actually changed)
+r::sexp::Variable bindingVariable(const r::sexp::BindingFingerprint& binding)
 {
-   if (isUnevaluatedPromise(var.second))
-   {
-      pEnv->push_back(var);
-   }
-}
-
-// If the given variable exists in the given list, remove it. Compares on name
-// only.
-void removeVarFromList(std::vector<r::sexp::Variable>* pEnv,
-                       const r::sexp::Variable& var)
-{
-   for (std::vector<r::sexp::Variable>::iterator iter = pEnv->begin();
-        iter != pEnv->end(); iter++)
-   {
-      if (iter->first == var.first)
-      {
-         pEnv->erase(iter);
-         break;
-      }
-   }
+   return std::make_pair(r::sexp::symbolName(binding.symbol), binding.value);
 }
 
 } // anonymous namespace
@@ -117,124 +92,92 @@ bool EnvironmentMonitor::hasEnvironment()
    return getMonitoredEnvironment() != NULL;
 }
 
-void EnvironmentMonitor::listEnv(std::vector<r::sexp::Variable>* pEnv)
+// fingerprints every binding in the monitored environment. this is the
+// per-prompt scan, so it deliberately stays cheap: no binding names are
+// translated and no R code is evaluated
+void EnvironmentMonitor::snapshotBindings(
+                     std::vector<r::sexp::BindingFingerprint>* pBindings)
 {
-   r::sexp::Protect rProtect;
-   r::sexp::listEnvironment(getMonitoredEnvironment(),
-                            false,
-                            userSettings().showLastDotValue(),
-                            &rProtect,
-                            pEnv);
+   SEXP env = getMonitoredEnvironment();
+   if (env == NULL)
+      return;
+
+   r::sexp::fingerprintEnvironment(env,
+                                   userSettings().showLastDotValue(),
+                                   pBindings);
 }
 
 void EnvironmentMonitor::checkForChanges()
 {
-   // information about the current environment
-   std::vector<r::sexp::Variable> currentEnv ;
-   std::vector<r::sexp::Variable> currentPromises;
-
-   // list of assigns/removes (includes both value changes and promise
-   // evaluations)
-   std::vector<r::sexp::Variable> addedVars;
-   std::vector<r::sexp::Variable> removedVars;
-
-   // get the set of variables and promises in the current environment
-   listEnv(&currentEnv);
+   // fingerprint the current environment
+   std::vector<r::sexp::BindingFingerprint> currentBindings;
+   snapshotBindings(&currentBindings);
 
-   // R returns an environment list sorted in dictionary order. Since the
-   // set difference algorithms below use simple string comparisons to
-   // establish order, we need to re-sort the list into canonical order
-   // to avoid the algorithms detecting superfluous insertions.
-   std::sort(currentEnv.begin(), currentEnv.end(), compareVarName);
-
-   std::for_each(currentEnv.begin(), currentEnv.end(),
-                 boost::bind(addUnevaledPromise, &currentPromises, _1));
-
-   bool refreshEnqueued = false;
    if (!initialized_)
    {
       if (refreshOnInit_ ||
           getMonitoredEnvironment() == R_GlobalEnv)
       {
          enqueRefreshEvent();
-         refreshEnqueued = true;
       }
       initialized_ = true;
       refreshOnInit_ = false;
    }
-   else
+   else if (currentBindings != lastBindings_)
    {
-      if (currentEnv != lastEnv_)
+      // optimize for empty currentBindings (user reset workspace) or empty
+      // lastBindings_ (startup) by just sending a single refresh event
+      // only do this for the global environment--while debugging local
+      // environments, the environment object list is sent down as part of
+      // the context depth event.
+      if ((currentBindings.empty() || lastBindings_.empty())
+          && getMonitoredEnvironment() == R_GlobalEnv)
       {
-         // optimize for empty currentEnv (user reset workspace) or empty
-         // lastEnv_ (startup) by just sending a single refresh event
-         // only do this for the global environment--while debugging local
-         // environments, the environment object list is sent down as part of
-         // the context depth event.
-         if ((currentEnv.empty() || lastEnv_.empty())
-             && getMonitoredEnvironment() == R_GlobalEnv)
-         {
-            enqueRefreshEvent();
-            refreshEnqueued = true;
-         }
-         else
-         {
-            std::set_difference(lastEnv_.begin(), lastEnv_.end(),
-                                currentEnv.begin(), currentEnv.end(),
-                                std::back_inserter(removedVars),
-                                compareVarName);
-
-            // fire removed event for deletes
-            std::for_each(removedVars.begin(),
-                          removedVars.end(),
-                          boost::bind(&EnvironmentMonitor::enqueRemovedEvent,
-                                      this, _1));
-
-            // remove deleted objects from the list of uneval'ed promises
-            // so we'll stop monitoring them for evaluation
-            std::for_each(removedVars.begin(),
-                          removedVars.end(),
-                          boost::bind(removeVarFromList, &unevaledPromises_, _1));
-
-            // find adds & assigns (all variable name/value combinations in the
-            // current environment but NOT in the previous environment)
-            std::set_difference(currentEnv.begin(), currentEnv.end(),
-                                lastEnv_.begin(), lastEnv_.end(),
-                                std::back_inserter(addedVars));
-
-            // remove assigned objects from the list of uneval'ed promises
-            // (otherwise, we double-assign in the case where a promise SEXP
-            // is simultaneously forced/evaluated and assigned a new value)
-            std::for_each(addedVars.begin(),
-                          addedVars.end(),
-                          boost::bind(removeVarFromList, &unevaledPromises_, _1));
-
-         }
+         enqueRefreshEvent();
       }
-      // if a refresh is scheduled there's no need to emit add events one by one
-      if (!refreshEnqueued)
+      else
       {
-         // have any promises been evaluated since we last checked?
-         if (currentPromises != unevaledPromises_)
+         // walk both fingerprint lists (each sorted by symbol pointer) in
+         // a single merge pass; only bindings which actually changed get
+         // the expensive treatment of name translation and conversion to
+         // JSON, so the cost here scales with the size of the changed set
+         // rather than the size of the environment
+         std::size_t i = 0, j = 0;
+         while (i < lastBindings_.size() || j < currentBindings.size())
          {
-            // for each promise that is in the set of promises we are monitoring
-            // for evaluation but not in the set of currently tracked promises,
-            // we assume this to be an eval--process as an assign
-            std::set_difference(unevaledPromises_.begin(), unevaledPromises_.end(),
-                                currentPromises.begin(), currentPromises.end(),
-                                std::back_inserter(addedVars));
+            if (j == currentBindings.size() ||
+                (i < lastBindings_.size() &&
+                 lastBindings_[i].symbol < currentBindings[j].symbol))
+            {
+               // binding removed
+               enqueRemovedEvent(bindingVariable(lastBindings_[i]));
+               i++;
+            }
+            else if (i == lastBindings_.size() ||
+                     currentBindings[j].symbol < lastBindings_[i].symbol)
+            {
+               // binding added
+               enqueAssignedEvent(bindingVariable(currentBindings[j]));
+               j++;
+            }
+            else
+            {
+               // binding present in both; emit an assignment if the value
+               // changed or a promise we were monitoring was evaluated
+               if (lastBindings_[i].value != currentBindings[j].value ||
+                   (lastBindings_[i].unevaledPromise &&
+                    !currentBindings[j].unevaledPromise))
+               {
+                  enqueAssignedEvent(bindingVariable(currentBindings[j]));
+               }
+               i++;
+               j++;
+            }
          }
-
-         // fire assigned event for adds, assigns, and promise evaluations
-         std::for_each(addedVars.begin(),
-                       addedVars.end(),
-                       boost::bind(&EnvironmentMonitor::enqueAssignedEvent,
-                                    this, _1));
       }
    }
 
-   unevaledPromises_ = currentPromises;
-   lastEnv_ = currentEnv;
+   lastBindings_.swap(currentBindings);
 }
 
 } // namespace environment
@@ -32,12 +32,11 @@ public:
    bool hasEnvironment();
    void checkForChanges();
 private:
-   void listEnv(std::vector<r::sexp::Variable>* pEnvironment);
+   void snapshotBindings(std::vector<r::sexp::BindingFingerprint>* pBindings);
    void enqueRemovedEvent(const r::sexp::Variable& variable);
    void enqueAssignedEvent(const r::sexp::Variable& variable);
 
-   std::vector<r::sexp::Variable> lastEnv_;
-   std::vector<r::sexp::Variable> unevaledPromises_;
+   std::vector<r::sexp::BindingFingerprint> lastBindings_;
    r::sexp::PreservedSEXP environment_;
    bool initialized_;
    bool refreshOnInit_;
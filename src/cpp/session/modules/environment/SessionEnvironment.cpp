@@ -17,6 +17,8 @@
 #include "EnvironmentMonitor.hpp"
 
 #include <algorithm>
+#include <deque>
+#include <map>
 
 #include <core/Exec.hpp>
 #include <core/RecursionGuard.hpp>
@@ -190,6 +192,215 @@ SEXP rs_hasExternalPointer(SEXP objSEXP, SEXP nullSEXP)
    return r::sexp::create(hasPtr, &protect);
 }
 
+// The environment listing is recomputed at every console prompt, and
+// object.size() traverses its argument--for a list with millions of
+// elements this alone can add hundreds of milliseconds to each Enter
+// press. We therefore cache object sizes keyed by binding identity
+// (R's copy-on-modify semantics mean an unchanged SEXP address, type,
+// and length imply an unchanged object), estimate the size of large
+// containers up front, and fill in exact sizes during idle time.
+struct ObjectSizeEntry
+{
+   ObjectSizeEntry(): object(NULL), type(0), length(0), size(0), exact(false)
+   {
+   }
+
+   // NB: There's no protection on this SEXP and it may be a stale pointer!
+   // Used only to test for changes.
+   SEXP object;
+   int type;
+   int length;
+   double size;
+   bool exact;
+};
+
+std::map<std::string, ObjectSizeEntry> s_objectSizes;
+std::deque<std::string> s_pendingExactSizes;
+bool s_exactSizeWorkScheduled = false;
+
+// containers with more than this many elements get an estimated size up
+// front; the exact size is computed when the session is next idle
+const int kSizeEstimateThreshold = 10000;
+
+// a one-level approximation of object.size: exact arithmetic for atomic
+// vectors, a flat per-element charge for strings, and a fixed charge for
+// everything else (no traversal)
+double shallowObjectSize(SEXP objSEXP)
+{
+   double n = r::sexp::length(objSEXP);
+   switch (TYPEOF(objSEXP))
+   {
+      case LGLSXP:
+      case INTSXP:
+         return 48 + 4 * n;
+      case REALSXP:
+         return 48 + 8 * n;
+      case CPLXSXP:
+         return 48 + 16 * n;
+      case RAWSXP:
+         return 48 + n;
+      case STRSXP:
+         return 48 + 64 * n;
+      default:
+         return 56;
+   }
+}
+
+double estimatedObjectSize(SEXP objSEXP)
+{
+   if (TYPEOF(objSEXP) != VECSXP)
+      return shallowObjectSize(objSEXP);
+
+   // lists are estimated one level deep (VECTOR_ELT is O(1), so this is
+   // a cheap pointer walk even for very long lists)
+   int length = r::sexp::length(objSEXP);
+   double size = 48 + 8 * static_cast<double>(length);
+   for (int i = 0; i < length; i++)
+      size += shallowObjectSize(VECTOR_ELT(objSEXP, i));
+   return size;
+}
+
+// indicates whether sizing the object exactly requires a traversal large
+// enough to be worth deferring (object.size is arithmetic for atomic
+// vectors but walks every element of lists and every string in a
+// character vector)
+bool isExpensiveToSize(SEXP objSEXP)
+{
+   int type = TYPEOF(objSEXP);
+   int length = r::sexp::length(objSEXP);
+   if ((type == VECSXP || type == STRSXP) && length > kSizeEstimateThreshold)
+      return true;
+
+   // check list elements (e.g. a data frame with a long character column)
+   if (type == VECSXP)
+   {
+      for (int i = 0; i < length; i++)
+      {
+         SEXP eltSEXP = VECTOR_ELT(objSEXP, i);
+         int eltType = TYPEOF(eltSEXP);
+         if ((eltType == VECSXP || eltType == STRSXP) &&
+             r::sexp::length(eltSEXP) > kSizeEstimateThreshold)
+            return true;
+      }
+   }
+
+   return false;
+}
+
+// computes the exact size of one estimated object; scheduled as idle
+// work so the traversal doesn't delay the console prompt
+bool computeNextExactObjectSize()
+{
+   if (!s_pendingExactSizes.empty())
+   {
+      std::string name = s_pendingExactSizes.front();
+      s_pendingExactSizes.pop_front();
+
+      std::map<std::string, ObjectSizeEntry>::iterator it =
+            s_objectSizes.find(name);
+      if (it != s_objectSizes.end() && !it->second.exact)
+      {
+         // the binding must still hold the object we estimated (unwrap
+         // forced promises, which get() sees through when describing)
+         SEXP env = s_pEnvironmentMonitor->getMonitoredEnvironment();
+         SEXP objSEXP = env != NULL ? r::sexp::findVar(name, env) : NULL;
+         if (objSEXP != NULL && TYPEOF(objSEXP) == PROMSXP)
+            objSEXP = PRVALUE(objSEXP);
+         if (objSEXP != it->second.object ||
+             objSEXP == NULL ||
+             TYPEOF(objSEXP) != it->second.type ||
+             r::sexp::length(objSEXP) != it->second.length)
+         {
+            // changed or removed since we estimated; drop the entry
+            s_objectSizes.erase(it);
+         }
+         else
+         {
+            double size = 0;
+            Error error = r::exec::RFunction(".rs.exactObjectSize",
+                                             objSEXP).call(&size);
+            if (error)
+               LOG_ERROR(error);
+            else
+            {
+               it->second.size = size;
+               it->second.exact = true;
+            }
+         }
+      }
+   }
+
+   if (s_pendingExactSizes.empty())
+   {
+      s_exactSizeWorkScheduled = false;
+      return false;
+   }
+   return true;
+}
+
+void scheduleExactObjectSize(const std::string& name)
+{
+   s_pendingExactSizes.push_back(name);
+   if (!s_exactSizeWorkScheduled)
+   {
+      s_exactSizeWorkScheduled = true;
+      module_context::scheduleIncrementalWork(
+               "compute object sizes",
+               boost::posix_time::milliseconds(100),
+               computeNextExactObjectSize,
+               true);   // idle only
+   }
+}
+
+// returns the cached size of the object bound to the given name, or NULL
+// when the caller (.rs.objectSize) should compute the size exactly and
+// store it via rs_storeObjectSize
+SEXP rs_cachedObjectSize(SEXP objSEXP, SEXP nameSEXP)
+{
+   r::sexp::Protect protect;
+   std::string name = r::sexp::safeAsString(nameSEXP);
+   int type = TYPEOF(objSEXP);
+   int length = r::sexp::length(objSEXP);
+
+   std::map<std::string, ObjectSizeEntry>::iterator it =
+         s_objectSizes.find(name);
+   if (it != s_objectSizes.end() &&
+       it->second.object == objSEXP &&
+       it->second.type == type &&
+       it->second.length == length)
+   {
+      return r::sexp::create(it->second.size, &protect);
+   }
+
+   // not cached; if the object is cheap to size exactly, have R do so
+   if (!isExpensiveToSize(objSEXP))
+      return R_NilValue;
+
+   // large container: record an estimate now and queue the exact
+   // computation for idle time
+   ObjectSizeEntry& entry = s_objectSizes[name];
+   entry.object = objSEXP;
+   entry.type = type;
+   entry.length = length;
+   entry.size = estimatedObjectSize(objSEXP);
+   entry.exact = false;
+   scheduleExactObjectSize(name);
+
+   return r::sexp::create(entry.size, &protect);
+}
+
+SEXP rs_storeObjectSize(SEXP objSEXP, SEXP nameSEXP, SEXP sizeSEXP)
+{
+   std::string name = r::sexp::safeAsString(nameSEXP);
+   ObjectSizeEntry& entry = s_objectSizes[name];
+   entry.object = objSEXP;
+   entry.type = TYPEOF(objSEXP);
+   entry.length = r::sexp::length(objSEXP);
+   entry.size = r::sexp::asReal(sizeSEXP);
+   entry.exact = true;
+   return R_NilValue;
+}
+
 // Construct a simulated source reference from a context containing a
 // function being debugged, and either the context containing the current
 // invocation or a string containing the last debug ouput from R.
@@ -361,7 +572,10 @@ json::Array callFramesAsJson(LineDebugState* pLineDebugState)
 json::Array environmentListAsJson()
 {
     using namespace rstudio::r::sexp;
-    Protect rProtect;
+
+    // listing a large environment guards one value per binding; use an
+    // arena so we occupy a single protection stack slot
+    ProtectArena rProtect;
     std::vector<Variable> vars;
     json::Array listJson;
 
@@ -1060,11 +1274,13 @@ Error initialize()
    r::routines::addCallMethod(methodDef);
 
    RS_REGISTER_CALL_METHOD(rs_hasExternalPointer, 2);
+   RS_REGISTER_CALL_METHOD(rs_cachedObjectSize, 2);
+   RS_REGISTER_CALL_METHOD(rs_storeObjectSize, 3);
 
    // subscribe to events
    using boost::bind;
    using namespace session::module_context;
-   events().onDetectChanges.connect(bind(onDetectChanges, _1));
+   registerChangeDetection("environment", bind(onDetectChanges, _1));
    events().onConsolePrompt.connect(bind(onConsolePrompt,
                                          pContextDepth,
                                          pLineDebugState,
@@ -219,6 +219,11 @@ json::Value asJson()
    return stateJson;
 }
 
+bool persistedStateExists()
+{
+   return presentationStatePath().exists();
+}
+
 Error initialize()
 {
    // attempt to load any cached state
@@ -54,7 +54,9 @@ void clear();
 
 core::json::Value asJson();
 
-
+// whether persisted state from a previous session exists on disk (used
+// to decide between eager and lazy module initialization)
+bool persistedStateExists();
 
 core::Error initialize();
 core::Error initializeOverlay();
@@ -505,6 +505,39 @@ Error initialize()
    return initBlock.execute();
 }
 
+Error initializeLazy()
+{
+   // if persisted presentation state exists (e.g. a presentation was
+   // showing when the session suspended) we need full initialization
+   // now so that client init can restore it
+   if (state::persistedStateExists())
+      return initialize();
+
+   std::vector<std::string> methods;
+   methods.push_back("create_standalone_presentation");
+   methods.push_back("create_desktop_view_in_browser_presentation");
+   methods.push_back("create_presentation_rpubs_source");
+   methods.push_back("set_presentation_slide_index");
+   methods.push_back("create_new_presentation");
+   methods.push_back("show_presentation_pane");
+   methods.push_back("close_presentation_pane");
+   methods.push_back("presentation_execute_code");
+   methods.push_back("set_working_directory");
+   methods.push_back("tutorial_feedback");
+   methods.push_back("tutorial_quiz_response");
+   methods.push_back("get_slide_navigation_for_file");
+   methods.push_back("get_slide_navigation_for_code");
+   methods.push_back("clear_presentation_cache");
+
+   std::vector<std::string> uriPrefixes;
+   uriPrefixes.push_back("/presentation");
+
+   return module_context::registerLazyModule("presentation",
+                                             initialize,
+                                             methods,
+                                             uriPrefixes);
+}
+
 } // namespace presentation
 } // namespace modules
 } // namespace session
@@ -39,7 +39,12 @@ namespace presentation {
 core::json::Value presentationStateAsJson();
 
 core::Error initialize();
-                       
+
+// register the module's rpc methods and uri handler as lazy stubs (full
+// initialization occurs on first use); falls back to eager
+// initialization when persisted presentation state needs to be restored
+core::Error initializeLazy();
+
 } // namespace presentation
 } // namespace modules
 } // namespace session
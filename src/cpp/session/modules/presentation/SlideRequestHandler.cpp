@@ -18,6 +18,7 @@
 
 #include <iostream>
 
+#include <boost/bind.hpp>
 #include <boost/utility.hpp>
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
@@ -29,6 +30,7 @@
 #include <boost/iostreams/filter/regex.hpp>
 
 #include <core/FileSerializer.hpp>
+#include <core/Hash.hpp>
 #include <core/HtmlUtils.hpp>
 #include <core/markdown/Markdown.hpp>
 #include <core/text/TemplateFilter.hpp>
@@ -833,9 +835,63 @@ void setWebCacheableFileResponse(const FilePath& path,
    }
 }
 
+// cache of fully rendered decks (keyed by request variant, e.g. zoom);
+// entries are valid only while the fingerprint of the presentation
+// source directory is unchanged
+struct RenderedDeck
+{
+   std::string fingerprint;
+   std::string html;
+};
+std::map<std::string,RenderedDeck> s_renderedDeckCache;
+
+bool addPathToFingerprint(std::ostream* pOstr,
+                          int level,
+                          const FilePath& path)
+{
+   *pOstr << path.absolutePath() << ":"
+          << path.lastWriteTime() << ":"
+          << path.size() << ";";
+   return true;
+}
+
+std::string presentationFingerprint()
+{
+   // fingerprint the presentation source directory (names, sizes, and
+   // modification times of every file) -- a change to the source or to
+   // any resource it references yields a different fingerprint
+   std::ostringstream ostr;
+   ostr << presentation::state::filePath().absolutePath() << ";";
+   Error error = presentation::state::directory().childrenRecursive(
+                        boost::bind(addPathToFingerprint, &ostr, _1, _2));
+   if (error)
+      LOG_ERROR(error);
+   return hash::crc32HexHash(ostr.str());
+}
+
 void handlePresentationRootRequest(const std::string& path,
                                    http::Response* pResponse)
-{   
+{
+   // serve directly from memory if the deck was rendered before and
+   // nothing in the presentation directory has changed since
+   std::string fingerprint = presentationFingerprint();
+   std::map<std::string,RenderedDeck>::const_iterator cacheIt =
+                                             s_renderedDeckCache.find(path);
+   if (cacheIt != s_renderedDeckCache.end() &&
+       cacheIt->second.fingerprint == fingerprint)
+   {
+      pResponse->setNoCacheHeaders();
+      pResponse->setContentType("text/html");
+      pResponse->setBody(cacheIt->second.html);
+
+      if (path != "zoom")
+      {
+         ClientEvent event(client_events::kPresentationPaneRequestCompleted);
+         module_context::enqueClientEvent(event);
+      }
+      return;
+   }
+
    // read presentation
    presentation::SlideDeck slideDeck;
    std::string slides, initCommands, slideCommands;
@@ -908,9 +964,10 @@ void handlePresentationRootRequest(const std::string& path,
    if (renderPresentation(vars, filters, previewOutputStream, &errorResponse))
    {
       // set response
+      std::string deckHtml = previewOutputStream.str();
       pResponse->setNoCacheHeaders();
       pResponse->setContentType("text/html");
-      pResponse->setBody(previewOutputStream);
+      pResponse->setBody(deckHtml);
 
       // also save a view in browser version if that path already exists
       // (allows the user to do a simple browser refresh to see changes)
@@ -921,6 +978,12 @@ void handlePresentationRootRequest(const std::string& path,
          if (!savePresentationAsStandalone(viewInBrowserPath, &errorResponse))
             LOG_ERROR_MESSAGE(errorResponse.message);
       }
+
+      // cache the rendered deck (re-fingerprint since knitting the
+      // source may have updated the derived markdown)
+      RenderedDeck& cacheEntry = s_renderedDeckCache[path];
+      cacheEntry.fingerprint = presentationFingerprint();
+      cacheEntry.html = deckHtml;
    }
    else
    {
@@ -710,6 +710,56 @@ Error interruptEngineChunk(const json::JsonRpcRequest& request,
 
 } // anonymous namespace
 
+// executes an R chunk on a worker (Rscript) process rather than in the
+// session's own R process; used for chunks which opt in to parallel
+// execution. output is merged through the chunk cache exactly as for
+// process-based alternate engines, and completion is signalled via
+// onChunkExecCompleted when the worker exits.
+Error executeParallelRChunk(const std::string& docId,
+                            const std::string& chunkId,
+                            const std::string& nbCtxId,
+                            const core::FilePath& workingDir,
+                            const std::string& code,
+                            const ChunkOptions& chunkOptions)
+{
+   // resolve the Rscript binary which hosts the worker
+   FilePath rScript;
+   Error error = module_context::rScriptPath(&rScript);
+   if (error)
+      return error;
+
+   // forward string chunk options as for other process-based engines
+   json::Object jsonChunkOptions = chunkOptions.mergedOptions();
+   std::map<std::string, std::string> options;
+   for (json::Object::const_iterator it = jsonChunkOptions.begin();
+        it != jsonChunkOptions.end();
+        ++it)
+   {
+      if (it->second.type() == json::StringType)
+         options[it->first] = it->second.get_str();
+   }
+
+   // execute the chunk with Rscript
+   options["engine.path"] = rScript.absolutePath();
+
+   // set the working directory while the worker is launched (the worker
+   // inherits it)
+   DirCapture dir;
+   dir.connectDir(docId, workingDir);
+
+   error = runChunk(docId, chunkId, nbCtxId, "r", code, options);
+
+   dir.disconnect();
+
+   return error;
+}
+
+void interruptParallelRChunk(const std::string& docId,
+                             const std::string& chunkId)
+{
+   interruptChunk(docId, chunkId);
+}
+
 Error executeAlternateEngineChunk(const std::string& docId,
                                   const std::string& chunkId,
                                   const std::string& nbCtxId,
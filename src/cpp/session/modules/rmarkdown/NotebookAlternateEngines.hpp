@@ -26,6 +26,16 @@ namespace notebook {
 
 core::Error initAlternateEngines();
 
+core::Error executeParallelRChunk(const std::string& docId,
+                                  const std::string& chunkId,
+                                  const std::string& nbCtxId,
+                                  const core::FilePath& workingDir,
+                                  const std::string& code,
+                                  const ChunkOptions& chunkOptions);
+
+void interruptParallelRChunk(const std::string& docId,
+                             const std::string& chunkId);
+
 core::Error executeAlternateEngineChunk(const std::string& docId,
                                   const std::string& chunkId,
                                   const std::string& nbCtxId,
@@ -23,6 +23,11 @@
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
 #include <session/SessionUserSettings.hpp>
 #include <session/SessionModuleContext.hpp>
 #include <session/SessionSourceDatabase.hpp>
@@ -30,6 +35,8 @@
 #include <core/Algorithm.hpp>
 #include <core/Exec.hpp>
 #include <core/FileSerializer.hpp>
+#include <core/Hash.hpp>
+#include <core/SafeConvert.hpp>
 
 #include <r/RExec.hpp>
 #include <r/RRoutines.hpp>
@@ -51,6 +58,186 @@ namespace rmarkdown {
 namespace notebook {
 namespace {
 
+// ---- content-addressed output deduplication -------------------------------
+//
+// chunk outputs (plots, widget data and assets) are frequently identical
+// across saves and across copies of a document, and letting every saved
+// cache carry its own copy is how notebook caches balloon to gigabytes.
+// saved outputs are instead hard-linked against a shared content-addressed
+// pool under the cache root, so identical outputs occupy disk space once.
+// the link count on a pool entry acts as its reference count: once only the
+// pool's own link remains, the entry is swept (see sweepContentStore).
+//
+// outputs are deduplicated only in the saved context. the saved cache always
+// replaces files by unlinking and re-creating them (never by rewriting in
+// place), so sharing the underlying inode is safe there; uncommitted
+// contexts rewrite chunk outputs during execution and are left alone.
+
+#ifndef _WIN32
+
+// don't bother deduplicating tiny files; the link bookkeeping would cost
+// about as much as the bytes saved
+const uintmax_t kDedupMinFileSize = 4096;
+
+FilePath contentStoreRoot()
+{
+   return notebookCacheRoot().childPath("store");
+}
+
+bool sameContents(const FilePath& a, const FilePath& b)
+{
+   if (a.size() != b.size())
+      return false;
+
+   std::string aContents, bContents;
+   if (core::readStringFromFile(a, &aContents))
+      return false;
+   if (core::readStringFromFile(b, &bContents))
+      return false;
+
+   return aContents == bContents;
+}
+
+void deduplicateFile(const FilePath& file)
+{
+   if (file.size() < kDedupMinFileSize)
+      return;
+
+   std::string contents;
+   Error error = core::readStringFromFile(file, &contents);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   // key entries by hash and size; the hash is fast rather than
+   // cryptographic, so contents are byte-compared before sharing below
+   std::string key = core::hash::fastHexHash(contents) + "-" +
+                     safe_convert::numberToString(file.size());
+   FilePath stored = contentStoreRoot().childPath(key.substr(0, 2))
+                                       .childPath(key);
+
+   if (stored.exists())
+   {
+      // guard against hash collisions
+      if (!sameContents(file, stored))
+         return;
+
+      // already sharing the same inode? nothing to do
+      struct stat fileSt, storedSt;
+      if (::stat(file.absolutePath().c_str(), &fileSt) != 0 ||
+          ::stat(stored.absolutePath().c_str(), &storedSt) != 0)
+         return;
+      if (fileSt.st_ino == storedSt.st_ino)
+         return;
+
+      // atomically replace the file with a link to the stored copy.
+      // failure to deduplicate is benign (the file just keeps its own
+      // copy), so errors here are ignored
+      FilePath tmp(file.absolutePath() + ".dedup");
+      if (::link(stored.absolutePath().c_str(),
+                 tmp.absolutePath().c_str()) != 0)
+         return;
+      if (::rename(tmp.absolutePath().c_str(),
+                   file.absolutePath().c_str()) != 0)
+      {
+         error = tmp.removeIfExists();
+         if (error)
+            LOG_ERROR(error);
+      }
+   }
+   else
+   {
+      // add this file to the pool (a link, so no bytes are copied). a
+      // failed link is benign -- e.g. a filesystem without hard link
+      // support simply operates without sharing
+      error = stored.parent().ensureDirectory();
+      if (error)
+      {
+         LOG_ERROR(error);
+         return;
+      }
+      ::link(file.absolutePath().c_str(), stored.absolutePath().c_str());
+   }
+}
+
+void deduplicateDirectory(const FilePath& dir)
+{
+   std::vector<FilePath> children;
+   Error error = dir.children(&children);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   BOOST_FOREACH(const FilePath& child, children)
+   {
+      if (child.isDirectory())
+         deduplicateDirectory(child);
+      else if (child.filename() != kNotebookChunkDefFilename)
+         deduplicateFile(child);
+   }
+}
+
+// remove pool entries whose only remaining link is the pool's own (i.e.
+// no saved cache references the content any more)
+void sweepContentStore()
+{
+   FilePath store = contentStoreRoot();
+   if (!store.exists())
+      return;
+
+   std::vector<FilePath> shards;
+   Error error = store.children(&shards);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   BOOST_FOREACH(const FilePath& shard, shards)
+   {
+      if (!shard.isDirectory())
+         continue;
+
+      std::vector<FilePath> entries;
+      error = shard.children(&entries);
+      if (error)
+      {
+         LOG_ERROR(error);
+         continue;
+      }
+
+      BOOST_FOREACH(const FilePath& entry, entries)
+      {
+         struct stat st;
+         if (::stat(entry.absolutePath().c_str(), &st) == 0 &&
+             st.st_nlink <= 1)
+         {
+            error = entry.remove();
+            if (error)
+               LOG_ERROR(error);
+         }
+      }
+   }
+}
+
+#else
+
+// hard links aren't reliably available on Windows, so the notebook cache
+// operates without the shared content pool there
+void deduplicateDirectory(const FilePath&)
+{
+}
+
+void sweepContentStore()
+{
+}
+
+#endif
+
 // it's much faster to load a notebook from its cache than it is to rehydrate
 // it from its .Rnb, so we keep it around even if the document is closed (as
 // it's somewhat common to open and close a document periodically over the 
@@ -145,6 +332,31 @@ void cleanUnusedCaches()
          }
       }
    }
+
+   // sweep staged widget libraries which haven't been rendered against in
+   // a while (their write times are freshened on each use); they're cheap
+   // to re-stage on demand
+   FilePath staging = cacheRoot.complete(kLibStagingDir);
+   if (staging.exists())
+   {
+      std::vector<FilePath> staged;
+      error = staging.children(&staged);
+      if (error)
+         LOG_ERROR(error);
+      BOOST_FOREACH(const FilePath& lib, staged)
+      {
+         if ((std::time(NULL) - lib.lastWriteTime()) > kCacheAgeThresholdMs)
+         {
+            error = lib.remove();
+            if (error)
+               LOG_ERROR(error);
+         }
+      }
+   }
+
+   // removing caches may have dropped the last reference to pooled
+   // content; sweep the pool afterwards
+   sweepContentStore();
 }
 
 Error notebookContentMatches(const FilePath& nbPath, const FilePath& rmdPath, 
@@ -292,7 +504,7 @@ void onDocRenamed(const std::string& oldPath,
          return;
    }
 
-   error = oldCacheDir.copyDirectoryRecursive(newCacheDir);
+   error = linkOrCopyDirectoryRecursive(oldCacheDir, newCacheDir);
    if (error)
    {
       LOG_ERROR(error);
@@ -480,6 +692,10 @@ void onDocSaved(FilePath path)
       if (error)
          LOG_ERROR(error);
    }
+
+   // share identical outputs with the content pool (and with other saved
+   // caches referencing the same content)
+   deduplicateDirectory(saved);
 }
 
 FilePath unsavedNotebookCache()
@@ -625,10 +841,49 @@ Error extractRmdFromNotebook(const json::JsonRpcRequest& request,
 } // anonymous namespace
 
 FilePath notebookCacheRoot()
-{ 
+{
    return module_context::sharedScratchPath().childPath("notebooks");
 }
 
+// materialize a copy of a folder using hard links where possible (so e.g.
+// Save As and widget library staging don't duplicate every file on disk),
+// falling back to a real copy when linking isn't supported
+Error linkOrCopyDirectoryRecursive(const FilePath& source,
+                                   const FilePath& target)
+{
+   Error error = target.ensureDirectory();
+   if (error)
+      return error;
+
+   std::vector<FilePath> children;
+   error = source.children(&children);
+   if (error)
+      return error;
+
+   BOOST_FOREACH(const FilePath& child, children)
+   {
+      FilePath to = target.complete(child.filename());
+      if (child.isDirectory())
+      {
+         error = linkOrCopyDirectoryRecursive(child, to);
+      }
+      else
+      {
+#ifndef _WIN32
+         if (::link(child.absolutePath().c_str(),
+                    to.absolutePath().c_str()) == 0)
+            continue;
+#endif
+         error = child.copy(to);
+      }
+
+      if (error)
+         return error;
+   }
+
+   return Success();
+}
+
 FilePath chunkCacheFolder(const FilePath& path, const std::string& docId,
       const std::string& nbCtxId)
 {
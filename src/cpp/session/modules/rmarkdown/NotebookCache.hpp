@@ -51,6 +51,12 @@
 
 #define kSavedCtx "s"
 
+// staging area beneath the cache root for HTML widget library folders
+// (copied once per library version, then hard-linked into chunk library
+// folders; see NotebookHtmlWidgets.cpp). note that the name must not
+// contain "-" so the cache sweep doesn't mistake it for a document cache.
+#define kLibStagingDir "widgetlibs"
+
 #include <string>
 
 namespace rstudio {
@@ -68,6 +74,9 @@ namespace notebook {
 
 core::FilePath notebookCacheRoot();
 
+core::Error linkOrCopyDirectoryRecursive(const core::FilePath& source,
+                                         const core::FilePath& target);
+
 core::FilePath chunkCacheFolder(const std::string& docPath, 
       const std::string& docId, const std::string& nbCtxId);
 
@@ -17,6 +17,8 @@
 #include "NotebookCache.hpp"
 #include "NotebookChunkDefs.hpp"
 
+#include <map>
+
 #include <boost/foreach.hpp>
 
 #include <core/json/Json.hpp>
@@ -40,6 +42,39 @@ namespace rmarkdown {
 namespace notebook {
 namespace {
 
+// cache of parsed chunk definition files, keyed by path and validated
+// against the file's size and write time. chunk metadata is consulted on
+// many notebook operations -- and on every chunk edit, to diff the old
+// definitions against the new ones -- so this keeps those operations from
+// re-reading and re-parsing the sidecar file each time. the file can also
+// be written outside this module (e.g. by cache hydration from a notebook
+// file), which the size/write time validation accounts for.
+struct CachedChunkDefs
+{
+   CachedChunkDefs()
+      : size(0),
+        lastWriteTime(0)
+   {
+   }
+
+   // COPYING: via compiler (copyable members)
+
+   json::Object contents;
+   uintmax_t size;
+   std::time_t lastWriteTime;
+};
+
+std::map<std::string, CachedChunkDefs> s_chunkDefsCache;
+
+void updateChunkDefsCache(const FilePath& defs, const json::Object& contents)
+{
+   CachedChunkDefs entry;
+   entry.contents = contents;
+   entry.size = defs.size();
+   entry.lastWriteTime = defs.lastWriteTime();
+   s_chunkDefsCache[defs.absolutePath()] = entry;
+}
+
 SEXP rs_getRmdWorkingDir(SEXP rmdFileSEXP, SEXP docIdSEXP)
 {
    r::sexp::Protect protect;
@@ -127,7 +162,19 @@ FilePath chunkDefinitionsPath(const std::string& docPath,
 
 Error getChunkJson(const FilePath& defs, json::Object *pJson)
 {
-   // read the defs file 
+   // serve from the cache if the file hasn't changed since we last
+   // parsed it
+   std::map<std::string, CachedChunkDefs>::const_iterator it =
+         s_chunkDefsCache.find(defs.absolutePath());
+   if (it != s_chunkDefsCache.end() &&
+       it->second.size == defs.size() &&
+       it->second.lastWriteTime == defs.lastWriteTime())
+   {
+      *pJson = it->second.contents;
+      return Success();
+   }
+
+   // read the defs file
    std::string contents;
    Error error = readStringFromFile(defs, &contents);
    if (error)
@@ -135,11 +182,12 @@ Error getChunkJson(const FilePath& defs, json::Object *pJson)
 
    // pull out the contents
    json::Value defContents;
-   if (!json::parse(contents, &defContents) || 
+   if (!json::parse(contents, &defContents) ||
        defContents.type() != json::ObjectType)
       return Error(json::errc::ParseError, ERROR_LOCATION);
 
    *pJson = defContents.get_obj();
+   updateChunkDefsCache(defs, *pJson);
 
    return Success();
 }
@@ -210,7 +258,11 @@ Error setChunkDefs(boost::shared_ptr<source_database::SourceDocument> pDoc,
       LOG_ERROR(error);
       return error;
    }
-   
+
+   // we already hold the parsed contents, so refresh the cache rather
+   // than letting the next reader re-parse what we just wrote
+   updateChunkDefsCache(defFile, defContents);
+
    return Success();
 }
 
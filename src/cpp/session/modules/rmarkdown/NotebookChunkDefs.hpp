@@ -38,6 +38,7 @@
 #define kChunkDefaultOptions "default_chunk_options"
 #define kChunkWorkingDir     "working_dir"
 #define kChunkExternals      "external_chunks"
+#define kChunkResultHashes   "chunk_result_hashes"
 
 namespace rstudio {
 namespace session {
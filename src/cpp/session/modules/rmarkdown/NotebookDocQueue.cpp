@@ -18,6 +18,8 @@
 
 #include <boost/foreach.hpp>
 
+#include <core/StringUtils.hpp>
+
 #include <session/SessionModuleContext.hpp>
 #include <session/SessionSourceDatabase.hpp>
 
@@ -327,6 +329,23 @@ std::string NotebookDocQueue::externalChunk(const std::string& label) const
    return code;
 }
 
+std::string NotebookDocQueue::pendingChunkCode(
+      const boost::shared_ptr<NotebookQueueUnit> excludeUnit) const
+{
+   // concatenate the code of the units still in the queue (other than the
+   // given one); used to check whether a chunk can execute out of band
+   // without affecting chunks yet to be executed
+   std::string code;
+   BOOST_FOREACH(const boost::shared_ptr<NotebookQueueUnit> unit, queue_)
+   {
+      if (unit == excludeUnit)
+         continue;
+      code.append(string_utils::wideToUtf8(unit->code()));
+      code.append("\n");
+   }
+   return code;
+}
+
 } // namespace notebook
 } // namespace rmarkdown
 } // namespace modules
@@ -75,6 +75,8 @@ public:
    int remainingUnits() const;
    core::FilePath workingDir() const;
    std::string externalChunk(const std::string& label) const;
+   std::string pendingChunkCode(
+      const boost::shared_ptr<NotebookQueueUnit> excludeUnit) const;
 
 private:
    std::string docId_;
@@ -114,6 +114,11 @@ std::string ChunkExecContext::docId()
    return docId_;
 }
 
+std::string ChunkExecContext::nbCtxId()
+{
+   return nbCtxId_;
+}
+
 const ChunkOptions& ChunkExecContext::options() 
 {
    return options_;
@@ -465,6 +470,11 @@ void ChunkExecContext::disconnect()
 
    NotebookCapture::disconnect();
 
+   // compress any large console output now that the chunk is finished
+   error = finalizeChunkConsoleOutput(docId_, chunkId_, nbCtxId_);
+   if (error)
+      LOG_ERROR(error);
+
    events().onChunkExecCompleted(docId_, chunkId_, nbCtxId_);
 }
 
@@ -58,6 +58,7 @@ public:
    // return execution context from events
    std::string chunkId();
    std::string docId();
+   std::string nbCtxId();
    ExecScope execScope();
    const ChunkOptions& options();
 
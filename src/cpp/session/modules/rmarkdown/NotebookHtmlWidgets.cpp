@@ -15,6 +15,7 @@
 
 #include "SessionRmdNotebook.hpp"
 #include "NotebookHtmlWidgets.hpp"
+#include "NotebookCache.hpp"
 #include "NotebookOutput.hpp"
 
 #include <iostream>
@@ -51,6 +52,54 @@ SEXP rs_recordHtmlWidget(SEXP htmlFileSEXP, SEXP depFileSEXP, SEXP metadata)
    return R_NilValue;
 }
 
+// stages a widget dependency (e.g. the plotly JS library) into a chunk
+// library folder. the first time a given version of a library is seen we
+// copy it into a staging folder beneath the cache root; thereafter we
+// materialize it into chunk library folders with hard links, so rendering
+// a widget doesn't copy a large library tree on every chunk execution
+// (save_html finds the library already in place and leaves it alone).
+SEXP rs_stageWidgetDependency(SEXP nameSEXP, SEXP versionSEXP, SEXP srcSEXP,
+                              SEXP targetSEXP)
+{
+   std::string name = r::sexp::safeAsString(nameSEXP);
+   std::string version = r::sexp::safeAsString(versionSEXP);
+   FilePath sourcePath(r::sexp::safeAsString(srcSEXP));
+   FilePath targetPath(r::sexp::safeAsString(targetSEXP));
+   if (name.empty() || version.empty() ||
+       !sourcePath.isDirectory() || targetPath.exists())
+      return R_NilValue;
+
+   // copy this version of the library into the staging folder if we
+   // haven't seen it before; if staging fails, link (or copy) directly
+   // from the source folder
+   FilePath staged = notebookCacheRoot().complete(kLibStagingDir)
+                                        .complete(name + "-" + version);
+   if (!staged.exists())
+   {
+      Error error = sourcePath.copyDirectoryRecursive(staged);
+      if (error)
+      {
+         LOG_ERROR(error);
+         Error removeError = staged.removeIfExists();
+         if (removeError)
+            LOG_ERROR(removeError);
+         staged = sourcePath;
+      }
+   }
+   else
+   {
+      // freshen the staged copy so the periodic cache sweep can see that
+      // it's still in use
+      staged.setLastWriteTime();
+   }
+
+   Error error = linkOrCopyDirectoryRecursive(staged, targetPath);
+   if (error)
+      LOG_ERROR(error);
+
+   return R_NilValue;
+}
+
 bool copyLibFile(const FilePath& from, const FilePath& to,
       const FilePath& path)
 {
@@ -103,6 +152,7 @@ core::Error HtmlCapture::connectHtmlCapture(
 core::Error initHtmlWidgets()
 {
    RS_REGISTER_CALL_METHOD(rs_recordHtmlWidget, 3);
+   RS_REGISTER_CALL_METHOD(rs_stageWidgetDependency, 4);
 
    ExecBlock initBlock;
    initBlock.addFunctions()
@@ -18,6 +18,7 @@
 #include "NotebookOutput.hpp"
 #include "NotebookPlots.hpp"
 
+#include <boost/cstdint.hpp>
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
 #include <boost/algorithm/string.hpp>
@@ -30,6 +31,7 @@
 #include <core/SafeConvert.hpp>
 #include <session/SessionUserSettings.hpp>
 #include <core/StringUtils.hpp>
+#include <core/http/Compression.hpp>
 #include <core/json/Json.hpp>
 #include <core/text/CsvParser.hpp>
 
@@ -49,6 +51,18 @@
 #define MAX_ORDINAL        16777215
 #define OUTPUT_THRESHOLD   25
 
+// caps on the console output stored for a single chunk: the first
+// MAX_CONSOLE_HEAD_BYTES are kept in the output file itself, the most
+// recent MAX_CONSOLE_TAIL_BYTES are kept in a bounded sidecar, and the
+// bytes dropped in between are counted so the replay can note the
+// elision (chunks printing e.g. large data frames otherwise bloat the
+// cache without bound)
+#define MAX_CONSOLE_HEAD_BYTES (256 * 1024)
+#define MAX_CONSOLE_TAIL_BYTES (64 * 1024)
+
+// compress finalized console output files larger than this
+#define COMPRESS_THRESHOLD     (16 * 1024)
+
 using namespace rstudio::core;
 
 namespace rstudio {
@@ -99,21 +113,77 @@ std::string chunkOutputExt(ChunkOutputType outputType)
    return "";
 }
 
-Error chunkConsoleContents(const FilePath& consoleFile, json::Array* pArray)
+// sidecar files holding the overflow portion of a chunk's console
+// output; these use extensions unknown to chunkOutputType so output
+// enumeration skips them
+FilePath consoleTailPath(const FilePath& consoleFile)
 {
-   std::string contents;
-   Error error = readStringFromFile(consoleFile, &contents);
+   return consoleFile.parent().complete(consoleFile.stem() + ".tail");
+}
+
+FilePath consoleElidedPath(const FilePath& consoleFile)
+{
+   return consoleFile.parent().complete(consoleFile.stem() + ".elided");
+}
+
+bool isGzipCompressed(const std::string& contents)
+{
+   // gzip magic bytes
+   return contents.size() >= 2 &&
+          static_cast<unsigned char>(contents[0]) == 0x1f &&
+          static_cast<unsigned char>(contents[1]) == 0x8b;
+}
+
+// reads a console output file, inflating it if it was compressed when
+// the chunk finished executing
+Error readConsoleFile(const FilePath& consoleFile, std::string* pContents)
+{
+   Error error = readStringFromFile(consoleFile, pContents);
    if (error)
       return error;
 
-   // parse each line of the CSV file
-   std::pair<std::vector<std::string>, std::string::iterator> line;
+   if (isGzipCompressed(*pContents))
+   {
+      std::string inflated;
+      error = core::http::compression::gzipDecompress(*pContents, &inflated);
+      if (error)
+         return error;
+      *pContents = inflated;
+   }
+
+   return Success();
+}
+
+// returns the number of console output bytes elided from the given
+// console file (0 if none were)
+boost::int64_t elidedByteCount(const FilePath& consoleFile)
+{
+   FilePath elidedPath = consoleElidedPath(consoleFile);
+   if (!elidedPath.exists())
+      return 0;
+
+   std::string contents;
+   Error error = readStringFromFile(elidedPath, &contents);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return 0;
+   }
+
+   boost::algorithm::trim(contents);
+   return safe_convert::stringTo<boost::int64_t>(contents, 0);
+}
+
+void appendConsoleRecords(const std::string& contents, json::Array* pArray)
+{
+   // parse each line of the CSV data
+   std::pair<std::vector<std::string>, std::string::const_iterator> line;
    line = text::parseCsvLine(contents.begin(), contents.end());
    while (!line.first.empty())
    {
       if (line.first.size() > 1)
       {
-         int outputType = safe_convert::stringTo<int>(line.first[0], 
+         int outputType = safe_convert::stringTo<int>(line.first[0],
                kChunkConsoleOutput);
 
          // don't emit input data to the client
@@ -128,6 +198,38 @@ Error chunkConsoleContents(const FilePath& consoleFile, json::Array* pArray)
       // read next line
       line = text::parseCsvLine(line.second, contents.end());
    }
+}
+
+Error chunkConsoleContents(const FilePath& consoleFile, json::Array* pArray)
+{
+   std::string contents;
+   Error error = readConsoleFile(consoleFile, &contents);
+   if (error)
+      return error;
+
+   appendConsoleRecords(contents, pArray);
+
+   // emit any overflow: a marker describing the output elided between
+   // the head and the tail, followed by the retained tail itself
+   FilePath tailPath = consoleTailPath(consoleFile);
+   if (tailPath.exists())
+   {
+      boost::int64_t elided = elidedByteCount(consoleFile);
+      if (elided > 0)
+      {
+         json::Array marker;
+         marker.push_back(kChunkConsoleOutput);
+         marker.push_back("\n... " +
+               safe_convert::numberToString(elided) +
+               " bytes of output elided ...\n\n");
+         pArray->push_back(marker);
+      }
+
+      error = readConsoleFile(tailPath, &contents);
+      if (error)
+         return error;
+      appendConsoleRecords(contents, pArray);
+   }
 
    return Success();
 }
@@ -573,22 +675,96 @@ core::Error cleanChunkOutput(const std::string& docId,
    return Success();
 }
 
+namespace {
+
+// appends encoded console data to the bounded tail sidecar, trimming
+// the sidecar back to its budget (on CSV record boundaries) and
+// recording the number of bytes dropped
+Error appendConsoleTail(const FilePath& consolePath, const std::string& encoded)
+{
+   FilePath tailPath = consoleTailPath(consolePath);
+   Error error = writeStringToFile(
+            tailPath,
+            encoded,
+            string_utils::LineEndingPassthrough,
+            false /*truncate*/);
+   if (error)
+      return error;
+
+   if (tailPath.size() <= MAX_CONSOLE_TAIL_BYTES)
+      return Success();
+
+   std::string contents;
+   error = readStringFromFile(tailPath, &contents);
+   if (error)
+      return error;
+
+   // drop whole records from the front until the tail fits its budget
+   std::size_t dropped = 0;
+   std::pair<std::vector<std::string>, std::string::const_iterator> line;
+   line = text::parseCsvLine(contents.cbegin(), contents.cend());
+   while (!line.first.empty() &&
+          (contents.size() - dropped) > MAX_CONSOLE_TAIL_BYTES)
+   {
+      dropped = line.second - contents.cbegin();
+      line = text::parseCsvLine(line.second, contents.cend());
+   }
+
+   if (dropped == 0)
+      return Success();
+
+   error = writeStringToFile(
+            tailPath,
+            contents.substr(dropped),
+            string_utils::LineEndingPassthrough);
+   if (error)
+      return error;
+
+   // accumulate the dropped bytes into the elision counter
+   boost::int64_t elided = elidedByteCount(consolePath) +
+                           static_cast<boost::int64_t>(dropped);
+   return writeStringToFile(
+            consoleElidedPath(consolePath),
+            safe_convert::numberToString(elided));
+}
+
+} // anonymous namespace
+
 core::Error writeConsoleOutput(int chunkConsoleType,
                                const std::string& output,
                                const core::FilePath& targetPath,
                                bool truncate)
 {
    Error error;
-   
+
    error = targetPath.parent().ensureDirectory();
    if (error)
       return error;
-   
+
    std::vector<std::string> data;
    data.push_back(safe_convert::numberToString(chunkConsoleType));
    data.push_back(output);
-   
+
    std::string encoded = text::encodeCsvLine(data) + "\n";
+
+   if (truncate)
+   {
+      // starting over; remove any overflow left by a previous execution
+      Error removeError = consoleTailPath(targetPath).removeIfExists();
+      if (removeError)
+         LOG_ERROR(removeError);
+      removeError = consoleElidedPath(targetPath).removeIfExists();
+      if (removeError)
+         LOG_ERROR(removeError);
+   }
+   else if (targetPath.exists() &&
+            targetPath.size() >= MAX_CONSOLE_HEAD_BYTES)
+   {
+      // the head of the output is full; keep only the most recent
+      // output (in the bounded tail sidecar) from here on
+      return appendConsoleTail(targetPath, encoded);
+   }
+
    error = writeStringToFile(
             targetPath,
             encoded,
@@ -608,6 +784,65 @@ core::Error appendConsoleOutput(int chunkConsoleOutputType,
             false);
 }
 
+core::Error finalizeChunkConsoleOutput(const std::string& docId,
+                                       const std::string& chunkId,
+                                       const std::string& nbCtxId)
+{
+#ifndef _WIN32
+   FilePath outputPath = chunkOutputPath(docId, chunkId, nbCtxId,
+         ContextExact);
+   if (!outputPath.exists())
+      return Success();
+
+   std::vector<FilePath> outputPaths;
+   Error error = outputPath.children(&outputPaths);
+   if (error)
+      return error;
+
+   // compress console output files large enough to be worth the trip
+   // through gzip; readers inflate the contents transparently (the tail
+   // sidecars are left alone since they're already tightly bounded)
+   BOOST_FOREACH(const FilePath& path, outputPaths)
+   {
+      if (chunkOutputType(path) != ChunkOutputText ||
+          path.size() < COMPRESS_THRESHOLD)
+         continue;
+
+      std::string contents;
+      error = readStringFromFile(path, &contents);
+      if (error)
+      {
+         LOG_ERROR(error);
+         continue;
+      }
+
+      // don't compress twice
+      if (isGzipCompressed(contents))
+         continue;
+
+      std::string compressed;
+      error = core::http::compression::gzipCompress(contents, &compressed);
+      if (error)
+      {
+         LOG_ERROR(error);
+         continue;
+      }
+
+      // only worthwhile if compression actually shrank the file
+      if (compressed.size() >= contents.size())
+         continue;
+
+      error = writeStringToFile(
+               path,
+               compressed,
+               string_utils::LineEndingPassthrough);
+      if (error)
+         LOG_ERROR(error);
+   }
+#endif
+   return Success();
+}
+
 Error initOutput()
 {
    ExecBlock initBlock;
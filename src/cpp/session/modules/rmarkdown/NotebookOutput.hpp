@@ -123,6 +123,12 @@ core::Error writeConsoleOutput(int chunkConsoleOutputType,
                                const core::FilePath& filePath,
                                bool truncate);
 
+// called when a chunk finishes executing; compresses large console
+// output files in the chunk's cache folder
+core::Error finalizeChunkConsoleOutput(const std::string& docId,
+                                       const std::string& chunkId,
+                                       const std::string& nbCtxId);
+
 
 // send chunk output to client
 void enqueueChunkOutput(const std::string& docId,
@@ -27,11 +27,17 @@
 #include "NotebookExec.hpp"
 #include "NotebookDocQueue.hpp"
 #include "NotebookCache.hpp"
+#include "NotebookOutput.hpp"
 #include "NotebookAlternateEngines.hpp"
 #include "NotebookChunkOptions.hpp"
 
+#include <set>
+#include <utility>
+
 #include <boost/foreach.hpp>
 
+#include <core/StringUtils.hpp>
+
 #include <r/RCntxtUtils.hpp>
 #include <r/RInterface.hpp>
 #include <r/RExec.hpp>
@@ -39,6 +45,7 @@
 #include <r/RSexp.hpp>
 
 #include <core/Exec.hpp>
+#include <core/Hash.hpp>
 #include <core/Thread.hpp>
 
 #include <session/SessionModuleContext.hpp>
@@ -48,6 +55,10 @@
 
 #define kThreadQuitCommand "thread_quit"
 
+// file (in the chunk's output folder) holding the objects assigned by a
+// cache=TRUE chunk, so they can be restored when the chunk is replayed
+#define kChunkObjectsFile "objects.rdata"
+
 using namespace rstudio::core;
 
 namespace rstudio {
@@ -64,6 +75,10 @@ enum ChunkExecState
    ChunkExecCancelled = 2
 };
 
+// maximum number of worker (Rscript) processes used for chunks marked
+// for parallel execution
+const std::size_t kMaxParallelChunks = 4;
+
 // represents the global queue of work 
 class NotebookQueue : boost::noncopyable
 {
@@ -95,7 +110,7 @@ public:
 
    bool complete()
    {
-      return queue_.empty();
+      return queue_.empty() && parallelChunks_.empty();
    }
 
    Error process(ExpressionMode mode)
@@ -143,6 +158,14 @@ public:
                execContext_->onExprComplete();
             }
 
+            // record the result hash for chunks marked cache=TRUE so
+            // unchanged chunks can be replayed from the cache next run
+            if (!incomplete && execContext_ && !execContext_->hasErrors())
+            {
+               saveChunkResultHash(execUnit_, execContext_->options(),
+                     execContext_->nbCtxId());
+            }
+
             // unit has finished executing; remove it from the queue
             popUnit(execUnit_);
 
@@ -199,6 +222,13 @@ public:
 
    void clear()
    {
+      // stop any chunks executing on worker processes
+      BOOST_FOREACH(const ParallelChunks::value_type& chunk, parallelChunks_)
+      {
+         interruptParallelRChunk(chunk.first, chunk.second);
+      }
+      parallelChunks_.clear();
+
       // clean up any active execution context
       if (execContext_)
          execContext_->disconnect();
@@ -229,9 +259,23 @@ public:
 
 private:
 
-   void onChunkExecCompleted(const std::string& docId, 
+   void onChunkExecCompleted(const std::string& docId,
          const std::string& chunkId, const std::string& nbCtxId)
    {
+      // if this chunk was executing on a worker process, mark it complete
+      // and resume the queue in case it was waiting on the worker pool
+      ParallelChunks::iterator it = parallelChunks_.find(
+            std::make_pair(docId, chunkId));
+      if (it != parallelChunks_.end())
+      {
+         parallelChunks_.erase(it);
+         enqueueExecStateChanged(ChunkExecFinished, json::Object(),
+               docId, chunkId);
+         if (!execUnit_)
+            process(ExprModeNew);
+         return;
+      }
+
       if (!execUnit_)
          return;
 
@@ -401,6 +445,73 @@ private:
       if (engine == "R")
          engine = "r";
 
+      // chunks marked with cache=TRUE whose code and options are
+      // unchanged since they last executed can be satisfied from the
+      // notebook cache: their saved output is replayed and the objects
+      // they assigned restored, in lieu of execution
+      if (engine == "r" &&
+          unit->execScope() == ExecScopeChunk &&
+          unit->execMode() == ExecModeBatch &&
+          label != "setup" &&
+          options.getOverlayOption("cache", false) &&
+          replayChunkFromCache(unit, options, ctx))
+      {
+         popUnit(unit);
+         return executeNextUnit(mode);
+      }
+
+      // batch-mode R chunks marked with parallel=TRUE may execute on a
+      // worker process while the queue continues, as long as a conservative
+      // dependency check shows they don't exchange objects with the session
+      // or with chunks still in the queue (worker chunks see neither the
+      // session's global environment nor each other's)
+      if (engine == "r" &&
+          unit->execScope() == ExecScopeChunk &&
+          unit->execMode() == ExecModeBatch &&
+          label != "setup" &&
+          options.getOverlayOption("parallel", false) &&
+          chunkIsParallelSafe(docQueue, unit))
+      {
+         // defer if all worker slots are in use (scheduling resumes when a
+         // worker completes)
+         if (parallelChunks_.size() >= kMaxParallelChunks)
+            return Success();
+
+         std::string innerCode;
+         error = unit->innerCode(&innerCode);
+         if (error)
+         {
+            // fall back to executing the chunk in the session
+            LOG_ERROR(error);
+         }
+         else
+         {
+            popUnit(unit);
+            enqueueExecStateChanged(ChunkExecStarted, options.chunkOptions(),
+                  unit->docId(), unit->chunkId());
+            parallelChunks_.insert(
+                  std::make_pair(unit->docId(), unit->chunkId()));
+            error = executeParallelRChunk(unit->docId(), unit->chunkId(), ctx,
+                  docQueue->workingDir(), innerCode, options);
+            if (error)
+            {
+               LOG_ERROR(error);
+               parallelChunks_.erase(
+                     std::make_pair(unit->docId(), unit->chunkId()));
+               enqueueExecStateChanged(ChunkExecFinished, json::Object(),
+                     unit->docId(), unit->chunkId());
+            }
+
+            // continue scheduling subsequent chunks
+            return executeNextUnit(mode);
+         }
+      }
+
+      // chunks executing below share the session's R state, so wait for any
+      // outstanding worker chunks to finish first
+      if (!parallelChunks_.empty())
+         return Success();
+
       if (engine == "r")
       {
          // establish execution context unless we're an inline chunk
@@ -490,12 +601,147 @@ private:
       }
    }
 
-   void enqueueExecStateChanged(ChunkExecState state, 
+   // computes a hash identifying a chunk's code and options; used to
+   // decide whether its cached results can be replayed in place of
+   // execution
+   std::string chunkResultHash(boost::shared_ptr<NotebookQueueUnit> unit,
+                               const ChunkOptions& options)
+   {
+      std::ostringstream ostr;
+      json::write(options.mergedOptions(), ostr);
+      return hash::crc32HexHash(
+            string_utils::wideToUtf8(unit->code()) + ostr.str());
+   }
+
+   // attempts to satisfy a cache=TRUE chunk from the notebook cache;
+   // returns true if the chunk's saved output was replayed (and the
+   // objects it assigned restored) in place of execution
+   bool replayChunkFromCache(boost::shared_ptr<NotebookQueueUnit> unit,
+                             const ChunkOptions& options,
+                             const std::string& ctx)
+   {
+      std::string docPath;
+      source_database::getPath(unit->docId(), &docPath);
+
+      // look up the hash recorded when the chunk last executed
+      json::Object hashes;
+      Error error = getChunkValue(docPath, unit->docId(), kChunkResultHashes,
+            &hashes);
+      if (error)
+         return false;
+      json::Object::const_iterator it = hashes.find(unit->chunkId());
+      if (it == hashes.end() || it->second.type() != json::StringType)
+         return false;
+      if (it->second.get_str() != chunkResultHash(unit, options))
+         return false;
+
+      // restore the objects the chunk assigned when it last executed;
+      // without them downstream chunks would see stale state, so treat
+      // failure as a cache miss
+      FilePath objectsFile = chunkOutputPath(unit->docId(), unit->chunkId(),
+            ctx, ContextExact).complete(kChunkObjectsFile);
+      if (objectsFile.exists())
+      {
+         error = r::exec::RFunction(".rs.notebookRestoreChunkObjects")
+               .addParam(string_utils::utf8ToSystem(
+                     objectsFile.absolutePath()))
+               .call();
+         if (error)
+         {
+            LOG_ERROR(error);
+            return false;
+         }
+      }
+
+      // replay the chunk's saved output in place of execution
+      enqueueExecStateChanged(ChunkExecStarted, options.chunkOptions(),
+            unit->docId(), unit->chunkId());
+      error = enqueueChunkOutput(docPath, unit->docId(), unit->chunkId(),
+            ctx, "");
+      if (error)
+         LOG_ERROR(error);
+      enqueueExecStateChanged(ChunkExecFinished, options.chunkOptions(),
+            unit->docId(), unit->chunkId());
+
+      return true;
+   }
+
+   // records the result hash of a completed cache=TRUE chunk, along with
+   // the objects its code assigned, so an unchanged chunk can be
+   // satisfied from the cache on the next run
+   void saveChunkResultHash(boost::shared_ptr<NotebookQueueUnit> unit,
+                            const ChunkOptions& options,
+                            const std::string& nbCtxId)
+   {
+      if (unit->execScope() != ExecScopeChunk ||
+          !options.getOverlayOption("cache", false))
+         return;
+
+      std::string docPath;
+      source_database::getPath(unit->docId(), &docPath);
+
+      // save the objects assigned by the chunk next to its output (replay
+      // must restore them for the benefit of downstream chunks)
+      FilePath objectsFile = chunkOutputPath(unit->docId(), unit->chunkId(),
+            nbCtxId, ContextExact).complete(kChunkObjectsFile);
+      Error error = r::exec::RFunction(".rs.notebookSaveChunkObjects")
+            .addParam(string_utils::wideToUtf8(unit->code()))
+            .addParam(string_utils::utf8ToSystem(objectsFile.absolutePath()))
+            .call();
+      if (error)
+      {
+         // without the objects the cached result can't be reused safely
+         LOG_ERROR(error);
+         return;
+      }
+
+      json::Object hashes;
+      error = getChunkValue(docPath, unit->docId(), kChunkResultHashes,
+            &hashes);
+      if (error)
+         LOG_ERROR(error);
+      hashes[unit->chunkId()] = chunkResultHash(unit, options);
+      error = setChunkValue(docPath, unit->docId(), kChunkResultHashes,
+            hashes);
+      if (error)
+         LOG_ERROR(error);
+   }
+
+   // determines whether it's safe to execute a chunk on a worker process:
+   // the chunk must not read objects from the session (workers start with
+   // an empty global environment) and must not assign objects read by
+   // chunks still in the queue (assignments made on a worker are not
+   // visible to the session)
+   bool chunkIsParallelSafe(boost::shared_ptr<NotebookDocQueue> docQueue,
+                            boost::shared_ptr<NotebookQueueUnit> unit)
+   {
+      std::vector<std::string> conflicts;
+      Error error = r::exec::RFunction(".rs.notebookParallelConflicts")
+            .addParam(string_utils::wideToUtf8(unit->code()))
+            .addParam(docQueue->pendingChunkCode(unit))
+            .call(&conflicts);
+      if (error)
+      {
+         LOG_ERROR(error);
+         return false;
+      }
+      return conflicts.empty();
+   }
+
+   void enqueueExecStateChanged(ChunkExecState state,
          const json::Object& options)
+   {
+      enqueueExecStateChanged(state, options, execUnit_->docId(),
+            execUnit_->chunkId());
+   }
+
+   void enqueueExecStateChanged(ChunkExecState state,
+         const json::Object& options, const std::string& docId,
+         const std::string& chunkId)
    {
       json::Object event;
-      event["doc_id"]     = execUnit_->docId();
-      event["chunk_id"]   = execUnit_->chunkId();
+      event["doc_id"]     = docId;
+      event["chunk_id"]   = chunkId;
       event["exec_state"] = state;
       event["options"]    = options;
       module_context::enqueClientEvent(ClientEvent(
@@ -651,6 +897,10 @@ private:
    boost::shared_ptr<NotebookQueueUnit> execUnit_;
    boost::shared_ptr<ChunkExecContext> execContext_;
 
+   // the doc/chunk IDs of chunks currently executing on worker processes
+   typedef std::set<std::pair<std::string, std::string> > ParallelChunks;
+   ParallelChunks parallelChunks_;
+
    // registered signal handlers
    std::vector<boost::signals::connection> handlers_;
 
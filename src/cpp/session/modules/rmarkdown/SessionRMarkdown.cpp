@@ -59,6 +59,12 @@
 #define kStandardRenderFunc "rmarkdown::render"
 #define kShinyRenderFunc "rmarkdown::run"
 
+// preload applied to pre-warmed render workers so the first knit doesn't
+// pay the rmarkdown/knitr load time (see warmAsyncRProcess)
+#define kRenderPreload \
+   "invisible(suppressPackageStartupMessages(" \
+   "requireNamespace('rmarkdown', quietly = TRUE)))"
+
 #define kShinyContentWarning "Warning: Shiny application in a static R Markdown document"
 
 using namespace rstudio::core;
@@ -82,6 +88,13 @@ std::string projectBuildDir()
 
 std::string s_websiteOutputDir;
 
+void warmRenderWorker()
+{
+   // pre-warm a worker with rmarkdown loaded so the first knit of the
+   // session starts instantly
+   async_r::warmAsyncRProcess(async_r::R_PROCESS_NO_RDATA, kRenderPreload);
+}
+
 void initWebsiteOutputDir()
 {
    if (!module_context::isWebsiteProject())
@@ -434,9 +447,13 @@ private:
             onRenderOutput(module_context::kCompileOutputNormal, "==> " + cmd + "\n");
          }
 
-         // start the render process
+         // start the render process (on a pre-warmed rmarkdown worker when
+         // one is available)
          async_r::AsyncRProcess::start(cmd.c_str(), environment, working,
-                                       async_r::R_PROCESS_NO_RDATA);
+                                       async_r::R_PROCESS_NO_RDATA,
+                                       std::vector<core::FilePath>(),
+                                       std::string(),
+                                       kRenderPreload);
       }
       else
       {
@@ -1322,6 +1339,8 @@ Error initialize()
 
    module_context::events().onDeferredInit.connect(
                                  boost::bind(initWebsiteOutputDir));
+   module_context::events().onDeferredInit.connect(
+                                 boost::bind(warmRenderWorker));
    module_context::events().onDetectSourceExtendedType
                                         .connect(onDetectRmdSourceType);
    module_context::events().onClientInit.connect(onClientInit);
@@ -29,8 +29,10 @@
 
 #include <iostream>
 
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
+#include <boost/make_shared.hpp>
 
 #include <r/RJson.hpp>
 #include <r/RExec.hpp>
@@ -63,35 +65,70 @@ namespace {
 std::string s_activeConsole;
 boost::shared_ptr<ChunkExecContext> s_execContext;
 
+void enqueueReplayFinished(const std::string& docId,
+      const std::string& requestId, const std::string& chunkId)
+{
+   json::Object result;
+   result["doc_id"] = docId;
+   result["request_id"] = requestId;
+   result["chunk_id"] = chunkId;
+   result["type"] = kFinishedReplay;
+   ClientEvent event(client_events::kChunkOutputFinished, result);
+   module_context::enqueClientEvent(event);
+}
+
+// replays the cached output of a single chunk per unit of work; used to
+// stream chunk outputs to the client incrementally rather than reading
+// and enqueuing every chunk's output in one pass
+bool replayNextChunkOutput(const std::string& docPath, const std::string& docId,
+      const std::string& requestId,
+      boost::shared_ptr<std::vector<std::string> > pChunkIds)
+{
+   if (!pChunkIds->empty())
+   {
+      std::string chunkId = pChunkIds->front();
+      pChunkIds->erase(pChunkIds->begin());
+      enqueueChunkOutput(docPath, docId, chunkId, notebookCtxId(), requestId);
+   }
+
+   // more chunks to replay?
+   if (!pChunkIds->empty())
+      return true;
+
+   // all chunks replayed; tell the client the replay is complete
+   enqueueReplayFinished(docId, requestId, "");
+   return false;
+}
+
 void replayChunkOutputs(const std::string& docPath, const std::string& docId,
       const std::string& requestId, const std::string& singleChunkId,
-      const json::Array& chunkOutputs) 
+      const json::Array& chunkOutputs)
 {
    std::vector<std::string> chunkIds;
    extractChunkIds(chunkOutputs, &chunkIds);
 
    if (singleChunkId.empty())
    {
-      // find all the chunks and play them back to the client
-      BOOST_FOREACH(const std::string& chunkId, chunkIds)
-      {
-         enqueueChunkOutput(docPath, docId, chunkId, notebookCtxId(), requestId);
-      }
+      // play all the chunks back to the client incrementally so that
+      // documents with heavy cached output don't stall the session while
+      // their outputs load
+      boost::shared_ptr<std::vector<std::string> > pChunkIds =
+            boost::make_shared<std::vector<std::string> >(chunkIds);
+      module_context::scheduleIncrementalWork(
+               "replay chunk outputs",
+               boost::posix_time::milliseconds(100),
+               boost::posix_time::milliseconds(25),
+               boost::bind(replayNextChunkOutput, docPath, docId, requestId,
+                           pChunkIds),
+               false /* the client is waiting; replay even when non-idle */);
    }
    else
    {
       // play back a specific chunk
-      enqueueChunkOutput(docPath, docId, singleChunkId, notebookCtxId(), 
+      enqueueChunkOutput(docPath, docId, singleChunkId, notebookCtxId(),
             requestId);
+      enqueueReplayFinished(docId, requestId, singleChunkId);
    }
-
-   json::Object result;
-   result["doc_id"] = docId;
-   result["request_id"] = requestId;
-   result["chunk_id"] = singleChunkId.empty() ? "" : singleChunkId;
-   result["type"] = kFinishedReplay;
-   ClientEvent event(client_events::kChunkOutputFinished, result);
-   module_context::enqueClientEvent(event);
 }
 
 // called by the client to inject output into a recently opened document 
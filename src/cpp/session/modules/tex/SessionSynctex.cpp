@@ -15,6 +15,8 @@
 
 #include "SessionSynctex.hpp"
 
+#include <boost/shared_ptr.hpp>
+
 #include <core/Error.hpp>
 #include <core/FilePath.hpp>
 #include <core/Exec.hpp>
@@ -38,6 +40,50 @@ namespace synctex {
 
 namespace {
 
+// cached parsed synctex scanner -- parsing a large .synctex file is by
+// far the dominant cost of a forward/inverse search, so keep the parsed
+// representation between lookups and re-parse only when the synctex
+// file changes on disk
+boost::shared_ptr<core::tex::Synctex> s_pSynctex;
+FilePath s_synctexPdfPath;
+std::time_t s_synctexModified = 0;
+
+std::time_t synctexLastWriteTime(const FilePath& pdfPath)
+{
+   FilePath synctexPath = pdfPath.parent().childPath(
+                                             pdfPath.stem() + ".synctex");
+   if (!synctexPath.exists())
+   {
+      synctexPath = pdfPath.parent().childPath(
+                                             pdfPath.stem() + ".synctex.gz");
+   }
+   if (!synctexPath.exists())
+      return 0;
+
+   return synctexPath.lastWriteTime();
+}
+
+boost::shared_ptr<core::tex::Synctex> synctexForPdf(const FilePath& pdfPath)
+{
+   std::time_t modified = synctexLastWriteTime(pdfPath);
+   if (s_pSynctex &&
+       s_synctexPdfPath == pdfPath &&
+       modified != 0 &&
+       modified == s_synctexModified)
+   {
+      return s_pSynctex;
+   }
+
+   boost::shared_ptr<core::tex::Synctex> pSynctex(new core::tex::Synctex());
+   if (!pSynctex->parse(pdfPath))
+      return boost::shared_ptr<core::tex::Synctex>();
+
+   s_pSynctex = pSynctex;
+   s_synctexPdfPath = pdfPath;
+   s_synctexModified = modified;
+   return pSynctex;
+}
+
 json::Value toJson(const FilePath& pdfFile,
                    const core::tex::PdfLocation& pdfLoc,
                    bool fromClick)
@@ -245,8 +291,8 @@ Error synctexInverseSearch(const json::JsonRpcRequest& request,
       return error;
    FilePath pdfPath = module_context::resolveAliasedPath(file);
 
-   core::tex::Synctex synctex;
-   if (synctex.parse(pdfPath))
+   boost::shared_ptr<core::tex::Synctex> pSynctex = synctexForPdf(pdfPath);
+   if (pSynctex)
    {
       if (!fromClick)
       {
@@ -254,7 +300,7 @@ Error synctexInverseSearch(const json::JsonRpcRequest& request,
          // the passed x and y coordinates since they represent the
          // top of the user-visible content (in case the page is
          // scrolled down from the top)
-         core::tex::PdfLocation contLoc = synctex.topOfPageContent(page);
+         core::tex::PdfLocation contLoc = pSynctex->topOfPageContent(page);
          x = std::max(static_cast<float>(x), contLoc.x());
          y = std::max(static_cast<float>(y), contLoc.y());
       }
@@ -263,7 +309,7 @@ Error synctexInverseSearch(const json::JsonRpcRequest& request,
             static_cast<float>(x), static_cast<float>(y),
             static_cast<float>(width), static_cast<float>(height));
 
-      core::tex::SourceLocation srcLoc = synctex.inverseSearch(pdfLocation);
+      core::tex::SourceLocation srcLoc = pSynctex->inverseSearch(pdfLocation);
       applyInverseConcordance(&srcLoc);
 
       pResponse->setResult(toJson(srcLoc));
@@ -326,13 +372,13 @@ Error forwardSearch(const FilePath& rootFile,
    // determine pdf
    FilePath pdfFile = rootFile.parent().complete(rootFile.stem() + ".pdf");
 
-   core::tex::Synctex synctex;
-   if (synctex.parse(pdfFile))
+   boost::shared_ptr<core::tex::Synctex> pSynctex = synctexForPdf(pdfFile);
+   if (pSynctex)
    {
       core::tex::SourceLocation srcLoc(inputFile, line, column);
       applyForwardConcordance(rootFile, &srcLoc);
 
-      core::tex::PdfLocation pdfLoc = synctex.forwardSearch(srcLoc);
+      core::tex::PdfLocation pdfLoc = pSynctex->forwardSearch(srcLoc);
       *pPdfLocation = toJson(pdfFile, pdfLoc, fromClick);
    }
    else
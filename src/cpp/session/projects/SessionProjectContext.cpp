@@ -490,6 +490,32 @@ void ProjectContext::subscribeToFileMonitor(const std::string& featureName,
       onMonitoringDisabled_.connect(cb.onMonitoringDisabled);
 }
 
+r_util::RProjectConfigDiff ProjectContext::setConfig(
+                                    const r_util::RProjectConfig& config)
+{
+   // compute the delta from the current config so that we (and our
+   // subscribers) only redo the work dependent on what actually changed
+   r_util::RProjectConfigDiff diff = r_util::computeConfigDiff(config_,
+                                                               config);
+   config_ = config;
+   if (!diff.any)
+      return diff;
+
+   if (diff.editor)
+      updateDefaultEncoding();
+
+   if (diff.build)
+   {
+      updateBuildTargetPath();
+      updatePackageInfo();
+   }
+
+   // fire scoped change notification
+   onConfigChanged_(diff);
+
+   return diff;
+}
+
 std::string ProjectContext::defaultEncoding() const
 {
    return defaultEncoding_;
@@ -447,17 +447,22 @@ json::Object projectBuildContextJson()
    return contextJson;
 }
 
-void setProjectConfig(const r_util::RProjectConfig& config)
+r_util::RProjectConfigDiff setProjectConfig(
+                                    const r_util::RProjectConfig& config)
 {
-   // set it
-   s_projectContext.setConfig(config);
+   // set it (computes the delta from the current config and scopes
+   // dependent recomputation and change notifications to it)
+   r_util::RProjectConfigDiff diff = s_projectContext.setConfig(config);
 
-   // sync underlying R setting
-   module_context::syncRSaveAction();
+   // sync underlying R setting when workspace behavior changed
+   if (diff.workspace)
+      module_context::syncRSaveAction();
+
+   return diff;
 }
 
 
-void syncProjectFileChanges()
+r_util::RProjectConfigDiff syncProjectFileChanges()
 {
    // read project file config
    bool providedDefaults;
@@ -472,11 +477,11 @@ void syncProjectFileChanges()
    if (error)
    {
       LOG_ERROR(error);
-      return;
+      return r_util::RProjectConfigDiff();
    }
 
    // set config
-   setProjectConfig(config);
+   return setProjectConfig(config);
 }
 
 
@@ -700,14 +705,19 @@ void onFilesChanged(const std::vector<core::system::FileChangeEvent>& events)
           s_projectContext.file().absolutePath())
       {
          // update project context
-         syncProjectFileChanges();
-
-         // fire event to client
-         json::Object dataJson;
-         dataJson["type"] = "project";
-         dataJson["prefs"] = s_projectContext.uiPrefs();
-         ClientEvent event(client_events::kUiPrefsChanged, dataJson);
-         module_context::enqueClientEvent(event);
+         r_util::RProjectConfigDiff diff = syncProjectFileChanges();
+
+         // fire event to client, but only when settings surfaced via
+         // uiPrefs actually changed (editing unrelated project options
+         // shouldn't force the client to re-apply prefs)
+         if (diff.editor || diff.authoring || diff.build)
+         {
+            json::Object dataJson;
+            dataJson["type"] = "project";
+            dataJson["prefs"] = s_projectContext.uiPrefs();
+            ClientEvent event(client_events::kUiPrefsChanged, dataJson);
+            module_context::enqueClientEvent(event);
+         }
 
          break;
       }
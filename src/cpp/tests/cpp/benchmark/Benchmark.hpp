@@ -0,0 +1,221 @@
+/*
+ * Benchmark.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+// Minimal microbenchmark harness (the benchmark analogue of
+// TestThat.hpp). Benchmarks register themselves with the BENCHMARK
+// macro, drive their measured loop with State::keepRunning -- which
+// calibrates the iteration count against a fixed wall-clock budget --
+// and optionally declare the bytes processed per iteration so the
+// runner can report throughput comparable across commits:
+//
+//   BENCHMARK(benchmarkWidgetParse)
+//   {
+//      std::string input = makeFixture();
+//      state.setBytesPerIteration(input.size());
+//      while (state.keepRunning())
+//         parseWidget(input);
+//   }
+//
+// See BenchmarkMain.hpp to build a benchmark executable.
+
+#ifndef BENCHMARK_BENCHMARK_HPP
+#define BENCHMARK_BENCHMARK_HPP
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/utility.hpp>
+
+namespace rstudio {
+namespace benchmark {
+
+// per-run wall clock budget and iteration cap. the budget is large
+// enough to amortize timer overhead and warmup effects but small
+// enough to keep the full suite quick
+const boost::int64_t kRunBudgetMicroseconds = 500000;
+const boost::uint64_t kMaxIterations = 10000000;
+
+class State : boost::noncopyable
+{
+public:
+   State()
+      : iterations_(0), bytesPerIteration_(0)
+   {
+   }
+
+   // returns true while the measured loop should keep going. the first
+   // call starts the clock so fixture setup before the loop is free
+   bool keepRunning()
+   {
+      using namespace boost::posix_time;
+
+      if (iterations_ == 0)
+      {
+         startTime_ = microsec_clock::universal_time();
+      }
+      else if (iterations_ >= kMaxIterations ||
+               elapsedMicroseconds() >= kRunBudgetMicroseconds)
+      {
+         endTime_ = microsec_clock::universal_time();
+         return false;
+      }
+
+      iterations_++;
+      return true;
+   }
+
+   void setBytesPerIteration(boost::uint64_t bytes)
+   {
+      bytesPerIteration_ = bytes;
+   }
+
+   boost::uint64_t iterations() const { return iterations_; }
+   boost::uint64_t bytesPerIteration() const { return bytesPerIteration_; }
+
+   boost::int64_t elapsedMicroseconds() const
+   {
+      using namespace boost::posix_time;
+      return (microsec_clock::universal_time() -
+              startTime_).total_microseconds();
+   }
+
+private:
+   boost::uint64_t iterations_;
+   boost::uint64_t bytesPerIteration_;
+   boost::posix_time::ptime startTime_;
+   boost::posix_time::ptime endTime_;
+};
+
+// keep a computed value observable so the compiler can't elide the
+// benchmarked work that produced it
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+   asm volatile("" : : "g"(&value) : "memory");
+#else
+   volatile const T* pSink = &value;
+   (void)pSink;
+#endif
+}
+
+typedef void (*BenchmarkFunction)(State&);
+
+struct BenchmarkEntry
+{
+   std::string name;
+   BenchmarkFunction function;
+};
+
+inline std::vector<BenchmarkEntry>& benchmarkRegistry()
+{
+   static std::vector<BenchmarkEntry> s_registry;
+   return s_registry;
+}
+
+class BenchmarkRegistrar
+{
+public:
+   BenchmarkRegistrar(const std::string& name, BenchmarkFunction function)
+   {
+      BenchmarkEntry entry;
+      entry.name = name;
+      entry.function = function;
+      benchmarkRegistry().push_back(entry);
+   }
+};
+
+// run all registered benchmarks (or those whose names contain one of
+// the substrings passed on the command line) and report one line per
+// benchmark: iterations, time per iteration, and throughput when the
+// benchmark declared its bytes per iteration
+inline int runAllBenchmarks(int argc, char* argv[])
+{
+   const std::vector<BenchmarkEntry>& registry = benchmarkRegistry();
+
+   std::cout << std::left << std::setw(44) << "benchmark"
+             << std::right << std::setw(12) << "iterations"
+             << std::setw(14) << "us/iter"
+             << std::setw(12) << "MB/s" << std::endl;
+
+   for (std::size_t i = 0; i < registry.size(); i++)
+   {
+      const BenchmarkEntry& entry = registry[i];
+
+      // apply command line name filter (substring match)
+      if (argc > 1)
+      {
+         bool matched = false;
+         for (int arg = 1; arg < argc; arg++)
+         {
+            if (entry.name.find(argv[arg]) != std::string::npos)
+            {
+               matched = true;
+               break;
+            }
+         }
+         if (!matched)
+            continue;
+      }
+
+      State state;
+      entry.function(state);
+
+      boost::uint64_t iterations = state.iterations();
+      double elapsed = static_cast<double>(state.elapsedMicroseconds());
+      double usPerIteration = (iterations > 0) ? (elapsed / iterations) : 0;
+
+      std::cout << std::left << std::setw(44) << entry.name
+                << std::right << std::setw(12) << iterations
+                << std::setw(14) << std::fixed << std::setprecision(2)
+                << usPerIteration;
+
+      if (state.bytesPerIteration() > 0 && elapsed > 0)
+      {
+         double bytesPerSecond =
+               static_cast<double>(state.bytesPerIteration()) *
+               iterations / (elapsed / 1e6);
+         std::cout << std::setw(12) << std::setprecision(1)
+                   << (bytesPerSecond / (1024 * 1024));
+      }
+      else
+      {
+         std::cout << std::setw(12) << "-";
+      }
+
+      std::cout << std::endl;
+   }
+
+   return EXIT_SUCCESS;
+}
+
+} // namespace benchmark
+} // namespace rstudio
+
+// define and register a benchmark. the macro opens the function body;
+// the measured loop inside should be driven by state.keepRunning()
+#define BENCHMARK(__NAME__)                                                    \
+   static void __NAME__(::rstudio::benchmark::State& state);                   \
+   namespace {                                                                 \
+   ::rstudio::benchmark::BenchmarkRegistrar s_registrar##__NAME__(             \
+         #__NAME__, __NAME__);                                                 \
+   }                                                                           \
+   static void __NAME__(::rstudio::benchmark::State& state)
+
+#endif // BENCHMARK_BENCHMARK_HPP
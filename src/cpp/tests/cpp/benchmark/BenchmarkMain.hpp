@@ -0,0 +1,30 @@
+/*
+ * BenchmarkMain.hpp
+ *
+ * Copyright (C) 2009-18 by RStudio, Inc.
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+// Include this to build a benchmark executable (the benchmark analogue
+// of TestMain.hpp). Pass name substrings on the command line to run a
+// subset of the registered benchmarks.
+
+#ifndef BENCHMARK_BENCHMARKMAIN_HPP
+#define BENCHMARK_BENCHMARKMAIN_HPP
+
+#include "Benchmark.hpp"
+
+int main(int argc, char* argv[])
+{
+   return rstudio::benchmark::runAllBenchmarks(argc, argv);
+}
+
+#endif
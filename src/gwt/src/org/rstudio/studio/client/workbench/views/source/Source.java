@@ -869,43 +869,85 @@ public class Source implements InsertSourceHandler,
       final JsArray<SourceDocument> docs =
             session.getSessionInfo().getSourceDocuments();
 
+      // documents with deferred contents are fetched asynchronously and can
+      // be restored out of order, so record the original index of each doc
+      // restored so far in order to compute tab insert positions
+      final ArrayList<Integer> restoredIndices = new ArrayList<Integer>();
+
       for (int i = 0; i < docs.length(); i++)
       {
          // restore the docs assigned to this source window
          SourceDocument doc = docs.get(i);
-         String docWindowId = 
+         String docWindowId =
                doc.getProperties().getString(
                      SourceWindowManager.SOURCE_WINDOW_ID);
          if (docWindowId == null)
             docWindowId = "";
          String currentSourceWindowId = SourceWindowManager.getSourceWindowId();
-         
+
          // it belongs in this window if (a) it's assigned to it, or (b) this
          // is the main window, and the window it's assigned to isn't open.
          if (currentSourceWindowId == docWindowId ||
-             (SourceWindowManager.isMainSourceWindow() && 
+             (SourceWindowManager.isMainSourceWindow() &&
               !windowManager_.isSourceWindowOpen(docWindowId)))
          {
-            // attempt to add a tab for the current doc; try/catch this since
-            // we don't want to allow one failure to prevent all docs from
-            // opening
-            EditingTarget sourceEditor = null;
-            try
+            if (doc.hasLazyContents())
             {
-               sourceEditor = addTab(doc, true, OPEN_REPLAY);
+               // the server deferred this document's contents so that
+               // startup time doesn't depend on the number of open tabs;
+               // fetch the full document in the background and restore
+               // the tab when it arrives
+               final int docIndex = i;
+               server_.getSourceDocument(doc.getId(),
+                     new ServerRequestCallback<SourceDocument>()
+                     {
+                        @Override
+                        public void onResponseReceived(SourceDocument fullDoc)
+                        {
+                           restoreDocument(fullDoc, docIndex, restoredIndices);
+                        }
+
+                        @Override
+                        public void onError(ServerError error)
+                        {
+                           Debug.logError(error);
+                        }
+                     });
             }
-            catch (Exception e)
+            else
             {
-               Debug.logException(e);
+               restoreDocument(doc, i, restoredIndices);
             }
-            
-            // if we couldn't add the tab for this doc, just continue to the
-            // next one
-            if (sourceEditor == null)
-               continue;
          }
       }
    }
+
+   private void restoreDocument(SourceDocument doc,
+                                int docIndex,
+                                ArrayList<Integer> restoredIndices)
+   {
+      // the tab belongs after the already restored docs which originally
+      // preceded it (this yields the original ordering no matter what
+      // order the docs are restored in)
+      int position = 0;
+      for (int restored : restoredIndices)
+      {
+         if (restored < docIndex)
+            position++;
+      }
+      restoredIndices.add(docIndex);
+
+      // attempt to add a tab for the doc; try/catch this since we don't
+      // want to allow one failure to prevent all docs from opening
+      try
+      {
+         addTab(doc, position, OPEN_REPLAY);
+      }
+      catch (Exception e)
+      {
+         Debug.logException(e);
+      }
+   }
    
    private void openEditPublishedDocs()
    {
@@ -78,6 +78,15 @@ public class SourceDocument extends JavaScriptObject
       this.contents = contents;
    }-*/;
 
+   /**
+    * True if the server omitted the contents of the file from this object
+    * (to keep the initial payload small); fetch the full document with
+    * getSourceDocument() before displaying it.
+    */
+   public native final boolean hasLazyContents() /*-{
+      return !!this.lazy_contents;
+   }-*/;
+
    /**
     * True if changes have been saved to the ID that have not been persisted
     * to the file.